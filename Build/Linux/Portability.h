@@ -0,0 +1,26 @@
+#pragma once
+
+// Force-included by CMakeLists.txt when building the command line tools with GCC or Clang. Stands in for
+// the MSVC extensions DirectXMath relies on, sal.h next to this file covers the SAL annotations.
+
+// GCC ignores an alignment in front of the struct keyword. XMVECTORF32 and friends and XMMATRIX get it from their
+// __m128 members, the XMFLOAT*A types are only ever stored through already aligned pointers by the tools.
+#define __declspec(x) __declspec_##x
+#define __declspec_align(x)
+#define __declspec_selectany __attribute__((weak))
+#define __declspec_deprecated(x) // DirectXPackedVector uses its own deprecated types.
+#define __vectorcall
+#define __fastcall
+#define __cdecl
+
+// XMVECTOR is a GCC vector type which already has the arithmetic operators (DirectXMath does the same for Clang).
+#define _XM_NO_XMVECTOR_OVERLOADS_
+
+#if defined(__cplusplus) && !defined(__clang__)
+#include <cpuid.h>
+#undef __cpuid
+static inline void __cpuid(int CPUInfo[4], int FunctionId)
+{
+	__cpuid_count(FunctionId, 0, CPUInfo[0], CPUInfo[1], CPUInfo[2], CPUInfo[3]);
+}
+#endif
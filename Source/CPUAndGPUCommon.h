@@ -7,6 +7,8 @@ typedef XMFLOAT4X3 float4x3;
 typedef XMFLOAT2 float2;
 typedef XMFLOAT3 float3;
 typedef XMFLOAT4 float4;
+typedef uint32_t uint;
+typedef XMUINT4 uint4;
 #endif
 
 #ifdef __cplusplus
@@ -15,23 +17,69 @@ typedef XMFLOAT4 float4;
 #define SALIGN
 #endif
 
+// Vertex positions are cooked to UNORM (see CookedMesh.h), Position = InPosition * PositionScale + PositionBias.
 struct SALIGN FPerDrawConstantData
 {
 	float4x4 ObjectToClip;
 	float4x3 ObjectToWorld;
 	float3 Albedo;
 	float Metallic;
+	float3 PositionScale;
 	float Roughness;
+	float3 PositionBias;
 	float AO;
 };
 
 struct SALIGN FPerFrameConstantData
 {
+	float4x4 WorldToClip;
 	float4 LightPositions[4];
 	float4 LightColors[4];
 	float4 ViewerPosition;
+	float4 IrradianceSH[9]; // L2 spherical harmonics, see GetSHShaderConstants().
+	uint PrefilteredEnvMapSlot; // Persistent descriptors (see DescriptorSlots.h).
+	uint BRDFIntegrationMapSlot;
+};
+
+// Instance of the instanced static mesh draws (see RecordStaticDrawBatches()), tightly packed in a structured buffer.
+struct FStaticInstanceData
+{
+	float4x3 ObjectToWorld;
+	float3 PositionScale; // Of the instance's mesh, see FPerDrawConstantData.
+	float Roughness;
+	float3 PositionBias;
+	float Metallic;
+	float3 Albedo;
+	float AO;
+};
+
+// PrefilterEnvMap.hlsl writes all faces and mips in one dispatch: thread group (Tile, Face) covers a
+// PREFILTER_ENV_MAP_TILE_SIZE^2 tile, tiles of all mips are numbered consecutively starting with mip 0. A dispatch
+// may cover only a range of tiles (starting at FirstTile), which is how env. map changes are spread over frames.
+#define PREFILTER_ENV_MAP_TILE_SIZE 8
+#define PREFILTER_ENV_MAP_MAX_MIP_LEVELS 8
+
+// Root constants (not a CBV), hence no SALIGN.
+struct FPrefilterEnvMapConstants
+{
+	uint Resolution;
+	uint NumMipLevels;
+	uint FirstTile;
+	uint Padding1;
+	uint4 NumSamples[PREFILTER_ENV_MAP_MAX_MIP_LEVELS / 4]; // GGX samples of every mip, see GetPrefilterNumSamples().
 };
 
 #ifdef __cplusplus
 #undef SALIGN
+
+inline uint32_t GetPrefilterEnvMapNumTiles(uint32_t Resolution, uint32_t NumMipLevels)
+{
+	uint32_t NumTiles = 0;
+	for (uint32_t Mip = 0; Mip < NumMipLevels; ++Mip)
+	{
+		const uint32_t TilesPerRow = ((Resolution >> Mip) + PREFILTER_ENV_MAP_TILE_SIZE - 1) / PREFILTER_ENV_MAP_TILE_SIZE;
+		NumTiles += TilesPerRow * TilesPerRow;
+	}
+	return NumTiles;
+}
 #endif
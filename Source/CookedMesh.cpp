@@ -0,0 +1,439 @@
+#include "CookedMesh.h"
+#include "EAAssert/eaassert.h"
+#include "DirectXMath/DirectXPackedVector.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define COOKED_MESH_MAGIC 0x4853454D // "MESH"
+#define COOKED_MESH_ALIGNMENT 16
+
+enum
+{
+	COOKED_STREAM_Positions, COOKED_STREAM_Attributes, COOKED_STREAM_Indices, COOKED_STREAM_Sections, COOKED_STREAM_Materials, COOKED_STREAM_Instances, COOKED_STREAM_LODs, COOKED_STREAM_Clusters,
+	COOKED_STREAM_Bounds,
+	COOKED_STREAM_Count,
+};
+
+// Streams follow the header in COOKED_STREAM_ order, each one aligned to COOKED_MESH_ALIGNMENT.
+struct FCookedMeshHeader
+{
+	uint32_t Magic;
+	uint32_t Version;
+	float PositionScale[3];
+	float PositionBias[3];
+	uint32_t IndexSize;
+	uint32_t NumVertices;
+	uint32_t NumIndices;
+	uint32_t NumSections;
+	uint32_t NumMaterials;
+	uint32_t NumInstances;
+	uint32_t NumLODs;
+	uint32_t NumClusters;
+	uint32_t AttributeMask; // VERTEX_ATTRIBUTE_BIT()s of the vertex streams.
+	uint32_t Padding[3];
+};
+
+static_assert(sizeof(FCookedMeshHeader) == 80, "Invalid cooked mesh header size.");
+static_assert(sizeof(FSceneMesh) == 16 && sizeof(FSceneMaterial) == 20 && sizeof(FSceneInstance) == 52 && sizeof(FSceneMeshLOD) == 16 &&
+	sizeof(FSceneCluster) == 40 && sizeof(FSceneBounds) == 28, "Cooked tables must not contain padding.");
+
+// Returns the file size.
+static uint64_t GetStreamOffsets(const FCookedMeshHeader& Header, const FVertexLayout& Layout, uint64_t OutOffsets[COOKED_STREAM_Count])
+{
+	const uint64_t Sizes[COOKED_STREAM_Count] =
+	{
+		(uint64_t)Header.NumVertices * Layout.Strides[0],
+		(uint64_t)Header.NumVertices * Layout.Strides[1],
+		(uint64_t)Header.NumIndices * Header.IndexSize,
+		(uint64_t)Header.NumSections * sizeof(FSceneMesh),
+		(uint64_t)Header.NumMaterials * sizeof(FSceneMaterial),
+		(uint64_t)Header.NumInstances * sizeof(FSceneInstance),
+		(uint64_t)Header.NumLODs * sizeof(FSceneMeshLOD),
+		(uint64_t)Header.NumClusters * sizeof(FSceneCluster),
+		(uint64_t)Header.NumSections * sizeof(FSceneBounds),
+	};
+	uint64_t Offset = sizeof(FCookedMeshHeader);
+	for (uint32_t Stream = 0; Stream < COOKED_STREAM_Count; ++Stream)
+	{
+		OutOffsets[Stream] = Offset;
+		Offset = (Offset + Sizes[Stream] + COOKED_MESH_ALIGNMENT - 1) & ~(uint64_t)(COOKED_MESH_ALIGNMENT - 1);
+	}
+	return Offset;
+}
+
+static int16_t QuantizeSNorm(float Value)
+{
+	return (int16_t)lrintf(XMMin(XMMax(Value, -1.0f), 1.0f) * 32767.0f);
+}
+
+static int8_t QuantizeSNorm8(float Value)
+{
+	return (int8_t)lrintf(XMMin(XMMax(Value, -1.0f), 1.0f) * 127.0f);
+}
+
+static uint8_t QuantizeUNorm8(float Value)
+{
+	return (uint8_t)lrintf(XMMin(XMMax(Value, 0.0f), 1.0f) * 255.0f);
+}
+
+// Octahedral encoding (Meyer et al. 2010): the normal is projected onto the octahedron |x| + |y| + |z| = 1 whose lower
+// half is folded over the upper one.
+static void EncodeOctahedral(const XMFLOAT3& Normal, int16_t Out[2])
+{
+	const float L1 = fabsf(Normal.x) + fabsf(Normal.y) + fabsf(Normal.z);
+	float X = L1 > 0.0f ? Normal.x / L1 : 0.0f;
+	float Y = L1 > 0.0f ? Normal.y / L1 : 0.0f;
+	if (Normal.z < 0.0f)
+	{
+		const float FoldedX = (1.0f - fabsf(Y)) * (X >= 0.0f ? 1.0f : -1.0f);
+		const float FoldedY = (1.0f - fabsf(X)) * (Y >= 0.0f ? 1.0f : -1.0f);
+		X = FoldedX;
+		Y = FoldedY;
+	}
+	Out[0] = QuantizeSNorm(X);
+	Out[1] = QuantizeSNorm(Y);
+}
+
+// Same as DecodeOctahedral() in Common.hlsli.
+static XMFLOAT3 DecodeOctahedral(const int16_t Encoded[2])
+{
+	const float X = XMMax(Encoded[0] / 32767.0f, -1.0f);
+	const float Y = XMMax(Encoded[1] / 32767.0f, -1.0f);
+	XMFLOAT3 Normal(X, Y, 1.0f - fabsf(X) - fabsf(Y));
+	const float T = XMMax(-Normal.z, 0.0f);
+	Normal.x += Normal.x >= 0.0f ? -T : T;
+	Normal.y += Normal.y >= 0.0f ? -T : T;
+	XMStoreFloat3(&Normal, XMVector3Normalize(XMLoadFloat3(&Normal)));
+	return Normal;
+}
+
+uint32_t GetCookedAttributeMask(const FScene& Scene)
+{
+	return VERTEX_ATTRIBUTE_BIT(VERTEX_ATTRIBUTE_Position) | VERTEX_ATTRIBUTE_BIT(VERTEX_ATTRIBUTE_Normal) | VERTEX_ATTRIBUTE_BIT(VERTEX_ATTRIBUTE_Tangent) |
+		VERTEX_ATTRIBUTE_BIT(VERTEX_ATTRIBUTE_Texcoord) | (Scene.Colors.empty() ? 0 : VERTEX_ATTRIBUTE_BIT(VERTEX_ATTRIBUTE_Color));
+}
+
+void CookMesh(const FScene& Scene, eastl::vector<uint8_t>& OutData)
+{
+	EA_ASSERT(Scene.Normals.size() == Scene.Positions.size() && Scene.Tangents.size() == Scene.Positions.size() && Scene.Texcoords.size() == Scene.Positions.size());
+	EA_ASSERT(Scene.Colors.empty() || Scene.Colors.size() == Scene.Positions.size());
+
+	XMVECTOR BoundsMin = g_XMFltMax;
+	XMVECTOR BoundsMax = XMVectorNegate(g_XMFltMax);
+	for (const XMFLOAT3& Position : Scene.Positions)
+	{
+		BoundsMin = XMVectorMin(BoundsMin, XMLoadFloat3(&Position));
+		BoundsMax = XMVectorMax(BoundsMax, XMLoadFloat3(&Position));
+	}
+	if (Scene.Positions.empty())
+	{
+		BoundsMin = BoundsMax = XMVectorZero();
+	}
+	const XMVECTOR Extent = XMVectorSubtract(BoundsMax, BoundsMin);
+	// Flat axes quantize to zero.
+	const XMVECTOR ToUNorm = XMVectorSelect(XMVectorDivide(XMVectorReplicate(65535.0f), Extent), XMVectorZero(), XMVectorEqual(Extent, XMVectorZero()));
+
+	uint32_t MaxIndex = 0;
+	for (const uint32_t Index : Scene.Indices)
+	{
+		MaxIndex = XMMax(MaxIndex, Index);
+	}
+
+	FCookedMeshHeader Header = {};
+	Header.Magic = COOKED_MESH_MAGIC;
+	Header.Version = COOKED_MESH_VERSION;
+	XMStoreFloat3((XMFLOAT3*)Header.PositionScale, Extent);
+	XMStoreFloat3((XMFLOAT3*)Header.PositionBias, BoundsMin);
+	Header.IndexSize = MaxIndex <= UINT16_MAX ? 2 : 4;
+	Header.NumVertices = (uint32_t)Scene.Positions.size();
+	Header.NumIndices = (uint32_t)Scene.Indices.size();
+	Header.NumSections = (uint32_t)Scene.Meshes.size();
+	Header.NumMaterials = (uint32_t)Scene.Materials.size();
+	Header.NumInstances = (uint32_t)Scene.Instances.size();
+	Header.NumLODs = (uint32_t)Scene.LODs.size();
+	Header.NumClusters = (uint32_t)Scene.Clusters.size();
+	Header.AttributeMask = GetCookedAttributeMask(Scene);
+	FVertexLayout Layout;
+	InitVertexLayout(Header.AttributeMask, Layout);
+
+	uint64_t Offsets[COOKED_STREAM_Count];
+	OutData.clear();
+	OutData.resize((size_t)GetStreamOffsets(Header, Layout, Offsets), 0);
+	memcpy(OutData.data(), &Header, sizeof(Header));
+
+	uint8_t* Streams[VERTEX_MAX_STREAMS] = { &OutData[(size_t)Offsets[COOKED_STREAM_Positions]], &OutData[(size_t)Offsets[COOKED_STREAM_Attributes]] };
+	const FVertexElement* Elements = Layout.Elements;
+	for (uint32_t Idx = 0; Idx < Header.NumVertices; ++Idx)
+	{
+		XMFLOAT3 Position;
+		XMStoreFloat3(&Position, XMVectorRound(XMVectorMultiply(XMVectorSubtract(XMLoadFloat3(&Scene.Positions[Idx]), BoundsMin), ToUNorm)));
+		auto* CookedPosition = (uint16_t*)(Streams[0] + Idx * Layout.Strides[0] + Elements[VERTEX_ATTRIBUTE_Position].Offset);
+		CookedPosition[0] = (uint16_t)XMMin(Position.x, 65535.0f);
+		CookedPosition[1] = (uint16_t)XMMin(Position.y, 65535.0f);
+		CookedPosition[2] = (uint16_t)XMMin(Position.z, 65535.0f);
+
+		uint8_t* Attributes = Streams[1] + Idx * Layout.Strides[1];
+		EncodeOctahedral(Scene.Normals[Idx], (int16_t*)(Attributes + Elements[VERTEX_ATTRIBUTE_Normal].Offset));
+
+		const XMFLOAT4& Tangent = Scene.Tangents[Idx];
+		auto* CookedTangent = (int8_t*)(Attributes + Elements[VERTEX_ATTRIBUTE_Tangent].Offset);
+		CookedTangent[0] = QuantizeSNorm8(Tangent.x);
+		CookedTangent[1] = QuantizeSNorm8(Tangent.y);
+		CookedTangent[2] = QuantizeSNorm8(Tangent.z);
+		CookedTangent[3] = Tangent.w < 0.0f ? -127 : 127;
+
+		auto* CookedTexcoord = (uint16_t*)(Attributes + Elements[VERTEX_ATTRIBUTE_Texcoord].Offset);
+		CookedTexcoord[0] = PackedVector::XMConvertFloatToHalf(Scene.Texcoords[Idx].x);
+		CookedTexcoord[1] = PackedVector::XMConvertFloatToHalf(Scene.Texcoords[Idx].y);
+
+		if (!Scene.Colors.empty())
+		{
+			const XMFLOAT4& Color = Scene.Colors[Idx];
+			uint8_t* CookedColor = Attributes + Elements[VERTEX_ATTRIBUTE_Color].Offset;
+			CookedColor[0] = QuantizeUNorm8(Color.x);
+			CookedColor[1] = QuantizeUNorm8(Color.y);
+			CookedColor[2] = QuantizeUNorm8(Color.z);
+			CookedColor[3] = QuantizeUNorm8(Color.w);
+		}
+	}
+
+	uint8_t* Indices = &OutData[(size_t)Offsets[COOKED_STREAM_Indices]];
+	if (Header.IndexSize == 2)
+	{
+		for (uint32_t Idx = 0; Idx < Header.NumIndices; ++Idx)
+		{
+			((uint16_t*)Indices)[Idx] = (uint16_t)Scene.Indices[Idx];
+		}
+	}
+	else
+	{
+		memcpy(Indices, Scene.Indices.data(), Header.NumIndices * sizeof(uint32_t));
+	}
+
+	memcpy(&OutData[(size_t)Offsets[COOKED_STREAM_Sections]], Scene.Meshes.data(), Header.NumSections * sizeof(FSceneMesh));
+	memcpy(&OutData[(size_t)Offsets[COOKED_STREAM_Materials]], Scene.Materials.data(), Header.NumMaterials * sizeof(FSceneMaterial));
+	memcpy(&OutData[(size_t)Offsets[COOKED_STREAM_Instances]], Scene.Instances.data(), Header.NumInstances * sizeof(FSceneInstance));
+	memcpy(&OutData[(size_t)Offsets[COOKED_STREAM_LODs]], Scene.LODs.data(), Header.NumLODs * sizeof(FSceneMeshLOD));
+	memcpy(&OutData[(size_t)Offsets[COOKED_STREAM_Clusters]], Scene.Clusters.data(), Header.NumClusters * sizeof(FSceneCluster));
+
+	// Section bounds of the dequantized positions, the ones the GPU sees.
+	const XMVECTOR Scale = XMVectorScale(Extent, 1.0f / 65535.0f);
+	auto* Bounds = (FSceneBounds*)&OutData[(size_t)Offsets[COOKED_STREAM_Bounds]];
+	for (uint32_t SectionIdx = 0; SectionIdx < Header.NumSections; ++SectionIdx)
+	{
+		const FSceneMesh& Section = Scene.Meshes[SectionIdx];
+		auto GetPosition = [&](uint32_t Idx)
+		{
+			const uint32_t Vertex = Section.BaseVertexLocation + Scene.Indices[Section.StartIndexLocation + Idx];
+			const auto* CookedPosition = (const uint16_t*)(Streams[0] + Vertex * Layout.Strides[0] + Elements[VERTEX_ATTRIBUTE_Position].Offset);
+			return XMVectorMultiplyAdd(XMVectorSet(CookedPosition[0], CookedPosition[1], CookedPosition[2], 0.0f), Scale, BoundsMin);
+		};
+
+		XMVECTOR SectionMin = g_XMFltMax;
+		XMVECTOR SectionMax = XMVectorNegate(g_XMFltMax);
+		for (uint32_t Idx = 0; Idx < Section.IndexCount; ++Idx)
+		{
+			const XMVECTOR Position = GetPosition(Idx);
+			SectionMin = XMVectorMin(SectionMin, Position);
+			SectionMax = XMVectorMax(SectionMax, Position);
+		}
+		if (Section.IndexCount == 0)
+		{
+			SectionMin = SectionMax = XMVectorZero();
+		}
+		const XMVECTOR Center = XMVectorScale(XMVectorAdd(SectionMin, SectionMax), 0.5f);
+		XMVECTOR RadiusSq = XMVectorZero();
+		for (uint32_t Idx = 0; Idx < Section.IndexCount; ++Idx)
+		{
+			RadiusSq = XMVectorMax(RadiusSq, XMVector3LengthSq(XMVectorSubtract(GetPosition(Idx), Center)));
+		}
+		XMStoreFloat3(&Bounds[SectionIdx].Center, Center);
+		XMStoreFloat3(&Bounds[SectionIdx].Extents, XMVectorScale(XMVectorSubtract(SectionMax, SectionMin), 0.5f));
+		Bounds[SectionIdx].Radius = XMVectorGetX(XMVectorSqrt(RadiusSq));
+	}
+}
+
+bool SaveCookedMesh(const char* FileName, const FScene& Scene)
+{
+	eastl::vector<uint8_t> Data;
+	CookMesh(Scene, Data);
+
+	FILE* File = fopen(FileName, "wb");
+	if (!File)
+	{
+		return false;
+	}
+	const bool bResult = fwrite(Data.data(), 1, Data.size(), File) == Data.size();
+	return fclose(File) == 0 && bResult;
+}
+
+bool ParseCookedMesh(const void* FileData, uint64_t FileSize, FCookedMesh& OutMesh)
+{
+	if (FileSize < sizeof(FCookedMeshHeader))
+	{
+		return false;
+	}
+	const auto& Header = *(const FCookedMeshHeader*)FileData;
+	if (Header.Magic != COOKED_MESH_MAGIC || Header.Version != COOKED_MESH_VERSION || (Header.IndexSize != 2 && Header.IndexSize != 4) ||
+		(Header.AttributeMask & VERTEX_ATTRIBUTE_BIT(VERTEX_ATTRIBUTE_Position)) == 0 || (Header.AttributeMask & ~VERTEX_ATTRIBUTES_ALL) != 0)
+	{
+		return false;
+	}
+	InitVertexLayout(Header.AttributeMask, OutMesh.Layout);
+	uint64_t Offsets[COOKED_STREAM_Count];
+	if (FileSize < GetStreamOffsets(Header, OutMesh.Layout, Offsets))
+	{
+		return false;
+	}
+
+	const auto* Data = (const uint8_t*)FileData;
+	OutMesh.PositionScale = XMFLOAT3(Header.PositionScale);
+	OutMesh.PositionBias = XMFLOAT3(Header.PositionBias);
+	OutMesh.IndexSize = Header.IndexSize;
+	OutMesh.NumVertices = Header.NumVertices;
+	OutMesh.NumIndices = Header.NumIndices;
+	OutMesh.NumSections = Header.NumSections;
+	OutMesh.NumMaterials = Header.NumMaterials;
+	OutMesh.NumInstances = Header.NumInstances;
+	OutMesh.NumLODs = Header.NumLODs;
+	OutMesh.NumClusters = Header.NumClusters;
+	OutMesh.VertexStreams[0] = Data + Offsets[COOKED_STREAM_Positions];
+	OutMesh.VertexStreams[1] = Data + Offsets[COOKED_STREAM_Attributes];
+	OutMesh.Indices = Data + Offsets[COOKED_STREAM_Indices];
+	OutMesh.Sections = (const FSceneMesh*)(Data + Offsets[COOKED_STREAM_Sections]);
+	OutMesh.Materials = (const FSceneMaterial*)(Data + Offsets[COOKED_STREAM_Materials]);
+	OutMesh.Instances = (const FSceneInstance*)(Data + Offsets[COOKED_STREAM_Instances]);
+	OutMesh.LODs = (const FSceneMeshLOD*)(Data + Offsets[COOKED_STREAM_LODs]);
+	OutMesh.Clusters = (const FSceneCluster*)(Data + Offsets[COOKED_STREAM_Clusters]);
+	OutMesh.Bounds = (const FSceneBounds*)(Data + Offsets[COOKED_STREAM_Bounds]);
+
+	// Index values are not checked, out of range vertex fetches read zero on the GPU.
+	for (uint32_t Idx = 0; Idx < OutMesh.NumSections; ++Idx)
+	{
+		const FSceneMesh& Section = OutMesh.Sections[Idx];
+		if ((uint64_t)Section.StartIndexLocation + Section.IndexCount > OutMesh.NumIndices || Section.BaseVertexLocation > OutMesh.NumVertices ||
+			Section.MaterialIndex >= OutMesh.NumMaterials)
+		{
+			return false;
+		}
+	}
+	for (uint32_t Idx = 0; Idx < OutMesh.NumInstances; ++Idx)
+	{
+		if (OutMesh.Instances[Idx].MeshIndex >= OutMesh.NumSections)
+		{
+			return false;
+		}
+	}
+	for (uint32_t Idx = 0; Idx < OutMesh.NumLODs; ++Idx)
+	{
+		const FSceneMeshLOD& LOD = OutMesh.LODs[Idx];
+		if (LOD.MeshIndex >= OutMesh.NumSections || (uint64_t)LOD.StartIndexLocation + LOD.IndexCount > OutMesh.NumIndices ||
+			(Idx > 0 && LOD.MeshIndex < OutMesh.LODs[Idx - 1].MeshIndex))
+		{
+			return false;
+		}
+	}
+	for (uint32_t Idx = 0; Idx < OutMesh.NumClusters; ++Idx)
+	{
+		const FSceneCluster& Cluster = OutMesh.Clusters[Idx];
+		if ((uint64_t)Cluster.StartIndexLocation + Cluster.IndexCount > OutMesh.NumIndices ||
+			(Idx > 0 && Cluster.StartIndexLocation < OutMesh.Clusters[Idx - 1].StartIndexLocation))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void DecodeCookedMesh(const FCookedMesh& Mesh, FScene& InOutScene)
+{
+	const auto FirstVertex = (uint32_t)InOutScene.Positions.size();
+	const auto FirstIndex = (uint32_t)InOutScene.Indices.size();
+	const auto FirstSection = (uint32_t)InOutScene.Meshes.size();
+	const auto FirstMaterial = (uint32_t)InOutScene.Materials.size();
+
+	const XMVECTOR Scale = XMVectorScale(XMLoadFloat3(&Mesh.PositionScale), 1.0f / 65535.0f);
+	const XMVECTOR Bias = XMLoadFloat3(&Mesh.PositionBias);
+	const bool bHasColors = (Mesh.Layout.AttributeMask & VERTEX_ATTRIBUTE_BIT(VERTEX_ATTRIBUTE_Color)) != 0;
+	InOutScene.Positions.resize(FirstVertex + Mesh.NumVertices);
+	InOutScene.Normals.resize(FirstVertex + Mesh.NumVertices);
+	InOutScene.Tangents.resize(FirstVertex + Mesh.NumVertices);
+	InOutScene.Texcoords.resize(FirstVertex + Mesh.NumVertices);
+	if (bHasColors || !InOutScene.Colors.empty())
+	{
+		InOutScene.Colors.resize(FirstVertex + Mesh.NumVertices, XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
+	}
+
+	// Attributes that the file lacks are decoded from their default values.
+	FVertexLayout Layout;
+	InitVertexLayout(VERTEX_ATTRIBUTES_ALL, Layout);
+	eastl::vector<uint8_t> Streams[VERTEX_MAX_STREAMS];
+	void* StreamData[VERTEX_MAX_STREAMS];
+	for (uint32_t Stream = 0; Stream < VERTEX_MAX_STREAMS; ++Stream)
+	{
+		Streams[Stream].resize((size_t)Mesh.NumVertices * Layout.Strides[Stream]);
+		StreamData[Stream] = Streams[Stream].data();
+	}
+	ConvertVertices(Mesh.Layout, Mesh.VertexStreams, 0, Mesh.NumVertices, Layout, StreamData);
+
+	const FVertexElement* Elements = Layout.Elements;
+	for (uint32_t Idx = 0; Idx < Mesh.NumVertices; ++Idx)
+	{
+		const auto* CookedPosition = (const uint16_t*)&Streams[0][Idx * Layout.Strides[0] + Elements[VERTEX_ATTRIBUTE_Position].Offset];
+		const XMVECTOR Position = XMVectorSet(CookedPosition[0], CookedPosition[1], CookedPosition[2], 0.0f);
+		XMStoreFloat3(&InOutScene.Positions[FirstVertex + Idx], XMVectorMultiplyAdd(Position, Scale, Bias));
+
+		const uint8_t* Attributes = &Streams[1][Idx * Layout.Strides[1]];
+		InOutScene.Normals[FirstVertex + Idx] = DecodeOctahedral((const int16_t*)(Attributes + Elements[VERTEX_ATTRIBUTE_Normal].Offset));
+
+		const auto* CookedTangent = (const int8_t*)(Attributes + Elements[VERTEX_ATTRIBUTE_Tangent].Offset);
+		XMVECTOR Tangent = XMVectorSet(CookedTangent[0], CookedTangent[1], CookedTangent[2], 0.0f);
+		Tangent = XMVectorSetW(XMVector3Normalize(Tangent), CookedTangent[3] < 0 ? -1.0f : 1.0f);
+		XMStoreFloat4(&InOutScene.Tangents[FirstVertex + Idx], Tangent);
+
+		const auto* CookedTexcoord = (const uint16_t*)(Attributes + Elements[VERTEX_ATTRIBUTE_Texcoord].Offset);
+		InOutScene.Texcoords[FirstVertex + Idx] = XMFLOAT2(PackedVector::XMConvertHalfToFloat(CookedTexcoord[0]), PackedVector::XMConvertHalfToFloat(CookedTexcoord[1]));
+
+		if (bHasColors)
+		{
+			const uint8_t* CookedColor = Attributes + Elements[VERTEX_ATTRIBUTE_Color].Offset;
+			InOutScene.Colors[FirstVertex + Idx] = XMFLOAT4(CookedColor[0] / 255.0f, CookedColor[1] / 255.0f, CookedColor[2] / 255.0f, CookedColor[3] / 255.0f);
+		}
+	}
+
+	InOutScene.Indices.resize(FirstIndex + Mesh.NumIndices);
+	for (uint32_t Idx = 0; Idx < Mesh.NumIndices; ++Idx)
+	{
+		InOutScene.Indices[FirstIndex + Idx] = Mesh.IndexSize == 2 ? ((const uint16_t*)Mesh.Indices)[Idx] : ((const uint32_t*)Mesh.Indices)[Idx];
+	}
+
+	for (uint32_t Idx = 0; Idx < Mesh.NumSections; ++Idx)
+	{
+		FSceneMesh Section = Mesh.Sections[Idx];
+		Section.StartIndexLocation += FirstIndex;
+		Section.BaseVertexLocation += FirstVertex;
+		Section.MaterialIndex += FirstMaterial;
+		InOutScene.Meshes.push_back(Section);
+	}
+	InOutScene.Materials.insert(InOutScene.Materials.end(), Mesh.Materials, Mesh.Materials + Mesh.NumMaterials);
+	for (uint32_t Idx = 0; Idx < Mesh.NumInstances; ++Idx)
+	{
+		FSceneInstance Instance = Mesh.Instances[Idx];
+		Instance.MeshIndex += FirstSection;
+		InOutScene.Instances.push_back(Instance);
+	}
+	for (uint32_t Idx = 0; Idx < Mesh.NumLODs; ++Idx)
+	{
+		FSceneMeshLOD LOD = Mesh.LODs[Idx];
+		LOD.MeshIndex += FirstSection;
+		LOD.StartIndexLocation += FirstIndex;
+		InOutScene.LODs.push_back(LOD);
+	}
+	for (uint32_t Idx = 0; Idx < Mesh.NumClusters; ++Idx)
+	{
+		FSceneCluster Cluster = Mesh.Clusters[Idx];
+		Cluster.StartIndexLocation += FirstIndex;
+		InOutScene.Clusters.push_back(Cluster);
+	}
+}
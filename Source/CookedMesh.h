@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+#include "EASTL/vector.h"
+#include "GLTFScene.h"
+#include "VertexLayout.h"
+
+// Cooked mesh container (.mesh), written offline by MeshTool mesh-cook and memory-mapped at load time. All streams are
+// stored in their GPU layout so they can be copied straight into the static vertex and index buffers:
+// - the two vertex streams of a FVertexLayout: positions quantized to 16 bits per axis relative to the file bounds, and
+//   octahedral normals, tangents, half precision texcoords and (when the scene has them) colors,
+// - 16-bit indices when every section can address its vertices with them, 32-bit otherwise,
+// - the section (FSceneMesh), material, instance, LOD and cluster tables of the source scene (the LODs index the same
+//   vertices, the clusters are ranges of the index stream),
+// - the object space bounds of every section (FSceneBounds, computed from the quantized positions).
+
+// Bump whenever the layout of the file or of the vertex attributes (see VertexLayout.h) changes.
+#define COOKED_MESH_VERSION 5
+
+struct FCookedMesh
+{
+	XMFLOAT3 PositionScale;
+	XMFLOAT3 PositionBias;
+	uint32_t IndexSize; // 2 or 4.
+	uint32_t NumVertices;
+	uint32_t NumIndices;
+	uint32_t NumSections;
+	uint32_t NumMaterials;
+	uint32_t NumInstances;
+	uint32_t NumLODs;
+	uint32_t NumClusters;
+	FVertexLayout Layout;
+	// Point into the file data.
+	const void* VertexStreams[VERTEX_MAX_STREAMS];
+	const void* Indices;
+	const FSceneMesh* Sections;
+	const FSceneMaterial* Materials;
+	const FSceneInstance* Instances;
+	const FSceneMeshLOD* LODs;
+	const FSceneCluster* Clusters;
+	const FSceneBounds* Bounds; // NumSections.
+};
+
+// Attributes that CookMesh() stores for Scene (colors only when it has them).
+uint32_t GetCookedAttributeMask(const FScene& Scene);
+// Quantizes Scene (which must have normals and tangents for every vertex) into a file image.
+void CookMesh(const FScene& Scene, eastl::vector<uint8_t>& OutData);
+bool SaveCookedMesh(const char* FileName, const FScene& Scene);
+// Validates a cooked mesh in memory (e.g. a mapped file); OutMesh points into FileData.
+bool ParseCookedMesh(const void* FileData, uint64_t FileSize, FCookedMesh& OutMesh);
+// Dequantized float copy, appended to InOutScene like LoadGLTFScene().
+void DecodeCookedMesh(const FCookedMesh& Mesh, FScene& InOutScene);
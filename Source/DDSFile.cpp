@@ -0,0 +1,157 @@
+#include "DDSFile.h"
+#include <stdio.h>
+#include "EAAssert/eaassert.h"
+
+#define DDS_MAGIC 0x20534444 // "DDS "
+#define DDS_FOURCC_DX10 0x30315844 // "DX10"
+
+struct FDDSPixelFormat
+{
+	uint32_t Size;
+	uint32_t Flags;
+	uint32_t FourCC;
+	uint32_t RGBBitCount;
+	uint32_t BitMasks[4];
+};
+
+struct FDDSHeader
+{
+	uint32_t Size;
+	uint32_t Flags;
+	uint32_t Height;
+	uint32_t Width;
+	uint32_t PitchOrLinearSize;
+	uint32_t Depth;
+	uint32_t MipMapCount;
+	uint32_t Reserved1[11];
+	FDDSPixelFormat PixelFormat;
+	uint32_t Caps[4];
+	uint32_t Reserved2;
+};
+
+struct FDDSHeaderDX10
+{
+	uint32_t Format;
+	uint32_t ResourceDimension;
+	uint32_t MiscFlag;
+	uint32_t ArraySize;
+	uint32_t MiscFlags2;
+};
+
+static_assert(sizeof(FDDSHeader) == 124, "Invalid DDS header size.");
+static_assert(sizeof(FDDSHeaderDX10) == 20, "Invalid DDS DX10 header size.");
+
+uint32_t GetDDSBytesPerPixel(uint32_t Format)
+{
+	switch (Format)
+	{
+	case DDS_FORMAT_R32G32B32A32_FLOAT: return 16;
+	case DDS_FORMAT_R16G16B16A16_FLOAT: return 8;
+	case DDS_FORMAT_R16G16_FLOAT: return 4;
+	case DDS_FORMAT_R9G9B9E5_SHAREDEXP: return 4;
+	case DDS_FORMAT_R8G8_UNORM: return 2;
+	}
+	EA_ASSERT(0);
+	return 0;
+}
+
+uint64_t GetDDSDataSize(const FDDSDesc& Desc)
+{
+	const uint32_t NumFaces = Desc.bIsCubeMap ? 6 : 1;
+	uint64_t SliceSize = 0;
+	for (uint32_t MipIdx = 0; MipIdx < Desc.NumMipLevels; ++MipIdx)
+	{
+		const uint32_t Width = Desc.Width >> MipIdx ? Desc.Width >> MipIdx : 1;
+		const uint32_t Height = Desc.Height >> MipIdx ? Desc.Height >> MipIdx : 1;
+		SliceSize += (uint64_t)Width * Height * GetDDSBytesPerPixel(Desc.Format);
+	}
+	return SliceSize * NumFaces * Desc.ArraySize;
+}
+
+bool SaveDDS(const char* FileName, const FDDSDesc& Desc, const void* Data)
+{
+	EA_ASSERT(Desc.Width > 0 && Desc.Height > 0 && Desc.ArraySize > 0 && Desc.NumMipLevels > 0);
+
+	FILE* File = fopen(FileName, "wb");
+	if (!File)
+	{
+		return false;
+	}
+
+	FDDSHeader Header = {};
+	Header.Size = sizeof(FDDSHeader);
+	Header.Flags = 0x1 | 0x2 | 0x4 | 0x8 | 0x1000 | 0x20000; // CAPS, HEIGHT, WIDTH, PITCH, PIXELFORMAT, MIPMAPCOUNT
+	Header.Height = Desc.Height;
+	Header.Width = Desc.Width;
+	Header.PitchOrLinearSize = Desc.Width * GetDDSBytesPerPixel(Desc.Format);
+	Header.Depth = 1;
+	Header.MipMapCount = Desc.NumMipLevels;
+	Header.PixelFormat.Size = sizeof(FDDSPixelFormat);
+	Header.PixelFormat.Flags = 0x4; // FOURCC
+	Header.PixelFormat.FourCC = DDS_FOURCC_DX10;
+	Header.Caps[0] = 0x1000 | (Desc.NumMipLevels > 1 ? (0x8 | 0x400000) : 0); // TEXTURE, COMPLEX, MIPMAP
+	if (Desc.bIsCubeMap)
+	{
+		Header.Caps[0] |= 0x8;
+		Header.Caps[1] = 0x200 | 0xfc00; // CUBEMAP, all faces
+	}
+
+	FDDSHeaderDX10 HeaderDX10 = {};
+	HeaderDX10.Format = Desc.Format;
+	HeaderDX10.ResourceDimension = 3; // D3D12_RESOURCE_DIMENSION_TEXTURE2D
+	HeaderDX10.MiscFlag = Desc.bIsCubeMap ? 0x4 : 0; // TEXTURECUBE
+	HeaderDX10.ArraySize = Desc.ArraySize;
+
+	const uint32_t Magic = DDS_MAGIC;
+	const uint64_t DataSize = GetDDSDataSize(Desc);
+
+	bool bResult = fwrite(&Magic, sizeof(Magic), 1, File) == 1;
+	bResult = bResult && fwrite(&Header, sizeof(Header), 1, File) == 1;
+	bResult = bResult && fwrite(&HeaderDX10, sizeof(HeaderDX10), 1, File) == 1;
+	bResult = bResult && fwrite(Data, 1, (size_t)DataSize, File) == DataSize;
+
+	fclose(File);
+	return bResult;
+}
+
+bool ParseDDS(const void* FileData, uint64_t FileSize, FDDSDesc& OutDesc, const uint8_t*& OutPixels)
+{
+	const uint64_t HeadersSize = sizeof(uint32_t) + sizeof(FDDSHeader) + sizeof(FDDSHeaderDX10);
+	if (FileSize < HeadersSize || *(const uint32_t*)FileData != DDS_MAGIC)
+	{
+		return false;
+	}
+
+	const auto* Header = (const FDDSHeader*)((const uint8_t*)FileData + sizeof(uint32_t));
+	const auto* HeaderDX10 = (const FDDSHeaderDX10*)(Header + 1);
+	if (Header->Size != sizeof(FDDSHeader) || Header->PixelFormat.FourCC != DDS_FOURCC_DX10 || HeaderDX10->ResourceDimension != 3)
+	{
+		return false;
+	}
+
+	switch (HeaderDX10->Format)
+	{
+	case DDS_FORMAT_R32G32B32A32_FLOAT:
+	case DDS_FORMAT_R16G16B16A16_FLOAT:
+	case DDS_FORMAT_R16G16_FLOAT:
+	case DDS_FORMAT_R8G8_UNORM:
+	case DDS_FORMAT_R9G9B9E5_SHAREDEXP:
+		break;
+	default:
+		return false;
+	}
+
+	OutDesc.Format = HeaderDX10->Format;
+	OutDesc.Width = Header->Width;
+	OutDesc.Height = Header->Height;
+	OutDesc.ArraySize = HeaderDX10->ArraySize;
+	OutDesc.NumMipLevels = Header->MipMapCount > 0 ? Header->MipMapCount : 1;
+	OutDesc.bIsCubeMap = (HeaderDX10->MiscFlag & 0x4) != 0;
+
+	if (OutDesc.Width == 0 || OutDesc.Height == 0 || OutDesc.ArraySize == 0 || FileSize - HeadersSize < GetDDSDataSize(OutDesc))
+	{
+		return false;
+	}
+	OutPixels = (const uint8_t*)FileData + HeadersSize;
+	return true;
+}
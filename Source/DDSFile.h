@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+
+// Minimal DDS (DX10 header) reader/writer for baked textures. Pixel data is expected in D3D12 subresource order
+// (all mips of array slice 0, then all mips of array slice 1, ...) with tightly packed rows.
+
+// Values match DXGI_FORMAT so the files can be consumed directly by D3D12 code.
+enum
+{
+	DDS_FORMAT_R32G32B32A32_FLOAT = 2,
+	DDS_FORMAT_R16G16B16A16_FLOAT = 10,
+	DDS_FORMAT_R16G16_FLOAT = 34,
+	DDS_FORMAT_R8G8_UNORM = 49,
+	DDS_FORMAT_R9G9B9E5_SHAREDEXP = 67,
+};
+
+struct FDDSDesc
+{
+	uint32_t Format;
+	uint32_t Width;
+	uint32_t Height;
+	uint32_t ArraySize; // Number of cubes for cube maps.
+	uint32_t NumMipLevels;
+	bool bIsCubeMap;
+};
+
+uint32_t GetDDSBytesPerPixel(uint32_t Format);
+uint64_t GetDDSDataSize(const FDDSDesc& Desc);
+bool SaveDDS(const char* FileName, const FDDSDesc& Desc, const void* Data);
+// Validates a DDS file in memory (e.g. a mapped file); OutPixels points into FileData.
+bool ParseDDS(const void* FileData, uint64_t FileSize, FDDSDesc& OutDesc, const uint8_t*& OutPixels);
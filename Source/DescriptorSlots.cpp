@@ -0,0 +1,69 @@
+#include "DescriptorSlots.h"
+#include "EAAssert/eaassert.h"
+
+void CreateDescriptorSlots(uint32_t Capacity, FDescriptorSlots& OutSlots)
+{
+	EA_ASSERT(Capacity <= DESCRIPTOR_MAX_SLOTS);
+	OutSlots.Capacity = Capacity;
+	OutSlots.NumUsedSlots = 0;
+	OutSlots.NumAllocated = 0;
+	OutSlots.Generations.clear();
+	OutSlots.FreeSlots.clear();
+	OutSlots.Retired.clear();
+}
+
+bool AllocateDescriptorSlot(FDescriptorSlots& Slots, FDescriptorHandle& OutHandle)
+{
+	uint32_t Slot;
+	if (!Slots.FreeSlots.empty())
+	{
+		Slot = Slots.FreeSlots.back();
+		Slots.FreeSlots.pop_back();
+	}
+	else if (Slots.NumUsedSlots < Slots.Capacity)
+	{
+		Slot = Slots.NumUsedSlots++;
+		Slots.Generations.push_back(1);
+	}
+	else
+	{
+		return false;
+	}
+	OutHandle = ((uint32_t)Slots.Generations[Slot] << DESCRIPTOR_SLOT_INDEX_BITS) | Slot;
+	Slots.NumAllocated += 1;
+	return true;
+}
+
+bool IsDescriptorHandleValid(const FDescriptorSlots& Slots, FDescriptorHandle Handle)
+{
+	// Free slots are ahead of the generation of every handle that was given out for them.
+	const uint32_t Slot = GetDescriptorSlot(Handle);
+	return Slot < Slots.NumUsedSlots && Slots.Generations[Slot] == Handle >> DESCRIPTOR_SLOT_INDEX_BITS;
+}
+
+bool ReleaseDescriptorSlot(FDescriptorSlots& Slots, FDescriptorHandle Handle, uint64_t FenceValue)
+{
+	if (!IsDescriptorHandleValid(Slots, Handle))
+	{
+		return false;
+	}
+	EA_ASSERT(Slots.Retired.empty() || Slots.Retired.back().FenceValue <= FenceValue);
+
+	const uint32_t Slot = GetDescriptorSlot(Handle);
+	uint16_t& Generation = Slots.Generations[Slot];
+	Generation = (uint16_t)(Generation == DESCRIPTOR_GENERATION_MASK ? 1 : Generation + 1);
+	Slots.Retired.push_back(FRetiredDescriptorSlot{ Slot, FenceValue });
+	Slots.NumAllocated -= 1;
+	return true;
+}
+
+void ReclaimDescriptorSlots(FDescriptorSlots& Slots, uint64_t CompletedFenceValue)
+{
+	uint32_t NumReclaimed = 0;
+	while (NumReclaimed < (uint32_t)Slots.Retired.size() && Slots.Retired[NumReclaimed].FenceValue <= CompletedFenceValue)
+	{
+		Slots.FreeSlots.push_back(Slots.Retired[NumReclaimed].Slot);
+		++NumReclaimed;
+	}
+	Slots.Retired.erase(Slots.Retired.begin(), Slots.Retired.begin() + NumReclaimed);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdint.h>
+#include "EASTL/vector.h"
+
+// Persistent slots of a descriptor range that shaders index directly (the start of the shader visible heap, see
+// Library.h), as opposed to the per-frame descriptors that are reset every frame. A view is written once, when its slot
+// is allocated, and stays there for as long as its owner wants it. Released slots go back to a free list, but only
+// after the GPU is done with the frames that may still read them: ReleaseDescriptorSlot() tags the slot with a fence
+// value and ReclaimDescriptorSlots() frees it once the fence got there.
+//
+// Handles carry the generation of their slot, which changes on every release, so a handle that is used after its
+// release is caught (IsDescriptorHandleValid()) instead of silently naming whatever got the slot next. Generations wrap
+// after DESCRIPTOR_GENERATION_MASK releases of the same slot.
+//
+// Nothing here touches D3D12, MeshTool descriptor-churn runs the slots against a fake fence.
+
+#define DESCRIPTOR_SLOT_INDEX_BITS 20
+#define DESCRIPTOR_MAX_SLOTS (1u << DESCRIPTOR_SLOT_INDEX_BITS)
+#define DESCRIPTOR_GENERATION_MASK ((1u << (32 - DESCRIPTOR_SLOT_INDEX_BITS)) - 1)
+#define DESCRIPTOR_HANDLE_INVALID 0u // Never returned by AllocateDescriptorSlot(), generations start at 1.
+
+// Slot index in the low DESCRIPTOR_SLOT_INDEX_BITS, its generation above.
+typedef uint32_t FDescriptorHandle;
+
+// Slot that was released and may be read by the GPU until FenceValue.
+struct FRetiredDescriptorSlot
+{
+	uint32_t Slot;
+	uint64_t FenceValue;
+};
+
+struct FDescriptorSlots
+{
+	uint32_t Capacity;
+	uint32_t NumUsedSlots; // Slots below were allocated at least once, the ones above are free.
+	uint32_t NumAllocated; // Live handles.
+	eastl::vector<uint16_t> Generations; // Per used slot, of its live handle or of the next one.
+	eastl::vector<uint32_t> FreeSlots; // Reclaimed, the last one is reused first.
+	eastl::vector<FRetiredDescriptorSlot> Retired; // Oldest first.
+};
+
+inline uint32_t GetDescriptorSlot(FDescriptorHandle Handle)
+{
+	return Handle & (DESCRIPTOR_MAX_SLOTS - 1);
+}
+
+// Capacity is at most DESCRIPTOR_MAX_SLOTS.
+void CreateDescriptorSlots(uint32_t Capacity, FDescriptorSlots& OutSlots);
+
+// Returns false when all slots are allocated or retired.
+bool AllocateDescriptorSlot(FDescriptorSlots& Slots, FDescriptorHandle& OutHandle);
+
+// True from AllocateDescriptorSlot() until ReleaseDescriptorSlot().
+bool IsDescriptorHandleValid(const FDescriptorSlots& Slots, FDescriptorHandle Handle);
+
+// The handle is invalid right away, the slot is reused after FenceValue is completed (see ReclaimDescriptorSlots()).
+// FenceValue must not be smaller than the one of the previous release. Returns false for an invalid handle.
+bool ReleaseDescriptorSlot(FDescriptorSlots& Slots, FDescriptorHandle Handle, uint64_t FenceValue);
+
+// Frees the released slots whose fence value is not larger than CompletedFenceValue.
+void ReclaimDescriptorSlots(FDescriptorSlots& Slots, uint64_t CompletedFenceValue);
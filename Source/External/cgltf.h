@@ -378,6 +378,12 @@ typedef struct cgltf_mesh {
 
 typedef struct cgltf_node cgltf_node;
 
+typedef struct cgltf_mesh_gpu_instancing {
+	cgltf_accessor* translation;
+	cgltf_accessor* rotation;
+	cgltf_accessor* scale;
+} cgltf_mesh_gpu_instancing;
+
 typedef struct cgltf_skin {
 	char* name;
 	cgltf_node** joints;
@@ -442,6 +448,8 @@ struct cgltf_node {
 	cgltf_float rotation[4];
 	cgltf_float scale[3];
 	cgltf_float matrix[16];
+	cgltf_bool has_mesh_gpu_instancing;
+	cgltf_mesh_gpu_instancing mesh_gpu_instancing;
 	cgltf_extras extras;
 };
 
@@ -3423,6 +3431,76 @@ static int cgltf_parse_json_lights(cgltf_options* options, jsmntok_t const* toke
 	return i;
 }
 
+static int cgltf_parse_json_mesh_gpu_instancing(jsmntok_t const* tokens, int i, const uint8_t* json_chunk, cgltf_mesh_gpu_instancing* out_instancing)
+{
+	CGLTF_CHECK_TOKTYPE(tokens[i], JSMN_OBJECT);
+
+	int size = tokens[i].size;
+	++i;
+
+	for (int j = 0; j < size; ++j)
+	{
+		CGLTF_CHECK_KEY(tokens[i]);
+
+		if (cgltf_json_strcmp(tokens+i, json_chunk, "attributes") == 0)
+		{
+			++i;
+
+			CGLTF_CHECK_TOKTYPE(tokens[i], JSMN_OBJECT);
+
+			int attributes_size = tokens[i].size;
+			++i;
+
+			for (int k = 0; k < attributes_size; ++k)
+			{
+				CGLTF_CHECK_KEY(tokens[i]);
+
+				cgltf_accessor** accessor = NULL;
+				if (cgltf_json_strcmp(tokens+i, json_chunk, "TRANSLATION") == 0)
+				{
+					accessor = &out_instancing->translation;
+				}
+				else if (cgltf_json_strcmp(tokens+i, json_chunk, "ROTATION") == 0)
+				{
+					accessor = &out_instancing->rotation;
+				}
+				else if (cgltf_json_strcmp(tokens+i, json_chunk, "SCALE") == 0)
+				{
+					accessor = &out_instancing->scale;
+				}
+
+				if (accessor)
+				{
+					++i;
+					CGLTF_CHECK_TOKTYPE(tokens[i], JSMN_PRIMITIVE);
+					*accessor = CGLTF_PTRINDEX(cgltf_accessor, cgltf_json_to_int(tokens + i, json_chunk));
+					++i;
+				}
+				else
+				{
+					i = cgltf_skip_json(tokens, i+1);
+				}
+
+				if (i < 0)
+				{
+					return i;
+				}
+			}
+		}
+		else
+		{
+			i = cgltf_skip_json(tokens, i+1);
+		}
+
+		if (i < 0)
+		{
+			return i;
+		}
+	}
+
+	return i;
+}
+
 static int cgltf_parse_json_node(cgltf_options* options, jsmntok_t const* tokens, int i, const uint8_t* json_chunk, cgltf_node* out_node)
 {
 	CGLTF_CHECK_TOKTYPE(tokens[i], JSMN_OBJECT);
@@ -3560,6 +3638,11 @@ static int cgltf_parse_json_node(cgltf_options* options, jsmntok_t const* tokens
 						}
 					}
 				}
+				else if (cgltf_json_strcmp(tokens+i, json_chunk, "EXT_mesh_gpu_instancing") == 0)
+				{
+					out_node->has_mesh_gpu_instancing = 1;
+					i = cgltf_parse_json_mesh_gpu_instancing(tokens, i + 1, json_chunk, &out_node->mesh_gpu_instancing);
+				}
 				else
 				{
 					i = cgltf_skip_json(tokens, i+1);
@@ -4330,6 +4413,9 @@ static int cgltf_fixup_pointers(cgltf_data* data)
 		CGLTF_PTRFIXUP(data->nodes[i].skin, data->skins, data->skins_count);
 		CGLTF_PTRFIXUP(data->nodes[i].camera, data->cameras, data->cameras_count);
 		CGLTF_PTRFIXUP(data->nodes[i].light, data->lights, data->lights_count);
+		CGLTF_PTRFIXUP(data->nodes[i].mesh_gpu_instancing.translation, data->accessors, data->accessors_count);
+		CGLTF_PTRFIXUP(data->nodes[i].mesh_gpu_instancing.rotation, data->accessors, data->accessors_count);
+		CGLTF_PTRFIXUP(data->nodes[i].mesh_gpu_instancing.scale, data->accessors, data->accessors_count);
 	}
 
 	for (cgltf_size i = 0; i < data->scenes_count; ++i)
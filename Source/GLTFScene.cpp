@@ -0,0 +1,651 @@
+#include "GLTFScene.h"
+#include "EAAssert/eaassert.h"
+#include "EASTL/algorithm.h"
+#include "cgltf.h"
+#include <string.h>
+
+// Primitive vertex data is shared by every primitive that uses the same attribute accessors.
+struct FGLTFVertexRange
+{
+	const cgltf_accessor* Positions;
+	const cgltf_accessor* Normals;
+	const cgltf_accessor* Tangents;
+	const cgltf_accessor* Texcoords;
+	const cgltf_accessor* Colors;
+	uint32_t BaseVertexLocation;
+};
+
+// Scene meshes of one glTF mesh, imported on first reference.
+struct FGLTFMeshRange
+{
+	uint32_t FirstMesh;
+	uint32_t NumMeshes;
+	bool bIsImported;
+};
+
+struct FGLTFImport
+{
+	FScene& Scene;
+	const cgltf_data* Data;
+	eastl::vector<FGLTFMeshRange> MeshRanges; // Indexed by glTF mesh.
+	eastl::vector<FGLTFVertexRange> VertexRanges;
+	uint32_t FirstMaterial;
+	uint32_t DefaultMaterial; // UINT32_MAX until a primitive without a material is found.
+};
+
+static uint32_t GetComponentSize(cgltf_component_type Type)
+{
+	switch (Type)
+	{
+	case cgltf_component_type_r_8: case cgltf_component_type_r_8u: return 1;
+	case cgltf_component_type_r_16: case cgltf_component_type_r_16u: return 2;
+	case cgltf_component_type_r_32u: case cgltf_component_type_r_32f: return 4;
+	default: return 0;
+	}
+}
+
+static uint32_t GetNumComponents(cgltf_type Type)
+{
+	switch (Type)
+	{
+	case cgltf_type_scalar: return 1;
+	case cgltf_type_vec2: return 2;
+	case cgltf_type_vec3: return 3;
+	case cgltf_type_vec4: case cgltf_type_mat2: return 4;
+	case cgltf_type_mat3: return 9;
+	case cgltf_type_mat4: return 16;
+	default: return 0;
+	}
+}
+
+// Normalized integers are mapped to [0, 1] or [-1, 1] as the spec requires.
+static float ReadComponent(const uint8_t* Src, cgltf_component_type Type, bool bIsNormalized)
+{
+	switch (Type)
+	{
+	case cgltf_component_type_r_8:
+	{
+		const int8_t Value = *(const int8_t*)Src;
+		return bIsNormalized ? XMMax(Value / 127.0f, -1.0f) : (float)Value;
+	}
+	case cgltf_component_type_r_8u: return bIsNormalized ? *Src / 255.0f : (float)*Src;
+	case cgltf_component_type_r_16:
+	{
+		int16_t Value;
+		memcpy(&Value, Src, sizeof(Value));
+		return bIsNormalized ? XMMax(Value / 32767.0f, -1.0f) : (float)Value;
+	}
+	case cgltf_component_type_r_16u:
+	{
+		uint16_t Value;
+		memcpy(&Value, Src, sizeof(Value));
+		return bIsNormalized ? Value / 65535.0f : (float)Value;
+	}
+	case cgltf_component_type_r_32u:
+	{
+		uint32_t Value;
+		memcpy(&Value, Src, sizeof(Value));
+		return (float)Value;
+	}
+	case cgltf_component_type_r_32f:
+	{
+		float Value;
+		memcpy(&Value, Src, sizeof(Value));
+		return Value;
+	}
+	default: return 0.0f;
+	}
+}
+
+static uint32_t ReadIndex(const uint8_t* Src, cgltf_component_type Type)
+{
+	switch (Type)
+	{
+	case cgltf_component_type_r_8u: return *Src;
+	case cgltf_component_type_r_16u:
+	{
+		uint16_t Value;
+		memcpy(&Value, Src, sizeof(Value));
+		return Value;
+	}
+	case cgltf_component_type_r_32u:
+	{
+		uint32_t Value;
+		memcpy(&Value, Src, sizeof(Value));
+		return Value;
+	}
+	default: return UINT32_MAX;
+	}
+}
+
+static const uint8_t* GetBufferViewData(const cgltf_buffer_view* View, cgltf_size Offset)
+{
+	return (const uint8_t*)View->buffer->data + View->offset + Offset;
+}
+
+// Unpacks Accessor->count elements with NumComponents floats each (extra components are dropped, missing ones are
+// zero), applying sparse substitution. Bounds were checked by cgltf_validate().
+static void UnpackFloats(const cgltf_accessor* Accessor, uint32_t NumComponents, float* Out)
+{
+	const uint32_t ComponentSize = GetComponentSize(Accessor->component_type);
+	const uint32_t NumSrcComponents = XMMin(GetNumComponents(Accessor->type), NumComponents);
+
+	if (Accessor->buffer_view == nullptr)
+	{
+		memset(Out, 0, Accessor->count * NumComponents * sizeof(float));
+	}
+	else if (Accessor->component_type == cgltf_component_type_r_32f && NumSrcComponents == NumComponents)
+	{
+		const uint8_t* Src = GetBufferViewData(Accessor->buffer_view, Accessor->offset);
+		if (Accessor->stride == NumComponents * sizeof(float))
+		{
+			memcpy(Out, Src, Accessor->count * NumComponents * sizeof(float));
+		}
+		else
+		{
+			for (cgltf_size Idx = 0; Idx < Accessor->count; ++Idx)
+			{
+				memcpy(Out + Idx * NumComponents, Src + Idx * Accessor->stride, NumComponents * sizeof(float));
+			}
+		}
+	}
+	else
+	{
+		const uint8_t* Src = GetBufferViewData(Accessor->buffer_view, Accessor->offset);
+		for (cgltf_size Idx = 0; Idx < Accessor->count; ++Idx)
+		{
+			float* Element = Out + Idx * NumComponents;
+			for (uint32_t C = 0; C < NumComponents; ++C)
+			{
+				Element[C] = C < NumSrcComponents ? ReadComponent(Src + Idx * Accessor->stride + C * ComponentSize, Accessor->component_type, Accessor->normalized) : 0.0f;
+			}
+		}
+	}
+
+	if (Accessor->is_sparse)
+	{
+		const cgltf_accessor_sparse& Sparse = Accessor->sparse;
+		const uint32_t IndexSize = GetComponentSize(Sparse.indices_component_type);
+		const uint32_t ElementSize = GetNumComponents(Accessor->type) * ComponentSize;
+		const uint8_t* Indices = GetBufferViewData(Sparse.indices_buffer_view, Sparse.indices_byte_offset);
+		const uint8_t* Values = GetBufferViewData(Sparse.values_buffer_view, Sparse.values_byte_offset);
+
+		for (cgltf_size Idx = 0; Idx < Sparse.count; ++Idx)
+		{
+			float* Element = Out + ReadIndex(Indices + Idx * IndexSize, Sparse.indices_component_type) * NumComponents;
+			for (uint32_t C = 0; C < NumSrcComponents; ++C)
+			{
+				Element[C] = ReadComponent(Values + Idx * ElementSize + C * ComponentSize, Accessor->component_type, Accessor->normalized);
+			}
+		}
+	}
+}
+
+static const cgltf_accessor* FindAttribute(const cgltf_primitive& Primitive, cgltf_attribute_type Type)
+{
+	for (cgltf_size Idx = 0; Idx < Primitive.attributes_count; ++Idx)
+	{
+		if (Primitive.attributes[Idx].type == Type && Primitive.attributes[Idx].index == 0)
+		{
+			return Primitive.attributes[Idx].data;
+		}
+	}
+	return nullptr;
+}
+
+// Triangle list with glTF (counter-clockwise) winding, indices are checked against NumVertices.
+static bool GetTriangles(const cgltf_primitive& Primitive, uint32_t NumVertices, eastl::vector<uint32_t>& OutTriangles)
+{
+	eastl::vector<uint32_t> Indices;
+	if (Primitive.indices)
+	{
+		const cgltf_accessor* Accessor = Primitive.indices;
+		eastl::vector<float> SparseIndices;
+		Indices.resize(Accessor->count);
+
+		if (Accessor->is_sparse || Accessor->buffer_view == nullptr)
+		{
+			// Rare, float is exact up to 2^24.
+			SparseIndices.resize(Accessor->count);
+			UnpackFloats(Accessor, 1, SparseIndices.data());
+			for (cgltf_size Idx = 0; Idx < Accessor->count; ++Idx)
+			{
+				Indices[Idx] = (uint32_t)SparseIndices[Idx];
+			}
+		}
+		else
+		{
+			const uint8_t* Src = GetBufferViewData(Accessor->buffer_view, Accessor->offset);
+			for (cgltf_size Idx = 0; Idx < Accessor->count; ++Idx)
+			{
+				Indices[Idx] = ReadIndex(Src + Idx * Accessor->stride, Accessor->component_type);
+			}
+		}
+	}
+	else
+	{
+		Indices.resize(NumVertices);
+		for (uint32_t Idx = 0; Idx < NumVertices; ++Idx)
+		{
+			Indices[Idx] = Idx;
+		}
+	}
+
+	for (const uint32_t Index : Indices)
+	{
+		if (Index >= NumVertices)
+		{
+			return false;
+		}
+	}
+
+	const auto NumIndices = (uint32_t)Indices.size();
+	if (Primitive.type == cgltf_primitive_type_triangles)
+	{
+		OutTriangles.assign(Indices.begin(), Indices.begin() + NumIndices / 3 * 3);
+	}
+	else if (Primitive.type == cgltf_primitive_type_triangle_strip)
+	{
+		for (uint32_t Idx = 0; Idx + 2 < NumIndices; ++Idx)
+		{
+			OutTriangles.push_back(Indices[Idx]);
+			OutTriangles.push_back(Indices[Idx + 1 + (Idx & 1)]);
+			OutTriangles.push_back(Indices[Idx + 2 - (Idx & 1)]);
+		}
+	}
+	else if (Primitive.type == cgltf_primitive_type_triangle_fan)
+	{
+		for (uint32_t Idx = 1; Idx + 1 < NumIndices; ++Idx)
+		{
+			OutTriangles.push_back(Indices[Idx]);
+			OutTriangles.push_back(Indices[Idx + 1]);
+			OutTriangles.push_back(Indices[0]);
+		}
+	}
+	return true;
+}
+
+// Area weighted face normals accumulated per vertex.
+static void ComputeNormals(const XMFLOAT3* Positions, uint32_t NumVertices, const eastl::vector<uint32_t>& Triangles, XMFLOAT3* OutNormals)
+{
+	memset(OutNormals, 0, NumVertices * sizeof(XMFLOAT3));
+
+	for (size_t Idx = 0; Idx < Triangles.size(); Idx += 3)
+	{
+		const XMVECTOR P0 = XMLoadFloat3(&Positions[Triangles[Idx]]);
+		const XMVECTOR P1 = XMLoadFloat3(&Positions[Triangles[Idx + 1]]);
+		const XMVECTOR P2 = XMLoadFloat3(&Positions[Triangles[Idx + 2]]);
+		const XMVECTOR FaceNormal = XMVector3Cross(XMVectorSubtract(P1, P0), XMVectorSubtract(P2, P0));
+
+		for (uint32_t C = 0; C < 3; ++C)
+		{
+			XMFLOAT3& Normal = OutNormals[Triangles[Idx + C]];
+			XMStoreFloat3(&Normal, XMVectorAdd(XMLoadFloat3(&Normal), FaceNormal));
+		}
+	}
+
+	for (uint32_t Idx = 0; Idx < NumVertices; ++Idx)
+	{
+		XMStoreFloat3(&OutNormals[Idx], XMVector3Normalize(XMLoadFloat3(&OutNormals[Idx])));
+	}
+}
+
+static uint32_t GetMaterialIndex(FGLTFImport& Import, const cgltf_material* Material)
+{
+	if (Material)
+	{
+		return Import.FirstMaterial + (uint32_t)(Material - Import.Data->materials);
+	}
+	if (Import.DefaultMaterial == UINT32_MAX)
+	{
+		Import.DefaultMaterial = (uint32_t)Import.Scene.Materials.size();
+		Import.Scene.Materials.push_back(FSceneMaterial{ XMFLOAT3(1.0f, 1.0f, 1.0f), 1.0f, 1.0f });
+	}
+	return Import.DefaultMaterial;
+}
+
+// Appends one FSceneMesh, vertex data is appended only when no earlier primitive used the same accessors. Points and
+// lines are skipped (NumMeshes of the glTF mesh doesn't count them).
+static bool ImportPrimitive(FGLTFImport& Import, const cgltf_primitive& Primitive)
+{
+	if (Primitive.type != cgltf_primitive_type_triangles && Primitive.type != cgltf_primitive_type_triangle_strip &&
+		Primitive.type != cgltf_primitive_type_triangle_fan)
+	{
+		return true;
+	}
+
+	FScene& Scene = Import.Scene;
+	const cgltf_accessor* PositionAccessor = FindAttribute(Primitive, cgltf_attribute_type_position);
+	const cgltf_accessor* NormalAccessor = FindAttribute(Primitive, cgltf_attribute_type_normal);
+	const cgltf_accessor* TexcoordAccessor = FindAttribute(Primitive, cgltf_attribute_type_texcoord);
+	const cgltf_accessor* ColorAccessor = FindAttribute(Primitive, cgltf_attribute_type_color);
+	// Tangents are only meaningful relative to the normals they were made for.
+	const cgltf_accessor* TangentAccessor = NormalAccessor ? FindAttribute(Primitive, cgltf_attribute_type_tangent) : nullptr;
+	if (PositionAccessor == nullptr)
+	{
+		return false;
+	}
+
+	const auto NumVertices = (uint32_t)PositionAccessor->count;
+	eastl::vector<uint32_t> Triangles;
+	if (!GetTriangles(Primitive, NumVertices, Triangles))
+	{
+		return false;
+	}
+
+	// Generated normals depend on the indices, so only primitives with normals share vertices.
+	uint32_t BaseVertexLocation = UINT32_MAX;
+	if (NormalAccessor)
+	{
+		for (const FGLTFVertexRange& Range : Import.VertexRanges)
+		{
+			if (Range.Positions == PositionAccessor && Range.Normals == NormalAccessor && Range.Tangents == TangentAccessor &&
+				Range.Texcoords == TexcoordAccessor && Range.Colors == ColorAccessor)
+			{
+				BaseVertexLocation = Range.BaseVertexLocation;
+				break;
+			}
+		}
+	}
+
+	if (BaseVertexLocation == UINT32_MAX)
+	{
+		BaseVertexLocation = (uint32_t)Scene.Positions.size();
+		Scene.Positions.resize(BaseVertexLocation + NumVertices);
+		Scene.Normals.resize(BaseVertexLocation + NumVertices);
+		Scene.Tangents.resize(BaseVertexLocation + NumVertices);
+		Scene.Texcoords.resize(BaseVertexLocation + NumVertices);
+
+		XMFLOAT3* Positions = &Scene.Positions[BaseVertexLocation];
+		XMFLOAT3* Normals = &Scene.Normals[BaseVertexLocation];
+		XMFLOAT4* Tangents = &Scene.Tangents[BaseVertexLocation];
+		UnpackFloats(PositionAccessor, 3, (float*)Positions);
+
+		if (NormalAccessor)
+		{
+			UnpackFloats(NormalAccessor, 3, (float*)Normals);
+		}
+		else
+		{
+			ComputeNormals(Positions, NumVertices, Triangles, Normals);
+		}
+
+		if (TexcoordAccessor)
+		{
+			UnpackFloats(TexcoordAccessor, 2, (float*)(Scene.Texcoords.data() + BaseVertexLocation));
+		}
+		else
+		{
+			memset(&Scene.Texcoords[BaseVertexLocation], 0, NumVertices * sizeof(XMFLOAT2));
+		}
+
+		// Zero w marks the tangents that are generated later (see GenerateTangents()).
+		if (TangentAccessor)
+		{
+			UnpackFloats(TangentAccessor, 4, (float*)Tangents);
+		}
+		else
+		{
+			memset(Tangents, 0, NumVertices * sizeof(XMFLOAT4));
+		}
+
+		// Colors are only stored once some primitive has them.
+		if (ColorAccessor && Scene.Colors.empty())
+		{
+			Scene.Colors.resize(BaseVertexLocation, XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
+		}
+		if (!Scene.Colors.empty())
+		{
+			Scene.Colors.resize(BaseVertexLocation + NumVertices, XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f));
+		}
+		if (ColorAccessor)
+		{
+			UnpackFloats(ColorAccessor, 4, (float*)(Scene.Colors.data() + BaseVertexLocation));
+			if (ColorAccessor->type == cgltf_type_vec3)
+			{
+				for (uint32_t Idx = 0; Idx < NumVertices; ++Idx)
+				{
+					Scene.Colors[BaseVertexLocation + Idx].w = 1.0f;
+				}
+			}
+		}
+
+		// Mirroring z also mirrors the bitangent, which flips its sign relative to cross(normal, tangent).
+		for (uint32_t Idx = 0; Idx < NumVertices; ++Idx)
+		{
+			Positions[Idx].z = -Positions[Idx].z;
+			Normals[Idx].z = -Normals[Idx].z;
+			Tangents[Idx].z = -Tangents[Idx].z;
+			Tangents[Idx].w = -Tangents[Idx].w;
+		}
+
+		Import.VertexRanges.push_back(FGLTFVertexRange{ PositionAccessor, NormalAccessor, TangentAccessor, TexcoordAccessor, ColorAccessor, BaseVertexLocation });
+	}
+
+	// Mirroring z flips the winding, restore it.
+	for (size_t Idx = 0; Idx < Triangles.size(); Idx += 3)
+	{
+		eastl::swap(Triangles[Idx + 1], Triangles[Idx + 2]);
+	}
+
+	FSceneMesh Mesh;
+	Mesh.IndexCount = (uint32_t)Triangles.size();
+	Mesh.StartIndexLocation = (uint32_t)Scene.Indices.size();
+	Mesh.BaseVertexLocation = BaseVertexLocation;
+	Mesh.MaterialIndex = GetMaterialIndex(Import, Primitive.material);
+	Scene.Meshes.push_back(Mesh);
+	Scene.Indices.insert(Scene.Indices.end(), Triangles.begin(), Triangles.end());
+
+	return true;
+}
+
+static bool ImportMesh(FGLTFImport& Import, const cgltf_mesh* Mesh, FGLTFMeshRange*& OutRange)
+{
+	OutRange = &Import.MeshRanges[Mesh - Import.Data->meshes];
+	if (!OutRange->bIsImported)
+	{
+		OutRange->FirstMesh = (uint32_t)Import.Scene.Meshes.size();
+		for (cgltf_size Idx = 0; Idx < Mesh->primitives_count; ++Idx)
+		{
+			if (!ImportPrimitive(Import, Mesh->primitives[Idx]))
+			{
+				return false;
+			}
+		}
+		OutRange->NumMeshes = (uint32_t)Import.Scene.Meshes.size() - OutRange->FirstMesh;
+		OutRange->bIsImported = true;
+	}
+	return true;
+}
+
+static void AddInstances(FScene& Scene, const FGLTFMeshRange& Range, FXMMATRIX ObjectToWorldRH)
+{
+	// Same transform in the left-handed space: mirror, transform, mirror back.
+	const XMMATRIX Mirror = XMMatrixScaling(1.0f, 1.0f, -1.0f);
+	FSceneInstance Instance;
+	XMStoreFloat4x3(&Instance.ObjectToWorld, Mirror * ObjectToWorldRH * Mirror);
+
+	for (uint32_t Idx = 0; Idx < Range.NumMeshes; ++Idx)
+	{
+		Instance.MeshIndex = Range.FirstMesh + Idx;
+		Scene.Instances.push_back(Instance);
+	}
+}
+
+static bool AddGPUInstances(FGLTFImport& Import, const cgltf_mesh_gpu_instancing& Instancing, const FGLTFMeshRange& Range, FXMMATRIX NodeToWorld)
+{
+	const cgltf_accessor* Accessors[3] = { Instancing.translation, Instancing.rotation, Instancing.scale };
+	cgltf_size NumInstances = SIZE_MAX;
+	for (const cgltf_accessor* Accessor : Accessors)
+	{
+		if (Accessor)
+		{
+			if (NumInstances != SIZE_MAX && Accessor->count != NumInstances)
+			{
+				return false;
+			}
+			NumInstances = Accessor->count;
+		}
+	}
+	if (NumInstances == SIZE_MAX)
+	{
+		return true;
+	}
+
+	eastl::vector<XMFLOAT3> Translations(NumInstances, XMFLOAT3(0.0f, 0.0f, 0.0f));
+	eastl::vector<XMFLOAT4> Rotations(NumInstances, XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f));
+	eastl::vector<XMFLOAT3> Scales(NumInstances, XMFLOAT3(1.0f, 1.0f, 1.0f));
+	if (Instancing.translation)
+	{
+		UnpackFloats(Instancing.translation, 3, (float*)Translations.data());
+	}
+	if (Instancing.rotation)
+	{
+		UnpackFloats(Instancing.rotation, 4, (float*)Rotations.data());
+	}
+	if (Instancing.scale)
+	{
+		UnpackFloats(Instancing.scale, 3, (float*)Scales.data());
+	}
+
+	for (cgltf_size Idx = 0; Idx < NumInstances; ++Idx)
+	{
+		const XMMATRIX InstanceToNode = XMMatrixAffineTransformation(XMLoadFloat3(&Scales[Idx]), g_XMZero,
+			XMQuaternionNormalize(XMLoadFloat4(&Rotations[Idx])), XMLoadFloat3(&Translations[Idx]));
+		AddInstances(Import.Scene, Range, InstanceToNode * NodeToWorld);
+	}
+	return true;
+}
+
+// Depth guards against child cycles, which cgltf doesn't reject.
+static bool ImportNode(FGLTFImport& Import, const cgltf_node* Node, FXMMATRIX ParentToWorld, cgltf_size Depth)
+{
+	if (Depth > Import.Data->nodes_count)
+	{
+		return false;
+	}
+
+	// cgltf matrices are column-major with column vectors, which is the row-major, row vector layout of DirectXMath.
+	XMFLOAT4X4 Local;
+	cgltf_node_transform_local(Node, &Local.m[0][0]);
+	const XMMATRIX NodeToWorld = XMLoadFloat4x4(&Local) * ParentToWorld;
+
+	if (Node->mesh)
+	{
+		FGLTFMeshRange* Range;
+		if (!ImportMesh(Import, Node->mesh, Range))
+		{
+			return false;
+		}
+
+		if (Node->has_mesh_gpu_instancing)
+		{
+			if (!AddGPUInstances(Import, Node->mesh_gpu_instancing, *Range, NodeToWorld))
+			{
+				return false;
+			}
+		}
+		else
+		{
+			AddInstances(Import.Scene, *Range, NodeToWorld);
+		}
+	}
+
+	for (cgltf_size Idx = 0; Idx < Node->children_count; ++Idx)
+	{
+		if (!ImportNode(Import, Node->children[Idx], NodeToWorld, Depth + 1))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool ImportScene(FGLTFImport& Import)
+{
+	const cgltf_data* Data = Import.Data;
+
+	for (cgltf_size Idx = 0; Idx < Data->materials_count; ++Idx)
+	{
+		const cgltf_material& Material = Data->materials[Idx];
+		FSceneMaterial SceneMaterial = { XMFLOAT3(1.0f, 1.0f, 1.0f), 1.0f, 1.0f };
+		if (Material.has_pbr_metallic_roughness)
+		{
+			const cgltf_pbr_metallic_roughness& PBR = Material.pbr_metallic_roughness;
+			SceneMaterial.BaseColor = XMFLOAT3(PBR.base_color_factor[0], PBR.base_color_factor[1], PBR.base_color_factor[2]);
+			SceneMaterial.Metallic = PBR.metallic_factor;
+			SceneMaterial.Roughness = PBR.roughness_factor;
+		}
+		Import.Scene.Materials.push_back(SceneMaterial);
+	}
+
+	// Default scene, the first one when unspecified or all root nodes when the file has no scenes.
+	const cgltf_scene* Scene = Data->scene ? Data->scene : (Data->scenes_count > 0 ? &Data->scenes[0] : nullptr);
+	if (Scene)
+	{
+		for (cgltf_size Idx = 0; Idx < Scene->nodes_count; ++Idx)
+		{
+			if (!ImportNode(Import, Scene->nodes[Idx], XMMatrixIdentity(), 0))
+			{
+				return false;
+			}
+		}
+	}
+	else
+	{
+		for (cgltf_size Idx = 0; Idx < Data->nodes_count; ++Idx)
+		{
+			if (Data->nodes[Idx].parent == nullptr && !ImportNode(Import, &Data->nodes[Idx], XMMatrixIdentity(), 0))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+bool LoadGLTFScene(const char* FileName, FScene& InOutScene)
+{
+	EA_ASSERT(FileName);
+
+	cgltf_options Options = {};
+	cgltf_data* Data = nullptr;
+	if (cgltf_parse_file(&Options, FileName, &Data) != cgltf_result_success)
+	{
+		return false;
+	}
+	if (cgltf_load_buffers(&Options, Data, FileName) != cgltf_result_success || cgltf_validate(Data) != cgltf_result_success)
+	{
+		cgltf_free(Data);
+		return false;
+	}
+
+	const size_t NumVertices = InOutScene.Positions.size();
+	const size_t NumColors = InOutScene.Colors.size();
+	const size_t NumIndices = InOutScene.Indices.size();
+	const size_t NumMeshes = InOutScene.Meshes.size();
+	const size_t NumMaterials = InOutScene.Materials.size();
+	const size_t NumInstances = InOutScene.Instances.size();
+
+	FGLTFImport Import = { InOutScene, Data };
+	Import.MeshRanges.resize(Data->meshes_count, FGLTFMeshRange{ 0, 0, false });
+	Import.FirstMaterial = (uint32_t)NumMaterials;
+	Import.DefaultMaterial = UINT32_MAX;
+
+	const bool bHasSucceeded = ImportScene(Import);
+	if (!bHasSucceeded)
+	{
+		InOutScene.Positions.resize(NumVertices);
+		InOutScene.Normals.resize(NumVertices);
+		InOutScene.Tangents.resize(NumVertices);
+		InOutScene.Texcoords.resize(NumVertices);
+		InOutScene.Colors.resize(NumColors);
+		InOutScene.Indices.resize(NumIndices);
+		InOutScene.Meshes.resize(NumMeshes);
+		InOutScene.Materials.resize(NumMaterials);
+		InOutScene.Instances.resize(NumInstances);
+	}
+
+	cgltf_free(Data);
+	return bHasSucceeded;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdint.h>
+#include "EASTL/vector.h"
+#include "DirectXMath/DirectXMath.h"
+
+// glTF 2.0 (.gltf, .glb) scene importer. Every node of the default scene is visited, each glTF mesh that is referenced
+// is imported once (one FSceneMesh per triangle primitive) and every reference to it - including the ones expanded
+// from EXT_mesh_gpu_instancing - becomes a FSceneInstance. Accessors may be interleaved, strided, normalized integer
+// or sparse. Geometry and transforms are converted from glTF's right-handed space to the left-handed space of the
+// demo (z is negated, triangle winding is reversed).
+
+struct FSceneMesh
+{
+	uint32_t IndexCount;
+	uint32_t StartIndexLocation;
+	uint32_t BaseVertexLocation;
+	uint32_t MaterialIndex;
+};
+
+struct FSceneMaterial
+{
+	XMFLOAT3 BaseColor;
+	float Metallic;
+	float Roughness;
+};
+
+struct FSceneInstance
+{
+	XMFLOAT4X3 ObjectToWorld;
+	uint32_t MeshIndex;
+};
+
+// Simplified index range of Meshes[MeshIndex] over the same vertices (see GenerateLODs()).
+struct FSceneMeshLOD
+{
+	uint32_t MeshIndex;
+	uint32_t IndexCount;
+	uint32_t StartIndexLocation;
+	float Error; // Object space distance to the full detail mesh.
+};
+
+// Consecutive triangles of a section or LOD index range (see BuildClusters()).
+struct FSceneCluster
+{
+	XMFLOAT3 Center; // Bounding sphere.
+	float Radius;
+	XMFLOAT3 ConeAxis; // Normal cone: mean triangle normal and the sine of the largest angle between it and a triangle
+	float ConeCutoff; // normal (1 when that angle is 90 degrees or more and the cluster can't be backface culled).
+	uint32_t IndexCount;
+	uint32_t StartIndexLocation;
+};
+
+// Object space bounds of a section: a box and a sphere around the same center (see CookMesh()).
+struct FSceneBounds
+{
+	XMFLOAT3 Center;
+	XMFLOAT3 Extents; // Half size of the box.
+	float Radius;
+};
+
+// Vertex streams have one entry per vertex (Texcoords are zero and Normals are generated when a primitive has none).
+// Tangents have the bitangent sign in w (bitangent = cross(normal, tangent) * w), w is zero for the tangents that
+// GenerateTangents() has to compute. Colors is empty when no primitive has vertex colors, white for the others otherwise.
+struct FScene
+{
+	eastl::vector<XMFLOAT3> Positions;
+	eastl::vector<XMFLOAT3> Normals;
+	eastl::vector<XMFLOAT4> Tangents;
+	eastl::vector<XMFLOAT2> Texcoords;
+	eastl::vector<XMFLOAT4> Colors;
+	eastl::vector<uint32_t> Indices;
+	eastl::vector<FSceneMesh> Meshes;
+	eastl::vector<FSceneMaterial> Materials;
+	eastl::vector<FSceneInstance> Instances;
+	eastl::vector<FSceneMeshLOD> LODs; // Grouped by MeshIndex, coarser LODs last.
+	eastl::vector<FSceneCluster> Clusters; // Sorted by StartIndexLocation.
+};
+
+// Appends the file to InOutScene (all indices in the new entries refer to the whole scene). Returns false for files
+// that can't be read or have invalid accessors, InOutScene is left unchanged then.
+bool LoadGLTFScene(const char* FileName, FScene& InOutScene);
@@ -0,0 +1,340 @@
+#include "HDRFile.h"
+#include "DDSFile.h"
+#include "JobSystem.h"
+#include "EAAssert/eaassert.h"
+#include "EASTL/vector.h"
+#include "EAStdC/EAString.h"
+#include "DirectXMath/DirectXPackedVector.h"
+#include <math.h>
+#include <string.h>
+
+#define HDR_SCANLINES_PER_JOB 16
+// Set in the scanline offsets for scanlines stored as plain RGBE quadruples.
+#define HDR_FLAT_SCANLINE (1ull << 63)
+
+// Converted channel values indexed by [E][M], exponents only differ in a few rows in real images.
+struct FConversionTable
+{
+	uint16_t Values[256][256];
+};
+
+struct FHDRDecodeContext
+{
+	const uint8_t* Data;
+	const uint64_t* ScanlineOffsets;
+	uint32_t Width;
+	uint32_t Height;
+	uint32_t Format;
+	bool bFlipVertically;
+	uint8_t* OutTexels;
+	uint64_t RowPitch;
+	float ExponentScales[256]; // 2^(E - 136), the scale of 8-bit mantissas (0 for E == 0).
+	const FConversionTable* Table; // Half floats or RGB9E5 mantissas.
+	uint32_t RGB9E5Exponents[256]; // Already shifted into place.
+};
+
+static bool ReadLine(const uint8_t* Data, uint64_t Size, uint64_t& InOutOffset, char* OutLine, uint32_t MaxLength)
+{
+	uint32_t Length = 0;
+	while (InOutOffset < Size && Data[InOutOffset] != '\n')
+	{
+		if (Length + 1 < MaxLength)
+		{
+			OutLine[Length++] = (char)Data[InOutOffset];
+		}
+		++InOutOffset;
+	}
+	OutLine[Length] = 0;
+	if (InOutOffset == Size)
+	{
+		return false;
+	}
+	++InOutOffset;
+	return true;
+}
+
+bool ParseHDRHeader(const void* FileData, uint64_t FileSize, FHDRDesc& OutDesc)
+{
+	const uint8_t* Data = (const uint8_t*)FileData;
+	uint64_t Offset = 0;
+	char Line[256];
+
+	if (!ReadLine(Data, FileSize, Offset, Line, sizeof(Line)) || (EA::StdC::Strcmp(Line, "#?RADIANCE") != 0 && EA::StdC::Strcmp(Line, "#?RGBE") != 0))
+	{
+		return false;
+	}
+
+	// Variables (EXPOSURE, GAMMA, ...) are ignored like in stb_image, only the pixel format matters.
+	bool bHasValidFormat = false;
+	for (;;)
+	{
+		if (!ReadLine(Data, FileSize, Offset, Line, sizeof(Line)))
+		{
+			return false;
+		}
+		if (Line[0] == 0)
+		{
+			break;
+		}
+		if (EA::StdC::Strncmp(Line, "FORMAT=", 7) == 0)
+		{
+			bHasValidFormat = EA::StdC::Strcmp(Line + 7, "32-bit_rle_rgbe") == 0;
+		}
+	}
+
+	if (!bHasValidFormat || !ReadLine(Data, FileSize, Offset, Line, sizeof(Line)) || EA::StdC::Strncmp(Line, "-Y ", 3) != 0)
+	{
+		return false;
+	}
+	char* End;
+	OutDesc.Height = EA::StdC::StrtoU32(Line + 3, &End, 10);
+	if (EA::StdC::Strncmp(End, " +X ", 4) != 0)
+	{
+		return false;
+	}
+	OutDesc.Width = EA::StdC::StrtoU32(End + 4, &End, 10);
+	OutDesc.DataOffset = Offset;
+
+	// 16K x 16K is D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION.
+	return *End == 0 && OutDesc.Width > 0 && OutDesc.Height > 0 && OutDesc.Width <= 16384 && OutDesc.Height <= 16384;
+}
+
+static bool IsRLEScanline(const uint8_t* Data, uint64_t Size, uint64_t Offset)
+{
+	return Offset + 4 <= Size && Data[Offset] == 2 && Data[Offset + 1] == 2 && (Data[Offset + 2] & 0x80) == 0;
+}
+
+// Returns the offset of the next scanline (0 for truncated or corrupt data). Like in stb_image, once a scanline is
+// not run-length encoded the rest of the image is treated as plain RGBE quadruples.
+static uint64_t SkipScanline(const uint8_t* Data, uint64_t Size, uint64_t Offset, uint32_t Width, bool& InOutbIsFlat)
+{
+	if (!InOutbIsFlat && IsRLEScanline(Data, Size, Offset))
+	{
+		if (((uint32_t)Data[Offset + 2] << 8 | Data[Offset + 3]) != Width)
+		{
+			return 0;
+		}
+		Offset += 4;
+
+		// R, G, B and E are encoded one after the other, each as a sequence of runs and literal spans.
+		for (uint32_t Channel = 0; Channel < 4; ++Channel)
+		{
+			uint32_t NumPixels = 0;
+			while (NumPixels < Width)
+			{
+				if (Offset >= Size)
+				{
+					return 0;
+				}
+				uint32_t Count = Data[Offset++];
+				if (Count > 128)
+				{
+					Count -= 128;
+					Offset += 1;
+				}
+				else
+				{
+					Offset += Count;
+				}
+				if (Count == 0 || NumPixels + Count > Width)
+				{
+					return 0;
+				}
+				NumPixels += Count;
+			}
+		}
+		return Offset <= Size ? Offset : 0;
+	}
+
+	InOutbIsFlat = true;
+	return Offset + Width * 4ull <= Size ? Offset + Width * 4ull : 0;
+}
+
+// Expands one scanline (already validated by SkipScanline()) into R, G, B and E planes of Width bytes.
+static void DecodeScanline(const uint8_t* Data, uint64_t Offset, uint32_t Width, uint8_t* OutPlanes)
+{
+	if (Offset & HDR_FLAT_SCANLINE)
+	{
+		const uint8_t* Pixels = Data + (Offset & ~HDR_FLAT_SCANLINE);
+		for (uint32_t X = 0; X < Width; ++X)
+		{
+			OutPlanes[X] = Pixels[4 * X + 0];
+			OutPlanes[Width + X] = Pixels[4 * X + 1];
+			OutPlanes[2 * Width + X] = Pixels[4 * X + 2];
+			OutPlanes[3 * Width + X] = Pixels[4 * X + 3];
+		}
+		return;
+	}
+
+	const uint8_t* Ptr = Data + Offset + 4;
+	for (uint32_t Channel = 0; Channel < 4; ++Channel)
+	{
+		uint8_t* Plane = OutPlanes + Channel * Width;
+		uint32_t X = 0;
+		while (X < Width)
+		{
+			uint32_t Count = *Ptr++;
+			if (Count > 128)
+			{
+				Count -= 128;
+				memset(Plane + X, *Ptr++, Count);
+			}
+			else
+			{
+				memcpy(Plane + X, Ptr, Count);
+				Ptr += Count;
+			}
+			X += Count;
+		}
+	}
+}
+
+static void ConvertToRGBA32F(const FHDRDecodeContext& Context, const uint8_t* Planes, XMFLOAT4* OutRow)
+{
+	const uint32_t Width = Context.Width;
+	for (uint32_t X = 0; X < Width; ++X)
+	{
+		const XMVECTOR Mantissas = XMVectorSet(Planes[X], Planes[Width + X], Planes[2 * Width + X], 0.0f);
+		const XMVECTOR Color = XMVectorScale(Mantissas, Context.ExponentScales[Planes[3 * Width + X]]);
+		XMStoreFloat4(&OutRow[X], XMVectorSelect(g_XMOne, Color, g_XMSelect1110));
+	}
+}
+
+// Both built on first use, by the thread safe initialization of a local static.
+static FConversionTable GHalfTable;
+static FConversionTable GRGB9E5Table;
+
+static int32_t GetRGB9E5Exponent(uint32_t E)
+{
+	// M * 2^(E - 136) == (2 * M) * 2^((E - 113) - 24), both formats share the exponent.
+	return XMMin(XMMax((int32_t)E - 113, 0), 31);
+}
+
+static bool InitializeConversionTables(uint32_t Format)
+{
+	for (uint32_t E = 0; E < 256; ++E)
+	{
+		for (uint32_t M = 0; M < 256; ++M)
+		{
+			if (Format == DDS_FORMAT_R16G16B16A16_FLOAT)
+			{
+				const float Value = E > 0 ? XMMin(ldexpf((float)M, (int32_t)E - 136), 65504.0f) : 0.0f;
+				GHalfTable.Values[E][M] = PackedVector::XMConvertFloatToHalf(Value);
+			}
+			else
+			{
+				// Mantissas are 2 * M for E in [113, 144], smaller exponents shift them right (rounding), larger ones
+				// saturate.
+				const float Mantissa = E > 0 ? ldexpf(2.0f * M, (int32_t)E - 113 - GetRGB9E5Exponent(E)) : 0.0f;
+				GRGB9E5Table.Values[E][M] = (uint16_t)XMMin(Mantissa + 0.5f, 511.0f);
+			}
+		}
+	}
+	return true;
+}
+
+static const FConversionTable& GetConversionTable(uint32_t Format)
+{
+	if (Format == DDS_FORMAT_R16G16B16A16_FLOAT)
+	{
+		static const bool bIsInitialized = InitializeConversionTables(Format);
+		EA_UNUSED(bIsInitialized);
+		return GHalfTable;
+	}
+	static const bool bIsInitialized = InitializeConversionTables(Format);
+	EA_UNUSED(bIsInitialized);
+	return GRGB9E5Table;
+}
+
+static void ConvertToRGBA16F(const FHDRDecodeContext& Context, const uint8_t* Planes, uint64_t* OutRow)
+{
+	const uint32_t Width = Context.Width;
+	for (uint32_t X = 0; X < Width; ++X)
+	{
+		const uint16_t* Values = Context.Table->Values[Planes[3 * Width + X]];
+		OutRow[X] = (uint64_t)Values[Planes[X]] | (uint64_t)Values[Planes[Width + X]] << 16 | (uint64_t)Values[Planes[2 * Width + X]] << 32 | 0x3C00ull << 48;
+	}
+}
+
+static void ConvertToRGB9E5(const FHDRDecodeContext& Context, const uint8_t* Planes, uint32_t* OutRow)
+{
+	const uint32_t Width = Context.Width;
+	for (uint32_t X = 0; X < Width; ++X)
+	{
+		const uint32_t E = Planes[3 * Width + X];
+		const uint16_t* Values = Context.Table->Values[E];
+		OutRow[X] = Values[Planes[X]] | (uint32_t)Values[Planes[Width + X]] << 9 | (uint32_t)Values[Planes[2 * Width + X]] << 18 | Context.RGB9E5Exponents[E];
+	}
+}
+
+static void DecodeScanlines(void* ContextPtr, uint32_t Begin, uint32_t End)
+{
+	const FHDRDecodeContext& Context = *(const FHDRDecodeContext*)ContextPtr;
+	eastl::vector<uint8_t> Planes(Context.Width * 4);
+
+	for (uint32_t Y = Begin; Y < End; ++Y)
+	{
+		DecodeScanline(Context.Data, Context.ScanlineOffsets[Y], Context.Width, Planes.data());
+
+		const uint32_t Row = Context.bFlipVertically ? Context.Height - 1 - Y : Y;
+		uint8_t* OutRow = Context.OutTexels + Row * Context.RowPitch;
+		switch (Context.Format)
+		{
+		case DDS_FORMAT_R32G32B32A32_FLOAT: ConvertToRGBA32F(Context, Planes.data(), (XMFLOAT4*)OutRow); break;
+		case DDS_FORMAT_R16G16B16A16_FLOAT: ConvertToRGBA16F(Context, Planes.data(), (uint64_t*)OutRow); break;
+		case DDS_FORMAT_R9G9B9E5_SHAREDEXP: ConvertToRGB9E5(Context, Planes.data(), (uint32_t*)OutRow); break;
+		}
+	}
+}
+
+bool DecodeHDR(FJobSystem& Jobs, const void* FileData, uint64_t FileSize, const FHDRDesc& Desc, uint32_t Format, bool bFlipVertically, void* OutTexels, uint64_t RowPitch)
+{
+	EA_ASSERT(Format == DDS_FORMAT_R32G32B32A32_FLOAT || Format == DDS_FORMAT_R16G16B16A16_FLOAT || Format == DDS_FORMAT_R9G9B9E5_SHAREDEXP);
+	EA_ASSERT(RowPitch >= (uint64_t)Desc.Width * GetDDSBytesPerPixel(Format));
+
+	eastl::vector<uint64_t> ScanlineOffsets(Desc.Height);
+
+	FHDRDecodeContext Context;
+	Context.Data = (const uint8_t*)FileData;
+	Context.ScanlineOffsets = ScanlineOffsets.data();
+	Context.Width = Desc.Width;
+	Context.Height = Desc.Height;
+	Context.Format = Format;
+	Context.bFlipVertically = bFlipVertically;
+	Context.OutTexels = (uint8_t*)OutTexels;
+	Context.RowPitch = RowPitch;
+	Context.Table = Format != DDS_FORMAT_R32G32B32A32_FLOAT ? &GetConversionTable(Format) : nullptr;
+	for (uint32_t E = 0; E < 256; ++E)
+	{
+		Context.ExponentScales[E] = E > 0 ? ldexpf(1.0f, (int32_t)E - 136) : 0.0f;
+		Context.RGB9E5Exponents[E] = (uint32_t)GetRGB9E5Exponent(E) << 27;
+	}
+
+	// Scanlines are found sequentially but decoded in parallel: every batch is submitted as soon as its offsets
+	// are known. Images narrower than 8 or wider than 32767 pixels can not be run-length encoded.
+	FJobCounter Counter;
+	Counter.NumPending.SetValue(0);
+	bool bIsFlat = Desc.Width < 8 || Desc.Width > 32767;
+	bool bResult = true;
+	uint64_t Offset = Desc.DataOffset;
+	uint32_t FirstScanline = 0;
+	for (uint32_t Y = 0; Y < Desc.Height; ++Y)
+	{
+		const uint64_t NextOffset = SkipScanline(Context.Data, FileSize, Offset, Desc.Width, bIsFlat);
+		if (NextOffset == 0)
+		{
+			bResult = false;
+			break;
+		}
+		ScanlineOffsets[Y] = bIsFlat ? Offset | HDR_FLAT_SCANLINE : Offset;
+		Offset = NextOffset;
+
+		if (Y + 1 - FirstScanline == HDR_SCANLINES_PER_JOB || Y + 1 == Desc.Height)
+		{
+			SubmitJob(Jobs, DecodeScanlines, &Context, FirstScanline, Y + 1, Counter);
+			FirstScanline = Y + 1;
+		}
+	}
+	WaitForCounter(Jobs, Counter);
+	return bResult;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdint.h>
+
+// Radiance RGBE (.hdr) decoder. A quick sequential pass over the run-length encoded data finds where every
+// scanline starts; batches of scanlines are decoded on the job system as soon as they are found, straight into
+// the caller's memory (e.g. a mapped upload buffer). Besides the file data (ideally a mapped file) the decoder only
+// holds the scanline offsets and one scanline per job, so 8K and 16K panoramas need no intermediate float copy.
+
+struct FJobSystem;
+
+struct FHDRDesc
+{
+	uint32_t Width;
+	uint32_t Height;
+	uint64_t DataOffset; // First scanline.
+};
+
+// Reads the header. Only 32-bit_rle_rgbe pixels in the standard "-Y H +X W" orientation are supported.
+bool ParseHDRHeader(const void* FileData, uint64_t FileSize, FHDRDesc& OutDesc);
+
+// Format is DDS_FORMAT_R32G32B32A32_FLOAT, DDS_FORMAT_R16G16B16A16_FLOAT (both with alpha 1, half floats saturate at
+// 65504) or DDS_FORMAT_R9G9B9E5_SHAREDEXP. Rows are RowPitch bytes apart. With bFlipVertically the last scanline is
+// stored first, so V == 0 is the bottom row (like stbi_set_flip_vertically_on_load()). Returns false for truncated
+// or corrupt data, OutTexels is then only partially written.
+bool DecodeHDR(FJobSystem& Jobs, const void* FileData, uint64_t FileSize, const FHDRDesc& Desc, uint32_t Format, bool bFlipVertically, void* OutTexels, uint64_t RowPitch);
@@ -0,0 +1,944 @@
+#include "IBLBaker.h"
+#include "JobSystem.h"
+#include "DDSFile.h"
+#include "HDRFile.h"
+#include "MappedFile.h"
+#include "IBLCache.h"
+#include "CPUAndGPUCommon.h"
+#include "EAAssert/eaassert.h"
+#include "DirectXMath/DirectXPackedVector.h"
+#include "stb_image.h"
+
+#define PI 3.14159265359f
+
+// Mirrors RadicalInverse_VdC() and Hammersley() from Common.hlsli.
+static float RadicalInverse_VdC(uint32_t Bits)
+{
+	Bits = (Bits << 16u) | (Bits >> 16u);
+	Bits = ((Bits & 0x55555555u) << 1u) | ((Bits & 0xAAAAAAAAu) >> 1u);
+	Bits = ((Bits & 0x33333333u) << 2u) | ((Bits & 0xCCCCCCCCu) >> 2u);
+	Bits = ((Bits & 0x0F0F0F0Fu) << 4u) | ((Bits & 0xF0F0F0F0u) >> 4u);
+	Bits = ((Bits & 0x00FF00FFu) << 8u) | ((Bits & 0xFF00FF00u) >> 8u);
+	return (float)Bits * 2.3283064365386963e-10f;
+}
+
+// Tangent space half vector from ImportanceSampleGGX() (before the tangent to world transform).
+static XMFLOAT3 ImportanceSampleGGXTangentSpace(uint32_t Idx, uint32_t NumSamples, float Roughness)
+{
+	const float XiX = Idx / (float)NumSamples;
+	const float XiY = RadicalInverse_VdC(Idx);
+
+	const float Alpha = Roughness * Roughness;
+	const float Phi = 2.0f * PI * XiX;
+	const float CosTheta = sqrtf((1.0f - XiY) / (1.0f + (Alpha * Alpha - 1.0f) * XiY));
+	const float SinTheta = sqrtf(1.0f - CosTheta * CosTheta);
+
+	return XMFLOAT3(SinTheta * cosf(Phi), SinTheta * sinf(Phi), CosTheta);
+}
+
+// Same tangent frame as ImportanceSampleGGX().
+static void XM_CALLCONV GetTangentFrame(FXMVECTOR N, XMVECTOR& OutTangentX, XMVECTOR& OutTangentY)
+{
+	const XMVECTOR UpVector = fabsf(XMVectorGetY(N)) < 0.999f ? XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f) : XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
+	OutTangentX = XMVector3Normalize(XMVector3Cross(UpVector, N));
+	OutTangentY = XMVector3Cross(N, OutTangentX);
+}
+
+void CreateCubeMapImage(uint32_t Resolution, uint32_t NumMipLevels, FCubeMapImage& OutImage)
+{
+	EA_ASSERT(Resolution > 0 && NumMipLevels > 0);
+	EA_ASSERT((Resolution >> (NumMipLevels - 1)) > 0);
+
+	OutImage.Resolution = Resolution;
+	OutImage.NumMipLevels = NumMipLevels;
+	OutImage.SubresourceOffsets.resize(6 * NumMipLevels);
+
+	uint32_t Offset = 0;
+	for (uint32_t Face = 0; Face < 6; ++Face)
+	{
+		for (uint32_t Mip = 0; Mip < NumMipLevels; ++Mip)
+		{
+			const uint32_t MipResolution = GetCubeMapMipResolution(OutImage, Mip);
+			OutImage.SubresourceOffsets[Face * NumMipLevels + Mip] = Offset;
+			Offset += MipResolution * MipResolution;
+		}
+	}
+	OutImage.Texels.resize(Offset);
+}
+
+XMVECTOR XM_CALLCONV GetCubeMapDirection(uint32_t Face, float U, float V)
+{
+	const float S = 2.0f * U - 1.0f;
+	const float T = 2.0f * V - 1.0f;
+
+	XMVECTOR Direction;
+	switch (Face)
+	{
+	case CUBE_FACE_PositiveX: Direction = XMVectorSet(1.0f, -T, -S, 0.0f); break;
+	case CUBE_FACE_NegativeX: Direction = XMVectorSet(-1.0f, -T, S, 0.0f); break;
+	case CUBE_FACE_PositiveY: Direction = XMVectorSet(S, 1.0f, T, 0.0f); break;
+	case CUBE_FACE_NegativeY: Direction = XMVectorSet(S, -1.0f, -T, 0.0f); break;
+	case CUBE_FACE_PositiveZ: Direction = XMVectorSet(S, -T, 1.0f, 0.0f); break;
+	default: Direction = XMVectorSet(-S, -T, -1.0f, 0.0f); break;
+	}
+	return XMVector3Normalize(Direction);
+}
+
+static void XM_CALLCONV GetCubeMapFaceUV(FXMVECTOR Direction, uint32_t& OutFace, float& OutU, float& OutV)
+{
+	XMFLOAT3 D;
+	XMStoreFloat3(&D, Direction);
+	const float AX = fabsf(D.x);
+	const float AY = fabsf(D.y);
+	const float AZ = fabsf(D.z);
+
+	float MA, SC, TC;
+	if (AX >= AY && AX >= AZ)
+	{
+		OutFace = D.x > 0.0f ? CUBE_FACE_PositiveX : CUBE_FACE_NegativeX;
+		MA = AX;
+		SC = D.x > 0.0f ? -D.z : D.z;
+		TC = -D.y;
+	}
+	else if (AY >= AZ)
+	{
+		OutFace = D.y > 0.0f ? CUBE_FACE_PositiveY : CUBE_FACE_NegativeY;
+		MA = AY;
+		SC = D.x;
+		TC = D.y > 0.0f ? D.z : -D.z;
+	}
+	else
+	{
+		OutFace = D.z > 0.0f ? CUBE_FACE_PositiveZ : CUBE_FACE_NegativeZ;
+		MA = AZ;
+		SC = D.z > 0.0f ? D.x : -D.x;
+		TC = -D.y;
+	}
+	OutU = 0.5f * (SC / MA + 1.0f);
+	OutV = 0.5f * (TC / MA + 1.0f);
+}
+
+static XMVECTOR XM_CALLCONV SampleBilinear(const XMFLOAT4* Texels, uint32_t Width, uint32_t Height, float U, float V, bool bWrapU)
+{
+	const float X = U * Width - 0.5f;
+	const float Y = V * Height - 0.5f;
+	const float X0F = floorf(X);
+	const float Y0F = floorf(Y);
+	const float FX = X - X0F;
+	const float FY = Y - Y0F;
+
+	int32_t X0 = (int32_t)X0F;
+	int32_t X1 = X0 + 1;
+	int32_t Y0 = (int32_t)Y0F;
+	int32_t Y1 = Y0 + 1;
+	if (bWrapU)
+	{
+		X0 = (X0 + (int32_t)Width) % (int32_t)Width;
+		X1 = X1 % (int32_t)Width;
+	}
+	else
+	{
+		X0 = X0 < 0 ? 0 : (X0 >= (int32_t)Width ? (int32_t)Width - 1 : X0);
+		X1 = X1 < 0 ? 0 : (X1 >= (int32_t)Width ? (int32_t)Width - 1 : X1);
+	}
+	Y0 = Y0 < 0 ? 0 : (Y0 >= (int32_t)Height ? (int32_t)Height - 1 : Y0);
+	Y1 = Y1 < 0 ? 0 : (Y1 >= (int32_t)Height ? (int32_t)Height - 1 : Y1);
+
+	const XMVECTOR C00 = XMLoadFloat4(&Texels[Y0 * Width + X0]);
+	const XMVECTOR C10 = XMLoadFloat4(&Texels[Y0 * Width + X1]);
+	const XMVECTOR C01 = XMLoadFloat4(&Texels[Y1 * Width + X0]);
+	const XMVECTOR C11 = XMLoadFloat4(&Texels[Y1 * Width + X1]);
+
+	const XMVECTOR Top = XMVectorLerp(C00, C10, FX);
+	const XMVECTOR Bottom = XMVectorLerp(C01, C11, FX);
+	return XMVectorLerp(Top, Bottom, FY);
+}
+
+// Texels past a face edge are taken from the adjacent face (the texel center is extended over the edge of the face
+// plane and projected back onto the cube).
+static XMVECTOR XM_CALLCONV LoadCubeMapTexel(const FCubeMapImage& Image, uint32_t Face, uint32_t Mip, int32_t X, int32_t Y)
+{
+	const int32_t Resolution = (int32_t)GetCubeMapMipResolution(Image, Mip);
+	if (X < 0 || X >= Resolution || Y < 0 || Y >= Resolution)
+	{
+		float U, V;
+		GetCubeMapFaceUV(GetCubeMapDirection(Face, (X + 0.5f) / Resolution, (Y + 0.5f) / Resolution), Face, U, V);
+		X = XMMin((int32_t)(U * Resolution), Resolution - 1);
+		Y = XMMin((int32_t)(V * Resolution), Resolution - 1);
+	}
+	return XMLoadFloat4(&GetCubeMapTexels(Image, Face, Mip)[Y * Resolution + X]);
+}
+
+// Bilinear filtering across face edges, like the hardware does for cube map SRVs.
+static XMVECTOR XM_CALLCONV SampleCubeMapFace(const FCubeMapImage& Image, uint32_t Face, uint32_t Mip, float U, float V)
+{
+	const uint32_t Resolution = GetCubeMapMipResolution(Image, Mip);
+	const float X = U * Resolution - 0.5f;
+	const float Y = V * Resolution - 0.5f;
+	const float X0F = floorf(X);
+	const float Y0F = floorf(Y);
+	const int32_t X0 = (int32_t)X0F;
+	const int32_t Y0 = (int32_t)Y0F;
+
+	XMVECTOR C00, C10, C01, C11;
+	if (X0 >= 0 && Y0 >= 0 && X0 + 1 < (int32_t)Resolution && Y0 + 1 < (int32_t)Resolution)
+	{
+		const XMFLOAT4* Texels = GetCubeMapTexels(Image, Face, Mip) + Y0 * Resolution + X0;
+		C00 = XMLoadFloat4(&Texels[0]);
+		C10 = XMLoadFloat4(&Texels[1]);
+		C01 = XMLoadFloat4(&Texels[Resolution]);
+		C11 = XMLoadFloat4(&Texels[Resolution + 1]);
+	}
+	else
+	{
+		C00 = LoadCubeMapTexel(Image, Face, Mip, X0, Y0);
+		C10 = LoadCubeMapTexel(Image, Face, Mip, X0 + 1, Y0);
+		C01 = LoadCubeMapTexel(Image, Face, Mip, X0, Y0 + 1);
+		C11 = LoadCubeMapTexel(Image, Face, Mip, X0 + 1, Y0 + 1);
+	}
+
+	const XMVECTOR Top = XMVectorLerp(C00, C10, X - X0F);
+	const XMVECTOR Bottom = XMVectorLerp(C01, C11, X - X0F);
+	return XMVectorLerp(Top, Bottom, Y - Y0F);
+}
+
+XMVECTOR XM_CALLCONV SampleCubeMap(const FCubeMapImage& Image, uint32_t Mip, FXMVECTOR Direction)
+{
+	uint32_t Face;
+	float U, V;
+	GetCubeMapFaceUV(Direction, Face, U, V);
+	return SampleCubeMapFace(Image, Face, Mip, U, V);
+}
+
+XMVECTOR XM_CALLCONV SampleCubeMapLevel(const FCubeMapImage& Image, float Mip, FXMVECTOR Direction)
+{
+	uint32_t Face;
+	float U, V;
+	GetCubeMapFaceUV(Direction, Face, U, V);
+
+	const uint32_t Mip0 = (uint32_t)Mip;
+	const XMVECTOR Color0 = SampleCubeMapFace(Image, Face, Mip0, U, V);
+	const float MipFraction = Mip - Mip0;
+	if (MipFraction == 0.0f || Mip0 + 1 >= Image.NumMipLevels)
+	{
+		return Color0;
+	}
+	return XMVectorLerp(Color0, SampleCubeMapFace(Image, Face, Mip0 + 1, U, V), MipFraction);
+}
+
+bool LoadEquirectangularImage(FJobSystem& Jobs, const char* FileName, FImage2D& OutImage)
+{
+	// Radiance files go through the parallel decoder, anything else stb_image can read through stbi_loadf().
+	FMappedFile File;
+	if (OpenMappedFile(FileName, File))
+	{
+		FHDRDesc Desc;
+		if (ParseHDRHeader(File.Data, File.Size, Desc))
+		{
+			OutImage.Width = Desc.Width;
+			OutImage.Height = Desc.Height;
+			OutImage.Texels.resize((size_t)Desc.Width * Desc.Height);
+			// Flipped like in CreateEnvMap() so that V == 0 is the bottom row.
+			const bool bResult = DecodeHDR(Jobs, File.Data, File.Size, Desc, DDS_FORMAT_R32G32B32A32_FLOAT, true, OutImage.Texels.data(), Desc.Width * sizeof(XMFLOAT4));
+			CloseMappedFile(File);
+			return bResult;
+		}
+		CloseMappedFile(File);
+	}
+
+	int Width, Height;
+	stbi_set_flip_vertically_on_load(1);
+	float* Data = stbi_loadf(FileName, &Width, &Height, nullptr, 4);
+	stbi_set_flip_vertically_on_load(0);
+	if (!Data)
+	{
+		return false;
+	}
+
+	OutImage.Width = (uint32_t)Width;
+	OutImage.Height = (uint32_t)Height;
+	OutImage.Texels.resize((size_t)Width * Height);
+	memcpy(OutImage.Texels.data(), Data, OutImage.Texels.size() * sizeof(XMFLOAT4));
+
+	stbi_image_free(Data);
+	return true;
+}
+
+// Exact inverse of the longitude/latitude mapping, V == 0 is the bottom row (the image is loaded flipped).
+static void XM_CALLCONV GetEquirectangularUV(FXMVECTOR Direction, float& OutU, float& OutV)
+{
+	XMFLOAT3 D;
+	XMStoreFloat3(&D, Direction);
+	OutU = atan2f(D.z, D.x) * (0.5f / PI) + 0.5f;
+	OutV = asinf(XMMin(XMMax(D.y, -1.0f), 1.0f)) * (1.0f / PI) + 0.5f;
+}
+
+static void GetCatmullRomWeights(float T, float OutWeights[4])
+{
+	const float T2 = T * T;
+	const float T3 = T2 * T;
+	OutWeights[0] = -0.5f * T3 + T2 - 0.5f * T;
+	OutWeights[1] = 1.5f * T3 - 2.5f * T2 + 1.0f;
+	OutWeights[2] = -1.5f * T3 + 2.0f * T2 + 0.5f * T;
+	OutWeights[3] = 0.5f * T3 - 0.5f * T2;
+}
+
+// Catmull-Rom, wraps in U and clamps in V.
+static XMVECTOR XM_CALLCONV SampleBicubic(const XMFLOAT4* Texels, uint32_t Width, uint32_t Height, float U, float V)
+{
+	const float X = U * Width - 0.5f;
+	const float Y = V * Height - 0.5f;
+	const float X0F = floorf(X);
+	const float Y0F = floorf(Y);
+
+	float WeightsX[4], WeightsY[4];
+	GetCatmullRomWeights(X - X0F, WeightsX);
+	GetCatmullRomWeights(Y - Y0F, WeightsY);
+
+	int32_t Xs[4];
+	for (int32_t Idx = 0; Idx < 4; ++Idx)
+	{
+		Xs[Idx] = (((int32_t)X0F - 1 + Idx) % (int32_t)Width + (int32_t)Width) % (int32_t)Width;
+	}
+
+	XMVECTOR Result = XMVectorZero();
+	for (int32_t IdxY = 0; IdxY < 4; ++IdxY)
+	{
+		int32_t Row = (int32_t)Y0F - 1 + IdxY;
+		Row = Row < 0 ? 0 : (Row >= (int32_t)Height ? (int32_t)Height - 1 : Row);
+		const XMFLOAT4* RowTexels = &Texels[Row * Width];
+
+		XMVECTOR RowSum = XMVectorZero();
+		for (int32_t IdxX = 0; IdxX < 4; ++IdxX)
+		{
+			RowSum = XMVectorMultiplyAdd(XMLoadFloat4(&RowTexels[Xs[IdxX]]), XMVectorReplicate(WeightsX[IdxX]), RowSum);
+		}
+		Result = XMVectorMultiplyAdd(RowSum, XMVectorReplicate(WeightsY[IdxY]), Result);
+	}
+	// The negative lobes overshoot around bright spots, negative radiance would break the prefilter.
+	return XMVectorMax(Result, XMVectorZero());
+}
+
+// Supersamples the texel with an N x N grid, weighted by the solid angle of every subsample. N covers the texel with
+// at least one image texel per subsample; the image has 1 / cos(latitude) times more texels per radian along
+// the rows, so texels near the poles get more subsamples.
+static XMVECTOR XM_CALLCONV SampleEquirectangularArea(const FImage2D& Image, float TexelsPerCubeTexel, uint32_t Face, uint32_t X, uint32_t Y, uint32_t Resolution)
+{
+	const XMVECTOR Center = GetCubeMapDirection(Face, (X + 0.5f) / Resolution, (Y + 0.5f) / Resolution);
+	const float CosLatitude = sqrtf(XMMax(1.0f - XMVectorGetY(Center) * XMVectorGetY(Center), 0.0f));
+	const float NumSubsamplesF = ceilf(TexelsPerCubeTexel / XMMax(CosLatitude, 1.0f / EQUIRECT_MAX_SUBSAMPLES));
+	const uint32_t NumSubsamples = (uint32_t)XMMin(XMMax(NumSubsamplesF, 1.0f), (float)EQUIRECT_MAX_SUBSAMPLES);
+	if (NumSubsamples == 1)
+	{
+		float U, V;
+		GetEquirectangularUV(Center, U, V);
+		return SampleBilinear(Image.Texels.data(), Image.Width, Image.Height, U, V, true);
+	}
+
+	XMVECTOR Sum = XMVectorZero();
+	float TotalWeight = 0.0f;
+	for (uint32_t SubY = 0; SubY < NumSubsamples; ++SubY)
+	{
+		const float V = (Y + (SubY + 0.5f) / NumSubsamples) / Resolution;
+		const float T = 2.0f * V - 1.0f;
+		for (uint32_t SubX = 0; SubX < NumSubsamples; ++SubX)
+		{
+			const float U = (X + (SubX + 0.5f) / NumSubsamples) / Resolution;
+			const float S = 2.0f * U - 1.0f;
+
+			// dOmega = dA / (1 + S^2 + T^2)^(3/2) on the unit cube.
+			const float R2 = 1.0f + S * S + T * T;
+			const float Weight = 1.0f / (R2 * sqrtf(R2));
+
+			float ImageU, ImageV;
+			GetEquirectangularUV(GetCubeMapDirection(Face, U, V), ImageU, ImageV);
+			Sum = XMVectorMultiplyAdd(SampleBilinear(Image.Texels.data(), Image.Width, Image.Height, ImageU, ImageV, true), XMVectorReplicate(Weight), Sum);
+			TotalWeight += Weight;
+		}
+	}
+	return XMVectorScale(Sum, 1.0f / TotalWeight);
+}
+
+// 2x2 box filter of mip Mip - 1 into the Width x Height texels at (X, Y) of mip Mip.
+static void DownsampleCubeMapRegion(FCubeMapImage& InOutCubeMap, uint32_t Face, uint32_t Mip, uint32_t X, uint32_t Y, uint32_t Width, uint32_t Height)
+{
+	const XMVECTOR Quarter = XMVectorReplicate(0.25f);
+	const uint32_t Resolution = GetCubeMapMipResolution(InOutCubeMap, Mip);
+	const uint32_t SrcResolution = GetCubeMapMipResolution(InOutCubeMap, Mip - 1);
+	const XMFLOAT4* Src = GetCubeMapTexels(InOutCubeMap, Face, Mip - 1);
+	XMFLOAT4* Dst = GetCubeMapTexels(InOutCubeMap, Face, Mip);
+
+	for (uint32_t Row = Y; Row < Y + Height; ++Row)
+	{
+		const XMFLOAT4* Src0 = Src + (2 * Row) * SrcResolution;
+		const XMFLOAT4* Src1 = Src0 + (SrcResolution > 1 ? SrcResolution : 0);
+		XMFLOAT4* DstRow = Dst + Row * Resolution;
+
+		for (uint32_t Column = X; Column < X + Width; ++Column)
+		{
+			XMVECTOR Sum = XMVectorAdd(XMLoadFloat4(&Src0[2 * Column]), XMLoadFloat4(&Src0[2 * Column + 1]));
+			Sum = XMVectorAdd(Sum, XMLoadFloat4(&Src1[2 * Column]));
+			Sum = XMVectorAdd(Sum, XMLoadFloat4(&Src1[2 * Column + 1]));
+			XMStoreFloat4(&DstRow[Column], XMVectorMultiply(Sum, Quarter));
+		}
+	}
+}
+
+static void DownsampleCubeMapMip(FJobSystem& Jobs, FCubeMapImage& InOutCubeMap, uint32_t Mip)
+{
+	const uint32_t Resolution = GetCubeMapMipResolution(InOutCubeMap, Mip);
+
+	ParallelFor(Jobs, 6 * Resolution, 32, [&](uint32_t Begin, uint32_t End)
+	{
+		for (uint32_t Row = Begin; Row < End; ++Row)
+		{
+			DownsampleCubeMapRegion(InOutCubeMap, Row / Resolution, Mip, 0, Row % Resolution, Resolution, 1);
+		}
+	});
+}
+
+void ConvertEquirectangularToCubeMap(FJobSystem& Jobs, const FImage2D& Image, uint32_t Filter, FCubeMapImage& InOutEnvMap)
+{
+	const uint32_t Resolution = InOutEnvMap.Resolution;
+	EA_ASSERT(Resolution <= EQUIRECT_MAX_CUBE_RESOLUTION && (Resolution & (Resolution - 1)) == 0);
+
+	// Square tiles of mip 0 are reduced to their own mips while they are still in cache, only the mips smaller
+	// than a tile are left for the end.
+	const uint32_t TileSize = XMMin(Resolution, 32u);
+	const uint32_t NumTilesPerRow = Resolution / TileSize;
+	uint32_t NumTileMips = 1;
+	while (NumTileMips < InOutEnvMap.NumMipLevels && (TileSize >> NumTileMips) > 0)
+	{
+		++NumTileMips;
+	}
+
+	// Image texels per cube texel along a great circle at the face center (a face spans PI / 2 radians).
+	const float TexelsPerCubeTexel = Image.Width / (4.0f * Resolution);
+
+	ParallelFor(Jobs, 6 * NumTilesPerRow * NumTilesPerRow, 1, [&](uint32_t Begin, uint32_t End)
+	{
+		for (uint32_t TileIdx = Begin; TileIdx < End; ++TileIdx)
+		{
+			const uint32_t Face = TileIdx / (NumTilesPerRow * NumTilesPerRow);
+			const uint32_t TileX = (TileIdx % NumTilesPerRow) * TileSize;
+			const uint32_t TileY = (TileIdx / NumTilesPerRow % NumTilesPerRow) * TileSize;
+			XMFLOAT4* Texels = GetCubeMapTexels(InOutEnvMap, Face, 0);
+
+			for (uint32_t Y = TileY; Y < TileY + TileSize; ++Y)
+			{
+				for (uint32_t X = TileX; X < TileX + TileSize; ++X)
+				{
+					XMVECTOR Color;
+					if (Filter == EQUIRECT_FILTER_Area)
+					{
+						Color = SampleEquirectangularArea(Image, TexelsPerCubeTexel, Face, X, Y, Resolution);
+					}
+					else
+					{
+						float U, V;
+						GetEquirectangularUV(GetCubeMapDirection(Face, (X + 0.5f) / Resolution, (Y + 0.5f) / Resolution), U, V);
+						Color = Filter == EQUIRECT_FILTER_Bicubic ?
+							SampleBicubic(Image.Texels.data(), Image.Width, Image.Height, U, V) :
+							SampleBilinear(Image.Texels.data(), Image.Width, Image.Height, U, V, true);
+					}
+					XMStoreFloat4(&Texels[Y * Resolution + X], XMVectorSetW(Color, 1.0f));
+				}
+			}
+
+			for (uint32_t Mip = 1; Mip < NumTileMips; ++Mip)
+			{
+				DownsampleCubeMapRegion(InOutEnvMap, Face, Mip, TileX >> Mip, TileY >> Mip, TileSize >> Mip, TileSize >> Mip);
+			}
+		}
+	});
+
+	for (uint32_t Mip = NumTileMips; Mip < InOutEnvMap.NumMipLevels; ++Mip)
+	{
+		DownsampleCubeMapMip(Jobs, InOutEnvMap, Mip);
+	}
+}
+
+void GenerateIrradianceMap(FJobSystem& Jobs, const FCubeMapImage& EnvMap, FCubeMapImage& InOutIrradianceMap)
+{
+	// Hemisphere samples of the old GenerateIrradianceMap.hlsl in tangent space, xyz is the direction and w is the weight.
+	eastl::vector<XMFLOAT4> Samples;
+	for (float Phi = 0.0f; Phi < (2.0f * PI); Phi += 0.025f)
+	{
+		for (float Theta = 0.0f; Theta < (0.5f * PI); Theta += 0.025f)
+		{
+			Samples.push_back(XMFLOAT4(sinf(Theta) * cosf(Phi), sinf(Theta) * sinf(Phi), cosf(Theta), cosf(Theta) * sinf(Theta)));
+		}
+	}
+	const XMVECTOR Scale = XMVectorReplicate(PI / Samples.size());
+	const uint32_t Resolution = InOutIrradianceMap.Resolution;
+
+	ParallelFor(Jobs, 6 * Resolution, 1, [&](uint32_t Begin, uint32_t End)
+	{
+		for (uint32_t Row = Begin; Row < End; ++Row)
+		{
+			const uint32_t Face = Row / Resolution;
+			const uint32_t Y = Row % Resolution;
+			XMFLOAT4* Texels = GetCubeMapTexels(InOutIrradianceMap, Face, 0) + Y * Resolution;
+
+			for (uint32_t X = 0; X < Resolution; ++X)
+			{
+				const XMVECTOR N = GetCubeMapDirection(Face, (X + 0.5f) / Resolution, (Y + 0.5f) / Resolution);
+				XMVECTOR TangentX, TangentY;
+				GetTangentFrame(N, TangentX, TangentY);
+
+				XMVECTOR Irradiance = XMVectorZero();
+				for (const XMFLOAT4& Sample : Samples)
+				{
+					XMVECTOR SampleVector = XMVectorScale(TangentX, Sample.x);
+					SampleVector = XMVectorMultiplyAdd(TangentY, XMVectorReplicate(Sample.y), SampleVector);
+					SampleVector = XMVectorMultiplyAdd(N, XMVectorReplicate(Sample.z), SampleVector);
+
+					Irradiance = XMVectorMultiplyAdd(SampleCubeMap(EnvMap, 0, SampleVector), XMVectorReplicate(Sample.w), Irradiance);
+				}
+				XMStoreFloat4(&Texels[X], XMVectorSetW(XMVectorMultiply(Irradiance, Scale), 1.0f));
+			}
+		}
+	});
+}
+
+// Tile -> (mip, first texel) mapping of the PrefilterEnvMap.hlsl dispatch.
+static void GetPrefilterEnvMapTile(uint32_t Tile, uint32_t Resolution, uint32_t NumMipLevels, uint32_t& OutMip, uint32_t& OutX, uint32_t& OutY)
+{
+	uint32_t Mip = 0;
+	uint32_t MipResolution = Resolution;
+	uint32_t TilesPerRow = (MipResolution + PREFILTER_ENV_MAP_TILE_SIZE - 1) / PREFILTER_ENV_MAP_TILE_SIZE;
+	while (Tile >= TilesPerRow * TilesPerRow && Mip + 1 < NumMipLevels)
+	{
+		Tile -= TilesPerRow * TilesPerRow;
+		Mip += 1;
+		MipResolution = XMMax(MipResolution / 2, 1u);
+		TilesPerRow = (MipResolution + PREFILTER_ENV_MAP_TILE_SIZE - 1) / PREFILTER_ENV_MAP_TILE_SIZE;
+	}
+	OutMip = Mip;
+	OutX = (Tile % TilesPerRow) * PREFILTER_ENV_MAP_TILE_SIZE;
+	OutY = (Tile / TilesPerRow) * PREFILTER_ENV_MAP_TILE_SIZE;
+}
+
+void PrefilterEnvMap(FJobSystem& Jobs, const FCubeMapImage& EnvMap, uint32_t Mode, const uint32_t* NumSamples, FCubeMapImage& InOutPrefilteredEnvMap)
+{
+	const uint32_t NumMipLevels = InOutPrefilteredEnvMap.NumMipLevels;
+	// Solid angle of a texel of the source mip 0 (at the face center, where texels are largest).
+	const float TexelSolidAngle = 4.0f * PI / (6.0f * EnvMap.Resolution * EnvMap.Resolution);
+
+	// With V == N the reflected vector does not depend on N in tangent space: L = 2 * H.z * H - N.
+	// Only samples with NoL > 0 contribute, xyz is the tangent space L and w is NoL.
+	struct FMipSamples
+	{
+		eastl::vector<XMFLOAT4> Samples;
+		eastl::vector<float> SourceMips;
+		float InvTotalWeight;
+	};
+	FMipSamples MipSamples[PREFILTER_ENV_MAP_MAX_MIP_LEVELS];
+	EA_ASSERT(NumMipLevels <= PREFILTER_ENV_MAP_MAX_MIP_LEVELS);
+
+	for (uint32_t Mip = 0; Mip < NumMipLevels; ++Mip)
+	{
+		const float Roughness = NumMipLevels > 1 ? (float)Mip / (NumMipLevels - 1) : 0.0f;
+		const float Alpha2 = Roughness * Roughness * Roughness * Roughness;
+		const uint32_t NumMipSamples = NumSamples[Mip];
+		EA_ASSERT(NumMipSamples > 0);
+
+		FMipSamples& Table = MipSamples[Mip];
+		float TotalWeight = 0.0f;
+		for (uint32_t SampleIdx = 0; SampleIdx < NumMipSamples; ++SampleIdx)
+		{
+			const XMFLOAT3 H = ImportanceSampleGGXTangentSpace(SampleIdx, NumMipSamples, Roughness);
+			const float NoL = 2.0f * H.z * H.z - 1.0f;
+			if (NoL > 0.0f)
+			{
+				Table.Samples.push_back(XMFLOAT4(2.0f * H.z * H.x, 2.0f * H.z * H.y, NoL, NoL));
+				TotalWeight += NoL;
+
+				// Filtered importance sampling: the sample stands for a solid angle of 1 / (N * PDF), it reads the
+				// source mip whose texels cover about that much. With V == N the PDF of L is D(NoH) * NoH / (4 * VoH)
+				// = D(NoH) / 4. No extra LOD bias, +1 (GPU Gems 3, ch. 20) doubles the error against brute force.
+				float SourceMip = 0.0f;
+				if (Mode == PREFILTER_MODE_Filtered && Alpha2 > 0.0f)
+				{
+					const float Denominator = H.z * H.z * (Alpha2 - 1.0f) + 1.0f;
+					const float PDF = Alpha2 / (PI * Denominator * Denominator) * 0.25f;
+					const float SampleSolidAngle = 1.0f / (NumMipSamples * PDF);
+					SourceMip = XMMin(XMMax(0.5f * log2f(SampleSolidAngle / TexelSolidAngle), 0.0f), EnvMap.NumMipLevels - 1.0f);
+				}
+				Table.SourceMips.push_back(SourceMip);
+			}
+		}
+		Table.InvTotalWeight = 1.0f / TotalWeight;
+	}
+
+	// Same work decomposition as the single PrefilterEnvMap.hlsl dispatch, one job per (tile, face) thread group.
+	const uint32_t NumTiles = GetPrefilterEnvMapNumTiles(InOutPrefilteredEnvMap.Resolution, NumMipLevels);
+	ParallelFor(Jobs, 6 * NumTiles, 1, [&](uint32_t Begin, uint32_t End)
+	{
+		for (uint32_t Group = Begin; Group < End; ++Group)
+		{
+			const uint32_t Face = Group / NumTiles;
+			uint32_t Mip, TileX, TileY;
+			GetPrefilterEnvMapTile(Group % NumTiles, InOutPrefilteredEnvMap.Resolution, NumMipLevels, Mip, TileX, TileY);
+
+			const FMipSamples& Table = MipSamples[Mip];
+			const uint32_t Resolution = GetCubeMapMipResolution(InOutPrefilteredEnvMap, Mip);
+			XMFLOAT4* Texels = GetCubeMapTexels(InOutPrefilteredEnvMap, Face, Mip);
+
+			for (uint32_t Y = TileY; Y < XMMin(TileY + PREFILTER_ENV_MAP_TILE_SIZE, Resolution); ++Y)
+			{
+				for (uint32_t X = TileX; X < XMMin(TileX + PREFILTER_ENV_MAP_TILE_SIZE, Resolution); ++X)
+				{
+					const XMVECTOR N = GetCubeMapDirection(Face, (X + 0.5f) / Resolution, (Y + 0.5f) / Resolution);
+					XMVECTOR TangentX, TangentY;
+					GetTangentFrame(N, TangentX, TangentY);
+
+					XMVECTOR PrefilteredColor = XMVectorZero();
+					for (uint32_t SampleIdx = 0; SampleIdx < Table.Samples.size(); ++SampleIdx)
+					{
+						const XMFLOAT4& Sample = Table.Samples[SampleIdx];
+						XMVECTOR L = XMVectorScale(TangentX, Sample.x);
+						L = XMVectorMultiplyAdd(TangentY, XMVectorReplicate(Sample.y), L);
+						L = XMVectorMultiplyAdd(N, XMVectorReplicate(Sample.z), L);
+
+						PrefilteredColor = XMVectorMultiplyAdd(SampleCubeMapLevel(EnvMap, Table.SourceMips[SampleIdx], L), XMVectorReplicate(Sample.w), PrefilteredColor);
+					}
+					XMStoreFloat4(&Texels[Y * Resolution + X], XMVectorSetW(XMVectorScale(PrefilteredColor, Table.InvTotalWeight), 1.0f));
+				}
+			}
+		}
+	});
+}
+
+static XMVECTOR XM_CALLCONV GeometrySchlickGGX4(FXMVECTOR CosTheta, FXMVECTOR K)
+{
+	return XMVectorDivide(CosTheta, XMVectorMultiplyAdd(CosTheta, XMVectorSubtract(g_XMOne, K), K));
+}
+
+void GenerateBRDFIntegrationMap(FJobSystem& Jobs, uint32_t Resolution, uint32_t NumSamples, eastl::vector<XMFLOAT2>& OutMap)
+{
+	EA_ASSERT(NumSamples % 4 == 0);
+	OutMap.resize(Resolution * Resolution);
+
+	ParallelFor(Jobs, Resolution, 1, [&](uint32_t Begin, uint32_t End)
+	{
+		// With N = (0, 1, 0) and V = (0, NoV, sin) only H.y and H.z of ImportanceSampleGGX() matter: in world space
+		// the sample is (-H.x, H.z, H.y). Samples are processed four at a time, one per SIMD lane.
+		eastl::vector<float> HY(NumSamples);
+		eastl::vector<float> HZ(NumSamples);
+
+		for (uint32_t Y = Begin; Y < End; ++Y)
+		{
+			const float Roughness = (Y + 0.5f) / Resolution;
+			for (uint32_t SampleIdx = 0; SampleIdx < NumSamples; ++SampleIdx)
+			{
+				const XMFLOAT3 H = ImportanceSampleGGXTangentSpace(SampleIdx, NumSamples, Roughness);
+				HY[SampleIdx] = H.z;
+				HZ[SampleIdx] = H.y;
+			}
+			const XMVECTOR K = XMVectorReplicate(Roughness * Roughness * 0.5f);
+
+			for (uint32_t X = 0; X < Resolution; ++X)
+			{
+				const float NoVScalar = (X + 0.5f) / Resolution;
+				const XMVECTOR NoV = XMVectorReplicate(NoVScalar);
+				const XMVECTOR SinV = XMVectorReplicate(sqrtf(1.0f - NoVScalar * NoVScalar));
+				const XMVECTOR GV = GeometrySchlickGGX4(NoV, K);
+
+				XMVECTOR A = XMVectorZero();
+				XMVECTOR B = XMVectorZero();
+
+				for (uint32_t SampleIdx = 0; SampleIdx < NumSamples; SampleIdx += 4)
+				{
+					const XMVECTOR NoH = XMVectorSaturate(XMLoadFloat4((const XMFLOAT4*)&HY[SampleIdx]));
+					const XMVECTOR HZ4 = XMLoadFloat4((const XMFLOAT4*)&HZ[SampleIdx]);
+
+					const XMVECTOR VoHRaw = XMVectorMultiplyAdd(NoV, NoH, XMVectorMultiply(SinV, HZ4));
+					const XMVECTOR NoL = XMVectorSaturate(XMVectorSubtract(XMVectorMultiply(XMVectorAdd(VoHRaw, VoHRaw), NoH), NoV));
+					const XMVECTOR VoH = XMVectorSaturate(VoHRaw);
+
+					const XMVECTOR G = XMVectorMultiply(GV, GeometrySchlickGGX4(NoL, K));
+					const XMVECTOR GVis = XMVectorDivide(XMVectorMultiply(G, VoH), XMVectorMultiply(NoH, NoV));
+
+					const XMVECTOR OneMinusVoH = XMVectorSubtract(g_XMOne, VoH);
+					const XMVECTOR OneMinusVoH2 = XMVectorMultiply(OneMinusVoH, OneMinusVoH);
+					const XMVECTOR Fc = XMVectorMultiply(XMVectorMultiply(OneMinusVoH2, OneMinusVoH2), OneMinusVoH);
+
+					const XMVECTOR Mask = XMVectorGreater(NoL, XMVectorZero());
+					A = XMVectorAdd(A, XMVectorSelect(XMVectorZero(), XMVectorMultiply(XMVectorSubtract(g_XMOne, Fc), GVis), Mask));
+					B = XMVectorAdd(B, XMVectorSelect(XMVectorZero(), XMVectorMultiply(Fc, GVis), Mask));
+				}
+
+				XMFLOAT4 SumA, SumB;
+				XMStoreFloat4(&SumA, A);
+				XMStoreFloat4(&SumB, B);
+				OutMap[Y * Resolution + X] = XMFLOAT2((SumA.x + SumA.y + SumA.z + SumA.w) / NumSamples, (SumB.x + SumB.y + SumB.z + SumB.w) / NumSamples);
+			}
+		}
+	});
+}
+
+XMFLOAT2 SampleBRDFIntegrationMap(uint32_t Resolution, const eastl::vector<XMFLOAT2>& Map, float NoV, float Roughness)
+{
+	const float X = XMMin(XMMax(NoV * Resolution - 0.5f, 0.0f), Resolution - 1.0f);
+	const float Y = XMMin(XMMax(Roughness * Resolution - 0.5f, 0.0f), Resolution - 1.0f);
+	const uint32_t X0 = (uint32_t)X;
+	const uint32_t Y0 = (uint32_t)Y;
+	const uint32_t X1 = XMMin(X0 + 1, Resolution - 1);
+	const uint32_t Y1 = XMMin(Y0 + 1, Resolution - 1);
+
+	const XMVECTOR Top = XMVectorLerp(XMLoadFloat2(&Map[Y0 * Resolution + X0]), XMLoadFloat2(&Map[Y0 * Resolution + X1]), X - X0);
+	const XMVECTOR Bottom = XMVectorLerp(XMLoadFloat2(&Map[Y1 * Resolution + X0]), XMLoadFloat2(&Map[Y1 * Resolution + X1]), X - X0);
+
+	XMFLOAT2 Result;
+	XMStoreFloat2(&Result, XMVectorLerp(Top, Bottom, Y - Y0));
+	return Result;
+}
+
+void QuantizeBRDFIntegrationMap(uint32_t Format, eastl::vector<XMFLOAT2>& InOutMap)
+{
+	EA_ASSERT(Format == DDS_FORMAT_R16G16_FLOAT || Format == DDS_FORMAT_R8G8_UNORM);
+
+	for (XMFLOAT2& Texel : InOutMap)
+	{
+		const XMVECTOR Value = XMLoadFloat2(&Texel);
+		if (Format == DDS_FORMAT_R16G16_FLOAT)
+		{
+			PackedVector::XMHALF2 Packed;
+			PackedVector::XMStoreHalf2(&Packed, Value);
+			XMStoreFloat2(&Texel, PackedVector::XMLoadHalf2(&Packed));
+		}
+		else
+		{
+			PackedVector::XMUBYTEN2 Packed;
+			PackedVector::XMStoreUByteN2(&Packed, Value);
+			XMStoreFloat2(&Texel, PackedVector::XMLoadUByteN2(&Packed));
+		}
+	}
+}
+
+void GetDefaultBRDFApprox(FBRDFApprox& OutApprox)
+{
+	OutApprox.C0 = XMFLOAT4(-1.0f, -0.0275f, -0.572f, 0.022f);
+	OutApprox.C1 = XMFLOAT4(1.0f, 0.0425f, 1.04f, -0.04f);
+}
+
+XMFLOAT2 EvaluateBRDFApprox(const FBRDFApprox& Approx, float NoV, float Roughness)
+{
+	const float RX = Approx.C0.x * Roughness + Approx.C1.x;
+	const float RY = Approx.C0.y * Roughness + Approx.C1.y;
+	const float RZ = Approx.C0.z * Roughness + Approx.C1.z;
+	const float RW = Approx.C0.w * Roughness + Approx.C1.w;
+	const float A = XMMin(RX * RX, exp2f(-9.28f * NoV)) * RX + RY;
+	return XMFLOAT2(-1.04f * A + RZ, 1.04f * A + RW);
+}
+
+static float GetBRDFApproxError(const float* Coefficients, const eastl::vector<XMFLOAT4>& Points)
+{
+	FBRDFApprox Approx;
+	memcpy(&Approx, Coefficients, sizeof(Approx));
+
+	float Error = 0.0f;
+	for (const XMFLOAT4& Point : Points)
+	{
+		const XMFLOAT2 Value = EvaluateBRDFApprox(Approx, Point.x, Point.y);
+		Error += (Value.x - Point.z) * (Value.x - Point.z) + (Value.y - Point.w) * (Value.y - Point.w);
+	}
+	return Error / Points.size();
+}
+
+void FitBRDFApprox(uint32_t Resolution, const eastl::vector<XMFLOAT2>& Map, FBRDFApprox& InOutApprox)
+{
+	const uint32_t NumParameters = sizeof(FBRDFApprox) / sizeof(float);
+	static_assert(sizeof(FBRDFApprox) == 8 * sizeof(float), "FBRDFApprox must be tightly packed.");
+
+	// NoV, Roughness, Scale, Bias at (at most) 64 x 64 texel centers.
+	eastl::vector<XMFLOAT4> Points;
+	const uint32_t Step = Resolution > 64 ? Resolution / 64 : 1;
+	for (uint32_t Y = Step / 2; Y < Resolution; Y += Step)
+	{
+		for (uint32_t X = Step / 2; X < Resolution; X += Step)
+		{
+			const XMFLOAT2& Texel = Map[Y * Resolution + X];
+			Points.push_back(XMFLOAT4((X + 0.5f) / Resolution, (Y + 0.5f) / Resolution, Texel.x, Texel.y));
+		}
+	}
+
+	// Nelder-Mead simplex with the standard reflection, expansion, contraction and shrink coefficients.
+	float Simplex[NumParameters + 1][NumParameters];
+	float Errors[NumParameters + 1];
+	for (uint32_t VertexIdx = 0; VertexIdx <= NumParameters; ++VertexIdx)
+	{
+		memcpy(Simplex[VertexIdx], &InOutApprox, sizeof(InOutApprox));
+		if (VertexIdx > 0)
+		{
+			float& Parameter = Simplex[VertexIdx][VertexIdx - 1];
+			Parameter += fabsf(Parameter) > 1.0e-3f ? 0.1f * Parameter : 0.01f;
+		}
+		Errors[VertexIdx] = GetBRDFApproxError(Simplex[VertexIdx], Points);
+	}
+
+	for (uint32_t Iteration = 0; Iteration < 4000; ++Iteration)
+	{
+		uint32_t Best = 0, Worst = 0, SecondWorst = 0;
+		for (uint32_t VertexIdx = 1; VertexIdx <= NumParameters; ++VertexIdx)
+		{
+			Best = Errors[VertexIdx] < Errors[Best] ? VertexIdx : Best;
+			Worst = Errors[VertexIdx] > Errors[Worst] ? VertexIdx : Worst;
+		}
+		SecondWorst = Best;
+		for (uint32_t VertexIdx = 0; VertexIdx <= NumParameters; ++VertexIdx)
+		{
+			SecondWorst = VertexIdx != Worst && Errors[VertexIdx] > Errors[SecondWorst] ? VertexIdx : SecondWorst;
+		}
+		if (Errors[Worst] - Errors[Best] <= 1.0e-12f)
+		{
+			break;
+		}
+
+		float Centroid[NumParameters] = {};
+		for (uint32_t VertexIdx = 0; VertexIdx <= NumParameters; ++VertexIdx)
+		{
+			if (VertexIdx == Worst)
+			{
+				continue;
+			}
+			for (uint32_t Idx = 0; Idx < NumParameters; ++Idx)
+			{
+				Centroid[Idx] += Simplex[VertexIdx][Idx] / NumParameters;
+			}
+		}
+
+		auto GetPoint = [&](float T, float* OutPoint)
+		{
+			for (uint32_t Idx = 0; Idx < NumParameters; ++Idx)
+			{
+				OutPoint[Idx] = Centroid[Idx] + T * (Simplex[Worst][Idx] - Centroid[Idx]);
+			}
+			return GetBRDFApproxError(OutPoint, Points);
+		};
+
+		float Reflected[NumParameters], Candidate[NumParameters];
+		const float ReflectedError = GetPoint(-1.0f, Reflected);
+		if (ReflectedError < Errors[Best])
+		{
+			const float ExpandedError = GetPoint(-2.0f, Candidate);
+			const bool bExpand = ExpandedError < ReflectedError;
+			memcpy(Simplex[Worst], bExpand ? Candidate : Reflected, sizeof(Reflected));
+			Errors[Worst] = bExpand ? ExpandedError : ReflectedError;
+		}
+		else if (ReflectedError < Errors[SecondWorst])
+		{
+			memcpy(Simplex[Worst], Reflected, sizeof(Reflected));
+			Errors[Worst] = ReflectedError;
+		}
+		else
+		{
+			const float ContractedError = GetPoint(ReflectedError < Errors[Worst] ? -0.5f : 0.5f, Candidate);
+			if (ContractedError < XMMin(ReflectedError, Errors[Worst]))
+			{
+				memcpy(Simplex[Worst], Candidate, sizeof(Candidate));
+				Errors[Worst] = ContractedError;
+			}
+			else
+			{
+				for (uint32_t VertexIdx = 0; VertexIdx <= NumParameters; ++VertexIdx)
+				{
+					if (VertexIdx == Best)
+					{
+						continue;
+					}
+					for (uint32_t Idx = 0; Idx < NumParameters; ++Idx)
+					{
+						Simplex[VertexIdx][Idx] = Simplex[Best][Idx] + 0.5f * (Simplex[VertexIdx][Idx] - Simplex[Best][Idx]);
+					}
+					Errors[VertexIdx] = GetBRDFApproxError(Simplex[VertexIdx], Points);
+				}
+			}
+		}
+	}
+
+	uint32_t Best = 0;
+	for (uint32_t VertexIdx = 1; VertexIdx <= NumParameters; ++VertexIdx)
+	{
+		Best = Errors[VertexIdx] < Errors[Best] ? VertexIdx : Best;
+	}
+	memcpy(&InOutApprox, Simplex[Best], sizeof(InOutApprox));
+}
+
+void GetCubeMapDDSData(const FCubeMapImage& Image, FDDSDesc& OutDesc, eastl::vector<uint16_t>& OutData)
+{
+	OutData.resize(Image.Texels.size() * 4);
+	PackedVector::XMConvertFloatToHalfStream(OutData.data(), sizeof(PackedVector::HALF), &Image.Texels[0].x, sizeof(float), OutData.size());
+
+	OutDesc = {};
+	OutDesc.Format = DDS_FORMAT_R16G16B16A16_FLOAT;
+	OutDesc.Width = Image.Resolution;
+	OutDesc.Height = Image.Resolution;
+	OutDesc.ArraySize = 1;
+	OutDesc.NumMipLevels = Image.NumMipLevels;
+	OutDesc.bIsCubeMap = true;
+}
+
+bool CreateCubeMapImageFromDDS(const FDDSDesc& Desc, const uint8_t* Pixels, FCubeMapImage& OutImage)
+{
+	if (!Desc.bIsCubeMap || Desc.ArraySize != 1 || Desc.Width != Desc.Height || Desc.NumMipLevels == 0 || (Desc.Width >> (Desc.NumMipLevels - 1)) == 0 ||
+		(Desc.Format != DDS_FORMAT_R16G16B16A16_FLOAT && Desc.Format != DDS_FORMAT_R32G32B32A32_FLOAT))
+	{
+		return false;
+	}
+
+	CreateCubeMapImage(Desc.Width, Desc.NumMipLevels, OutImage);
+	if (Desc.Format == DDS_FORMAT_R16G16B16A16_FLOAT)
+	{
+		PackedVector::XMConvertHalfToFloatStream(&OutImage.Texels[0].x, sizeof(float), (const PackedVector::HALF*)Pixels, sizeof(PackedVector::HALF),
+			OutImage.Texels.size() * 4);
+	}
+	else
+	{
+		memcpy(OutImage.Texels.data(), Pixels, OutImage.Texels.size() * sizeof(XMFLOAT4));
+	}
+	return true;
+}
+
+void GetBRDFIntegrationMapDDSData(uint32_t Format, uint32_t Resolution, const eastl::vector<XMFLOAT2>& Map, FDDSDesc& OutDesc, eastl::vector<uint8_t>& OutData)
+{
+	EA_ASSERT(Format == DDS_FORMAT_R16G16_FLOAT || Format == DDS_FORMAT_R8G8_UNORM);
+
+	OutData.resize(Map.size() * GetDDSBytesPerPixel(Format));
+	for (uint32_t TexelIdx = 0; TexelIdx < Map.size(); ++TexelIdx)
+	{
+		const XMVECTOR Value = XMLoadFloat2(&Map[TexelIdx]);
+		if (Format == DDS_FORMAT_R16G16_FLOAT)
+		{
+			PackedVector::XMStoreHalf2((PackedVector::XMHALF2*)OutData.data() + TexelIdx, Value);
+		}
+		else
+		{
+			PackedVector::XMStoreUByteN2((PackedVector::XMUBYTEN2*)OutData.data() + TexelIdx, Value);
+		}
+	}
+
+	OutDesc = {};
+	OutDesc.Format = Format;
+	OutDesc.Width = Resolution;
+	OutDesc.Height = Resolution;
+	OutDesc.ArraySize = 1;
+	OutDesc.NumMipLevels = 1;
+}
+
+bool SaveCubeMapDDS(const char* FileName, const FCubeMapImage& Image)
+{
+	FDDSDesc Desc;
+	eastl::vector<uint16_t> Data;
+	GetCubeMapDDSData(Image, Desc, Data);
+	return SaveDDS(FileName, Desc, Data.data());
+}
+
+bool SaveBRDFIntegrationMapDDS(const char* FileName, uint32_t Format, uint32_t Resolution, const eastl::vector<XMFLOAT2>& Map)
+{
+	FDDSDesc Desc;
+	eastl::vector<uint8_t> Data;
+	GetBRDFIntegrationMapDDSData(Format, Resolution, Map, Desc, Data);
+	return SaveDDS(FileName, Desc, Data.data());
+}
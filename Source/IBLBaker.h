@@ -0,0 +1,110 @@
+#pragma once
+
+#include <stdint.h>
+#include "EASTL/vector.h"
+#include "DirectXMath/DirectXMath.h"
+
+// CPU implementation of the image based lighting precompute chain. The math mirrors Shaders/Common.hlsli and the
+// EquirectangularToCube and PrefilterEnvMap shaders, so results can be used in place of (or compared against) the GPU
+// passes recorded in Initialize(). The BRDF integration map is only generated here (offline, see
+// BRDFIntegrationMapData.h). No graphics API is used.
+
+struct FJobSystem;
+struct FDDSDesc;
+
+#define EQUIRECT_MAX_CUBE_RESOLUTION 4096
+#define EQUIRECT_MAX_SUBSAMPLES 16 // Per axis, EQUIRECT_FILTER_Area.
+
+enum
+{
+	CUBE_FACE_PositiveX, CUBE_FACE_NegativeX, CUBE_FACE_PositiveY, CUBE_FACE_NegativeY, CUBE_FACE_PositiveZ, CUBE_FACE_NegativeZ,
+};
+
+struct FImage2D
+{
+	uint32_t Width;
+	uint32_t Height;
+	eastl::vector<XMFLOAT4> Texels;
+};
+
+struct FCubeMapImage
+{
+	uint32_t Resolution;
+	uint32_t NumMipLevels;
+	eastl::vector<XMFLOAT4> Texels; // D3D12 subresource order (Face * NumMipLevels + Mip), rows tightly packed.
+	eastl::vector<uint32_t> SubresourceOffsets;
+};
+
+void CreateCubeMapImage(uint32_t Resolution, uint32_t NumMipLevels, FCubeMapImage& OutImage);
+
+inline uint32_t GetCubeMapMipResolution(const FCubeMapImage& Image, uint32_t Mip)
+{
+	const uint32_t Resolution = Image.Resolution >> Mip;
+	return Resolution > 0 ? Resolution : 1;
+}
+
+inline XMFLOAT4* GetCubeMapTexels(FCubeMapImage& Image, uint32_t Face, uint32_t Mip)
+{
+	return &Image.Texels[Image.SubresourceOffsets[Face * Image.NumMipLevels + Mip]];
+}
+
+inline const XMFLOAT4* GetCubeMapTexels(const FCubeMapImage& Image, uint32_t Face, uint32_t Mip)
+{
+	return &Image.Texels[Image.SubresourceOffsets[Face * Image.NumMipLevels + Mip]];
+}
+
+// Direction through (U, V) in [0, 1] on a cube face (D3D cube map conventions, V points down).
+XMVECTOR XM_CALLCONV GetCubeMapDirection(uint32_t Face, float U, float V);
+// Bilinear sample of a single mip level (like FILTER_MIN_MAG_LINEAR_MIP_POINT, filtered across face edges).
+XMVECTOR XM_CALLCONV SampleCubeMap(const FCubeMapImage& Image, uint32_t Mip, FXMVECTOR Direction);
+// Trilinear sample at a fractional mip (like FILTER_MIN_MAG_MIP_LINEAR with SampleLevel()).
+XMVECTOR XM_CALLCONV SampleCubeMapLevel(const FCubeMapImage& Image, float Mip, FXMVECTOR Direction);
+
+// Radiance (.hdr) files are decoded on the job system (see HDRFile.h), other formats with stb_image.
+bool LoadEquirectangularImage(FJobSystem& Jobs, const char* FileName, FImage2D& OutImage);
+
+// All functions below fill every face of the output cube map; the output must be created with CreateCubeMapImage().
+// Exact longitude/latitude mapping (U = atan2(z, x) / (2 * PI) + 0.5, V = asin(y) / PI + 0.5), wrapping in U. The
+// resolution must be a power of two up to EQUIRECT_MAX_CUBE_RESOLUTION. Fills all mips in one pass: tiles of mip 0 are
+// converted on the job system and box filtered to their mips right away. Filter is an EQUIRECT_FILTER_ (IBLCache.h),
+// EQUIRECT_FILTER_Bicubic is Catmull-Rom (clamped to 0), EQUIRECT_FILTER_Area supersamples texels that cover more than one image texel (downscale
+// and near the poles) with solid angle weights and is bilinear otherwise.
+void ConvertEquirectangularToCubeMap(FJobSystem& Jobs, const FImage2D& Image, uint32_t Filter, FCubeMapImage& InOutEnvMap);
+// Brute force irradiance / PI (the removed GenerateIrradianceMap.hlsl pass), the reference for the SH irradiance.
+void GenerateIrradianceMap(FJobSystem& Jobs, const FCubeMapImage& EnvMap, FCubeMapImage& InOutIrradianceMap);
+// Mip N of the output is prefiltered with Roughness = N / (NumMipLevels - 1) and NumSamples[N] GGX samples per texel.
+// Mode is a PREFILTER_MODE_ (IBLCache.h). The CPU twin of the PrefilterEnvMap.hlsl compute kernel: same math, same
+// (tile, face) work decomposition, so a GPU result can be checked against it texel by texel.
+void PrefilterEnvMap(FJobSystem& Jobs, const FCubeMapImage& EnvMap, uint32_t Mode, const uint32_t* NumSamples, FCubeMapImage& InOutPrefilteredEnvMap);
+// Row-major Resolution x Resolution map, x is NoV and y is Roughness, both evaluated at texel centers so that the
+// bilinear lookup in SimpleForward.hlsl is exact at every texel.
+void GenerateBRDFIntegrationMap(FJobSystem& Jobs, uint32_t Resolution, uint32_t NumSamples, eastl::vector<XMFLOAT2>& OutMap);
+// Bilinear, clamped lookup (like GSampler in SimpleForward.hlsl).
+XMFLOAT2 SampleBRDFIntegrationMap(uint32_t Resolution, const eastl::vector<XMFLOAT2>& Map, float NoV, float Roughness);
+// Round trip through DDS_FORMAT_R16G16_FLOAT or DDS_FORMAT_R8G8_UNORM, to measure the error of the stored format.
+void QuantizeBRDFIntegrationMap(uint32_t Format, eastl::vector<XMFLOAT2>& InOutMap);
+
+// Analytic approximation of the BRDF integration map in the form of EnvBRDFApprox() (Karis, "Physically Based
+// Shading on Mobile"): R = C0 * Roughness + C1, A = min(R.x^2, exp2(-9.28 * NoV)) * R.x + R.y,
+// Scale = -1.04 * A + R.z, Bias = 1.04 * A + R.w.
+struct FBRDFApprox
+{
+	XMFLOAT4 C0;
+	XMFLOAT4 C1;
+};
+
+// The published coefficients.
+void GetDefaultBRDFApprox(FBRDFApprox& OutApprox);
+// Least squares fit (Nelder-Mead) to Map, starting from InOutApprox.
+void FitBRDFApprox(uint32_t Resolution, const eastl::vector<XMFLOAT2>& Map, FBRDFApprox& InOutApprox);
+XMFLOAT2 EvaluateBRDFApprox(const FBRDFApprox& Approx, float NoV, float Roughness);
+
+// Convert to (and store as) DDS data. Cube maps are RGBA16F like the GPU resources, the BRDF integration map is
+// DDS_FORMAT_R16G16_FLOAT or DDS_FORMAT_R8G8_UNORM.
+void GetCubeMapDDSData(const FCubeMapImage& Image, FDDSDesc& OutDesc, eastl::vector<uint16_t>& OutData);
+// Inverse of GetCubeMapDDSData() (e.g. for GPU baked IBL cache entries). Returns false for anything but a single RGBA16F
+// or RGBA32F cube.
+bool CreateCubeMapImageFromDDS(const FDDSDesc& Desc, const uint8_t* Pixels, FCubeMapImage& OutImage);
+void GetBRDFIntegrationMapDDSData(uint32_t Format, uint32_t Resolution, const eastl::vector<XMFLOAT2>& Map, FDDSDesc& OutDesc, eastl::vector<uint8_t>& OutData);
+bool SaveCubeMapDDS(const char* FileName, const FCubeMapImage& Image);
+bool SaveBRDFIntegrationMapDDS(const char* FileName, uint32_t Format, uint32_t Resolution, const eastl::vector<XMFLOAT2>& Map);
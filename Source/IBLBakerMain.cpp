@@ -0,0 +1,1714 @@
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "EASTL/algorithm.h"
+#include "EASTL/sort.h"
+#include "EASTL/string.h"
+#include "EAStdC/EASprintf.h"
+#include "EAStdC/EAString.h"
+#include "EAStdC/EAStopwatch.h"
+#include "EAThread/eathread_atomic.h"
+#include "EAThread/eathread_thread.h"
+#include "JobSystem.h"
+#include "DDSFile.h"
+#include "HDRFile.h"
+#include "MappedFile.h"
+#include "IBLBaker.h"
+#include "IBLCache.h"
+#include "SphericalHarmonics.h"
+#include "stb_image.h"
+#include "DirectXMath/DirectXPackedVector.h"
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#include <io.h>
+#else
+#include <dirent.h>
+#endif
+
+// Headless command line front end for the CPU IBL baker.
+//
+// IBLBaker bake <input.hdr> <output directory> [options]
+//   -threads N              worker threads (default: one per core)
+//   -env-res N              environment cube map resolution, a power of two up to 4096 (default: 512)
+//   -env-filter F           bilinear, bicubic or area (default: area)
+//   -prefilter-res N        prefiltered cube map resolution (default: 256)
+//   -prefilter-mips N       prefiltered cube map mip levels, up to 8 (default: 6)
+//   -prefilter-mode M       filtered (importance samples read env. map mips, like PrefilterEnvMap.hlsl) or brute-force
+//                           (every sample reads mip 0, the old shader) (default: filtered)
+//   -prefilter-samples N    GGX samples per prefiltered texel of every mip (default: GetPrefilterNumSamples(), filtered only)
+//   -cache DIR              also store the result as an IBL cache entry in DIR (e.g. Data/IBLCache)
+//
+// IBLBaker batch <input directory or list file> <output directory> [bake options] [-in-flight N]
+//   Bakes every .hdr file in the input directory, or every file in the list file (one path per line, # starts a
+//   comment), to <output directory>/<file name without extension>/. N files (default: 3) are baked at once, each
+//   runs its stages on the shared thread pool: the load (I/O and decode) and save (encode and write) of one file
+//   overlap the convert and prefilter of the others, and memory stays bounded by N files. Reports probes per minute.
+//
+// IBLBaker brdf-lut <output file> [options]
+//   Generates the split-sum BRDF integration map. The output type follows the extension: .h is a constexpr header
+//   for embedding (see BRDFIntegrationMapData.h), .dds a DDS texture, anything else a raw blob (texels or the
+//   analytic coefficients).
+//   -threads N              worker threads (default: one per core)
+//   -res N                  resolution, 32 to 512 (default: 128)
+//   -samples N              GGX samples per texel, a multiple of 4 (default: 4096)
+//   -format F               rg16f, rg8 or analytic (EnvBRDFApprox() coefficients fitted to the map, default: rg16f)
+//
+// IBLBaker brdf-lut-benchmark [-threads N] [-samples N]
+//   Size and error of every resolution and format against the 512x512 map with 4096 samples.
+//
+// IBLBaker hdr-benchmark <input.hdr> [-threads N] [-scale N] [-runs N]
+//   Throughput and peak RSS growth of DecodeHDR() (all output formats) and stbi_loadf(). -scale upscales the image
+//   in memory first (4 gives an 8K, 8 a 16K panorama from a 2K one).
+//
+// IBLBaker equirect-compare <input.hdr> [-threads N] [-env-res N]
+//   Time and error of every equirectangular to cube filter against the area filtered cube map at 4x the resolution
+//   (box filtered down, the golden reference). Env. map resolution defaults to 256.
+//
+// IBLBaker prefilter-benchmark <input.hdr> [-threads N] [-env-res N] [-prefilter-res N] [-prefilter-mips N] [-ref-samples N]
+//   Time and per-mip error of brute force and filtered importance sampling (several sample counts and the default
+//   schedule) against brute force with -ref-samples (default: 16384). Defaults: env. map 512, prefiltered 64 x 6 mips.
+//
+// IBLBaker cache-list <cache directory>
+//   Lists cache entries with their keys and sizes.
+//
+// IBLBaker cache-verify <cache directory> [-threads N] [-tolerance N]
+//   Re-runs the prefilter of every cache entry (e.g. baked by the demo with PrefilterEnvMap.hlsl) on the CPU twin,
+//   from the cached env. map, and compares the prefiltered env. map texel by texel. Fails if any texel differs by more
+//   than -tolerance (relative, in 0.1%, default: 20).
+//
+// IBLBaker sh-accuracy <input.hdr> [-threads N] [-env-res N] [-irr-res N]
+//   Compares the SH irradiance projected from every env. map mip with the brute force irradiance cube map
+//   (irradiance cube map resolution defaults to 64).
+
+void* operator new[](size_t Size, const char* /*Name*/, int /*Flags*/, unsigned /*DebugFlags*/, const char* /*File*/, int /*Line*/)
+{
+	return malloc(Size);
+}
+
+void* operator new[](size_t Size, size_t Alignment, size_t AlignmentOffset, const char* /*Name*/, int /*Flags*/, unsigned /*DebugFlags*/, const char* /*File*/, int /*Line*/)
+{
+#ifdef _WIN32
+	return _aligned_offset_malloc(Size, Alignment, AlignmentOffset);
+#else
+	EA_UNUSED(AlignmentOffset);
+	return aligned_alloc(Alignment, (Size + Alignment - 1) & ~(Alignment - 1));
+#endif
+}
+
+struct FBakeSettings
+{
+	uint32_t NumThreads;
+	uint32_t EnvMapResolution;
+	uint32_t PrefilteredEnvMapResolution;
+	uint32_t PrefilteredEnvMapNumMipLevels;
+	uint32_t PrefilteredEnvMapNumSamples; // 0 is the per-mip default (GetPrefilterNumSamples()).
+	uint32_t PrefilterMode;
+	uint32_t EnvMapFilter;
+	const char* CacheDirectory;
+	uint32_t NumProbesInFlight; // batch only.
+};
+
+static const char* const GEquirectangularFilterNames[] = { "bilinear", "bicubic", "area" };
+static const char* const GPrefilterModeNames[] = { "brute-force", "filtered" };
+
+static bool ParseEquirectangularFilter(const char* Name, uint32_t& OutFilter)
+{
+	for (uint32_t Filter = 0; Filter < eastl::size(GEquirectangularFilterNames); ++Filter)
+	{
+		if (EA::StdC::Stricmp(Name, GEquirectangularFilterNames[Filter]) == 0)
+		{
+			OutFilter = Filter;
+			return true;
+		}
+	}
+	fprintf(stderr, "Invalid filter: %s\n", Name);
+	return false;
+}
+
+static bool ParsePrefilterMode(const char* Name, uint32_t& OutMode)
+{
+	for (uint32_t Mode = 0; Mode < eastl::size(GPrefilterModeNames); ++Mode)
+	{
+		if (EA::StdC::Stricmp(Name, GPrefilterModeNames[Mode]) == 0)
+		{
+			OutMode = Mode;
+			return true;
+		}
+	}
+	fprintf(stderr, "Invalid prefilter mode: %s\n", Name);
+	return false;
+}
+
+static bool IsValidPrefilteredEnvMapSize(uint32_t Resolution, uint32_t NumMipLevels)
+{
+	if (NumMipLevels == 0 || NumMipLevels > IBL_MAX_PREFILTERED_MIP_LEVELS || (Resolution >> (NumMipLevels - 1)) == 0)
+	{
+		fprintf(stderr, "Invalid prefiltered env. map mip count (1 to %u, the last mip at least 1x1).\n", IBL_MAX_PREFILTERED_MIP_LEVELS);
+		return false;
+	}
+	return true;
+}
+
+static bool IsValidEnvMapResolution(uint32_t Resolution)
+{
+	if (Resolution == 0 || Resolution > EQUIRECT_MAX_CUBE_RESOLUTION || (Resolution & (Resolution - 1)) != 0)
+	{
+		fprintf(stderr, "Invalid env. map resolution (a power of two up to %u).\n", EQUIRECT_MAX_CUBE_RESOLUTION);
+		return false;
+	}
+	return true;
+}
+
+struct FOption
+{
+	const char* Name;
+	uint32_t* Value;
+	const char** String;
+};
+
+static bool ParseOptions(int Argc, char** Argv, const FOption* Options, uint32_t NumOptions)
+{
+	for (int ArgIdx = 0; ArgIdx < Argc; ArgIdx += 2)
+	{
+		const FOption* Option = nullptr;
+		for (uint32_t OptionIdx = 0; OptionIdx < NumOptions; ++OptionIdx)
+		{
+			if (EA::StdC::Strcmp(Argv[ArgIdx], Options[OptionIdx].Name) == 0)
+			{
+				Option = &Options[OptionIdx];
+				break;
+			}
+		}
+		if (!Option || ArgIdx + 1 >= Argc)
+		{
+			fprintf(stderr, "Invalid option: %s\n", Argv[ArgIdx]);
+			return false;
+		}
+		if (Option->Value)
+		{
+			*Option->Value = EA::StdC::StrtoU32(Argv[ArgIdx + 1], nullptr, 10);
+		}
+		else
+		{
+			*Option->String = Argv[ArgIdx + 1];
+		}
+	}
+	return true;
+}
+
+static bool ParseBakeSettings(int Argc, char** Argv, FBakeSettings& OutSettings)
+{
+	OutSettings.NumThreads = 0;
+	OutSettings.EnvMapResolution = 512;
+	OutSettings.PrefilteredEnvMapResolution = 256;
+	OutSettings.PrefilteredEnvMapNumMipLevels = 6;
+	OutSettings.PrefilteredEnvMapNumSamples = 0;
+	OutSettings.CacheDirectory = nullptr;
+	OutSettings.NumProbesInFlight = 3;
+	const char* FilterName = "area";
+	const char* PrefilterModeName = "filtered";
+
+	const FOption Options[] =
+	{
+		{ "-threads", &OutSettings.NumThreads, nullptr },
+		{ "-env-res", &OutSettings.EnvMapResolution, nullptr },
+		{ "-prefilter-res", &OutSettings.PrefilteredEnvMapResolution, nullptr },
+		{ "-prefilter-mips", &OutSettings.PrefilteredEnvMapNumMipLevels, nullptr },
+		{ "-prefilter-samples", &OutSettings.PrefilteredEnvMapNumSamples, nullptr },
+		{ "-prefilter-mode", nullptr, &PrefilterModeName },
+		{ "-env-filter", nullptr, &FilterName },
+		{ "-cache", nullptr, &OutSettings.CacheDirectory },
+		{ "-in-flight", &OutSettings.NumProbesInFlight, nullptr },
+	};
+	if (!ParseOptions(Argc, Argv, Options, (uint32_t)eastl::size(Options)) || !ParseEquirectangularFilter(FilterName, OutSettings.EnvMapFilter) ||
+		!ParsePrefilterMode(PrefilterModeName, OutSettings.PrefilterMode) || !IsValidEnvMapResolution(OutSettings.EnvMapResolution))
+	{
+		return false;
+	}
+	if (OutSettings.NumProbesInFlight == 0)
+	{
+		fprintf(stderr, "-in-flight must be at least 1.\n");
+		return false;
+	}
+	if (OutSettings.PrefilteredEnvMapNumSamples == 0 && OutSettings.PrefilterMode == PREFILTER_MODE_BruteForce)
+	{
+		fprintf(stderr, "Brute force prefiltering needs -prefilter-samples.\n");
+		return false;
+	}
+	return IsValidPrefilteredEnvMapSize(OutSettings.PrefilteredEnvMapResolution, OutSettings.PrefilteredEnvMapNumMipLevels);
+}
+
+// Full mip chain, like the GPU env. map created in Initialize().
+static uint32_t GetNumMipLevels(uint32_t Resolution)
+{
+	uint32_t NumMipLevels = 1;
+	while ((Resolution >> NumMipLevels) > 0)
+	{
+		++NumMipLevels;
+	}
+	return NumMipLevels;
+}
+
+enum
+{
+	BAKE_STAGE_Load, BAKE_STAGE_Convert, BAKE_STAGE_Prefilter, BAKE_STAGE_Save, BAKE_STAGE_Count,
+};
+
+static const char* const GBakeStageNames[BAKE_STAGE_Count] = { "Load", "Equirectangular to cube", "Prefiltered env. map", "Save" };
+
+struct FBakeResult
+{
+	float StageTimes[BAKE_STAGE_Count]; // Milliseconds.
+	uint32_t ImageWidth;
+	uint32_t ImageHeight;
+	uint64_t CacheKeyHash; // Zero without -cache.
+	bool bIsLoaded; // False: the input could not be read, otherwise the output could not be written.
+};
+
+// Bakes one input file to EnvMap.dds and PrefilteredEnvMap.dds in OutputDirectory (created when missing, its parent
+// must exist). Every stage runs on the job system and intermediate images are freed as soon as the next stage is done
+// with them, so several files can be baked at once (see BakeBatch()).
+static bool BakeFile(FJobSystem& Jobs, const char* InputFileName, const char* OutputDirectory, const FBakeSettings& Settings, FBakeResult& OutResult)
+{
+	OutResult = {};
+	EA::StdC::Stopwatch StageTime(EA::StdC::Stopwatch::kUnitsMilliseconds, true);
+
+	FImage2D Image;
+	if (!LoadEquirectangularImage(Jobs, InputFileName, Image))
+	{
+		return false;
+	}
+	OutResult.bIsLoaded = true;
+	OutResult.ImageWidth = Image.Width;
+	OutResult.ImageHeight = Image.Height;
+	OutResult.StageTimes[BAKE_STAGE_Load] = StageTime.GetElapsedTimeFloat();
+
+	FCubeMapImage EnvMap;
+	CreateCubeMapImage(Settings.EnvMapResolution, GetNumMipLevels(Settings.EnvMapResolution), EnvMap);
+	StageTime.Restart();
+	ConvertEquirectangularToCubeMap(Jobs, Image, Settings.EnvMapFilter, EnvMap);
+	Image.Texels.set_capacity(0);
+	OutResult.StageTimes[BAKE_STAGE_Convert] = StageTime.GetElapsedTimeFloat();
+
+	FCubeMapImage PrefilteredEnvMap;
+	CreateCubeMapImage(Settings.PrefilteredEnvMapResolution, Settings.PrefilteredEnvMapNumMipLevels, PrefilteredEnvMap);
+	uint32_t NumSamples[IBL_MAX_PREFILTERED_MIP_LEVELS] = {};
+	for (uint32_t Mip = 0; Mip < Settings.PrefilteredEnvMapNumMipLevels; ++Mip)
+	{
+		NumSamples[Mip] = Settings.PrefilteredEnvMapNumSamples ? Settings.PrefilteredEnvMapNumSamples : GetPrefilterNumSamples(Mip);
+	}
+	StageTime.Restart();
+	PrefilterEnvMap(Jobs, EnvMap, Settings.PrefilterMode, NumSamples, PrefilteredEnvMap);
+	OutResult.StageTimes[BAKE_STAGE_Prefilter] = StageTime.GetElapsedTimeFloat();
+
+	// Converted to RGBA16F once, for the DDS files and the cache entry.
+	StageTime.Restart();
+	FDDSDesc Descs[IBL_TEXTURE_Count];
+	eastl::vector<uint16_t> Data[IBL_TEXTURE_Count];
+	GetCubeMapDDSData(EnvMap, Descs[IBL_TEXTURE_EnvMap], Data[IBL_TEXTURE_EnvMap]);
+	EnvMap.Texels.set_capacity(0);
+	GetCubeMapDDSData(PrefilteredEnvMap, Descs[IBL_TEXTURE_PrefilteredEnvMap], Data[IBL_TEXTURE_PrefilteredEnvMap]);
+	PrefilteredEnvMap.Texels.set_capacity(0);
+
+	// Created once there is something to write, a file that fails to load leaves no output behind.
+	MakeDirectory(OutputDirectory);
+	const eastl::string Directory(OutputDirectory);
+	bool bResult = SaveDDS((Directory + "/EnvMap.dds").c_str(), Descs[IBL_TEXTURE_EnvMap], Data[IBL_TEXTURE_EnvMap].data());
+	bResult = bResult && SaveDDS((Directory + "/PrefilteredEnvMap.dds").c_str(), Descs[IBL_TEXTURE_PrefilteredEnvMap], Data[IBL_TEXTURE_PrefilteredEnvMap].data());
+
+	if (bResult && Settings.CacheDirectory)
+	{
+		FIBLCacheKey Key = {};
+		bResult = ComputeFileHash(InputFileName, Key.SourceHash);
+		Key.EnvMapResolution = Settings.EnvMapResolution;
+		Key.PrefilteredEnvMapResolution = Settings.PrefilteredEnvMapResolution;
+		Key.PrefilteredEnvMapNumMipLevels = Settings.PrefilteredEnvMapNumMipLevels;
+		Key.PrefilterMode = Settings.PrefilterMode;
+		Key.EnvMapFilter = Settings.EnvMapFilter;
+		memcpy(Key.PrefilteredEnvMapNumSamples, NumSamples, sizeof(NumSamples));
+		Key.ShaderVersion = IBL_CACHE_SHADER_VERSION;
+
+		const void* DataPointers[IBL_TEXTURE_Count];
+		for (uint32_t Texture = 0; Texture < IBL_TEXTURE_Count; ++Texture)
+		{
+			DataPointers[Texture] = Data[Texture].data();
+		}
+		bResult = bResult && SaveIBLCacheEntry(Settings.CacheDirectory, Key, Descs, DataPointers);
+		if (bResult)
+		{
+			OutResult.CacheKeyHash = GetIBLCacheKeyHash(Key);
+		}
+	}
+	OutResult.StageTimes[BAKE_STAGE_Save] = StageTime.GetElapsedTimeFloat();
+	return bResult;
+}
+
+static int Bake(const char* InputFileName, const char* OutputDirectory, const FBakeSettings& Settings)
+{
+	FJobSystem Jobs = {};
+	CreateJobSystem(Settings.NumThreads, Jobs);
+	printf("Baking %s with %u threads.\n", InputFileName, GetNumThreads(Jobs));
+
+	EA::StdC::Stopwatch TotalTime(EA::StdC::Stopwatch::kUnitsMilliseconds, true);
+	FBakeResult Result;
+	const bool bResult = BakeFile(Jobs, InputFileName, OutputDirectory, Settings, Result);
+	const float TotalMilliseconds = TotalTime.GetElapsedTimeFloat();
+	DestroyJobSystem(Jobs);
+
+	if (!Result.bIsLoaded)
+	{
+		fprintf(stderr, "Failed to load %s\n", InputFileName);
+		return 1;
+	}
+	printf("%-28s %9.2f ms (%ux%u)\n", GBakeStageNames[BAKE_STAGE_Load], Result.StageTimes[BAKE_STAGE_Load], Result.ImageWidth, Result.ImageHeight);
+	printf("%-28s %9.2f ms (%s)\n", GBakeStageNames[BAKE_STAGE_Convert], Result.StageTimes[BAKE_STAGE_Convert], GEquirectangularFilterNames[Settings.EnvMapFilter]);
+	printf("%-28s %9.2f ms (%s)\n", GBakeStageNames[BAKE_STAGE_Prefilter], Result.StageTimes[BAKE_STAGE_Prefilter], GPrefilterModeNames[Settings.PrefilterMode]);
+	if (Result.CacheKeyHash)
+	{
+		printf("Stored cache entry %016llx in %s\n", (unsigned long long)Result.CacheKeyHash, Settings.CacheDirectory);
+	}
+	printf("%-28s %9.2f ms\n", GBakeStageNames[BAKE_STAGE_Save], Result.StageTimes[BAKE_STAGE_Save]);
+	printf("%-28s %9.2f ms\n", "Total", TotalMilliseconds);
+
+	if (!bResult)
+	{
+		fprintf(stderr, "Failed to write output files to %s\n", OutputDirectory);
+		return 1;
+	}
+	return 0;
+}
+
+static int CompareEquirectangularFilters(const char* InputFileName, int Argc, char** Argv)
+{
+	uint32_t NumThreads = 0;
+	uint32_t EnvMapResolution = 256;
+	const FOption Options[] =
+	{
+		{ "-threads", &NumThreads, nullptr },
+		{ "-env-res", &EnvMapResolution, nullptr },
+	};
+	if (!ParseOptions(Argc, Argv, Options, (uint32_t)eastl::size(Options)) || !IsValidEnvMapResolution(EnvMapResolution))
+	{
+		return -1;
+	}
+
+	FJobSystem Jobs = {};
+	CreateJobSystem(NumThreads, Jobs);
+
+	FImage2D Image;
+	if (!LoadEquirectangularImage(Jobs, InputFileName, Image))
+	{
+		fprintf(stderr, "Failed to load %s\n", InputFileName);
+		DestroyJobSystem(Jobs);
+		return 1;
+	}
+
+	// Every reference texel is the average of 4 x 4 area filtered texels (mip 2).
+	const uint32_t ReferenceMip = XMMin(2u, GetNumMipLevels(EQUIRECT_MAX_CUBE_RESOLUTION / EnvMapResolution) - 1);
+	FCubeMapImage Reference;
+	CreateCubeMapImage(EnvMapResolution << ReferenceMip, ReferenceMip + 1, Reference);
+	EA::StdC::Stopwatch Time(EA::StdC::Stopwatch::kUnitsMilliseconds, true);
+	ConvertEquirectangularToCubeMap(Jobs, Image, EQUIRECT_FILTER_Area, Reference);
+	printf("%ux%u image, reference %u (area): %.2f ms on %u threads\n", Image.Width, Image.Height, Reference.Resolution,
+		Time.GetElapsedTimeFloat(), GetNumThreads(Jobs));
+
+	// Relative errors are |result - reference| / |reference| of the RGB radiance of mip 0. The poles (+Y and -Y faces)
+	// are where the old shader mapping had its seams.
+	printf("%-10s %12s %12s %12s %12s\n", "filter", "time [ms]", "rms rel.", "max rel.", "poles rms");
+	for (uint32_t Filter = 0; Filter < eastl::size(GEquirectangularFilterNames); ++Filter)
+	{
+		FCubeMapImage EnvMap;
+		CreateCubeMapImage(EnvMapResolution, GetNumMipLevels(EnvMapResolution), EnvMap);
+		Time.Restart();
+		ConvertEquirectangularToCubeMap(Jobs, Image, Filter, EnvMap);
+		const float ConversionTime = Time.GetElapsedTimeFloat();
+
+		double SumRelativeError2 = 0.0;
+		double SumPoleRelativeError2 = 0.0;
+		float MaxRelativeError = 0.0f;
+		for (uint32_t Face = 0; Face < 6; ++Face)
+		{
+			const XMFLOAT4* Texels = GetCubeMapTexels(EnvMap, Face, 0);
+			const XMFLOAT4* ReferenceTexels = GetCubeMapTexels(Reference, Face, ReferenceMip);
+			for (uint32_t Idx = 0; Idx < EnvMapResolution * EnvMapResolution; ++Idx)
+			{
+				const XMVECTOR Value = XMLoadFloat4(&Texels[Idx]);
+				const XMVECTOR ReferenceValue = XMLoadFloat4(&ReferenceTexels[Idx]);
+				const float AbsoluteError = XMVectorGetX(XMVector3Length(XMVectorSubtract(Value, ReferenceValue)));
+				const float RelativeError = AbsoluteError / XMMax(XMVectorGetX(XMVector3Length(ReferenceValue)), 1.0e-6f);
+				SumRelativeError2 += RelativeError * RelativeError;
+				MaxRelativeError = XMMax(MaxRelativeError, RelativeError);
+				if (Face == CUBE_FACE_PositiveY || Face == CUBE_FACE_NegativeY)
+				{
+					SumPoleRelativeError2 += RelativeError * RelativeError;
+				}
+			}
+		}
+		const double NumFaceTexels = (double)EnvMapResolution * EnvMapResolution;
+		printf("%-10s %12.2f %11.3f%% %11.3f%% %11.3f%%\n", GEquirectangularFilterNames[Filter], ConversionTime,
+			100.0 * sqrt(SumRelativeError2 / (6.0 * NumFaceTexels)), 100.0 * MaxRelativeError,
+			100.0 * sqrt(SumPoleRelativeError2 / (2.0 * NumFaceTexels)));
+	}
+
+	DestroyJobSystem(Jobs);
+	return 0;
+}
+
+struct FPrefilterError
+{
+	float RMSRelativeError;
+	float MaxRelativeError;
+};
+
+// Relative errors are |result - reference| / |reference| of the RGB radiance, per texel of every mip.
+static void GetPrefilterError(const FCubeMapImage& PrefilteredEnvMap, const FCubeMapImage& Reference, FPrefilterError* OutErrors)
+{
+	for (uint32_t Mip = 0; Mip < PrefilteredEnvMap.NumMipLevels; ++Mip)
+	{
+		const uint32_t NumFaceTexels = GetCubeMapMipResolution(PrefilteredEnvMap, Mip) * GetCubeMapMipResolution(PrefilteredEnvMap, Mip);
+		double SumRelativeError2 = 0.0;
+		float MaxRelativeError = 0.0f;
+		for (uint32_t Face = 0; Face < 6; ++Face)
+		{
+			const XMFLOAT4* Texels = GetCubeMapTexels(PrefilteredEnvMap, Face, Mip);
+			const XMFLOAT4* ReferenceTexels = GetCubeMapTexels(Reference, Face, Mip);
+			for (uint32_t Idx = 0; Idx < NumFaceTexels; ++Idx)
+			{
+				const XMVECTOR ReferenceValue = XMLoadFloat4(&ReferenceTexels[Idx]);
+				const float AbsoluteError = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat4(&Texels[Idx]), ReferenceValue)));
+				const float RelativeError = AbsoluteError / XMMax(XMVectorGetX(XMVector3Length(ReferenceValue)), 1.0e-6f);
+				SumRelativeError2 += RelativeError * RelativeError;
+				MaxRelativeError = XMMax(MaxRelativeError, RelativeError);
+			}
+		}
+		OutErrors[Mip].RMSRelativeError = (float)sqrt(SumRelativeError2 / (6.0 * NumFaceTexels));
+		OutErrors[Mip].MaxRelativeError = MaxRelativeError;
+	}
+}
+
+static int BenchmarkPrefilter(const char* InputFileName, int Argc, char** Argv)
+{
+	uint32_t NumThreads = 0;
+	uint32_t EnvMapResolution = 512;
+	uint32_t PrefilteredEnvMapResolution = 64;
+	uint32_t PrefilteredEnvMapNumMipLevels = 6;
+	uint32_t NumReferenceSamples = 16384;
+	const FOption Options[] =
+	{
+		{ "-threads", &NumThreads, nullptr },
+		{ "-env-res", &EnvMapResolution, nullptr },
+		{ "-prefilter-res", &PrefilteredEnvMapResolution, nullptr },
+		{ "-prefilter-mips", &PrefilteredEnvMapNumMipLevels, nullptr },
+		{ "-ref-samples", &NumReferenceSamples, nullptr },
+	};
+	if (!ParseOptions(Argc, Argv, Options, (uint32_t)eastl::size(Options)) || !IsValidEnvMapResolution(EnvMapResolution) ||
+		!IsValidPrefilteredEnvMapSize(PrefilteredEnvMapResolution, PrefilteredEnvMapNumMipLevels) || NumReferenceSamples == 0)
+	{
+		return -1;
+	}
+
+	FJobSystem Jobs = {};
+	CreateJobSystem(NumThreads, Jobs);
+
+	FImage2D Image;
+	if (!LoadEquirectangularImage(Jobs, InputFileName, Image))
+	{
+		fprintf(stderr, "Failed to load %s\n", InputFileName);
+		DestroyJobSystem(Jobs);
+		return 1;
+	}
+
+	FCubeMapImage EnvMap;
+	CreateCubeMapImage(EnvMapResolution, GetNumMipLevels(EnvMapResolution), EnvMap);
+	ConvertEquirectangularToCubeMap(Jobs, Image, EQUIRECT_FILTER_Area, EnvMap);
+
+	// The golden reference reads mip 0 only, it converges to the exact GGX convolution of the env. map.
+	uint32_t NumSamples[IBL_MAX_PREFILTERED_MIP_LEVELS];
+	for (uint32_t Mip = 0; Mip < PrefilteredEnvMapNumMipLevels; ++Mip)
+	{
+		NumSamples[Mip] = Mip == 0 ? 1 : NumReferenceSamples;
+	}
+	FCubeMapImage Reference;
+	CreateCubeMapImage(PrefilteredEnvMapResolution, PrefilteredEnvMapNumMipLevels, Reference);
+	EA::StdC::Stopwatch Time(EA::StdC::Stopwatch::kUnitsMilliseconds, true);
+	PrefilterEnvMap(Jobs, EnvMap, PREFILTER_MODE_BruteForce, NumSamples, Reference);
+	printf("Env. map %u, reference %u x %u mips @ %u samples (brute force): %.2f ms on %u threads\n", EnvMapResolution,
+		PrefilteredEnvMapResolution, PrefilteredEnvMapNumMipLevels, NumReferenceSamples, Time.GetElapsedTimeFloat(), GetNumThreads(Jobs));
+
+	struct FConfig
+	{
+		uint32_t Mode;
+		uint32_t NumSamples; // 0 is the default schedule (GetPrefilterNumSamples()).
+	};
+	const FConfig Configs[] =
+	{
+		{ PREFILTER_MODE_BruteForce, 4096 }, { PREFILTER_MODE_BruteForce, 1024 }, { PREFILTER_MODE_BruteForce, 256 },
+		{ PREFILTER_MODE_Filtered, 1024 }, { PREFILTER_MODE_Filtered, 256 }, { PREFILTER_MODE_Filtered, 128 },
+		{ PREFILTER_MODE_Filtered, 64 }, { PREFILTER_MODE_Filtered, 32 }, { PREFILTER_MODE_Filtered, 16 },
+		{ PREFILTER_MODE_Filtered, 0 },
+	};
+
+	// One row per configuration, rms (max) relative error of every mip.
+	printf("%-12s %9s %11s", "mode", "samples", "time [ms]");
+	for (uint32_t Mip = 0; Mip < PrefilteredEnvMapNumMipLevels; ++Mip)
+	{
+		printf("   mip %u (r %.2f)  ", Mip, PrefilteredEnvMapNumMipLevels > 1 ? (float)Mip / (PrefilteredEnvMapNumMipLevels - 1) : 0.0f);
+	}
+	printf("\n");
+	for (const FConfig& Config : Configs)
+	{
+		eastl::string SamplesText;
+		for (uint32_t Mip = 0; Mip < PrefilteredEnvMapNumMipLevels; ++Mip)
+		{
+			NumSamples[Mip] = Config.NumSamples ? Config.NumSamples : GetPrefilterNumSamples(Mip);
+		}
+		if (Config.NumSamples)
+		{
+			SamplesText.sprintf("%u", Config.NumSamples);
+		}
+		else
+		{
+			SamplesText = "default";
+		}
+
+		FCubeMapImage PrefilteredEnvMap;
+		CreateCubeMapImage(PrefilteredEnvMapResolution, PrefilteredEnvMapNumMipLevels, PrefilteredEnvMap);
+		Time.Restart();
+		PrefilterEnvMap(Jobs, EnvMap, Config.Mode, NumSamples, PrefilteredEnvMap);
+		const float PrefilterTime = Time.GetElapsedTimeFloat();
+
+		FPrefilterError Errors[IBL_MAX_PREFILTERED_MIP_LEVELS];
+		GetPrefilterError(PrefilteredEnvMap, Reference, Errors);
+		printf("%-12s %9s %11.2f", GPrefilterModeNames[Config.Mode], SamplesText.c_str(), PrefilterTime);
+		for (uint32_t Mip = 0; Mip < PrefilteredEnvMapNumMipLevels; ++Mip)
+		{
+			printf(" %6.2f%% (%6.1f%%)", 100.0f * Errors[Mip].RMSRelativeError, 100.0f * Errors[Mip].MaxRelativeError);
+		}
+		printf("\n");
+	}
+	printf("Default schedule:");
+	for (uint32_t Mip = 0; Mip < PrefilteredEnvMapNumMipLevels; ++Mip)
+	{
+		printf(" %u", GetPrefilterNumSamples(Mip));
+	}
+	printf("\n");
+
+	DestroyJobSystem(Jobs);
+	return 0;
+}
+
+static int ListCache(const char* CacheDirectory)
+{
+	eastl::vector<FIBLCacheEntryInfo> Entries;
+	ListIBLCacheEntries(CacheDirectory, Entries);
+
+	uint64_t TotalSize = 0;
+	for (const FIBLCacheEntryInfo& Entry : Entries)
+	{
+		const FIBLCacheKey& Key = Entry.Key;
+		printf("%016llx%s\n", (unsigned long long)Entry.KeyHash, Entry.bIsValid ? "" : " (incomplete or corrupted)");
+		if (Entry.bIsValid)
+		{
+			printf("  source %016llx, shader version %u\n", (unsigned long long)Key.SourceHash, Key.ShaderVersion);
+			printf("  env. %u (%s), prefiltered %u x %u mips (%s) @", Key.EnvMapResolution,
+				Key.EnvMapFilter < eastl::size(GEquirectangularFilterNames) ? GEquirectangularFilterNames[Key.EnvMapFilter] : "?", Key.PrefilteredEnvMapResolution,
+				Key.PrefilteredEnvMapNumMipLevels, Key.PrefilterMode < eastl::size(GPrefilterModeNames) ? GPrefilterModeNames[Key.PrefilterMode] : "?");
+			for (uint32_t Mip = 0; Mip < XMMin(Key.PrefilteredEnvMapNumMipLevels, (uint32_t)IBL_MAX_PREFILTERED_MIP_LEVELS); ++Mip)
+			{
+				printf(" %u", Key.PrefilteredEnvMapNumSamples[Mip]);
+			}
+			printf(" samples\n");
+		}
+
+		uint64_t EntrySize = 0;
+		for (uint32_t Texture = 0; Texture < IBL_TEXTURE_Count; ++Texture)
+		{
+			const FDDSDesc& Desc = Entry.Descs[Texture];
+			printf("  %-20s %4ux%-4u %2u mips %s %10.1f KB\n", GetIBLTextureName(Texture), Desc.Width, Desc.Height, Desc.NumMipLevels,
+				Desc.bIsCubeMap ? "cube" : "2d  ", Entry.FileSizes[Texture] / 1024.0);
+			EntrySize += Entry.FileSizes[Texture];
+		}
+		printf("  %-20s %33.1f KB\n", "total", EntrySize / 1024.0);
+		TotalSize += EntrySize;
+	}
+	printf("%u entries, %.2f MB\n", (uint32_t)Entries.size(), TotalSize / (1024.0 * 1024.0));
+	return 0;
+}
+
+static int VerifyCache(const char* CacheDirectory, int Argc, char** Argv)
+{
+	uint32_t NumThreads = 0;
+	uint32_t Tolerance = 20;
+	const FOption Options[] =
+	{
+		{ "-threads", &NumThreads, nullptr },
+		{ "-tolerance", &Tolerance, nullptr },
+	};
+	if (!ParseOptions(Argc, Argv, Options, (uint32_t)eastl::size(Options)))
+	{
+		return -1;
+	}
+	const float MaxRelativeError = Tolerance / 1000.0f;
+
+	FJobSystem Jobs = {};
+	CreateJobSystem(NumThreads, Jobs);
+
+	eastl::vector<FIBLCacheEntryInfo> Entries;
+	ListIBLCacheEntries(CacheDirectory, Entries);
+
+	// The cached env. map is exactly what the GPU prefilter read, so the CPU twin sees the same input. Differences come
+	// from RGBA16F storage and the sampler precision of the GPU.
+	uint32_t NumFailed = 0;
+	for (const FIBLCacheEntryInfo& Info : Entries)
+	{
+		printf("%016llx", (unsigned long long)Info.KeyHash);
+		FIBLCacheEntry Entry;
+		if (!Info.bIsValid || Info.Key.PrefilteredEnvMapNumMipLevels > IBL_MAX_PREFILTERED_MIP_LEVELS || Info.Key.PrefilterMode > PREFILTER_MODE_Filtered ||
+			!OpenIBLCacheEntry(CacheDirectory, Info.Key, Entry))
+		{
+			printf(" skipped (incomplete, corrupted or unsupported)\n");
+			continue;
+		}
+		FCubeMapImage EnvMap, PrefilteredEnvMap;
+		const bool bIsValid = CreateCubeMapImageFromDDS(Entry.Descs[IBL_TEXTURE_EnvMap], Entry.Pixels[IBL_TEXTURE_EnvMap], EnvMap) &&
+			CreateCubeMapImageFromDDS(Entry.Descs[IBL_TEXTURE_PrefilteredEnvMap], Entry.Pixels[IBL_TEXTURE_PrefilteredEnvMap], PrefilteredEnvMap) &&
+			PrefilteredEnvMap.NumMipLevels == Info.Key.PrefilteredEnvMapNumMipLevels;
+		CloseIBLCacheEntry(Entry);
+		if (!bIsValid)
+		{
+			printf(" skipped (unsupported texture format)\n");
+			continue;
+		}
+
+		FCubeMapImage Twin;
+		CreateCubeMapImage(PrefilteredEnvMap.Resolution, PrefilteredEnvMap.NumMipLevels, Twin);
+		EA::StdC::Stopwatch Time(EA::StdC::Stopwatch::kUnitsMilliseconds, true);
+		PrefilterEnvMap(Jobs, EnvMap, Info.Key.PrefilterMode, Info.Key.PrefilteredEnvMapNumSamples, Twin);
+		printf(" (%s, CPU twin %.2f ms)\n", GPrefilterModeNames[Info.Key.PrefilterMode], Time.GetElapsedTimeFloat());
+
+		uint32_t NumMismatches = 0;
+		for (uint32_t Mip = 0; Mip < Twin.NumMipLevels; ++Mip)
+		{
+			const uint32_t NumFaceTexels = GetCubeMapMipResolution(Twin, Mip) * GetCubeMapMipResolution(Twin, Mip);
+			uint32_t NumMipMismatches = 0;
+			double SumRelativeError2 = 0.0;
+			float MaxMipRelativeError = 0.0f;
+			for (uint32_t Face = 0; Face < 6; ++Face)
+			{
+				const XMFLOAT4* Texels = GetCubeMapTexels(PrefilteredEnvMap, Face, Mip);
+				const XMFLOAT4* TwinTexels = GetCubeMapTexels(Twin, Face, Mip);
+				for (uint32_t Idx = 0; Idx < NumFaceTexels; ++Idx)
+				{
+					const XMVECTOR TwinValue = XMLoadFloat4(&TwinTexels[Idx]);
+					const float AbsoluteError = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat4(&Texels[Idx]), TwinValue)));
+					const float RelativeError = AbsoluteError / XMMax(XMVectorGetX(XMVector3Length(TwinValue)), 1.0e-3f);
+					SumRelativeError2 += RelativeError * RelativeError;
+					MaxMipRelativeError = XMMax(MaxMipRelativeError, RelativeError);
+					NumMipMismatches += RelativeError > MaxRelativeError ? 1 : 0;
+				}
+			}
+			printf("  mip %u %4ux%-4u rms rel. %8.4f%%, max rel. %8.4f%%, %u texels above %.1f%%\n", Mip, GetCubeMapMipResolution(Twin, Mip),
+				GetCubeMapMipResolution(Twin, Mip), 100.0 * sqrt(SumRelativeError2 / (6.0 * NumFaceTexels)), 100.0f * MaxMipRelativeError,
+				NumMipMismatches, 100.0f * MaxRelativeError);
+			NumMismatches += NumMipMismatches;
+		}
+		NumFailed += NumMismatches > 0 ? 1 : 0;
+	}
+	printf("%u entries, %u failed\n", (uint32_t)Entries.size(), NumFailed);
+
+	DestroyJobSystem(Jobs);
+	return NumFailed > 0 ? 1 : 0;
+}
+
+static void ProjectIrradianceSH(const FCubeMapImage& EnvMap, uint32_t Mip, FSH9Color& OutIrradianceSH)
+{
+	const void* Faces[6];
+	for (uint32_t Face = 0; Face < 6; ++Face)
+	{
+		Faces[Face] = GetCubeMapTexels(EnvMap, Face, Mip);
+	}
+	FSH9Color RadianceSH;
+	ProjectCubeMapToSH(Faces, GetCubeMapMipResolution(EnvMap, Mip), SH_TEXEL_FORMAT_RGBA32F, RadianceSH);
+	ConvolveSHWithCosineLobe(RadianceSH, OutIrradianceSH);
+}
+
+static int CompareSHIrradiance(const char* InputFileName, int Argc, char** Argv)
+{
+	uint32_t NumThreads = 0;
+	uint32_t EnvMapResolution = 512;
+	uint32_t IrradianceMapResolution = 64;
+	const FOption Options[] =
+	{
+		{ "-threads", &NumThreads, nullptr },
+		{ "-env-res", &EnvMapResolution, nullptr },
+		{ "-irr-res", &IrradianceMapResolution, nullptr },
+	};
+	if (!ParseOptions(Argc, Argv, Options, (uint32_t)eastl::size(Options)) || !IsValidEnvMapResolution(EnvMapResolution) || IrradianceMapResolution == 0)
+	{
+		return -1;
+	}
+
+	FJobSystem Jobs = {};
+	CreateJobSystem(NumThreads, Jobs);
+
+	FImage2D Image;
+	if (!LoadEquirectangularImage(Jobs, InputFileName, Image))
+	{
+		fprintf(stderr, "Failed to load %s\n", InputFileName);
+		DestroyJobSystem(Jobs);
+		return 1;
+	}
+
+	FCubeMapImage EnvMap;
+	CreateCubeMapImage(EnvMapResolution, GetNumMipLevels(EnvMapResolution), EnvMap);
+	ConvertEquirectangularToCubeMap(Jobs, Image, EQUIRECT_FILTER_Area, EnvMap);
+
+	FCubeMapImage IrradianceMap;
+	CreateCubeMapImage(IrradianceMapResolution, 1, IrradianceMap);
+	EA::StdC::Stopwatch Time(EA::StdC::Stopwatch::kUnitsMilliseconds, true);
+	GenerateIrradianceMap(Jobs, EnvMap, IrradianceMap);
+	printf("Brute force %ux%u irradiance map: %.2f ms on %u threads\n", IrradianceMapResolution, IrradianceMapResolution, Time.GetElapsedTimeFloat(), GetNumThreads(Jobs));
+	DestroyJobSystem(Jobs);
+
+	// Relative errors are |SH - reference| / |reference| of the RGB irradiance, per irradiance map texel.
+	printf("%8s %12s %12s %12s %12s\n", "SH from", "time [us]", "rms rel.", "max rel.", "mean abs.");
+	for (uint32_t Mip = 0; Mip < EnvMap.NumMipLevels; ++Mip)
+	{
+		const uint32_t Resolution = GetCubeMapMipResolution(EnvMap, Mip);
+
+		// Single threaded, like ComputeIrradianceSH() in the demo. Repeated to get a stable time for small mips.
+		FSH9Color IrradianceSH;
+		uint32_t NumRuns = 0;
+		EA::StdC::Stopwatch ProjectionTime(EA::StdC::Stopwatch::kUnitsMicroseconds, true);
+		do
+		{
+			ProjectIrradianceSH(EnvMap, Mip, IrradianceSH);
+			++NumRuns;
+		} while (ProjectionTime.GetElapsedTimeFloat() < 50000.0f);
+		const float MicrosecondsPerRun = ProjectionTime.GetElapsedTimeFloat() / NumRuns;
+
+		double SumRelativeError2 = 0.0;
+		double SumAbsoluteError = 0.0;
+		float MaxRelativeError = 0.0f;
+		for (uint32_t Face = 0; Face < 6; ++Face)
+		{
+			const XMFLOAT4* Texels = GetCubeMapTexels(IrradianceMap, Face, 0);
+			for (uint32_t Y = 0; Y < IrradianceMapResolution; ++Y)
+			{
+				for (uint32_t X = 0; X < IrradianceMapResolution; ++X)
+				{
+					const XMVECTOR N = GetCubeMapDirection(Face, (X + 0.5f) / IrradianceMapResolution, (Y + 0.5f) / IrradianceMapResolution);
+					// Clamped like EvaluateIrradianceSH() in SimpleForward.hlsl.
+					const XMVECTOR Irradiance = XMVectorMax(EvaluateSH(IrradianceSH, N), XMVectorZero());
+					const XMVECTOR Reference = XMLoadFloat4(&Texels[Y * IrradianceMapResolution + X]);
+
+					const float AbsoluteError = XMVectorGetX(XMVector3Length(XMVectorSubtract(Irradiance, Reference)));
+					const float RelativeError = AbsoluteError / XMMax(XMVectorGetX(XMVector3Length(Reference)), 1.0e-6f);
+					SumRelativeError2 += RelativeError * RelativeError;
+					SumAbsoluteError += AbsoluteError;
+					MaxRelativeError = XMMax(MaxRelativeError, RelativeError);
+				}
+			}
+		}
+		const double NumTexels = 6.0 * IrradianceMapResolution * IrradianceMapResolution;
+		printf("%8u %12.1f %11.3f%% %11.3f%% %12.5f\n", Resolution, MicrosecondsPerRun, 100.0 * sqrt(SumRelativeError2 / NumTexels),
+			100.0 * MaxRelativeError, SumAbsoluteError / NumTexels);
+	}
+	return 0;
+}
+
+static bool SaveBlob(const char* FileName, const void* Data, size_t Size)
+{
+	FILE* File = fopen(FileName, "wb");
+	if (!File)
+	{
+		return false;
+	}
+	const bool bResult = fwrite(Data, 1, Size, File) == Size;
+	return fclose(File) == 0 && bResult;
+}
+
+// Texels (Format is a DDS_FORMAT_) or, with Format == 0, the analytic coefficients as a constexpr header.
+static bool SaveBRDFIntegrationMapHeader(const char* FileName, uint32_t Format, uint32_t Resolution, uint32_t NumSamples,
+	const eastl::vector<uint8_t>& Data, const FBRDFApprox& Approx)
+{
+	FILE* File = fopen(FileName, "w");
+	if (!File)
+	{
+		return false;
+	}
+	fprintf(File, "#pragma once\n\n");
+	fprintf(File, "// Generated by \"IBLBaker brdf-lut\", do not edit.\n");
+	if (Format == 0)
+	{
+		fprintf(File, "// EnvBRDFApprox() coefficients fitted to the %ux%u split-sum BRDF integration map (%u GGX samples per texel).\n\n",
+			Resolution, Resolution, NumSamples);
+	}
+	else
+	{
+		fprintf(File, "// Split-sum BRDF integration map for SimpleForward.hlsl: row-major, x is NoV and y is Roughness (both at texel\n");
+		fprintf(File, "// centers), %u GGX samples per texel.\n\n", NumSamples);
+	}
+	fprintf(File, "#include <stdint.h>\n\n");
+
+	if (Format == 0)
+	{
+		// R = C0 * Roughness + C1, see FBRDFApprox in IBLBaker.h.
+		fprintf(File, "constexpr float GBRDFApproxC0[4] = { %.9gf, %.9gf, %.9gf, %.9gf };\n", Approx.C0.x, Approx.C0.y, Approx.C0.z, Approx.C0.w);
+		fprintf(File, "constexpr float GBRDFApproxC1[4] = { %.9gf, %.9gf, %.9gf, %.9gf };\n", Approx.C1.x, Approx.C1.y, Approx.C1.z, Approx.C1.w);
+	}
+	else
+	{
+		const bool bHalf = Format == DDS_FORMAT_R16G16_FLOAT;
+		fprintf(File, "#define BRDF_INTEGRATION_MAP_FORMAT %u // %s\n", Format, bHalf ? "DDS_FORMAT_R16G16_FLOAT" : "DDS_FORMAT_R8G8_UNORM");
+		fprintf(File, "#define BRDF_INTEGRATION_MAP_RESOLUTION %u\n\n", Resolution);
+		fprintf(File, "constexpr %s GBRDFIntegrationMapData[BRDF_INTEGRATION_MAP_RESOLUTION * BRDF_INTEGRATION_MAP_RESOLUTION * 2] =\n{",
+			bHalf ? "uint16_t" : "uint8_t");
+
+		const uint32_t NumValues = Resolution * Resolution * 2;
+		const uint32_t ValuesPerLine = bHalf ? 16 : 24;
+		for (uint32_t Idx = 0; Idx < NumValues; ++Idx)
+		{
+			fprintf(File, Idx % ValuesPerLine == 0 ? "\n\t" : " ");
+			if (bHalf)
+			{
+				fprintf(File, "0x%04x,", ((const uint16_t*)Data.data())[Idx]);
+			}
+			else
+			{
+				fprintf(File, "0x%02x,", Data[Idx]);
+			}
+		}
+		fprintf(File, "\n};\n");
+	}
+	return fclose(File) == 0;
+}
+
+static bool HasExtension(const char* FileName, const char* Extension)
+{
+	const size_t Length = EA::StdC::Strlen(FileName);
+	const size_t ExtensionLength = EA::StdC::Strlen(Extension);
+	return Length >= ExtensionLength && EA::StdC::Stricmp(FileName + Length - ExtensionLength, Extension) == 0;
+}
+
+static int GenerateBRDFLUT(const char* OutputFileName, int Argc, char** Argv)
+{
+	uint32_t NumThreads = 0;
+	uint32_t Resolution = 128;
+	uint32_t NumSamples = 4096;
+	const char* FormatName = "rg16f";
+	const FOption Options[] =
+	{
+		{ "-threads", &NumThreads, nullptr },
+		{ "-res", &Resolution, nullptr },
+		{ "-samples", &NumSamples, nullptr },
+		{ "-format", nullptr, &FormatName },
+	};
+	if (!ParseOptions(Argc, Argv, Options, (uint32_t)eastl::size(Options)))
+	{
+		return -1;
+	}
+
+	// 0 is the analytic approximation.
+	uint32_t Format;
+	if (EA::StdC::Stricmp(FormatName, "rg16f") == 0)
+	{
+		Format = DDS_FORMAT_R16G16_FLOAT;
+	}
+	else if (EA::StdC::Stricmp(FormatName, "rg8") == 0)
+	{
+		Format = DDS_FORMAT_R8G8_UNORM;
+	}
+	else if (EA::StdC::Stricmp(FormatName, "analytic") == 0)
+	{
+		Format = 0;
+	}
+	else
+	{
+		fprintf(stderr, "Invalid format: %s\n", FormatName);
+		return -1;
+	}
+	if (Resolution < 32 || Resolution > 512 || NumSamples == 0 || NumSamples % 4 != 0)
+	{
+		fprintf(stderr, "Invalid resolution (32 to 512) or sample count (a multiple of 4).\n");
+		return -1;
+	}
+	const bool bHeader = HasExtension(OutputFileName, ".h");
+	if (Format == 0 && HasExtension(OutputFileName, ".dds"))
+	{
+		fprintf(stderr, "The analytic approximation can not be stored as a DDS texture.\n");
+		return -1;
+	}
+
+	FJobSystem Jobs = {};
+	CreateJobSystem(NumThreads, Jobs);
+	EA::StdC::Stopwatch Time(EA::StdC::Stopwatch::kUnitsMilliseconds, true);
+	eastl::vector<XMFLOAT2> Map;
+	GenerateBRDFIntegrationMap(Jobs, Resolution, NumSamples, Map);
+	printf("%ux%u BRDF integration map with %u samples: %.2f ms on %u threads\n", Resolution, Resolution, NumSamples,
+		Time.GetElapsedTimeFloat(), GetNumThreads(Jobs));
+	DestroyJobSystem(Jobs);
+
+	FBRDFApprox Approx;
+	GetDefaultBRDFApprox(Approx);
+	FDDSDesc Desc = {};
+	eastl::vector<uint8_t> Data;
+	if (Format == 0)
+	{
+		FitBRDFApprox(Resolution, Map, Approx);
+		Data.resize(sizeof(Approx));
+		memcpy(Data.data(), &Approx, sizeof(Approx));
+	}
+	else
+	{
+		GetBRDFIntegrationMapDDSData(Format, Resolution, Map, Desc, Data);
+	}
+
+	bool bResult;
+	if (bHeader)
+	{
+		bResult = SaveBRDFIntegrationMapHeader(OutputFileName, Format, Resolution, NumSamples, Data, Approx);
+	}
+	else if (HasExtension(OutputFileName, ".dds"))
+	{
+		bResult = SaveDDS(OutputFileName, Desc, Data.data());
+	}
+	else
+	{
+		bResult = SaveBlob(OutputFileName, Data.data(), Data.size());
+	}
+	if (!bResult)
+	{
+		fprintf(stderr, "Failed to write %s\n", OutputFileName);
+		return 1;
+	}
+	printf("Wrote %s (%u bytes of data)\n", OutputFileName, (uint32_t)Data.size());
+	return 0;
+}
+
+struct FBRDFLUTError
+{
+	double Rms;
+	float Max;
+};
+
+// Errors of Scale and Bias (both channels count) at the texel centers of the reference map.
+template<typename F>
+static FBRDFLUTError GetBRDFLUTError(uint32_t ReferenceResolution, const eastl::vector<XMFLOAT2>& Reference, F Evaluate)
+{
+	FBRDFLUTError Error = {};
+	double SumError2 = 0.0;
+	for (uint32_t Y = 0; Y < ReferenceResolution; ++Y)
+	{
+		for (uint32_t X = 0; X < ReferenceResolution; ++X)
+		{
+			const XMFLOAT2 Value = Evaluate((X + 0.5f) / ReferenceResolution, (Y + 0.5f) / ReferenceResolution);
+			const XMFLOAT2& ReferenceValue = Reference[Y * ReferenceResolution + X];
+			const float ErrorX = fabsf(Value.x - ReferenceValue.x);
+			const float ErrorY = fabsf(Value.y - ReferenceValue.y);
+			SumError2 += ErrorX * ErrorX + ErrorY * ErrorY;
+			Error.Max = XMMax(Error.Max, XMMax(ErrorX, ErrorY));
+		}
+	}
+	Error.Rms = sqrt(SumError2 / (2.0 * ReferenceResolution * ReferenceResolution));
+	return Error;
+}
+
+static int BenchmarkBRDFLUT(int Argc, char** Argv)
+{
+	uint32_t NumThreads = 0;
+	uint32_t NumSamples = 4096;
+	const FOption Options[] =
+	{
+		{ "-threads", &NumThreads, nullptr },
+		{ "-samples", &NumSamples, nullptr },
+	};
+	if (!ParseOptions(Argc, Argv, Options, (uint32_t)eastl::size(Options)) || NumSamples == 0 || NumSamples % 4 != 0)
+	{
+		return -1;
+	}
+
+	FJobSystem Jobs = {};
+	CreateJobSystem(NumThreads, Jobs);
+
+	const uint32_t ReferenceResolution = 512;
+	EA::StdC::Stopwatch Time(EA::StdC::Stopwatch::kUnitsMilliseconds, true);
+	eastl::vector<XMFLOAT2> Reference;
+	GenerateBRDFIntegrationMap(Jobs, ReferenceResolution, 4096, Reference);
+	printf("Reference: %ux%u, 4096 samples, %.2f ms on %u threads\n", ReferenceResolution, ReferenceResolution,
+		Time.GetElapsedTimeFloat(), GetNumThreads(Jobs));
+
+	printf("%-10s %6s %8s %10s %12s %12s %12s\n", "format", "res.", "samples", "bytes", "time [ms]", "rms error", "max error");
+	for (uint32_t Resolution = 32; Resolution <= 512; Resolution *= 2)
+	{
+		Time.Restart();
+		eastl::vector<XMFLOAT2> Map;
+		GenerateBRDFIntegrationMap(Jobs, Resolution, NumSamples, Map);
+		const float GenerationTime = Time.GetElapsedTimeFloat();
+
+		const uint32_t Formats[] = { DDS_FORMAT_R16G16_FLOAT, DDS_FORMAT_R8G8_UNORM };
+		for (uint32_t Format : Formats)
+		{
+			eastl::vector<XMFLOAT2> QuantizedMap(Map);
+			QuantizeBRDFIntegrationMap(Format, QuantizedMap);
+			const FBRDFLUTError Error = GetBRDFLUTError(ReferenceResolution, Reference, [&](float NoV, float Roughness)
+			{
+				return SampleBRDFIntegrationMap(Resolution, QuantizedMap, NoV, Roughness);
+			});
+			printf("%-10s %6u %8u %10u %12.2f %12.6f %12.6f\n", Format == DDS_FORMAT_R16G16_FLOAT ? "rg16f" : "rg8", Resolution,
+				NumSamples, Resolution * Resolution * (Format == DDS_FORMAT_R16G16_FLOAT ? 4 : 2), GenerationTime, Error.Rms, Error.Max);
+		}
+	}
+
+	FBRDFApprox Approx;
+	GetDefaultBRDFApprox(Approx);
+	for (uint32_t Pass = 0; Pass < 2; ++Pass)
+	{
+		Time.Restart();
+		if (Pass == 1)
+		{
+			FitBRDFApprox(ReferenceResolution, Reference, Approx);
+		}
+		const float FitTime = Time.GetElapsedTimeFloat();
+		const FBRDFLUTError Error = GetBRDFLUTError(ReferenceResolution, Reference, [&](float NoV, float Roughness)
+		{
+			return EvaluateBRDFApprox(Approx, NoV, Roughness);
+		});
+		printf("%-10s %6s %8s %10u %12.2f %12.6f %12.6f\n", Pass == 0 ? "karis" : "fitted", "-", "-", (uint32_t)sizeof(Approx),
+			FitTime, Error.Rms, Error.Max);
+	}
+
+	DestroyJobSystem(Jobs);
+	return 0;
+}
+
+// Resident set size and its peak in bytes. Only Linux can reset the peak, elsewhere it never decreases.
+static void GetMemoryUsage(uint64_t& OutRSS, uint64_t& OutPeakRSS)
+{
+	OutRSS = 0;
+	OutPeakRSS = 0;
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS Counters = {};
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &Counters, sizeof(Counters)))
+	{
+		OutRSS = Counters.WorkingSetSize;
+		OutPeakRSS = Counters.PeakWorkingSetSize;
+	}
+#else
+	FILE* File = fopen("/proc/self/status", "r");
+	if (File)
+	{
+		char Line[256];
+		while (fgets(Line, sizeof(Line), File))
+		{
+			if (EA::StdC::Strncmp(Line, "VmRSS:", 6) == 0)
+			{
+				OutRSS = EA::StdC::StrtoU64(Line + 6, nullptr, 10) * 1024;
+			}
+			else if (EA::StdC::Strncmp(Line, "VmHWM:", 6) == 0)
+			{
+				OutPeakRSS = EA::StdC::StrtoU64(Line + 6, nullptr, 10) * 1024;
+			}
+		}
+		fclose(File);
+	}
+#endif
+}
+
+static void ResetPeakRSS()
+{
+#ifndef _WIN32
+	FILE* File = fopen("/proc/self/clear_refs", "w");
+	if (File)
+	{
+		fputs("5", File);
+		fclose(File);
+	}
+#endif
+}
+
+static void EncodeRLEChannel(const uint8_t* Values, uint32_t Width, eastl::vector<uint8_t>& OutData)
+{
+	uint32_t X = 0;
+	while (X < Width)
+	{
+		// Find the next run worth encoding (at least 4 equal values), everything before it goes into literal spans.
+		uint32_t RunStart = X;
+		uint32_t RunLength = 0;
+		while (RunStart < Width)
+		{
+			RunLength = 1;
+			while (RunStart + RunLength < Width && RunLength < 127 && Values[RunStart + RunLength] == Values[RunStart])
+			{
+				++RunLength;
+			}
+			if (RunLength >= 4)
+			{
+				break;
+			}
+			RunStart += RunLength;
+			RunLength = 0;
+		}
+		while (X < RunStart)
+		{
+			const uint32_t Count = XMMin(RunStart - X, 128u);
+			OutData.push_back((uint8_t)Count);
+			OutData.insert(OutData.end(), Values + X, Values + X + Count);
+			X += Count;
+		}
+		if (RunLength > 0)
+		{
+			OutData.push_back((uint8_t)(128 + RunLength));
+			OutData.push_back(Values[RunStart]);
+			X += RunLength;
+		}
+	}
+}
+
+// Nearest neighbor upscale of Image by Scale in both directions, written as a run-length encoded Radiance file.
+// Only used to benchmark 8K and 16K panoramas, the runs make it compress better than a real one.
+static void CreateUpscaledHDRFile(const FImage2D& Image, uint32_t Scale, eastl::vector<uint8_t>& OutFile)
+{
+	const uint32_t Width = Image.Width * Scale;
+	const uint32_t Height = Image.Height * Scale;
+	char Header[128];
+	const int HeaderLength = EA::StdC::Snprintf(Header, sizeof(Header), "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y %u +X %u\n", Height, Width);
+	OutFile.assign(Header, Header + HeaderLength);
+
+	eastl::vector<uint8_t> Planes(Width * 4);
+	for (uint32_t Y = 0; Y < Height; ++Y)
+	{
+		const XMFLOAT4* Row = &Image.Texels[(Y / Scale) * Image.Width];
+		for (uint32_t X = 0; X < Width; ++X)
+		{
+			const XMFLOAT4& Color = Row[X / Scale];
+			const float MaxValue = XMMax(Color.x, XMMax(Color.y, Color.z));
+			uint8_t RGBE[4] = {};
+			if (MaxValue > 1.0e-32f)
+			{
+				int Exponent;
+				const float Scale256 = frexpf(MaxValue, &Exponent) * 256.0f / MaxValue;
+				RGBE[0] = (uint8_t)(Color.x * Scale256);
+				RGBE[1] = (uint8_t)(Color.y * Scale256);
+				RGBE[2] = (uint8_t)(Color.z * Scale256);
+				RGBE[3] = (uint8_t)(Exponent + 128);
+			}
+			for (uint32_t Channel = 0; Channel < 4; ++Channel)
+			{
+				Planes[Channel * Width + X] = RGBE[Channel];
+			}
+		}
+
+		const uint8_t ScanlineHeader[4] = { 2, 2, (uint8_t)(Width >> 8), (uint8_t)(Width & 0xFF) };
+		OutFile.insert(OutFile.end(), ScanlineHeader, ScanlineHeader + 4);
+		for (uint32_t Channel = 0; Channel < 4; ++Channel)
+		{
+			EncodeRLEChannel(&Planes[Channel * Width], Width, OutFile);
+		}
+	}
+}
+
+static XMVECTOR XM_CALLCONV LoadDecodedTexel(uint32_t Format, const uint8_t* Texels, size_t Index)
+{
+	switch (Format)
+	{
+	case DDS_FORMAT_R16G16B16A16_FLOAT: return PackedVector::XMLoadHalf4((const PackedVector::XMHALF4*)Texels + Index);
+	case DDS_FORMAT_R9G9B9E5_SHAREDEXP: return PackedVector::XMLoadFloat3SE((const PackedVector::XMFLOAT3SE*)Texels + Index);
+	}
+	return XMLoadFloat4((const XMFLOAT4*)Texels + Index);
+}
+
+static int BenchmarkHDRDecoder(const char* InputFileName, int Argc, char** Argv)
+{
+	uint32_t NumThreads = 0;
+	uint32_t Scale = 1;
+	uint32_t NumRuns = 3;
+	const FOption Options[] =
+	{
+		{ "-threads", &NumThreads, nullptr },
+		{ "-scale", &Scale, nullptr },
+		{ "-runs", &NumRuns, nullptr },
+	};
+	if (!ParseOptions(Argc, Argv, Options, (uint32_t)eastl::size(Options)) || Scale == 0 || NumRuns == 0)
+	{
+		return -1;
+	}
+
+	FMappedFile File;
+	FHDRDesc Desc;
+	if (!OpenMappedFile(InputFileName, File) || !ParseHDRHeader(File.Data, File.Size, Desc))
+	{
+		fprintf(stderr, "Failed to load %s\n", InputFileName);
+		CloseMappedFile(File);
+		return 1;
+	}
+
+	FJobSystem Jobs = {};
+	CreateJobSystem(NumThreads, Jobs);
+
+	const uint8_t* FileData = File.Data;
+	uint64_t FileSize = File.Size;
+	eastl::vector<uint8_t> UpscaledFile;
+	if (Scale > 1)
+	{
+		FImage2D Image;
+		Image.Width = Desc.Width;
+		Image.Height = Desc.Height;
+		Image.Texels.resize((size_t)Desc.Width * Desc.Height);
+		DecodeHDR(Jobs, File.Data, File.Size, Desc, DDS_FORMAT_R32G32B32A32_FLOAT, false, Image.Texels.data(), Desc.Width * sizeof(XMFLOAT4));
+		CreateUpscaledHDRFile(Image, Scale, UpscaledFile);
+		FileData = UpscaledFile.data();
+		FileSize = UpscaledFile.size();
+		if (!ParseHDRHeader(FileData, FileSize, Desc))
+		{
+			fprintf(stderr, "Upscaled image is too large.\n");
+			DestroyJobSystem(Jobs);
+			CloseMappedFile(File);
+			return 1;
+		}
+	}
+	const size_t NumPixels = (size_t)Desc.Width * Desc.Height;
+	printf("%ux%u, %.2f MB, %u threads, best of %u runs\n", Desc.Width, Desc.Height, FileSize / (1024.0 * 1024.0), GetNumThreads(Jobs), NumRuns);
+
+	// Both decoders read from memory. The output of DecodeHDR() goes to a buffer that is allocated and touched up
+	// front (like a mapped upload buffer), so the peak RSS growth is the decoder's own working memory; stbi_loadf()
+	// allocates its 3 floats per pixel output itself. The growth is the largest of all runs, without a peak reset
+	// (Windows) the decoders run in order of their expected footprint.
+	struct FResult
+	{
+		const char* Name;
+		uint32_t Format;
+		float Milliseconds;
+		uint64_t OutputSize;
+		uint64_t PeakRSSGrowth;
+		float MaxError;
+	};
+	FResult Results[] =
+	{
+		{ "DecodeHDR rgb9e5", DDS_FORMAT_R9G9B9E5_SHAREDEXP },
+		{ "DecodeHDR rgba16f", DDS_FORMAT_R16G16B16A16_FLOAT },
+		{ "DecodeHDR rgba32f", DDS_FORMAT_R32G32B32A32_FLOAT },
+		{ "stbi_loadf rgb32f", 0 },
+	};
+
+	// Fault the input in, so that its pages count for neither decoder.
+	volatile uint8_t Sink = 0;
+	for (uint64_t Offset = 0; Offset < FileSize; Offset += 4096)
+	{
+		Sink = Sink + FileData[Offset];
+	}
+
+	float* Reference = nullptr;
+	for (FResult& Result : Results)
+	{
+		Result.Milliseconds = FLT_MAX;
+		Result.PeakRSSGrowth = 0;
+		Result.OutputSize = NumPixels * (Result.Format ? GetDDSBytesPerPixel(Result.Format) : 3 * sizeof(float));
+		eastl::vector<uint8_t> Output(Result.Format ? (size_t)Result.OutputSize : 0);
+
+		for (uint32_t Run = 0; Run < NumRuns; ++Run)
+		{
+			if (Reference)
+			{
+				stbi_image_free(Reference);
+			}
+			uint64_t RSS, PeakRSS;
+			ResetPeakRSS();
+			GetMemoryUsage(RSS, PeakRSS);
+
+			EA::StdC::Stopwatch Time(EA::StdC::Stopwatch::kUnitsMilliseconds, true);
+			if (Result.Format)
+			{
+				DecodeHDR(Jobs, FileData, FileSize, Desc, Result.Format, true, Output.data(), Desc.Width * (uint64_t)GetDDSBytesPerPixel(Result.Format));
+			}
+			else
+			{
+				int Width, Height;
+				stbi_set_flip_vertically_on_load(1);
+				Reference = stbi_loadf_from_memory(FileData, (int)FileSize, &Width, &Height, nullptr, 3);
+				stbi_set_flip_vertically_on_load(0);
+			}
+			Result.Milliseconds = XMMin(Result.Milliseconds, Time.GetElapsedTimeFloat());
+
+			uint64_t FinalRSS;
+			GetMemoryUsage(FinalRSS, PeakRSS);
+			Result.PeakRSSGrowth = XMMax(Result.PeakRSSGrowth, PeakRSS > RSS ? PeakRSS - RSS : 0);
+		}
+	}
+
+	// Error relative to the brightest channel of every stb_image texel, 0 means bit exact.
+	for (FResult& Result : Results)
+	{
+		Result.MaxError = 0.0f;
+		if (Result.Format == 0 || !Reference)
+		{
+			continue;
+		}
+		eastl::vector<uint8_t> Output((size_t)Result.OutputSize);
+		DecodeHDR(Jobs, FileData, FileSize, Desc, Result.Format, true, Output.data(), Desc.Width * (uint64_t)GetDDSBytesPerPixel(Result.Format));
+		for (size_t Idx = 0; Idx < NumPixels; ++Idx)
+		{
+			const XMVECTOR Expected = XMLoadFloat3((const XMFLOAT3*)&Reference[3 * Idx]);
+			const XMVECTOR Error = XMVectorAbs(XMVectorSubtract(LoadDecodedTexel(Result.Format, Output.data(), Idx), Expected));
+			const float MaxValue = XMMax(XMVectorGetX(Expected), XMMax(XMVectorGetY(Expected), XMVectorGetZ(Expected)));
+			if (MaxValue > 0.0f)
+			{
+				const float MaxChannelError = XMMax(XMVectorGetX(Error), XMMax(XMVectorGetY(Error), XMVectorGetZ(Error)));
+				Result.MaxError = XMMax(Result.MaxError, MaxChannelError / MaxValue);
+			}
+		}
+	}
+	stbi_image_free(Reference);
+
+	printf("%-20s %10s %10s %10s %11s %13s %11s\n", "decoder", "time [ms]", "MB/s in", "Mpixel/s", "output MB", "peak RSS +MB", "max error");
+	for (const FResult& Result : Results)
+	{
+		printf("%-20s %10.2f %10.1f %10.1f %11.1f %13.1f %10.4f%%\n", Result.Name, Result.Milliseconds,
+			FileSize / (1024.0 * 1024.0) / (Result.Milliseconds * 0.001), NumPixels / 1.0e6 / (Result.Milliseconds * 0.001),
+			Result.OutputSize / (1024.0 * 1024.0), Result.PeakRSSGrowth / (1024.0 * 1024.0), 100.0f * Result.MaxError);
+	}
+
+	DestroyJobSystem(Jobs);
+	CloseMappedFile(File);
+	return 0;
+}
+
+static bool IsDirectory(const char* Path)
+{
+#ifdef _WIN32
+	struct _stat Status;
+	return _stat(Path, &Status) == 0 && (Status.st_mode & _S_IFDIR) != 0;
+#else
+	struct stat Status;
+	return stat(Path, &Status) == 0 && S_ISDIR(Status.st_mode);
+#endif
+}
+
+// Sorted, so batch runs are reproducible.
+static void ListHDRFiles(const char* Directory, eastl::vector<eastl::string>& OutFileNames)
+{
+#ifdef _WIN32
+	char Pattern[512];
+	EA::StdC::Snprintf(Pattern, sizeof(Pattern), "%s/*.hdr", Directory);
+
+	_finddata_t FindData;
+	const intptr_t Find = _findfirst(Pattern, &FindData);
+	if (Find != -1)
+	{
+		do
+		{
+			if (!(FindData.attrib & _A_SUBDIR))
+			{
+				OutFileNames.push_back(eastl::string(Directory) + "/" + FindData.name);
+			}
+		} while (_findnext(Find, &FindData) == 0);
+		_findclose(Find);
+	}
+#else
+	DIR* Dir = opendir(Directory);
+	if (Dir)
+	{
+		while (const dirent* Entry = readdir(Dir))
+		{
+			if (HasExtension(Entry->d_name, ".hdr"))
+			{
+				const eastl::string FileName = eastl::string(Directory) + "/" + Entry->d_name;
+				if (!IsDirectory(FileName.c_str()))
+				{
+					OutFileNames.push_back(FileName);
+				}
+			}
+		}
+		closedir(Dir);
+	}
+#endif
+	eastl::sort(OutFileNames.begin(), OutFileNames.end());
+}
+
+static bool LoadFileList(const char* ListFileName, eastl::vector<eastl::string>& OutFileNames)
+{
+	FILE* File = fopen(ListFileName, "r");
+	if (!File)
+	{
+		return false;
+	}
+	char Line[1024];
+	while (fgets(Line, sizeof(Line), File))
+	{
+		char* Begin = Line;
+		while (*Begin == ' ' || *Begin == '\t')
+		{
+			++Begin;
+		}
+		char* End = Begin + EA::StdC::Strlen(Begin);
+		while (End > Begin && (End[-1] == '\n' || End[-1] == '\r' || End[-1] == ' ' || End[-1] == '\t'))
+		{
+			--End;
+		}
+		if (End > Begin && *Begin != '#')
+		{
+			OutFileNames.push_back(eastl::string(Begin, End));
+		}
+	}
+	fclose(File);
+	return true;
+}
+
+// File name without directory and extension, names the output directory of a batch entry.
+static eastl::string GetFileStem(const eastl::string& FileName)
+{
+	const size_t Slash = FileName.find_last_of("/\\");
+	const size_t Begin = Slash == eastl::string::npos ? 0 : Slash + 1;
+	const size_t Dot = FileName.find_last_of('.');
+	return FileName.substr(Begin, Dot == eastl::string::npos || Dot < Begin ? eastl::string::npos : Dot - Begin);
+}
+
+struct FBatch
+{
+	FJobSystem* Jobs;
+	const FBakeSettings* Settings;
+	const char* OutputDirectory;
+	eastl::vector<eastl::string> InputFileNames;
+	eastl::vector<FBakeResult> Results;
+	eastl::vector<bool> bSucceeded;
+	EA::Thread::AtomicInt32 NextFile;
+	EA::Thread::AtomicInt32 NumFinished;
+	const EA::StdC::Stopwatch* Time;
+};
+
+// One of Settings.NumProbesInFlight lanes, bakes files until none are left.
+static intptr_t RunBatchLane(void* Context)
+{
+	FBatch& Batch = *(FBatch*)Context;
+	const uint32_t NumFiles = (uint32_t)Batch.InputFileNames.size();
+
+	for (;;)
+	{
+		const uint32_t FileIdx = (uint32_t)Batch.NextFile.Increment() - 1;
+		if (FileIdx >= NumFiles)
+		{
+			break;
+		}
+		const eastl::string& InputFileName = Batch.InputFileNames[FileIdx];
+		const eastl::string OutputDirectory = eastl::string(Batch.OutputDirectory) + "/" + GetFileStem(InputFileName);
+
+		FBakeResult& Result = Batch.Results[FileIdx];
+		Batch.bSucceeded[FileIdx] = BakeFile(*Batch.Jobs, InputFileName.c_str(), OutputDirectory.c_str(), *Batch.Settings, Result);
+
+		float Milliseconds = 0.0f;
+		for (uint32_t Stage = 0; Stage < BAKE_STAGE_Count; ++Stage)
+		{
+			Milliseconds += Result.StageTimes[Stage];
+		}
+		const int32_t NumFinished = Batch.NumFinished.Increment();
+		printf("[%3d/%u] %8.2f s %9.2f ms  %-13s %s\n", NumFinished, NumFiles, Batch.Time->GetElapsedTimeFloat() * 0.001f, Milliseconds,
+			Batch.bSucceeded[FileIdx] ? "ok" : (Result.bIsLoaded ? "write failed" : "load failed"), InputFileName.c_str());
+	}
+	return 0;
+}
+
+static int BakeBatch(const char* Input, const char* OutputDirectory, const FBakeSettings& Settings)
+{
+	FBatch Batch;
+	if (IsDirectory(Input))
+	{
+		ListHDRFiles(Input, Batch.InputFileNames);
+	}
+	else if (!LoadFileList(Input, Batch.InputFileNames))
+	{
+		fprintf(stderr, "Failed to read %s\n", Input);
+		return 1;
+	}
+	const uint32_t NumFiles = (uint32_t)Batch.InputFileNames.size();
+	if (NumFiles == 0)
+	{
+		fprintf(stderr, "No input files in %s\n", Input);
+		return 1;
+	}
+
+	// Output directories are named after the input files.
+	{
+		eastl::vector<eastl::string> Stems;
+		for (const eastl::string& FileName : Batch.InputFileNames)
+		{
+			Stems.push_back(GetFileStem(FileName));
+		}
+		eastl::sort(Stems.begin(), Stems.end());
+		const auto Duplicate = eastl::adjacent_find(Stems.begin(), Stems.end());
+		if (Duplicate != Stems.end())
+		{
+			fprintf(stderr, "Several input files are named %s, their outputs would overwrite each other.\n", Duplicate->c_str());
+			return 1;
+		}
+	}
+	MakeDirectory(OutputDirectory);
+
+	FJobSystem Jobs = {};
+	CreateJobSystem(Settings.NumThreads, Jobs);
+	const uint32_t NumLanes = XMMin(Settings.NumProbesInFlight, NumFiles);
+	printf("Baking %u files with %u threads, %u in flight.\n", NumFiles, GetNumThreads(Jobs), NumLanes);
+
+	Batch.Jobs = &Jobs;
+	Batch.Settings = &Settings;
+	Batch.OutputDirectory = OutputDirectory;
+	Batch.Results.resize(NumFiles);
+	Batch.bSucceeded.resize(NumFiles, false);
+	Batch.NextFile.SetValue(0);
+	Batch.NumFinished.SetValue(0);
+
+	uint64_t RSS, PeakRSS;
+	ResetPeakRSS();
+	GetMemoryUsage(RSS, PeakRSS);
+	const uint64_t BaseRSS = RSS;
+
+	// Lanes are plain threads (not jobs, a waiting job could run a whole other lane nested inside it),
+	// the stages inside them fan out on the shared workers.
+	EA::StdC::Stopwatch Time(EA::StdC::Stopwatch::kUnitsMilliseconds, true);
+	Batch.Time = &Time;
+	EA::Thread::Thread* Lanes = new EA::Thread::Thread[NumLanes];
+	for (uint32_t Lane = 0; Lane < NumLanes; ++Lane)
+	{
+		Lanes[Lane].Begin(RunBatchLane, &Batch);
+	}
+	for (uint32_t Lane = 0; Lane < NumLanes; ++Lane)
+	{
+		Lanes[Lane].WaitForEnd();
+	}
+	delete[] Lanes;
+	const float Seconds = Time.GetElapsedTimeFloat() * 0.001f;
+	DestroyJobSystem(Jobs);
+	GetMemoryUsage(RSS, PeakRSS);
+
+	uint32_t NumFailed = 0;
+	double StageTimes[BAKE_STAGE_Count] = {};
+	for (uint32_t FileIdx = 0; FileIdx < NumFiles; ++FileIdx)
+	{
+		if (!Batch.bSucceeded[FileIdx])
+		{
+			++NumFailed;
+			continue;
+		}
+		for (uint32_t Stage = 0; Stage < BAKE_STAGE_Count; ++Stage)
+		{
+			StageTimes[Stage] += Batch.Results[FileIdx].StageTimes[Stage];
+		}
+	}
+	const uint32_t NumBaked = NumFiles - NumFailed;
+
+	// Stage times overlap across lanes, their sum is larger than the wall time.
+	printf("\n%-28s %12s\n", "Stage", "ms per probe");
+	for (uint32_t Stage = 0; Stage < BAKE_STAGE_Count; ++Stage)
+	{
+		printf("%-28s %12.2f\n", GBakeStageNames[Stage], NumBaked ? StageTimes[Stage] / NumBaked : 0.0);
+	}
+	printf("\n%u baked, %u failed in %.2f s: %.1f probes per minute, peak RSS growth %.1f MB\n", NumBaked, NumFailed, Seconds,
+		Seconds > 0.0f ? NumBaked * 60.0f / Seconds : 0.0f, PeakRSS > BaseRSS ? (PeakRSS - BaseRSS) / (1024.0 * 1024.0) : 0.0);
+
+	return NumFailed ? 1 : 0;
+}
+
+static void PrintUsage()
+{
+	printf("Usage:\n");
+	printf("  IBLBaker bake <input.hdr> <output directory> [-threads N] [-env-res N] [-prefilter-res N] [-prefilter-mips N]\n");
+	printf("                [-prefilter-mode filtered|brute-force] [-prefilter-samples N] [-env-filter bilinear|bicubic|area] [-cache DIR]\n");
+	printf("  IBLBaker batch <input directory|list file> <output directory> [bake options] [-in-flight N]\n");
+	printf("  IBLBaker brdf-lut <output.h|.dds|.bin> [-threads N] [-res N] [-samples N] [-format rg16f|rg8|analytic]\n");
+	printf("  IBLBaker brdf-lut-benchmark [-threads N] [-samples N]\n");
+	printf("  IBLBaker hdr-benchmark <input.hdr> [-threads N] [-scale N] [-runs N]\n");
+	printf("  IBLBaker equirect-compare <input.hdr> [-threads N] [-env-res N]\n");
+	printf("  IBLBaker prefilter-benchmark <input.hdr> [-threads N] [-env-res N] [-prefilter-res N] [-prefilter-mips N] [-ref-samples N]\n");
+	printf("  IBLBaker cache-list <cache directory>\n");
+	printf("  IBLBaker cache-verify <cache directory> [-threads N] [-tolerance N]\n");
+	printf("  IBLBaker sh-accuracy <input.hdr> [-threads N] [-env-res N] [-irr-res N]\n");
+}
+
+int main(int Argc, char** Argv)
+{
+	if (Argc >= 4 && EA::StdC::Strcmp(Argv[1], "bake") == 0)
+	{
+		FBakeSettings Settings;
+		if (!ParseBakeSettings(Argc - 4, Argv + 4, Settings))
+		{
+			PrintUsage();
+			return 1;
+		}
+		return Bake(Argv[2], Argv[3], Settings);
+	}
+	if (Argc >= 4 && EA::StdC::Strcmp(Argv[1], "batch") == 0)
+	{
+		FBakeSettings Settings;
+		if (!ParseBakeSettings(Argc - 4, Argv + 4, Settings))
+		{
+			PrintUsage();
+			return 1;
+		}
+		return BakeBatch(Argv[2], Argv[3], Settings);
+	}
+	if (Argc >= 3 && EA::StdC::Strcmp(Argv[1], "brdf-lut") == 0)
+	{
+		const int Result = GenerateBRDFLUT(Argv[2], Argc - 3, Argv + 3);
+		if (Result >= 0)
+		{
+			return Result;
+		}
+	}
+	if (Argc >= 2 && EA::StdC::Strcmp(Argv[1], "brdf-lut-benchmark") == 0)
+	{
+		const int Result = BenchmarkBRDFLUT(Argc - 2, Argv + 2);
+		if (Result >= 0)
+		{
+			return Result;
+		}
+	}
+	if (Argc >= 3 && EA::StdC::Strcmp(Argv[1], "hdr-benchmark") == 0)
+	{
+		const int Result = BenchmarkHDRDecoder(Argv[2], Argc - 3, Argv + 3);
+		if (Result >= 0)
+		{
+			return Result;
+		}
+	}
+	if (Argc >= 3 && EA::StdC::Strcmp(Argv[1], "equirect-compare") == 0)
+	{
+		const int Result = CompareEquirectangularFilters(Argv[2], Argc - 3, Argv + 3);
+		if (Result >= 0)
+		{
+			return Result;
+		}
+	}
+	if (Argc >= 3 && EA::StdC::Strcmp(Argv[1], "prefilter-benchmark") == 0)
+	{
+		const int Result = BenchmarkPrefilter(Argv[2], Argc - 3, Argv + 3);
+		if (Result >= 0)
+		{
+			return Result;
+		}
+	}
+	if (Argc == 3 && EA::StdC::Strcmp(Argv[1], "cache-list") == 0)
+	{
+		return ListCache(Argv[2]);
+	}
+	if (Argc >= 3 && EA::StdC::Strcmp(Argv[1], "cache-verify") == 0)
+	{
+		const int Result = VerifyCache(Argv[2], Argc - 3, Argv + 3);
+		if (Result >= 0)
+		{
+			return Result;
+		}
+	}
+	if (Argc >= 3 && EA::StdC::Strcmp(Argv[1], "sh-accuracy") == 0)
+	{
+		const int Result = CompareSHIrradiance(Argv[2], Argc - 3, Argv + 3);
+		if (Result >= 0)
+		{
+			return Result;
+		}
+	}
+	PrintUsage();
+	return 1;
+}
@@ -0,0 +1,222 @@
+#include "IBLCache.h"
+#include <stdio.h>
+#include <string.h>
+#include "EAAssert/eaassert.h"
+#include "EAStdC/EAHashCRC.h"
+#include "EAStdC/EASprintf.h"
+#include "EAStdC/EAString.h"
+#ifdef _WIN32
+#include <direct.h>
+#include <io.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#define IBL_CACHE_KEY_FILE_NAME "Key.bin"
+
+static const char* GTextureNames[IBL_TEXTURE_Count] = { "EnvMap", "PrefilteredEnvMap" };
+
+const char* GetIBLTextureName(uint32_t Texture)
+{
+	EA_ASSERT(Texture < IBL_TEXTURE_Count);
+	return GTextureNames[Texture];
+}
+
+void MakeDirectory(const char* Path)
+{
+#ifdef _WIN32
+	_mkdir(Path);
+#else
+	mkdir(Path, 0755);
+#endif
+}
+
+static void GetEntryPath(const char* CacheDirectory, uint64_t KeyHash, const char* FileName, char* OutPath, size_t OutPathSize)
+{
+	if (FileName)
+	{
+		EA::StdC::Snprintf(OutPath, OutPathSize, "%s/%016llx/%s", CacheDirectory, (unsigned long long)KeyHash, FileName);
+	}
+	else
+	{
+		EA::StdC::Snprintf(OutPath, OutPathSize, "%s/%016llx", CacheDirectory, (unsigned long long)KeyHash);
+	}
+}
+
+static void GetTexturePath(const char* CacheDirectory, uint64_t KeyHash, uint32_t Texture, char* OutPath, size_t OutPathSize)
+{
+	char FileName[64];
+	EA::StdC::Snprintf(FileName, sizeof(FileName), "%s.dds", GetIBLTextureName(Texture));
+	GetEntryPath(CacheDirectory, KeyHash, FileName, OutPath, OutPathSize);
+}
+
+static bool LoadKey(const char* CacheDirectory, uint64_t KeyHash, FIBLCacheKey& OutKey)
+{
+	char Path[512];
+	GetEntryPath(CacheDirectory, KeyHash, IBL_CACHE_KEY_FILE_NAME, Path, sizeof(Path));
+
+	FILE* File = fopen(Path, "rb");
+	if (!File)
+	{
+		return false;
+	}
+	const bool bResult = fread(&OutKey, sizeof(OutKey), 1, File) == 1;
+	fclose(File);
+	return bResult;
+}
+
+bool ComputeFileHash(const char* FileName, uint64_t& OutHash)
+{
+	FMappedFile File;
+	if (!OpenMappedFile(FileName, File))
+	{
+		return false;
+	}
+	OutHash = EA::StdC::CRC64(File.Data, (size_t)File.Size);
+	CloseMappedFile(File);
+	return true;
+}
+
+uint64_t GetIBLCacheKeyHash(const FIBLCacheKey& Key)
+{
+	static_assert(sizeof(FIBLCacheKey) == 64, "FIBLCacheKey must not contain padding.");
+	return EA::StdC::CRC64(&Key, sizeof(Key));
+}
+
+bool OpenIBLCacheEntry(const char* CacheDirectory, const FIBLCacheKey& Key, FIBLCacheEntry& OutEntry)
+{
+	OutEntry = {};
+
+	const uint64_t KeyHash = GetIBLCacheKeyHash(Key);
+	FIBLCacheKey StoredKey;
+	if (!LoadKey(CacheDirectory, KeyHash, StoredKey) || memcmp(&StoredKey, &Key, sizeof(Key)) != 0)
+	{
+		return false;
+	}
+
+	for (uint32_t Texture = 0; Texture < IBL_TEXTURE_Count; ++Texture)
+	{
+		char Path[512];
+		GetTexturePath(CacheDirectory, KeyHash, Texture, Path, sizeof(Path));
+
+		if (!OpenMappedFile(Path, OutEntry.Files[Texture]) ||
+			!ParseDDS(OutEntry.Files[Texture].Data, OutEntry.Files[Texture].Size, OutEntry.Descs[Texture], OutEntry.Pixels[Texture]))
+		{
+			CloseIBLCacheEntry(OutEntry);
+			return false;
+		}
+	}
+	return true;
+}
+
+void CloseIBLCacheEntry(FIBLCacheEntry& Entry)
+{
+	for (uint32_t Texture = 0; Texture < IBL_TEXTURE_Count; ++Texture)
+	{
+		CloseMappedFile(Entry.Files[Texture]);
+		Entry.Pixels[Texture] = nullptr;
+	}
+}
+
+bool SaveIBLCacheEntry(const char* CacheDirectory, const FIBLCacheKey& Key, const FDDSDesc Descs[IBL_TEXTURE_Count], const void* const Data[IBL_TEXTURE_Count])
+{
+	const uint64_t KeyHash = GetIBLCacheKeyHash(Key);
+
+	char Path[512];
+	MakeDirectory(CacheDirectory);
+	GetEntryPath(CacheDirectory, KeyHash, nullptr, Path, sizeof(Path));
+	MakeDirectory(Path);
+
+	for (uint32_t Texture = 0; Texture < IBL_TEXTURE_Count; ++Texture)
+	{
+		GetTexturePath(CacheDirectory, KeyHash, Texture, Path, sizeof(Path));
+		if (!SaveDDS(Path, Descs[Texture], Data[Texture]))
+		{
+			return false;
+		}
+	}
+
+	// The key goes last, an entry without it is never opened.
+	GetEntryPath(CacheDirectory, KeyHash, IBL_CACHE_KEY_FILE_NAME, Path, sizeof(Path));
+	FILE* File = fopen(Path, "wb");
+	if (!File)
+	{
+		return false;
+	}
+	const bool bResult = fwrite(&Key, sizeof(Key), 1, File) == 1;
+	fclose(File);
+	return bResult;
+}
+
+static void AddEntryInfo(const char* CacheDirectory, const char* EntryName, eastl::vector<FIBLCacheEntryInfo>& OutEntries)
+{
+	if (EA::StdC::Strlen(EntryName) != 16)
+	{
+		return;
+	}
+	char* End;
+	const uint64_t KeyHash = EA::StdC::StrtoU64(EntryName, &End, 16);
+	if (*End != '\0')
+	{
+		return;
+	}
+
+	FIBLCacheEntryInfo Info = {};
+	Info.KeyHash = KeyHash;
+	Info.bIsValid = LoadKey(CacheDirectory, KeyHash, Info.Key) && GetIBLCacheKeyHash(Info.Key) == KeyHash;
+
+	for (uint32_t Texture = 0; Texture < IBL_TEXTURE_Count; ++Texture)
+	{
+		char Path[512];
+		GetTexturePath(CacheDirectory, KeyHash, Texture, Path, sizeof(Path));
+
+		FMappedFile File;
+		const uint8_t* Pixels;
+		if (OpenMappedFile(Path, File))
+		{
+			Info.FileSizes[Texture] = File.Size;
+			Info.bIsValid = ParseDDS(File.Data, File.Size, Info.Descs[Texture], Pixels) && Info.bIsValid;
+			CloseMappedFile(File);
+		}
+		else
+		{
+			Info.bIsValid = false;
+		}
+	}
+	OutEntries.push_back(Info);
+}
+
+void ListIBLCacheEntries(const char* CacheDirectory, eastl::vector<FIBLCacheEntryInfo>& OutEntries)
+{
+#ifdef _WIN32
+	char Pattern[512];
+	EA::StdC::Snprintf(Pattern, sizeof(Pattern), "%s/*", CacheDirectory);
+
+	_finddata_t FindData;
+	const intptr_t Find = _findfirst(Pattern, &FindData);
+	if (Find == -1)
+	{
+		return;
+	}
+	do
+	{
+		if (FindData.attrib & _A_SUBDIR)
+		{
+			AddEntryInfo(CacheDirectory, FindData.name, OutEntries);
+		}
+	} while (_findnext(Find, &FindData) == 0);
+	_findclose(Find);
+#else
+	DIR* Directory = opendir(CacheDirectory);
+	if (!Directory)
+	{
+		return;
+	}
+	while (const dirent* Entry = readdir(Directory))
+	{
+		AddEntryInfo(CacheDirectory, Entry->d_name, OutEntries);
+	}
+	closedir(Directory);
+#endif
+}
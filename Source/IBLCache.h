@@ -0,0 +1,91 @@
+#pragma once
+
+#include <stdint.h>
+#include "EASTL/vector.h"
+#include "DDSFile.h"
+#include "MappedFile.h"
+
+// Content-addressed on-disk cache of baked IBL textures. Every entry is a directory named after the hash of its
+// FIBLCacheKey and holds one DDS file per texture (all mips, D3D12 subresource order) plus the key itself, which is
+// written last and marks the entry as complete. Entries are memory-mapped so the texel data can be copied straight
+// into upload buffers.
+
+// Bump whenever EquirectangularToCube, PrefilterEnvMap or the CPU baker change in a way that affects their output.
+// The irradiance SH is not cached, it is projected from the (cached) env. map at load time. The BRDF integration map
+// does not depend on the environment and is embedded in the executable (BRDFIntegrationMapData.h).
+#define IBL_CACHE_SHADER_VERSION 7
+
+#define IBL_MAX_PREFILTERED_MIP_LEVELS 8
+
+enum
+{
+	IBL_TEXTURE_EnvMap, IBL_TEXTURE_PrefilteredEnvMap, IBL_TEXTURE_Count,
+};
+
+enum
+{
+	// Every GGX sample reads mip 0 of the env. map (the old PrefilterEnvMap.hlsl, CPU baker only).
+	PREFILTER_MODE_BruteForce,
+	// Every GGX sample reads the env. map mip that covers its solid angle (filtered importance sampling, like
+	// PrefilterEnvMap.hlsl). Needs the full env. map mip chain and far fewer samples.
+	PREFILTER_MODE_Filtered,
+};
+
+enum
+{
+	// Bilinear lookups of the equirectangular image (what EquirectangularToCube.hlsl does).
+	EQUIRECT_FILTER_Bilinear,
+	EQUIRECT_FILTER_Bicubic,
+	EQUIRECT_FILTER_Area,
+};
+
+// GGX samples per texel of a prefiltered mip with filtered importance sampling, shared by the GPU and the CPU bake.
+// Picked with IBLBaker prefilter-benchmark: 512 samples are as close to the exact convolution as 4096 brute force
+// samples at every roughness. Mip 0 (roughness 0) is a mirror lookup and needs one sample.
+inline uint32_t GetPrefilterNumSamples(uint32_t Mip)
+{
+	return Mip == 0 ? 1 : 512;
+}
+
+struct FIBLCacheKey
+{
+	uint64_t SourceHash;
+	uint32_t EnvMapResolution;
+	uint32_t PrefilteredEnvMapResolution;
+	uint32_t PrefilteredEnvMapNumMipLevels;
+	uint32_t PrefilteredEnvMapNumSamples[IBL_MAX_PREFILTERED_MIP_LEVELS]; // Per mip, unused mips are zero.
+	uint32_t PrefilterMode;
+	uint32_t ShaderVersion;
+	uint32_t EnvMapFilter; // EQUIRECT_FILTER_ the env. map was converted with.
+};
+
+struct FIBLCacheEntry
+{
+	FMappedFile Files[IBL_TEXTURE_Count];
+	FDDSDesc Descs[IBL_TEXTURE_Count];
+	const uint8_t* Pixels[IBL_TEXTURE_Count];
+};
+
+struct FIBLCacheEntryInfo
+{
+	FIBLCacheKey Key;
+	uint64_t KeyHash;
+	FDDSDesc Descs[IBL_TEXTURE_Count];
+	uint64_t FileSizes[IBL_TEXTURE_Count];
+	bool bIsValid;
+};
+
+const char* GetIBLTextureName(uint32_t Texture);
+
+// Creates the last directory of Path, nothing when it exists.
+void MakeDirectory(const char* Path);
+
+bool ComputeFileHash(const char* FileName, uint64_t& OutHash);
+uint64_t GetIBLCacheKeyHash(const FIBLCacheKey& Key);
+
+// Returns false on a cache miss (no entry, incomplete entry or a hash collision with a different key).
+bool OpenIBLCacheEntry(const char* CacheDirectory, const FIBLCacheKey& Key, FIBLCacheEntry& OutEntry);
+void CloseIBLCacheEntry(FIBLCacheEntry& Entry);
+bool SaveIBLCacheEntry(const char* CacheDirectory, const FIBLCacheKey& Key, const FDDSDesc Descs[IBL_TEXTURE_Count], const void* const Data[IBL_TEXTURE_Count]);
+
+void ListIBLCacheEntries(const char* CacheDirectory, eastl::vector<FIBLCacheEntryInfo>& OutEntries);
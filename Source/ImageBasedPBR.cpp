@@ -6,10 +6,34 @@
 #include "EAStdC/EASprintf.h"
 #include "EAStdC/EABitTricks.h"
 #include "EAStdC/EAString.h"
-#include "stb_image.h"
-#include "cgltf.h"
-
-#define MESH_MAX_NUM_SECTIONS 4
+#include "IBLCache.h"
+#include "SphericalHarmonics.h"
+#include "JobSystem.h"
+#include "HDRFile.h"
+#include "MappedFile.h"
+#include "BRDFIntegrationMapData.h"
+#include "CookedMesh.h"
+#include "InstanceBVH.h"
+#include "MeshCluster.h"
+#include "MeshSimplify.h"
+#include "MeshStreaming.h"
+#include "StaticScene.h"
+#include "VertexLayout.h"
+
+#define ENV_MAP_FILE_NAME "Data/Textures/Newport_Loft.hdr"
+#define ENV_MAP_RESOLUTION 512
+#define IRRADIANCE_SH_PROJECTION_RESOLUTION 64 // EnvMap mip that is projected to SH.
+#define PREFILTERED_ENV_MAP_RESOLUTION 256
+#define PREFILTERED_ENV_MAP_NUM_MIP_LEVELS 6 // 256, 128, 64, 32, 16, 8
+#define IBL_CACHE_DIRECTORY "Data/IBLCache"
+// Per-frame GPU work of a runtime env. map change (see UpdateEnvMapRebake()).
+#define ENV_MAP_REBAKE_FACES_PER_FRAME 1
+#define ENV_MAP_REBAKE_PREFILTER_SAMPLES_PER_FRAME (2 * 1024 * 1024) // GGX samples of all faces.
+// Vertex and index data of streamed meshes copied to the static geometry buffers per frame (see UpdateMeshStreaming()).
+#define MESH_STREAM_UPLOAD_BYTES_PER_FRAME (2 * 1024 * 1024)
+// Vertex attributes of the static geometry buffers, the ones that some pipeline reads (see CreatePipelines()). Cooked
+// meshes are converted to this layout when they are uploaded.
+#define STATIC_VERTEX_ATTRIBUTES (VERTEX_ATTRIBUTE_BIT(VERTEX_ATTRIBUTE_Position) | VERTEX_ATTRIBUTE_BIT(VERTEX_ATTRIBUTE_Normal) | VERTEX_ATTRIBUTE_BIT(VERTEX_ATTRIBUTE_Color))
 
 enum
 {
@@ -18,73 +42,139 @@ enum
 
 enum
 {
-	PSO_Test, PSO_SimpleForward, PSO_SampleEnvMap, PSO_EquirectangularToCube, PSO_GenerateIrradianceMap, PSO_PrefilterEnvMap, PSO_GenerateBRDFIntegrationMap,
+	PSO_Test, PSO_SimpleForward, PSO_SampleEnvMap, PSO_EquirectangularToCube, PSO_PrefilterEnvMap,
 };
 
-struct FVertex
+// Resources that are needed to render an EnvMap from an equirectangular .hdr file.
+struct FEnvMapSource
 {
-	XMFLOAT3 Position;
-	XMFLOAT3 Normal;
+	ID3D12Resource* HDRRectTexture; // RGB9E5, COPY_DEST until UploadEnvMapSource().
+	ID3D12Resource* StagingBuffer;
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT StagingLayout;
+	ID3D12Resource* TempCubeMap; // Render target for all faces, copied to the EnvMap by FinishEnvMap().
 };
 
-struct FMeshSection
+// States of a runtime env. map change. CPU work runs as a job, GPU work is split into per-frame slices.
+enum
 {
-	uint32_t IndexCount;
-	uint32_t StartIndexLocation;
-	uint32_t BaseVertexLocation;
-	uint32_t MaterialIndex;
+	REBAKE_Idle,
+	REBAKE_Loading, // Job: hash, cache lookup, .hdr decode and resource creation.
+	REBAKE_UploadFaces, // Cache hit.
+	REBAKE_DrawEnvMapFaces,
+	REBAKE_PrefilterEnvMap,
+	REBAKE_CopyToReadback,
+	REBAKE_WaitForGPU,
+	REBAKE_Readback, // Job: readback, SH projection and cache store.
+	REBAKE_Retire, // Waits until the GPU is done with the replaced textures.
 };
 
-struct FMesh
+struct FEnvMapRebake
 {
-	FMeshSection Sections[MESH_MAX_NUM_SECTIONS];
-	uint32_t NumSections;
+	ID3D12CommandAllocator* CmdAlloc[2];
+	ID3D12GraphicsCommandList2* CmdList; // Executed right before the frame's command list.
+	FMipmapGenerator MipmapGenerator;
+	FJobCounter JobCounter;
+	uint32_t State;
+	bool bIsCacheHit;
+	bool bHasSucceeded; // Result of the last job.
+	char FileName[MAX_PATH];
+	FIBLCacheKey Key;
+	FEnvMapSource Source;
+	ID3D12Resource* Textures[IBL_TEXTURE_Count]; // New textures, the replaced ones after the swap.
+	ID3D12Resource* UploadBuffers[IBL_TEXTURE_Count];
+	ID3D12Resource* ReadbackBuffers[IBL_TEXTURE_Count];
+	D3D12_CPU_DESCRIPTOR_HANDLE SRVs[IBL_TEXTURE_Count]; // Swapped with the SRVs in FDemoRoot.
+	D3D12_CPU_DESCRIPTOR_HANDLE HDRRectTextureSRV;
+	D3D12_CPU_DESCRIPTOR_HANDLE TempCubeMapRTVs;
+	D3D12_CPU_DESCRIPTOR_HANDLE PrefilteredEnvMapUAVs;
+	XMFLOAT4 IrradianceSH[SH_NUM_COEFFICIENTS];
+	uint32_t NextFace;
+	uint32_t NextTile;
+	uint32_t NextTexture;
+	uint64_t FenceValue; // Frame fence value the current state waits for.
+	double MaxStepTime; // Longest CPU time spent in UpdateEnvMapRebake() during the last change.
 };
 
-struct FStaticMesh
+// Streamed mesh that is being copied to the static geometry buffers, over as many frames as the upload budget needs.
+struct FMeshUpload
 {
-	uint32_t IndexCount;
-	uint32_t StartIndexLocation;
+	const FStreamedMesh* Mesh; // nullptr when there is none.
 	uint32_t BaseVertexLocation;
+	uint32_t StartIndexLocation;
+	uint32_t NextVertex;
+	uint32_t NextIndex;
 };
 
-struct FStaticMeshInstance
+// Resource that was replaced while frames in flight may still use it.
+struct FRetiredResource
 {
-	XMFLOAT3 Position;
-	XMFLOAT3 Rotation;
-	uint32_t MeshIndex;
-	float Roughness;
-	float Metallic;
+	ID3D12Resource* Resource;
+	uint64_t FenceValue; // Frame fence value after which it is released.
 };
 
 struct FDemoRoot
 {
 	FGraphicsContext Gfx;
 	FUIContext UI;
-	eastl::vector<FStaticMesh> StaticMeshes;
-	eastl::vector<FStaticMeshInstance> StaticMeshInstances;
+	FJobSystem Jobs;
+	FStaticScene StaticScene;
+	eastl::vector<uint32_t> VisibleInstances; // Last frame, in the order of StaticScene.InstanceBVH.
+	uint32_t NumVisibleInstances;
+	FStaticDrawList StaticDrawList; // Last frame.
+	double InstanceCullTime;
+	double StaticDrawTime; // SelectStaticDrawLODs(), RecordStaticDrawBatches() and the submission of the batches.
+	ID3D12CommandSignature* StaticDrawSignature; // ExecuteIndirect() of FStaticDrawBatch arguments.
+	bool bIndirectStaticDraws; // UI input, ExecuteIndirect() instead of draws recorded by jobs.
+	uint32_t NumStaticDrawCmdLists; // Last frame, zero when the batches were submitted with ExecuteIndirect().
+	uint32_t PickedInstance; // Under the mouse cursor, UINT32_MAX for none.
 	eastl::vector<ID3D12PipelineState*> Pipelines;
 	eastl::vector<ID3D12RootSignature*> RootSignatures;
-	ID3D12Resource* StaticVB;
+	FVertexLayout StaticVertexLayout; // STATIC_VERTEX_ATTRIBUTES.
+	ID3D12Resource* StaticVBs[VERTEX_MAX_STREAMS];
 	ID3D12Resource* StaticIB;
-	D3D12_VERTEX_BUFFER_VIEW StaticVBView;
+	D3D12_VERTEX_BUFFER_VIEW StaticVBViews[VERTEX_MAX_STREAMS];
 	D3D12_INDEX_BUFFER_VIEW StaticIBView;
+	uint32_t NumStaticVertices;
+	uint32_t StaticVBCapacity; // Vertices.
+	uint32_t StaticIBCapacity; // Indices.
 	XMFLOAT3 CameraPosition;
 	XMFLOAT3 CameraFocusPosition;
+	float CameraDistance; // Radius of the camera orbit.
 	ID3D12Resource* EnvMap;
-	ID3D12Resource* IrradianceMap;
 	ID3D12Resource* PrefilteredEnvMap;
 	ID3D12Resource* BRDFIntegrationMap;
 	D3D12_CPU_DESCRIPTOR_HANDLE EnvMapSRV;
-	D3D12_CPU_DESCRIPTOR_HANDLE IrradianceMapSRV;
 	D3D12_CPU_DESCRIPTOR_HANDLE PrefilteredEnvMapSRV;
 	D3D12_CPU_DESCRIPTOR_HANDLE BRDFIntegrationMapSRV;
+	FDescriptorHandle EnvMapDescriptor; // Persistent copies of the SRVs above, the shaders index them by slot.
+	FDescriptorHandle PrefilteredEnvMapDescriptor;
+	FDescriptorHandle BRDFIntegrationMapDescriptor;
+	XMFLOAT4 IrradianceSH[SH_NUM_COEFFICIENTS];
+	FEnvMapRebake EnvMapRebake;
+	char EnvMapFileName[MAX_PATH];
+	char NewEnvMapFileName[MAX_PATH]; // UI input.
+	float MaxLODError; // Pixels, UI input.
+	uint64_t NumDrawnTriangles[2]; // Last frame, with the selected LODs and with LODs[0] only.
+	bool bClusterCulling; // UI input.
+	FClusterCullStats ClusterCullStats; // Last frame.
+	FMeshStreamer MeshStreamer;
+	FMeshUpload MeshUpload;
+	eastl::vector<FRetiredResource> RetiredResources;
+	eastl::vector<const char*> MeshFileNames; // Command line arguments that are not options.
+	uint32_t NumRequestedMeshFiles; // MeshFileNames passed to RequestMesh() so far.
+	uint32_t NumStreamedMeshes;
+	uint32_t NumFailedMeshes;
+	bool bShowsDefaultScene; // Sphere grid, replaced by the first streamed mesh that has instances.
+	double MaxMeshStreamingStepTime; // Longest CPU time spent in UpdateMeshStreaming().
 	ID3D12Resource* MSColorBuffer;
 	ID3D12Resource* MSDepthBuffer;
 	D3D12_CPU_DESCRIPTOR_HANDLE MSColorBufferRTV;
 	D3D12_CPU_DESCRIPTOR_HANDLE MSDepthBufferDSV;
 };
 
+static bool LoadEnvMap(FDemoRoot& Root, const char* FileName);
+static void UpdateMeshStreaming(FDemoRoot& Root);
+
 static void Update(FDemoRoot& Root)
 {
 	double Time;
@@ -95,11 +185,129 @@ static void Update(FDemoRoot& Root)
 	// Update camera position.
 	{
 		const float Angle = XMScalarModAngle(0.25f * (float)Time);
-		XMVECTOR Position = XMVectorSet(12.0f * cosf(Angle), 6.0f, 12.0f * sinf(Angle), 1.0f);
+		const float Distance = Root.CameraDistance;
+		XMVECTOR Position = XMVectorSet(Distance * cosf(Angle), 0.5f * Distance, Distance * sinf(Angle), 1.0f);
 		XMStoreFloat3(&Root.CameraPosition, Position);
 	}
 
+	AnimateStaticScene(Root.Jobs, (float)Time, Root.StaticScene);
+
 	ImGui::ShowDemoWindow();
+
+	// Environment change, the IBL textures are rebaked over several frames (see UpdateEnvMapRebake()).
+	{
+		static const char* StateNames[] =
+		{
+			"Idle", "Loading", "Uploading faces", "Drawing faces", "Prefiltering", "Copying to readback", "Waiting for GPU", "Reading back", "Releasing old textures",
+		};
+		static_assert(eastl::size(StateNames) == REBAKE_Retire + 1, "Missing state name.");
+		const FEnvMapRebake& Rebake = Root.EnvMapRebake;
+
+		ImGui::Begin("Environment");
+		ImGui::Text("Current: %s", Root.EnvMapFileName);
+		ImGui::InputText(".hdr file", Root.NewEnvMapFileName, sizeof(Root.NewEnvMapFileName));
+		if (ImGui::Button("Load"))
+		{
+			LoadEnvMap(Root, Root.NewEnvMapFileName);
+		}
+		ImGui::Text("State: %s", StateNames[Rebake.State]);
+		ImGui::Text("Longest rebake step: %.3f ms", 1000.0 * Rebake.MaxStepTime);
+		ImGui::End();
+	}
+
+	ImGui::Begin("Level of detail and culling");
+	ImGui::SliderFloat("Max. error (pixels)", &Root.MaxLODError, 0.0f, 8.0f);
+	ImGui::Text("Visible instances: %u of %u (%.3f ms)", Root.NumVisibleInstances, (uint32_t)Root.StaticScene.Instances.size(), 1000.0 * Root.InstanceCullTime);
+	ImGui::Text("Moving instances: %u", (uint32_t)Root.StaticScene.MovingInstances.size());
+	if (Root.PickedInstance != UINT32_MAX)
+	{
+		ImGui::Text("Under the cursor: instance %u, mesh %u", Root.PickedInstance, Root.StaticScene.Instances[Root.PickedInstance].MeshIndex);
+	}
+	ImGui::Checkbox("Cluster culling", &Root.bClusterCulling);
+	ImGui::Text("Triangles: %llu (%llu without LODs and culling)", (unsigned long long)Root.NumDrawnTriangles[0], (unsigned long long)Root.NumDrawnTriangles[1]);
+	if (Root.bClusterCulling)
+	{
+		const FClusterCullStats& Stats = Root.ClusterCullStats;
+		const double NumTriangles = (double)XMMax(Stats.NumTriangles, (uint64_t)1);
+		ImGui::Text("Visible clusters: %llu of %llu", (unsigned long long)Stats.NumVisibleClusters, (unsigned long long)Stats.NumClusters);
+		ImGui::Text("Culled triangles: %.1f%% frustum, %.1f%% backface", 100.0 * Stats.NumFrustumCulledTriangles / NumTriangles,
+			100.0 * Stats.NumBackfaceCulledTriangles / NumTriangles);
+	}
+	ImGui::Checkbox("ExecuteIndirect", &Root.bIndirectStaticDraws);
+	if (Root.NumStaticDrawCmdLists > 0)
+	{
+		ImGui::Text("Draws: %u in %u command lists", (uint32_t)Root.StaticDrawList.Batches.size(), Root.NumStaticDrawCmdLists);
+	}
+	else
+	{
+		ImGui::Text("Draws: %u (ExecuteIndirect)", (uint32_t)Root.StaticDrawList.Batches.size());
+	}
+	ImGui::Text("Draw recording time: %.3f ms", 1000.0 * Root.StaticDrawTime);
+	ImGui::End();
+
+	ImGui::Begin("Mesh streaming");
+	ImGui::Text("Meshes: %u streamed, %u failed, %u pending", Root.NumStreamedMeshes, Root.NumFailedMeshes, GetNumMeshRequests(Root.MeshStreamer));
+	if (Root.MeshUpload.Mesh)
+	{
+		const FMeshUpload& Upload = Root.MeshUpload;
+		const FCookedMesh& Mesh = Upload.Mesh->Mesh;
+		ImGui::Text("Uploading %s (%.0f%%)", Upload.Mesh->FileName.c_str(), 100.0 * (Upload.NextVertex + Upload.NextIndex) / XMMax(Mesh.NumVertices + Mesh.NumIndices, 1u));
+	}
+	ImGui::Text("Longest streaming step: %.3f ms", 1000.0 * Root.MaxMeshStreamingStepTime);
+	ImGui::End();
+
+	ImGui::Begin("Upload memory");
+	{
+		const FUploadRing& Upload = Root.Gfx.Upload;
+		const double MB = 1.0 / (1024.0 * 1024.0);
+		ImGui::Text("Last frame: %.2f MB in %u allocations (%.2f MB dedicated)", MB * Upload.LastFrame.NumBytes, Upload.LastFrame.NumAllocations,
+			MB * Upload.LastFrame.NumDedicatedBytes);
+		ImGui::Text("Largest frame: %.2f MB", MB * Upload.MaxFrame.NumBytes);
+		ImGui::Text("In use: %.2f MB at most last frame, %.2f MB ever", MB * Upload.LastFrame.HighWater, MB * Upload.MaxFrame.HighWater);
+		ImGui::Text("Capacity: %.2f MB, %u pages", MB * Upload.LastFrame.Capacity, (uint32_t)Upload.Pages.size());
+	}
+	ImGui::End();
+}
+
+// Targets and input assembler state of the passes that draw to the MS color buffer, every command list starts without.
+static void SetDrawTargetState(FDemoRoot& Root, ID3D12GraphicsCommandList2* CmdList)
+{
+	const FGraphicsContext& Gfx = Root.Gfx;
+	CmdList->RSSetViewports(1, &CD3DX12_VIEWPORT(0.0f, 0.0f, (float)Gfx.Resolution[0], (float)Gfx.Resolution[1]));
+	CmdList->RSSetScissorRects(1, &CD3DX12_RECT(0, 0, (LONG)Gfx.Resolution[0], (LONG)Gfx.Resolution[1]));
+	CmdList->OMSetRenderTargets(1, &Root.MSColorBufferRTV, TRUE, &Root.MSDepthBufferDSV);
+	CmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	CmdList->IASetVertexBuffers(0, VERTEX_MAX_STREAMS, Root.StaticVBViews);
+	CmdList->IASetIndexBuffer(&Root.StaticIBView);
+}
+
+// Bindings of the static mesh draws of a frame, set on every command list that records some of them.
+struct FStaticDrawState
+{
+	D3D12_INDEX_BUFFER_VIEW IBView; // Culled or static indices.
+	D3D12_GPU_VIRTUAL_ADDRESS PerFrameConstants;
+	D3D12_GPU_VIRTUAL_ADDRESS Instances; // FStaticInstanceData.
+};
+
+static void SetStaticDrawState(FDemoRoot& Root, const FStaticDrawState& State, ID3D12GraphicsCommandList2* CmdList)
+{
+	CmdList->IASetIndexBuffer(&State.IBView);
+	CmdList->SetPipelineState(Root.Pipelines[PSO_SimpleForward]);
+	CmdList->SetGraphicsRootSignature(Root.RootSignatures[PSO_SimpleForward]);
+	CmdList->SetGraphicsRootConstantBufferView(1, State.PerFrameConstants);
+	CmdList->SetGraphicsRootShaderResourceView(2, State.Instances);
+	CmdList->SetGraphicsRootDescriptorTable(3, Root.Gfx.PersistentDescriptorHeap.GPUStart);
+	CmdList->SetGraphicsRootDescriptorTable(4, Root.Gfx.PersistentDescriptorHeap.GPUStart);
+}
+
+static void DrawStaticBatches(const FStaticDrawBatch* Batches, uint32_t Begin, uint32_t End, ID3D12GraphicsCommandList2* CmdList)
+{
+	for (uint32_t Idx = Begin; Idx < End; ++Idx)
+	{
+		const FStaticDrawBatch& Batch = Batches[Idx];
+		CmdList->SetGraphicsRoot32BitConstant(0, Batch.FirstInstance, 0);
+		CmdList->DrawIndexedInstanced(Batch.IndexCountPerInstance, Batch.InstanceCount, Batch.StartIndexLocation, Batch.BaseVertexLocation, 0);
+	}
 }
 
 static void Draw(FDemoRoot& Root)
@@ -107,29 +315,54 @@ static void Draw(FDemoRoot& Root)
 	FGraphicsContext& Gfx = Root.Gfx;
 	ID3D12GraphicsCommandList2* CmdList = GetAndInitCommandList(Gfx);
 
-	CmdList->RSSetViewports(1, &CD3DX12_VIEWPORT(0.0f, 0.0f, (float)Gfx.Resolution[0], (float)Gfx.Resolution[1]));
-	CmdList->RSSetScissorRects(1, &CD3DX12_RECT(0, 0, (LONG)Gfx.Resolution[0], (LONG)Gfx.Resolution[1]));
+	// Streamed geometry is copied before it is drawn.
+	UpdateMeshStreaming(Root);
 
-	CmdList->OMSetRenderTargets(1, &Root.MSColorBufferRTV, TRUE, &Root.MSDepthBufferDSV);
+	SetDrawTargetState(Root, CmdList);
 	CmdList->ClearRenderTargetView(Root.MSColorBufferRTV, XMVECTORF32{ 0.0f }, 0, nullptr);
 	CmdList->ClearDepthStencilView(Root.MSDepthBufferDSV, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
 
-	CmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	CmdList->IASetVertexBuffers(0, 1, &Root.StaticVBView);
-	CmdList->IASetIndexBuffer(&Root.StaticIBView);
-
 	const XMMATRIX ViewTransform = XMMatrixLookAtLH(XMLoadFloat3(&Root.CameraPosition), XMLoadFloat3(&Root.CameraFocusPosition), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
-	const XMMATRIX ProjectionTransform = XMMatrixPerspectiveFovLH(XM_PI / 3, 1.777f, 0.1f, 100.0f);
+	const float FovY = XM_PI / 3;
+	const XMMATRIX ProjectionTransform = XMMatrixPerspectiveFovLH(FovY, 1.777f, 0.1f, XMMax(100.0f, 4.0f * Root.CameraDistance));
+	const XMMATRIX WorldToClip = ViewTransform * ProjectionTransform;
+
+	// Instances whose bounds intersect the view frustum, and the one under the mouse cursor (see InstanceBVH.h).
+	{
+		const double StartTime = GetTime();
+		XMFLOAT4 FrustumPlanes[6];
+		GetFrustumPlanes(WorldToClip, FrustumPlanes);
+		Root.NumVisibleInstances = QueryInstanceBVH(Root.StaticScene.InstanceBVH, Root.StaticScene.InstanceBounds, FrustumPlanes, Root.VisibleInstances.data());
+		Root.InstanceCullTime = GetTime() - StartTime;
+
+		Root.PickedInstance = UINT32_MAX;
+		const ImVec2 MousePosition = ImGui::GetIO().MousePos;
+		if (ImGui::IsMousePosValid(&MousePosition) && !ImGui::GetIO().WantCaptureMouse)
+		{
+			// From the near to the far plane.
+			const XMMATRIX ClipToWorld = XMMatrixInverse(nullptr, WorldToClip);
+			const float X = 2.0f * MousePosition.x / Gfx.Resolution[0] - 1.0f;
+			const float Y = 1.0f - 2.0f * MousePosition.y / Gfx.Resolution[1];
+			const XMVECTOR Near = XMVector3TransformCoord(XMVectorSet(X, Y, 0.0f, 1.0f), ClipToWorld);
+			const XMVECTOR Far = XMVector3TransformCoord(XMVectorSet(X, Y, 1.0f, 1.0f), ClipToWorld);
+			XMFLOAT3 Origin, Direction;
+			XMStoreFloat3(&Origin, Near);
+			XMStoreFloat3(&Direction, XMVectorSubtract(Far, Near));
+			float Distance;
+			RayCastInstanceBVH(Root.StaticScene.InstanceBVH, Root.StaticScene.InstanceBounds, Origin, Direction, 1.0f, Root.PickedInstance, Distance);
+		}
+	}
 
 	// Draw all static mesh instances.
 	{
-		CmdList->SetPipelineState(Root.Pipelines[PSO_SimpleForward]);
-		CmdList->SetGraphicsRootSignature(Root.RootSignatures[PSO_SimpleForward]);
+		FStaticDrawState State;
+		State.IBView = Root.StaticIBView;
 
 		// Per-frame constant data.
 		{
-			D3D12_GPU_VIRTUAL_ADDRESS GPUAddress;
-			auto* CPUAddress = (FPerFrameConstantData*)AllocateGPUMemory(Gfx, sizeof(FPerFrameConstantData), GPUAddress);
+			auto* CPUAddress = (FPerFrameConstantData*)AllocateGPUMemory(Gfx, sizeof(FPerFrameConstantData), State.PerFrameConstants);
+
+			XMStoreFloat4x4(&CPUAddress->WorldToClip, XMMatrixTranspose(WorldToClip));
 
 			CPUAddress->LightPositions[0] = XMFLOAT4(-10.0f, 10.0f, -10.0f, 1.0f);
 			CPUAddress->LightPositions[1] = XMFLOAT4(10.0f, 10.0f, -10.0f, 1.0f);
@@ -144,64 +377,92 @@ static void Draw(FDemoRoot& Root)
 			const XMFLOAT3 P = Root.CameraPosition;
 			CPUAddress->ViewerPosition = XMFLOAT4(P.x, P.y, P.z, 1.0f);
 
-			CD3DX12_CPU_DESCRIPTOR_HANDLE TableBaseCPU;
-			CD3DX12_GPU_DESCRIPTOR_HANDLE TableBaseGPU;
-			AllocateGPUDescriptors(Gfx, 4, TableBaseCPU, TableBaseGPU);
-
-			D3D12_CONSTANT_BUFFER_VIEW_DESC CBVDesc = {};
-			CBVDesc.BufferLocation = GPUAddress;
-			CBVDesc.SizeInBytes = (uint32_t)sizeof(FPerFrameConstantData);
-
-			Gfx.Device->CreateConstantBufferView(&CBVDesc, TableBaseCPU);
-			TableBaseCPU.Offset(Gfx.DescriptorSize);
-
-			Gfx.Device->CopyDescriptorsSimple(1, TableBaseCPU, Root.IrradianceMapSRV, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-			TableBaseCPU.Offset(Gfx.DescriptorSize);
+			memcpy(CPUAddress->IrradianceSH, Root.IrradianceSH, sizeof(Root.IrradianceSH));
 
-			Gfx.Device->CopyDescriptorsSimple(1, TableBaseCPU, Root.PrefilteredEnvMapSRV, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-			TableBaseCPU.Offset(Gfx.DescriptorSize);
-
-			Gfx.Device->CopyDescriptorsSimple(1, TableBaseCPU, Root.BRDFIntegrationMapSRV, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-			TableBaseCPU.Offset(Gfx.DescriptorSize);
-
-			CmdList->SetGraphicsRootDescriptorTable(1, TableBaseGPU);
+			CPUAddress->PrefilteredEnvMapSlot = GetDescriptorSlot(Root.PrefilteredEnvMapDescriptor);
+			CPUAddress->BRDFIntegrationMapSlot = GetDescriptorSlot(Root.BRDFIntegrationMapDescriptor);
 		}
 
-		const auto NumMeshInstances = (uint32_t)Root.StaticMeshInstances.size();
-
-		D3D12_GPU_VIRTUAL_ADDRESS GPUAddress;
-		auto* CPUAddress = (FPerDrawConstantData*)AllocateGPUMemory(Gfx, NumMeshInstances * sizeof(FPerDrawConstantData), GPUAddress);
-
-		const XMMATRIX WorldToClip = ViewTransform * ProjectionTransform;
+		const uint32_t NumMeshInstances = Root.NumVisibleInstances;
+
+		// LOD selection, cluster culling and instance data of all visible instances on the worker threads (see StaticScene.h),
+		// then a draw per mesh LOD, or per instance with cluster culling, recorded by jobs to command lists of their own or
+		// submitted with one ExecuteIndirect().
+		FStaticDrawView View;
+		XMStoreFloat4x4(&View.WorldToClip, WorldToClip);
+		View.CameraPosition = Root.CameraPosition;
+		View.MaxLODErrorAtUnitDistance = Root.MaxLODError * 2.0f * tanf(0.5f * FovY) / Gfx.Resolution[1];
+		View.bCullClusters = Root.bClusterCulling;
+		const double StartTime = GetTime();
+		SelectStaticDrawLODs(Root.Jobs, Root.StaticScene, View, Root.VisibleInstances.data(), NumMeshInstances, Root.StaticDrawList);
+
+		// Visible clusters are compacted into this frame's upload memory, sized for the selected LODs.
+		const uint32_t CulledIBSize = Root.StaticDrawList.MaxCulledIndexCount * Root.StaticScene.IndexSize;
+		View.bCullClusters = View.bCullClusters && CulledIBSize > 0;
+		FUploadAllocation CulledIB = {};
+		if (View.bCullClusters)
+		{
+			AllocateUploadMemory(Gfx, CulledIBSize, CulledIB);
+			State.IBView.BufferLocation = CulledIB.GPUAddress;
+			State.IBView.SizeInBytes = CulledIBSize;
+		}
 
-		for (uint32_t MeshInstIdx = 0; MeshInstIdx < NumMeshInstances; ++MeshInstIdx)
+		FUploadAllocation InstanceData = {};
+		if (NumMeshInstances > 0)
 		{
-			const FStaticMeshInstance& MeshInst = Root.StaticMeshInstances[MeshInstIdx];
-			const FStaticMesh& Mesh = Root.StaticMeshes[MeshInst.MeshIndex];
+			AllocateUploadMemory(Gfx, NumMeshInstances * sizeof(FStaticInstanceData), InstanceData);
+		}
+		RecordStaticDrawBatches(Root.Jobs, Root.StaticScene, View, Root.VisibleInstances.data(), NumMeshInstances, CulledIB.CPUAddress,
+			(FStaticInstanceData*)InstanceData.CPUAddress, Root.StaticDrawList);
 
-			const XMMATRIX ObjectToWorld =
-				XMMatrixRotationRollPitchYaw(MeshInst.Rotation.x, MeshInst.Rotation.y, MeshInst.Rotation.z) *
-				XMMatrixTranslation(MeshInst.Position.x, MeshInst.Position.y, MeshInst.Position.z);
+		State.Instances = InstanceData.GPUAddress;
 
-			XMStoreFloat4x4(&CPUAddress->ObjectToClip, XMMatrixTranspose(ObjectToWorld * WorldToClip));
+		const FStaticDrawBatch* Batches = Root.StaticDrawList.Batches.data();
+		const auto NumBatches = (uint32_t)Root.StaticDrawList.Batches.size();
+		Root.NumStaticDrawCmdLists = 0;
+		if (Root.bIndirectStaticDraws && NumBatches >= STATIC_DRAW_INDIRECT_MIN_BATCHES)
+		{
+			// The batches are the arguments of the command signature as they are.
+			FUploadAllocation Arguments;
+			AllocateUploadMemory(Gfx, NumBatches * sizeof(FStaticDrawBatch), Arguments);
+			memcpy(Arguments.CPUAddress, Batches, NumBatches * sizeof(FStaticDrawBatch));
+			SetStaticDrawState(Root, State, CmdList);
+			CmdList->ExecuteIndirect(Root.StaticDrawSignature, NumBatches, (ID3D12Resource*)Arguments.Resource, Arguments.Offset, nullptr, 0);
+			CmdList->IASetIndexBuffer(&Root.StaticIBView);
+		}
+		else
+		{
+			Root.NumStaticDrawCmdLists = GetNumStaticDrawCommandLists(NumBatches, XMMin(GetNumThreads(Root.Jobs), (uint32_t)MAX_JOB_COMMAND_LISTS));
+			if (Root.NumStaticDrawCmdLists == 1)
 			{
-				const XMMATRIX ObjectToWorldT = XMMatrixTranspose(ObjectToWorld);
-				XMStoreFloat4((XMFLOAT4*)& CPUAddress->ObjectToWorld, ObjectToWorldT.r[0]);
-				XMStoreFloat4((XMFLOAT4*)& CPUAddress->ObjectToWorld + 1, ObjectToWorldT.r[1]);
-				XMStoreFloat4((XMFLOAT4*)& CPUAddress->ObjectToWorld + 2, ObjectToWorldT.r[2]);
+				SetStaticDrawState(Root, State, CmdList);
+				DrawStaticBatches(Batches, 0, NumBatches, CmdList);
+				CmdList->IASetIndexBuffer(&Root.StaticIBView);
+			}
+			else
+			{
+				// A list per job, executed in order after the commands so far, and the rest of the frame in the list after them.
+				const uint32_t NumLists = Root.NumStaticDrawCmdLists;
+				BeginJobCommandLists(Gfx, NumLists);
+				ParallelFor(Root.Jobs, NumLists, 1, [&](uint32_t Begin, uint32_t End)
+				{
+					for (uint32_t ListIdx = Begin; ListIdx < End; ++ListIdx)
+					{
+						ID3D12GraphicsCommandList2* JobCmdList = GetJobCommandList(Gfx, ListIdx);
+						SetDrawTargetState(Root, JobCmdList);
+						SetStaticDrawState(Root, State, JobCmdList);
+						DrawStaticBatches(Batches, GetStaticDrawCommandListBegin(NumBatches, NumLists, ListIdx),
+							GetStaticDrawCommandListBegin(NumBatches, NumLists, ListIdx + 1), JobCmdList);
+					}
+				});
+				CmdList = Gfx.CmdList;
+				SetDrawTargetState(Root, CmdList);
 			}
-
-			CPUAddress->Albedo = XMFLOAT3(0.5f, 0.0f, 0.0f);
-			CPUAddress->Metallic = MeshInst.Metallic;
-			CPUAddress->Roughness = MeshInst.Roughness;
-			CPUAddress->AO = 1.0f;
-
-			CmdList->SetGraphicsRootConstantBufferView(0, GPUAddress);
-			CmdList->DrawIndexedInstanced(Mesh.IndexCount, 1, Mesh.StartIndexLocation, Mesh.BaseVertexLocation, 0);
-
-			GPUAddress += sizeof(FPerDrawConstantData);
-			CPUAddress++;
 		}
+		Root.StaticDrawTime = GetTime() - StartTime;
+		Root.ClusterCullStats = Root.StaticDrawList.Stats.ClusterCullStats;
+		Root.NumDrawnTriangles[0] = Root.StaticDrawList.Stats.NumTriangles;
+		Root.NumDrawnTriangles[1] = Root.StaticScene.NumInstanceTriangles;
 	}
 
 	// Draw EnvMap.
@@ -218,11 +479,14 @@ static void Draw(FDemoRoot& Root)
 		const XMMATRIX ObjectToClip = ViewTransformOrigin * ProjectionTransform;
 		XMStoreFloat4x4(&CPUAddress->ObjectToClip, XMMatrixTranspose(ObjectToClip));
 
-		const FStaticMesh& Mesh = Root.StaticMeshes[MESH_Cube];
+		const FStaticMesh& Mesh = Root.StaticScene.Meshes[MESH_Cube];
+		CPUAddress->PositionScale = Mesh.PositionScale;
+		CPUAddress->PositionBias = Mesh.PositionBias;
 
 		CmdList->SetGraphicsRootConstantBufferView(0, GPUAddress);
-		CmdList->SetGraphicsRootDescriptorTable(1, CopyDescriptorsToGPUHeap(Gfx, 1, Root.EnvMapSRV));
-		CmdList->DrawIndexedInstanced(Mesh.IndexCount, 1, Mesh.StartIndexLocation, Mesh.BaseVertexLocation, 0);
+		CmdList->SetGraphicsRoot32BitConstant(1, GetDescriptorSlot(Root.EnvMapDescriptor), 0);
+		CmdList->SetGraphicsRootDescriptorTable(2, Gfx.PersistentDescriptorHeap.GPUStart);
+		CmdList->DrawIndexedInstanced(Mesh.LODs[0].IndexCount, 1, Mesh.LODs[0].StartIndexLocation, Mesh.BaseVertexLocation, 0);
 	}
 
 	DrawUI(Gfx, Root.UI);
@@ -247,9 +511,7 @@ static void Draw(FDemoRoot& Root)
 		CmdList->ResourceBarrier((UINT)eastl::size(Barriers), Barriers);
 	}
 
-	CmdList->Close();
-
-	Gfx.CmdQueue->ExecuteCommandLists(1, CommandListCast(&CmdList));
+	ExecuteFrameCommandLists(Gfx);
 }
 
 static void AddGraphicsPipeline(FGraphicsContext& Gfx, D3D12_GRAPHICS_PIPELINE_STATE_DESC& PSODesc, const char* VSName, const char* PSName, eastl::vector<ID3D12PipelineState*>& OutPipelines, eastl::vector<ID3D12RootSignature*>& OutSignatures)
@@ -295,18 +557,41 @@ static void AddComputePipeline(FGraphicsContext& Gfx, const char* CSName, eastl:
 	OutSignatures.push_back(RootSignature);
 }
 
-static void CreatePipelines(FGraphicsContext& Gfx, uint32_t NumSamples, eastl::vector<ID3D12PipelineState*>& OutPipelines, eastl::vector<ID3D12RootSignature*>& OutSignatures)
+// Input layout that fetches the attributes in AttributeMask (a subset of Layout's) from the static geometry buffers.
+static D3D12_INPUT_LAYOUT_DESC GetInputLayout(const FVertexLayout& Layout, uint32_t AttributeMask, D3D12_INPUT_ELEMENT_DESC OutElements[VERTEX_ATTRIBUTE_Count])
 {
-	const D3D12_INPUT_ELEMENT_DESC InPositionNormal[] =
+	static const DXGI_FORMAT Formats[VERTEX_ATTRIBUTE_Count] =
 	{
-		{ "_Position", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "_Normal", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		DXGI_FORMAT_R16G16B16A16_UNORM, DXGI_FORMAT_R16G16_SNORM, DXGI_FORMAT_R8G8B8A8_SNORM, DXGI_FORMAT_R16G16_FLOAT, DXGI_FORMAT_R8G8B8A8_UNORM,
 	};
+	EA_ASSERT((AttributeMask & ~Layout.AttributeMask) == 0);
+
+	uint32_t NumElements = 0;
+	for (uint32_t Attribute = 0; Attribute < VERTEX_ATTRIBUTE_Count; ++Attribute)
+	{
+		if (AttributeMask & VERTEX_ATTRIBUTE_BIT(Attribute))
+		{
+			const FVertexElement& Element = Layout.Elements[Attribute];
+			OutElements[NumElements++] = { GetVertexAttributeName(Attribute), 0, Formats[Attribute], Element.Stream, Element.Offset, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 };
+		}
+	}
+	return { OutElements, NumElements };
+}
+
+static void CreatePipelines(FGraphicsContext& Gfx, const FVertexLayout& Layout, uint32_t NumSamples, eastl::vector<ID3D12PipelineState*>& OutPipelines,
+	eastl::vector<ID3D12RootSignature*>& OutSignatures)
+{
+	// Passes that only need positions fetch stream 0 alone.
+	D3D12_INPUT_ELEMENT_DESC InPosition[VERTEX_ATTRIBUTE_Count];
+	D3D12_INPUT_ELEMENT_DESC InPositionNormalColor[VERTEX_ATTRIBUTE_Count];
+	const D3D12_INPUT_LAYOUT_DESC PositionLayout = GetInputLayout(Layout, VERTEX_ATTRIBUTE_BIT(VERTEX_ATTRIBUTE_Position), InPosition);
+	const D3D12_INPUT_LAYOUT_DESC PositionNormalColorLayout = GetInputLayout(Layout, VERTEX_ATTRIBUTE_BIT(VERTEX_ATTRIBUTE_Position) |
+		VERTEX_ATTRIBUTE_BIT(VERTEX_ATTRIBUTE_Normal) | VERTEX_ATTRIBUTE_BIT(VERTEX_ATTRIBUTE_Color), InPositionNormalColor);
 
 	// Test pipeline.
 	{
 		D3D12_GRAPHICS_PIPELINE_STATE_DESC PSODesc = {};
-		PSODesc.InputLayout = { InPositionNormal, (UINT)eastl::size(InPositionNormal) };
+		PSODesc.InputLayout = PositionLayout;
 		PSODesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
 		PSODesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
 		PSODesc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
@@ -322,7 +607,7 @@ static void CreatePipelines(FGraphicsContext& Gfx, uint32_t NumSamples, eastl::v
 	// SimpleForward pipeline.
 	{
 		D3D12_GRAPHICS_PIPELINE_STATE_DESC PSODesc = {};
-		PSODesc.InputLayout = { InPositionNormal, (UINT)eastl::size(InPositionNormal) };
+		PSODesc.InputLayout = PositionNormalColorLayout;
 		PSODesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
 		PSODesc.RasterizerState.CullMode = D3D12_CULL_MODE_BACK;
 		PSODesc.RasterizerState.MultisampleEnable = NumSamples > 1 ? TRUE : FALSE;
@@ -340,7 +625,7 @@ static void CreatePipelines(FGraphicsContext& Gfx, uint32_t NumSamples, eastl::v
 	// EnvMap pipeline.
 	{
 		D3D12_GRAPHICS_PIPELINE_STATE_DESC PSODesc = {};
-		PSODesc.InputLayout = { InPositionNormal, (UINT)eastl::size(InPositionNormal) };
+		PSODesc.InputLayout = PositionLayout;
 		PSODesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
 		PSODesc.RasterizerState.CullMode = D3D12_CULL_MODE_BACK;
 		PSODesc.RasterizerState.MultisampleEnable = NumSamples > 1 ? TRUE : FALSE;
@@ -357,10 +642,10 @@ static void CreatePipelines(FGraphicsContext& Gfx, uint32_t NumSamples, eastl::v
 		EA_ASSERT(OutPipelines.size() == PSO_SampleEnvMap);
 		AddGraphicsPipeline(Gfx, PSODesc, "SampleEnvMap.vs.cso", "SampleEnvMap.ps.cso", OutPipelines, OutSignatures);
 	}
-	// EquirectangularToCube, GenerateIrradianceMap, PrefilterEnvMap pipelines.
+	// EquirectangularToCube pipeline.
 	{
 		D3D12_GRAPHICS_PIPELINE_STATE_DESC PSODesc = {};
-		PSODesc.InputLayout = { InPositionNormal, (UINT)eastl::size(InPositionNormal) };
+		PSODesc.InputLayout = PositionLayout;
 		PSODesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
 		PSODesc.RasterizerState.CullMode = D3D12_CULL_MODE_BACK;
 		PSODesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
@@ -374,87 +659,111 @@ static void CreatePipelines(FGraphicsContext& Gfx, uint32_t NumSamples, eastl::v
 
 		EA_ASSERT(OutPipelines.size() == PSO_EquirectangularToCube);
 		AddGraphicsPipeline(Gfx, PSODesc, "EquirectangularToCube.vs.cso", "EquirectangularToCube.ps.cso", OutPipelines, OutSignatures);
-
-		EA_ASSERT(OutPipelines.size() == PSO_GenerateIrradianceMap);
-		AddGraphicsPipeline(Gfx, PSODesc, "GenerateIrradianceMap.vs.cso", "GenerateIrradianceMap.ps.cso", OutPipelines, OutSignatures);
-
+	}
+	// PrefilterEnvMap pipeline.
+	{
 		EA_ASSERT(OutPipelines.size() == PSO_PrefilterEnvMap);
-		AddGraphicsPipeline(Gfx, PSODesc, "PrefilterEnvMap.vs.cso", "PrefilterEnvMap.ps.cso", OutPipelines, OutSignatures);
+		AddComputePipeline(Gfx, "PrefilterEnvMap.cs.cso", OutPipelines, OutSignatures);
 	}
-
-	EA_ASSERT(OutPipelines.size() == PSO_GenerateBRDFIntegrationMap);
-	AddComputePipeline(Gfx, "GenerateBRDFIntegrationMap.cs.cso", OutPipelines, OutSignatures);
 }
 
-static void CreateEnvMap(FGraphicsContext& Gfx, const FStaticMesh& Cube, ID3D12Resource*& OutEnvMap, D3D12_CPU_DESCRIPTOR_HANDLE& OutEnvMapSRV, eastl::vector<ID3D12Resource*>& OutTempResources)
+static void CreateCubeMapSRV(FGraphicsContext& Gfx, ID3D12Resource* Texture, D3D12_CPU_DESCRIPTOR_HANDLE SRV)
 {
-	int Width, Height;
-	D3D12_SUBRESOURCE_DATA ImageData = {};
-	stbi_set_flip_vertically_on_load(1);
-	ImageData.pData = stbi_loadf("Data/Textures/Newport_Loft.hdr", &Width, &Height, nullptr, 3);
-	stbi_set_flip_vertically_on_load(0);
-	ImageData.RowPitch = Width * sizeof(XMFLOAT3);
-	EA_ASSERT(ImageData.pData);
+	D3D12_SHADER_RESOURCE_VIEW_DESC SRVDesc = {};
+	SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
+	SRVDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	SRVDesc.TextureCube.MipLevels = (uint32_t)-1;
+	Gfx.Device->CreateShaderResourceView(Texture, &SRVDesc, SRV);
+}
 
-	ID3D12Resource* TempHDRRectTexture;
-	D3D12_CPU_DESCRIPTOR_HANDLE TempHDRRectTextureSRV = AllocateDescriptors(Gfx, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
+// Decodes the .hdr file and creates all resources, EnvMap starts in the COPY_DEST state. Only uses the device (and the job
+// system), so it can run on a worker thread.
+static bool CreateEnvMapSource(FGraphicsContext& Gfx, FJobSystem& Jobs, const char* FileName, FEnvMapSource& OutSource, ID3D12Resource*& OutEnvMap)
+{
+	// The .hdr file is decoded straight into the staging buffer as RGB9E5 (exact for RGBE data, 4 bytes per texel and
+	// filterable on all hardware).
+	FMappedFile File;
+	FHDRDesc HDRDesc;
+	if (!OpenMappedFile(FileName, File))
 	{
-		const auto Desc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R32G32B32_FLOAT, Width, Height, 1, 1);
-		VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &Desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&TempHDRRectTexture)));
-		OutTempResources.push_back(TempHDRRectTexture);
-
-		Gfx.Device->CreateShaderResourceView(TempHDRRectTexture, nullptr, TempHDRRectTextureSRV);
+		return false;
+	}
+	if (!ParseHDRHeader(File.Data, File.Size, HDRDesc))
+	{
+		CloseMappedFile(File);
+		return false;
 	}
 
-	ID3D12Resource* StagingBuffer;
+	OutSource = {};
 	{
-		const auto BufferDesc = CD3DX12_RESOURCE_DESC::Buffer(GetRequiredIntermediateSize(TempHDRRectTexture, 0, 1));
-		VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE, &BufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&StagingBuffer)));
-		OutTempResources.push_back(StagingBuffer);
+		const auto Desc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R9G9B9E5_SHAREDEXP, HDRDesc.Width, HDRDesc.Height, 1, 1);
+		VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &Desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&OutSource.HDRRectTexture)));
 	}
+	{
+		const D3D12_RESOURCE_DESC TextureDesc = OutSource.HDRRectTexture->GetDesc();
+		uint64_t BufferSize;
+		Gfx.Device->GetCopyableFootprints(&TextureDesc, 0, 1, 0, &OutSource.StagingLayout, nullptr, nullptr, &BufferSize);
 
-	const uint32_t CubeMapResolution = 512;
-	ID3D12Resource* TempCubeMap;
-	const D3D12_CPU_DESCRIPTOR_HANDLE TempCubeMapRTVs = AllocateDescriptors(Gfx, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, 6);
+		const auto BufferDesc = CD3DX12_RESOURCE_DESC::Buffer(BufferSize);
+		VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE, &BufferDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&OutSource.StagingBuffer)));
+	}
 	{
-		auto Desc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R16G16B16A16_FLOAT, CubeMapResolution, CubeMapResolution, 6);
+		auto Desc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R16G16B16A16_FLOAT, ENV_MAP_RESOLUTION, ENV_MAP_RESOLUTION, 6);
 		VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &Desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&OutEnvMap)));
 
-		OutEnvMapSRV = AllocateDescriptors(Gfx, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
+		Desc.Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+		VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &Desc, D3D12_RESOURCE_STATE_RENDER_TARGET, nullptr, IID_PPV_ARGS(&OutSource.TempCubeMap)));
+	}
 
-		D3D12_SHADER_RESOURCE_VIEW_DESC SRVDesc = {};
-		SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
-		SRVDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-		SRVDesc.TextureCube.MipLevels = (uint32_t)-1;
-		Gfx.Device->CreateShaderResourceView(OutEnvMap, &SRVDesc, OutEnvMapSRV);
+	uint8_t* StagingData;
+	VHR(OutSource.StagingBuffer->Map(0, &CD3DX12_RANGE(0, 0), (void**)&StagingData));
+	// Flipped (V == 0 is the bottom row) as EquirectangularToCube.hlsl expects.
+	const bool bIsDecoded = DecodeHDR(Jobs, File.Data, File.Size, HDRDesc, DDS_FORMAT_R9G9B9E5_SHAREDEXP, true, StagingData + OutSource.StagingLayout.Offset, OutSource.StagingLayout.Footprint.RowPitch);
+	OutSource.StagingBuffer->Unmap(0, nullptr);
+	CloseMappedFile(File);
 
+	return bIsDecoded;
+}
 
-		Desc.Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
-		VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &Desc, D3D12_RESOURCE_STATE_RENDER_TARGET, nullptr, IID_PPV_ARGS(&TempCubeMap)));
-		OutTempResources.push_back(TempCubeMap);
+static void ReleaseEnvMapSource(FEnvMapSource& Source)
+{
+	SAFE_RELEASE(Source.HDRRectTexture);
+	SAFE_RELEASE(Source.StagingBuffer);
+	SAFE_RELEASE(Source.TempCubeMap);
+}
 
-		D3D12_CPU_DESCRIPTOR_HANDLE CPUHandle = TempCubeMapRTVs;
+// HDRRectTextureSRV is one descriptor, TempCubeMapRTVs are six (one per face).
+static void CreateEnvMapSourceViews(FGraphicsContext& Gfx, const FEnvMapSource& Source, D3D12_CPU_DESCRIPTOR_HANDLE HDRRectTextureSRV, D3D12_CPU_DESCRIPTOR_HANDLE TempCubeMapRTVs)
+{
+	Gfx.Device->CreateShaderResourceView(Source.HDRRectTexture, nullptr, HDRRectTextureSRV);
 
-		for (uint32_t Idx = 0; Idx < 6; ++Idx)
-		{
-			D3D12_RENDER_TARGET_VIEW_DESC RTVDesc = {};
-			RTVDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2DARRAY;
-			RTVDesc.Texture2DArray.ArraySize = 1;
-			RTVDesc.Texture2DArray.FirstArraySlice = Idx;
-			Gfx.Device->CreateRenderTargetView(TempCubeMap, &RTVDesc, CPUHandle);
+	for (uint32_t Idx = 0; Idx < 6; ++Idx)
+	{
+		D3D12_RENDER_TARGET_VIEW_DESC RTVDesc = {};
+		RTVDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2DARRAY;
+		RTVDesc.Texture2DArray.ArraySize = 1;
+		RTVDesc.Texture2DArray.FirstArraySlice = Idx;
+		Gfx.Device->CreateRenderTargetView(Source.TempCubeMap, &RTVDesc, TempCubeMapRTVs);
 
-			CPUHandle.ptr += Gfx.DescriptorSizeRTV;
-		}
+		TempCubeMapRTVs.ptr += Gfx.DescriptorSizeRTV;
 	}
+}
 
-	ID3D12GraphicsCommandList2* CmdList = Gfx.CmdList;
-
-	UpdateSubresources<1>(CmdList, TempHDRRectTexture, StagingBuffer, 0, 0, 1, &ImageData);
-
-	stbi_image_free((void*)ImageData.pData);
+static void UploadEnvMapSource(FGraphicsContext& Gfx, const FEnvMapSource& Source)
+{
+	const auto Dest = CD3DX12_TEXTURE_COPY_LOCATION(Source.HDRRectTexture, 0);
+	const auto Src = CD3DX12_TEXTURE_COPY_LOCATION(Source.StagingBuffer, Source.StagingLayout);
+	Gfx.CmdList->CopyTextureRegion(&Dest, 0, 0, 0, &Src, nullptr);
 
-	CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(TempHDRRectTexture, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+	Gfx.CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(Source.HDRRectTexture, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+}
 
+// Renders faces [FirstFace, FirstFace + NumFaces) of the TempCubeMap, PSO_EquirectangularToCube must be set.
+static void DrawEnvMapFaces(FGraphicsContext& Gfx, const FStaticMesh& Cube, D3D12_CPU_DESCRIPTOR_HANDLE HDRRectTextureSRV, D3D12_CPU_DESCRIPTOR_HANDLE TempCubeMapRTVs, uint32_t FirstFace, uint32_t NumFaces)
+{
+	EA_ASSERT(FirstFace + NumFaces <= 6);
+	const uint32_t CubeMapResolution = ENV_MAP_RESOLUTION;
+	ID3D12GraphicsCommandList2* CmdList = Gfx.CmdList;
 
 	CmdList->RSSetViewports(1, &CD3DX12_VIEWPORT(0.0f, 0.0f, (float)CubeMapResolution, (float)CubeMapResolution));
 	CmdList->RSSetScissorRects(1, &CD3DX12_RECT(0, 0, CubeMapResolution, CubeMapResolution));
@@ -475,374 +784,864 @@ static void CreateEnvMap(FGraphicsContext& Gfx, const FStaticMesh& Cube, ID3D12R
 
 
 	D3D12_GPU_VIRTUAL_ADDRESS GPUAddress;
-	auto* CPUAddress = (FPerDrawConstantData*)AllocateGPUMemory(Gfx, 6 * sizeof(FPerDrawConstantData), GPUAddress);
+	auto* CPUAddress = (FPerDrawConstantData*)AllocateGPUMemory(Gfx, NumFaces * sizeof(FPerDrawConstantData), GPUAddress);
 
+	const D3D12_GPU_DESCRIPTOR_HANDLE HDRRectTextureTable = CopyDescriptorsToGPUHeap(Gfx, 1, HDRRectTextureSRV);
 	D3D12_CPU_DESCRIPTOR_HANDLE RTV = TempCubeMapRTVs;
+	RTV.ptr += FirstFace * (size_t)Gfx.DescriptorSizeRTV;
 
-	for (uint32_t Idx = 0; Idx < 6; ++Idx)
+	for (uint32_t Idx = FirstFace; Idx < FirstFace + NumFaces; ++Idx)
 	{
 		CmdList->OMSetRenderTargets(1, &RTV, TRUE, nullptr);
 
 		const XMMATRIX ObjectToClip = ViewTransforms[Idx] * ProjectionTransform;
 		XMStoreFloat4x4(&CPUAddress->ObjectToClip, XMMatrixTranspose(ObjectToClip));
+		CPUAddress->PositionScale = Cube.PositionScale;
+		CPUAddress->PositionBias = Cube.PositionBias;
 
 		CmdList->SetGraphicsRootConstantBufferView(0, GPUAddress);
-		CmdList->SetGraphicsRootDescriptorTable(1, CopyDescriptorsToGPUHeap(Gfx, 1, TempHDRRectTextureSRV));
-		CmdList->DrawIndexedInstanced(Cube.IndexCount, 1, Cube.StartIndexLocation, Cube.BaseVertexLocation, 0);
+		CmdList->SetGraphicsRootDescriptorTable(1, HDRRectTextureTable);
+		CmdList->DrawIndexedInstanced(Cube.LODs[0].IndexCount, 1, Cube.LODs[0].StartIndexLocation, Cube.BaseVertexLocation, 0);
 
 		RTV.ptr += Gfx.DescriptorSizeRTV;
 		GPUAddress += sizeof(FPerDrawConstantData);
 		CPUAddress++;
 	}
+}
 
-	CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(TempCubeMap, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COPY_SOURCE));
+// Copies the rendered faces to the EnvMap (COPY_DEST), which ends up in the PIXEL_SHADER_RESOURCE state.
+static void FinishEnvMap(FGraphicsContext& Gfx, const FEnvMapSource& Source, ID3D12Resource* EnvMap)
+{
+	Gfx.CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(Source.TempCubeMap, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COPY_SOURCE));
 
-	CmdList->CopyResource(OutEnvMap, TempCubeMap);
+	Gfx.CmdList->CopyResource(EnvMap, Source.TempCubeMap);
 
-	Gfx.CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(OutEnvMap, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+	Gfx.CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(EnvMap, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
 }
 
-static void CreateIrradianceMap(FGraphicsContext& Gfx, D3D12_CPU_DESCRIPTOR_HANDLE EnvMapSRV, const FStaticMesh& Cube, ID3D12Resource*& OutIrradianceMap, D3D12_CPU_DESCRIPTOR_HANDLE& OutIrradianceMapSRV, eastl::vector<ID3D12Resource*>& OutTempResources)
+static void CreateEnvMap(FGraphicsContext& Gfx, FJobSystem& Jobs, const FStaticMesh& Cube, ID3D12Resource*& OutEnvMap, D3D12_CPU_DESCRIPTOR_HANDLE& OutEnvMapSRV, eastl::vector<ID3D12Resource*>& OutTempResources)
 {
-	const uint32_t CubeMapResolution = 64;
-	ID3D12Resource* TempCubeMap;
-	const D3D12_CPU_DESCRIPTOR_HANDLE TempCubeMapRTVs = AllocateDescriptors(Gfx, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, 6);
+	FEnvMapSource Source;
+	if (!CreateEnvMapSource(Gfx, Jobs, ENV_MAP_FILE_NAME, Source, OutEnvMap))
 	{
-		auto Desc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R16G16B16A16_FLOAT, CubeMapResolution, CubeMapResolution, 6);
-		VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &Desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&OutIrradianceMap)));
+		EA_ASSERT(0);
+	}
+	OutTempResources.push_back(Source.HDRRectTexture);
+	OutTempResources.push_back(Source.StagingBuffer);
+	OutTempResources.push_back(Source.TempCubeMap);
 
-		OutIrradianceMapSRV = AllocateDescriptors(Gfx, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
+	OutEnvMapSRV = AllocateDescriptors(Gfx, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
+	CreateCubeMapSRV(Gfx, OutEnvMap, OutEnvMapSRV);
 
-		D3D12_SHADER_RESOURCE_VIEW_DESC SRVDesc = {};
-		SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
-		SRVDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-		SRVDesc.TextureCube.MipLevels = (uint32_t)-1;
-		Gfx.Device->CreateShaderResourceView(OutIrradianceMap, &SRVDesc, OutIrradianceMapSRV);
+	const D3D12_CPU_DESCRIPTOR_HANDLE HDRRectTextureSRV = AllocateDescriptors(Gfx, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
+	const D3D12_CPU_DESCRIPTOR_HANDLE TempCubeMapRTVs = AllocateDescriptors(Gfx, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, 6);
+	CreateEnvMapSourceViews(Gfx, Source, HDRRectTextureSRV, TempCubeMapRTVs);
 
+	UploadEnvMapSource(Gfx, Source);
+	DrawEnvMapFaces(Gfx, Cube, HDRRectTextureSRV, TempCubeMapRTVs, 0, 6);
+	FinishEnvMap(Gfx, Source, OutEnvMap);
+}
 
-		Desc.Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
-		VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &Desc, D3D12_RESOURCE_STATE_RENDER_TARGET, nullptr, IID_PPV_ARGS(&TempCubeMap)));
-		OutTempResources.push_back(TempCubeMap);
+// Starts in the UNORDERED_ACCESS state. Only uses the device, so it can run on a worker thread.
+static void CreatePrefilteredEnvMapTexture(FGraphicsContext& Gfx, ID3D12Resource*& OutPrefilteredEnvMap)
+{
+	static_assert(PREFILTERED_ENV_MAP_NUM_MIP_LEVELS <= PREFILTER_ENV_MAP_MAX_MIP_LEVELS, "Too many prefiltered env. map mips.");
 
-		D3D12_CPU_DESCRIPTOR_HANDLE CPUHandle = TempCubeMapRTVs;
+	auto Desc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R16G16B16A16_FLOAT, PREFILTERED_ENV_MAP_RESOLUTION, PREFILTERED_ENV_MAP_RESOLUTION, 6, PREFILTERED_ENV_MAP_NUM_MIP_LEVELS);
+	Desc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+	VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &Desc, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, nullptr, IID_PPV_ARGS(&OutPrefilteredEnvMap)));
+}
 
-		for (uint32_t Idx = 0; Idx < 6; ++Idx)
-		{
-			D3D12_RENDER_TARGET_VIEW_DESC RTVDesc = {};
-			RTVDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2DARRAY;
-			RTVDesc.Texture2DArray.ArraySize = 1;
-			RTVDesc.Texture2DArray.FirstArraySlice = Idx;
-			Gfx.Device->CreateRenderTargetView(TempCubeMap, &RTVDesc, CPUHandle);
+// Every mip is written directly through its own UAV (all 6 faces), unused UAV slots of MipUAVs
+// (PREFILTER_ENV_MAP_MAX_MIP_LEVELS descriptors) get null descriptors.
+static void CreatePrefilteredEnvMapViews(FGraphicsContext& Gfx, ID3D12Resource* PrefilteredEnvMap, D3D12_CPU_DESCRIPTOR_HANDLE SRV, D3D12_CPU_DESCRIPTOR_HANDLE MipUAVs)
+{
+	const uint32_t NumMipLevelsUsed = PREFILTERED_ENV_MAP_NUM_MIP_LEVELS;
 
-			CPUHandle.ptr += Gfx.DescriptorSizeRTV;
-		}
+	CreateCubeMapSRV(Gfx, PrefilteredEnvMap, SRV);
+
+	for (uint32_t MipSliceIdx = 0; MipSliceIdx < PREFILTER_ENV_MAP_MAX_MIP_LEVELS; ++MipSliceIdx)
+	{
+		D3D12_UNORDERED_ACCESS_VIEW_DESC UAVDesc = {};
+		UAVDesc.Format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+		UAVDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2DARRAY;
+		UAVDesc.Texture2DArray.MipSlice = MipSliceIdx < NumMipLevelsUsed ? MipSliceIdx : 0;
+		UAVDesc.Texture2DArray.ArraySize = 6;
+		Gfx.Device->CreateUnorderedAccessView(MipSliceIdx < NumMipLevelsUsed ? PrefilteredEnvMap : nullptr, nullptr, &UAVDesc, MipUAVs);
+
+		MipUAVs.ptr += Gfx.DescriptorSize;
+	}
+}
+
+// Prefilters tiles [FirstTile, FirstTile + NumTiles) of all faces, PSO_PrefilterEnvMap must be set. See PrefilterEnvMap.hlsl.
+static void DispatchPrefilterEnvMap(FGraphicsContext& Gfx, D3D12_CPU_DESCRIPTOR_HANDLE EnvMapSRV, D3D12_CPU_DESCRIPTOR_HANDLE MipUAVs, uint32_t FirstTile, uint32_t NumTiles)
+{
+	static_assert(sizeof(FPrefilterEnvMapConstants) == 12 * sizeof(uint32_t), "Must match the root constants of PrefilterEnvMap.hlsl.");
+	FPrefilterEnvMapConstants Constants = {};
+	Constants.Resolution = PREFILTERED_ENV_MAP_RESOLUTION;
+	Constants.NumMipLevels = PREFILTERED_ENV_MAP_NUM_MIP_LEVELS;
+	Constants.FirstTile = FirstTile;
+	for (uint32_t MipSliceIdx = 0; MipSliceIdx < PREFILTERED_ENV_MAP_NUM_MIP_LEVELS; ++MipSliceIdx)
+	{
+		(&Constants.NumSamples[MipSliceIdx / 4].x)[MipSliceIdx % 4] = GetPrefilterNumSamples(MipSliceIdx);
 	}
 
 	ID3D12GraphicsCommandList2* CmdList = Gfx.CmdList;
 
-	CmdList->RSSetViewports(1, &CD3DX12_VIEWPORT(0.0f, 0.0f, (float)CubeMapResolution, (float)CubeMapResolution));
-	CmdList->RSSetScissorRects(1, &CD3DX12_RECT(0, 0, CubeMapResolution, CubeMapResolution));
+	// Descriptor table: EnvMap SRV followed by the mip UAVs.
+	const D3D12_GPU_DESCRIPTOR_HANDLE GPUHandle = CopyDescriptorsToGPUHeap(Gfx, 1, EnvMapSRV);
+	CopyDescriptorsToGPUHeap(Gfx, PREFILTER_ENV_MAP_MAX_MIP_LEVELS, MipUAVs);
 
-	CmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	CmdList->SetComputeRoot32BitConstants(0, sizeof(Constants) / 4, &Constants, 0);
+	CmdList->SetComputeRootDescriptorTable(1, GPUHandle);
+	CmdList->Dispatch(NumTiles, 6, 1);
+}
 
+// EnvMap is in the PIXEL_SHADER_RESOURCE state and gets back to it.
+static void CreatePrefilteredEnvMap(FGraphicsContext& Gfx, ID3D12Resource* EnvMap, D3D12_CPU_DESCRIPTOR_HANDLE EnvMapSRV, ID3D12Resource*& OutPrefilteredEnvMap,
+	D3D12_CPU_DESCRIPTOR_HANDLE& OutPrefilteredEnvMapSRV)
+{
+	CreatePrefilteredEnvMapTexture(Gfx, OutPrefilteredEnvMap);
 
-	const XMMATRIX ViewTransforms[6] =
+	OutPrefilteredEnvMapSRV = AllocateDescriptors(Gfx, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
+	const D3D12_CPU_DESCRIPTOR_HANDLE MipUAVs = AllocateDescriptors(Gfx, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, PREFILTER_ENV_MAP_MAX_MIP_LEVELS);
+	CreatePrefilteredEnvMapViews(Gfx, OutPrefilteredEnvMap, OutPrefilteredEnvMapSRV, MipUAVs);
+
+	// One dispatch for all faces and mips, the compute shader reads EnvMap.
+	Gfx.CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(EnvMap, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
+	DispatchPrefilterEnvMap(Gfx, EnvMapSRV, MipUAVs, 0, GetPrefilterEnvMapNumTiles(PREFILTERED_ENV_MAP_RESOLUTION, PREFILTERED_ENV_MAP_NUM_MIP_LEVELS));
+
+	const D3D12_RESOURCE_BARRIER Barriers[] =
 	{
-		XMMatrixLookToLH(XMVectorZero(), XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
-		XMMatrixLookToLH(XMVectorZero(), XMVectorSet(-1.0f, 0.0f, 0.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
-		XMMatrixLookToLH(XMVectorZero(), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f), XMVectorSet(0.0f, 0.0f, -1.0f, 0.0f)),
-		XMMatrixLookToLH(XMVectorZero(), XMVectorSet(0.0f, -1.0f, 0.0f, 0.0f), XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f)),
-		XMMatrixLookToLH(XMVectorZero(), XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
-		XMMatrixLookToLH(XMVectorZero(), XMVectorSet(0.0f, 0.0f, -1.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
+		CD3DX12_RESOURCE_BARRIER::Transition(EnvMap, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE),
+		CD3DX12_RESOURCE_BARRIER::Transition(OutPrefilteredEnvMap, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE),
 	};
-	const XMMATRIX ProjectionTransform = XMMatrixPerspectiveFovLH(XM_PIDIV2, 1.0f, 0.1f, 10.0f);
-
+	Gfx.CmdList->ResourceBarrier((UINT)eastl::size(Barriers), Barriers);
+}
 
-	D3D12_GPU_VIRTUAL_ADDRESS GPUAddress;
-	auto* CPUAddress = (FPerDrawConstantData*)AllocateGPUMemory(Gfx, 6 * sizeof(FPerDrawConstantData), GPUAddress);
+// Starts in the COPY_DEST state.
+static void CreateDDSTexture(FGraphicsContext& Gfx, const FDDSDesc& Desc, ID3D12Resource*& OutTexture)
+{
+	const uint32_t ArraySize = Desc.bIsCubeMap ? 6 * Desc.ArraySize : Desc.ArraySize;
+	const auto TextureDesc = CD3DX12_RESOURCE_DESC::Tex2D((DXGI_FORMAT)Desc.Format, Desc.Width, Desc.Height, (UINT16)ArraySize, (UINT16)Desc.NumMipLevels);
+	VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &TextureDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&OutTexture)));
+}
 
-	D3D12_CPU_DESCRIPTOR_HANDLE RTV = TempCubeMapRTVs;
+static void GetDDSDesc(ID3D12Resource* Texture, FDDSDesc& OutDesc)
+{
+	const D3D12_RESOURCE_DESC Desc = Texture->GetDesc();
+	OutDesc = {};
+	OutDesc.Format = (uint32_t)Desc.Format;
+	OutDesc.Width = (uint32_t)Desc.Width;
+	OutDesc.Height = Desc.Height;
+	OutDesc.bIsCubeMap = Desc.DepthOrArraySize == 6;
+	OutDesc.ArraySize = OutDesc.bIsCubeMap ? 1 : Desc.DepthOrArraySize;
+	OutDesc.NumMipLevels = Desc.MipLevels;
+}
 
-	for (uint32_t Idx = 0; Idx < 6; ++Idx)
-	{
-		CmdList->OMSetRenderTargets(1, &RTV, TRUE, nullptr);
+static void CreateTextureFromDDS(FGraphicsContext& Gfx, const FDDSDesc& Desc, const uint8_t* Pixels, ID3D12Resource*& OutTexture, D3D12_CPU_DESCRIPTOR_HANDLE& OutTextureSRV, eastl::vector<ID3D12Resource*>& OutTempResources)
+{
+	CreateDDSTexture(Gfx, Desc, OutTexture);
 
-		const XMMATRIX ObjectToClip = ViewTransforms[Idx] * ProjectionTransform;
-		XMStoreFloat4x4(&CPUAddress->ObjectToClip, XMMatrixTranspose(ObjectToClip));
+	UploadTextureData(Gfx, OutTexture, Pixels, OutTempResources);
+	Gfx.CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(OutTexture, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
 
-		CmdList->SetGraphicsRootConstantBufferView(0, GPUAddress);
-		CmdList->SetGraphicsRootDescriptorTable(1, CopyDescriptorsToGPUHeap(Gfx, 1, EnvMapSRV));
-		CmdList->DrawIndexedInstanced(Cube.IndexCount, 1, Cube.StartIndexLocation, Cube.BaseVertexLocation, 0);
+	OutTextureSRV = AllocateDescriptors(Gfx, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
 
-		RTV.ptr += Gfx.DescriptorSizeRTV;
-		GPUAddress += sizeof(FPerDrawConstantData);
-		CPUAddress++;
+	if (Desc.bIsCubeMap)
+	{
+		CreateCubeMapSRV(Gfx, OutTexture, OutTextureSRV);
 	}
+	else
+	{
+		Gfx.Device->CreateShaderResourceView(OutTexture, nullptr, OutTextureSRV);
+	}
+}
 
-	CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(TempCubeMap, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COPY_SOURCE));
-
-	CmdList->CopyResource(OutIrradianceMap, TempCubeMap);
+// The BRDF integration map does not depend on the environment, it is embedded in the executable (regenerate
+// BRDFIntegrationMapData.h with "IBLBaker brdf-lut") and only has to be uploaded.
+static void CreateBRDFIntegrationMap(FGraphicsContext& Gfx, ID3D12Resource*& OutBRDFIntegrationMap, D3D12_CPU_DESCRIPTOR_HANDLE& OutBRDFIntegrationMapSRV, eastl::vector<ID3D12Resource*>& OutTempResources)
+{
+	FDDSDesc Desc = {};
+	Desc.Format = BRDF_INTEGRATION_MAP_FORMAT;
+	Desc.Width = BRDF_INTEGRATION_MAP_RESOLUTION;
+	Desc.Height = BRDF_INTEGRATION_MAP_RESOLUTION;
+	Desc.ArraySize = 1;
+	Desc.NumMipLevels = 1;
+	EA_ASSERT(GetDDSDataSize(Desc) == sizeof(GBRDFIntegrationMapData));
+
+	CreateTextureFromDDS(Gfx, Desc, (const uint8_t*)GBRDFIntegrationMapData, OutBRDFIntegrationMap, OutBRDFIntegrationMapSRV, OutTempResources);
+}
 
-	Gfx.CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(OutIrradianceMap, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+static bool GetIBLCacheKey(const char* EnvMapFileName, FIBLCacheKey& OutKey)
+{
+	OutKey = {};
+	if (!ComputeFileHash(EnvMapFileName, OutKey.SourceHash))
+	{
+		return false;
+	}
+	OutKey.EnvMapResolution = ENV_MAP_RESOLUTION;
+	OutKey.EnvMapFilter = EQUIRECT_FILTER_Bilinear;
+	OutKey.PrefilteredEnvMapResolution = PREFILTERED_ENV_MAP_RESOLUTION;
+	OutKey.PrefilteredEnvMapNumMipLevels = PREFILTERED_ENV_MAP_NUM_MIP_LEVELS;
+	static_assert(PREFILTERED_ENV_MAP_NUM_MIP_LEVELS <= IBL_MAX_PREFILTERED_MIP_LEVELS, "Too many prefiltered env. map mips.");
+	for (uint32_t Mip = 0; Mip < PREFILTERED_ENV_MAP_NUM_MIP_LEVELS; ++Mip)
+	{
+		OutKey.PrefilteredEnvMapNumSamples[Mip] = GetPrefilterNumSamples(Mip);
+	}
+	OutKey.PrefilterMode = PREFILTER_MODE_Filtered;
+	OutKey.ShaderVersion = IBL_CACHE_SHADER_VERSION;
+	return true;
 }
 
-static void CreatePrefilteredEnvMap(FGraphicsContext& Gfx, D3D12_CPU_DESCRIPTOR_HANDLE EnvMapSRV, const FStaticMesh& Cube, ID3D12Resource*& OutPrefilteredEnvMap, D3D12_CPU_DESCRIPTOR_HANDLE& OutPrefilteredEnvMapSRV, eastl::vector<ID3D12Resource*>& OutTempResources)
+static void CreateIBLTexturesFromCache(FDemoRoot& Root, const FIBLCacheEntry& Entry, eastl::vector<ID3D12Resource*>& OutTempResources)
 {
-	const uint32_t CubeMapResolution = 256;
-	const uint32_t NumMipLevelsUsed = 6; // 256, 128, 64, 32, 16, 8
+	ID3D12Resource** Textures[IBL_TEXTURE_Count] = { &Root.EnvMap, &Root.PrefilteredEnvMap };
+	D3D12_CPU_DESCRIPTOR_HANDLE* SRVs[IBL_TEXTURE_Count] = { &Root.EnvMapSRV, &Root.PrefilteredEnvMapSRV };
 
-	ID3D12Resource* TempCubeMap;
-	const D3D12_CPU_DESCRIPTOR_HANDLE TempCubeMapRTVs = AllocateDescriptors(Gfx, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, 6 * NumMipLevelsUsed);
+	for (uint32_t Texture = 0; Texture < IBL_TEXTURE_Count; ++Texture)
 	{
-		auto Desc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R16G16B16A16_FLOAT, CubeMapResolution, CubeMapResolution, 6, NumMipLevelsUsed);
-		VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &Desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&OutPrefilteredEnvMap)));
+		CreateTextureFromDDS(Root.Gfx, Entry.Descs[Texture], Entry.Pixels[Texture], *Textures[Texture], *SRVs[Texture], OutTempResources);
+	}
+}
 
-		OutPrefilteredEnvMapSRV = AllocateDescriptors(Gfx, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
+// Reads the generated IBL textures back from the GPU (tightly packed, D3D12 subresource order).
+static void ReadbackIBLTextures(FDemoRoot& Root, FDDSDesc OutDescs[IBL_TEXTURE_Count], eastl::vector<uint8_t> OutData[IBL_TEXTURE_Count])
+{
+	FGraphicsContext& Gfx = Root.Gfx;
+	ID3D12Resource* Textures[IBL_TEXTURE_Count] = { Root.EnvMap, Root.PrefilteredEnvMap };
+	ID3D12Resource* ReadbackBuffers[IBL_TEXTURE_Count];
 
-		D3D12_SHADER_RESOURCE_VIEW_DESC SRVDesc = {};
-		SRVDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
-		SRVDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-		SRVDesc.TextureCube.MipLevels = NumMipLevelsUsed;
-		Gfx.Device->CreateShaderResourceView(OutPrefilteredEnvMap, &SRVDesc, OutPrefilteredEnvMapSRV);
+	ID3D12GraphicsCommandList2* CmdList = GetAndInitCommandList(Gfx);
+	for (uint32_t Texture = 0; Texture < IBL_TEXTURE_Count; ++Texture)
+	{
+		CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(Textures[Texture], D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_SOURCE));
+		ReadbackBuffers[Texture] = CopyTextureToReadbackBuffer(Gfx, Textures[Texture]);
+		CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(Textures[Texture], D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+	}
+	CmdList->Close();
+	Gfx.CmdQueue->ExecuteCommandLists(1, CommandListCast(&CmdList));
+	WaitForGPU(Gfx);
 
+	for (uint32_t Texture = 0; Texture < IBL_TEXTURE_Count; ++Texture)
+	{
+		ReadbackTextureData(Gfx, Textures[Texture], ReadbackBuffers[Texture], OutData[Texture]);
+		GetDDSDesc(Textures[Texture], OutDescs[Texture]);
+	}
+}
 
-		Desc.Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
-		VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &Desc, D3D12_RESOURCE_STATE_RENDER_TARGET, nullptr, IID_PPV_ARGS(&TempCubeMap)));
-		OutTempResources.push_back(TempCubeMap);
+// Stores the read back IBL textures in the cache, so the next run skips the precompute passes.
+static void SaveIBLTexturesToCache(const FIBLCacheKey& Key, const FDDSDesc Descs[IBL_TEXTURE_Count], const eastl::vector<uint8_t> Data[IBL_TEXTURE_Count])
+{
+	const void* DataPointers[IBL_TEXTURE_Count];
+	for (uint32_t Texture = 0; Texture < IBL_TEXTURE_Count; ++Texture)
+	{
+		DataPointers[Texture] = Data[Texture].data();
+	}
+	SaveIBLCacheEntry(IBL_CACHE_DIRECTORY, Key, Descs, DataPointers);
+}
 
-		D3D12_CPU_DESCRIPTOR_HANDLE CPUHandle = TempCubeMapRTVs;
+// Projects the EnvMap mip closest to IRRADIANCE_SH_PROJECTION_RESOLUTION (RGBA16F, D3D12 subresource order) to SH and
+// convolves it to irradiance. Cheap enough to run on every load or environment change.
+static void ComputeIrradianceSH(const FDDSDesc& EnvMapDesc, const uint8_t* EnvMapPixels, XMFLOAT4 OutIrradianceSH[SH_NUM_COEFFICIENTS])
+{
+	EA_ASSERT(EnvMapDesc.bIsCubeMap && EnvMapDesc.Format == DDS_FORMAT_R16G16B16A16_FLOAT);
+
+	uint32_t Mip = 0;
+	while (Mip + 1 < EnvMapDesc.NumMipLevels && (EnvMapDesc.Width >> Mip) > IRRADIANCE_SH_PROJECTION_RESOLUTION)
+	{
+		++Mip;
+	}
+	const uint32_t BytesPerPixel = GetDDSBytesPerPixel(EnvMapDesc.Format);
 
-		for (uint32_t MipSliceIdx = 0; MipSliceIdx < NumMipLevelsUsed; ++MipSliceIdx)
+	const void* Faces[6];
+	const uint8_t* FaceData = EnvMapPixels;
+	for (uint32_t Face = 0; Face < 6; ++Face)
+	{
+		for (uint32_t MipIdx = 0; MipIdx < EnvMapDesc.NumMipLevels; ++MipIdx)
 		{
-			for (uint32_t ArraySliceIdx = 0; ArraySliceIdx < 6; ++ArraySliceIdx)
+			const uint32_t Resolution = XMMax(EnvMapDesc.Width >> MipIdx, 1u);
+			if (MipIdx == Mip)
 			{
-				D3D12_RENDER_TARGET_VIEW_DESC RTVDesc = {};
-				RTVDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2DARRAY;
-				RTVDesc.Texture2DArray.ArraySize = 1;
-				RTVDesc.Texture2DArray.FirstArraySlice = ArraySliceIdx;
-				RTVDesc.Texture2DArray.MipSlice = MipSliceIdx;
-				Gfx.Device->CreateRenderTargetView(TempCubeMap, &RTVDesc, CPUHandle);
-
-				CPUHandle.ptr += Gfx.DescriptorSizeRTV;
+				Faces[Face] = FaceData;
 			}
+			FaceData += Resolution * Resolution * BytesPerPixel;
 		}
 	}
 
-	const XMMATRIX ViewTransforms[6] =
+	FSH9Color RadianceSH, IrradianceSH;
+	ProjectCubeMapToSH(Faces, XMMax(EnvMapDesc.Width >> Mip, 1u), SH_TEXEL_FORMAT_RGBA16F, RadianceSH);
+	ConvolveSHWithCosineLobe(RadianceSH, IrradianceSH);
+	GetSHShaderConstants(IrradianceSH, OutIrradianceSH);
+}
+
+static void CreateEnvMapRebake(FGraphicsContext& Gfx, FEnvMapRebake& Out)
+{
+	for (uint32_t Idx = 0; Idx < 2; ++Idx)
 	{
-		XMMatrixLookToLH(XMVectorZero(), XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
-		XMMatrixLookToLH(XMVectorZero(), XMVectorSet(-1.0f, 0.0f, 0.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
-		XMMatrixLookToLH(XMVectorZero(), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f), XMVectorSet(0.0f, 0.0f, -1.0f, 0.0f)),
-		XMMatrixLookToLH(XMVectorZero(), XMVectorSet(0.0f, -1.0f, 0.0f, 0.0f), XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f)),
-		XMMatrixLookToLH(XMVectorZero(), XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
-		XMMatrixLookToLH(XMVectorZero(), XMVectorSet(0.0f, 0.0f, -1.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)),
-	};
-	const XMMATRIX ProjectionTransform = XMMatrixPerspectiveFovLH(XM_PIDIV2, 1.0f, 0.1f, 10.0f);
+		VHR(Gfx.Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&Out.CmdAlloc[Idx])));
+	}
+	VHR(Gfx.Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, Out.CmdAlloc[0], nullptr, IID_PPV_ARGS(&Out.CmdList)));
+	Out.CmdList->Close();
 
-	D3D12_GPU_VIRTUAL_ADDRESS GPUAddress;
-	auto* CPUAddress = (FPerDrawConstantData*)AllocateGPUMemory(Gfx, 6 * NumMipLevelsUsed * sizeof(FPerDrawConstantData), GPUAddress);
+	CreateMipmapGenerator(Gfx, DXGI_FORMAT_R16G16B16A16_FLOAT, Out.MipmapGenerator);
 
-	ID3D12GraphicsCommandList2* CmdList = Gfx.CmdList;
+	// Views of the new textures are written to these descriptors, they are reused by every change.
+	for (uint32_t Texture = 0; Texture < IBL_TEXTURE_Count; ++Texture)
+	{
+		Out.SRVs[Texture] = AllocateDescriptors(Gfx, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
+	}
+	Out.HDRRectTextureSRV = AllocateDescriptors(Gfx, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
+	Out.TempCubeMapRTVs = AllocateDescriptors(Gfx, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, 6);
+	Out.PrefilteredEnvMapUAVs = AllocateDescriptors(Gfx, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, PREFILTER_ENV_MAP_MAX_MIP_LEVELS);
+}
 
-	CmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+static void ReleaseEnvMapRebakeResources(FEnvMapRebake& Rebake)
+{
+	ReleaseEnvMapSource(Rebake.Source);
+	for (uint32_t Texture = 0; Texture < IBL_TEXTURE_Count; ++Texture)
+	{
+		SAFE_RELEASE(Rebake.Textures[Texture]);
+		SAFE_RELEASE(Rebake.UploadBuffers[Texture]);
+		SAFE_RELEASE(Rebake.ReadbackBuffers[Texture]);
+	}
+}
 
-	uint32_t CurrentResolution = CubeMapResolution;
-	D3D12_CPU_DESCRIPTOR_HANDLE RTV = TempCubeMapRTVs;
+// The GPU must be idle.
+static void DestroyEnvMapRebake(FJobSystem& Jobs, FEnvMapRebake& Rebake)
+{
+	WaitForCounter(Jobs, Rebake.JobCounter);
+	ReleaseEnvMapRebakeResources(Rebake);
+	DestroyMipmapGenerator(Rebake.MipmapGenerator);
+	SAFE_RELEASE(Rebake.CmdList);
+	for (uint32_t Idx = 0; Idx < 2; ++Idx)
+	{
+		SAFE_RELEASE(Rebake.CmdAlloc[Idx]);
+	}
+}
+
+// Everything that is slow on the CPU: hashing the file, reading the cache entry or decoding the .hdr file, and
+// creating the resources (device calls are free-threaded).
+static void LoadEnvMapJob(void* Context, uint32_t, uint32_t)
+{
+	FDemoRoot& Root = *(FDemoRoot*)Context;
+	FEnvMapRebake& Rebake = Root.EnvMapRebake;
+	FGraphicsContext& Gfx = Root.Gfx;
 
-	for (uint32_t MipSliceIdx = 0; MipSliceIdx < NumMipLevelsUsed; ++MipSliceIdx)
+	Rebake.bHasSucceeded = false;
+	if (!GetIBLCacheKey(Rebake.FileName, Rebake.Key))
 	{
-		CmdList->RSSetViewports(1, &CD3DX12_VIEWPORT(0.0f, 0.0f, (float)CurrentResolution, (float)CurrentResolution));
-		CmdList->RSSetScissorRects(1, &CD3DX12_RECT(0, 0, CurrentResolution, CurrentResolution));
+		return;
+	}
 
-		for (uint32_t ArraySliceIdx = 0; ArraySliceIdx < 6; ++ArraySliceIdx)
+	FIBLCacheEntry Entry;
+	Rebake.bIsCacheHit = OpenIBLCacheEntry(IBL_CACHE_DIRECTORY, Rebake.Key, Entry);
+	if (Rebake.bIsCacheHit)
+	{
+		for (uint32_t Texture = 0; Texture < IBL_TEXTURE_Count; ++Texture)
 		{
-			CmdList->OMSetRenderTargets(1, &RTV, TRUE, nullptr);
-
-			const XMMATRIX ObjectToClip = ViewTransforms[ArraySliceIdx] * ProjectionTransform;
-			XMStoreFloat4x4(&CPUAddress->ObjectToClip, XMMatrixTranspose(ObjectToClip));
-			CPUAddress->Roughness = (float)MipSliceIdx / (NumMipLevelsUsed - 1);
+			CreateDDSTexture(Gfx, Entry.Descs[Texture], Rebake.Textures[Texture]);
+			Rebake.UploadBuffers[Texture] = CreateTextureUploadBuffer(Gfx, Rebake.Textures[Texture], Entry.Pixels[Texture]);
+		}
+		ComputeIrradianceSH(Entry.Descs[IBL_TEXTURE_EnvMap], Entry.Pixels[IBL_TEXTURE_EnvMap], Rebake.IrradianceSH);
+		CloseIBLCacheEntry(Entry);
+		Rebake.bHasSucceeded = true;
+	}
+	else if (CreateEnvMapSource(Gfx, Root.Jobs, Rebake.FileName, Rebake.Source, Rebake.Textures[IBL_TEXTURE_EnvMap]))
+	{
+		CreatePrefilteredEnvMapTexture(Gfx, Rebake.Textures[IBL_TEXTURE_PrefilteredEnvMap]);
+		Rebake.bHasSucceeded = true;
+	}
+}
 
-			CmdList->SetGraphicsRootConstantBufferView(0, GPUAddress);
-			CmdList->SetGraphicsRootDescriptorTable(1, CopyDescriptorsToGPUHeap(Gfx, 1, EnvMapSRV));
-			CmdList->DrawIndexedInstanced(Cube.IndexCount, 1, Cube.StartIndexLocation, Cube.BaseVertexLocation, 0);
+static void ReadbackEnvMapJob(void* Context, uint32_t, uint32_t)
+{
+	FDemoRoot& Root = *(FDemoRoot*)Context;
+	FEnvMapRebake& Rebake = Root.EnvMapRebake;
 
-			RTV.ptr += Gfx.DescriptorSizeRTV;
-			GPUAddress += sizeof(FPerDrawConstantData);
-			CPUAddress++;
-		}
+	FDDSDesc Descs[IBL_TEXTURE_Count];
+	eastl::vector<uint8_t> Data[IBL_TEXTURE_Count];
+	for (uint32_t Texture = 0; Texture < IBL_TEXTURE_Count; ++Texture)
+	{
+		ReadbackTextureData(Root.Gfx, Rebake.Textures[Texture], Rebake.ReadbackBuffers[Texture], Data[Texture]);
+		GetDDSDesc(Rebake.Textures[Texture], Descs[Texture]);
+	}
+	ComputeIrradianceSH(Descs[IBL_TEXTURE_EnvMap], Data[IBL_TEXTURE_EnvMap].data(), Rebake.IrradianceSH);
+	SaveIBLTexturesToCache(Rebake.Key, Descs, Data);
+	Rebake.bHasSucceeded = true;
+}
 
-		CurrentResolution /= 2;
+// Starts an environment change, the current IBL textures are used until the new ones are complete. Returns false when
+// a change is already in progress.
+static bool LoadEnvMap(FDemoRoot& Root, const char* FileName)
+{
+	FEnvMapRebake& Rebake = Root.EnvMapRebake;
+	if (Rebake.State != REBAKE_Idle)
+	{
+		return false;
 	}
+	EA::StdC::Strlcpy(Rebake.FileName, FileName, sizeof(Rebake.FileName));
+	Rebake.MaxStepTime = 0.0;
+	Rebake.State = REBAKE_Loading;
+	SubmitJob(Root.Jobs, &LoadEnvMapJob, &Root, 0, 1, Rebake.JobCounter);
+	return true;
+}
 
-	CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(TempCubeMap, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COPY_SOURCE));
+// Number of prefilter tiles starting at FirstTile that fit in ENV_MAP_REBAKE_PREFILTER_SAMPLES_PER_FRAME (at least one).
+static uint32_t GetPrefilterTilesPerFrame(uint32_t FirstTile)
+{
+	uint32_t Tile = 0;
+	uint32_t NumTiles = 0;
+	uint64_t NumSamples = 0;
+	for (uint32_t Mip = 0; Mip < PREFILTERED_ENV_MAP_NUM_MIP_LEVELS; ++Mip)
+	{
+		const uint32_t TilesPerRow = ((PREFILTERED_ENV_MAP_RESOLUTION >> Mip) + PREFILTER_ENV_MAP_TILE_SIZE - 1) / PREFILTER_ENV_MAP_TILE_SIZE;
+		const uint64_t TileNumSamples = 6ull * PREFILTER_ENV_MAP_TILE_SIZE * PREFILTER_ENV_MAP_TILE_SIZE * GetPrefilterNumSamples(Mip);
 
-	CmdList->CopyResource(OutPrefilteredEnvMap, TempCubeMap);
+		for (uint32_t Idx = 0; Idx < TilesPerRow * TilesPerRow; ++Idx, ++Tile)
+		{
+			if (Tile < FirstTile)
+			{
+				continue;
+			}
+			if (NumTiles > 0 && NumSamples + TileNumSamples > ENV_MAP_REBAKE_PREFILTER_SAMPLES_PER_FRAME)
+			{
+				return NumTiles;
+			}
+			NumSamples += TileNumSamples;
+			NumTiles += 1;
+		}
+	}
+	return NumTiles;
+}
 
-	Gfx.CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(OutPrefilteredEnvMap, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+// Replaces the IBL textures, SRVs and SH used by Draw(). The replaced textures are released by the REBAKE_Retire state.
+static void SwapEnvMap(FDemoRoot& Root)
+{
+	FEnvMapRebake& Rebake = Root.EnvMapRebake;
+
+	eastl::swap(Root.EnvMap, Rebake.Textures[IBL_TEXTURE_EnvMap]);
+	eastl::swap(Root.PrefilteredEnvMap, Rebake.Textures[IBL_TEXTURE_PrefilteredEnvMap]);
+	eastl::swap(Root.EnvMapSRV, Rebake.SRVs[IBL_TEXTURE_EnvMap]);
+	eastl::swap(Root.PrefilteredEnvMapSRV, Rebake.SRVs[IBL_TEXTURE_PrefilteredEnvMap]);
+	// Frames recorded so far keep reading the replaced descriptors, their slots are reused when the GPU is done.
+	ReleasePersistentDescriptor(Root.Gfx, Root.EnvMapDescriptor);
+	ReleasePersistentDescriptor(Root.Gfx, Root.PrefilteredEnvMapDescriptor);
+	Root.EnvMapDescriptor = CreatePersistentDescriptor(Root.Gfx, Root.EnvMapSRV);
+	Root.PrefilteredEnvMapDescriptor = CreatePersistentDescriptor(Root.Gfx, Root.PrefilteredEnvMapSRV);
+	memcpy(Root.IrradianceSH, Rebake.IrradianceSH, sizeof(Root.IrradianceSH));
+	EA::StdC::Strlcpy(Root.EnvMapFileName, Rebake.FileName, sizeof(Root.EnvMapFileName));
+
+	// Frames (and rebake commands) recorded so far may still use the replaced textures and the temporary resources.
+	Rebake.FenceValue = Root.Gfx.FrameCount + 1;
+	Rebake.State = REBAKE_Retire;
 }
 
-static void CreateBRDFIntegrationMap(FGraphicsContext& Gfx, ID3D12Resource*& OutBRDFIntegrationMap, D3D12_CPU_DESCRIPTOR_HANDLE& OutBRDFIntegrationMapSRV, eastl::vector<ID3D12Resource*>& OutTempResources)
+// Advances the environment change started by LoadEnvMap() by one step. GPU work is recorded to the rebake command list
+// in slices (ENV_MAP_REBAKE_FACES_PER_FRAME, ENV_MAP_REBAKE_PREFILTER_SAMPLES_PER_FRAME, one cube face of the cached
+// textures, one readback copy) and executed before the frame's command list, so the textures are complete when the
+// frame that first uses them runs. Must be called before the frame is recorded.
+static void UpdateEnvMapRebake(FDemoRoot& Root)
 {
-	const uint32_t MapResolution = 512;
-	EA_ASSERT(EA::StdC::IsPowerOf2(MapResolution));
+	FGraphicsContext& Gfx = Root.Gfx;
+	FEnvMapRebake& Rebake = Root.EnvMapRebake;
+
+	if (Rebake.State == REBAKE_Idle)
+	{
+		return;
+	}
+	const double StartTime = GetTime();
 
-	ID3D12Resource* TempTexture;
-	const D3D12_CPU_DESCRIPTOR_HANDLE TempTextureUAV = AllocateDescriptors(Gfx, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
+	if (Rebake.State == REBAKE_Loading || Rebake.State == REBAKE_Readback)
+	{
+		if (Root.Jobs.NumWorkers == 0)
+		{
+			// Nobody else will run the job.
+			WaitForCounter(Root.Jobs, Rebake.JobCounter);
+		}
+		if (Rebake.JobCounter.NumPending.GetValue() > 0)
+		{
+			return;
+		}
+		if (!Rebake.bHasSucceeded)
+		{
+			ReleaseEnvMapRebakeResources(Rebake);
+			Rebake.State = REBAKE_Idle;
+			return;
+		}
+		if (Rebake.State == REBAKE_Readback)
+		{
+			SwapEnvMap(Root);
+			return;
+		}
+	}
+	else if (Rebake.State == REBAKE_WaitForGPU || Rebake.State == REBAKE_Retire)
 	{
-		auto Desc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R16G16_FLOAT, MapResolution, MapResolution, 1, 1);
-		VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &Desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&OutBRDFIntegrationMap)));
+		if (Gfx.FrameFence->GetCompletedValue() < Rebake.FenceValue)
+		{
+			return;
+		}
+		if (Rebake.State == REBAKE_WaitForGPU)
+		{
+			Rebake.bHasSucceeded = false;
+			Rebake.State = REBAKE_Readback;
+			SubmitJob(Root.Jobs, &ReadbackEnvMapJob, &Root, 0, 1, Rebake.JobCounter);
+		}
+		else
+		{
+			ReleaseEnvMapRebakeResources(Rebake);
+			Rebake.State = REBAKE_Idle;
+		}
+		return;
+	}
 
-		OutBRDFIntegrationMapSRV = AllocateDescriptors(Gfx, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
+	ID3D12CommandAllocator* CmdAlloc = Rebake.CmdAlloc[Gfx.FrameIndex];
+	CmdAlloc->Reset();
+	Rebake.CmdList->Reset(CmdAlloc, nullptr);
+	Rebake.CmdList->SetDescriptorHeaps(1, &Gfx.GPUDescriptorHeaps[Gfx.FrameIndex].Heap);
 
-		Gfx.Device->CreateShaderResourceView(OutBRDFIntegrationMap, nullptr, OutBRDFIntegrationMapSRV);
+	// Library functions record to Gfx.CmdList.
+	ID3D12GraphicsCommandList2* FrameCmdList = Gfx.CmdList;
+	Gfx.CmdList = Rebake.CmdList;
+	ID3D12GraphicsCommandList2* CmdList = Rebake.CmdList;
 
+	ID3D12Resource* EnvMap = Rebake.Textures[IBL_TEXTURE_EnvMap];
+	ID3D12Resource* PrefilteredEnvMap = Rebake.Textures[IBL_TEXTURE_PrefilteredEnvMap];
 
-		Desc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
-		VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &Desc, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, nullptr, IID_PPV_ARGS(&TempTexture)));
-		OutTempResources.push_back(TempTexture);
+	if (Rebake.State == REBAKE_Loading)
+	{
+		if (Rebake.bIsCacheHit)
+		{
+			for (uint32_t Texture = 0; Texture < IBL_TEXTURE_Count; ++Texture)
+			{
+				CreateCubeMapSRV(Gfx, Rebake.Textures[Texture], Rebake.SRVs[Texture]);
+			}
+			Rebake.State = REBAKE_UploadFaces;
+		}
+		else
+		{
+			CreateCubeMapSRV(Gfx, EnvMap, Rebake.SRVs[IBL_TEXTURE_EnvMap]);
+			CreateEnvMapSourceViews(Gfx, Rebake.Source, Rebake.HDRRectTextureSRV, Rebake.TempCubeMapRTVs);
+			CreatePrefilteredEnvMapViews(Gfx, PrefilteredEnvMap, Rebake.SRVs[IBL_TEXTURE_PrefilteredEnvMap], Rebake.PrefilteredEnvMapUAVs);
 
-		Gfx.Device->CreateUnorderedAccessView(TempTexture, nullptr, nullptr, TempTextureUAV);
+			UploadEnvMapSource(Gfx, Rebake.Source);
+			Rebake.State = REBAKE_DrawEnvMapFaces;
+		}
+		Rebake.NextFace = 0;
+	}
+	else if (Rebake.State == REBAKE_UploadFaces)
+	{
+		// Subresources of a face (all its mips) are consecutive.
+		for (uint32_t Texture = 0; Texture < IBL_TEXTURE_Count; ++Texture)
+		{
+			const uint32_t NumMipLevels = Rebake.Textures[Texture]->GetDesc().MipLevels;
+			CopyUploadBufferToTexture(Gfx, Rebake.UploadBuffers[Texture], Rebake.Textures[Texture], Rebake.NextFace * NumMipLevels, NumMipLevels);
+		}
+		if (++Rebake.NextFace == 6)
+		{
+			const D3D12_RESOURCE_BARRIER Barriers[2] =
+			{
+				CD3DX12_RESOURCE_BARRIER::Transition(EnvMap, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE),
+				CD3DX12_RESOURCE_BARRIER::Transition(PrefilteredEnvMap, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE),
+			};
+			CmdList->ResourceBarrier((UINT)eastl::size(Barriers), Barriers);
+			// SH were computed from the cache entry.
+			SwapEnvMap(Root);
+		}
 	}
+	else if (Rebake.State == REBAKE_DrawEnvMapFaces)
+	{
+		const uint32_t NumFaces = XMMin(6u - Rebake.NextFace, (uint32_t)ENV_MAP_REBAKE_FACES_PER_FRAME);
 
-	ID3D12GraphicsCommandList2* CmdList = Gfx.CmdList;
+		// Input assembler state is not inherited from the frame's command list.
+		CmdList->IASetVertexBuffers(0, VERTEX_MAX_STREAMS, Root.StaticVBViews);
+		CmdList->IASetIndexBuffer(&Root.StaticIBView);
+		CmdList->SetPipelineState(Root.Pipelines[PSO_EquirectangularToCube]);
+		CmdList->SetGraphicsRootSignature(Root.RootSignatures[PSO_EquirectangularToCube]);
+		DrawEnvMapFaces(Gfx, Root.StaticScene.Meshes[MESH_Cube], Rebake.HDRRectTextureSRV, Rebake.TempCubeMapRTVs, Rebake.NextFace, NumFaces);
 
+		Rebake.NextFace += NumFaces;
+		if (Rebake.NextFace == 6)
+		{
+			FinishEnvMap(Gfx, Rebake.Source, EnvMap);
+			// PrefilterEnvMap.hlsl reads the whole mip chain (filtered importance sampling).
+			GenerateMipmaps(Gfx, Rebake.MipmapGenerator, EnvMap);
+			// Read by the compute shader of the prefilter slices until the last one.
+			CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(EnvMap, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
+			Rebake.NextTile = 0;
+			Rebake.State = REBAKE_PrefilterEnvMap;
+		}
+	}
+	else if (Rebake.State == REBAKE_PrefilterEnvMap)
+	{
+		const uint32_t NumTiles = GetPrefilterTilesPerFrame(Rebake.NextTile);
 
-	CmdList->SetComputeRootDescriptorTable(0, CopyDescriptorsToGPUHeap(Gfx, 1, TempTextureUAV));
-	CmdList->Dispatch(MapResolution / 8, MapResolution / 8, 1);
+		CmdList->SetPipelineState(Root.Pipelines[PSO_PrefilterEnvMap]);
+		CmdList->SetComputeRootSignature(Root.RootSignatures[PSO_PrefilterEnvMap]);
+		DispatchPrefilterEnvMap(Gfx, Rebake.SRVs[IBL_TEXTURE_EnvMap], Rebake.PrefilteredEnvMapUAVs, Rebake.NextTile, NumTiles);
+
+		Rebake.NextTile += NumTiles;
+		if (Rebake.NextTile == GetPrefilterEnvMapNumTiles(PREFILTERED_ENV_MAP_RESOLUTION, PREFILTERED_ENV_MAP_NUM_MIP_LEVELS))
+		{
+			const D3D12_RESOURCE_BARRIER Barriers[] =
+			{
+				CD3DX12_RESOURCE_BARRIER::Transition(EnvMap, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE),
+				CD3DX12_RESOURCE_BARRIER::Transition(PrefilteredEnvMap, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE),
+			};
+			CmdList->ResourceBarrier((UINT)eastl::size(Barriers), Barriers);
+			Rebake.NextTexture = 0;
+			Rebake.State = REBAKE_CopyToReadback;
+		}
+	}
+	else if (Rebake.State == REBAKE_CopyToReadback)
+	{
+		// One texture per frame, the SH projection and the cache need both.
+		ID3D12Resource* Texture = Rebake.Textures[Rebake.NextTexture];
+		CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(Texture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_SOURCE));
+		Rebake.ReadbackBuffers[Rebake.NextTexture] = CopyTextureToReadbackBuffer(Gfx, Texture);
+		CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(Texture, D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
 
+		if (++Rebake.NextTexture == IBL_TEXTURE_Count)
+		{
+			// Signaled by PresentFrame() of this frame.
+			Rebake.FenceValue = Gfx.FrameCount + 1;
+			Rebake.State = REBAKE_WaitForGPU;
+		}
+	}
 
-	CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(TempTexture, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_COPY_SOURCE));
+	CmdList->Close();
+	Gfx.CmdQueue->ExecuteCommandLists(1, CommandListCast(&CmdList));
+	Gfx.CmdList = FrameCmdList;
 
-	CmdList->CopyResource(OutBRDFIntegrationMap, TempTexture);
+	Rebake.MaxStepTime = XMMax(Rebake.MaxStepTime, GetTime() - StartTime);
+}
 
-	Gfx.CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(OutBRDFIntegrationMap, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+// Rebuilds the index over the static instances whenever instances are added or removed.
+static void BuildStaticInstanceBVH(FDemoRoot& Root)
+{
+	BuildStaticSceneBVH(Root.StaticScene);
+	Root.VisibleInstances.resize(Root.StaticScene.Instances.size());
 }
 
-static void LoadGLTFMesh(const char* FileName, FMesh& OutMesh, eastl::vector<FVertex>& InOutVertices, eastl::vector<uint32_t>& InOutIndices)
+// Creates a static geometry buffer (COPY_DEST) that holds Capacity elements, the replaced buffer (if any) keeps the first
+// NumUsed of them and is retired.
+static void ResizeStaticBuffer(FDemoRoot& Root, ID3D12Resource*& InOutBuffer, uint32_t Stride, uint32_t NumUsed, uint32_t Capacity)
 {
-	cgltf_options Options = {};
-	cgltf_data* Data = nullptr;
+	FGraphicsContext& Gfx = Root.Gfx;
+
+	ID3D12Resource* Buffer;
+	VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &CD3DX12_RESOURCE_DESC::Buffer((uint64_t)Capacity * Stride),
+		D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&Buffer)));
+	if (InOutBuffer)
 	{
-		cgltf_result R = cgltf_parse_file(&Options, FileName, &Data);
-		EA_ASSERT(R == cgltf_result_success);
-		R = cgltf_load_buffers(&Options, Data, FileName);
-		EA_ASSERT(R == cgltf_result_success);
+		if (NumUsed > 0)
+		{
+			Gfx.CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(InOutBuffer, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_COPY_SOURCE));
+			Gfx.CmdList->CopyBufferRegion(Buffer, 0, InOutBuffer, 0, (uint64_t)NumUsed * Stride);
+		}
+		// Frames recorded so far may still use it.
+		Root.RetiredResources.push_back(FRetiredResource{ InOutBuffer, Gfx.FrameCount + 1 });
 	}
+	InOutBuffer = Buffer;
+}
 
-	cgltf_mesh* Mesh = &Data->meshes[0];
-	EA_ASSERT(Mesh->primitives_count <= MESH_MAX_NUM_SECTIONS);
+// Copies Size bytes to Buffer through this frame's upload memory.
+static void UploadToBuffer(FGraphicsContext& Gfx, ID3D12Resource* Buffer, uint64_t Offset, const void* Data, uint32_t Size)
+{
+	FUploadAllocation Upload;
+	AllocateUploadMemory(Gfx, Size, Upload);
+	memcpy(Upload.CPUAddress, Data, Size);
+	Gfx.CmdList->CopyBufferRegion(Buffer, Offset, (ID3D12Resource*)Upload.Resource, Upload.Offset, Size);
+}
 
-	OutMesh.NumSections = (uint32_t)Mesh->primitives_count;
+// Converts NumVertices vertices of Mesh, starting at FirstVertex, to the static vertex layout and copies them to the
+// static vertex buffers at DstVertex through this frame's upload memory.
+static void UploadVertices(FDemoRoot& Root, const FCookedMesh& Mesh, uint32_t FirstVertex, uint32_t NumVertices, uint32_t DstVertex)
+{
+	FGraphicsContext& Gfx = Root.Gfx;
+	const FVertexLayout& Layout = Root.StaticVertexLayout;
+	for (uint32_t Stream = 0; Stream < VERTEX_MAX_STREAMS; ++Stream)
+	{
+		const uint32_t Size = NumVertices * Layout.Strides[Stream];
+		FUploadAllocation Upload;
+		AllocateUploadMemory(Gfx, Size, Upload);
+		void* Streams[VERTEX_MAX_STREAMS] = {};
+		Streams[Stream] = Upload.CPUAddress;
+		ConvertVertices(Mesh.Layout, Mesh.VertexStreams, FirstVertex, NumVertices, Layout, Streams);
+		Gfx.CmdList->CopyBufferRegion(Root.StaticVBs[Stream], (uint64_t)DstVertex * Layout.Strides[Stream], (ID3D12Resource*)Upload.Resource, Upload.Offset, Size);
+	}
+}
 
-	uint32_t TotalNumVertices = 0;
-	uint32_t TotalNumIndices = 0;
+// Reserves the space of a streamed mesh in the static geometry buffers (all in COPY_DEST state), which are replaced by
+// larger ones when needed, and appends its indices to the CPU copy.
+static void BeginMeshUpload(FDemoRoot& Root, const FStreamedMesh& StreamedMesh)
+{
+	FGraphicsContext& Gfx = Root.Gfx;
+	FMeshUpload& Upload = Root.MeshUpload;
+	const FCookedMesh& Mesh = StreamedMesh.Mesh;
+	FStaticScene& Scene = Root.StaticScene;
+	const auto NumIndices = (uint32_t)(Scene.Indices.size() / Scene.IndexSize);
+
+	Upload.Mesh = &StreamedMesh;
+	Upload.BaseVertexLocation = Root.NumStaticVertices;
+	Upload.StartIndexLocation = NumIndices;
+	Upload.NextVertex = 0;
+	Upload.NextIndex = 0;
+
+	if (Root.NumStaticVertices + Mesh.NumVertices > Root.StaticVBCapacity)
+	{
+		Root.StaticVBCapacity = XMMax(Root.NumStaticVertices + Mesh.NumVertices, 2 * Root.StaticVBCapacity);
+		for (uint32_t Stream = 0; Stream < VERTEX_MAX_STREAMS; ++Stream)
+		{
+			const uint32_t Stride = Root.StaticVertexLayout.Strides[Stream];
+			ResizeStaticBuffer(Root, Root.StaticVBs[Stream], Stride, Root.NumStaticVertices, Root.StaticVBCapacity);
+			Root.StaticVBViews[Stream].BufferLocation = Root.StaticVBs[Stream]->GetGPUVirtualAddress();
+			Root.StaticVBViews[Stream].SizeInBytes = Root.StaticVBCapacity * Stride;
+		}
+	}
+	Root.NumStaticVertices += Mesh.NumVertices;
 
-	for (uint32_t SectionIdx = 0; SectionIdx < Mesh->primitives_count; ++SectionIdx)
+	if (Mesh.IndexSize > Scene.IndexSize)
 	{
-		EA_ASSERT(Data->meshes[0].primitives[SectionIdx].indices);
-		EA_ASSERT(Data->meshes[0].primitives[SectionIdx].attributes);
+		// Indices of the meshes added so far are widened on the CPU and uploaded at once (this happens at most once).
+		WidenStaticSceneIndices(Scene);
+		Root.StaticIBCapacity = XMMax(NumIndices + Mesh.NumIndices, Root.StaticIBCapacity);
+		ResizeStaticBuffer(Root, Root.StaticIB, 4, 0, Root.StaticIBCapacity);
 
-		TotalNumIndices += (uint32_t)Data->meshes[0].primitives[SectionIdx].indices->count;
-		TotalNumVertices += (uint32_t)Data->meshes[0].primitives[SectionIdx].attributes[0].data->count;
+		UploadToBuffer(Gfx, Root.StaticIB, 0, Scene.Indices.data(), (uint32_t)Scene.Indices.size());
 	}
+	else if (NumIndices + Mesh.NumIndices > Root.StaticIBCapacity)
+	{
+		Root.StaticIBCapacity = XMMax(NumIndices + Mesh.NumIndices, 2 * Root.StaticIBCapacity);
+		ResizeStaticBuffer(Root, Root.StaticIB, Scene.IndexSize, NumIndices, Root.StaticIBCapacity);
+	}
+	Root.StaticIBView.BufferLocation = Root.StaticIB->GetGPUVirtualAddress();
+	Root.StaticIBView.Format = Scene.IndexSize == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+	Root.StaticIBView.SizeInBytes = Root.StaticIBCapacity * Scene.IndexSize;
 
-	InOutVertices.reserve(InOutVertices.size() + TotalNumVertices);
-	InOutIndices.reserve(InOutIndices.size() + TotalNumIndices);
+	AppendStaticSceneIndices(Mesh, Scene);
+}
 
-	eastl::vector<XMFLOAT3> Positions;
-	eastl::vector<XMFLOAT3> Normals;
-	Positions.reserve(TotalNumVertices);
-	Normals.reserve(TotalNumVertices);
+// Hands the meshes finished by the loading jobs (see MeshStreaming.h) to the static geometry buffers in request order,
+// at most MESH_STREAM_UPLOAD_BYTES_PER_FRAME of vertex and index data per frame. A mesh is added to StaticScene (and
+// drawn) in the frame whose command list copies its last bytes, the first one with instances replaces the default
+// scene. Records to the frame's command list, before anything reads the static geometry buffers.
+static void UpdateMeshStreaming(FDemoRoot& Root)
+{
+	FGraphicsContext& Gfx = Root.Gfx;
+	FMeshUpload& Upload = Root.MeshUpload;
 
-	for (uint32_t SectionIdx = 0; SectionIdx < Mesh->primitives_count; ++SectionIdx)
+	const uint64_t CompletedFenceValue = Gfx.FrameFence->GetCompletedValue();
+	for (size_t Idx = 0; Idx < Root.RetiredResources.size();)
 	{
-		// Indices.
+		if (CompletedFenceValue >= Root.RetiredResources[Idx].FenceValue)
 		{
-			const cgltf_accessor* Accessor = Data->meshes[0].primitives[SectionIdx].indices;
-
-			EA_ASSERT(Accessor->buffer_view);
-			EA_ASSERT(Accessor->stride == Accessor->buffer_view->stride || Accessor->buffer_view->stride == 0);
-			EA_ASSERT((Accessor->stride * Accessor->count) == Accessor->buffer_view->size);
-
-			const auto DataAddr = (const uint8_t*)Accessor->buffer_view->buffer->data + Accessor->offset + Accessor->buffer_view->offset;
+			SAFE_RELEASE(Root.RetiredResources[Idx].Resource);
+			Root.RetiredResources.erase_unsorted(Root.RetiredResources.begin() + Idx);
+		}
+		else
+		{
+			++Idx;
+		}
+	}
 
-			OutMesh.Sections[SectionIdx].StartIndexLocation = (uint32_t)InOutIndices.size();
-			OutMesh.Sections[SectionIdx].IndexCount = (uint32_t)Accessor->count;
+	while (Root.NumRequestedMeshFiles < (uint32_t)Root.MeshFileNames.size() && RequestMesh(Root.MeshStreamer, Root.MeshFileNames[Root.NumRequestedMeshFiles]))
+	{
+		Root.NumRequestedMeshFiles += 1;
+	}
+	if (!Upload.Mesh && GetNumMeshRequests(Root.MeshStreamer) == 0)
+	{
+		return;
+	}
+	const double StartTime = GetTime();
 
-			if (Accessor->stride == 1)
-			{
-				const uint8_t* DataU8 = (const uint8_t*)DataAddr;
-				for (uint32_t Idx = 0; Idx < Accessor->count; ++Idx)
-				{
-					InOutIndices.push_back((uint32_t)* DataU8++);
-				}
-			}
-			else if (Accessor->stride == 2)
-			{
-				const uint16_t* DataU16 = (const uint16_t*)DataAddr;
-				for (uint32_t Idx = 0; Idx < Accessor->count; ++Idx)
-				{
-					InOutIndices.push_back((uint32_t)* DataU16++);
-				}
-			}
-			else if (Accessor->stride == 4)
+	const uint32_t VertexSize = Root.StaticVertexLayout.Strides[0] + Root.StaticVertexLayout.Strides[1];
+	uint32_t Budget = MESH_STREAM_UPLOAD_BYTES_PER_FRAME;
+	bool bIsCopying = false;
+	for (;;)
+	{
+		const FStreamedMesh* StreamedMesh = Upload.Mesh;
+		if (!StreamedMesh)
+		{
+			bool bHasSucceeded;
+			StreamedMesh = GetStreamedMesh(Root.MeshStreamer, bHasSucceeded);
+			if (!StreamedMesh)
 			{
-				InOutIndices.resize(InOutIndices.size() + Accessor->count);
-				memcpy(&InOutIndices[InOutIndices.size() - Accessor->count], DataAddr, Accessor->count * Accessor->stride);
+				break;
 			}
-			else
+			if (!bHasSucceeded)
 			{
-				EA_ASSERT(0);
+				ReleaseStreamedMesh(Root.MeshStreamer);
+				Root.NumFailedMeshes += 1;
+				continue;
 			}
 		}
-
-		// Attributes.
+		if (!bIsCopying)
 		{
-			const uint32_t NumAttribs = (uint32_t)Data->meshes[0].primitives[SectionIdx].attributes_count;
-
-			for (uint32_t AttribIdx = 0; AttribIdx < NumAttribs; ++AttribIdx)
+			const D3D12_RESOURCE_BARRIER Barriers[VERTEX_MAX_STREAMS + 1] =
 			{
-				const cgltf_attribute* Attrib = &Data->meshes[0].primitives[SectionIdx].attributes[AttribIdx];
-				const cgltf_accessor* Accessor = Attrib->data;
-
-				EA_ASSERT(Accessor->buffer_view);
-				EA_ASSERT(Accessor->stride == Accessor->buffer_view->stride || Accessor->buffer_view->stride == 0);
-				EA_ASSERT((Accessor->stride * Accessor->count) == Accessor->buffer_view->size);
-
-				const auto DataAddr = (const uint8_t*)Accessor->buffer_view->buffer->data + Accessor->offset + Accessor->buffer_view->offset;
-
-				if (Attrib->type == cgltf_attribute_type_position)
-				{
-					EA_ASSERT(Accessor->type == cgltf_type_vec3);
-					Positions.resize(Accessor->count);
-					memcpy(Positions.data(), DataAddr, Accessor->count * Accessor->stride);
-				}
-				else if (Attrib->type == cgltf_attribute_type_normal)
-				{
-					EA_ASSERT(Accessor->type == cgltf_type_vec3);
-					Normals.resize(Accessor->count);
-					memcpy(Normals.data(), DataAddr, Accessor->count * Accessor->stride);
-				}
-			}
-
-			EA_ASSERT(Positions.size() > 0 && Positions.size() == Normals.size());
-
-			OutMesh.Sections[SectionIdx].BaseVertexLocation = (uint32_t)InOutVertices.size();
+				CD3DX12_RESOURCE_BARRIER::Transition(Root.StaticVBs[0], D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER, D3D12_RESOURCE_STATE_COPY_DEST),
+				CD3DX12_RESOURCE_BARRIER::Transition(Root.StaticVBs[1], D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER, D3D12_RESOURCE_STATE_COPY_DEST),
+				CD3DX12_RESOURCE_BARRIER::Transition(Root.StaticIB, D3D12_RESOURCE_STATE_INDEX_BUFFER, D3D12_RESOURCE_STATE_COPY_DEST),
+			};
+			Gfx.CmdList->ResourceBarrier((UINT)eastl::size(Barriers), Barriers);
+			bIsCopying = true;
+		}
+		if (!Upload.Mesh)
+		{
+			BeginMeshUpload(Root, *StreamedMesh);
+		}
 
-			for (uint32_t Idx = 0; Idx < Positions.size(); ++Idx)
-			{
-				FVertex Vertex;
-				Vertex.Position = Positions[Idx];
-				Vertex.Normal = Normals[Idx];
-				InOutVertices.push_back(Vertex);
-			}
+		const FCookedMesh& Mesh = Upload.Mesh->Mesh;
+		const uint32_t NumVertices = XMMin(Mesh.NumVertices - Upload.NextVertex, Budget / VertexSize);
+		if (NumVertices > 0)
+		{
+			UploadVertices(Root, Mesh, Upload.NextVertex, NumVertices, Upload.BaseVertexLocation + Upload.NextVertex);
+			Upload.NextVertex += NumVertices;
+			Budget -= NumVertices * VertexSize;
+		}
+		const uint32_t NumIndices = Upload.NextVertex == Mesh.NumVertices ? XMMin(Mesh.NumIndices - Upload.NextIndex, Budget / Root.StaticScene.IndexSize) : 0;
+		if (NumIndices > 0)
+		{
+			const uint32_t IndexSize = Root.StaticScene.IndexSize;
+			const size_t Offset = (size_t)(Upload.StartIndexLocation + Upload.NextIndex) * IndexSize;
+			UploadToBuffer(Gfx, Root.StaticIB, Offset, &Root.StaticScene.Indices[Offset], NumIndices * IndexSize);
+			Upload.NextIndex += NumIndices;
+			Budget -= NumIndices * IndexSize;
+		}
+		if (Upload.NextVertex < Mesh.NumVertices || Upload.NextIndex < Mesh.NumIndices)
+		{
+			break;
+		}
 
-			Positions.clear();
-			Normals.clear();
+		if (Root.bShowsDefaultScene && Mesh.NumInstances > 0)
+		{
+			Root.StaticScene.Instances.clear();
+			SetStaticMotions(nullptr, 0, Root.StaticScene.Motions);
+			Root.StaticScene.MovingInstances.clear();
+			Root.bShowsDefaultScene = false;
+		}
+		AddStaticSceneMesh(Mesh, Upload.BaseVertexLocation, Upload.StartIndexLocation, true, Root.StaticScene);
+		if (Mesh.NumInstances > 0)
+		{
+			BuildStaticInstanceBVH(Root);
 		}
+		ReleaseStreamedMesh(Root.MeshStreamer);
+		Upload.Mesh = nullptr;
+		Root.NumStreamedMeshes += 1;
 	}
 
-	cgltf_free(Data);
+	if (bIsCopying)
+	{
+		const D3D12_RESOURCE_BARRIER Barriers[VERTEX_MAX_STREAMS + 1] =
+		{
+			CD3DX12_RESOURCE_BARRIER::Transition(Root.StaticVBs[0], D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER),
+			CD3DX12_RESOURCE_BARRIER::Transition(Root.StaticVBs[1], D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER),
+			CD3DX12_RESOURCE_BARRIER::Transition(Root.StaticIB, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_INDEX_BUFFER),
+		};
+		Gfx.CmdList->ResourceBarrier((UINT)eastl::size(Barriers), Barriers);
+	}
+	Root.MaxMeshStreamingStepTime = XMMax(Root.MaxMeshStreamingStepTime, GetTime() - StartTime);
 }
 
 static void Initialize(FDemoRoot& Root)
@@ -852,23 +1651,99 @@ static void Initialize(FDemoRoot& Root)
 	eastl::vector<ID3D12Resource*> TempResources;
 	eastl::vector<ID3D12Resource*> TexturesThatNeedMipmaps;
 
+	CreateJobSystem(0, Root.Jobs);
+
 	const uint32_t NumSamples = 8;
 	CreateUIContext(Gfx, NumSamples, Root.UI, TempResources);
-	CreatePipelines(Gfx, NumSamples, Root.Pipelines, Root.RootSignatures);
+	InitVertexLayout(STATIC_VERTEX_ATTRIBUTES, Root.StaticVertexLayout);
+	CreatePipelines(Gfx, Root.StaticVertexLayout, NumSamples, Root.Pipelines, Root.RootSignatures);
 
-	eastl::vector<FVertex> AllVertices;
-	eastl::vector<uint32_t> AllIndices;
+	// Root constant 0 of PSO_SimpleForward and the draw, see FStaticDrawBatch.
 	{
+		D3D12_INDIRECT_ARGUMENT_DESC Arguments[2] = {};
+		Arguments[0].Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+		Arguments[0].Constant.RootParameterIndex = 0;
+		Arguments[0].Constant.DestOffsetIn32BitValues = 0;
+		Arguments[0].Constant.Num32BitValuesToSet = 1;
+		Arguments[1].Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+		static_assert(sizeof(FStaticDrawBatch) == sizeof(uint32_t) + sizeof(D3D12_DRAW_INDEXED_ARGUMENTS), "FStaticDrawBatch is not an argument of the command signature.");
+
+		D3D12_COMMAND_SIGNATURE_DESC Desc = {};
+		Desc.ByteStride = sizeof(FStaticDrawBatch);
+		Desc.NumArgumentDescs = (UINT)eastl::size(Arguments);
+		Desc.pArgumentDescs = Arguments;
+		VHR(Gfx.Device->CreateCommandSignature(&Desc, Root.RootSignatures[PSO_SimpleForward], IID_PPV_ARGS(&Root.StaticDrawSignature)));
+	}
+
+	// Command line: [-instances N] [-moving P] [mesh files]. With -instances, N generated instances of the built-in meshes,
+	// P percent of them moving (10 by default), replace the sphere grid (see GenerateStaticScene()).
+	uint32_t NumGeneratedInstances = 0;
+	uint32_t MovingPercent = 10;
+	for (int32_t ArgIdx = 1; ArgIdx < __argc; ++ArgIdx)
+	{
+		if (ArgIdx + 1 < __argc && EA::StdC::Strcmp(__argv[ArgIdx], "-instances") == 0)
 		{
-			FMesh Mesh = {};
-			LoadGLTFMesh("Data/Meshes/Cube.gltf", Mesh, AllVertices, AllIndices);
-			Root.StaticMeshes.push_back(FStaticMesh{ Mesh.Sections[0].IndexCount, Mesh.Sections[0].StartIndexLocation, Mesh.Sections[0].BaseVertexLocation });
+			NumGeneratedInstances = EA::StdC::StrtoU32(__argv[++ArgIdx], nullptr, 10);
 		}
+		else if (ArgIdx + 1 < __argc && EA::StdC::Strcmp(__argv[ArgIdx], "-moving") == 0)
 		{
-			FMesh Mesh = {};
-			LoadGLTFMesh("Data/Meshes/Sphere.gltf", Mesh, AllVertices, AllIndices);
-			Root.StaticMeshes.push_back(FStaticMesh{ Mesh.Sections[0].IndexCount, Mesh.Sections[0].StartIndexLocation, Mesh.Sections[0].BaseVertexLocation });
+			MovingPercent = XMMin(EA::StdC::StrtoU32(__argv[++ArgIdx], nullptr, 10), 100u);
 		}
+		else
+		{
+			Root.MeshFileNames.push_back(__argv[ArgIdx]);
+		}
+	}
+
+	// Built-in meshes come first (see MESH_Cube, MESH_Sphere), their instances are not drawn. Files passed on the command
+	// line (.mesh, or .gltf/.glb/.ply which are cooked by the loading job) are streamed in after the first frame (see
+	// UpdateMeshStreaming()).
+	const char* MeshFileNames[] = { "Data/Meshes/Cube.mesh", "Data/Meshes/Sphere.mesh" };
+	FMappedFile MeshFiles[eastl::size(MeshFileNames)] = {};
+	eastl::vector<uint8_t> CookedData[eastl::size(MeshFileNames)];
+	FCookedMesh Meshes[eastl::size(MeshFileNames)] = {};
+	const uint32_t NumMeshes = (uint32_t)eastl::size(MeshFileNames);
+	FStaticScene& Scene = Root.StaticScene;
+	Scene.IndexSize = 2;
+	for (uint32_t MeshIdx = 0; MeshIdx < NumMeshes; ++MeshIdx)
+	{
+		if (!OpenMeshFile(Root.Jobs, MeshFileNames[MeshIdx], MeshFiles[MeshIdx], CookedData[MeshIdx], Meshes[MeshIdx]))
+		{
+			EA_ASSERT(0);
+		}
+		Scene.IndexSize = XMMax(Scene.IndexSize, Meshes[MeshIdx].IndexSize);
+	}
+	EA_ASSERT(Meshes[MESH_Cube].NumSections == 1 && Meshes[MESH_Sphere].NumSections == 1);
+
+	for (uint32_t MeshIdx = 0; MeshIdx < NumMeshes; ++MeshIdx)
+	{
+		AddStaticSceneMesh(Meshes[MeshIdx], Root.NumStaticVertices, (uint32_t)(Scene.Indices.size() / Scene.IndexSize), false, Scene);
+		AppendStaticSceneIndices(Meshes[MeshIdx], Scene);
+		Root.NumStaticVertices += Meshes[MeshIdx].NumVertices;
+	}
+	const uint32_t NumVertices = Root.NumStaticVertices;
+	const auto NumIndices = (uint32_t)(Scene.Indices.size() / Scene.IndexSize);
+	const uint32_t IndexSize = Scene.IndexSize;
+	Root.StaticVBCapacity = NumVertices;
+	Root.StaticIBCapacity = NumIndices;
+
+	// The camera orbit grows with the generated scene.
+	Root.CameraDistance = 12.0f;
+	if (NumGeneratedInstances > 0)
+	{
+		FStaticSceneDesc Desc;
+		Desc.NumInstances = NumGeneratedInstances;
+		Desc.FirstMesh = MESH_Cube;
+		Desc.NumMeshes = NumMeshes;
+		Desc.MovingFraction = MovingPercent / 100.0f;
+		Desc.Seed = 1;
+		Root.CameraDistance = XMMax(Root.CameraDistance, 1.5f * GenerateStaticScene(Desc, Scene));
+		Root.bShowsDefaultScene = false;
+	}
+	else
+	{
+		// Shown until a streamed mesh with instances is added.
+		Root.bShowsDefaultScene = true;
 
 		const int32_t NumRows = 5;
 		const int32_t NumColumns = 7;
@@ -881,90 +1756,129 @@ static void Initialize(FDemoRoot& Root)
 				FStaticMeshInstance Instance = {};
 				float X = 2.2f * (-NumColumns * 0.5f + ColumnIdx + 0.5f);
 				float Y = 2.2f * (-NumRows * 0.5f + RowIdx + 0.5f);
-				Instance.Position = XMFLOAT3(X, Y, 0.0f);
-				Instance.MeshIndex = 1;
+				XMStoreFloat4x3(&Instance.ObjectToWorld, XMMatrixTranslation(X, Y, 0.0f));
+				Instance.MeshIndex = MESH_Sphere;
+				Instance.Albedo = XMFLOAT3(0.5f, 0.0f, 0.0f);
 				Instance.Roughness = Roughness;
 				Instance.Metallic = Metallic;
 
 				Roughness += 1.0f / NumColumns;
 				Roughness = XMMin(Roughness, 1.0f);
 
-				Root.StaticMeshInstances.push_back(Instance);
+				Scene.Instances.push_back(Instance);
 			}
 			Metallic += 1.0f / (NumRows - 1);
 			Metallic = XMMin(Metallic, 1.0f);
 		}
 	}
+	BuildStaticInstanceBVH(Root);
+	Root.PickedInstance = UINT32_MAX;
 
-	// Static geometry vertex buffer (single buffer for all static meshes).
+	// Static geometry vertex buffers (one per stream of the static vertex layout, shared by all static meshes), cooked
+	// vertices are converted to that layout.
+	for (uint32_t Stream = 0; Stream < VERTEX_MAX_STREAMS; ++Stream)
 	{
-		const D3D12_RESOURCE_DESC Desc = CD3DX12_RESOURCE_DESC::Buffer(AllVertices.size() * sizeof(FVertex));
-
-		ID3D12Resource* StagingVB;
-		VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE, &Desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&StagingVB)));
-		TempResources.push_back(StagingVB);
-
-		void* Ptr;
-		VHR(StagingVB->Map(0, &CD3DX12_RANGE(0, 0), &Ptr));
-		memcpy(Ptr, AllVertices.data(), AllVertices.size() * sizeof(FVertex));
-		StagingVB->Unmap(0, nullptr);
+		// Both streams are used (the static layout has more than positions).
+		const uint32_t Stride = Root.StaticVertexLayout.Strides[Stream];
+		EA_ASSERT(Stride > 0);
+		const D3D12_RESOURCE_DESC Desc = CD3DX12_RESOURCE_DESC::Buffer((uint64_t)NumVertices * Stride);
+
+		FUploadAllocation Staging;
+		AllocateUploadMemory(Gfx, Desc.Width, Staging);
+		uint8_t* Ptr = Staging.CPUAddress;
+		for (uint32_t MeshIdx = 0; MeshIdx < NumMeshes; ++MeshIdx)
+		{
+			void* Streams[VERTEX_MAX_STREAMS] = {};
+			Streams[Stream] = Ptr;
+			ConvertVertices(Meshes[MeshIdx].Layout, Meshes[MeshIdx].VertexStreams, 0, Meshes[MeshIdx].NumVertices, Root.StaticVertexLayout, Streams);
+			Ptr += Meshes[MeshIdx].NumVertices * Stride;
+		}
 
-		VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &Desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&Root.StaticVB)));
+		VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &Desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&Root.StaticVBs[Stream])));
 
-		Root.StaticVBView.BufferLocation = Root.StaticVB->GetGPUVirtualAddress();
-		Root.StaticVBView.StrideInBytes = sizeof(FVertex);
-		Root.StaticVBView.SizeInBytes = (UINT)AllVertices.size() * sizeof(FVertex);
+		Root.StaticVBViews[Stream].BufferLocation = Root.StaticVBs[Stream]->GetGPUVirtualAddress();
+		Root.StaticVBViews[Stream].StrideInBytes = Stride;
+		Root.StaticVBViews[Stream].SizeInBytes = NumVertices * Stride;
 
-		Gfx.CmdList->CopyResource(Root.StaticVB, StagingVB);
-		Gfx.CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(Root.StaticVB, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER));
+		Gfx.CmdList->CopyBufferRegion(Root.StaticVBs[Stream], 0, (ID3D12Resource*)Staging.Resource, Staging.Offset, Desc.Width);
+		Gfx.CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(Root.StaticVBs[Stream], D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER));
 	}
 
-	// Static geometry index buffer (single buffer for all static meshes).
+	// Static geometry index buffer (single buffer for all static meshes), 16-bit unless a mesh needs 32-bit indices. The
+	// cluster culler reads the CPU copy built above.
 	{
-		const D3D12_RESOURCE_DESC Desc = CD3DX12_RESOURCE_DESC::Buffer(AllIndices.size() * sizeof(uint32_t));
-
-		ID3D12Resource* StagingIB;
-		VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE, &Desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&StagingIB)));
-		TempResources.push_back(StagingIB);
-
-		void* Ptr;
-		VHR(StagingIB->Map(0, &CD3DX12_RANGE(0, 0), &Ptr));
-		memcpy(Ptr, AllIndices.data(), AllIndices.size() * sizeof(uint32_t));
-		StagingIB->Unmap(0, nullptr);
+		const D3D12_RESOURCE_DESC Desc = CD3DX12_RESOURCE_DESC::Buffer((uint64_t)NumIndices * IndexSize);
 
 		VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &Desc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&Root.StaticIB)));
 
 		Root.StaticIBView.BufferLocation = Root.StaticIB->GetGPUVirtualAddress();
-		Root.StaticIBView.Format = DXGI_FORMAT_R32_UINT;
-		Root.StaticIBView.SizeInBytes = (UINT)AllIndices.size() * sizeof(uint32_t);
+		Root.StaticIBView.Format = IndexSize == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+		Root.StaticIBView.SizeInBytes = NumIndices * IndexSize;
 
-		Gfx.CmdList->CopyResource(Root.StaticIB, StagingIB);
+		UploadToBuffer(Gfx, Root.StaticIB, 0, Scene.Indices.data(), (uint32_t)Scene.Indices.size());
 		Gfx.CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(Root.StaticIB, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_INDEX_BUFFER));
 	}
 
-	Gfx.CmdList->IASetVertexBuffers(0, 1, &Root.StaticVBView);
+	for (FMappedFile& File : MeshFiles)
+	{
+		CloseMappedFile(File);
+	}
+
+	Gfx.CmdList->IASetVertexBuffers(0, VERTEX_MAX_STREAMS, Root.StaticVBViews);
 	Gfx.CmdList->IASetIndexBuffer(&Root.StaticIBView);
 
-	// Create EnvMap.
-	Gfx.CmdList->SetPipelineState(Root.Pipelines[PSO_EquirectangularToCube]);
-	Gfx.CmdList->SetGraphicsRootSignature(Root.RootSignatures[PSO_EquirectangularToCube]);
-	CreateEnvMap(Root.Gfx, Root.StaticMeshes[MESH_Cube], Root.EnvMap, Root.EnvMapSRV, TempResources);
-	TexturesThatNeedMipmaps.push_back(Root.EnvMap);
-
-	// Create IrradianceMap.
-	Gfx.CmdList->SetPipelineState(Root.Pipelines[PSO_GenerateIrradianceMap]);
-	Gfx.CmdList->SetGraphicsRootSignature(Root.RootSignatures[PSO_GenerateIrradianceMap]);
-	CreateIrradianceMap(Root.Gfx, Root.EnvMapSRV, Root.StaticMeshes[MESH_Cube], Root.IrradianceMap, Root.IrradianceMapSRV, TempResources);
-
-	// Create PrefilteredEnvMap.
-	Gfx.CmdList->SetPipelineState(Root.Pipelines[PSO_PrefilterEnvMap]);
-	Gfx.CmdList->SetGraphicsRootSignature(Root.RootSignatures[PSO_PrefilterEnvMap]);
-	CreatePrefilteredEnvMap(Gfx, Root.EnvMapSRV, Root.StaticMeshes[MESH_Cube], Root.PrefilteredEnvMap, Root.PrefilteredEnvMapSRV, TempResources);
-
-	// Create BRDFIntegrationMap.
-	Gfx.CmdList->SetPipelineState(Root.Pipelines[PSO_GenerateBRDFIntegrationMap]);
-	Gfx.CmdList->SetComputeRootSignature(Root.RootSignatures[PSO_GenerateBRDFIntegrationMap]);
+	const DXGI_FORMAT Formats[] = { DXGI_FORMAT_R16G16B16A16_FLOAT, DXGI_FORMAT_R8G8B8A8_UNORM };
+	FMipmapGenerator MipmapGenerators[eastl::size(Formats)];
+	for (uint32_t Idx = 0; Idx < eastl::size(Formats); ++Idx)
+	{
+		CreateMipmapGenerator(Root.Gfx, Formats[Idx], MipmapGenerators[Idx]);
+	}
+
+	// IBL textures come from the on-disk cache when possible, otherwise they are generated on the GPU (and cached below).
+	FIBLCacheKey IBLCacheKey;
+	if (!GetIBLCacheKey(ENV_MAP_FILE_NAME, IBLCacheKey))
+	{
+		EA_ASSERT(0);
+	}
+
+	FIBLCacheEntry IBLCacheEntry;
+	const bool bIsIBLCacheHit = OpenIBLCacheEntry(IBL_CACHE_DIRECTORY, IBLCacheKey, IBLCacheEntry);
+	if (bIsIBLCacheHit)
+	{
+		CreateIBLTexturesFromCache(Root, IBLCacheEntry, TempResources);
+		ComputeIrradianceSH(IBLCacheEntry.Descs[IBL_TEXTURE_EnvMap], IBLCacheEntry.Pixels[IBL_TEXTURE_EnvMap], Root.IrradianceSH);
+		// Texel data is already in the upload buffers.
+		CloseIBLCacheEntry(IBLCacheEntry);
+	}
+	else
+	{
+		// Create EnvMap.
+		Gfx.CmdList->SetPipelineState(Root.Pipelines[PSO_EquirectangularToCube]);
+		Gfx.CmdList->SetGraphicsRootSignature(Root.RootSignatures[PSO_EquirectangularToCube]);
+		CreateEnvMap(Root.Gfx, Root.Jobs, Root.StaticScene.Meshes[MESH_Cube], Root.EnvMap, Root.EnvMapSRV, TempResources);
+		// PrefilterEnvMap.hlsl reads the whole mip chain (filtered importance sampling).
+		EA_ASSERT(Root.EnvMap->GetDesc().Format == Formats[0]);
+		GenerateMipmaps(Root.Gfx, MipmapGenerators[0], Root.EnvMap);
+
+		// Create PrefilteredEnvMap.
+		Gfx.CmdList->SetPipelineState(Root.Pipelines[PSO_PrefilterEnvMap]);
+		Gfx.CmdList->SetComputeRootSignature(Root.RootSignatures[PSO_PrefilterEnvMap]);
+		CreatePrefilteredEnvMap(Gfx, Root.EnvMap, Root.EnvMapSRV, Root.PrefilteredEnvMap, Root.PrefilteredEnvMapSRV);
+	}
 	CreateBRDFIntegrationMap(Gfx, Root.BRDFIntegrationMap, Root.BRDFIntegrationMapSRV, TempResources);
+	Root.EnvMapDescriptor = CreatePersistentDescriptor(Gfx, Root.EnvMapSRV);
+	Root.PrefilteredEnvMapDescriptor = CreatePersistentDescriptor(Gfx, Root.PrefilteredEnvMapSRV);
+	Root.BRDFIntegrationMapDescriptor = CreatePersistentDescriptor(Gfx, Root.BRDFIntegrationMapSRV);
+
+	CreateEnvMapRebake(Gfx, Root.EnvMapRebake);
+	EA::StdC::Strlcpy(Root.EnvMapFileName, ENV_MAP_FILE_NAME, sizeof(Root.EnvMapFileName));
+	EA::StdC::Strlcpy(Root.NewEnvMapFileName, ENV_MAP_FILE_NAME, sizeof(Root.NewEnvMapFileName));
+	Root.MaxLODError = 1.0f;
+	Root.bClusterCulling = true;
+	Root.bIndirectStaticDraws = true;
+	// Files are requested by UpdateMeshStreaming(), a thread that waits for jobs here (see CreateEnvMap()) could pick up
+	// the loading jobs.
+	CreateMeshStreamer(Root.Jobs, Root.MeshStreamer);
 
 	// Setup resources for MSAA.
 	{
@@ -985,13 +1899,6 @@ static void Initialize(FDemoRoot& Root)
 
 	// Execute "data upload" and "data generation" GPU commands, create mipmaps, destroy temp resources when GPU is done.
 	{
-		const DXGI_FORMAT Formats[] = { DXGI_FORMAT_R16G16B16A16_FLOAT, DXGI_FORMAT_R8G8B8A8_UNORM };
-		FMipmapGenerator MipmapGenerators[eastl::size(Formats)];
-		for (uint32_t Idx = 0; Idx < eastl::size(Formats); ++Idx)
-		{
-			CreateMipmapGenerator(Root.Gfx, Formats[Idx], MipmapGenerators[Idx]);
-		}
-
 		for (ID3D12Resource* Texture : TexturesThatNeedMipmaps)
 		{
 			const D3D12_RESOURCE_DESC Desc = Texture->GetDesc();
@@ -1020,6 +1927,15 @@ static void Initialize(FDemoRoot& Root)
 		}
 	}
 
+	if (!bIsIBLCacheHit)
+	{
+		FDDSDesc Descs[IBL_TEXTURE_Count];
+		eastl::vector<uint8_t> Data[IBL_TEXTURE_Count];
+		ReadbackIBLTextures(Root, Descs, Data);
+		ComputeIrradianceSH(Descs[IBL_TEXTURE_EnvMap], Data[IBL_TEXTURE_EnvMap].data(), Root.IrradianceSH);
+		SaveIBLTexturesToCache(IBLCacheKey, Descs, Data);
+	}
+
 	Root.CameraPosition = XMFLOAT3(0.0f, 0.0f, -10.0f);
 	Root.CameraFocusPosition = XMFLOAT3(0.0f, 0.0f, 0.0f);
 }
@@ -1034,15 +1950,25 @@ static void Shutdown(FDemoRoot& Root)
 	{
 		SAFE_RELEASE(Pipeline);
 	}
-	SAFE_RELEASE(Root.StaticVB);
+	SAFE_RELEASE(Root.StaticDrawSignature);
+	for (ID3D12Resource*& StaticVB : Root.StaticVBs)
+	{
+		SAFE_RELEASE(StaticVB);
+	}
 	SAFE_RELEASE(Root.StaticIB);
 	SAFE_RELEASE(Root.EnvMap);
-	SAFE_RELEASE(Root.IrradianceMap);
 	SAFE_RELEASE(Root.PrefilteredEnvMap);
 	SAFE_RELEASE(Root.BRDFIntegrationMap);
+	DestroyEnvMapRebake(Root.Jobs, Root.EnvMapRebake);
+	DestroyMeshStreamer(Root.MeshStreamer);
+	for (FRetiredResource& Retired : Root.RetiredResources)
+	{
+		SAFE_RELEASE(Retired.Resource);
+	}
 	SAFE_RELEASE(Root.MSColorBuffer);
 	SAFE_RELEASE(Root.MSDepthBuffer);
 	DestroyUIContext(Root.UI);
+	DestroyJobSystem(Root.Jobs);
 }
 
 static int32_t Run(FDemoRoot& Root)
@@ -1069,6 +1995,7 @@ static int32_t Run(FDemoRoot& Root)
 		else
 		{
 			Update(Root);
+			UpdateEnvMapRebake(Root);
 			Draw(Root);
 			PresentFrame(Root.Gfx, 0);
 		}
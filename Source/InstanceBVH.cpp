@@ -0,0 +1,687 @@
+#include "InstanceBVH.h"
+#include "EAAssert/eaassert.h"
+#include "EASTL/sort.h"
+#include <float.h>
+
+// Beyond this depth nodes are split at the median, which bounds the depth of the tree (and the traversal stacks) to
+// INSTANCE_BVH_MAX_SAH_DEPTH + 32.
+#define INSTANCE_BVH_MAX_SAH_DEPTH 32
+#define INSTANCE_BVH_STACK_SIZE 64
+
+// Frustum planes replicated for 4-wide tests. The tested box corner is the one furthest along the plane normal, the
+// distance is computed as ((w + x * nx) + y * ny) + z * nz by all box tests, so that a box and the nodes around it
+// always agree.
+struct FFrustum4
+{
+	XMFLOAT4 Planes[6];
+	XMVECTOR Normals[6][3];
+	XMVECTOR Distances[6];
+	bool bPositive[6][3];
+};
+
+// Ray replicated for 4-wide tests. Zero direction components are replaced by tiny ones, so that the slab distances
+// are never NaN.
+struct FRay4
+{
+	XMVECTOR Origin[3];
+	XMVECTOR InvDirection[3];
+	XMVECTOR MaxDistance;
+	bool bPositive[3];
+};
+
+struct FBoxes4
+{
+	XMVECTOR Min[3];
+	XMVECTOR Max[3];
+};
+
+struct FBuildPrimitive
+{
+	XMFLOAT3 Min;
+	uint32_t Instance;
+	XMFLOAT3 Max;
+};
+
+struct FBuildBin
+{
+	XMVECTOR Min;
+	XMVECTOR Max;
+	XMVECTOR CentroidMin;
+	XMVECTOR CentroidMax;
+	uint32_t Count;
+};
+
+struct FBuildTask
+{
+	uint32_t Node;
+	uint32_t Begin;
+	uint32_t End;
+	uint32_t Depth;
+	XMFLOAT3 CentroidMin;
+	XMFLOAT3 CentroidMax;
+};
+
+struct FRayStackEntry
+{
+	uint32_t Node;
+	float Distance;
+};
+
+void ResizeInstanceBounds(uint32_t NumInstances, FInstanceBounds& InOutBounds)
+{
+	const uint32_t Size = (NumInstances + 3) & ~3u;
+	const uint32_t FirstEmpty = XMMin(InOutBounds.NumInstances, NumInstances);
+	InOutBounds.NumInstances = NumInstances;
+	InOutBounds.MinX.resize(Size);
+	InOutBounds.MinY.resize(Size);
+	InOutBounds.MinZ.resize(Size);
+	InOutBounds.MaxX.resize(Size);
+	InOutBounds.MaxY.resize(Size);
+	InOutBounds.MaxZ.resize(Size);
+	// New boxes and the padding after the last one.
+	for (uint32_t Instance = FirstEmpty; Instance < Size; ++Instance)
+	{
+		InOutBounds.MinX[Instance] = InOutBounds.MinY[Instance] = InOutBounds.MinZ[Instance] = FLT_MAX;
+		InOutBounds.MaxX[Instance] = InOutBounds.MaxY[Instance] = InOutBounds.MaxZ[Instance] = -FLT_MAX;
+	}
+}
+
+void XM_CALLCONV SetInstanceBounds(FXMMATRIX ObjectToWorld, const FSceneBounds& MeshBounds, uint32_t Instance, FInstanceBounds& InOutBounds)
+{
+	EA_ASSERT(Instance < InOutBounds.NumInstances);
+
+	// Box around the transformed box (Arvo 1990), clipped to the box around the transformed sphere.
+	const XMVECTOR Center = XMVector3Transform(XMLoadFloat3(&MeshBounds.Center), ObjectToWorld);
+	XMVECTOR Extents = XMVectorMultiply(XMVectorAbs(ObjectToWorld.r[0]), XMVectorReplicate(MeshBounds.Extents.x));
+	Extents = XMVectorMultiplyAdd(XMVectorAbs(ObjectToWorld.r[1]), XMVectorReplicate(MeshBounds.Extents.y), Extents);
+	Extents = XMVectorMultiplyAdd(XMVectorAbs(ObjectToWorld.r[2]), XMVectorReplicate(MeshBounds.Extents.z), Extents);
+	const XMVECTOR ScaleSq = XMVectorMax(XMVector3LengthSq(ObjectToWorld.r[0]), XMVectorMax(XMVector3LengthSq(ObjectToWorld.r[1]), XMVector3LengthSq(ObjectToWorld.r[2])));
+	Extents = XMVectorMin(Extents, XMVectorScale(XMVectorSqrt(ScaleSq), MeshBounds.Radius));
+
+	XMFLOAT3 Min, Max;
+	XMStoreFloat3(&Min, XMVectorSubtract(Center, Extents));
+	XMStoreFloat3(&Max, XMVectorAdd(Center, Extents));
+	InOutBounds.MinX[Instance] = Min.x;
+	InOutBounds.MinY[Instance] = Min.y;
+	InOutBounds.MinZ[Instance] = Min.z;
+	InOutBounds.MaxX[Instance] = Max.x;
+	InOutBounds.MaxY[Instance] = Max.y;
+	InOutBounds.MaxZ[Instance] = Max.z;
+}
+
+static XMVECTOR XM_CALLCONV LoadMin(const FInstanceBounds& Bounds, uint32_t Instance)
+{
+	return XMVectorSet(Bounds.MinX[Instance], Bounds.MinY[Instance], Bounds.MinZ[Instance], 0.0f);
+}
+
+static XMVECTOR XM_CALLCONV LoadMax(const FInstanceBounds& Bounds, uint32_t Instance)
+{
+	return XMVectorSet(Bounds.MaxX[Instance], Bounds.MaxY[Instance], Bounds.MaxZ[Instance], 0.0f);
+}
+
+static float XM_CALLCONV GetHalfArea(FXMVECTOR Min, FXMVECTOR Max)
+{
+	XMFLOAT3 Size;
+	XMStoreFloat3(&Size, XMVectorMax(XMVectorSubtract(Max, Min), XMVectorZero()));
+	return Size.x * Size.y + Size.y * Size.z + Size.z * Size.x;
+}
+
+// Sets the box of Node from its instances or children, returns whether it changed.
+static bool FitNode(const FInstanceBounds& Bounds, FInstanceBVH& InOutBVH, uint32_t Node)
+{
+	FInstanceBVHNode& N = InOutBVH.Nodes[Node];
+	XMVECTOR Min, Max;
+	if (N.Count > 0)
+	{
+		Min = g_XMFltMax;
+		Max = XMVectorNegate(g_XMFltMax);
+		for (uint32_t Idx = N.First; Idx < N.First + N.Count; ++Idx)
+		{
+			Min = XMVectorMin(Min, LoadMin(Bounds, InOutBVH.Instances[Idx]));
+			Max = XMVectorMax(Max, LoadMax(Bounds, InOutBVH.Instances[Idx]));
+		}
+	}
+	else
+	{
+		const FInstanceBVHNode& Left = InOutBVH.Nodes[N.First];
+		const FInstanceBVHNode& Right = InOutBVH.Nodes[N.First + 1];
+		Min = XMVectorMin(XMLoadFloat3(&Left.Min), XMLoadFloat3(&Right.Min));
+		Max = XMVectorMax(XMLoadFloat3(&Left.Max), XMLoadFloat3(&Right.Max));
+	}
+	XMFLOAT3 NewMin, NewMax;
+	XMStoreFloat3(&NewMin, Min);
+	XMStoreFloat3(&NewMax, Max);
+	const bool bHasChanged = NewMin.x != N.Min.x || NewMin.y != N.Min.y || NewMin.z != N.Min.z || NewMax.x != N.Max.x || NewMax.y != N.Max.y ||
+		NewMax.z != N.Max.z;
+	N.Min = NewMin;
+	N.Max = NewMax;
+	return bHasChanged;
+}
+
+void BuildInstanceBVH(const FInstanceBounds& Bounds, FInstanceBVH& OutBVH)
+{
+	const uint32_t NumInstances = Bounds.NumInstances;
+	OutBVH.Nodes.clear();
+	OutBVH.Parents.clear();
+	OutBVH.Instances.resize(NumInstances);
+	OutBVH.Leaves.resize(NumInstances);
+	if (NumInstances == 0)
+	{
+		return;
+	}
+
+	// Boxes are copied next to their instance index and partitioned in place, so that every level of the build reads
+	// them in order.
+	eastl::vector<FBuildPrimitive> Primitives(NumInstances);
+	XMVECTOR CentroidMin = g_XMFltMax;
+	XMVECTOR CentroidMax = XMVectorNegate(g_XMFltMax);
+	for (uint32_t Instance = 0; Instance < NumInstances; ++Instance)
+	{
+		FBuildPrimitive& Primitive = Primitives[Instance];
+		const XMVECTOR Min = LoadMin(Bounds, Instance);
+		const XMVECTOR Max = LoadMax(Bounds, Instance);
+		XMStoreFloat3(&Primitive.Min, Min);
+		XMStoreFloat3(&Primitive.Max, Max);
+		Primitive.Instance = Instance;
+		const XMVECTOR Centroid = XMVectorScale(XMVectorAdd(Min, Max), 0.5f);
+		CentroidMin = XMVectorMin(CentroidMin, Centroid);
+		CentroidMax = XMVectorMax(CentroidMax, Centroid);
+	}
+
+	// Nodes get their boxes from RefitInstanceBVH(), the build only needs the centroid bounds.
+	OutBVH.Nodes.reserve(2 * (NumInstances / INSTANCE_BVH_MAX_LEAF_SIZE) + 1);
+	OutBVH.Parents.reserve(OutBVH.Nodes.capacity());
+	OutBVH.Nodes.push_back(FInstanceBVHNode{});
+	OutBVH.Parents.push_back(UINT32_MAX);
+
+	eastl::vector<FBuildTask> Tasks;
+	Tasks.push_back(FBuildTask{ 0, 0, NumInstances, 0 });
+	XMStoreFloat3(&Tasks.back().CentroidMin, CentroidMin);
+	XMStoreFloat3(&Tasks.back().CentroidMax, CentroidMax);
+	while (!Tasks.empty())
+	{
+		const FBuildTask Task = Tasks.back();
+		Tasks.pop_back();
+		const uint32_t Count = Task.End - Task.Begin;
+		if (Count <= INSTANCE_BVH_MAX_LEAF_SIZE)
+		{
+			OutBVH.Nodes[Task.Node].First = Task.Begin;
+			OutBVH.Nodes[Task.Node].Count = Count;
+			for (uint32_t Idx = Task.Begin; Idx < Task.End; ++Idx)
+			{
+				OutBVH.Instances[Idx] = Primitives[Idx].Instance;
+				OutBVH.Leaves[Primitives[Idx].Instance] = Task.Node;
+			}
+			continue;
+		}
+
+		const float* TaskCentroidMin = &Task.CentroidMin.x;
+		const float* TaskCentroidMax = &Task.CentroidMax.x;
+		uint32_t Axis = 0;
+		for (uint32_t Idx = 1; Idx < 3; ++Idx)
+		{
+			if (TaskCentroidMax[Idx] - TaskCentroidMin[Idx] > TaskCentroidMax[Axis] - TaskCentroidMin[Axis])
+			{
+				Axis = Idx;
+			}
+		}
+		const float AxisMin = TaskCentroidMin[Axis];
+		const float AxisExtent = TaskCentroidMax[Axis] - AxisMin;
+		const float ToBin = AxisExtent > 0.0f ? INSTANCE_BVH_NUM_BINS * (1.0f - 1.0e-6f) / AxisExtent : 0.0f;
+		auto GetCentroid = [Axis](const FBuildPrimitive& Primitive)
+		{
+			return 0.5f * ((&Primitive.Min.x)[Axis] + (&Primitive.Max.x)[Axis]);
+		};
+		auto GetBin = [&](const FBuildPrimitive& Primitive)
+		{
+			return XMMin((uint32_t)((GetCentroid(Primitive) - AxisMin) * ToBin), (uint32_t)INSTANCE_BVH_NUM_BINS - 1);
+		};
+
+		// Binned SAH split: the plane between two bins with the lowest sum of child areas times child instance counts.
+		uint32_t Mid = Task.Begin;
+		XMVECTOR ChildCentroidMin[2];
+		XMVECTOR ChildCentroidMax[2];
+		if (AxisExtent > 0.0f && Task.Depth < INSTANCE_BVH_MAX_SAH_DEPTH)
+		{
+			FBuildBin Bins[INSTANCE_BVH_NUM_BINS];
+			for (FBuildBin& Bin : Bins)
+			{
+				Bin.Min = Bin.CentroidMin = g_XMFltMax;
+				Bin.Max = Bin.CentroidMax = XMVectorNegate(g_XMFltMax);
+				Bin.Count = 0;
+			}
+			for (uint32_t Idx = Task.Begin; Idx < Task.End; ++Idx)
+			{
+				const FBuildPrimitive& Primitive = Primitives[Idx];
+				const XMVECTOR Min = XMLoadFloat3(&Primitive.Min);
+				const XMVECTOR Max = XMLoadFloat3(&Primitive.Max);
+				const XMVECTOR Centroid = XMVectorScale(XMVectorAdd(Min, Max), 0.5f);
+				FBuildBin& Bin = Bins[GetBin(Primitive)];
+				Bin.Min = XMVectorMin(Bin.Min, Min);
+				Bin.Max = XMVectorMax(Bin.Max, Max);
+				Bin.CentroidMin = XMVectorMin(Bin.CentroidMin, Centroid);
+				Bin.CentroidMax = XMVectorMax(Bin.CentroidMax, Centroid);
+				Bin.Count += 1;
+			}
+
+			float RightCosts[INSTANCE_BVH_NUM_BINS];
+			XMVECTOR Min = g_XMFltMax;
+			XMVECTOR Max = XMVectorNegate(g_XMFltMax);
+			uint32_t RightCount = 0;
+			for (uint32_t BinIdx = INSTANCE_BVH_NUM_BINS - 1; BinIdx > 0; --BinIdx)
+			{
+				Min = XMVectorMin(Min, Bins[BinIdx].Min);
+				Max = XMVectorMax(Max, Bins[BinIdx].Max);
+				RightCount += Bins[BinIdx].Count;
+				RightCosts[BinIdx] = GetHalfArea(Min, Max) * RightCount;
+			}
+			Min = g_XMFltMax;
+			Max = XMVectorNegate(g_XMFltMax);
+			uint32_t LeftCount = 0;
+			float BestCost = FLT_MAX;
+			uint32_t BestSplit = 0; // First bin of the right child.
+			uint32_t BestLeftCount = 0;
+			for (uint32_t BinIdx = 1; BinIdx < INSTANCE_BVH_NUM_BINS; ++BinIdx)
+			{
+				Min = XMVectorMin(Min, Bins[BinIdx - 1].Min);
+				Max = XMVectorMax(Max, Bins[BinIdx - 1].Max);
+				LeftCount += Bins[BinIdx - 1].Count;
+				const float Cost = GetHalfArea(Min, Max) * LeftCount + RightCosts[BinIdx];
+				if (LeftCount > 0 && LeftCount < Count && Cost < BestCost)
+				{
+					BestCost = Cost;
+					BestSplit = BinIdx;
+					BestLeftCount = LeftCount;
+				}
+			}
+
+			if (BestLeftCount > 0)
+			{
+				FBuildPrimitive* Range = Primitives.data();
+				uint32_t Left = Task.Begin;
+				uint32_t Right = Task.End;
+				while (Left < Right)
+				{
+					if (GetBin(Range[Left]) < BestSplit)
+					{
+						++Left;
+					}
+					else
+					{
+						eastl::swap(Range[Left], Range[--Right]);
+					}
+				}
+				Mid = Left;
+				EA_ASSERT(Mid == Task.Begin + BestLeftCount);
+
+				for (uint32_t Child = 0; Child < 2; ++Child)
+				{
+					ChildCentroidMin[Child] = g_XMFltMax;
+					ChildCentroidMax[Child] = XMVectorNegate(g_XMFltMax);
+				}
+				for (uint32_t BinIdx = 0; BinIdx < INSTANCE_BVH_NUM_BINS; ++BinIdx)
+				{
+					const uint32_t Child = BinIdx < BestSplit ? 0 : 1;
+					ChildCentroidMin[Child] = XMVectorMin(ChildCentroidMin[Child], Bins[BinIdx].CentroidMin);
+					ChildCentroidMax[Child] = XMVectorMax(ChildCentroidMax[Child], Bins[BinIdx].CentroidMax);
+				}
+			}
+		}
+		if (Mid == Task.Begin)
+		{
+			// All centroids are in one bin (or the node is too deep), split at the median.
+			Mid = Task.Begin + Count / 2;
+			if (AxisExtent > 0.0f)
+			{
+				eastl::nth_element(Primitives.begin() + Task.Begin, Primitives.begin() + Mid, Primitives.begin() + Task.End,
+					[&](const FBuildPrimitive& A, const FBuildPrimitive& B) { return GetCentroid(A) < GetCentroid(B); });
+			}
+			const uint32_t Ranges[2][2] = { { Task.Begin, Mid }, { Mid, Task.End } };
+			for (uint32_t Child = 0; Child < 2; ++Child)
+			{
+				ChildCentroidMin[Child] = g_XMFltMax;
+				ChildCentroidMax[Child] = XMVectorNegate(g_XMFltMax);
+				for (uint32_t Idx = Ranges[Child][0]; Idx < Ranges[Child][1]; ++Idx)
+				{
+					const XMVECTOR Centroid = XMVectorScale(XMVectorAdd(XMLoadFloat3(&Primitives[Idx].Min), XMLoadFloat3(&Primitives[Idx].Max)), 0.5f);
+					ChildCentroidMin[Child] = XMVectorMin(ChildCentroidMin[Child], Centroid);
+					ChildCentroidMax[Child] = XMVectorMax(ChildCentroidMax[Child], Centroid);
+				}
+			}
+		}
+
+		const auto FirstChild = (uint32_t)OutBVH.Nodes.size();
+		OutBVH.Nodes[Task.Node].First = FirstChild;
+		OutBVH.Nodes[Task.Node].Count = 0;
+		OutBVH.Nodes.push_back(FInstanceBVHNode{});
+		OutBVH.Nodes.push_back(FInstanceBVHNode{});
+		OutBVH.Parents.push_back(Task.Node);
+		OutBVH.Parents.push_back(Task.Node);
+
+		FBuildTask ChildTasks[2] = { { FirstChild, Task.Begin, Mid, Task.Depth + 1 }, { FirstChild + 1, Mid, Task.End, Task.Depth + 1 } };
+		for (uint32_t Child = 0; Child < 2; ++Child)
+		{
+			XMStoreFloat3(&ChildTasks[Child].CentroidMin, ChildCentroidMin[Child]);
+			XMStoreFloat3(&ChildTasks[Child].CentroidMax, ChildCentroidMax[Child]);
+			Tasks.push_back(ChildTasks[Child]);
+		}
+	}
+
+	RefitInstanceBVH(Bounds, OutBVH);
+}
+
+void RefitInstanceBVH(const FInstanceBounds& Bounds, FInstanceBVH& InOutBVH)
+{
+	for (auto Node = (uint32_t)InOutBVH.Nodes.size(); Node-- > 0;)
+	{
+		FitNode(Bounds, InOutBVH, Node);
+	}
+}
+
+void UpdateInstanceBVH(const FInstanceBounds& Bounds, const uint32_t* Instances, uint32_t NumInstances, FInstanceBVH& InOutBVH)
+{
+	// The boxes of all moved instances are final, so the path above a node that did not change is up to date.
+	for (uint32_t Idx = 0; Idx < NumInstances; ++Idx)
+	{
+		EA_ASSERT(Instances[Idx] < Bounds.NumInstances);
+		for (uint32_t Node = InOutBVH.Leaves[Instances[Idx]]; Node != UINT32_MAX && FitNode(Bounds, InOutBVH, Node); Node = InOutBVH.Parents[Node])
+		{
+		}
+	}
+}
+
+static void InitFrustum4(const XMFLOAT4 FrustumPlanes[6], FFrustum4& OutFrustum)
+{
+	for (uint32_t Plane = 0; Plane < 6; ++Plane)
+	{
+		OutFrustum.Planes[Plane] = FrustumPlanes[Plane];
+		const float* Normal = &FrustumPlanes[Plane].x;
+		for (uint32_t Axis = 0; Axis < 3; ++Axis)
+		{
+			OutFrustum.Normals[Plane][Axis] = XMVectorReplicate(Normal[Axis]);
+			OutFrustum.bPositive[Plane][Axis] = Normal[Axis] >= 0.0f;
+		}
+		OutFrustum.Distances[Plane] = XMVectorReplicate(FrustumPlanes[Plane].w);
+	}
+}
+
+// Lanes (bits) of the boxes that are not completely outside of one of the planes.
+static uint32_t GetVisibleBoxes(const FFrustum4& Frustum, const FBoxes4& Boxes)
+{
+	XMVECTOR Visible = XMVectorTrueInt();
+	for (uint32_t Plane = 0; Plane < 6; ++Plane)
+	{
+		XMVECTOR Distance = Frustum.Distances[Plane];
+		for (uint32_t Axis = 0; Axis < 3; ++Axis)
+		{
+			const XMVECTOR Corner = Frustum.bPositive[Plane][Axis] ? Boxes.Max[Axis] : Boxes.Min[Axis];
+			Distance = XMVectorAdd(Distance, XMVectorMultiply(Corner, Frustum.Normals[Plane][Axis]));
+		}
+		Visible = XMVectorAndInt(Visible, XMVectorGreaterOrEqual(Distance, XMVectorZero()));
+	}
+	uint32_t Lanes[4];
+	XMStoreInt4(Lanes, Visible);
+	return (Lanes[0] & 1) | (Lanes[1] & 2) | (Lanes[2] & 4) | (Lanes[3] & 8);
+}
+
+// 0 when the node is completely outside of a plane, 2 when it is completely inside of all of them, 1 otherwise.
+static uint32_t ClassifyNode(const FFrustum4& Frustum, const FInstanceBVHNode& Node)
+{
+	const float* Min = &Node.Min.x;
+	const float* Max = &Node.Max.x;
+	uint32_t Result = 2;
+	for (uint32_t Plane = 0; Plane < 6; ++Plane)
+	{
+		const float* Normal = &Frustum.Planes[Plane].x;
+		float FarDistance = Frustum.Planes[Plane].w;
+		float NearDistance = FarDistance;
+		for (uint32_t Axis = 0; Axis < 3; ++Axis)
+		{
+			FarDistance = FarDistance + (Frustum.bPositive[Plane][Axis] ? Max[Axis] : Min[Axis]) * Normal[Axis];
+			NearDistance = NearDistance + (Frustum.bPositive[Plane][Axis] ? Min[Axis] : Max[Axis]) * Normal[Axis];
+		}
+		if (FarDistance < 0.0f)
+		{
+			return 0;
+		}
+		if (NearDistance < 0.0f)
+		{
+			Result = 1;
+		}
+	}
+	return Result;
+}
+
+static void LoadBoxes4(const FInstanceBounds& Bounds, const uint32_t* Instances, uint32_t Count, FBoxes4& OutBoxes)
+{
+	EA_ASSERT(Count > 0 && Count <= 4);
+	uint32_t Lanes[4];
+	for (uint32_t Lane = 0; Lane < 4; ++Lane)
+	{
+		Lanes[Lane] = Instances[XMMin(Lane, Count - 1)];
+	}
+	OutBoxes.Min[0] = XMVectorSet(Bounds.MinX[Lanes[0]], Bounds.MinX[Lanes[1]], Bounds.MinX[Lanes[2]], Bounds.MinX[Lanes[3]]);
+	OutBoxes.Min[1] = XMVectorSet(Bounds.MinY[Lanes[0]], Bounds.MinY[Lanes[1]], Bounds.MinY[Lanes[2]], Bounds.MinY[Lanes[3]]);
+	OutBoxes.Min[2] = XMVectorSet(Bounds.MinZ[Lanes[0]], Bounds.MinZ[Lanes[1]], Bounds.MinZ[Lanes[2]], Bounds.MinZ[Lanes[3]]);
+	OutBoxes.Max[0] = XMVectorSet(Bounds.MaxX[Lanes[0]], Bounds.MaxX[Lanes[1]], Bounds.MaxX[Lanes[2]], Bounds.MaxX[Lanes[3]]);
+	OutBoxes.Max[1] = XMVectorSet(Bounds.MaxY[Lanes[0]], Bounds.MaxY[Lanes[1]], Bounds.MaxY[Lanes[2]], Bounds.MaxY[Lanes[3]]);
+	OutBoxes.Max[2] = XMVectorSet(Bounds.MaxZ[Lanes[0]], Bounds.MaxZ[Lanes[1]], Bounds.MaxZ[Lanes[2]], Bounds.MaxZ[Lanes[3]]);
+}
+
+uint32_t CullInstances(const FInstanceBounds& Bounds, const XMFLOAT4 FrustumPlanes[6], uint32_t* OutInstances)
+{
+	FFrustum4 Frustum;
+	InitFrustum4(FrustumPlanes, Frustum);
+
+	uint32_t NumVisible = 0;
+	for (uint32_t Instance = 0; Instance < Bounds.NumInstances; Instance += 4)
+	{
+		FBoxes4 Boxes;
+		Boxes.Min[0] = XMLoadFloat4((const XMFLOAT4*)&Bounds.MinX[Instance]);
+		Boxes.Min[1] = XMLoadFloat4((const XMFLOAT4*)&Bounds.MinY[Instance]);
+		Boxes.Min[2] = XMLoadFloat4((const XMFLOAT4*)&Bounds.MinZ[Instance]);
+		Boxes.Max[0] = XMLoadFloat4((const XMFLOAT4*)&Bounds.MaxX[Instance]);
+		Boxes.Max[1] = XMLoadFloat4((const XMFLOAT4*)&Bounds.MaxY[Instance]);
+		Boxes.Max[2] = XMLoadFloat4((const XMFLOAT4*)&Bounds.MaxZ[Instance]);
+		// Boxes past NumInstances are empty and never visible.
+		for (uint32_t Lanes = GetVisibleBoxes(Frustum, Boxes); Lanes != 0; Lanes &= Lanes - 1)
+		{
+			OutInstances[NumVisible++] = Instance + (Lanes & 1 ? 0 : Lanes & 2 ? 1 : Lanes & 4 ? 2 : 3);
+		}
+	}
+	return NumVisible;
+}
+
+uint32_t QueryInstanceBVH(const FInstanceBVH& BVH, const FInstanceBounds& Bounds, const XMFLOAT4 FrustumPlanes[6], uint32_t* OutInstances)
+{
+	if (BVH.Nodes.empty())
+	{
+		return 0;
+	}
+	FFrustum4 Frustum;
+	InitFrustum4(FrustumPlanes, Frustum);
+
+	uint32_t NumVisible = 0;
+	uint32_t Stack[INSTANCE_BVH_STACK_SIZE];
+	uint32_t StackSize = 0;
+	Stack[StackSize++] = 0;
+	while (StackSize > 0)
+	{
+		const uint32_t NodeIdx = Stack[--StackSize];
+		const FInstanceBVHNode& Node = BVH.Nodes[NodeIdx];
+		const uint32_t Class = ClassifyNode(Frustum, Node);
+		if (Class == 0)
+		{
+			continue;
+		}
+		if (Class == 2)
+		{
+			// The instances of a subtree are consecutive, from the first one of its leftmost leaf to the last one of its
+			// rightmost leaf.
+			uint32_t First = NodeIdx;
+			uint32_t Last = NodeIdx;
+			while (BVH.Nodes[First].Count == 0)
+			{
+				First = BVH.Nodes[First].First;
+			}
+			while (BVH.Nodes[Last].Count == 0)
+			{
+				Last = BVH.Nodes[Last].First + 1;
+			}
+			for (uint32_t Idx = BVH.Nodes[First].First; Idx < BVH.Nodes[Last].First + BVH.Nodes[Last].Count; ++Idx)
+			{
+				OutInstances[NumVisible++] = BVH.Instances[Idx];
+			}
+			continue;
+		}
+		if (Node.Count == 0)
+		{
+			EA_ASSERT(StackSize + 2 <= INSTANCE_BVH_STACK_SIZE);
+			Stack[StackSize++] = Node.First + 1;
+			Stack[StackSize++] = Node.First;
+			continue;
+		}
+
+		FBoxes4 Boxes;
+		LoadBoxes4(Bounds, &BVH.Instances[Node.First], Node.Count, Boxes);
+		const uint32_t Lanes = GetVisibleBoxes(Frustum, Boxes);
+		for (uint32_t Lane = 0; Lane < Node.Count; ++Lane)
+		{
+			if (Lanes & (1 << Lane))
+			{
+				OutInstances[NumVisible++] = BVH.Instances[Node.First + Lane];
+			}
+		}
+	}
+	return NumVisible;
+}
+
+static void InitRay4(const XMFLOAT3& Origin, const XMFLOAT3& Direction, float MaxDistance, FRay4& OutRay)
+{
+	const float* O = &Origin.x;
+	const float* D = &Direction.x;
+	for (uint32_t Axis = 0; Axis < 3; ++Axis)
+	{
+		const float Component = D[Axis] >= 0.0f ? XMMax(D[Axis], 1.0e-30f) : XMMin(D[Axis], -1.0e-30f);
+		OutRay.Origin[Axis] = XMVectorReplicate(O[Axis]);
+		OutRay.InvDirection[Axis] = XMVectorReplicate(1.0f / Component);
+		OutRay.bPositive[Axis] = Component > 0.0f;
+	}
+	OutRay.MaxDistance = XMVectorReplicate(MaxDistance);
+}
+
+// Distances at which the ray enters the boxes (zero when it starts inside), FLT_MAX for the ones it misses.
+static XMVECTOR XM_CALLCONV GetRayEntries(const FRay4& Ray, const FBoxes4& Boxes)
+{
+	XMVECTOR Entry = XMVectorZero();
+	XMVECTOR Exit = Ray.MaxDistance;
+	for (uint32_t Axis = 0; Axis < 3; ++Axis)
+	{
+		const XMVECTOR Near = Ray.bPositive[Axis] ? Boxes.Min[Axis] : Boxes.Max[Axis];
+		const XMVECTOR Far = Ray.bPositive[Axis] ? Boxes.Max[Axis] : Boxes.Min[Axis];
+		Entry = XMVectorMax(Entry, XMVectorMultiply(XMVectorSubtract(Near, Ray.Origin[Axis]), Ray.InvDirection[Axis]));
+		Exit = XMVectorMin(Exit, XMVectorMultiply(XMVectorSubtract(Far, Ray.Origin[Axis]), Ray.InvDirection[Axis]));
+	}
+	return XMVectorSelect(g_XMFltMax, Entry, XMVectorLessOrEqual(Entry, Exit));
+}
+
+static float GetNodeEntry(const FRay4& Ray, const FInstanceBVHNode& Node)
+{
+	FBoxes4 Boxes;
+	Boxes.Min[0] = XMVectorReplicate(Node.Min.x);
+	Boxes.Min[1] = XMVectorReplicate(Node.Min.y);
+	Boxes.Min[2] = XMVectorReplicate(Node.Min.z);
+	Boxes.Max[0] = XMVectorReplicate(Node.Max.x);
+	Boxes.Max[1] = XMVectorReplicate(Node.Max.y);
+	Boxes.Max[2] = XMVectorReplicate(Node.Max.z);
+	return XMVectorGetX(GetRayEntries(Ray, Boxes));
+}
+
+bool RayCastInstances(const FInstanceBounds& Bounds, const XMFLOAT3& Origin, const XMFLOAT3& Direction, float MaxDistance, uint32_t& OutInstance,
+	float& OutDistance)
+{
+	FRay4 Ray;
+	InitRay4(Origin, Direction, MaxDistance, Ray);
+
+	OutInstance = UINT32_MAX;
+	OutDistance = FLT_MAX;
+	for (uint32_t Instance = 0; Instance < Bounds.NumInstances; Instance += 4)
+	{
+		FBoxes4 Boxes;
+		Boxes.Min[0] = XMLoadFloat4((const XMFLOAT4*)&Bounds.MinX[Instance]);
+		Boxes.Min[1] = XMLoadFloat4((const XMFLOAT4*)&Bounds.MinY[Instance]);
+		Boxes.Min[2] = XMLoadFloat4((const XMFLOAT4*)&Bounds.MinZ[Instance]);
+		Boxes.Max[0] = XMLoadFloat4((const XMFLOAT4*)&Bounds.MaxX[Instance]);
+		Boxes.Max[1] = XMLoadFloat4((const XMFLOAT4*)&Bounds.MaxY[Instance]);
+		Boxes.Max[2] = XMLoadFloat4((const XMFLOAT4*)&Bounds.MaxZ[Instance]);
+		XMFLOAT4 Distances;
+		XMStoreFloat4(&Distances, GetRayEntries(Ray, Boxes));
+		for (uint32_t Lane = 0; Lane < 4; ++Lane)
+		{
+			if ((&Distances.x)[Lane] < OutDistance)
+			{
+				OutDistance = (&Distances.x)[Lane];
+				OutInstance = Instance + Lane;
+			}
+		}
+	}
+	return OutInstance != UINT32_MAX;
+}
+
+bool RayCastInstanceBVH(const FInstanceBVH& BVH, const FInstanceBounds& Bounds, const XMFLOAT3& Origin, const XMFLOAT3& Direction, float MaxDistance,
+	uint32_t& OutInstance, float& OutDistance)
+{
+	OutInstance = UINT32_MAX;
+	OutDistance = FLT_MAX;
+	if (BVH.Nodes.empty())
+	{
+		return false;
+	}
+	FRay4 Ray;
+	InitRay4(Origin, Direction, MaxDistance, Ray);
+
+	// Children are visited nearest first, subtrees that the ray enters after the closest hit so far are skipped (the ones
+	// that it enters at the same distance may have a tie with a lower instance index).
+	FRayStackEntry Stack[INSTANCE_BVH_STACK_SIZE];
+	uint32_t StackSize = 0;
+	Stack[StackSize++] = FRayStackEntry{ 0, GetNodeEntry(Ray, BVH.Nodes[0]) };
+	while (StackSize > 0)
+	{
+		const FRayStackEntry Entry = Stack[--StackSize];
+		if (Entry.Distance == FLT_MAX || Entry.Distance > OutDistance)
+		{
+			continue;
+		}
+		const FInstanceBVHNode& Node = BVH.Nodes[Entry.Node];
+		if (Node.Count == 0)
+		{
+			FRayStackEntry Left = { Node.First, GetNodeEntry(Ray, BVH.Nodes[Node.First]) };
+			FRayStackEntry Right = { Node.First + 1, GetNodeEntry(Ray, BVH.Nodes[Node.First + 1]) };
+			if (Left.Distance < Right.Distance)
+			{
+				eastl::swap(Left, Right);
+			}
+			EA_ASSERT(StackSize + 2 <= INSTANCE_BVH_STACK_SIZE);
+			Stack[StackSize++] = Left;
+			Stack[StackSize++] = Right;
+			continue;
+		}
+
+		FBoxes4 Boxes;
+		LoadBoxes4(Bounds, &BVH.Instances[Node.First], Node.Count, Boxes);
+		XMFLOAT4 Distances;
+		XMStoreFloat4(&Distances, GetRayEntries(Ray, Boxes));
+		for (uint32_t Lane = 0; Lane < Node.Count; ++Lane)
+		{
+			const float Distance = (&Distances.x)[Lane];
+			const uint32_t Instance = BVH.Instances[Node.First + Lane];
+			// Ties go to the lower instance index, like RayCastInstances().
+			if (Distance < OutDistance || (Distance == OutDistance && Distance != FLT_MAX && Instance < OutInstance))
+			{
+				OutDistance = Distance;
+				OutInstance = Instance;
+			}
+		}
+	}
+	return OutInstance != UINT32_MAX;
+}
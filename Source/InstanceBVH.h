@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdint.h>
+#include "EASTL/vector.h"
+#include "GLTFScene.h"
+
+// Spatial index over the instances of a scene. The world space boxes of the instances are kept in a structure of arrays
+// (FInstanceBounds) that is tested 4 boxes at a time, a bounding volume hierarchy over them is built top-down with a
+// binned surface area heuristic (Wald 2007) and answers frustum queries (instance culling) and ray casts (picking). When
+// instances move only their boxes and the nodes above them are refit (UpdateInstanceBVH()), the tree keeps its topology,
+// so queries get slower as instances move far from where they were at the last build.
+
+#define INSTANCE_BVH_MAX_LEAF_SIZE 4
+#define INSTANCE_BVH_NUM_BINS 16
+
+// World space boxes, one array per component, sized to a multiple of 4.
+struct FInstanceBounds
+{
+	uint32_t NumInstances;
+	eastl::vector<float> MinX;
+	eastl::vector<float> MinY;
+	eastl::vector<float> MinZ;
+	eastl::vector<float> MaxX;
+	eastl::vector<float> MaxY;
+	eastl::vector<float> MaxZ;
+};
+
+struct FInstanceBVHNode
+{
+	XMFLOAT3 Min;
+	uint32_t First; // Leaves: first of their Count entries of FInstanceBVH::Instances. Interior nodes: left child, the right one follows it.
+	XMFLOAT3 Max;
+	uint32_t Count; // Zero for interior nodes.
+};
+
+struct FInstanceBVH
+{
+	eastl::vector<FInstanceBVHNode> Nodes; // Nodes[0] is the root, children come after their parents. Empty without instances.
+	eastl::vector<uint32_t> Instances; // Grouped by leaf.
+	eastl::vector<uint32_t> Parents; // Per node, UINT32_MAX for the root.
+	eastl::vector<uint32_t> Leaves; // Per instance, the node that holds it.
+};
+
+// New boxes are empty (they are never visible or hit).
+void ResizeInstanceBounds(uint32_t NumInstances, FInstanceBounds& InOutBounds);
+
+// Box around the object space bounds of the instance's mesh, transformed by ObjectToWorld.
+void XM_CALLCONV SetInstanceBounds(FXMMATRIX ObjectToWorld, const FSceneBounds& MeshBounds, uint32_t Instance, FInstanceBounds& InOutBounds);
+
+void BuildInstanceBVH(const FInstanceBounds& Bounds, FInstanceBVH& OutBVH);
+
+// Recomputes the boxes of all nodes after any number of instance boxes changed.
+void RefitInstanceBVH(const FInstanceBounds& Bounds, FInstanceBVH& InOutBVH);
+
+// Recomputes the boxes of the nodes above the given instances only, stops at the nodes whose box does not change.
+// Cheaper than RefitInstanceBVH() as long as few instances moved.
+void UpdateInstanceBVH(const FInstanceBounds& Bounds, const uint32_t* Instances, uint32_t NumInstances, FInstanceBVH& InOutBVH);
+
+// Writes the instances whose box is not completely outside of one of the planes (normalized, inside is positive, see
+// GetFrustumPlanes()) to OutInstances, which must have room for all of them, and returns their count. Both functions
+// return the same set, CullInstances() tests every box, QueryInstanceBVH() in the order of the tree.
+uint32_t CullInstances(const FInstanceBounds& Bounds, const XMFLOAT4 FrustumPlanes[6], uint32_t* OutInstances);
+uint32_t QueryInstanceBVH(const FInstanceBVH& BVH, const FInstanceBounds& Bounds, const XMFLOAT4 FrustumPlanes[6], uint32_t* OutInstances);
+
+// Closest instance whose box the ray enters (or starts in) within MaxDistance (in units of Direction, which doesn't need
+// to be normalized), the lowest instance index on ties. Returns false when there is none. Both functions return the same
+// result, RayCastInstances() tests every box.
+bool RayCastInstances(const FInstanceBounds& Bounds, const XMFLOAT3& Origin, const XMFLOAT3& Direction, float MaxDistance, uint32_t& OutInstance,
+	float& OutDistance);
+bool RayCastInstanceBVH(const FInstanceBVH& BVH, const FInstanceBounds& Bounds, const XMFLOAT3& Origin, const XMFLOAT3& Direction, float MaxDistance,
+	uint32_t& OutInstance, float& OutDistance);
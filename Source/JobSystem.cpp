@@ -0,0 +1,246 @@
+#include "JobSystem.h"
+#include "EASTL/deque.h"
+#include "EAAssert/eaassert.h"
+#include "EAThread/eathread.h"
+#include "EAThread/eathread_thread.h"
+#include "EAThread/eathread_futex.h"
+#include "EAThread/eathread_semaphore.h"
+
+struct FJobQueue
+{
+	EA::Thread::Futex Lock;
+	eastl::deque<FJob> Jobs;
+};
+
+struct FWorkerContext
+{
+	FJobSystem* Jobs;
+	uint32_t ThreadIndex;
+};
+
+static thread_local uint32_t GThreadIndex = 0;
+
+// Only a job of Counter when it isn't null.
+static bool TakeJob(FJobQueue& Queue, const FJobCounter* Counter, bool bFromBack, FJob& OutJob)
+{
+	if (Queue.Jobs.empty())
+	{
+		return false;
+	}
+	if (!Counter)
+	{
+		if (bFromBack)
+		{
+			OutJob = Queue.Jobs.back();
+			Queue.Jobs.pop_back();
+		}
+		else
+		{
+			OutJob = Queue.Jobs.front();
+			Queue.Jobs.pop_front();
+		}
+		return true;
+	}
+	for (uint32_t Idx = 0, NumJobs = (uint32_t)Queue.Jobs.size(); Idx < NumJobs; ++Idx)
+	{
+		const auto It = Queue.Jobs.begin() + (bFromBack ? NumJobs - 1 - Idx : Idx);
+		if (It->Counter == Counter)
+		{
+			OutJob = *It;
+			Queue.Jobs.erase(It);
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool PopJob(FJobSystem& Jobs, uint32_t ThreadIndex, const FJobCounter* Counter, FJob& OutJob)
+{
+	const uint32_t NumQueues = (uint32_t)Jobs.Queues.size();
+
+	// Own queue first (newest job, its data is most likely still in cache).
+	{
+		FJobQueue& Queue = *Jobs.Queues[ThreadIndex];
+		Queue.Lock.Lock();
+		const bool bResult = TakeJob(Queue, Counter, true, OutJob);
+		Queue.Lock.Unlock();
+		if (bResult)
+		{
+			return true;
+		}
+	}
+	// Steal the oldest job from somebody else.
+	for (uint32_t Offset = 1; Offset < NumQueues; ++Offset)
+	{
+		FJobQueue& Queue = *Jobs.Queues[(ThreadIndex + Offset) % NumQueues];
+		if (!Queue.Lock.TryLock())
+		{
+			continue;
+		}
+		const bool bResult = TakeJob(Queue, Counter, false, OutJob);
+		Queue.Lock.Unlock();
+		if (bResult)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static void ExecuteJob(FJobSystem& Jobs, const FJob& Job)
+{
+	Jobs.NumQueuedJobs.Decrement();
+	Job.Function(Job.Context, Job.Begin, Job.End);
+	Job.Counter->NumPending.Decrement();
+}
+
+static intptr_t WorkerThread(void* Context)
+{
+	FWorkerContext* Worker = (FWorkerContext*)Context;
+	FJobSystem& Jobs = *Worker->Jobs;
+	GThreadIndex = Worker->ThreadIndex;
+
+	while (Jobs.bShouldQuit.GetValue() == 0)
+	{
+		FJob Job;
+		if (PopJob(Jobs, GThreadIndex, nullptr, Job))
+		{
+			ExecuteJob(Jobs, Job);
+		}
+		else if (Jobs.NumQueuedJobs.GetValue() == 0)
+		{
+			Jobs.WakeUpSemaphore->Wait();
+		}
+	}
+
+	delete Worker;
+	return 0;
+}
+
+void CreateJobSystem(uint32_t NumWorkers, FJobSystem& OutJobs)
+{
+	if (NumWorkers == JOB_SYSTEM_NO_WORKERS)
+	{
+		NumWorkers = 0;
+	}
+	else if (NumWorkers == 0)
+	{
+		const int NumCores = EA::Thread::GetProcessorCount();
+		NumWorkers = NumCores > 1 ? (uint32_t)(NumCores - 1) : 1;
+	}
+
+	OutJobs.NumWorkers = NumWorkers;
+	OutJobs.NumQueuedJobs.SetValue(0);
+	OutJobs.bShouldQuit.SetValue(0);
+	OutJobs.WakeUpSemaphore = new EA::Thread::Semaphore(0);
+
+	OutJobs.Queues.resize(NumWorkers + 1);
+	for (FJobQueue*& Queue : OutJobs.Queues)
+	{
+		Queue = new FJobQueue();
+	}
+
+	OutJobs.Threads = new EA::Thread::Thread[NumWorkers];
+	for (uint32_t Idx = 0; Idx < NumWorkers; ++Idx)
+	{
+		FWorkerContext* Worker = new FWorkerContext{ &OutJobs, Idx + 1 };
+		OutJobs.Threads[Idx].Begin(WorkerThread, Worker);
+	}
+}
+
+void DestroyJobSystem(FJobSystem& Jobs)
+{
+	Jobs.bShouldQuit.SetValue(1);
+	Jobs.WakeUpSemaphore->Post((int)Jobs.NumWorkers);
+
+	for (uint32_t Idx = 0; Idx < Jobs.NumWorkers; ++Idx)
+	{
+		Jobs.Threads[Idx].WaitForEnd();
+	}
+	delete[] Jobs.Threads;
+	delete Jobs.WakeUpSemaphore;
+
+	for (FJobQueue* Queue : Jobs.Queues)
+	{
+		EA_ASSERT(Queue->Jobs.empty());
+		delete Queue;
+	}
+	Jobs.Queues.clear();
+	Jobs.Threads = nullptr;
+	Jobs.WakeUpSemaphore = nullptr;
+	Jobs.NumWorkers = 0;
+}
+
+void SubmitJob(FJobSystem& Jobs, FJobFunction Function, void* Context, uint32_t Begin, uint32_t End, FJobCounter& Counter)
+{
+	Counter.NumPending.Increment();
+	Jobs.NumQueuedJobs.Increment();
+
+	FJobQueue& Queue = *Jobs.Queues[GThreadIndex];
+	Queue.Lock.Lock();
+	Queue.Jobs.push_back(FJob{ Function, Context, Begin, End, &Counter });
+	Queue.Lock.Unlock();
+
+	Jobs.WakeUpSemaphore->Post(1);
+}
+
+void WaitForCounter(FJobSystem& Jobs, FJobCounter& Counter)
+{
+	// Workers help with anything. Other threads (e.g. the render thread) only run jobs of Counter, so a long job somebody
+	// submitted without waiting for it can't end up running inline in a frame's ParallelFor.
+	const FJobCounter* Filter = GThreadIndex == 0 ? &Counter : nullptr;
+	while (Counter.NumPending.GetValue() > 0)
+	{
+		FJob Job;
+		if (PopJob(Jobs, GThreadIndex, Filter, Job))
+		{
+			ExecuteJob(Jobs, Job);
+		}
+		else
+		{
+			EA::Thread::ThreadSleep(EA::Thread::kTimeoutYield);
+		}
+	}
+}
+
+void ParallelFor(FJobSystem& Jobs, uint32_t Count, uint32_t Granularity, FJobFunction Function, void* Context)
+{
+	if (Count == 0)
+	{
+		return;
+	}
+	if (Granularity == 0)
+	{
+		// Aim for a few chunks per thread so that stealing can balance uneven work.
+		Granularity = eastl::max(1u, Count / (4 * GetNumThreads(Jobs)));
+	}
+
+	const uint32_t NumChunks = (Count + Granularity - 1) / Granularity;
+	if (NumChunks == 1)
+	{
+		Function(Context, 0, Count);
+		return;
+	}
+
+	FJobCounter Counter;
+	Counter.NumPending.SetValue((int32_t)NumChunks);
+	Jobs.NumQueuedJobs.Add((int32_t)NumChunks);
+
+	// Deal chunks round-robin so every worker starts with local work; stealing fixes the imbalance.
+	const uint32_t NumQueues = (uint32_t)Jobs.Queues.size();
+	for (uint32_t QueueIdx = 0; QueueIdx < NumQueues; ++QueueIdx)
+	{
+		FJobQueue& Queue = *Jobs.Queues[QueueIdx];
+		Queue.Lock.Lock();
+		for (uint32_t ChunkIdx = QueueIdx; ChunkIdx < NumChunks; ChunkIdx += NumQueues)
+		{
+			const uint32_t Begin = ChunkIdx * Granularity;
+			const uint32_t End = eastl::min(Begin + Granularity, Count);
+			Queue.Jobs.push_back(FJob{ Function, Context, Begin, End, &Counter });
+		}
+		Queue.Lock.Unlock();
+	}
+	Jobs.WakeUpSemaphore->Post((int)eastl::min(NumChunks, Jobs.NumWorkers));
+
+	WaitForCounter(Jobs, Counter);
+}
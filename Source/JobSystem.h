@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdint.h>
+#include "EASTL/vector.h"
+#include "EAThread/eathread_atomic.h"
+
+// Work-stealing thread pool. Every worker owns a job deque: it pops its own work from the back (LIFO, cache
+// friendly) and steals from the front of other workers' deques when it runs dry. Threads that wait for a job
+// counter execute pending jobs instead of blocking, so nested parallelism never deadlocks. Non-worker threads only
+// execute jobs of the counter they wait for, jobs that nobody waits for (background loads) run on the workers.
+
+typedef void (*FJobFunction)(void* Context, uint32_t Begin, uint32_t End);
+
+struct FJobCounter
+{
+	EA::Thread::AtomicInt32 NumPending;
+};
+
+struct FJob
+{
+	FJobFunction Function;
+	void* Context;
+	uint32_t Begin;
+	uint32_t End;
+	FJobCounter* Counter;
+};
+
+namespace EA { namespace Thread { class Thread; class Semaphore; } }
+
+struct FJobQueue;
+struct FJobSystem
+{
+	eastl::vector<FJobQueue*> Queues; // Queue 0 is shared by all non-worker threads.
+	EA::Thread::Thread* Threads;
+	EA::Thread::Semaphore* WakeUpSemaphore;
+	EA::Thread::AtomicInt32 NumQueuedJobs;
+	EA::Thread::AtomicInt32 bShouldQuit;
+	uint32_t NumWorkers;
+};
+
+// NumWorkers == 0 means one worker per logical core minus the calling thread but at least one, so background jobs that
+// nobody waits for still make progress on a single core machine. JOB_SYSTEM_NO_WORKERS means none (jobs run on the
+// threads that wait for them, e.g. to time the single threaded case).
+#define JOB_SYSTEM_NO_WORKERS UINT32_MAX
+void CreateJobSystem(uint32_t NumWorkers, FJobSystem& OutJobs);
+void DestroyJobSystem(FJobSystem& Jobs);
+
+void SubmitJob(FJobSystem& Jobs, FJobFunction Function, void* Context, uint32_t Begin, uint32_t End, FJobCounter& Counter);
+void WaitForCounter(FJobSystem& Jobs, FJobCounter& Counter);
+
+// Splits [0, Count) into chunks of at most Granularity elements and runs them on all workers and the calling thread.
+void ParallelFor(FJobSystem& Jobs, uint32_t Count, uint32_t Granularity, FJobFunction Function, void* Context);
+
+inline uint32_t GetNumThreads(const FJobSystem& Jobs)
+{
+	return Jobs.NumWorkers + 1;
+}
+
+template<typename TFunction>
+void ParallelFor(FJobSystem& Jobs, uint32_t Count, uint32_t Granularity, const TFunction& Function)
+{
+	struct FLocal
+	{
+		static void Run(void* Context, uint32_t Begin, uint32_t End)
+		{
+			(*(const TFunction*)Context)(Begin, End);
+		}
+	};
+	ParallelFor(Jobs, Count, Granularity, &FLocal::Run, (void*)&Function);
+}
@@ -3,7 +3,6 @@
 #include "d3dx12.h"
 #include "imgui/imgui.h"
 #include "EAStdC/EASprintf.h"
-#include "EAStdC/EATextUtil.h"
 #include "EAStdC/EABitTricks.h"
 
 #pragma comment(lib, "d3d12.lib")
@@ -122,6 +121,14 @@ void CreateGraphicsContext(HWND Window, bool bShouldCreateDepthBuffer, FGraphics
 
 	VHR(Gfx.Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, Gfx.CmdAlloc[0], nullptr, IID_PPV_ARGS(&Gfx.CmdList)));
 	VHR(Gfx.CmdList->Close());
+	for (uint32_t Idx = 0; Idx <= MAX_JOB_COMMAND_LISTS; ++Idx)
+	{
+		VHR(Gfx.Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&Gfx.JobCmdAllocs[0][Idx])));
+		VHR(Gfx.Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&Gfx.JobCmdAllocs[1][Idx])));
+		VHR(Gfx.Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, Gfx.JobCmdAllocs[0][Idx], nullptr, IID_PPV_ARGS(&Gfx.JobCmdLists[Idx])));
+		VHR(Gfx.JobCmdLists[Idx]->Close());
+	}
+	Gfx.NumJobCmdLists = 0;
 
 	VHR(Gfx.Device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&Gfx.FrameFence)));
 	Gfx.FrameFenceEvent = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
@@ -133,6 +140,12 @@ void DestroyGraphicsContext(FGraphicsContext& Gfx)
 {
 	CloseHandle(Gfx.FrameFenceEvent);
 	SAFE_RELEASE(Gfx.CmdList);
+	for (uint32_t Idx = 0; Idx <= MAX_JOB_COMMAND_LISTS; ++Idx)
+	{
+		SAFE_RELEASE(Gfx.JobCmdLists[Idx]);
+		SAFE_RELEASE(Gfx.JobCmdAllocs[0][Idx]);
+		SAFE_RELEASE(Gfx.JobCmdAllocs[1][Idx]);
+	}
 	SAFE_RELEASE(Gfx.RTVHeap.Heap);
 	SAFE_RELEASE(Gfx.DSVHeap.Heap);
 	for (uint32_t Idx = 0; Idx < 4; ++Idx)
@@ -142,10 +155,10 @@ void DestroyGraphicsContext(FGraphicsContext& Gfx)
 	for (uint32_t Idx = 0; Idx < 2; ++Idx)
 	{
 		SAFE_RELEASE(Gfx.CmdAlloc[Idx]);
-		SAFE_RELEASE(Gfx.GPUDescriptorHeaps[Idx].Heap);
-		SAFE_RELEASE(Gfx.GPUUploadMemoryHeaps[Idx].Heap);
 	}
+	SAFE_RELEASE(Gfx.PersistentDescriptorHeap.Heap);
 	SAFE_RELEASE(Gfx.CPUDescriptorHeap.Heap);
+	DestroyUploadRing(Gfx.Upload);
 	SAFE_RELEASE(Gfx.DepthStencilBuffer);
 	SAFE_RELEASE(Gfx.FrameFence);
 	SAFE_RELEASE(Gfx.SwapChain);
@@ -153,10 +166,50 @@ void DestroyGraphicsContext(FGraphicsContext& Gfx)
 	SAFE_RELEASE(Gfx.Device);
 }
 
+void BeginJobCommandLists(FGraphicsContext& Gfx, uint32_t NumLists)
+{
+	EA_ASSERT(Gfx.NumJobCmdLists == 0 && NumLists > 0 && NumLists <= MAX_JOB_COMMAND_LISTS);
+	VHR(Gfx.CmdList->Close());
+	Gfx.FrameCmdList = Gfx.CmdList;
+
+	// Resetting is cheap next to the recording, the jobs only record.
+	for (uint32_t Idx = 0; Idx <= NumLists; ++Idx)
+	{
+		ID3D12CommandAllocator* CmdAlloc = Gfx.JobCmdAllocs[Gfx.FrameIndex][Idx];
+		CmdAlloc->Reset();
+		Gfx.JobCmdLists[Idx]->Reset(CmdAlloc, nullptr);
+		Gfx.JobCmdLists[Idx]->SetDescriptorHeaps(1, &Gfx.GPUDescriptorHeaps[Gfx.FrameIndex].Heap);
+	}
+	Gfx.NumJobCmdLists = NumLists;
+	Gfx.CmdList = Gfx.JobCmdLists[NumLists];
+}
+
+void ExecuteFrameCommandLists(FGraphicsContext& Gfx)
+{
+	if (Gfx.NumJobCmdLists == 0)
+	{
+		VHR(Gfx.CmdList->Close());
+		Gfx.CmdQueue->ExecuteCommandLists(1, CommandListCast(&Gfx.CmdList));
+		return;
+	}
+
+	ID3D12CommandList* CmdLists[MAX_JOB_COMMAND_LISTS + 2];
+	CmdLists[0] = Gfx.FrameCmdList;
+	for (uint32_t Idx = 0; Idx <= Gfx.NumJobCmdLists; ++Idx)
+	{
+		VHR(Gfx.JobCmdLists[Idx]->Close());
+		CmdLists[Idx + 1] = Gfx.JobCmdLists[Idx];
+	}
+	Gfx.CmdQueue->ExecuteCommandLists(Gfx.NumJobCmdLists + 2, CmdLists);
+	Gfx.CmdList = Gfx.FrameCmdList;
+	Gfx.NumJobCmdLists = 0;
+}
+
 void PresentFrame(FGraphicsContext& Gfx, uint32_t SwapInterval)
 {
 	Gfx.SwapChain->Present(SwapInterval, 0);
 	Gfx.CmdQueue->Signal(Gfx.FrameFence, ++Gfx.FrameCount);
+	CloseUploadFrame(Gfx.Upload, Gfx.FrameCount);
 
 	const uint64_t GPUFrameCount = Gfx.FrameFence->GetCompletedValue();
 
@@ -169,17 +222,21 @@ void PresentFrame(FGraphicsContext& Gfx, uint32_t SwapInterval)
 	Gfx.FrameIndex = !Gfx.FrameIndex;
 	Gfx.BackBufferIndex = Gfx.SwapChain->GetCurrentBackBufferIndex();
 	Gfx.GPUDescriptorHeaps[Gfx.FrameIndex].Size = 0;
-	Gfx.GPUUploadMemoryHeaps[Gfx.FrameIndex].Size = 0;
+	const uint64_t CompletedFenceValue = Gfx.FrameFence->GetCompletedValue();
+	ReclaimUploadMemory(Gfx.Upload, CompletedFenceValue);
+	ReclaimDescriptorSlots(Gfx.PersistentDescriptors, CompletedFenceValue);
 }
 
 void WaitForGPU(FGraphicsContext& Gfx)
 {
 	Gfx.CmdQueue->Signal(Gfx.FrameFence, ++Gfx.FrameCount);
+	CloseUploadFrame(Gfx.Upload, Gfx.FrameCount);
 	Gfx.FrameFence->SetEventOnCompletion(Gfx.FrameCount, Gfx.FrameFenceEvent);
 	WaitForSingleObject(Gfx.FrameFenceEvent, INFINITE);
 
 	Gfx.GPUDescriptorHeaps[Gfx.FrameIndex].Size = 0;
-	Gfx.GPUUploadMemoryHeaps[Gfx.FrameIndex].Size = 0;
+	ReclaimUploadMemory(Gfx.Upload, Gfx.FrameCount);
+	ReclaimDescriptorSlots(Gfx.PersistentDescriptors, Gfx.FrameCount);
 }
 
 FDescriptorHeap& GetDescriptorHeap(FGraphicsContext& Gfx, D3D12_DESCRIPTOR_HEAP_TYPE Type, D3D12_DESCRIPTOR_HEAP_FLAGS Flags, uint32_t& OutDescriptorSize)
@@ -211,6 +268,26 @@ FDescriptorHeap& GetDescriptorHeap(FGraphicsContext& Gfx, D3D12_DESCRIPTOR_HEAP_
 	return Gfx.CPUDescriptorHeap;
 }
 
+// FUploadBackend of the upload ring: persistently mapped upload heap buffers.
+static bool CreateUploadMemory(void* Context, uint64_t Size, FUploadMemory& OutMemory)
+{
+	auto* Device = (ID3D12Device3*)Context;
+	ID3D12Resource* Buffer;
+	if (FAILED(Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE, &CD3DX12_RESOURCE_DESC::Buffer(Size), D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&Buffer))))
+	{
+		return false;
+	}
+	VHR(Buffer->Map(0, &CD3DX12_RANGE(0, 0), (void**)&OutMemory.CPUStart));
+	OutMemory.Resource = Buffer;
+	OutMemory.GPUStart = Buffer->GetGPUVirtualAddress();
+	return true;
+}
+
+static void DestroyUploadMemory(void* /*Context*/, const FUploadMemory& Memory)
+{
+	((ID3D12Resource*)Memory.Resource)->Release();
+}
+
 static void CreateHeaps(FGraphicsContext& Gfx)
 {
 	// Render target descriptor heap (RTV).
@@ -246,38 +323,40 @@ static void CreateHeaps(FGraphicsContext& Gfx)
 		VHR(Gfx.Device->CreateDescriptorHeap(&HeapDesc, IID_PPV_ARGS(&Gfx.CPUDescriptorHeap.Heap)));
 		Gfx.CPUDescriptorHeap.CPUStart = Gfx.CPUDescriptorHeap.Heap->GetCPUDescriptorHandleForHeapStart();
 	}
-	// Shader visible descriptor heaps (CBV, SRV, UAV).
+	// Shader visible descriptor heap (CBV, SRV, UAV), one for all frames since only one can be bound: the persistent
+	// descriptors, then the per-frame parts.
 	{
+		FDescriptorHeap& Persistent = Gfx.PersistentDescriptorHeap;
+		Persistent.Capacity = PERSISTENT_DESCRIPTOR_CAPACITY;
+
+		D3D12_DESCRIPTOR_HEAP_DESC HeapDesc = {};
+		HeapDesc.NumDescriptors = Persistent.Capacity + 2 * 16 * 1024;
+		HeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+		HeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+		VHR(Gfx.Device->CreateDescriptorHeap(&HeapDesc, IID_PPV_ARGS(&Persistent.Heap)));
+
+		Persistent.CPUStart = Persistent.Heap->GetCPUDescriptorHandleForHeapStart();
+		Persistent.GPUStart = Persistent.Heap->GetGPUDescriptorHandleForHeapStart();
+		CreateDescriptorSlots(Persistent.Capacity, Gfx.PersistentDescriptors);
+
 		for (uint32_t Idx = 0; Idx < 2; ++Idx)
 		{
 			FDescriptorHeap& Heap = Gfx.GPUDescriptorHeaps[Idx];
+			Heap.Heap = Persistent.Heap;
 			Heap.Capacity = 16 * 1024;
 
-			D3D12_DESCRIPTOR_HEAP_DESC HeapDesc = {};
-			HeapDesc.NumDescriptors = Heap.Capacity;
-			HeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-			HeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-			VHR(Gfx.Device->CreateDescriptorHeap(&HeapDesc, IID_PPV_ARGS(&Heap.Heap)));
-
-			Heap.CPUStart = Heap.Heap->GetCPUDescriptorHandleForHeapStart();
-			Heap.GPUStart = Heap.Heap->GetGPUDescriptorHandleForHeapStart();
+			const uint32_t Offset = Persistent.Capacity + Idx * Heap.Capacity;
+			Heap.CPUStart.ptr = Persistent.CPUStart.ptr + (size_t)Offset * Gfx.DescriptorSize;
+			Heap.GPUStart.ptr = Persistent.GPUStart.ptr + (uint64_t)Offset * Gfx.DescriptorSize;
 		}
 	}
-	// Upload Memory Heaps.
+	// Upload memory, pages are created as frames need them.
 	{
-		for (uint32_t Index = 0; Index < 2; ++Index)
-		{
-			FGPUMemoryHeap& UploadHeap = Gfx.GPUUploadMemoryHeaps[Index];
-			UploadHeap.Size = 0;
-			UploadHeap.Capacity = 8 * 1024 * 1024;
-			UploadHeap.CPUStart = nullptr;
-			UploadHeap.GPUStart = 0;
-
-			VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE, &CD3DX12_RESOURCE_DESC::Buffer(UploadHeap.Capacity), D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&UploadHeap.Heap)));
-
-			VHR(UploadHeap.Heap->Map(0, &CD3DX12_RANGE(0, 0), (void**)& UploadHeap.CPUStart));
-			UploadHeap.GPUStart = UploadHeap.Heap->GetGPUVirtualAddress();
-		}
+		FUploadBackend Backend;
+		Backend.Context = Gfx.Device;
+		Backend.CreateMemory = &CreateUploadMemory;
+		Backend.DestroyMemory = &DestroyUploadMemory;
+		CreateUploadRing(Backend, UPLOAD_PAGE_SIZE, Gfx.Upload);
 	}
 }
 
@@ -340,6 +419,7 @@ void CreateUIContext(FGraphicsContext& Gfx, uint32_t NumSamples, FUIContext& UI,
 
 	UI.FontSRV = AllocateDescriptors(Gfx, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 1);
 	Gfx.Device->CreateShaderResourceView(UI.Font, &SRVDesc, UI.FontSRV);
+	UI.FontDescriptor = CreatePersistentDescriptor(Gfx, UI.FontSRV);
 
 
 	D3D12_INPUT_ELEMENT_DESC InputElements[] =
@@ -480,7 +560,7 @@ void DrawUI(FGraphicsContext& Gfx, FUIContext& UI)
 
 	CmdList->SetGraphicsRootSignature(UI.RootSignature);
 	CmdList->SetGraphicsRootConstantBufferView(0, ConstantBufferGPUAddress);
-	CmdList->SetGraphicsRootDescriptorTable(1, CopyDescriptorsToGPUHeap(Gfx, 1, UI.FontSRV));
+	CmdList->SetGraphicsRootDescriptorTable(1, GetPersistentDescriptorTable(Gfx, UI.FontDescriptor));
 
 	CmdList->IASetVertexBuffers(0, 1, &Frame.VertexBufferView);
 	CmdList->IASetIndexBuffer(&Frame.IndexBufferView);
@@ -605,7 +685,11 @@ void GenerateMipmaps(FGraphicsContext& Gfx, FMipmapGenerator& Generator, ID3D12R
 			CmdList->SetComputeRoot32BitConstant(0, CurrentSrcMipLevel, 0);
 			CmdList->SetComputeRoot32BitConstant(0, NumMipsInDispatch, 1);
 			CmdList->SetComputeRootDescriptorTable(1, GPUHandle);
-			CmdList->Dispatch((UINT)(TextureDesc.Width >> (4 + CurrentSrcMipLevel)), TextureDesc.Height >> (4 + CurrentSrcMipLevel), 1);
+			// One 8x8 group reduces 16x16 source texels; sources smaller than that (the tail down to 1x1) still need a group,
+			// its threads past the edge only touch texels outside the generated mips.
+			const uint32_t NumGroupsX = XMMax(1u, (uint32_t)(TextureDesc.Width >> (4 + CurrentSrcMipLevel)));
+			const uint32_t NumGroupsY = XMMax(1u, TextureDesc.Height >> (4 + CurrentSrcMipLevel));
+			CmdList->Dispatch(NumGroupsX, NumGroupsY, 1);
 
 			{
 				const CD3DX12_RESOURCE_BARRIER Barriers[5] =
@@ -648,6 +732,119 @@ void GenerateMipmaps(FGraphicsContext& Gfx, FMipmapGenerator& Generator, ID3D12R
 	}
 }
 
+static uint64_t GetTextureFootprints(FGraphicsContext& Gfx, ID3D12Resource* Texture, eastl::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT>& OutLayouts, eastl::vector<uint32_t>& OutNumRows, eastl::vector<uint64_t>& OutRowSizes)
+{
+	const D3D12_RESOURCE_DESC Desc = Texture->GetDesc();
+	const uint32_t NumSubresources = Desc.MipLevels * Desc.DepthOrArraySize;
+
+	OutLayouts.resize(NumSubresources);
+	OutNumRows.resize(NumSubresources);
+	OutRowSizes.resize(NumSubresources);
+
+	uint64_t TotalSize;
+	Gfx.Device->GetCopyableFootprints(&Desc, 0, NumSubresources, 0, OutLayouts.data(), OutNumRows.data(), OutRowSizes.data(), &TotalSize);
+	return TotalSize;
+}
+
+ID3D12Resource* CreateTextureUploadBuffer(FGraphicsContext& Gfx, ID3D12Resource* Texture, const uint8_t* Data)
+{
+	eastl::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> Layouts;
+	eastl::vector<uint32_t> NumRows;
+	eastl::vector<uint64_t> RowSizes;
+	const uint64_t TotalSize = GetTextureFootprints(Gfx, Texture, Layouts, NumRows, RowSizes);
+
+	ID3D12Resource* UploadBuffer;
+	VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE, &CD3DX12_RESOURCE_DESC::Buffer(TotalSize), D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&UploadBuffer)));
+
+	uint8_t* Ptr;
+	VHR(UploadBuffer->Map(0, &CD3DX12_RANGE(0, 0), (void**)&Ptr));
+	for (uint32_t SubresourceIdx = 0; SubresourceIdx < Layouts.size(); ++SubresourceIdx)
+	{
+		const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& Layout = Layouts[SubresourceIdx];
+		for (uint32_t RowIdx = 0; RowIdx < NumRows[SubresourceIdx]; ++RowIdx)
+		{
+			memcpy(Ptr + Layout.Offset + (uint64_t)RowIdx * Layout.Footprint.RowPitch, Data, (size_t)RowSizes[SubresourceIdx]);
+			Data += RowSizes[SubresourceIdx];
+		}
+	}
+	UploadBuffer->Unmap(0, nullptr);
+	return UploadBuffer;
+}
+
+void CopyUploadBufferToTexture(FGraphicsContext& Gfx, ID3D12Resource* UploadBuffer, ID3D12Resource* Texture, uint32_t FirstSubresource, uint32_t NumSubresources)
+{
+	eastl::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> Layouts;
+	eastl::vector<uint32_t> NumRows;
+	eastl::vector<uint64_t> RowSizes;
+	GetTextureFootprints(Gfx, Texture, Layouts, NumRows, RowSizes);
+	EA_ASSERT(FirstSubresource + NumSubresources <= Layouts.size());
+
+	for (uint32_t SubresourceIdx = FirstSubresource; SubresourceIdx < FirstSubresource + NumSubresources; ++SubresourceIdx)
+	{
+		const auto Dest = CD3DX12_TEXTURE_COPY_LOCATION(Texture, SubresourceIdx);
+		const auto Src = CD3DX12_TEXTURE_COPY_LOCATION(UploadBuffer, Layouts[SubresourceIdx]);
+		Gfx.CmdList->CopyTextureRegion(&Dest, 0, 0, 0, &Src, nullptr);
+	}
+}
+
+void UploadTextureData(FGraphicsContext& Gfx, ID3D12Resource* Texture, const uint8_t* Data, eastl::vector<ID3D12Resource*>& OutTempResources)
+{
+	ID3D12Resource* UploadBuffer = CreateTextureUploadBuffer(Gfx, Texture, Data);
+	OutTempResources.push_back(UploadBuffer);
+
+	const D3D12_RESOURCE_DESC Desc = Texture->GetDesc();
+	CopyUploadBufferToTexture(Gfx, UploadBuffer, Texture, 0, Desc.MipLevels * Desc.DepthOrArraySize);
+}
+
+ID3D12Resource* CopyTextureToReadbackBuffer(FGraphicsContext& Gfx, ID3D12Resource* Texture)
+{
+	eastl::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> Layouts;
+	eastl::vector<uint32_t> NumRows;
+	eastl::vector<uint64_t> RowSizes;
+	const uint64_t TotalSize = GetTextureFootprints(Gfx, Texture, Layouts, NumRows, RowSizes);
+
+	ID3D12Resource* ReadbackBuffer;
+	VHR(Gfx.Device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK), D3D12_HEAP_FLAG_NONE, &CD3DX12_RESOURCE_DESC::Buffer(TotalSize), D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&ReadbackBuffer)));
+
+	for (uint32_t SubresourceIdx = 0; SubresourceIdx < Layouts.size(); ++SubresourceIdx)
+	{
+		const auto Dest = CD3DX12_TEXTURE_COPY_LOCATION(ReadbackBuffer, Layouts[SubresourceIdx]);
+		const auto Src = CD3DX12_TEXTURE_COPY_LOCATION(Texture, SubresourceIdx);
+		Gfx.CmdList->CopyTextureRegion(&Dest, 0, 0, 0, &Src, nullptr);
+	}
+	return ReadbackBuffer;
+}
+
+void ReadbackTextureData(FGraphicsContext& Gfx, ID3D12Resource* Texture, ID3D12Resource*& InOutReadbackBuffer, eastl::vector<uint8_t>& OutData)
+{
+	eastl::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> Layouts;
+	eastl::vector<uint32_t> NumRows;
+	eastl::vector<uint64_t> RowSizes;
+	const uint64_t TotalSize = GetTextureFootprints(Gfx, Texture, Layouts, NumRows, RowSizes);
+
+	uint64_t PackedSize = 0;
+	for (uint32_t SubresourceIdx = 0; SubresourceIdx < Layouts.size(); ++SubresourceIdx)
+	{
+		PackedSize += RowSizes[SubresourceIdx] * NumRows[SubresourceIdx];
+	}
+	OutData.resize((size_t)PackedSize);
+
+	const uint8_t* Ptr;
+	VHR(InOutReadbackBuffer->Map(0, &CD3DX12_RANGE(0, (SIZE_T)TotalSize), (void**)&Ptr));
+	uint8_t* Data = OutData.data();
+	for (uint32_t SubresourceIdx = 0; SubresourceIdx < Layouts.size(); ++SubresourceIdx)
+	{
+		const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& Layout = Layouts[SubresourceIdx];
+		for (uint32_t RowIdx = 0; RowIdx < NumRows[SubresourceIdx]; ++RowIdx)
+		{
+			memcpy(Data, Ptr + Layout.Offset + (uint64_t)RowIdx * Layout.Footprint.RowPitch, (size_t)RowSizes[SubresourceIdx]);
+			Data += RowSizes[SubresourceIdx];
+		}
+	}
+	InOutReadbackBuffer->Unmap(0, &CD3DX12_RANGE(0, 0));
+	SAFE_RELEASE(InOutReadbackBuffer);
+}
+
 eastl::vector<uint8_t> LoadFile(const char* Name)
 {
 	FILE* File = fopen(Name, "rb");
@@ -798,132 +995,3 @@ HWND CreateSimpleWindow(const char* Name, uint32_t Width, uint32_t Height)
 	EA_ASSERT(Window);
 	return Window;
 }
-
-void LoadPLYFile(const char* FileName, eastl::vector<XMFLOAT3>& InOutPositions, eastl::vector<XMFLOAT3>& InOutNormals, eastl::vector<XMFLOAT2>& InOutTexcoords, eastl::vector<uint32_t>& InOutTriangles)
-{
-	using namespace EA::StdC;
-	FILE* File = fopen(FileName, "r");
-	EA_ASSERT(File);
-
-	char LineBuffer[1024];
-	char Token[64];
-	uint32_t NumVertices = UINT32_MAX;
-	uint32_t NumTriangles = UINT32_MAX;
-
-	struct FProperty
-	{
-		const char* Name;
-		bool bIsPresent;
-	} Properties[] =
-	{
-		{ "x\n", false }, { "y\n", false }, { "z\n", false },
-		{ "nx\n", false }, { "ny\n", false }, { "nz\n", false },
-		{ "s\n", false }, { "t\n", false },
-	};
-	bool bHasPositions = false;
-	bool bHasNormals = false;
-	bool bHasTexcoords = false;
-
-	while (fgets(LineBuffer, sizeof(LineBuffer), File))
-	{
-		const char* Line = LineBuffer;
-		while (SplitTokenSeparated(Line, kLengthNull, ' ', Token, sizeof(Token), &Line))
-		{
-			if (Strcmp(Token, "comment") == 0 || Strcmp(Token, "format") == 0)
-			{
-				break; // Skip the line.
-			}
-			else if (Strcmp(Token, "vertex") == 0)
-			{
-				NumVertices = AtoU32(Line);
-			}
-			else if (Strcmp(Token, "face") == 0)
-			{
-				NumTriangles = AtoU32(Line);
-			}
-			else if (Strcmp(Token, "float") == 0)
-			{
-				for (uint32_t Idx = 0; Idx < eastl::size(Properties); ++Idx)
-				{
-					if (Strcmp(Line, Properties[Idx].Name) == 0)
-					{
-						Properties[Idx].bIsPresent = true;
-						break;
-					}
-				}
-			}
-			else if (Strcmp(Token, "end_header\n") == 0)
-			{
-				bHasPositions = Properties[0].bIsPresent && Properties[1].bIsPresent && Properties[2].bIsPresent;
-				bHasNormals = Properties[3].bIsPresent && Properties[4].bIsPresent && Properties[5].bIsPresent;
-				bHasTexcoords = Properties[6].bIsPresent && Properties[7].bIsPresent;
-				goto HeaderIsDone;
-			}
-		}
-	}
-HeaderIsDone:
-
-	EA_ASSERT(bHasPositions);
-	EA_ASSERT(NumVertices != UINT32_MAX);
-	EA_ASSERT(NumTriangles != UINT32_MAX);
-
-	InOutPositions.reserve(InOutPositions.size() + NumVertices);
-	if (bHasNormals)
-	{
-		InOutNormals.reserve(InOutNormals.size() + NumVertices);
-	}
-	if (bHasTexcoords)
-	{
-		InOutTexcoords.reserve(InOutTexcoords.size() + NumVertices);
-	}
-
-	for (uint32_t LineIdx = 0; LineIdx < NumVertices; ++LineIdx)
-	{
-		char* Line = fgets(LineBuffer, sizeof(LineBuffer), File);
-		EA_ASSERT(Line);
-
-		XMFLOAT3 Position;
-		Position.x = StrtoF32(Line, &Line);
-		Position.y = StrtoF32(Line, &Line);
-		Position.z = StrtoF32(Line, &Line);
-		InOutPositions.push_back(Position);
-
-		if (bHasNormals)
-		{
-			XMFLOAT3 Normal;
-			Normal.x = StrtoF32(Line, &Line);
-			Normal.y = StrtoF32(Line, &Line);
-			Normal.z = StrtoF32(Line, &Line);
-			InOutNormals.push_back(Normal);
-		}
-		if (bHasTexcoords)
-		{
-			XMFLOAT2 Texcoord;
-			Texcoord.x = StrtoF32(Line, &Line);
-			Texcoord.y = StrtoF32(Line, &Line);
-			InOutTexcoords.push_back(Texcoord);
-		}
-	}
-
-	InOutTriangles.reserve(InOutTriangles.size() + NumTriangles * 3);
-
-	for (uint32_t LineIdx = 0; LineIdx < NumTriangles; ++LineIdx)
-	{
-		char* Line = fgets(LineBuffer, sizeof(LineBuffer), File);
-		EA_ASSERT(Line);
-
-		uint32_t NumIndices = StrtoU32(Line, &Line, 10);
-		EA_ASSERT(NumIndices == 3);
-
-		uint32_t Triangle[3];
-		Triangle[0] = StrtoU32(Line, &Line, 10);
-		Triangle[1] = StrtoU32(Line, &Line, 10);
-		Triangle[2] = StrtoU32(Line, &Line, 10);
-
-		InOutTriangles.push_back(Triangle[0]);
-		InOutTriangles.push_back(Triangle[1]);
-		InOutTriangles.push_back(Triangle[2]);
-	}
-
-	fclose(File);
-}
@@ -6,6 +6,8 @@
 #include "EAAssert/eaassert.h"
 #include "EASTL/vector.h"
 #include "DirectXMath/DirectXMath.h"
+#include "DescriptorSlots.h"
+#include "UploadRing.h"
 
 #define VHR(hr) if (FAILED(hr)) { EA_ASSERT(0); }
 #define SAFE_RELEASE(obj) if ((obj)) { (obj)->Release(); (obj) = nullptr; }
@@ -19,14 +21,9 @@ struct FDescriptorHeap
 	uint32_t Capacity;
 };
 
-struct FGPUMemoryHeap
-{
-	ID3D12Resource* Heap;
-	uint8_t* CPUStart;
-	D3D12_GPU_VIRTUAL_ADDRESS GPUStart;
-	uint32_t Size;
-	uint32_t Capacity;
-};
+#define UPLOAD_PAGE_SIZE (8 * 1024 * 1024)
+#define PERSISTENT_DESCRIPTOR_CAPACITY 4096
+#define MAX_JOB_COMMAND_LISTS 32 // Recorded in parallel in one frame, see BeginJobCommandLists().
 
 struct FGraphicsContext
 {
@@ -34,6 +31,12 @@ struct FGraphicsContext
 	ID3D12GraphicsCommandList2* CmdList;
 	ID3D12CommandQueue* CmdQueue;
 	ID3D12CommandAllocator* CmdAlloc[2];
+	// Lists that jobs record while CmdList waits, and the one that continues CmdList after them. The lists are reused
+	// every frame, every one has an allocator per frame.
+	ID3D12GraphicsCommandList2* JobCmdLists[MAX_JOB_COMMAND_LISTS + 1];
+	ID3D12CommandAllocator* JobCmdAllocs[2][MAX_JOB_COMMAND_LISTS + 1];
+	ID3D12GraphicsCommandList2* FrameCmdList; // CmdList of the frame while it is continued by JobCmdLists[NumJobCmdLists].
+	uint32_t NumJobCmdLists; // This frame, zero until BeginJobCommandLists().
 	uint32_t Resolution[2];
 	uint32_t DescriptorSize;
 	uint32_t DescriptorSizeRTV;
@@ -45,8 +48,10 @@ struct FGraphicsContext
 	FDescriptorHeap RTVHeap;
 	FDescriptorHeap DSVHeap;
 	FDescriptorHeap CPUDescriptorHeap;
-	FDescriptorHeap GPUDescriptorHeaps[2];
-	FGPUMemoryHeap GPUUploadMemoryHeaps[2];
+	FDescriptorHeap PersistentDescriptorHeap; // Start of the shader visible heap, owns it.
+	FDescriptorHeap GPUDescriptorHeaps[2]; // Per-frame rest of the shader visible heap, reset by PresentFrame().
+	FDescriptorSlots PersistentDescriptors; // Of PersistentDescriptorHeap, released slots are reclaimed like the upload memory.
+	FUploadRing Upload; // Pages of UPLOAD_PAGE_SIZE, frames are closed by PresentFrame() and WaitForGPU().
 	ID3D12Fence* FrameFence;
 	HANDLE FrameFenceEvent;
 	uint64_t FrameCount;
@@ -59,6 +64,7 @@ struct FUIContext
 	ID3D12PipelineState* PipelineState;
 	ID3D12Resource* Font;
 	D3D12_CPU_DESCRIPTOR_HANDLE FontSRV;
+	FDescriptorHandle FontDescriptor; // Persistent copy of FontSRV.
 	struct FFrame
 	{
 		ID3D12Resource* VertexBuffer;
@@ -84,7 +90,16 @@ void CreateMipmapGenerator(FGraphicsContext& Gfx, DXGI_FORMAT Format, FMipmapGen
 void DestroyMipmapGenerator(FMipmapGenerator& Generator);
 void GenerateMipmaps(FGraphicsContext& Gfx, FMipmapGenerator& Generator, ID3D12Resource* Texture);
 
-void LoadPLYFile(const char* FileName, eastl::vector<XMFLOAT3>& InOutPositions, eastl::vector<XMFLOAT3>& InOutNormals, eastl::vector<XMFLOAT2>& InOutTexcoords, eastl::vector<uint32_t>& InOutTriangles);
+// Records copies of tightly packed texel data (D3D12 subresource order) to Texture, which must be in the COPY_DEST state.
+void UploadTextureData(FGraphicsContext& Gfx, ID3D12Resource* Texture, const uint8_t* Data, eastl::vector<ID3D12Resource*>& OutTempResources);
+// The two halves of UploadTextureData(). CreateTextureUploadBuffer() only uses the device, so the (large) copy to the
+// upload buffer can run on a worker thread, the copy commands can then be recorded a few subresources at a time.
+ID3D12Resource* CreateTextureUploadBuffer(FGraphicsContext& Gfx, ID3D12Resource* Texture, const uint8_t* Data);
+void CopyUploadBufferToTexture(FGraphicsContext& Gfx, ID3D12Resource* UploadBuffer, ID3D12Resource* Texture, uint32_t FirstSubresource, uint32_t NumSubresources);
+// Records copies of all subresources of Texture (COPY_SOURCE state) to a new readback buffer. When the GPU is done
+// ReadbackTextureData() returns tightly packed texel data and releases the buffer.
+ID3D12Resource* CopyTextureToReadbackBuffer(FGraphicsContext& Gfx, ID3D12Resource* Texture);
+void ReadbackTextureData(FGraphicsContext& Gfx, ID3D12Resource* Texture, ID3D12Resource*& InOutReadbackBuffer, eastl::vector<uint8_t>& OutData);
 
 void CreateGraphicsContext(HWND Window, bool bShouldCreateDepthBuffer, FGraphicsContext& Gfx);
 void DestroyGraphicsContext(FGraphicsContext& Gfx);
@@ -110,6 +125,21 @@ inline ID3D12GraphicsCommandList2* GetAndInitCommandList(FGraphicsContext& Gfx)
 	return Gfx.CmdList;
 }
 
+// Parallel recording: closes CmdList and resets NumLists lists (at most MAX_JOB_COMMAND_LISTS, one per job, see
+// GetJobCommandList()) and one more that becomes CmdList, so everything recorded after the jobs lands behind them. The
+// lists start without state, the descriptor heap is set. Once per frame, before ExecuteFrameCommandLists().
+void BeginJobCommandLists(FGraphicsContext& Gfx, uint32_t NumLists);
+// Closes CmdList and executes the lists of the frame with one ExecuteCommandLists(): CmdList alone or, after
+// BeginJobCommandLists(), the list it closed, the job lists in order and the continuation.
+void ExecuteFrameCommandLists(FGraphicsContext& Gfx);
+
+// Only the job that records list Idx may use it, the jobs must be done before ExecuteFrameCommandLists().
+inline ID3D12GraphicsCommandList2* GetJobCommandList(FGraphicsContext& Gfx, uint32_t Idx)
+{
+	EA_ASSERT(Idx < Gfx.NumJobCmdLists);
+	return Gfx.JobCmdLists[Idx];
+}
+
 inline D3D12_CPU_DESCRIPTOR_HANDLE AllocateDescriptors(FGraphicsContext& Gfx, D3D12_DESCRIPTOR_HEAP_TYPE Type, uint32_t Count)
 {
 	uint32_t DescriptorSize;
@@ -144,24 +174,54 @@ inline D3D12_GPU_DESCRIPTOR_HANDLE CopyDescriptorsToGPUHeap(FGraphicsContext& Gf
 	return GPUBaseHandle;
 }
 
-inline void* AllocateGPUMemory(FGraphicsContext& Gfx, uint32_t Size, D3D12_GPU_VIRTUAL_ADDRESS& OutGPUAddress)
+// Copy of a CPU heap descriptor to a persistent slot of the shader visible heap (see DescriptorSlots.h), which shaders
+// index through a table that starts at PersistentDescriptorHeap.GPUStart, so no frame needs to copy it again.
+inline FDescriptorHandle CreatePersistentDescriptor(FGraphicsContext& Gfx, D3D12_CPU_DESCRIPTOR_HANDLE SrcHandle)
 {
-	EA_ASSERT(Size > 0);
+	FDescriptorHandle Handle = DESCRIPTOR_HANDLE_INVALID;
+	if (!AllocateDescriptorSlot(Gfx.PersistentDescriptors, Handle))
+	{
+		EA_ASSERT(0);
+	}
+	D3D12_CPU_DESCRIPTOR_HANDLE CPUHandle;
+	CPUHandle.ptr = Gfx.PersistentDescriptorHeap.CPUStart.ptr + (size_t)GetDescriptorSlot(Handle) * Gfx.DescriptorSize;
+	Gfx.Device->CopyDescriptorsSimple(1, CPUHandle, SrcHandle, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	return Handle;
+}
 
-	if (Size & 0xff)
+// The slot is reused once the GPU is done with the frames recorded so far.
+inline void ReleasePersistentDescriptor(FGraphicsContext& Gfx, FDescriptorHandle Handle)
+{
+	if (!ReleaseDescriptorSlot(Gfx.PersistentDescriptors, Handle, Gfx.FrameCount + 1))
 	{
-		// Always align to 256 bytes.
-		Size = (Size + 255) & ~0xff;
+		EA_ASSERT(0);
 	}
+}
 
-	FGPUMemoryHeap& UploadHeap = Gfx.GPUUploadMemoryHeaps[Gfx.FrameIndex];
-	EA_ASSERT((UploadHeap.Size + Size) < UploadHeap.Capacity);
+// Single descriptor table of a persistent descriptor, for shaders that don't index.
+inline D3D12_GPU_DESCRIPTOR_HANDLE GetPersistentDescriptorTable(FGraphicsContext& Gfx, FDescriptorHandle Handle)
+{
+	EA_ASSERT(IsDescriptorHandleValid(Gfx.PersistentDescriptors, Handle));
+	D3D12_GPU_DESCRIPTOR_HANDLE GPUHandle;
+	GPUHandle.ptr = Gfx.PersistentDescriptorHeap.GPUStart.ptr + (uint64_t)GetDescriptorSlot(Handle) * Gfx.DescriptorSize;
+	return GPUHandle;
+}
 
-	void* CPUAddress = UploadHeap.CPUStart + UploadHeap.Size;
-	OutGPUAddress = UploadHeap.GPUStart + UploadHeap.Size;
+// Upload memory (see UploadRing.h) for the commands of the current frame, reclaimed once the GPU is done with them.
+inline void AllocateUploadMemory(FGraphicsContext& Gfx, uint64_t Size, FUploadAllocation& OutAllocation)
+{
+	if (!AllocateUpload(Gfx.Upload, Size, OutAllocation))
+	{
+		EA_ASSERT(0);
+	}
+}
 
-	UploadHeap.Size += Size;
-	return CPUAddress;
+inline void* AllocateGPUMemory(FGraphicsContext& Gfx, uint32_t Size, D3D12_GPU_VIRTUAL_ADDRESS& OutGPUAddress)
+{
+	FUploadAllocation Allocation;
+	AllocateUploadMemory(Gfx, Size, Allocation);
+	OutGPUAddress = Allocation.GPUAddress;
+	return Allocation.CPUAddress;
 }
 
 inline void GetBackBuffer(FGraphicsContext& Gfx, ID3D12Resource*& OutBuffer, D3D12_CPU_DESCRIPTOR_HANDLE& OutHandle)
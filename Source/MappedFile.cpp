@@ -0,0 +1,81 @@
+#include "MappedFile.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+bool OpenMappedFile(const char* FileName, FMappedFile& OutFile)
+{
+	OutFile = {};
+#ifdef _WIN32
+	HANDLE File = CreateFileA(FileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (File == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	LARGE_INTEGER Size;
+	if (!GetFileSizeEx(File, &Size) || Size.QuadPart == 0)
+	{
+		CloseHandle(File);
+		return false;
+	}
+	HANDLE Mapping = CreateFileMappingA(File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!Mapping)
+	{
+		CloseHandle(File);
+		return false;
+	}
+	const void* Data = MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!Data)
+	{
+		CloseHandle(Mapping);
+		CloseHandle(File);
+		return false;
+	}
+	OutFile.Data = (const uint8_t*)Data;
+	OutFile.Size = (uint64_t)Size.QuadPart;
+	OutFile.FileHandle = File;
+	OutFile.MappingHandle = Mapping;
+#else
+	const int File = open(FileName, O_RDONLY);
+	if (File < 0)
+	{
+		return false;
+	}
+	struct stat Stat;
+	if (fstat(File, &Stat) != 0 || Stat.st_size == 0)
+	{
+		close(File);
+		return false;
+	}
+	void* Data = mmap(nullptr, (size_t)Stat.st_size, PROT_READ, MAP_PRIVATE, File, 0);
+	close(File);
+	if (Data == MAP_FAILED)
+	{
+		return false;
+	}
+	OutFile.Data = (const uint8_t*)Data;
+	OutFile.Size = (uint64_t)Stat.st_size;
+#endif
+	return true;
+}
+
+void CloseMappedFile(FMappedFile& File)
+{
+	if (!File.Data)
+	{
+		return;
+	}
+#ifdef _WIN32
+	UnmapViewOfFile(File.Data);
+	CloseHandle((HANDLE)File.MappingHandle);
+	CloseHandle((HANDLE)File.FileHandle);
+#else
+	munmap((void*)File.Data, (size_t)File.Size);
+#endif
+	File = {};
+}
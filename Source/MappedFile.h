@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stdint.h>
+
+// Read-only memory mapping of a whole file. Data stays valid until CloseMappedFile().
+
+struct FMappedFile
+{
+	const uint8_t* Data;
+	uint64_t Size;
+	void* FileHandle;
+	void* MappingHandle;
+};
+
+bool OpenMappedFile(const char* FileName, FMappedFile& OutFile);
+void CloseMappedFile(FMappedFile& File);
@@ -0,0 +1,372 @@
+#include "MeshCluster.h"
+#include "MeshOptimize.h"
+#include "MeshSimplify.h"
+#include "EAAssert/eaassert.h"
+#include "EASTL/algorithm.h"
+#include "EASTL/sort.h"
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+struct FIndexRange
+{
+	uint32_t StartIndexLocation;
+	uint32_t IndexCount;
+	uint32_t BaseVertexLocation;
+};
+
+static void ComputeClusterBounds(const XMFLOAT3* Positions, const uint32_t* Indices, FSceneCluster& Cluster)
+{
+	XMVECTOR BoundsMin = g_XMFltMax;
+	XMVECTOR BoundsMax = XMVectorNegate(g_XMFltMax);
+	XMVECTOR NormalSum = XMVectorZero();
+	for (uint32_t Idx = 0; Idx < Cluster.IndexCount; Idx += 3)
+	{
+		const XMVECTOR P0 = XMLoadFloat3(&Positions[Indices[Idx + 0]]);
+		const XMVECTOR P1 = XMLoadFloat3(&Positions[Indices[Idx + 1]]);
+		const XMVECTOR P2 = XMLoadFloat3(&Positions[Indices[Idx + 2]]);
+		BoundsMin = XMVectorMin(BoundsMin, XMVectorMin(P0, XMVectorMin(P1, P2)));
+		BoundsMax = XMVectorMax(BoundsMax, XMVectorMax(P0, XMVectorMax(P1, P2)));
+		NormalSum = XMVectorAdd(NormalSum, XMVector3Normalize(XMVector3Cross(XMVectorSubtract(P1, P0), XMVectorSubtract(P2, P0))));
+	}
+
+	const XMVECTOR Center = XMVectorScale(XMVectorAdd(BoundsMin, BoundsMax), 0.5f);
+	XMVECTOR RadiusSq = XMVectorZero();
+	for (uint32_t Idx = 0; Idx < Cluster.IndexCount; ++Idx)
+	{
+		RadiusSq = XMVectorMax(RadiusSq, XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&Positions[Indices[Idx]]), Center)));
+	}
+	XMStoreFloat3(&Cluster.Center, Center);
+	Cluster.Radius = XMVectorGetX(XMVectorSqrt(RadiusSq));
+
+	// Degenerate triangles have a zero normal and don't widen the cone.
+	Cluster.ConeAxis = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	Cluster.ConeCutoff = 1.0f;
+	const float NormalSumLength = XMVectorGetX(XMVector3Length(NormalSum));
+	if (NormalSumLength < 1.0e-6f)
+	{
+		return;
+	}
+	const XMVECTOR Axis = XMVectorScale(NormalSum, 1.0f / NormalSumLength);
+	float MinCos = 1.0f;
+	for (uint32_t Idx = 0; Idx < Cluster.IndexCount; Idx += 3)
+	{
+		const XMVECTOR P0 = XMLoadFloat3(&Positions[Indices[Idx + 0]]);
+		const XMVECTOR Normal = XMVector3Cross(XMVectorSubtract(XMLoadFloat3(&Positions[Indices[Idx + 1]]), P0), XMVectorSubtract(XMLoadFloat3(&Positions[Indices[Idx + 2]]), P0));
+		const float Length = XMVectorGetX(XMVector3Length(Normal));
+		if (Length > 0.0f)
+		{
+			MinCos = XMMin(MinCos, XMVectorGetX(XMVector3Dot(Normal, Axis)) / Length);
+		}
+	}
+	XMStoreFloat3(&Cluster.ConeAxis, Axis);
+	Cluster.ConeCutoff = MinCos > 0.0f ? sqrtf(XMMax(1.0f - MinCos * MinCos, 0.0f)) : 1.0f;
+}
+
+// Distinct vertices of Triangle that are not in the cluster with Stamp.
+static uint32_t CountNewVertices(const uint32_t* Stamps, const uint32_t* Triangle, uint32_t Stamp)
+{
+	return (Stamps[Triangle[0]] != Stamp) + (Stamps[Triangle[1]] != Stamp && Triangle[1] != Triangle[0]) +
+		(Stamps[Triangle[2]] != Stamp && Triangle[2] != Triangle[0] && Triangle[2] != Triangle[1]);
+}
+
+// Greedy clustering of one index range: a cluster starts at the first unused triangle (in the order the range had) and
+// grows by the adjacent triangle that adds the fewest vertices, then the one closest to its center and normal. Writes
+// the new triangle order to OutIndices and the index count of every cluster to OutClusterSizes.
+static void BuildRangeClusters(const XMFLOAT3* Positions, const uint32_t* Indices, uint32_t NumIndices, uint32_t CacheSize, uint32_t* OutIndices,
+	eastl::vector<uint32_t>& OutClusterSizes)
+{
+	const uint32_t NumTriangles = NumIndices / 3;
+	uint32_t NumVertices = 0;
+	for (uint32_t Idx = 0; Idx < NumIndices; ++Idx)
+	{
+		NumVertices = XMMax(NumVertices, Indices[Idx] + 1);
+	}
+
+	// Triangles around every position (hard edges and attribute seams don't split clusters), the first
+	// LiveCounts[Position] of them are not in a cluster yet.
+	eastl::vector<uint32_t> Remap;
+	GetPositionRemap(Positions, NumVertices, Remap);
+	eastl::vector<uint32_t> Offsets(NumVertices + 1, 0);
+	eastl::vector<uint32_t> LiveCounts(NumVertices, 0);
+	eastl::vector<uint32_t> Adjacency(NumIndices);
+	for (uint32_t Idx = 0; Idx < NumIndices; ++Idx)
+	{
+		LiveCounts[Remap[Indices[Idx]]]++;
+	}
+	for (uint32_t Position = 0; Position < NumVertices; ++Position)
+	{
+		Offsets[Position + 1] = Offsets[Position] + LiveCounts[Position];
+		LiveCounts[Position] = 0;
+	}
+	for (uint32_t Idx = 0; Idx < NumIndices; ++Idx)
+	{
+		const uint32_t Position = Remap[Indices[Idx]];
+		Adjacency[Offsets[Position] + LiveCounts[Position]++] = Idx / 3;
+	}
+
+	eastl::vector<XMFLOAT3> Centroids(NumTriangles);
+	eastl::vector<XMFLOAT3> Normals(NumTriangles);
+	for (uint32_t Triangle = 0; Triangle < NumTriangles; ++Triangle)
+	{
+		const XMVECTOR P0 = XMLoadFloat3(&Positions[Indices[Triangle * 3 + 0]]);
+		const XMVECTOR P1 = XMLoadFloat3(&Positions[Indices[Triangle * 3 + 1]]);
+		const XMVECTOR P2 = XMLoadFloat3(&Positions[Indices[Triangle * 3 + 2]]);
+		XMStoreFloat3(&Centroids[Triangle], XMVectorScale(XMVectorAdd(P0, XMVectorAdd(P1, P2)), 1.0f / 3.0f));
+		XMStoreFloat3(&Normals[Triangle], XMVector3Normalize(XMVector3Cross(XMVectorSubtract(P1, P0), XMVectorSubtract(P2, P0))));
+	}
+
+	eastl::vector<bool> IsUsed(NumTriangles, false);
+	eastl::vector<uint32_t> Stamps(NumVertices, 0);
+	eastl::vector<uint32_t> ClusterVertices;
+	eastl::vector<uint32_t> ClusterTriangles;
+	eastl::vector<uint32_t> LocalIndices;
+	uint32_t NumOutIndices = 0;
+	uint32_t Stamp = 0;
+	OutClusterSizes.clear();
+	uint32_t NextSeed = 0;
+	for (;;)
+	{
+		// Next to the previous cluster when it has unused neighbors (the one whose vertices have the fewest of them,
+		// which fills gaps first), the first unused triangle otherwise.
+		uint32_t Seed = UINT32_MAX;
+		uint32_t BestNumLive = UINT32_MAX;
+		for (const uint32_t Vertex : ClusterVertices)
+		{
+			const uint32_t Position = Remap[Vertex];
+			for (uint32_t Idx = Offsets[Position]; Idx < Offsets[Position] + LiveCounts[Position]; ++Idx)
+			{
+				const uint32_t* Triangle = &Indices[Adjacency[Idx] * 3];
+				const uint32_t NumLive = LiveCounts[Remap[Triangle[0]]] + LiveCounts[Remap[Triangle[1]]] + LiveCounts[Remap[Triangle[2]]];
+				if (NumLive < BestNumLive)
+				{
+					Seed = Adjacency[Idx];
+					BestNumLive = NumLive;
+				}
+			}
+		}
+		if (Seed == UINT32_MAX)
+		{
+			while (NextSeed < NumTriangles && IsUsed[NextSeed])
+			{
+				++NextSeed;
+			}
+			if (NextSeed == NumTriangles)
+			{
+				break;
+			}
+			Seed = NextSeed;
+		}
+		++Stamp;
+		ClusterVertices.clear();
+		ClusterTriangles.clear();
+		XMVECTOR CentroidSum = XMVectorZero();
+		XMVECTOR NormalSum = XMVectorZero();
+		for (uint32_t Triangle = Seed; Triangle != UINT32_MAX;)
+		{
+			IsUsed[Triangle] = true;
+			ClusterTriangles.push_back(Triangle);
+			CentroidSum = XMVectorAdd(CentroidSum, XMLoadFloat3(&Centroids[Triangle]));
+			NormalSum = XMVectorAdd(NormalSum, XMLoadFloat3(&Normals[Triangle]));
+			for (uint32_t Corner = 0; Corner < 3; ++Corner)
+			{
+				const uint32_t Vertex = Indices[Triangle * 3 + Corner];
+				if (Stamps[Vertex] != Stamp)
+				{
+					Stamps[Vertex] = Stamp;
+					ClusterVertices.push_back(Vertex);
+				}
+				uint32_t* Live = &Adjacency[Offsets[Remap[Vertex]]];
+				uint32_t& LiveCount = LiveCounts[Remap[Vertex]];
+				*eastl::find(Live, Live + LiveCount, Triangle) = Live[LiveCount - 1];
+				--LiveCount;
+			}
+			if (ClusterTriangles.size() == CLUSTER_MAX_TRIANGLES)
+			{
+				break;
+			}
+
+			const XMVECTOR Center = XMVectorScale(CentroidSum, 1.0f / ClusterTriangles.size());
+			const XMVECTOR Axis = XMVector3Normalize(NormalSum);
+			uint32_t BestNumNewVertices = 3;
+			float BestScore = FLT_MAX;
+			Triangle = UINT32_MAX;
+			for (const uint32_t Vertex : ClusterVertices)
+			{
+				const uint32_t Position = Remap[Vertex];
+				for (uint32_t Idx = Offsets[Position]; Idx < Offsets[Position] + LiveCounts[Position]; ++Idx)
+				{
+					const uint32_t Candidate = Adjacency[Idx];
+					const uint32_t NumNewVertices = CountNewVertices(Stamps.data(), &Indices[Candidate * 3], Stamp);
+					if (ClusterVertices.size() + NumNewVertices > CLUSTER_MAX_VERTICES || NumNewVertices > BestNumNewVertices)
+					{
+						continue;
+					}
+					// Distance to the center, scaled by 1 to 3 as the normal turns away from the axis (both squared).
+					const float Scale = 2.0f - XMVectorGetX(XMVector3Dot(XMLoadFloat3(&Normals[Candidate]), Axis));
+					const float Score = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&Centroids[Candidate]), Center))) * Scale * Scale;
+					if (NumNewVertices < BestNumNewVertices || Score < BestScore)
+					{
+						Triangle = Candidate;
+						BestNumNewVertices = NumNewVertices;
+						BestScore = Score;
+					}
+				}
+			}
+		}
+
+		// Cache optimized with cluster local vertex indices (the cluster vertices are shaded together, Tipsify runs over
+		// at most CLUSTER_MAX_VERTICES of them).
+		const auto NumClusterIndices = (uint32_t)ClusterTriangles.size() * 3;
+		LocalIndices.clear();
+		for (const uint32_t Triangle : ClusterTriangles)
+		{
+			for (uint32_t Corner = 0; Corner < 3; ++Corner)
+			{
+				LocalIndices.push_back((uint32_t)(eastl::find(ClusterVertices.begin(), ClusterVertices.end(), Indices[Triangle * 3 + Corner]) - ClusterVertices.begin()));
+			}
+		}
+		OptimizeVertexCache(LocalIndices.data(), NumClusterIndices, (uint32_t)ClusterVertices.size(), CacheSize, &OutIndices[NumOutIndices]);
+		for (uint32_t Idx = NumOutIndices; Idx < NumOutIndices + NumClusterIndices; ++Idx)
+		{
+			OutIndices[Idx] = ClusterVertices[OutIndices[Idx]];
+		}
+		NumOutIndices += NumClusterIndices;
+		OutClusterSizes.push_back(NumClusterIndices);
+	}
+	EA_ASSERT(NumOutIndices == NumTriangles * 3);
+}
+
+void BuildClusters(FScene& InOutScene, uint32_t CacheSize)
+{
+	FScene& Scene = InOutScene;
+	EA_ASSERT(Scene.Clusters.empty());
+
+	eastl::vector<FIndexRange> Ranges;
+	for (const FSceneMesh& Mesh : Scene.Meshes)
+	{
+		Ranges.push_back(FIndexRange{ Mesh.StartIndexLocation, Mesh.IndexCount, Mesh.BaseVertexLocation });
+	}
+	for (const FSceneMeshLOD& LOD : Scene.LODs)
+	{
+		Ranges.push_back(FIndexRange{ LOD.StartIndexLocation, LOD.IndexCount, Scene.Meshes[LOD.MeshIndex].BaseVertexLocation });
+	}
+	eastl::sort(Ranges.begin(), Ranges.end(), [](const FIndexRange& A, const FIndexRange& B) { return A.StartIndexLocation < B.StartIndexLocation; });
+
+	eastl::vector<uint32_t> Source;
+	eastl::vector<uint32_t> ClusterSizes;
+	for (const FIndexRange& Range : Ranges)
+	{
+		const XMFLOAT3* Positions = &Scene.Positions[Range.BaseVertexLocation];
+		uint32_t* Indices = &Scene.Indices[Range.StartIndexLocation];
+		Source.assign(Indices, Indices + Range.IndexCount);
+		BuildRangeClusters(Positions, Source.data(), Range.IndexCount, CacheSize, Indices, ClusterSizes);
+
+		uint32_t Start = 0;
+		for (const uint32_t IndexCount : ClusterSizes)
+		{
+			FSceneCluster Cluster;
+			Cluster.IndexCount = IndexCount;
+			Cluster.StartIndexLocation = Range.StartIndexLocation + Start;
+			ComputeClusterBounds(Positions, &Indices[Start], Cluster);
+			Scene.Clusters.push_back(Cluster);
+			Start += IndexCount;
+		}
+	}
+}
+
+void GetClusterRange(const FSceneCluster* Clusters, uint32_t NumClusters, uint32_t StartIndexLocation, uint32_t IndexCount, uint32_t& OutFirstCluster,
+	uint32_t& OutNumClusters)
+{
+	const FSceneCluster* First = eastl::lower_bound(Clusters, Clusters + NumClusters, StartIndexLocation,
+		[](const FSceneCluster& Cluster, uint32_t Start) { return Cluster.StartIndexLocation < Start; });
+	const FSceneCluster* Last = First;
+	while (Last < Clusters + NumClusters && Last->StartIndexLocation < StartIndexLocation + IndexCount)
+	{
+		++Last;
+	}
+	OutFirstCluster = (uint32_t)(First - Clusters);
+	OutNumClusters = (uint32_t)(Last - First);
+}
+
+void XM_CALLCONV GetFrustumPlanes(FXMMATRIX ToClip, XMFLOAT4 OutPlanes[6])
+{
+	// Frustum planes (Gribb and Hartmann 2001) are sums and differences of the columns of ToClip.
+	const XMMATRIX ToClipT = XMMatrixTranspose(ToClip);
+	const XMVECTOR Planes[6] =
+	{
+		XMVectorAdd(ToClipT.r[3], ToClipT.r[0]), XMVectorSubtract(ToClipT.r[3], ToClipT.r[0]),
+		XMVectorAdd(ToClipT.r[3], ToClipT.r[1]), XMVectorSubtract(ToClipT.r[3], ToClipT.r[1]),
+		ToClipT.r[2], XMVectorSubtract(ToClipT.r[3], ToClipT.r[2]),
+	};
+	for (uint32_t Idx = 0; Idx < 6; ++Idx)
+	{
+		XMStoreFloat4(&OutPlanes[Idx], XMPlaneNormalize(Planes[Idx]));
+	}
+}
+
+void XM_CALLCONV InitClusterCullView(FXMMATRIX ObjectToWorld, CXMMATRIX WorldToClip, const XMFLOAT3& CameraPosition, FClusterCullView& OutView)
+{
+	GetFrustumPlanes(XMMatrixMultiply(ObjectToWorld, WorldToClip), OutView.FrustumPlanes);
+
+	XMVECTOR Determinant;
+	const XMMATRIX WorldToObject = XMMatrixInverse(&Determinant, ObjectToWorld);
+	XMStoreFloat3(&OutView.CameraPosition, XMVector3TransformCoord(XMLoadFloat3(&CameraPosition), WorldToObject));
+	OutView.bBackfaceCulling = XMVectorGetX(Determinant) > 0.0f;
+}
+
+uint32_t CullClusters(const FClusterCullView& View, const FSceneCluster* Clusters, uint32_t NumClusters, const void* Indices, uint32_t IndexSize,
+	void* OutIndices, FClusterCullStats& InOutStats)
+{
+	EA_ASSERT(IndexSize == 2 || IndexSize == 4);
+
+	// Visible clusters that follow each other in the index stream are copied together.
+	uint32_t NumOutIndices = 0;
+	uint32_t RunStart = 0;
+	uint32_t RunCount = 0;
+	for (uint32_t ClusterIdx = 0; ClusterIdx < NumClusters; ++ClusterIdx)
+	{
+		const FSceneCluster& Cluster = Clusters[ClusterIdx];
+		InOutStats.NumTriangles += Cluster.IndexCount / 3;
+
+		bool bIsVisible = true;
+		for (uint32_t Idx = 0; Idx < 6 && bIsVisible; ++Idx)
+		{
+			const XMFLOAT4& Plane = View.FrustumPlanes[Idx];
+			bIsVisible = Plane.x * Cluster.Center.x + Plane.y * Cluster.Center.y + Plane.z * Cluster.Center.z + Plane.w >= -Cluster.Radius;
+		}
+		if (!bIsVisible)
+		{
+			InOutStats.NumFrustumCulledTriangles += Cluster.IndexCount / 3;
+			continue;
+		}
+
+		// Every point P of the bounding sphere sees every normal N of the cone from behind (dot(P - Camera, N) > 0)
+		// when the angle between P - Camera and the axis is below 90 degrees minus the cone angle.
+		if (View.bBackfaceCulling && Cluster.ConeCutoff < 1.0f)
+		{
+			const float Dx = Cluster.Center.x - View.CameraPosition.x;
+			const float Dy = Cluster.Center.y - View.CameraPosition.y;
+			const float Dz = Cluster.Center.z - View.CameraPosition.z;
+			const float Distance = sqrtf(Dx * Dx + Dy * Dy + Dz * Dz);
+			if (Dx * Cluster.ConeAxis.x + Dy * Cluster.ConeAxis.y + Dz * Cluster.ConeAxis.z >= Cluster.ConeCutoff * Distance + Cluster.Radius * (1.0f + Cluster.ConeCutoff))
+			{
+				InOutStats.NumBackfaceCulledTriangles += Cluster.IndexCount / 3;
+				continue;
+			}
+		}
+
+		InOutStats.NumVisibleClusters++;
+		if (RunCount > 0 && RunStart + RunCount != Cluster.StartIndexLocation)
+		{
+			memcpy((uint8_t*)OutIndices + (size_t)NumOutIndices * IndexSize, (const uint8_t*)Indices + (size_t)RunStart * IndexSize, (size_t)RunCount * IndexSize);
+			NumOutIndices += RunCount;
+			RunCount = 0;
+		}
+		RunStart = RunCount > 0 ? RunStart : Cluster.StartIndexLocation;
+		RunCount += Cluster.IndexCount;
+	}
+	memcpy((uint8_t*)OutIndices + (size_t)NumOutIndices * IndexSize, (const uint8_t*)Indices + (size_t)RunStart * IndexSize, (size_t)RunCount * IndexSize);
+	InOutStats.NumClusters += NumClusters;
+	return NumOutIndices + RunCount;
+}
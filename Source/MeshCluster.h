@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+#include "GLTFScene.h"
+
+// Culling below the draw level. BuildClusters() splits the index range of every section and LOD into clusters
+// (meshlets) of at most CLUSTER_MAX_TRIANGLES triangles and CLUSTER_MAX_VERTICES vertices, grown over the triangle
+// adjacency so that they are compact and face one way. The triangles of a cluster are made consecutive, so a cluster is
+// only a bounding sphere, a normal cone and an index range of the scene's index stream. CullClusters() skips the
+// clusters that are outside of the view frustum or whose triangles all face away from the camera and copies the
+// indices of the others into a compacted index list.
+
+#define CLUSTER_MAX_VERTICES 64
+#define CLUSTER_MAX_TRIANGLES 124
+
+// Object space view of one instance.
+struct FClusterCullView
+{
+	XMFLOAT4 FrustumPlanes[6]; // Normalized, inside is positive.
+	XMFLOAT3 CameraPosition;
+	bool bBackfaceCulling; // Off for mirrored instances, whose triangles are seen with the opposite winding.
+};
+
+struct FClusterCullStats
+{
+	uint64_t NumClusters;
+	uint64_t NumVisibleClusters;
+	uint64_t NumTriangles;
+	uint64_t NumFrustumCulledTriangles;
+	uint64_t NumBackfaceCulledTriangles;
+};
+
+// Appends the clusters of every section and LOD to InOutScene.Clusters and reorders the triangles of those index ranges
+// cluster by cluster (each one cache optimized on its own). Must run after GenerateLODs().
+void BuildClusters(FScene& InOutScene, uint32_t CacheSize);
+
+// Clusters of the index range that starts at StartIndexLocation, found in a table sorted like FScene::Clusters.
+void GetClusterRange(const FSceneCluster* Clusters, uint32_t NumClusters, uint32_t StartIndexLocation, uint32_t IndexCount, uint32_t& OutFirstCluster,
+	uint32_t& OutNumClusters);
+
+// Normalized planes of the view frustum of a D3D projection (0 <= z <= w), inside is positive, in the space that ToClip
+// transforms from.
+void XM_CALLCONV GetFrustumPlanes(FXMMATRIX ToClip, XMFLOAT4 OutPlanes[6]);
+
+void XM_CALLCONV InitClusterCullView(FXMMATRIX ObjectToWorld, CXMMATRIX WorldToClip, const XMFLOAT3& CameraPosition, FClusterCullView& OutView);
+
+// Clusters must belong to the index range of one section or LOD, Indices is the index stream they refer to (IndexSize
+// is 2 or 4). Writes the indices of the visible clusters to OutIndices (which must have room for all of them) and
+// returns their count, InOutStats is accumulated.
+uint32_t CullClusters(const FClusterCullView& View, const FSceneCluster* Clusters, uint32_t NumClusters, const void* Indices, uint32_t IndexSize,
+	void* OutIndices, FClusterCullStats& InOutStats);
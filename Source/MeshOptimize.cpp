@@ -0,0 +1,469 @@
+#include "MeshOptimize.h"
+#include "EAAssert/eaassert.h"
+#include "EASTL/sort.h"
+#include <string.h>
+
+#define FETCH_CACHE_LINE_SIZE 64
+#define FETCH_CACHE_NUM_LINES 256
+// A cluster may end early once its ACMR is within this factor of the ACMR of the whole section.
+#define OVERDRAW_THRESHOLD 1.05f
+
+// FIFO post-transform cache: a vertex is cached while fewer than Size vertices entered the cache after it.
+struct FVertexCache
+{
+	eastl::vector<uint32_t> Timestamps;
+	uint32_t Time;
+	uint32_t Size;
+};
+
+static void InitVertexCache(FVertexCache& Cache, uint32_t NumVertices, uint32_t Size)
+{
+	Cache.Timestamps.assign(NumVertices, 0);
+	Cache.Time = Size + 1;
+	Cache.Size = Size;
+}
+
+static void FlushVertexCache(FVertexCache& Cache)
+{
+	Cache.Time += Cache.Size + 1;
+}
+
+// Returns true when the vertex has to be shaded.
+static bool AccessVertexCache(FVertexCache& Cache, uint32_t Vertex)
+{
+	if (Cache.Time - Cache.Timestamps[Vertex] <= Cache.Size)
+	{
+		return false;
+	}
+	Cache.Timestamps[Vertex] = Cache.Time++;
+	return true;
+}
+
+static bool IsSameVertex(const FScene& Scene, uint32_t A, uint32_t B)
+{
+	return memcmp(&Scene.Positions[A], &Scene.Positions[B], sizeof(XMFLOAT3)) == 0 && memcmp(&Scene.Normals[A], &Scene.Normals[B], sizeof(XMFLOAT3)) == 0 &&
+		memcmp(&Scene.Tangents[A], &Scene.Tangents[B], sizeof(XMFLOAT4)) == 0 && memcmp(&Scene.Texcoords[A], &Scene.Texcoords[B], sizeof(XMFLOAT2)) == 0 &&
+		(Scene.Colors.empty() || memcmp(&Scene.Colors[A], &Scene.Colors[B], sizeof(XMFLOAT4)) == 0);
+}
+
+static uint32_t HashVertex(const FScene& Scene, uint32_t Vertex)
+{
+	uint32_t Words[16];
+	memcpy(&Words[0], &Scene.Positions[Vertex], sizeof(XMFLOAT3));
+	memcpy(&Words[3], &Scene.Normals[Vertex], sizeof(XMFLOAT3));
+	memcpy(&Words[6], &Scene.Tangents[Vertex], sizeof(XMFLOAT4));
+	memcpy(&Words[10], &Scene.Texcoords[Vertex], sizeof(XMFLOAT2));
+	uint32_t NumWords = 12;
+	if (!Scene.Colors.empty())
+	{
+		memcpy(&Words[12], &Scene.Colors[Vertex], sizeof(XMFLOAT4));
+		NumWords = 16;
+	}
+	uint32_t Hash = 2166136261u;
+	for (uint32_t Idx = 0; Idx < NumWords; ++Idx)
+	{
+		Hash = (Hash ^ Words[Idx]) * 16777619u;
+	}
+	return Hash ^ (Hash >> 15);
+}
+
+// OutRemap[Vertex] is the first vertex of the range that is bitwise identical to it (open addressing hash table).
+static void DeduplicateVertices(const FScene& Scene, uint32_t BaseVertex, uint32_t NumVertices, eastl::vector<uint32_t>& OutRemap)
+{
+	uint32_t TableSize = 1;
+	while (TableSize < NumVertices * 2)
+	{
+		TableSize *= 2;
+	}
+	eastl::vector<uint32_t> Table(TableSize, UINT32_MAX);
+	OutRemap.resize(NumVertices);
+	for (uint32_t Vertex = 0; Vertex < NumVertices; ++Vertex)
+	{
+		uint32_t Slot = HashVertex(Scene, BaseVertex + Vertex) & (TableSize - 1);
+		while (Table[Slot] != UINT32_MAX && !IsSameVertex(Scene, BaseVertex + Table[Slot], BaseVertex + Vertex))
+		{
+			Slot = (Slot + 1) & (TableSize - 1);
+		}
+		if (Table[Slot] == UINT32_MAX)
+		{
+			Table[Slot] = Vertex;
+		}
+		OutRemap[Vertex] = Table[Slot];
+	}
+}
+
+// Tipsify: fans around a vertex emit all its remaining triangles, the next fanning vertex is the oldest one of the
+// emitted triangles that stays in the cache until its own triangles are emitted. When there is none the most recently
+// used vertex with remaining triangles is taken (dead-end stack), then the next one in input order.
+void OptimizeVertexCache(const uint32_t* Indices, uint32_t NumIndices, uint32_t NumVertices, uint32_t CacheSize, uint32_t* OutIndices)
+{
+	if (NumIndices == 0)
+	{
+		return;
+	}
+	const uint32_t NumTriangles = NumIndices / 3;
+
+	// Triangles that use each vertex.
+	eastl::vector<uint32_t> LiveTriangles(NumVertices, 0);
+	eastl::vector<uint32_t> Offsets(NumVertices + 1, 0);
+	eastl::vector<uint32_t> Adjacency(NumIndices);
+	for (uint32_t Idx = 0; Idx < NumIndices; ++Idx)
+	{
+		++LiveTriangles[Indices[Idx]];
+	}
+	for (uint32_t Vertex = 0; Vertex < NumVertices; ++Vertex)
+	{
+		Offsets[Vertex + 1] = Offsets[Vertex] + LiveTriangles[Vertex];
+	}
+	for (uint32_t Idx = 0; Idx < NumIndices; ++Idx)
+	{
+		Adjacency[Offsets[Indices[Idx]]++] = Idx / 3;
+	}
+	for (uint32_t Vertex = NumVertices; Vertex > 0; --Vertex)
+	{
+		Offsets[Vertex] = Offsets[Vertex - 1];
+	}
+	Offsets[0] = 0;
+
+	eastl::vector<uint32_t> CacheTimes(NumVertices, 0);
+	eastl::vector<uint8_t> IsEmitted(NumTriangles, 0);
+	eastl::vector<uint32_t> DeadEnds;
+	eastl::vector<uint32_t> Candidates;
+	uint32_t Time = CacheSize + 1;
+	uint32_t Cursor = 0;
+	uint32_t NumOutIndices = 0;
+	uint32_t Fanning = Indices[0];
+	while (Fanning != UINT32_MAX)
+	{
+		Candidates.clear();
+		for (uint32_t Idx = Offsets[Fanning]; Idx < Offsets[Fanning + 1]; ++Idx)
+		{
+			const uint32_t Triangle = Adjacency[Idx];
+			if (IsEmitted[Triangle])
+			{
+				continue;
+			}
+			IsEmitted[Triangle] = 1;
+			for (uint32_t Corner = 0; Corner < 3; ++Corner)
+			{
+				const uint32_t Vertex = Indices[Triangle * 3 + Corner];
+				OutIndices[NumOutIndices++] = Vertex;
+				DeadEnds.push_back(Vertex);
+				Candidates.push_back(Vertex);
+				--LiveTriangles[Vertex];
+				if (Time - CacheTimes[Vertex] > CacheSize)
+				{
+					CacheTimes[Vertex] = Time++;
+				}
+			}
+		}
+
+		Fanning = UINT32_MAX;
+		int32_t BestPriority = -1;
+		for (uint32_t Vertex : Candidates)
+		{
+			if (LiveTriangles[Vertex] == 0)
+			{
+				continue;
+			}
+			const uint32_t Age = Time - CacheTimes[Vertex];
+			const int32_t Priority = Age + 2 * LiveTriangles[Vertex] <= CacheSize ? (int32_t)Age : 0;
+			if (Priority > BestPriority)
+			{
+				BestPriority = Priority;
+				Fanning = Vertex;
+			}
+		}
+		while (Fanning == UINT32_MAX && !DeadEnds.empty())
+		{
+			const uint32_t Vertex = DeadEnds.back();
+			DeadEnds.pop_back();
+			if (LiveTriangles[Vertex] > 0)
+			{
+				Fanning = Vertex;
+			}
+		}
+		for (; Fanning == UINT32_MAX && Cursor < NumIndices; ++Cursor)
+		{
+			if (LiveTriangles[Indices[Cursor]] > 0)
+			{
+				Fanning = Indices[Cursor];
+			}
+		}
+	}
+	EA_ASSERT(NumOutIndices == NumTriangles * 3);
+}
+
+struct FTriangleCluster
+{
+	uint32_t FirstTriangle;
+	uint32_t NumTriangles;
+	float SortKey;
+};
+
+// Splits a cache optimized triangle order into clusters and draws the ones that face away from the center of the
+// section first. Clusters start where the cache is cold anyway (a triangle whose three vertices miss) and, inside
+// those, as soon as the ACMR of the cluster so far is within OVERDRAW_THRESHOLD of the section's.
+static void OptimizeOverdraw(const XMFLOAT3* Positions, uint32_t NumVertices, uint32_t* Indices, uint32_t NumIndices, uint32_t CacheSize)
+{
+	const uint32_t NumTriangles = NumIndices / 3;
+	if (NumTriangles == 0)
+	{
+		return;
+	}
+
+	FVertexCache Cache;
+	InitVertexCache(Cache, NumVertices, CacheSize);
+	eastl::vector<uint32_t> HardStarts;
+	uint32_t NumMisses = 0;
+	for (uint32_t Triangle = 0; Triangle < NumTriangles; ++Triangle)
+	{
+		uint32_t TriangleMisses = 0;
+		for (uint32_t Corner = 0; Corner < 3; ++Corner)
+		{
+			TriangleMisses += AccessVertexCache(Cache, Indices[Triangle * 3 + Corner]) ? 1 : 0;
+		}
+		if (Triangle == 0 || TriangleMisses == 3)
+		{
+			HardStarts.push_back(Triangle);
+		}
+		NumMisses += TriangleMisses;
+	}
+	HardStarts.push_back(NumTriangles);
+	const float MaxClusterACMR = OVERDRAW_THRESHOLD * NumMisses / NumTriangles;
+
+	eastl::vector<FTriangleCluster> Clusters;
+	for (size_t HardIdx = 0; HardIdx + 1 < HardStarts.size(); ++HardIdx)
+	{
+		const uint32_t End = HardStarts[HardIdx + 1];
+		uint32_t ClusterStart = HardStarts[HardIdx];
+		uint32_t ClusterMisses = 0;
+		FlushVertexCache(Cache);
+		for (uint32_t Triangle = ClusterStart; Triangle < End; ++Triangle)
+		{
+			for (uint32_t Corner = 0; Corner < 3; ++Corner)
+			{
+				ClusterMisses += AccessVertexCache(Cache, Indices[Triangle * 3 + Corner]) ? 1 : 0;
+			}
+			if (Triangle + 1 == End || ClusterMisses <= MaxClusterACMR * (Triangle + 1 - ClusterStart))
+			{
+				Clusters.push_back(FTriangleCluster{ ClusterStart, Triangle + 1 - ClusterStart, 0.0f });
+				ClusterStart = Triangle + 1;
+				ClusterMisses = 0;
+				FlushVertexCache(Cache);
+			}
+		}
+	}
+	if (Clusters.size() < 2)
+	{
+		return;
+	}
+
+	// Area weighted centroids and normals (the cross product points out of clockwise front faces).
+	eastl::vector<XMFLOAT3> ClusterCentroids(Clusters.size());
+	eastl::vector<XMFLOAT3> ClusterNormals(Clusters.size());
+	XMVECTOR SectionCentroid = XMVectorZero();
+	float SectionArea = 0.0f;
+	for (size_t ClusterIdx = 0; ClusterIdx < Clusters.size(); ++ClusterIdx)
+	{
+		const FTriangleCluster& Cluster = Clusters[ClusterIdx];
+		XMVECTOR Centroid = XMVectorZero();
+		XMVECTOR Normal = XMVectorZero();
+		float Area = 0.0f;
+		for (uint32_t Triangle = Cluster.FirstTriangle; Triangle < Cluster.FirstTriangle + Cluster.NumTriangles; ++Triangle)
+		{
+			const XMVECTOR P0 = XMLoadFloat3(&Positions[Indices[Triangle * 3 + 0]]);
+			const XMVECTOR P1 = XMLoadFloat3(&Positions[Indices[Triangle * 3 + 1]]);
+			const XMVECTOR P2 = XMLoadFloat3(&Positions[Indices[Triangle * 3 + 2]]);
+			const XMVECTOR Cross = XMVector3Cross(XMVectorSubtract(P1, P0), XMVectorSubtract(P2, P0));
+			const float TriangleArea = XMVectorGetX(XMVector3Length(Cross));
+			Centroid = XMVectorMultiplyAdd(XMVectorAdd(XMVectorAdd(P0, P1), P2), XMVectorReplicate(TriangleArea / 3.0f), Centroid);
+			Normal = XMVectorAdd(Normal, Cross);
+			Area += TriangleArea;
+		}
+		SectionCentroid = XMVectorAdd(SectionCentroid, Centroid);
+		SectionArea += Area;
+		XMStoreFloat3(&ClusterCentroids[ClusterIdx], Area > 0.0f ? XMVectorScale(Centroid, 1.0f / Area) : Centroid);
+		XMStoreFloat3(&ClusterNormals[ClusterIdx], XMVector3Normalize(Normal));
+	}
+	if (SectionArea > 0.0f)
+	{
+		SectionCentroid = XMVectorScale(SectionCentroid, 1.0f / SectionArea);
+	}
+	for (size_t ClusterIdx = 0; ClusterIdx < Clusters.size(); ++ClusterIdx)
+	{
+		const XMVECTOR Direction = XMVectorSubtract(XMLoadFloat3(&ClusterCentroids[ClusterIdx]), SectionCentroid);
+		Clusters[ClusterIdx].SortKey = XMVectorGetX(XMVector3Dot(Direction, XMLoadFloat3(&ClusterNormals[ClusterIdx])));
+	}
+	eastl::stable_sort(Clusters.begin(), Clusters.end(), [](const FTriangleCluster& A, const FTriangleCluster& B) { return A.SortKey > B.SortKey; });
+
+	const eastl::vector<uint32_t> Source(Indices, Indices + NumIndices);
+	uint32_t NumOutIndices = 0;
+	for (const FTriangleCluster& Cluster : Clusters)
+	{
+		memcpy(&Indices[NumOutIndices], &Source[Cluster.FirstTriangle * 3], Cluster.NumTriangles * 3 * sizeof(uint32_t));
+		NumOutIndices += Cluster.NumTriangles * 3;
+	}
+	EA_ASSERT(NumOutIndices == NumIndices);
+}
+
+void OptimizeScene(FScene& InOutScene, uint32_t CacheSize)
+{
+	FScene& Scene = InOutScene;
+	EA_ASSERT(Scene.Normals.size() == Scene.Positions.size() && Scene.Tangents.size() == Scene.Positions.size() && Scene.Texcoords.size() == Scene.Positions.size());
+	EA_ASSERT(Scene.Colors.empty() || Scene.Colors.size() == Scene.Positions.size());
+	EA_ASSERT(Scene.LODs.empty() && Scene.Clusters.empty());
+
+	// Sections that share a BaseVertexLocation share the vertices up to the next one.
+	eastl::vector<uint32_t> Bases;
+	for (const FSceneMesh& Mesh : Scene.Meshes)
+	{
+		Bases.push_back(Mesh.BaseVertexLocation);
+	}
+	eastl::sort(Bases.begin(), Bases.end());
+	Bases.erase(eastl::unique(Bases.begin(), Bases.end()), Bases.end());
+	eastl::vector<eastl::vector<uint32_t>> RangeSections(Bases.size());
+	for (uint32_t MeshIdx = 0; MeshIdx < (uint32_t)Scene.Meshes.size(); ++MeshIdx)
+	{
+		RangeSections[eastl::lower_bound(Bases.begin(), Bases.end(), Scene.Meshes[MeshIdx].BaseVertexLocation) - Bases.begin()].push_back(MeshIdx);
+	}
+
+	// Per section triangle lists: deduplicated, without degenerate triangles, cache and overdraw optimized.
+	eastl::vector<eastl::vector<uint32_t>> SectionIndices(Scene.Meshes.size());
+	eastl::vector<uint32_t> Remap;
+	eastl::vector<uint32_t> Triangles;
+	for (size_t RangeIdx = 0; RangeIdx < Bases.size(); ++RangeIdx)
+	{
+		const uint32_t Base = Bases[RangeIdx];
+		const uint32_t NumVertices = (RangeIdx + 1 < Bases.size() ? Bases[RangeIdx + 1] : (uint32_t)Scene.Positions.size()) - Base;
+		DeduplicateVertices(Scene, Base, NumVertices, Remap);
+		for (uint32_t MeshIdx : RangeSections[RangeIdx])
+		{
+			const FSceneMesh& Mesh = Scene.Meshes[MeshIdx];
+			Triangles.clear();
+			for (uint32_t Idx = 0; Idx + 2 < Mesh.IndexCount; Idx += 3)
+			{
+				const uint32_t* Triangle = &Scene.Indices[Mesh.StartIndexLocation + Idx];
+				EA_ASSERT(Triangle[0] < NumVertices && Triangle[1] < NumVertices && Triangle[2] < NumVertices);
+				const uint32_t I0 = Remap[Triangle[0]];
+				const uint32_t I1 = Remap[Triangle[1]];
+				const uint32_t I2 = Remap[Triangle[2]];
+				if (I0 != I1 && I1 != I2 && I2 != I0)
+				{
+					Triangles.push_back(I0);
+					Triangles.push_back(I1);
+					Triangles.push_back(I2);
+				}
+			}
+			eastl::vector<uint32_t>& Indices = SectionIndices[MeshIdx];
+			Indices.resize(Triangles.size());
+			OptimizeVertexCache(Triangles.data(), (uint32_t)Triangles.size(), NumVertices, CacheSize, Indices.data());
+			OptimizeOverdraw(&Scene.Positions[Base], NumVertices, Indices.data(), (uint32_t)Indices.size(), CacheSize);
+		}
+	}
+
+	// Vertex fetch order: every range is renumbered in the order its sections first reference the vertices.
+	eastl::vector<XMFLOAT3> Positions;
+	eastl::vector<XMFLOAT3> Normals;
+	eastl::vector<XMFLOAT4> Tangents;
+	eastl::vector<XMFLOAT2> Texcoords;
+	eastl::vector<XMFLOAT4> Colors;
+	Positions.reserve(Scene.Positions.size());
+	Normals.reserve(Scene.Positions.size());
+	Tangents.reserve(Scene.Positions.size());
+	Texcoords.reserve(Scene.Positions.size());
+	Colors.reserve(Scene.Colors.size());
+	for (size_t RangeIdx = 0; RangeIdx < Bases.size(); ++RangeIdx)
+	{
+		const uint32_t OldBase = Bases[RangeIdx];
+		const uint32_t NewBase = (uint32_t)Positions.size();
+		const uint32_t NumVertices = (RangeIdx + 1 < Bases.size() ? Bases[RangeIdx + 1] : (uint32_t)Scene.Positions.size()) - OldBase;
+		Remap.assign(NumVertices, UINT32_MAX);
+		for (uint32_t MeshIdx : RangeSections[RangeIdx])
+		{
+			for (uint32_t& Index : SectionIndices[MeshIdx])
+			{
+				if (Remap[Index] == UINT32_MAX)
+				{
+					Remap[Index] = (uint32_t)Positions.size() - NewBase;
+					Positions.push_back(Scene.Positions[OldBase + Index]);
+					Normals.push_back(Scene.Normals[OldBase + Index]);
+					Tangents.push_back(Scene.Tangents[OldBase + Index]);
+					Texcoords.push_back(Scene.Texcoords[OldBase + Index]);
+					if (!Scene.Colors.empty())
+					{
+						Colors.push_back(Scene.Colors[OldBase + Index]);
+					}
+				}
+				Index = Remap[Index];
+			}
+			Scene.Meshes[MeshIdx].BaseVertexLocation = NewBase;
+		}
+	}
+	Scene.Positions = eastl::move(Positions);
+	Scene.Normals = eastl::move(Normals);
+	Scene.Tangents = eastl::move(Tangents);
+	Scene.Texcoords = eastl::move(Texcoords);
+	Scene.Colors = eastl::move(Colors);
+
+	Scene.Indices.clear();
+	for (size_t MeshIdx = 0; MeshIdx < Scene.Meshes.size(); ++MeshIdx)
+	{
+		Scene.Meshes[MeshIdx].StartIndexLocation = (uint32_t)Scene.Indices.size();
+		Scene.Meshes[MeshIdx].IndexCount = (uint32_t)SectionIndices[MeshIdx].size();
+		Scene.Indices.insert(Scene.Indices.end(), SectionIndices[MeshIdx].begin(), SectionIndices[MeshIdx].end());
+	}
+}
+
+void AnalyzeVertexCache(const FScene& Scene, uint32_t VertexStride, uint32_t CacheSize, FVertexCacheStats& OutStats)
+{
+	const uint32_t NumVertices = (uint32_t)Scene.Positions.size();
+	FVertexCache Cache;
+	InitVertexCache(Cache, NumVertices, CacheSize);
+	eastl::vector<uint32_t> LastSection(NumVertices, UINT32_MAX);
+	uint64_t FetchTags[FETCH_CACHE_NUM_LINES];
+	memset(FetchTags, 0xff, sizeof(FetchTags));
+
+	uint64_t NumTriangles = 0;
+	uint64_t NumUniqueVertices = 0;
+	uint64_t NumMisses = 0;
+	uint64_t NumLineReads = 0;
+	uint64_t NumLineHits = 0;
+	for (uint32_t MeshIdx = 0; MeshIdx < (uint32_t)Scene.Meshes.size(); ++MeshIdx)
+	{
+		const FSceneMesh& Mesh = Scene.Meshes[MeshIdx];
+		FlushVertexCache(Cache);
+		for (uint32_t Idx = 0; Idx < Mesh.IndexCount; ++Idx)
+		{
+			const uint32_t Vertex = Mesh.BaseVertexLocation + Scene.Indices[Mesh.StartIndexLocation + Idx];
+			EA_ASSERT(Vertex < NumVertices);
+			if (LastSection[Vertex] != MeshIdx)
+			{
+				LastSection[Vertex] = MeshIdx;
+				++NumUniqueVertices;
+			}
+			if (!AccessVertexCache(Cache, Vertex))
+			{
+				continue;
+			}
+			++NumMisses;
+			const uint64_t FirstLine = (uint64_t)Vertex * VertexStride / FETCH_CACHE_LINE_SIZE;
+			const uint64_t LastLine = ((uint64_t)Vertex * VertexStride + VertexStride - 1) / FETCH_CACHE_LINE_SIZE;
+			for (uint64_t Line = FirstLine; Line <= LastLine; ++Line)
+			{
+				uint64_t& Tag = FetchTags[Line % FETCH_CACHE_NUM_LINES];
+				NumLineHits += Tag == Line ? 1 : 0;
+				Tag = Line;
+				++NumLineReads;
+			}
+		}
+		NumTriangles += Mesh.IndexCount / 3;
+	}
+
+	OutStats.ACMR = NumTriangles > 0 ? (float)((double)NumMisses / NumTriangles) : 0.0f;
+	OutStats.ATVR = NumUniqueVertices > 0 ? (float)((double)NumMisses / NumUniqueVertices) : 0.0f;
+	OutStats.FetchHitRate = NumLineReads > 0 ? (float)((double)NumLineHits / NumLineReads) : 0.0f;
+	OutStats.Overfetch = NumVertices > 0 ? (float)((double)(NumLineReads - NumLineHits) * FETCH_CACHE_LINE_SIZE / ((uint64_t)NumVertices * VertexStride)) : 0.0f;
+	OutStats.NumVertices = NumVertices;
+	OutStats.NumTriangles = (uint32_t)NumTriangles;
+}
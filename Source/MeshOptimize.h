@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+#include "GLTFScene.h"
+
+// Mesh processing stage run before a scene is cooked. OptimizeScene():
+// - merges bitwise identical vertices (all attributes) and drops the triangles that become degenerate,
+// - reorders the triangles of every section for the post-transform vertex cache (Tipsify, Sander et al. 2007),
+// - splits that order into clusters and sorts them so that outward facing clusters are drawn first, which reduces
+//   overdraw at a bounded cost in cache misses (the linear clustering of the same paper),
+// - renumbers vertices in the order the new index stream first references them, so vertex fetch walks memory
+//   sequentially; unreferenced vertices are dropped.
+// Sections that share a vertex range (same BaseVertexLocation) keep sharing it, instances and materials are untouched.
+
+// Post-transform cache size (FIFO entries) the demo optimizes for.
+#define VERTEX_CACHE_SIZE 16
+
+struct FVertexCacheStats
+{
+	float ACMR; // Vertex shader invocations per triangle (0.5 is the ideal for a regular grid, 3 the worst case).
+	float ATVR; // Vertex shader invocations per unique vertex of a section (1 is the ideal).
+	float FetchHitRate; // Fraction of the 64 byte lines read by vertex fetch that hit a 16 KB direct-mapped cache.
+	float Overfetch; // Bytes of the lines that miss that cache per byte of vertex data (1 is the ideal).
+	uint32_t NumVertices;
+	uint32_t NumTriangles;
+};
+
+void OptimizeScene(FScene& InOutScene, uint32_t CacheSize);
+
+// Tipsify triangle order of a single index list.
+void OptimizeVertexCache(const uint32_t* Indices, uint32_t NumIndices, uint32_t NumVertices, uint32_t CacheSize, uint32_t* OutIndices);
+
+// CPU simulation of drawing every section once: a FIFO post-transform cache of CacheSize entries that is flushed
+// between sections, and a fetch cache that reads VertexStride bytes per shaded vertex.
+void AnalyzeVertexCache(const FScene& Scene, uint32_t VertexStride, uint32_t CacheSize, FVertexCacheStats& OutStats);
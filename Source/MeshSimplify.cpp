@@ -0,0 +1,556 @@
+#include "MeshSimplify.h"
+#include "MeshOptimize.h"
+#include "EAAssert/eaassert.h"
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+// Weight of the border quadrics relative to the triangle quadrics.
+#define BORDER_WEIGHT 10.0f
+// A collapse is rejected when it turns a triangle normal by more than acos(0.25) (about 75 degrees).
+#define MIN_FLIP_COSINE 0.25f
+// GenerateLODs() stops at this total error (relative to the bounds diagonal of the section) or triangle count, or when a
+// LOD would keep more than 3/4 of the triangles of the previous one.
+#define LOD_MAX_ERROR 0.05f
+#define LOD_MIN_TRIANGLES 32
+
+enum
+{
+	VERTEX_Manifold, VERTEX_Border, VERTEX_Seam, VERTEX_Locked,
+};
+
+// Open edge ends: none, one vertex, or more than one (OPEN_Many).
+#define OPEN_None UINT32_MAX
+#define OPEN_Many (UINT32_MAX - 1)
+
+// Sum of squared distances to weighted planes, Error(P) = P^T * A * P + 2 * B^T * P + C.
+struct FQuadric
+{
+	float A00, A11, A22, A10, A20, A21;
+	float B0, B1, B2;
+	float C;
+	float Weight;
+};
+
+static void AddPlaneQuadric(FQuadric& Quadric, FXMVECTOR Normal, float Distance, float Weight)
+{
+	XMFLOAT3 N;
+	XMStoreFloat3(&N, Normal);
+	Quadric.A00 += Weight * N.x * N.x;
+	Quadric.A11 += Weight * N.y * N.y;
+	Quadric.A22 += Weight * N.z * N.z;
+	Quadric.A10 += Weight * N.y * N.x;
+	Quadric.A20 += Weight * N.z * N.x;
+	Quadric.A21 += Weight * N.z * N.y;
+	Quadric.B0 += Weight * N.x * Distance;
+	Quadric.B1 += Weight * N.y * Distance;
+	Quadric.B2 += Weight * N.z * Distance;
+	Quadric.C += Weight * Distance * Distance;
+	Quadric.Weight += Weight;
+}
+
+static void AddQuadric(FQuadric& Quadric, const FQuadric& Other)
+{
+	const float* Src = &Other.A00;
+	float* Dst = &Quadric.A00;
+	for (uint32_t Idx = 0; Idx < sizeof(FQuadric) / sizeof(float); ++Idx)
+	{
+		Dst[Idx] += Src[Idx];
+	}
+}
+
+// Weighted mean squared distance.
+static float EvaluateQuadric(const FQuadric& Q, const XMFLOAT3& P)
+{
+	const float Rx = Q.A00 * P.x + Q.A10 * P.y + Q.A20 * P.z;
+	const float Ry = Q.A10 * P.x + Q.A11 * P.y + Q.A21 * P.z;
+	const float Rz = Q.A20 * P.x + Q.A21 * P.y + Q.A22 * P.z;
+	const float Error = Rx * P.x + Ry * P.y + Rz * P.z + 2.0f * (Q.B0 * P.x + Q.B1 * P.y + Q.B2 * P.z) + Q.C;
+	return Q.Weight > 0.0f ? fabsf(Error) / Q.Weight : 0.0f;
+}
+
+static uint32_t GetHashTableSize(uint32_t NumKeys)
+{
+	uint32_t Size = 16;
+	while (Size < NumKeys * 2)
+	{
+		Size *= 2;
+	}
+	return Size;
+}
+
+static uint32_t HashEdge(uint32_t A, uint32_t B)
+{
+	return (uint32_t)((((uint64_t)A << 32 | B) * 0x9E3779B97F4A7C15ull) >> 32);
+}
+
+// Open addressing set of directed edges between positions.
+struct FEdgeSet
+{
+	eastl::vector<uint64_t> Slots;
+};
+
+static void InitEdgeSet(FEdgeSet& Set, const uint32_t* Indices, uint32_t NumIndices, const uint32_t* Remap)
+{
+	Set.Slots.assign(GetHashTableSize(NumIndices), UINT64_MAX);
+	const auto Mask = (uint32_t)Set.Slots.size() - 1;
+	for (uint32_t Idx = 0; Idx < NumIndices; ++Idx)
+	{
+		const uint32_t A = Remap[Indices[Idx]];
+		const uint32_t B = Remap[Indices[Idx - Idx % 3 + (Idx + 1) % 3]];
+		const uint64_t Key = (uint64_t)A << 32 | B;
+		uint32_t Slot = HashEdge(A, B) & Mask;
+		while (Set.Slots[Slot] != UINT64_MAX && Set.Slots[Slot] != Key)
+		{
+			Slot = (Slot + 1) & Mask;
+		}
+		Set.Slots[Slot] = Key;
+	}
+}
+
+static bool HasEdge(const FEdgeSet& Set, uint32_t A, uint32_t B)
+{
+	const auto Mask = (uint32_t)Set.Slots.size() - 1;
+	const uint64_t Key = (uint64_t)A << 32 | B;
+	for (uint32_t Slot = HashEdge(A, B) & Mask; Set.Slots[Slot] != UINT64_MAX; Slot = (Slot + 1) & Mask)
+	{
+		if (Set.Slots[Slot] == Key)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// OutRemap[Vertex] is the first vertex with a bitwise identical position.
+void GetPositionRemap(const XMFLOAT3* Positions, uint32_t NumVertices, eastl::vector<uint32_t>& OutRemap)
+{
+	eastl::vector<uint32_t> Table(GetHashTableSize(NumVertices), UINT32_MAX);
+	const auto Mask = (uint32_t)Table.size() - 1;
+	OutRemap.resize(NumVertices);
+	for (uint32_t Vertex = 0; Vertex < NumVertices; ++Vertex)
+	{
+		uint32_t Words[3];
+		memcpy(Words, &Positions[Vertex], sizeof(Words));
+		uint32_t Slot = HashEdge(Words[0] ^ (Words[2] * 0x85EBCA6Bu), Words[1]) & Mask;
+		while (Table[Slot] != UINT32_MAX && memcmp(&Positions[Table[Slot]], &Positions[Vertex], sizeof(XMFLOAT3)) != 0)
+		{
+			Slot = (Slot + 1) & Mask;
+		}
+		if (Table[Slot] == UINT32_MAX)
+		{
+			Table[Slot] = Vertex;
+		}
+		OutRemap[Vertex] = Table[Slot];
+	}
+}
+
+static void AddOpenEdgeEnd(uint32_t& End, uint32_t Vertex)
+{
+	End = End == OPEN_None ? Vertex : OPEN_Many;
+}
+
+struct FVertexTopology
+{
+	eastl::vector<uint8_t> Kinds;
+	eastl::vector<uint32_t> OpenOut; // Ends of the open edges that leave or enter each vertex (no opposite edge).
+	eastl::vector<uint32_t> OpenIn;
+	eastl::vector<uint32_t> Wedges; // Next referenced vertex at the same position (a ring).
+};
+
+// Offsets and Adjacency list the triangles around every position.
+static bool HasEdge(const uint32_t* Indices, const uint32_t* Offsets, const uint32_t* Adjacency, uint32_t Position, uint32_t A, uint32_t B)
+{
+	for (uint32_t Idx = Offsets[Position]; Idx < Offsets[Position + 1]; ++Idx)
+	{
+		const uint32_t* Triangle = &Indices[Adjacency[Idx] * 3];
+		if ((Triangle[0] == A && Triangle[1] == B) || (Triangle[1] == A && Triangle[2] == B) || (Triangle[2] == A && Triangle[0] == B))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static void ClassifyVertices(const uint32_t* Indices, uint32_t NumIndices, uint32_t NumVertices, const uint32_t* Remap, const uint32_t* Offsets,
+	const uint32_t* Adjacency, FVertexTopology& Out)
+{
+	Out.Kinds.assign(NumVertices, VERTEX_Locked);
+	Out.OpenOut.assign(NumVertices, OPEN_None);
+	Out.OpenIn.assign(NumVertices, OPEN_None);
+	Out.Wedges.assign(NumVertices, UINT32_MAX);
+
+	for (uint32_t Idx = 0; Idx < NumIndices; ++Idx)
+	{
+		const uint32_t A = Indices[Idx];
+		const uint32_t B = Indices[Idx - Idx % 3 + (Idx + 1) % 3];
+		if (!HasEdge(Indices, Offsets, Adjacency, Remap[A], B, A))
+		{
+			AddOpenEdgeEnd(Out.OpenOut[A], B);
+			AddOpenEdgeEnd(Out.OpenIn[B], A);
+		}
+		Out.Wedges[A] = A;
+	}
+
+	// Link the referenced vertices of every position into a ring.
+	eastl::vector<uint32_t> Last(NumVertices, UINT32_MAX);
+	eastl::vector<uint32_t> Count(NumVertices, 0);
+	for (uint32_t Vertex = 0; Vertex < NumVertices; ++Vertex)
+	{
+		if (Out.Wedges[Vertex] == UINT32_MAX)
+		{
+			continue;
+		}
+		const uint32_t Position = Remap[Vertex];
+		if (Last[Position] != UINT32_MAX)
+		{
+			Out.Wedges[Vertex] = Out.Wedges[Last[Position]];
+			Out.Wedges[Last[Position]] = Vertex;
+		}
+		Last[Position] = Vertex;
+		++Count[Position];
+	}
+
+	const auto IsSingle = [](uint32_t End) { return End != OPEN_None && End != OPEN_Many; };
+	for (uint32_t Vertex = 0; Vertex < NumVertices; ++Vertex)
+	{
+		if (Out.Wedges[Vertex] == UINT32_MAX)
+		{
+			continue;
+		}
+		const uint32_t Out0 = Out.OpenOut[Vertex];
+		const uint32_t In0 = Out.OpenIn[Vertex];
+		if (Count[Remap[Vertex]] == 1)
+		{
+			if (Out0 == OPEN_None && In0 == OPEN_None)
+			{
+				Out.Kinds[Vertex] = VERTEX_Manifold;
+			}
+			else if (IsSingle(Out0) && IsSingle(In0))
+			{
+				Out.Kinds[Vertex] = VERTEX_Border;
+			}
+		}
+		else if (Count[Remap[Vertex]] == 2)
+		{
+			// The other side of a seam runs the other way.
+			const uint32_t Wedge = Out.Wedges[Vertex];
+			const uint32_t Out1 = Out.OpenOut[Wedge];
+			const uint32_t In1 = Out.OpenIn[Wedge];
+			if (IsSingle(Out0) && IsSingle(In0) && IsSingle(Out1) && IsSingle(In1) && Remap[Out0] == Remap[In1] && Remap[In0] == Remap[Out1])
+			{
+				Out.Kinds[Vertex] = VERTEX_Seam;
+			}
+		}
+	}
+}
+
+struct FCollapse
+{
+	uint32_t From;
+	uint32_t To;
+	float Error;
+};
+
+// Counting sort by the upper 16 bits of the errors (they are positive, so their bits sort like integers), which
+// orders them to within 1%.
+static void SortCollapses(const eastl::vector<FCollapse>& Collapses, eastl::vector<uint32_t>& Histogram, eastl::vector<uint32_t>& OutOrder)
+{
+	const auto GetKey = [](float Error)
+	{
+		uint32_t Bits;
+		memcpy(&Bits, &Error, sizeof(Bits));
+		return Bits >> 15;
+	};
+	Histogram.assign(1 << 16, 0);
+	for (const FCollapse& Collapse : Collapses)
+	{
+		++Histogram[GetKey(Collapse.Error)];
+	}
+	uint32_t Offset = 0;
+	for (uint32_t& Count : Histogram)
+	{
+		const uint32_t Start = Offset;
+		Offset += Count;
+		Count = Start;
+	}
+	OutOrder.resize(Collapses.size());
+	for (uint32_t Idx = 0; Idx < (uint32_t)Collapses.size(); ++Idx)
+	{
+		OutOrder[Histogram[GetKey(Collapses[Idx].Error)]++] = Idx;
+	}
+}
+
+// True when moving position From to position To turns one of the triangles around From too far.
+static bool HasFlip(const XMFLOAT3* Positions, const uint32_t* Remap, const uint32_t* Indices, const uint32_t* Offsets, const uint32_t* Adjacency,
+	uint32_t From, uint32_t To)
+{
+	const XMVECTOR Target = XMLoadFloat3(&Positions[To]);
+	for (uint32_t Idx = Offsets[From]; Idx < Offsets[From + 1]; ++Idx)
+	{
+		const uint32_t* Triangle = &Indices[Adjacency[Idx] * 3];
+		const uint32_t P0 = Remap[Triangle[0]];
+		const uint32_t P1 = Remap[Triangle[1]];
+		const uint32_t P2 = Remap[Triangle[2]];
+		if (P0 == To || P1 == To || P2 == To)
+		{
+			continue;
+		}
+		XMVECTOR V0 = XMLoadFloat3(&Positions[P0]);
+		XMVECTOR V1 = XMLoadFloat3(&Positions[P1]);
+		XMVECTOR V2 = XMLoadFloat3(&Positions[P2]);
+		const XMVECTOR Normal = XMVector3Cross(XMVectorSubtract(V1, V0), XMVectorSubtract(V2, V0));
+		V0 = P0 == From ? Target : V0;
+		V1 = P1 == From ? Target : V1;
+		V2 = P2 == From ? Target : V2;
+		const XMVECTOR NewNormal = XMVector3Cross(XMVectorSubtract(V1, V0), XMVectorSubtract(V2, V0));
+		const float Cosine = XMVectorGetX(XMVector3Dot(Normal, NewNormal));
+		if (Cosine < MIN_FLIP_COSINE * XMVectorGetX(XMVector3Length(Normal)) * XMVectorGetX(XMVector3Length(NewNormal)))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+uint32_t SimplifyMesh(const XMFLOAT3* InPositions, uint32_t NumVertices, const uint32_t* Indices, uint32_t NumIndices, uint32_t TargetIndexCount,
+	float MaxError, uint32_t* OutIndices, float& OutError)
+{
+	EA_ASSERT(NumIndices % 3 == 0);
+	memcpy(OutIndices, Indices, NumIndices * sizeof(uint32_t));
+	OutError = 0.0f;
+	if (NumIndices <= TargetIndexCount)
+	{
+		return NumIndices;
+	}
+
+	// Errors are computed in the unit cube.
+	XMVECTOR BoundsMin = g_XMFltMax;
+	XMVECTOR BoundsMax = XMVectorNegate(g_XMFltMax);
+	for (uint32_t Idx = 0; Idx < NumIndices; ++Idx)
+	{
+		BoundsMin = XMVectorMin(BoundsMin, XMLoadFloat3(&InPositions[Indices[Idx]]));
+		BoundsMax = XMVectorMax(BoundsMax, XMLoadFloat3(&InPositions[Indices[Idx]]));
+	}
+	const float Extent = XMMax(XMVectorGetX(XMVector3Length(XMVectorSubtract(BoundsMax, BoundsMin))), FLT_MIN);
+	eastl::vector<XMFLOAT3> Positions(NumVertices);
+	for (uint32_t Vertex = 0; Vertex < NumVertices; ++Vertex)
+	{
+		XMStoreFloat3(&Positions[Vertex], XMVectorScale(XMVectorSubtract(XMLoadFloat3(&InPositions[Vertex]), BoundsMin), 1.0f / Extent));
+	}
+	const float MaxNormalizedError = (MaxError / Extent) * (MaxError / Extent);
+
+	eastl::vector<uint32_t> Remap;
+	GetPositionRemap(InPositions, NumVertices, Remap);
+
+	// Quadrics of the triangle planes and of planes perpendicular to the open edges (in position space).
+	eastl::vector<FQuadric> Quadrics(NumVertices, FQuadric{});
+	{
+		FEdgeSet Edges;
+		InitEdgeSet(Edges, Indices, NumIndices, Remap.data());
+		for (uint32_t Idx = 0; Idx < NumIndices; Idx += 3)
+		{
+			const uint32_t P[3] = { Remap[Indices[Idx]], Remap[Indices[Idx + 1]], Remap[Indices[Idx + 2]] };
+			const XMVECTOR V[3] = { XMLoadFloat3(&Positions[P[0]]), XMLoadFloat3(&Positions[P[1]]), XMLoadFloat3(&Positions[P[2]]) };
+			const XMVECTOR Cross = XMVector3Cross(XMVectorSubtract(V[1], V[0]), XMVectorSubtract(V[2], V[0]));
+			const float Area = 0.5f * XMVectorGetX(XMVector3Length(Cross));
+			if (Area == 0.0f)
+			{
+				continue;
+			}
+			const XMVECTOR Normal = XMVector3Normalize(Cross);
+			for (uint32_t Corner = 0; Corner < 3; ++Corner)
+			{
+				AddPlaneQuadric(Quadrics[P[Corner]], Normal, -XMVectorGetX(XMVector3Dot(Normal, V[0])), Area);
+			}
+			for (uint32_t Corner = 0; Corner < 3; ++Corner)
+			{
+				const uint32_t Next = (Corner + 1) % 3;
+				if (HasEdge(Edges, P[Next], P[Corner]))
+				{
+					continue;
+				}
+				const XMVECTOR Edge = XMVectorSubtract(V[Next], V[Corner]);
+				const float LengthSq = XMVectorGetX(XMVector3LengthSq(Edge));
+				const XMVECTOR EdgeNormal = XMVector3Normalize(XMVector3Cross(Edge, Normal));
+				const float Distance = -XMVectorGetX(XMVector3Dot(EdgeNormal, V[Corner]));
+				AddPlaneQuadric(Quadrics[P[Corner]], EdgeNormal, Distance, BORDER_WEIGHT * LengthSq);
+				AddPlaneQuadric(Quadrics[P[Next]], EdgeNormal, Distance, BORDER_WEIGHT * LengthSq);
+			}
+		}
+	}
+
+	FVertexTopology Topology;
+	eastl::vector<uint32_t> Offsets(NumVertices + 1);
+	eastl::vector<uint32_t> Adjacency;
+	eastl::vector<FCollapse> Collapses;
+	eastl::vector<uint32_t> Histogram;
+	eastl::vector<uint32_t> Order;
+	eastl::vector<uint32_t> CollapseRemap(NumVertices);
+	eastl::vector<uint8_t> IsLocked(NumVertices);
+	float MaxCollapseError = 0.0f;
+	while (NumIndices > TargetIndexCount)
+	{
+		// Triangles around every position.
+		Offsets.assign(NumVertices + 1, 0);
+		Adjacency.resize(NumIndices);
+		for (uint32_t Idx = 0; Idx < NumIndices; ++Idx)
+		{
+			++Offsets[Remap[OutIndices[Idx]] + 1];
+		}
+		for (uint32_t Vertex = 0; Vertex < NumVertices; ++Vertex)
+		{
+			Offsets[Vertex + 1] += Offsets[Vertex];
+		}
+		for (uint32_t Idx = 0; Idx < NumIndices; ++Idx)
+		{
+			Adjacency[Offsets[Remap[OutIndices[Idx]]]++] = Idx / 3;
+		}
+		for (uint32_t Vertex = NumVertices; Vertex > 0; --Vertex)
+		{
+			Offsets[Vertex] = Offsets[Vertex - 1];
+		}
+		Offsets[0] = 0;
+		ClassifyVertices(OutIndices, NumIndices, NumVertices, Remap.data(), Offsets.data(), Adjacency.data(), Topology);
+
+		// Every half-edge gives a collapse of its first vertex, open ones also of the second.
+		Collapses.clear();
+		const auto AddCollapse = [&](uint32_t From, uint32_t To)
+		{
+			const uint32_t Kind = Topology.Kinds[From];
+			if (Kind == VERTEX_Locked || Remap[From] == Remap[To] ||
+				(Kind != VERTEX_Manifold && To != Topology.OpenOut[From] && To != Topology.OpenIn[From]))
+			{
+				return;
+			}
+			Collapses.push_back(FCollapse{ From, To, EvaluateQuadric(Quadrics[Remap[From]], Positions[To]) });
+		};
+		for (uint32_t Idx = 0; Idx < NumIndices; ++Idx)
+		{
+			const uint32_t A = OutIndices[Idx];
+			const uint32_t B = OutIndices[Idx - Idx % 3 + (Idx + 1) % 3];
+			AddCollapse(A, B);
+			if (Topology.OpenOut[A] == B)
+			{
+				AddCollapse(B, A);
+			}
+		}
+		SortCollapses(Collapses, Histogram, Order);
+
+		// Independent collapses in order of increasing error: the triangles around a collapsed vertex are left alone for
+		// the rest of the pass.
+		for (uint32_t Vertex = 0; Vertex < NumVertices; ++Vertex)
+		{
+			CollapseRemap[Vertex] = Vertex;
+		}
+		IsLocked.assign(NumVertices, 0);
+		uint32_t NumTriangles = NumIndices / 3;
+		uint32_t NumCollapses = 0;
+		for (uint32_t CollapseIdx : Order)
+		{
+			const FCollapse& Collapse = Collapses[CollapseIdx];
+			if (Collapse.Error > MaxNormalizedError || NumTriangles <= TargetIndexCount / 3)
+			{
+				break;
+			}
+			const uint32_t From = Remap[Collapse.From];
+			const uint32_t To = Remap[Collapse.To];
+			if (IsLocked[From] || IsLocked[To] || HasFlip(Positions.data(), Remap.data(), OutIndices, Offsets.data(), Adjacency.data(), From, To))
+			{
+				continue;
+			}
+
+			CollapseRemap[Collapse.From] = Collapse.To;
+			if (Topology.Kinds[Collapse.From] == VERTEX_Seam)
+			{
+				const uint32_t Wedge = Topology.Wedges[Collapse.From];
+				CollapseRemap[Wedge] = Collapse.To == Topology.OpenOut[Collapse.From] ? Topology.OpenIn[Wedge] : Topology.OpenOut[Wedge];
+			}
+			AddQuadric(Quadrics[To], Quadrics[From]);
+			for (uint32_t Idx = Offsets[From]; Idx < Offsets[From + 1]; ++Idx)
+			{
+				const uint32_t* Triangle = &OutIndices[Adjacency[Idx] * 3];
+				IsLocked[Remap[Triangle[0]]] = IsLocked[Remap[Triangle[1]]] = IsLocked[Remap[Triangle[2]]] = 1;
+			}
+			MaxCollapseError = XMMax(MaxCollapseError, Collapse.Error);
+			NumTriangles -= Topology.Kinds[Collapse.From] == VERTEX_Border ? 1 : 2;
+			++NumCollapses;
+		}
+		if (NumCollapses == 0)
+		{
+			break;
+		}
+
+		// Collapsed positions disappear with all their wedges, so every triangle that had two of them is gone.
+		uint32_t NumOutIndices = 0;
+		for (uint32_t Idx = 0; Idx < NumIndices; Idx += 3)
+		{
+			const uint32_t I0 = CollapseRemap[OutIndices[Idx]];
+			const uint32_t I1 = CollapseRemap[OutIndices[Idx + 1]];
+			const uint32_t I2 = CollapseRemap[OutIndices[Idx + 2]];
+			if (Remap[I0] != Remap[I1] && Remap[I1] != Remap[I2] && Remap[I2] != Remap[I0])
+			{
+				OutIndices[NumOutIndices++] = I0;
+				OutIndices[NumOutIndices++] = I1;
+				OutIndices[NumOutIndices++] = I2;
+			}
+		}
+		NumIndices = NumOutIndices;
+	}
+
+	OutError = sqrtf(MaxCollapseError) * Extent;
+	return NumIndices;
+}
+
+void GenerateLODs(FScene& InOutScene, uint32_t CacheSize)
+{
+	FScene& Scene = InOutScene;
+	EA_ASSERT(Scene.LODs.empty() && Scene.Clusters.empty());
+
+	eastl::vector<uint32_t> Source;
+	eastl::vector<uint32_t> Simplified;
+	eastl::vector<uint32_t> Optimized;
+	for (uint32_t MeshIdx = 0; MeshIdx < (uint32_t)Scene.Meshes.size(); ++MeshIdx)
+	{
+		const FSceneMesh Mesh = Scene.Meshes[MeshIdx];
+		Source.assign(Scene.Indices.begin() + Mesh.StartIndexLocation, Scene.Indices.begin() + Mesh.StartIndexLocation + Mesh.IndexCount);
+
+		uint32_t NumVertices = 0;
+		XMVECTOR BoundsMin = g_XMFltMax;
+		XMVECTOR BoundsMax = XMVectorNegate(g_XMFltMax);
+		for (uint32_t Index : Source)
+		{
+			NumVertices = XMMax(NumVertices, Index + 1);
+			BoundsMin = XMVectorMin(BoundsMin, XMLoadFloat3(&Scene.Positions[Mesh.BaseVertexLocation + Index]));
+			BoundsMax = XMVectorMax(BoundsMax, XMLoadFloat3(&Scene.Positions[Mesh.BaseVertexLocation + Index]));
+		}
+		const float MaxError = Source.empty() ? 0.0f : LOD_MAX_ERROR * XMVectorGetX(XMVector3Length(XMVectorSubtract(BoundsMax, BoundsMin)));
+
+		// Errors add up, each LOD is measured against the previous one.
+		float Error = 0.0f;
+		for (uint32_t Level = 1; Level < MAX_MESH_LODS; ++Level)
+		{
+			const auto NumSourceIndices = (uint32_t)Source.size();
+			const uint32_t TargetIndexCount = NumSourceIndices / 6 * 3;
+			if (TargetIndexCount < LOD_MIN_TRIANGLES * 3 || Error >= MaxError)
+			{
+				break;
+			}
+			float StepError;
+			Simplified.resize(NumSourceIndices);
+			const uint32_t NumIndices = SimplifyMesh(&Scene.Positions[Mesh.BaseVertexLocation], NumVertices, Source.data(), NumSourceIndices,
+				TargetIndexCount, MaxError - Error, Simplified.data(), StepError);
+			if (NumIndices > NumSourceIndices / 4 * 3)
+			{
+				break;
+			}
+			Error += StepError;
+
+			Optimized.resize(NumIndices);
+			OptimizeVertexCache(Simplified.data(), NumIndices, NumVertices, CacheSize, Optimized.data());
+			Scene.LODs.push_back(FSceneMeshLOD{ MeshIdx, NumIndices, (uint32_t)Scene.Indices.size(), Error });
+			Scene.Indices.insert(Scene.Indices.end(), Optimized.begin(), Optimized.end());
+			Source.swap(Optimized);
+		}
+	}
+}
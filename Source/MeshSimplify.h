@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+#include "GLTFScene.h"
+
+// Quadric error metric simplification (Garland and Heckbert 1997). Edges are collapsed onto one of their vertices, so
+// a simplified mesh is a new index list for the same vertex range and every vertex keeps its attributes. Vertices are
+// classified by the topology around their position:
+// - manifold vertices collapse onto any neighbor,
+// - open border vertices only along the border, which also adds a quadric that keeps it in place,
+// - attribute seam vertices (two vertices at one position, e.g. a hard normal or texcoord seam) only along the seam,
+//   both sides together,
+// - everything else is locked.
+// Collapses that would flip a triangle are rejected.
+
+// LODs of a mesh, the full detail one included.
+#define MAX_MESH_LODS 8
+
+// Writes at most NumIndices indices to OutIndices and returns their count, which stays above TargetIndexCount when
+// reaching it would need a collapse with an error above MaxError. OutError is the largest error of the collapses
+// that were done (object space distance to the input surface).
+uint32_t SimplifyMesh(const XMFLOAT3* Positions, uint32_t NumVertices, const uint32_t* Indices, uint32_t NumIndices, uint32_t TargetIndexCount,
+	float MaxError, uint32_t* OutIndices, float& OutError);
+
+// OutRemap[Vertex] is the first vertex with the same (bitwise) position.
+void GetPositionRemap(const XMFLOAT3* Positions, uint32_t NumVertices, eastl::vector<uint32_t>& OutRemap);
+
+// Appends up to MAX_MESH_LODS - 1 LODs of every section to InOutScene.LODs (each one simplified from the previous one
+// to half of its triangles, as long as that stays close to the full detail mesh) and their cache optimized indices to
+// InOutScene.Indices. Must run after OptimizeScene(), which does not know about LODs.
+void GenerateLODs(FScene& InOutScene, uint32_t CacheSize);
@@ -0,0 +1,170 @@
+#include "MeshStreaming.h"
+#include "MeshCluster.h"
+#include "MeshOptimize.h"
+#include "MeshSimplify.h"
+#include "MeshTangents.h"
+#include "PLYFile.h"
+#include "EAAssert/eaassert.h"
+#include "EAStdC/EAStopwatch.h"
+#include "EAStdC/EAString.h"
+
+bool LoadScene(FJobSystem& Jobs, const char* FileName, FScene& OutScene)
+{
+	const size_t Length = EA::StdC::Strlen(FileName);
+	if (Length < 4 || EA::StdC::Stricmp(FileName + Length - 4, ".ply") != 0)
+	{
+		if (!LoadGLTFScene(FileName, OutScene))
+		{
+			return false;
+		}
+	}
+	else
+	{
+		if (!LoadPLYFile(Jobs, FileName, OutScene.Positions, OutScene.Normals, OutScene.Texcoords, OutScene.Indices))
+		{
+			return false;
+		}
+		OutScene.Normals.resize(OutScene.Positions.size(), XMFLOAT3(0.0f, 0.0f, 0.0f));
+		OutScene.Tangents.resize(OutScene.Positions.size(), XMFLOAT4(0.0f, 0.0f, 0.0f, 0.0f));
+		OutScene.Texcoords.resize(OutScene.Positions.size(), XMFLOAT2(0.0f, 0.0f));
+		OutScene.Meshes.push_back(FSceneMesh{ (uint32_t)OutScene.Indices.size(), 0, 0, 0 });
+		OutScene.Materials.push_back(FSceneMaterial{ XMFLOAT3(1.0f, 1.0f, 1.0f), 0.0f, 0.5f });
+		OutScene.Instances.push_back(FSceneInstance{ XMFLOAT4X3(1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f), 0 });
+	}
+	GenerateTangents(Jobs, OutScene);
+	return true;
+}
+
+bool OpenMeshFile(FJobSystem& Jobs, const char* FileName, FMappedFile& OutFile, eastl::vector<uint8_t>& OutCookedData, FCookedMesh& OutMesh)
+{
+	const size_t Length = EA::StdC::Strlen(FileName);
+	if (Length >= 5 && EA::StdC::Stricmp(FileName + Length - 5, ".mesh") == 0)
+	{
+		if (!OpenMappedFile(FileName, OutFile))
+		{
+			return false;
+		}
+		if (!ParseCookedMesh(OutFile.Data, OutFile.Size, OutMesh))
+		{
+			CloseMappedFile(OutFile);
+			return false;
+		}
+		return true;
+	}
+
+	FScene Scene;
+	if (!LoadScene(Jobs, FileName, Scene))
+	{
+		return false;
+	}
+	OptimizeScene(Scene, VERTEX_CACHE_SIZE);
+	GenerateLODs(Scene, VERTEX_CACHE_SIZE);
+	BuildClusters(Scene, VERTEX_CACHE_SIZE);
+	CookMesh(Scene, OutCookedData);
+	return ParseCookedMesh(OutCookedData.data(), OutCookedData.size(), OutMesh);
+}
+
+static void CloseStreamedMesh(FStreamedMesh& Mesh)
+{
+	CloseMappedFile(Mesh.File);
+	Mesh.CookedData.set_capacity(0);
+	Mesh.Mesh = FCookedMesh{};
+}
+
+static void LoadMeshJob(void* Context, uint32_t /*Begin*/, uint32_t /*End*/)
+{
+	FMeshStreamSlot& Slot = *(FMeshStreamSlot*)Context;
+	FStreamedMesh& Mesh = Slot.Mesh;
+
+	EA::StdC::Stopwatch Time(EA::StdC::Stopwatch::kUnitsMilliseconds, true);
+	const bool bHasSucceeded = OpenMeshFile(*Slot.Jobs, Mesh.FileName.c_str(), Mesh.File, Mesh.CookedData, Mesh.Mesh);
+	if (!bHasSucceeded)
+	{
+		CloseStreamedMesh(Mesh);
+	}
+	Mesh.LoadTime = Time.GetElapsedTimeFloat();
+
+	// Publishes the slot, it is not touched by the job after this.
+	Slot.State.SetValue(bHasSucceeded ? MESH_STREAM_Loaded : MESH_STREAM_Failed);
+}
+
+void CreateMeshStreamer(FJobSystem& Jobs, FMeshStreamer& OutStreamer)
+{
+	OutStreamer.Jobs = &Jobs;
+	OutStreamer.Slots = new FMeshStreamSlot[MESH_STREAM_MAX_REQUESTS];
+	for (uint32_t SlotIdx = 0; SlotIdx < MESH_STREAM_MAX_REQUESTS; ++SlotIdx)
+	{
+		OutStreamer.Slots[SlotIdx].Mesh.File = FMappedFile{};
+		OutStreamer.Slots[SlotIdx].Mesh.Mesh = FCookedMesh{};
+		OutStreamer.Slots[SlotIdx].Jobs = &Jobs;
+		OutStreamer.Slots[SlotIdx].State.SetValue(MESH_STREAM_Free);
+	}
+	OutStreamer.JobCounter.NumPending.SetValue(0);
+	OutStreamer.NumRequests = 0;
+	OutStreamer.NumReleased = 0;
+}
+
+void DestroyMeshStreamer(FMeshStreamer& Streamer)
+{
+	if (!Streamer.Slots)
+	{
+		return;
+	}
+	WaitForCounter(*Streamer.Jobs, Streamer.JobCounter);
+	for (uint32_t SlotIdx = 0; SlotIdx < MESH_STREAM_MAX_REQUESTS; ++SlotIdx)
+	{
+		CloseStreamedMesh(Streamer.Slots[SlotIdx].Mesh);
+	}
+	delete[] Streamer.Slots;
+	Streamer.Slots = nullptr;
+}
+
+bool RequestMesh(FMeshStreamer& Streamer, const char* FileName)
+{
+	if (GetNumMeshRequests(Streamer) == MESH_STREAM_MAX_REQUESTS)
+	{
+		return false;
+	}
+	FMeshStreamSlot& Slot = Streamer.Slots[Streamer.NumRequests % MESH_STREAM_MAX_REQUESTS];
+	EA_ASSERT(Slot.State.GetValue() == MESH_STREAM_Free);
+
+	Slot.Mesh.FileName = FileName;
+	Slot.Mesh.RequestIndex = Streamer.NumRequests++;
+	Slot.Mesh.LoadTime = 0.0f;
+	Slot.State.SetValue(MESH_STREAM_Loading);
+	SubmitJob(*Streamer.Jobs, &LoadMeshJob, &Slot, 0, 1, Streamer.JobCounter);
+	return true;
+}
+
+const FStreamedMesh* GetStreamedMesh(FMeshStreamer& Streamer, bool& bOutHasSucceeded)
+{
+	if (GetNumMeshRequests(Streamer) == 0)
+	{
+		return nullptr;
+	}
+	FMeshStreamSlot& Slot = Streamer.Slots[Streamer.NumReleased % MESH_STREAM_MAX_REQUESTS];
+	if (Slot.State.GetValue() == MESH_STREAM_Loading && Streamer.Jobs->NumWorkers == 0)
+	{
+		// Nobody else will run the job.
+		WaitForCounter(*Streamer.Jobs, Streamer.JobCounter);
+	}
+
+	const int32_t State = Slot.State.GetValue();
+	if (State == MESH_STREAM_Loading)
+	{
+		return nullptr;
+	}
+	bOutHasSucceeded = State == MESH_STREAM_Loaded;
+	return &Slot.Mesh;
+}
+
+void ReleaseStreamedMesh(FMeshStreamer& Streamer)
+{
+	EA_ASSERT(GetNumMeshRequests(Streamer) > 0);
+	FMeshStreamSlot& Slot = Streamer.Slots[Streamer.NumReleased % MESH_STREAM_MAX_REQUESTS];
+	EA_ASSERT(Slot.State.GetValue() == MESH_STREAM_Loaded || Slot.State.GetValue() == MESH_STREAM_Failed);
+
+	CloseStreamedMesh(Slot.Mesh);
+	Slot.State.SetValue(MESH_STREAM_Free);
+	Streamer.NumReleased += 1;
+}
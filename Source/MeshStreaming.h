@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdint.h>
+#include "EASTL/string.h"
+#include "EASTL/vector.h"
+#include "EAThread/eathread_atomic.h"
+#include "CookedMesh.h"
+#include "JobSystem.h"
+#include "MappedFile.h"
+
+// Asynchronous mesh loading. RequestMesh() queues a file and a job maps it (cooked .mesh) or imports and cooks it
+// (.gltf, .glb, .ply) on a worker, so file reads, parsing and the whole cooking pipeline stay off the requesting thread.
+// Requests live in a ring of slots that hands the meshes back in request order: a worker only writes the slot of its
+// own request and publishes it with an atomic state change, the requesting thread only reads the oldest slot once it is
+// published. No locks are taken and neither the order nor the content of the results depends on which worker finishes
+// first.
+
+#define MESH_STREAM_MAX_REQUESTS 64 // Requests that were made but not released yet.
+
+enum
+{
+	MESH_STREAM_Free, MESH_STREAM_Loading, MESH_STREAM_Loaded, MESH_STREAM_Failed,
+};
+
+struct FStreamedMesh
+{
+	eastl::string FileName;
+	uint32_t RequestIndex; // Counts all requests of the streamer.
+	FMappedFile File;
+	eastl::vector<uint8_t> CookedData; // Imported files.
+	FCookedMesh Mesh; // Points to File or CookedData.
+	float LoadTime; // Milliseconds spent in the job.
+};
+
+struct FMeshStreamSlot
+{
+	FStreamedMesh Mesh;
+	FJobSystem* Jobs;
+	EA::Thread::AtomicInt32 State;
+};
+
+struct FMeshStreamer
+{
+	FJobSystem* Jobs;
+	FMeshStreamSlot* Slots; // Ring of MESH_STREAM_MAX_REQUESTS, indexed by RequestIndex.
+	FJobCounter JobCounter;
+	uint32_t NumRequests; // RequestIndex of the next request.
+	uint32_t NumReleased; // RequestIndex of the oldest slot.
+};
+
+void CreateMeshStreamer(FJobSystem& Jobs, FMeshStreamer& OutStreamer);
+// Waits for the running jobs and closes the meshes that were not released.
+void DestroyMeshStreamer(FMeshStreamer& Streamer);
+
+// Returns false when MESH_STREAM_MAX_REQUESTS requests are not released yet.
+bool RequestMesh(FMeshStreamer& Streamer, const char* FileName);
+
+// Oldest request that was not released, nullptr while its job is running or when there is none. Failed loads are
+// returned too (bOutHasSucceeded is false, Mesh is empty) and have to be released like the others.
+const FStreamedMesh* GetStreamedMesh(FMeshStreamer& Streamer, bool& bOutHasSucceeded);
+// Closes the mesh returned by GetStreamedMesh() and frees its slot.
+void ReleaseStreamedMesh(FMeshStreamer& Streamer);
+
+inline uint32_t GetNumMeshRequests(const FMeshStreamer& Streamer)
+{
+	return Streamer.NumRequests - Streamer.NumReleased;
+}
+
+// Imports a .gltf, .glb or .ply file and generates the tangents it lacks. A PLY file becomes a scene with a single
+// section (zero normals and texcoords when the file has none) and a single instance.
+bool LoadScene(FJobSystem& Jobs, const char* FileName, FScene& OutScene);
+
+// Maps a cooked mesh, other files are imported (see LoadScene()), optimized and cooked into OutCookedData.
+bool OpenMeshFile(FJobSystem& Jobs, const char* FileName, FMappedFile& OutFile, eastl::vector<uint8_t>& OutCookedData, FCookedMesh& OutMesh);
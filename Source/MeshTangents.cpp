@@ -0,0 +1,127 @@
+#include "MeshTangents.h"
+#include "EAAssert/eaassert.h"
+#include <math.h>
+
+#define TANGENT_JOB_GRANULARITY 4096
+
+// Angle weighted texture space directions that one triangle corner adds to its vertex.
+struct FTangentCorner
+{
+	XMFLOAT3 Tangent;
+	XMFLOAT3 Bitangent;
+};
+
+static XMVECTOR XM_CALLCONV ProjectOnPlane(FXMVECTOR Vector, FXMVECTOR Normal)
+{
+	return XMVector3Normalize(XMVectorSubtract(Vector, XMVectorMultiply(Normal, XMVector3Dot(Normal, Vector))));
+}
+
+void GenerateTangents(FJobSystem& Jobs, FScene& InOutScene)
+{
+	FScene& Scene = InOutScene;
+	const auto NumVertices = (uint32_t)Scene.Positions.size();
+	EA_ASSERT(Scene.Normals.size() == NumVertices && Scene.Tangents.size() == NumVertices && Scene.Texcoords.size() == NumVertices);
+
+	// Scene vertex of every triangle corner.
+	eastl::vector<uint32_t> Corners;
+	Corners.reserve(Scene.Indices.size());
+	for (const FSceneMesh& Mesh : Scene.Meshes)
+	{
+		for (uint32_t Idx = 0; Idx < Mesh.IndexCount / 3 * 3; ++Idx)
+		{
+			const uint32_t Vertex = Mesh.BaseVertexLocation + Scene.Indices[Mesh.StartIndexLocation + Idx];
+			EA_ASSERT(Vertex < NumVertices);
+			Corners.push_back(Vertex);
+		}
+	}
+	const auto NumTriangles = (uint32_t)(Corners.size() / 3);
+
+	eastl::vector<FTangentCorner> CornerFrames(Corners.size());
+	ParallelFor(Jobs, NumTriangles, TANGENT_JOB_GRANULARITY, [&](uint32_t Begin, uint32_t End)
+	{
+		for (uint32_t Triangle = Begin; Triangle < End; ++Triangle)
+		{
+			const uint32_t* Vertices = &Corners[Triangle * 3];
+			const XMVECTOR P[3] = { XMLoadFloat3(&Scene.Positions[Vertices[0]]), XMLoadFloat3(&Scene.Positions[Vertices[1]]), XMLoadFloat3(&Scene.Positions[Vertices[2]]) };
+			const XMVECTOR UV[3] = { XMLoadFloat2(&Scene.Texcoords[Vertices[0]]), XMLoadFloat2(&Scene.Texcoords[Vertices[1]]), XMLoadFloat2(&Scene.Texcoords[Vertices[2]]) };
+			const XMVECTOR Edge1 = XMVectorSubtract(P[1], P[0]);
+			const XMVECTOR Edge2 = XMVectorSubtract(P[2], P[0]);
+			const XMFLOAT2 DUV1(XMVectorGetX(UV[1]) - XMVectorGetX(UV[0]), XMVectorGetY(UV[1]) - XMVectorGetY(UV[0]));
+			const XMFLOAT2 DUV2(XMVectorGetX(UV[2]) - XMVectorGetX(UV[0]), XMVectorGetY(UV[2]) - XMVectorGetY(UV[0]));
+
+			// Gradients of the texture coordinates over the triangle: P - P0 = (u - u0) * Tangent + (v - v0) * Bitangent.
+			const float Area = DUV1.x * DUV2.y - DUV2.x * DUV1.y;
+			XMVECTOR Tangent = XMVectorZero();
+			XMVECTOR Bitangent = XMVectorZero();
+			if (fabsf(Area) > 1e-20f)
+			{
+				Tangent = XMVectorScale(XMVectorSubtract(XMVectorScale(Edge1, DUV2.y), XMVectorScale(Edge2, DUV1.y)), 1.0f / Area);
+				Bitangent = XMVectorScale(XMVectorSubtract(XMVectorScale(Edge2, DUV1.x), XMVectorScale(Edge1, DUV2.x)), 1.0f / Area);
+			}
+
+			for (uint32_t C = 0; C < 3; ++C)
+			{
+				const XMVECTOR Normal = XMLoadFloat3(&Scene.Normals[Vertices[C]]);
+				const XMVECTOR ToNext = XMVector3Normalize(XMVectorSubtract(P[(C + 1) % 3], P[C]));
+				const XMVECTOR ToPrev = XMVector3Normalize(XMVectorSubtract(P[(C + 2) % 3], P[C]));
+				const float Angle = acosf(XMMin(XMMax(XMVectorGetX(XMVector3Dot(ToNext, ToPrev)), -1.0f), 1.0f));
+
+				FTangentCorner& Frame = CornerFrames[Triangle * 3 + C];
+				XMStoreFloat3(&Frame.Tangent, XMVectorScale(ProjectOnPlane(Tangent, Normal), Angle));
+				XMStoreFloat3(&Frame.Bitangent, XMVectorScale(ProjectOnPlane(Bitangent, Normal), Angle));
+			}
+		}
+	});
+
+	// Corners of every vertex in corner order (counting sort).
+	eastl::vector<uint32_t> FirstCorner(NumVertices + 1, 0);
+	for (const uint32_t Vertex : Corners)
+	{
+		FirstCorner[Vertex + 1] += 1;
+	}
+	for (uint32_t Vertex = 0; Vertex < NumVertices; ++Vertex)
+	{
+		FirstCorner[Vertex + 1] += FirstCorner[Vertex];
+	}
+	eastl::vector<uint32_t> VertexCorners(Corners.size());
+	{
+		eastl::vector<uint32_t> Next(FirstCorner.begin(), FirstCorner.end() - 1);
+		for (uint32_t Corner = 0; Corner < (uint32_t)Corners.size(); ++Corner)
+		{
+			VertexCorners[Next[Corners[Corner]]++] = Corner;
+		}
+	}
+
+	ParallelFor(Jobs, NumVertices, TANGENT_JOB_GRANULARITY, [&](uint32_t Begin, uint32_t End)
+	{
+		for (uint32_t Vertex = Begin; Vertex < End; ++Vertex)
+		{
+			XMFLOAT4& Out = Scene.Tangents[Vertex];
+			if (Out.w != 0.0f)
+			{
+				continue;
+			}
+			XMVECTOR TangentSum = XMVectorZero();
+			XMVECTOR BitangentSum = XMVectorZero();
+			for (uint32_t Idx = FirstCorner[Vertex]; Idx < FirstCorner[Vertex + 1]; ++Idx)
+			{
+				const FTangentCorner& Frame = CornerFrames[VertexCorners[Idx]];
+				TangentSum = XMVectorAdd(TangentSum, XMLoadFloat3(&Frame.Tangent));
+				BitangentSum = XMVectorAdd(BitangentSum, XMLoadFloat3(&Frame.Bitangent));
+			}
+
+			const XMVECTOR Normal = XMLoadFloat3(&Scene.Normals[Vertex]);
+			XMVECTOR Tangent = ProjectOnPlane(TangentSum, Normal);
+			if (XMVectorGetX(XMVector3LengthSq(Tangent)) < 0.5f)
+			{
+				Tangent = XMVector3Normalize(XMVector3Orthogonal(Normal));
+				if (XMVectorGetX(XMVector3LengthSq(Tangent)) < 0.5f)
+				{
+					Tangent = g_XMIdentityR0;
+				}
+			}
+			const float Sign = XMVectorGetX(XMVector3Dot(XMVector3Cross(Normal, Tangent), BitangentSum)) < 0.0f ? -1.0f : 1.0f;
+			XMStoreFloat4(&Out, XMVectorSetW(Tangent, Sign));
+		}
+	});
+}
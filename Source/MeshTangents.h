@@ -0,0 +1,17 @@
+#pragma once
+
+#include "GLTFScene.h"
+#include "JobSystem.h"
+
+// Per-vertex tangent frames for normal mapping, computed like MikkTSpace (Mikkelsen 2008) does for a single vertex:
+// every triangle that uses a vertex contributes its texture space tangent and bitangent, projected onto the plane of
+// the vertex normal and weighted by the triangle's angle at that vertex. The tangent is the normalized sum, the
+// bitangent sign (w) says on which side of cross(normal, tangent) the summed bitangents are. Unlike MikkTSpace, vertices
+// whose triangles disagree about the texture space orientation (mirrored UV islands that share vertices) are not split,
+// they take the orientation of the majority. Vertices without a usable UV gradient get an arbitrary frame around the
+// normal.
+
+// Fills the tangents whose w is zero (see FScene) from the triangles of all sections (LODs are ignored). Triangles are
+// processed in parallel, the per-vertex sums are gathered in triangle order, so the result does not depend on the
+// number of threads.
+void GenerateTangents(FJobSystem& Jobs, FScene& InOutScene);
@@ -0,0 +1,2884 @@
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "EASTL/sort.h"
+#include "EASTL/string.h"
+#include "EAStdC/EASprintf.h"
+#include "EAStdC/EAString.h"
+#include "EAStdC/EAStopwatch.h"
+#include "EAStdC/EATextUtil.h"
+#include "EAThread/eathread.h"
+#include "CookedMesh.h"
+#include "DescriptorSlots.h"
+#include "GLTFScene.h"
+#include "InstanceBVH.h"
+#include "JobSystem.h"
+#include "MappedFile.h"
+#include "MeshCluster.h"
+#include "MeshOptimize.h"
+#include "MeshSimplify.h"
+#include "MeshStreaming.h"
+#include "PLYFile.h"
+#include "StaticScene.h"
+#include "UploadRing.h"
+
+// Headless command line front end for mesh loading and processing.
+//
+// MeshTool ply-convert <input.ply> <output.ply> [-threads N] [-format F]
+//   Rewrites a PLY file as ascii, binary (little endian, the default) or binary-be (big endian), with x, y, z and
+//   optional nx, ny, nz, s, t float vertices and triangles.
+//
+// MeshTool ply-benchmark <input.ply>... [-threads N] [-runs N]
+//   Load throughput (MB/s of file data and triangles per second) of LoadPLYFile() and, for ascii files, of the loader
+//   it replaced (fgets() and StrtoF32() per line, see LoadPLYFileReference()), and the largest difference between them.
+//
+// MeshTool gltf-info <input.gltf|glb>... [-runs N]
+//   LoadGLTFScene() time and scene statistics: unique vertices and triangles against the ones the scene would have
+//   with every mesh reference (node or EXT_mesh_gpu_instancing instance) flattened into its own copy.
+//
+// MeshTool mesh-cook <input.gltf|glb|ply> <output.mesh>
+//   Optimizes the scene (see MeshOptimize.h), generates LODs (see MeshSimplify.h) and clusters (see MeshCluster.h) and
+//   writes a cooked mesh (see CookedMesh.h) that the demo maps and uploads as is.
+//
+// MeshTool mesh-benchmark <input.gltf|glb>... [-runs N]
+//   Optimizes and cooks every file to <input>.mesh and compares loading it the way the demo does (map, parse, copy
+//   the streams to the upload buffers) with importing the glTF and building float vertices: time, GPU buffer sizes and
+//   the largest position, normal and tangent (degrees) error of the cooked data.
+//
+// MeshTool mesh-optimize <input.gltf|glb|ply>... [-cache N] [-threads N]
+//   OptimizeScene() time and the simulated post-transform cache (ACMR, ATVR) and vertex fetch cache hit rate of the
+//   cooked vertex layout before and after it, for a FIFO cache of N entries (VERTEX_CACHE_SIZE by default).
+//
+// MeshTool mesh-simplify <input.gltf|glb|ply>... [-runs N] [-threads N]
+//   GenerateLODs() throughput (full detail triangles per second) and the triangles and error of every LOD level,
+//   summed and maxed over the sections.
+//
+// MeshTool mesh-cull <input.gltf|glb|ply>... [-views N] [-runs N] [-threads N]
+//   BuildClusters() time, cluster sizes and CullClusters() for the full detail mesh of every instance, seen by N cameras
+//   spread around the scene (two thirds of them aimed off center): the fraction of the triangles culled by the frustum
+//   and normal cone tests next to the fraction of the triangles that are outside of the frustum or face away (the limits
+//   of both tests), the culling time per million triangles and the visible triangles missing from the culled index list.
+//
+// MeshTool mesh-stream <input.mesh|gltf|glb|ply>... [-runs N] [-threads N]
+//   Loads the files the way the demo does (see OpenMeshFile()) one after another on the calling thread, then all at
+//   once through the mesh streamer (see MeshStreaming.h), N times: wall time of both, the longest call the polling
+//   thread spent in GetStreamedMesh() and ReleaseStreamedMesh(), and the streamed meshes that came back out of request
+//   order or with cooked data different from the serial load (every run must have none).
+//
+// MeshTool instance-bvh [-instances N] [-views N] [-rays N] [-runs N]
+//   Instance index (see InstanceBVH.h) over generated scenes of N instances (10k, 100k and 1M by default) with random
+//   rotations and scales, spread over a cube at constant density: time of the world bounds update, BuildInstanceBVH(),
+//   RefitInstanceBVH() and UpdateInstanceBVH() after 1% of the instances moved, and the average time of N frustum
+//   queries (cameras inside the cube) and N ray casts, next to the ones of the brute force CullInstances() and
+//   RayCastInstances(). The results of both, after the update, must not differ.
+//
+// MeshTool scene-benchmark [input.mesh|gltf|glb|ply]... [-instances N] [-moving P] [-frames N] [-threads N] [-clusters 0|1]
+//   CPU side of a frame of the demo over a generated scene (see GenerateStaticScene()) of N instances (100k by default)
+//   of the given meshes (Data/Meshes/Cube.mesh and Sphere.mesh by default), P percent of them moving (10 by default),
+//   seen by a camera that orbits it like the demo's: average time per frame of the animation (transforms, bounds and
+//   index refit), the frustum query, the draw recording (LOD selection, cluster culling, instance data and batches, see
+//   RecordStaticDrawBatches()) and their submission to a command list that only records, in ns per instance (per
+//   visible one for the last two) for 1, 2, 4... up to N threads (all cores by default). Every thread count must draw
+//   the same instances.
+//
+// MeshTool draw-submission [input.mesh|gltf|glb|ply]... [-instances N] [-frames N] [-threads N]
+//   Cost of getting the static mesh draws of a frame to a command list that only records (the calls and their
+//   arguments, see FRecordingCommandList) over the generated scene and camera of scene-benchmark, without moving
+//   instances: the per-instance constants and draws the demo used to record (RecordStaticDraws()) against its instanced
+//   batches (RecordStaticDrawBatches()) submitted with a draw each or with one ExecuteIndirect(), with and without
+//   cluster culling. Recording and submission time in ms per 100k visible instances on N threads (1 by default), commands,
+//   command list and upload bytes per frame. Replaying the command lists must draw the same instances with the same
+//   indices and data every way.
+//
+// MeshTool command-lists [input.mesh|gltf|glb|ply]... [-instances N] [-frames N] [-threads N] [-clusters 0|1]
+//   Parallel recording of the instanced batches (see GetNumStaticDrawCommandLists()) over the generated scene and camera
+//   of draw-submission, with cluster culling by default (a batch per visible instance): for 1, 2, 4... up to N threads
+//   (32 by default) the command lists of a frame, recorded a job each to command lists that only record, and the time
+//   per frame and per 100k batches. Replayed in order, the lists of every thread count must draw the same instances
+//   in the same order as the one list of a single thread.
+//
+// MeshTool instance-transforms [input.mesh|gltf|glb|ply]... [-instances N] [-moving P] [-frames N] [-threads N]
+//   Per-frame instance work of the demo over the generated scene and camera of scene-benchmark, P percent (100 by
+//   default) of N instances (100k by default) moving: AnimateStaticScene() (4 instances per step from the structure of
+//   arrays, bounds, index refit and GPU data of the moved instances) next to a matrix per instance, and streaming the
+//   GPU data of the visible instances (see StreamStaticInstanceData()) next to writing it field by field. Millions of
+//   instances per second and core for 1, 2, 4... up to N threads (all cores by default) and the speedup of both
+//   together. The transforms must match the ones of the matrices and the streamed data must match the written.
+//
+// MeshTool upload-ring [-frames N] [-latency N] [-page KB] [-seed N]
+//   Runs the upload ring (see UploadRing.h) on heap memory with pages of KB kilobytes (1024 by default) through N random
+//   frames (10000 by default) of small, page sized and dedicated allocations, with bursts, against a fake fence that
+//   lags 0 to N frames (3 by default) behind. Every allocation is filled with its index and checked when its frame
+//   completes: none may be overwritten, misaligned or leaked, and the frame stats must match the allocations. Then the
+//   time per allocation of a steady stream of per-draw constants.
+//
+// MeshTool descriptor-churn [-frames N] [-latency N] [-capacity N] [-seed N]
+//   Runs the persistent descriptor slots (see DescriptorSlots.h) with a capacity of N (4096 by default) through N random
+//   frames (10000 by default) that allocate and release slots, with bursts that fill them up, against a fake fence that
+//   lags 0 to N frames (3 by default) behind. No slot may be handed out while it is live or before the GPU is done with
+//   its release, released handles must stay invalid (also to a second release), the slots may only run out when all
+//   of them are live or retired, and none may leak. Then the time per allocation and release of a steady churn.
+
+void* operator new[](size_t Size, const char* /*Name*/, int /*Flags*/, unsigned /*DebugFlags*/, const char* /*File*/, int /*Line*/)
+{
+	return malloc(Size);
+}
+
+void* operator new[](size_t Size, size_t Alignment, size_t AlignmentOffset, const char* /*Name*/, int /*Flags*/, unsigned /*DebugFlags*/, const char* /*File*/, int /*Line*/)
+{
+#ifdef _WIN32
+	return _aligned_offset_malloc(Size, Alignment, AlignmentOffset);
+#else
+	EA_UNUSED(AlignmentOffset);
+	return aligned_alloc(Alignment, (Size + Alignment - 1) & ~(Alignment - 1));
+#endif
+}
+
+struct FOption
+{
+	const char* Name;
+	uint32_t* Value;
+	const char** String;
+};
+
+static bool ParseOptions(int Argc, char** Argv, const FOption* Options, uint32_t NumOptions)
+{
+	for (int ArgIdx = 0; ArgIdx < Argc; ArgIdx += 2)
+	{
+		const FOption* Option = nullptr;
+		for (uint32_t OptionIdx = 0; OptionIdx < NumOptions; ++OptionIdx)
+		{
+			if (EA::StdC::Strcmp(Argv[ArgIdx], Options[OptionIdx].Name) == 0)
+			{
+				Option = &Options[OptionIdx];
+				break;
+			}
+		}
+		if (!Option || ArgIdx + 1 >= Argc)
+		{
+			fprintf(stderr, "Invalid option: %s\n", Argv[ArgIdx]);
+			return false;
+		}
+		if (Option->Value)
+		{
+			*Option->Value = EA::StdC::StrtoU32(Argv[ArgIdx + 1], nullptr, 10);
+		}
+		else
+		{
+			*Option->String = Argv[ArgIdx + 1];
+		}
+	}
+	return true;
+}
+
+struct FMeshData
+{
+	eastl::vector<XMFLOAT3> Positions;
+	eastl::vector<XMFLOAT3> Normals;
+	eastl::vector<XMFLOAT2> Texcoords;
+	eastl::vector<uint32_t> Triangles;
+};
+
+static int ConvertPLYFile(const char* InputFileName, const char* OutputFileName, int Argc, char** Argv)
+{
+	uint32_t NumThreads = 0;
+	const char* FormatName = "binary";
+	const FOption Options[] =
+	{
+		{ "-threads", &NumThreads, nullptr },
+		{ "-format", nullptr, &FormatName },
+	};
+	if (!ParseOptions(Argc, Argv, Options, (uint32_t)eastl::size(Options)))
+	{
+		return -1;
+	}
+	static const char* const FormatNames[] = { "ascii", "binary", "binary-be" };
+	uint32_t Format = UINT32_MAX;
+	for (uint32_t Idx = 0; Idx < eastl::size(FormatNames); ++Idx)
+	{
+		if (EA::StdC::Stricmp(FormatName, FormatNames[Idx]) == 0)
+		{
+			Format = Idx;
+		}
+	}
+	if (Format == UINT32_MAX)
+	{
+		fprintf(stderr, "Invalid format: %s\n", FormatName);
+		return -1;
+	}
+
+	FJobSystem Jobs = {};
+	CreateJobSystem(NumThreads, Jobs);
+	FMeshData Mesh;
+	const bool bIsLoaded = LoadPLYFile(Jobs, InputFileName, Mesh.Positions, Mesh.Normals, Mesh.Texcoords, Mesh.Triangles);
+	DestroyJobSystem(Jobs);
+	if (!bIsLoaded)
+	{
+		fprintf(stderr, "Failed to load %s\n", InputFileName);
+		return 1;
+	}
+	if (!SavePLYFile(OutputFileName, Format, Mesh.Positions, Mesh.Normals, Mesh.Texcoords, Mesh.Triangles))
+	{
+		fprintf(stderr, "Failed to write %s\n", OutputFileName);
+		return 1;
+	}
+	printf("%s: %u vertices, %u triangles\n", OutputFileName, (uint32_t)Mesh.Positions.size(), (uint32_t)(Mesh.Triangles.size() / 3));
+	return 0;
+}
+
+// The ascii only loader LoadPLYFile() replaced, kept as the baseline of ply-benchmark. Its asserts are failures here.
+static bool LoadPLYFileReference(const char* FileName, eastl::vector<XMFLOAT3>& InOutPositions, eastl::vector<XMFLOAT3>& InOutNormals, eastl::vector<XMFLOAT2>& InOutTexcoords, eastl::vector<uint32_t>& InOutTriangles)
+{
+	using namespace EA::StdC;
+	FILE* File = fopen(FileName, "r");
+	if (!File)
+	{
+		return false;
+	}
+
+	char LineBuffer[1024];
+	char Token[64];
+	uint32_t NumVertices = UINT32_MAX;
+	uint32_t NumTriangles = UINT32_MAX;
+
+	struct FProperty
+	{
+		const char* Name;
+		bool bIsPresent;
+	} Properties[] =
+	{
+		{ "x\n", false }, { "y\n", false }, { "z\n", false },
+		{ "nx\n", false }, { "ny\n", false }, { "nz\n", false },
+		{ "s\n", false }, { "t\n", false },
+	};
+	bool bHasPositions = false;
+	bool bHasNormals = false;
+	bool bHasTexcoords = false;
+
+	while (fgets(LineBuffer, sizeof(LineBuffer), File))
+	{
+		const char* Line = LineBuffer;
+		while (SplitTokenSeparated(Line, kLengthNull, ' ', Token, sizeof(Token), &Line))
+		{
+			if (Strcmp(Token, "comment") == 0 || Strcmp(Token, "format") == 0)
+			{
+				break; // Skip the line.
+			}
+			else if (Strcmp(Token, "vertex") == 0)
+			{
+				NumVertices = AtoU32(Line);
+			}
+			else if (Strcmp(Token, "face") == 0)
+			{
+				NumTriangles = AtoU32(Line);
+			}
+			else if (Strcmp(Token, "float") == 0)
+			{
+				for (uint32_t Idx = 0; Idx < eastl::size(Properties); ++Idx)
+				{
+					if (Strcmp(Line, Properties[Idx].Name) == 0)
+					{
+						Properties[Idx].bIsPresent = true;
+						break;
+					}
+				}
+			}
+			else if (Strcmp(Token, "end_header\n") == 0)
+			{
+				bHasPositions = Properties[0].bIsPresent && Properties[1].bIsPresent && Properties[2].bIsPresent;
+				bHasNormals = Properties[3].bIsPresent && Properties[4].bIsPresent && Properties[5].bIsPresent;
+				bHasTexcoords = Properties[6].bIsPresent && Properties[7].bIsPresent;
+				goto HeaderIsDone;
+			}
+		}
+	}
+HeaderIsDone:
+
+	if (!bHasPositions || NumVertices == UINT32_MAX || NumTriangles == UINT32_MAX)
+	{
+		fclose(File);
+		return false;
+	}
+
+	InOutPositions.reserve(InOutPositions.size() + NumVertices);
+	if (bHasNormals)
+	{
+		InOutNormals.reserve(InOutNormals.size() + NumVertices);
+	}
+	if (bHasTexcoords)
+	{
+		InOutTexcoords.reserve(InOutTexcoords.size() + NumVertices);
+	}
+
+	for (uint32_t LineIdx = 0; LineIdx < NumVertices; ++LineIdx)
+	{
+		char* Line = fgets(LineBuffer, sizeof(LineBuffer), File);
+		if (!Line)
+		{
+			fclose(File);
+			return false;
+		}
+
+		XMFLOAT3 Position;
+		Position.x = StrtoF32(Line, &Line);
+		Position.y = StrtoF32(Line, &Line);
+		Position.z = StrtoF32(Line, &Line);
+		InOutPositions.push_back(Position);
+
+		if (bHasNormals)
+		{
+			XMFLOAT3 Normal;
+			Normal.x = StrtoF32(Line, &Line);
+			Normal.y = StrtoF32(Line, &Line);
+			Normal.z = StrtoF32(Line, &Line);
+			InOutNormals.push_back(Normal);
+		}
+		if (bHasTexcoords)
+		{
+			XMFLOAT2 Texcoord;
+			Texcoord.x = StrtoF32(Line, &Line);
+			Texcoord.y = StrtoF32(Line, &Line);
+			InOutTexcoords.push_back(Texcoord);
+		}
+	}
+
+	InOutTriangles.reserve(InOutTriangles.size() + NumTriangles * 3);
+
+	for (uint32_t LineIdx = 0; LineIdx < NumTriangles; ++LineIdx)
+	{
+		char* Line = fgets(LineBuffer, sizeof(LineBuffer), File);
+		if (!Line || StrtoU32(Line, &Line, 10) != 3)
+		{
+			fclose(File);
+			return false;
+		}
+
+		uint32_t Triangle[3];
+		Triangle[0] = StrtoU32(Line, &Line, 10);
+		Triangle[1] = StrtoU32(Line, &Line, 10);
+		Triangle[2] = StrtoU32(Line, &Line, 10);
+
+		InOutTriangles.push_back(Triangle[0]);
+		InOutTriangles.push_back(Triangle[1]);
+		InOutTriangles.push_back(Triangle[2]);
+	}
+
+	fclose(File);
+	return true;
+}
+
+static bool IsAsciiPLYFile(const char* FileName)
+{
+	FMappedFile File;
+	if (!OpenMappedFile(FileName, File))
+	{
+		return false;
+	}
+	const char Signature[] = "ply\nformat ascii ";
+	const bool bIsAscii = File.Size > sizeof(Signature) && memcmp(File.Data, Signature, sizeof(Signature) - 1) == 0;
+	CloseMappedFile(File);
+	return bIsAscii;
+}
+
+// Largest absolute difference of all attributes, FLT_MAX when the meshes do not match in size or indices.
+static float GetMeshDifference(const FMeshData& Mesh, const FMeshData& Reference)
+{
+	if (Mesh.Positions.size() != Reference.Positions.size() || Mesh.Normals.size() != Reference.Normals.size() ||
+		Mesh.Texcoords.size() != Reference.Texcoords.size() || Mesh.Triangles != Reference.Triangles)
+	{
+		return FLT_MAX;
+	}
+	float MaxDifference = 0.0f;
+	const auto Compare = [&MaxDifference](const float* Values, const float* ReferenceValues, size_t Count)
+	{
+		for (size_t Idx = 0; Idx < Count; ++Idx)
+		{
+			MaxDifference = XMMax(MaxDifference, fabsf(Values[Idx] - ReferenceValues[Idx]));
+		}
+	};
+	Compare(&Mesh.Positions.data()->x, &Reference.Positions.data()->x, 3 * Mesh.Positions.size());
+	Compare(&Mesh.Normals.data()->x, &Reference.Normals.data()->x, 3 * Mesh.Normals.size());
+	Compare(&Mesh.Texcoords.data()->x, &Reference.Texcoords.data()->x, 2 * Mesh.Texcoords.size());
+	return MaxDifference;
+}
+
+static int BenchmarkPLYLoader(int Argc, char** Argv)
+{
+	int NumFiles = 0;
+	while (NumFiles < Argc && Argv[NumFiles][0] != '-')
+	{
+		++NumFiles;
+	}
+	uint32_t NumThreads = 0;
+	uint32_t NumRuns = 3;
+	const FOption Options[] =
+	{
+		{ "-threads", &NumThreads, nullptr },
+		{ "-runs", &NumRuns, nullptr },
+	};
+	if (NumFiles == 0 || !ParseOptions(Argc - NumFiles, Argv + NumFiles, Options, (uint32_t)eastl::size(Options)) || NumRuns == 0)
+	{
+		return -1;
+	}
+
+	FJobSystem Jobs = {};
+	CreateJobSystem(NumThreads, Jobs);
+	printf("%u threads, best of %u runs (the file is in the page cache after the first one)\n", GetNumThreads(Jobs), NumRuns);
+	printf("%-32s %-22s %10s %10s %10s %12s %12s\n", "file", "loader", "MB", "time [ms]", "MB/s", "Mtri/s", "max diff.");
+
+	int Result = 0;
+	for (int FileIdx = 0; FileIdx < NumFiles; ++FileIdx)
+	{
+		const char* FileName = Argv[FileIdx];
+		FMappedFile File;
+		if (!OpenMappedFile(FileName, File))
+		{
+			fprintf(stderr, "Failed to open %s\n", FileName);
+			Result = 1;
+			continue;
+		}
+		const uint64_t FileSize = File.Size;
+		CloseMappedFile(File);
+
+		FMeshData Meshes[2];
+		float Milliseconds[2] = { FLT_MAX, FLT_MAX };
+		const uint32_t NumLoaders = IsAsciiPLYFile(FileName) ? 2 : 1;
+		bool bIsLoaded[2] = {};
+		for (uint32_t Loader = 0; Loader < NumLoaders; ++Loader)
+		{
+			for (uint32_t Run = 0; Run < NumRuns; ++Run)
+			{
+				FMeshData& Mesh = Meshes[Loader];
+				Mesh = FMeshData();
+				EA::StdC::Stopwatch Time(EA::StdC::Stopwatch::kUnitsMilliseconds, true);
+				if (Loader == 0)
+				{
+					bIsLoaded[Loader] = LoadPLYFile(Jobs, FileName, Mesh.Positions, Mesh.Normals, Mesh.Texcoords, Mesh.Triangles);
+				}
+				else
+				{
+					bIsLoaded[Loader] = LoadPLYFileReference(FileName, Mesh.Positions, Mesh.Normals, Mesh.Texcoords, Mesh.Triangles);
+				}
+				Milliseconds[Loader] = XMMin(Milliseconds[Loader], Time.GetElapsedTimeFloat());
+			}
+		}
+
+		static const char* const LoaderNames[] = { "LoadPLYFile", "fgets/StrtoF32 (old)" };
+		for (uint32_t Loader = 0; Loader < NumLoaders; ++Loader)
+		{
+			const eastl::string Name = EA::StdC::Strlen(FileName) > 32 ? eastl::string("...") + (FileName + EA::StdC::Strlen(FileName) - 29) : eastl::string(FileName);
+			if (!bIsLoaded[Loader])
+			{
+				printf("%-32s %-22s %10.1f %10s\n", Name.c_str(), LoaderNames[Loader], FileSize / (1024.0 * 1024.0), "failed");
+				Result = Loader == 0 ? 1 : Result;
+				continue;
+			}
+			const float Seconds = Milliseconds[Loader] * 0.001f;
+			char Difference[32] = "-";
+			if (Loader == 1 && bIsLoaded[0])
+			{
+				const float MaxDifference = GetMeshDifference(Meshes[0], Meshes[1]);
+				EA::StdC::Snprintf(Difference, sizeof(Difference), MaxDifference == FLT_MAX ? "mismatch" : "%.3g", MaxDifference);
+			}
+			printf("%-32s %-22s %10.1f %10.2f %10.1f %12.2f %12s\n", Name.c_str(), LoaderNames[Loader], FileSize / (1024.0 * 1024.0), Milliseconds[Loader],
+				FileSize / (1024.0 * 1024.0) / Seconds, Meshes[Loader].Triangles.size() / 3 / 1.0e6 / Seconds, Difference);
+		}
+	}
+
+	DestroyJobSystem(Jobs);
+	return Result;
+}
+
+static int PrintGLTFSceneInfo(int Argc, char** Argv)
+{
+	int NumFiles = 0;
+	while (NumFiles < Argc && Argv[NumFiles][0] != '-')
+	{
+		++NumFiles;
+	}
+	uint32_t NumRuns = 3;
+	const FOption Options[] =
+	{
+		{ "-runs", &NumRuns, nullptr },
+	};
+	if (NumFiles == 0 || !ParseOptions(Argc - NumFiles, Argv + NumFiles, Options, (uint32_t)eastl::size(Options)) || NumRuns == 0)
+	{
+		return -1;
+	}
+
+	printf("%-32s %10s %8s %8s %10s %12s %12s %14s %14s\n", "file", "time [ms]", "meshes", "mtls", "instances", "vertices", "triangles",
+		"flat vertices", "flat triangles");
+
+	int Result = 0;
+	for (int FileIdx = 0; FileIdx < NumFiles; ++FileIdx)
+	{
+		const char* FileName = Argv[FileIdx];
+		const eastl::string Name = EA::StdC::Strlen(FileName) > 32 ? eastl::string("...") + (FileName + EA::StdC::Strlen(FileName) - 29) : eastl::string(FileName);
+
+		FScene Scene;
+		float Milliseconds = FLT_MAX;
+		bool bIsLoaded = false;
+		for (uint32_t Run = 0; Run < NumRuns; ++Run)
+		{
+			Scene = FScene();
+			EA::StdC::Stopwatch Time(EA::StdC::Stopwatch::kUnitsMilliseconds, true);
+			bIsLoaded = LoadGLTFScene(FileName, Scene);
+			Milliseconds = XMMin(Milliseconds, Time.GetElapsedTimeFloat());
+		}
+		if (!bIsLoaded)
+		{
+			printf("%-32s %10s\n", Name.c_str(), "failed");
+			Result = 1;
+			continue;
+		}
+
+		// Vertices a mesh references (meshes may share a vertex range, flattening would copy it for each).
+		uint64_t FlatVertices = 0;
+		uint64_t FlatTriangles = 0;
+		eastl::vector<uint32_t> MeshNumVertices(Scene.Meshes.size(), 0);
+		for (size_t MeshIdx = 0; MeshIdx < Scene.Meshes.size(); ++MeshIdx)
+		{
+			const FSceneMesh& Mesh = Scene.Meshes[MeshIdx];
+			for (uint32_t Idx = 0; Idx < Mesh.IndexCount; ++Idx)
+			{
+				MeshNumVertices[MeshIdx] = XMMax(MeshNumVertices[MeshIdx], Scene.Indices[Mesh.StartIndexLocation + Idx] + 1);
+			}
+		}
+		for (const FSceneInstance& Instance : Scene.Instances)
+		{
+			FlatVertices += MeshNumVertices[Instance.MeshIndex];
+			FlatTriangles += Scene.Meshes[Instance.MeshIndex].IndexCount / 3;
+		}
+
+		printf("%-32s %10.2f %8u %8u %10u %12u %12u %14llu %14llu\n", Name.c_str(), Milliseconds, (uint32_t)Scene.Meshes.size(), (uint32_t)Scene.Materials.size(),
+			(uint32_t)Scene.Instances.size(), (uint32_t)Scene.Positions.size(), (uint32_t)Scene.Indices.size() / 3, (unsigned long long)FlatVertices,
+			(unsigned long long)FlatTriangles);
+	}
+	return Result;
+}
+
+static int CookMeshFile(const char* InputFileName, const char* OutputFileName)
+{
+	FJobSystem Jobs = {};
+	CreateJobSystem(0, Jobs);
+	FScene Scene;
+	const bool bIsLoaded = LoadScene(Jobs, InputFileName, Scene);
+	DestroyJobSystem(Jobs);
+	if (!bIsLoaded)
+	{
+		fprintf(stderr, "Failed to load %s\n", InputFileName);
+		return 1;
+	}
+	OptimizeScene(Scene, VERTEX_CACHE_SIZE);
+	GenerateLODs(Scene, VERTEX_CACHE_SIZE);
+	BuildClusters(Scene, VERTEX_CACHE_SIZE);
+	if (!SaveCookedMesh(OutputFileName, Scene))
+	{
+		fprintf(stderr, "Failed to write %s\n", OutputFileName);
+		return 1;
+	}
+	FVertexLayout Layout;
+	InitVertexLayout(GetCookedAttributeMask(Scene), Layout);
+	printf("%s: %u vertices (%u + %u bytes), %u triangles (LODs included), %u sections, %u LODs, %u clusters, %u instances\n", OutputFileName,
+		(uint32_t)Scene.Positions.size(), Layout.Strides[0], Layout.Strides[1], (uint32_t)(Scene.Indices.size() / 3), (uint32_t)Scene.Meshes.size(),
+		(uint32_t)Scene.LODs.size(), (uint32_t)Scene.Clusters.size(), (uint32_t)Scene.Instances.size());
+	return 0;
+}
+
+// The demo's float vertex (position and normal), the layout used before cooked meshes.
+struct FFloatVertex
+{
+	XMFLOAT3 Position;
+	XMFLOAT3 Normal;
+};
+
+static int BenchmarkCookedMesh(int Argc, char** Argv)
+{
+	int NumFiles = 0;
+	while (NumFiles < Argc && Argv[NumFiles][0] != '-')
+	{
+		++NumFiles;
+	}
+	uint32_t NumRuns = 3;
+	const FOption Options[] =
+	{
+		{ "-runs", &NumRuns, nullptr },
+	};
+	if (NumFiles == 0 || !ParseOptions(Argc - NumFiles, Argv + NumFiles, Options, (uint32_t)eastl::size(Options)) || NumRuns == 0)
+	{
+		return -1;
+	}
+
+	FJobSystem Jobs = {};
+	CreateJobSystem(0, Jobs);
+	printf("best of %u runs, GPU MB is the size of the vertex and index buffers\n", NumRuns);
+	printf("%-32s %-8s %10s %10s %10s %10s %12s %12s %12s\n", "file", "loader", "time [ms]", "file MB", "GPU MB", "B/vertex", "max pos err", "max nrm err",
+		"max tan err");
+
+	int Result = 0;
+	for (int FileIdx = 0; FileIdx < NumFiles; ++FileIdx)
+	{
+		const char* FileName = Argv[FileIdx];
+		const eastl::string Name = EA::StdC::Strlen(FileName) > 32 ? eastl::string("...") + (FileName + EA::StdC::Strlen(FileName) - 29) : eastl::string(FileName);
+		const eastl::string CookedFileName = eastl::string(FileName) + ".mesh";
+
+		FScene Scene;
+		if (!LoadScene(Jobs, FileName, Scene))
+		{
+			printf("%-32s %10s\n", Name.c_str(), "failed");
+			Result = 1;
+			continue;
+		}
+		OptimizeScene(Scene, VERTEX_CACHE_SIZE);
+		GenerateLODs(Scene, VERTEX_CACHE_SIZE);
+		BuildClusters(Scene, VERTEX_CACHE_SIZE);
+		if (!SaveCookedMesh(CookedFileName.c_str(), Scene) || Scene.Positions.empty())
+		{
+			printf("%-32s %10s\n", Name.c_str(), "failed");
+			Result = 1;
+			continue;
+		}
+
+		// Stands in for the upload buffers.
+		eastl::vector<uint8_t> Staging;
+		float Milliseconds[2] = { FLT_MAX, FLT_MAX };
+		uint64_t CookedFileSize = 0;
+		uint64_t GPUSizes[2] = {};
+		uint32_t NumVertices[2] = {};
+		bool bIsLoaded = true;
+		for (uint32_t Run = 0; Run < NumRuns; ++Run)
+		{
+			{
+				EA::StdC::Stopwatch Time(EA::StdC::Stopwatch::kUnitsMilliseconds, true);
+				FScene GLTFScene;
+				bIsLoaded = LoadGLTFScene(FileName, GLTFScene) && bIsLoaded;
+				eastl::vector<FFloatVertex> Vertices(GLTFScene.Positions.size());
+				for (size_t Idx = 0; Idx < Vertices.size(); ++Idx)
+				{
+					Vertices[Idx].Position = GLTFScene.Positions[Idx];
+					Vertices[Idx].Normal = GLTFScene.Normals[Idx];
+				}
+				NumVertices[0] = (uint32_t)Vertices.size();
+				GPUSizes[0] = Vertices.size() * sizeof(FFloatVertex) + GLTFScene.Indices.size() * sizeof(uint32_t);
+				Staging.resize((size_t)GPUSizes[0]);
+				memcpy(Staging.data(), Vertices.data(), Vertices.size() * sizeof(FFloatVertex));
+				memcpy(Staging.data() + Vertices.size() * sizeof(FFloatVertex), GLTFScene.Indices.data(), GLTFScene.Indices.size() * sizeof(uint32_t));
+				Milliseconds[0] = XMMin(Milliseconds[0], Time.GetElapsedTimeFloat());
+			}
+			{
+				EA::StdC::Stopwatch Time(EA::StdC::Stopwatch::kUnitsMilliseconds, true);
+				FMappedFile File;
+				FCookedMesh Mesh;
+				if (!OpenMappedFile(CookedFileName.c_str(), File))
+				{
+					bIsLoaded = false;
+					break;
+				}
+				if (ParseCookedMesh(File.Data, File.Size, Mesh))
+				{
+					NumVertices[1] = Mesh.NumVertices;
+					GPUSizes[1] = (uint64_t)Mesh.NumIndices * Mesh.IndexSize;
+					for (uint32_t Stream = 0; Stream < VERTEX_MAX_STREAMS; ++Stream)
+					{
+						GPUSizes[1] += (uint64_t)Mesh.NumVertices * Mesh.Layout.Strides[Stream];
+					}
+					Staging.resize((size_t)GPUSizes[1]);
+					uint8_t* Ptr = Staging.data();
+					for (uint32_t Stream = 0; Stream < VERTEX_MAX_STREAMS; ++Stream)
+					{
+						memcpy(Ptr, Mesh.VertexStreams[Stream], (size_t)Mesh.NumVertices * Mesh.Layout.Strides[Stream]);
+						Ptr += (size_t)Mesh.NumVertices * Mesh.Layout.Strides[Stream];
+					}
+					memcpy(Ptr, Mesh.Indices, (size_t)Mesh.NumIndices * Mesh.IndexSize);
+				}
+				else
+				{
+					bIsLoaded = false;
+				}
+				CookedFileSize = File.Size;
+				CloseMappedFile(File);
+				Milliseconds[1] = XMMin(Milliseconds[1], Time.GetElapsedTimeFloat());
+			}
+		}
+
+		FMappedFile File;
+		FCookedMesh Mesh;
+		FScene Decoded;
+		if (!bIsLoaded || !OpenMappedFile(CookedFileName.c_str(), File))
+		{
+			printf("%-32s %10s\n", Name.c_str(), "failed");
+			Result = 1;
+			continue;
+		}
+		if (ParseCookedMesh(File.Data, File.Size, Mesh))
+		{
+			DecodeCookedMesh(Mesh, Decoded);
+		}
+		CloseMappedFile(File);
+
+		float MaxPositionError = 0.0f;
+		float MaxNormalError = 0.0f;
+		float MaxTangentError = 0.0f; // 180 when a bitangent sign is wrong.
+		for (size_t Idx = 0; Idx < Decoded.Positions.size() && Decoded.Positions.size() == Scene.Positions.size(); ++Idx)
+		{
+			const XMVECTOR PositionError = XMVector3Length(XMVectorSubtract(XMLoadFloat3(&Decoded.Positions[Idx]), XMLoadFloat3(&Scene.Positions[Idx])));
+			const XMVECTOR CosAngle = XMVector3Dot(XMLoadFloat3(&Decoded.Normals[Idx]), XMVector3Normalize(XMLoadFloat3(&Scene.Normals[Idx])));
+			const XMVECTOR TangentCosAngle = XMVector3Dot(XMLoadFloat4(&Decoded.Tangents[Idx]), XMVector3Normalize(XMLoadFloat4(&Scene.Tangents[Idx])));
+			MaxPositionError = XMMax(MaxPositionError, XMVectorGetX(PositionError));
+			MaxNormalError = XMMax(MaxNormalError, XMConvertToDegrees(acosf(XMMin(XMVectorGetX(CosAngle), 1.0f))));
+			MaxTangentError = XMMax(MaxTangentError, Decoded.Tangents[Idx].w != Scene.Tangents[Idx].w ? 180.0f :
+				XMConvertToDegrees(acosf(XMMin(XMVectorGetX(TangentCosAngle), 1.0f))));
+		}
+
+		static const char* const LoaderNames[] = { "glTF", "cooked" };
+		for (uint32_t Loader = 0; Loader < 2; ++Loader)
+		{
+			printf("%-32s %-8s %10.2f", Name.c_str(), LoaderNames[Loader], Milliseconds[Loader]);
+			if (Loader == 0)
+			{
+				printf(" %10s", "-");
+			}
+			else
+			{
+				printf(" %10.2f", CookedFileSize / (1024.0 * 1024.0));
+			}
+			printf(" %10.2f %10.1f", GPUSizes[Loader] / (1024.0 * 1024.0), (double)GPUSizes[Loader] / XMMax(NumVertices[Loader], 1u));
+			if (Loader == 1)
+			{
+				printf(" %12.3g %12.3g %12.3g", MaxPositionError, MaxNormalError, MaxTangentError);
+			}
+			printf("\n");
+		}
+	}
+	DestroyJobSystem(Jobs);
+	return Result;
+}
+
+static int BenchmarkMeshOptimizer(int Argc, char** Argv)
+{
+	int NumFiles = 0;
+	while (NumFiles < Argc && Argv[NumFiles][0] != '-')
+	{
+		++NumFiles;
+	}
+	uint32_t CacheSize = VERTEX_CACHE_SIZE;
+	uint32_t NumThreads = 0;
+	const FOption Options[] =
+	{
+		{ "-cache", &CacheSize, nullptr },
+		{ "-threads", &NumThreads, nullptr },
+	};
+	if (NumFiles == 0 || !ParseOptions(Argc - NumFiles, Argv + NumFiles, Options, (uint32_t)eastl::size(Options)) || CacheSize == 0)
+	{
+		return -1;
+	}
+
+	FJobSystem Jobs = {};
+	CreateJobSystem(NumThreads, Jobs);
+	printf("FIFO cache of %u vertices, cooked vertex size (both streams), 16 KB direct-mapped vertex fetch cache with 64 byte lines\n", CacheSize);
+	printf("%-32s %-10s %10s %10s %10s %8s %8s %10s %10s\n", "file", "order", "time [ms]", "vertices", "triangles", "ACMR", "ATVR", "fetch hit", "overfetch");
+
+	int Result = 0;
+	for (int FileIdx = 0; FileIdx < NumFiles; ++FileIdx)
+	{
+		const char* FileName = Argv[FileIdx];
+		const eastl::string Name = EA::StdC::Strlen(FileName) > 32 ? eastl::string("...") + (FileName + EA::StdC::Strlen(FileName) - 29) : eastl::string(FileName);
+		FScene Scene;
+		if (!LoadScene(Jobs, FileName, Scene))
+		{
+			printf("%-32s %10s\n", Name.c_str(), "failed");
+			Result = 1;
+			continue;
+		}
+
+		FVertexLayout Layout;
+		InitVertexLayout(GetCookedAttributeMask(Scene), Layout);
+		const uint32_t VertexStride = Layout.Strides[0] + Layout.Strides[1];
+		FVertexCacheStats Stats[2];
+		AnalyzeVertexCache(Scene, VertexStride, CacheSize, Stats[0]);
+		EA::StdC::Stopwatch Time(EA::StdC::Stopwatch::kUnitsMilliseconds, true);
+		OptimizeScene(Scene, CacheSize);
+		const float Milliseconds = Time.GetElapsedTimeFloat();
+		AnalyzeVertexCache(Scene, VertexStride, CacheSize, Stats[1]);
+
+		static const char* const OrderNames[] = { "file", "optimized" };
+		for (uint32_t Order = 0; Order < 2; ++Order)
+		{
+			char TimeText[32] = "-";
+			if (Order == 1)
+			{
+				EA::StdC::Snprintf(TimeText, sizeof(TimeText), "%.2f", Milliseconds);
+			}
+			printf("%-32s %-10s %10s %10u %10u %8.3f %8.3f %10.3f %10.3f\n", Name.c_str(), OrderNames[Order], TimeText, Stats[Order].NumVertices,
+				Stats[Order].NumTriangles, Stats[Order].ACMR, Stats[Order].ATVR, Stats[Order].FetchHitRate, Stats[Order].Overfetch);
+		}
+	}
+
+	DestroyJobSystem(Jobs);
+	return Result;
+}
+
+static int BenchmarkMeshSimplifier(int Argc, char** Argv)
+{
+	int NumFiles = 0;
+	while (NumFiles < Argc && Argv[NumFiles][0] != '-')
+	{
+		++NumFiles;
+	}
+	uint32_t NumRuns = 3;
+	uint32_t NumThreads = 0;
+	const FOption Options[] =
+	{
+		{ "-runs", &NumRuns, nullptr },
+		{ "-threads", &NumThreads, nullptr },
+	};
+	if (NumFiles == 0 || !ParseOptions(Argc - NumFiles, Argv + NumFiles, Options, (uint32_t)eastl::size(Options)) || NumRuns == 0)
+	{
+		return -1;
+	}
+
+	FJobSystem Jobs = {};
+	CreateJobSystem(NumThreads, Jobs);
+	printf("best of %u runs, errors are relative to the bounds diagonal of the section\n", NumRuns);
+	printf("%-32s %10s %10s %5s %12s %10s %12s\n", "file", "time [ms]", "Mtri/s", "LOD", "triangles", "% of LOD0", "max error");
+
+	int Result = 0;
+	for (int FileIdx = 0; FileIdx < NumFiles; ++FileIdx)
+	{
+		const char* FileName = Argv[FileIdx];
+		const eastl::string Name = EA::StdC::Strlen(FileName) > 32 ? eastl::string("...") + (FileName + EA::StdC::Strlen(FileName) - 29) : eastl::string(FileName);
+		FScene Source;
+		if (!LoadScene(Jobs, FileName, Source))
+		{
+			printf("%-32s %10s\n", Name.c_str(), "failed");
+			Result = 1;
+			continue;
+		}
+		OptimizeScene(Source, VERTEX_CACHE_SIZE);
+
+		FScene Scene;
+		float Milliseconds = FLT_MAX;
+		for (uint32_t Run = 0; Run < NumRuns; ++Run)
+		{
+			Scene = Source;
+			EA::StdC::Stopwatch Time(EA::StdC::Stopwatch::kUnitsMilliseconds, true);
+			GenerateLODs(Scene, VERTEX_CACHE_SIZE);
+			Milliseconds = XMMin(Milliseconds, Time.GetElapsedTimeFloat());
+		}
+
+		// Level of every LOD entry (they are grouped by section) and the section diagonals.
+		uint64_t NumTriangles[MAX_MESH_LODS] = {};
+		float MaxErrors[MAX_MESH_LODS] = {};
+		uint32_t NumLevels = 1;
+		eastl::vector<float> Diagonals(Scene.Meshes.size(), 0.0f);
+		for (size_t MeshIdx = 0; MeshIdx < Scene.Meshes.size(); ++MeshIdx)
+		{
+			const FSceneMesh& Mesh = Scene.Meshes[MeshIdx];
+			XMVECTOR BoundsMin = g_XMFltMax;
+			XMVECTOR BoundsMax = XMVectorNegate(g_XMFltMax);
+			for (uint32_t Idx = 0; Idx < Mesh.IndexCount; ++Idx)
+			{
+				const XMVECTOR Position = XMLoadFloat3(&Scene.Positions[Mesh.BaseVertexLocation + Scene.Indices[Mesh.StartIndexLocation + Idx]]);
+				BoundsMin = XMVectorMin(BoundsMin, Position);
+				BoundsMax = XMVectorMax(BoundsMax, Position);
+			}
+			Diagonals[MeshIdx] = Mesh.IndexCount > 0 ? XMVectorGetX(XMVector3Length(XMVectorSubtract(BoundsMax, BoundsMin))) : 0.0f;
+			NumTriangles[0] += Mesh.IndexCount / 3;
+		}
+		for (size_t LODIdx = 0, Level = 1; LODIdx < Scene.LODs.size(); ++LODIdx)
+		{
+			const FSceneMeshLOD& LOD = Scene.LODs[LODIdx];
+			Level = LODIdx > 0 && Scene.LODs[LODIdx - 1].MeshIndex == LOD.MeshIndex ? Level + 1 : 1;
+			NumTriangles[Level] += LOD.IndexCount / 3;
+			MaxErrors[Level] = XMMax(MaxErrors[Level], Diagonals[LOD.MeshIndex] > 0.0f ? LOD.Error / Diagonals[LOD.MeshIndex] : 0.0f);
+			NumLevels = XMMax(NumLevels, (uint32_t)Level + 1);
+		}
+
+		for (uint32_t Level = 0; Level < NumLevels; ++Level)
+		{
+			if (Level == 0)
+			{
+				printf("%-32s %10.2f %10.2f", Name.c_str(), Milliseconds, NumTriangles[0] / 1.0e3 / Milliseconds);
+			}
+			else
+			{
+				printf("%-32s %10s %10s", "", "", "");
+			}
+			printf(" %5u %12llu %10.1f %12.3g\n", Level, (unsigned long long)NumTriangles[Level], 100.0 * NumTriangles[Level] / XMMax(NumTriangles[0], (uint64_t)1),
+				MaxErrors[Level]);
+		}
+	}
+
+	DestroyJobSystem(Jobs);
+	return Result;
+}
+
+// Sorted in the culled index list of an instance to look the reference triangles up.
+struct FTriangleKey
+{
+	uint32_t Indices[3];
+
+	bool operator<(const FTriangleKey& Other) const
+	{
+		return memcmp(Indices, Other.Indices, sizeof(Indices)) < 0;
+	}
+};
+
+static int BenchmarkClusterCulling(int Argc, char** Argv)
+{
+	int NumFiles = 0;
+	while (NumFiles < Argc && Argv[NumFiles][0] != '-')
+	{
+		++NumFiles;
+	}
+	uint32_t NumViews = 64;
+	uint32_t NumRuns = 3;
+	uint32_t NumThreads = 0;
+	const FOption Options[] =
+	{
+		{ "-views", &NumViews, nullptr },
+		{ "-runs", &NumRuns, nullptr },
+		{ "-threads", &NumThreads, nullptr },
+	};
+	if (NumFiles == 0 || !ParseOptions(Argc - NumFiles, Argv + NumFiles, Options, (uint32_t)eastl::size(Options)) || NumViews == 0 || NumRuns == 0)
+	{
+		return -1;
+	}
+
+	FJobSystem Jobs = {};
+	CreateJobSystem(NumThreads, Jobs);
+	printf("%u views at 1.5 bounding radii from the scene center looking at it or one radius above or beside it, 60 degree vertical field of view, "
+		"best of %u runs\n", NumViews, NumRuns);
+	printf("%-32s %10s %8s %8s %10s %9s %9s %9s %9s %9s %12s %8s\n", "file", "clusters", "tri/cl", "vtx/cl", "build [ms]", "frustum", "outside", "backface",
+		"facing", "culled", "ms/Mtri", "diffs");
+
+	int Result = 0;
+	for (int FileIdx = 0; FileIdx < NumFiles; ++FileIdx)
+	{
+		const char* FileName = Argv[FileIdx];
+		const eastl::string Name = EA::StdC::Strlen(FileName) > 32 ? eastl::string("...") + (FileName + EA::StdC::Strlen(FileName) - 29) : eastl::string(FileName);
+		FScene Scene;
+		if (!LoadScene(Jobs, FileName, Scene) || Scene.Instances.empty())
+		{
+			printf("%-32s %10s\n", Name.c_str(), "failed");
+			Result = 1;
+			continue;
+		}
+		OptimizeScene(Scene, VERTEX_CACHE_SIZE);
+		GenerateLODs(Scene, VERTEX_CACHE_SIZE);
+		EA::StdC::Stopwatch BuildTime(EA::StdC::Stopwatch::kUnitsMilliseconds, true);
+		BuildClusters(Scene, VERTEX_CACHE_SIZE);
+		const float BuildMilliseconds = BuildTime.GetElapsedTimeFloat();
+
+		// Cluster sizes of the full detail meshes.
+		uint64_t NumClusterVertices = 0;
+		uint64_t NumClusterTriangles = 0;
+		uint64_t NumClusters = 0;
+		eastl::vector<uint32_t> FirstClusters(Scene.Meshes.size());
+		eastl::vector<uint32_t> NumMeshClusters(Scene.Meshes.size());
+		eastl::vector<uint32_t> Stamps(Scene.Positions.size(), UINT32_MAX);
+		for (size_t MeshIdx = 0; MeshIdx < Scene.Meshes.size(); ++MeshIdx)
+		{
+			const FSceneMesh& Mesh = Scene.Meshes[MeshIdx];
+			GetClusterRange(Scene.Clusters.data(), (uint32_t)Scene.Clusters.size(), Mesh.StartIndexLocation, Mesh.IndexCount, FirstClusters[MeshIdx],
+				NumMeshClusters[MeshIdx]);
+			for (uint32_t ClusterIdx = FirstClusters[MeshIdx]; ClusterIdx < FirstClusters[MeshIdx] + NumMeshClusters[MeshIdx]; ++ClusterIdx)
+			{
+				const FSceneCluster& Cluster = Scene.Clusters[ClusterIdx];
+				for (uint32_t Idx = 0; Idx < Cluster.IndexCount; ++Idx)
+				{
+					uint32_t& Stamp = Stamps[Mesh.BaseVertexLocation + Scene.Indices[Cluster.StartIndexLocation + Idx]];
+					NumClusterVertices += Stamp != ClusterIdx;
+					Stamp = ClusterIdx;
+				}
+				NumClusterTriangles += Cluster.IndexCount / 3;
+			}
+			NumClusters += NumMeshClusters[MeshIdx];
+		}
+
+		// Scene bounds in world space.
+		XMVECTOR BoundsMin = g_XMFltMax;
+		XMVECTOR BoundsMax = XMVectorNegate(g_XMFltMax);
+		for (const FSceneInstance& Instance : Scene.Instances)
+		{
+			const XMMATRIX ObjectToWorld = XMLoadFloat4x3(&Instance.ObjectToWorld);
+			const FSceneMesh& Mesh = Scene.Meshes[Instance.MeshIndex];
+			for (uint32_t Idx = 0; Idx < Mesh.IndexCount; ++Idx)
+			{
+				const XMVECTOR Position = XMVector3TransformCoord(XMLoadFloat3(&Scene.Positions[Mesh.BaseVertexLocation + Scene.Indices[Mesh.StartIndexLocation + Idx]]), ObjectToWorld);
+				BoundsMin = XMVectorMin(BoundsMin, Position);
+				BoundsMax = XMVectorMax(BoundsMax, Position);
+			}
+		}
+		const XMVECTOR Center = XMVectorScale(XMVectorAdd(BoundsMin, BoundsMax), 0.5f);
+		const float Radius = XMMax(0.5f * XMVectorGetX(XMVector3Length(XMVectorSubtract(BoundsMax, BoundsMin))), 1.0e-6f);
+
+		// Cameras on a spherical Fibonacci lattice. Every third one looks at the center, the others one radius off it so
+		// that part of the scene is outside of the frustum.
+		eastl::vector<uint32_t> CulledIndices(Scene.Indices.size());
+		eastl::vector<FTriangleKey> CulledTriangles;
+		FClusterCullStats Stats = {};
+		uint64_t NumFacingAway = 0;
+		uint64_t NumOutside = 0;
+		uint64_t NumDiffs = 0;
+		float Milliseconds = FLT_MAX;
+		for (uint32_t Run = 0; Run < NumRuns; ++Run)
+		{
+			Stats = FClusterCullStats{};
+			float RunMilliseconds = 0.0f;
+			for (uint32_t ViewIdx = 0; ViewIdx < NumViews; ++ViewIdx)
+			{
+				const float CosTheta = 1.0f - (2.0f * ViewIdx + 1.0f) / NumViews;
+				const float SinTheta = sqrtf(XMMax(1.0f - CosTheta * CosTheta, 0.0f));
+				const float Phi = XM_PI * (3.0f - sqrtf(5.0f)) * ViewIdx;
+				const XMVECTOR Direction = XMVectorSet(SinTheta * cosf(Phi), CosTheta, SinTheta * sinf(Phi), 0.0f);
+				const XMVECTOR Eye = XMVectorMultiplyAdd(Direction, XMVectorReplicate(1.5f * Radius), Center);
+				const XMVECTOR Up = fabsf(CosTheta) > 0.99f ? XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f) : XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+				const XMVECTOR Side = XMVector3Normalize(XMVector3Cross(Up, Direction));
+				const XMVECTOR Offsets[3] = { XMVectorZero(), XMVector3Cross(Direction, Side), Side };
+				const XMVECTOR Target = XMVectorMultiplyAdd(Offsets[ViewIdx % 3], XMVectorReplicate(Radius), Center);
+				const XMMATRIX WorldToClip = XMMatrixLookAtLH(Eye, Target, Up) * XMMatrixPerspectiveFovLH(XM_PI / 3, 1.777f, 0.01f * Radius, 10.0f * Radius);
+				XMFLOAT3 CameraPosition;
+				XMStoreFloat3(&CameraPosition, Eye);
+
+				EA::StdC::Stopwatch Time(EA::StdC::Stopwatch::kUnitsMilliseconds, true);
+				for (const FSceneInstance& Instance : Scene.Instances)
+				{
+					FClusterCullView View;
+					InitClusterCullView(XMLoadFloat4x3(&Instance.ObjectToWorld), WorldToClip, CameraPosition, View);
+					CullClusters(View, &Scene.Clusters[FirstClusters[Instance.MeshIndex]], NumMeshClusters[Instance.MeshIndex], Scene.Indices.data(),
+						sizeof(uint32_t), CulledIndices.data(), Stats);
+				}
+				RunMilliseconds += Time.GetElapsedTimeFloat();
+
+				// Per triangle reference: a triangle that faces the camera and is not completely behind one frustum plane must
+				// be in the culled index list.
+				if (Run == 0)
+				{
+					XMFLOAT4 FrustumPlanes[6];
+					GetFrustumPlanes(WorldToClip, FrustumPlanes);
+					for (const FSceneInstance& Instance : Scene.Instances)
+					{
+						const XMMATRIX ObjectToWorld = XMLoadFloat4x3(&Instance.ObjectToWorld);
+						const FSceneMesh& Mesh = Scene.Meshes[Instance.MeshIndex];
+
+						FClusterCullView View;
+						FClusterCullStats InstanceStats = {};
+						InitClusterCullView(ObjectToWorld, WorldToClip, CameraPosition, View);
+						const uint32_t NumCulledIndices = CullClusters(View, &Scene.Clusters[FirstClusters[Instance.MeshIndex]], NumMeshClusters[Instance.MeshIndex],
+							Scene.Indices.data(), sizeof(uint32_t), CulledIndices.data(), InstanceStats);
+						CulledTriangles.clear();
+						for (uint32_t Idx = 0; Idx < NumCulledIndices; Idx += 3)
+						{
+							CulledTriangles.push_back(FTriangleKey{ { CulledIndices[Idx], CulledIndices[Idx + 1], CulledIndices[Idx + 2] } });
+						}
+						eastl::sort(CulledTriangles.begin(), CulledTriangles.end());
+
+						for (uint32_t Idx = 0; Idx < Mesh.IndexCount; Idx += 3)
+						{
+							const uint32_t* Triangle = &Scene.Indices[Mesh.StartIndexLocation + Idx];
+							const XMVECTOR P0 = XMVector3TransformCoord(XMLoadFloat3(&Scene.Positions[Mesh.BaseVertexLocation + Triangle[0]]), ObjectToWorld);
+							const XMVECTOR P1 = XMVector3TransformCoord(XMLoadFloat3(&Scene.Positions[Mesh.BaseVertexLocation + Triangle[1]]), ObjectToWorld);
+							const XMVECTOR P2 = XMVector3TransformCoord(XMLoadFloat3(&Scene.Positions[Mesh.BaseVertexLocation + Triangle[2]]), ObjectToWorld);
+							const XMVECTOR Normal = XMVector3Cross(XMVectorSubtract(P1, P0), XMVectorSubtract(P2, P0));
+							const bool bIsFacingAway = XMVectorGetX(XMVector3Dot(XMVectorSubtract(P0, Eye), Normal)) >= 0.0f;
+							bool bIsOutside = false;
+							for (uint32_t Plane = 0; Plane < 6 && !bIsOutside; ++Plane)
+							{
+								const XMVECTOR PlaneVector = XMLoadFloat4(&FrustumPlanes[Plane]);
+								bIsOutside = XMVectorGetX(XMPlaneDotCoord(PlaneVector, P0)) < 0.0f && XMVectorGetX(XMPlaneDotCoord(PlaneVector, P1)) < 0.0f &&
+									XMVectorGetX(XMPlaneDotCoord(PlaneVector, P2)) < 0.0f;
+							}
+							NumFacingAway += bIsFacingAway;
+							NumOutside += bIsOutside;
+
+							const FTriangleKey Key = { { Triangle[0], Triangle[1], Triangle[2] } };
+							NumDiffs += !bIsFacingAway && !bIsOutside && !eastl::binary_search(CulledTriangles.begin(), CulledTriangles.end(), Key);
+						}
+					}
+				}
+			}
+			Milliseconds = XMMin(Milliseconds, RunMilliseconds);
+		}
+
+		const double NumTriangles = (double)XMMax(Stats.NumTriangles, (uint64_t)1);
+		printf("%-32s %10llu %8.1f %8.1f %10.2f %8.1f%% %8.1f%% %8.1f%% %8.1f%% %8.1f%% %12.3f %8llu\n", Name.c_str(), (unsigned long long)NumClusters,
+			(double)NumClusterTriangles / XMMax(NumClusters, (uint64_t)1), (double)NumClusterVertices / XMMax(NumClusters, (uint64_t)1), BuildMilliseconds,
+			100.0 * Stats.NumFrustumCulledTriangles / NumTriangles, 100.0 * NumOutside / NumTriangles, 100.0 * Stats.NumBackfaceCulledTriangles / NumTriangles,
+			100.0 * NumFacingAway / NumTriangles, 100.0 * (Stats.NumFrustumCulledTriangles + Stats.NumBackfaceCulledTriangles) / NumTriangles,
+			Milliseconds / (NumTriangles / 1.0e6), (unsigned long long)NumDiffs);
+		if (NumDiffs > 0)
+		{
+			Result = 1;
+		}
+	}
+
+	DestroyJobSystem(Jobs);
+	return Result;
+}
+
+static void GetCookedData(const FMappedFile& File, const eastl::vector<uint8_t>& CookedData, const uint8_t*& OutData, uint64_t& OutSize)
+{
+	OutData = CookedData.empty() ? File.Data : CookedData.data();
+	OutSize = CookedData.empty() ? File.Size : CookedData.size();
+}
+
+static int BenchmarkMeshStreaming(int Argc, char** Argv)
+{
+	int NumFiles = 0;
+	while (NumFiles < Argc && Argv[NumFiles][0] != '-')
+	{
+		++NumFiles;
+	}
+	uint32_t NumRuns = 3;
+	uint32_t NumThreads = 0;
+	const FOption Options[] =
+	{
+		{ "-runs", &NumRuns, nullptr },
+		{ "-threads", &NumThreads, nullptr },
+	};
+	if (NumFiles == 0 || !ParseOptions(Argc - NumFiles, Argv + NumFiles, Options, (uint32_t)eastl::size(Options)) || NumRuns == 0)
+	{
+		return -1;
+	}
+
+	FJobSystem Jobs = {};
+	CreateJobSystem(NumThreads, Jobs);
+	printf("%-32s %12s %10s %10s\n", "file", "size [MB]", "time [ms]", "triangles");
+
+	// Serial reference, an empty entry is a failed load.
+	int Result = 0;
+	eastl::vector<eastl::vector<uint8_t>> References(NumFiles);
+	EA::StdC::Stopwatch SerialTime(EA::StdC::Stopwatch::kUnitsMilliseconds, true);
+	for (int FileIdx = 0; FileIdx < NumFiles; ++FileIdx)
+	{
+		const char* FileName = Argv[FileIdx];
+		const eastl::string Name = EA::StdC::Strlen(FileName) > 32 ? eastl::string("...") + (FileName + EA::StdC::Strlen(FileName) - 29) : eastl::string(FileName);
+		EA::StdC::Stopwatch Time(EA::StdC::Stopwatch::kUnitsMilliseconds, true);
+		FMappedFile File = {};
+		eastl::vector<uint8_t> CookedData;
+		FCookedMesh Mesh = {};
+		if (!OpenMeshFile(Jobs, FileName, File, CookedData, Mesh))
+		{
+			printf("%-32s %12s\n", Name.c_str(), "failed");
+			Result = 1;
+			continue;
+		}
+		const float Milliseconds = Time.GetElapsedTimeFloat();
+
+		const uint8_t* Data;
+		uint64_t Size;
+		GetCookedData(File, CookedData, Data, Size);
+		References[FileIdx].assign(Data, Data + Size);
+		CloseMappedFile(File);
+		printf("%-32s %12.2f %10.2f %10u\n", Name.c_str(), Size / (1024.0 * 1024.0), Milliseconds, Mesh.NumIndices / 3);
+	}
+	const float SerialMilliseconds = SerialTime.GetElapsedTimeFloat();
+
+	// Requests are made as soon as a slot is free, the polling thread yields while the oldest one is loading.
+	float Milliseconds = FLT_MAX;
+	float MaxPollMicroseconds = 0.0f;
+	uint32_t NumMismatches = 0;
+	for (uint32_t Run = 0; Run < NumRuns; ++Run)
+	{
+		FMeshStreamer Streamer = {};
+		CreateMeshStreamer(Jobs, Streamer);
+		EA::StdC::Stopwatch Time(EA::StdC::Stopwatch::kUnitsMilliseconds, true);
+
+		int NumRequested = 0;
+		int NumReceived = 0;
+		while (NumReceived < NumFiles)
+		{
+			while (NumRequested < NumFiles && RequestMesh(Streamer, Argv[NumRequested]))
+			{
+				++NumRequested;
+			}
+
+			EA::StdC::Stopwatch PollTime(EA::StdC::Stopwatch::kUnitsMicroseconds, true);
+			bool bHasSucceeded;
+			const FStreamedMesh* Mesh = GetStreamedMesh(Streamer, bHasSucceeded);
+			if (Mesh)
+			{
+				const uint8_t* Data = nullptr;
+				uint64_t Size = 0;
+				if (bHasSucceeded)
+				{
+					GetCookedData(Mesh->File, Mesh->CookedData, Data, Size);
+				}
+				const eastl::vector<uint8_t>& Reference = References[NumReceived];
+				const bool bIsInOrder = Mesh->RequestIndex == (uint32_t)NumReceived && Mesh->FileName == Argv[NumReceived];
+				const bool bIsIdentical = Size == Reference.size() && (Size == 0 || memcmp(Data, Reference.data(), Size) == 0);
+				NumMismatches += !bIsInOrder || !bIsIdentical;
+
+				ReleaseStreamedMesh(Streamer);
+				++NumReceived;
+			}
+			MaxPollMicroseconds = XMMax(MaxPollMicroseconds, PollTime.GetElapsedTimeFloat());
+			if (!Mesh)
+			{
+				EA::Thread::ThreadSleep(EA::Thread::kTimeoutYield);
+			}
+		}
+		Milliseconds = XMMin(Milliseconds, Time.GetElapsedTimeFloat());
+		DestroyMeshStreamer(Streamer);
+	}
+
+	printf("\n%u threads, best of %u streamed runs\n", GetNumThreads(Jobs), NumRuns);
+	printf("%-10s %10s %10s %16s %12s\n", "loader", "time [ms]", "speedup", "max poll [us]", "mismatches");
+	printf("%-10s %10.2f %10s %16s %12s\n", "serial", SerialMilliseconds, "1.00", "-", "-");
+	printf("%-10s %10.2f %10.2f %16.1f %12u\n", "streamed", Milliseconds, SerialMilliseconds / XMMax(Milliseconds, 1.0e-3f), MaxPollMicroseconds,
+		NumMismatches);
+	if (NumMismatches > 0)
+	{
+		Result = 1;
+	}
+
+	DestroyJobSystem(Jobs);
+	return Result;
+}
+
+static float RandomFloat(uint32_t& InOutState)
+{
+	// xorshift32 (Marsaglia 2003).
+	InOutState ^= InOutState << 13;
+	InOutState ^= InOutState >> 17;
+	InOutState ^= InOutState << 5;
+	return (InOutState >> 8) * (1.0f / 16777216.0f);
+}
+
+static XMVECTOR RandomDirection(uint32_t& InOutState)
+{
+	const float CosTheta = 2.0f * RandomFloat(InOutState) - 1.0f;
+	const float SinTheta = sqrtf(XMMax(1.0f - CosTheta * CosTheta, 0.0f));
+	const float Phi = XM_2PI * RandomFloat(InOutState);
+	return XMVectorSet(SinTheta * cosf(Phi), CosTheta, SinTheta * sinf(Phi), 0.0f);
+}
+
+static int BenchmarkInstanceBVH(int Argc, char** Argv)
+{
+	uint32_t NumInstancesOption = 0;
+	uint32_t NumViews = 256;
+	uint32_t NumRays = 4096;
+	uint32_t NumRuns = 3;
+	const FOption Options[] =
+	{
+		{ "-instances", &NumInstancesOption, nullptr },
+		{ "-views", &NumViews, nullptr },
+		{ "-rays", &NumRays, nullptr },
+		{ "-runs", &NumRuns, nullptr },
+	};
+	if (!ParseOptions(Argc, Argv, Options, (uint32_t)eastl::size(Options)) || NumViews == 0 || NumRays == 0 || NumRuns == 0)
+	{
+		return -1;
+	}
+	const uint32_t DefaultNumInstances[] = { 10000, 100000, 1000000 };
+	const uint32_t* NumInstancesList = NumInstancesOption > 0 ? &NumInstancesOption : DefaultNumInstances;
+	const uint32_t NumScenes = NumInstancesOption > 0 ? 1 : (uint32_t)eastl::size(DefaultNumInstances);
+
+	// A cube, a rod, a plate and a sphere.
+	const FSceneBounds MeshBounds[] =
+	{
+		{ XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f), 1.7320508f },
+		{ XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(3.0f, 0.25f, 0.25f), 3.0207615f },
+		{ XMFLOAT3(0.0f, 0.5f, 0.0f), XMFLOAT3(2.0f, 0.1f, 2.0f), 2.8301943f },
+		{ XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f), 1.0f },
+	};
+	const uint32_t NumMeshes = (uint32_t)eastl::size(MeshBounds);
+
+	printf("instances 4 units apart, 60 degree cameras that see half of the cube, rays from inside of it, best of %u runs\n", NumRuns);
+	printf("%10s %11s %10s %10s %10s %10s %9s %11s %11s %10s %10s %8s\n", "instances", "bounds [ms]", "build [ms]", "nodes", "refit [ms]",
+		"update [ms]", "visible", "query [us]", "brute [us]", "ray [us]", "brute [us]", "diffs");
+
+	int Result = 0;
+	for (uint32_t SceneIdx = 0; SceneIdx < NumScenes; ++SceneIdx)
+	{
+		const uint32_t NumInstances = NumInstancesList[SceneIdx];
+		const float Size = 4.0f * cbrtf((float)NumInstances);
+		uint32_t RandomState = 0x9E3779B9u ^ NumInstances;
+
+		eastl::vector<XMFLOAT4X3> ObjectToWorld(NumInstances);
+		eastl::vector<uint32_t> MeshIndices(NumInstances);
+		for (uint32_t Instance = 0; Instance < NumInstances; ++Instance)
+		{
+			const XMVECTOR Rotation = XMQuaternionRotationRollPitchYaw(XM_2PI * RandomFloat(RandomState), XM_2PI * RandomFloat(RandomState),
+				XM_2PI * RandomFloat(RandomState));
+			const float Scale = 0.5f + 1.5f * RandomFloat(RandomState);
+			const XMVECTOR Position = XMVectorScale(XMVectorSet(RandomFloat(RandomState), RandomFloat(RandomState), RandomFloat(RandomState), 0.0f), Size);
+			XMStoreFloat4x3(&ObjectToWorld[Instance], XMMatrixAffineTransformation(XMVectorReplicate(Scale), XMVectorZero(), Rotation, Position));
+			MeshIndices[Instance] = Instance % NumMeshes;
+		}
+
+		FInstanceBounds Bounds = {};
+		FInstanceBVH BVH;
+		eastl::vector<uint32_t> Moved(XMMax(NumInstances / 100, 1u));
+		float BoundsMilliseconds = FLT_MAX;
+		float BuildMilliseconds = FLT_MAX;
+		float RefitMilliseconds = FLT_MAX;
+		float UpdateMilliseconds = FLT_MAX;
+		for (uint32_t Run = 0; Run < NumRuns; ++Run)
+		{
+			EA::StdC::Stopwatch BoundsTime(EA::StdC::Stopwatch::kUnitsMilliseconds, true);
+			ResizeInstanceBounds(NumInstances, Bounds);
+			for (uint32_t Instance = 0; Instance < NumInstances; ++Instance)
+			{
+				SetInstanceBounds(XMLoadFloat4x3(&ObjectToWorld[Instance]), MeshBounds[MeshIndices[Instance]], Instance, Bounds);
+			}
+			BoundsMilliseconds = XMMin(BoundsMilliseconds, BoundsTime.GetElapsedTimeFloat());
+
+			EA::StdC::Stopwatch BuildTime(EA::StdC::Stopwatch::kUnitsMilliseconds, true);
+			BuildInstanceBVH(Bounds, BVH);
+			BuildMilliseconds = XMMin(BuildMilliseconds, BuildTime.GetElapsedTimeFloat());
+
+			// Moves 1% of the instances by up to one unit.
+			for (uint32_t& Instance : Moved)
+			{
+				Instance = XMMin((uint32_t)(RandomFloat(RandomState) * NumInstances), NumInstances - 1);
+			}
+			EA::StdC::Stopwatch UpdateTime(EA::StdC::Stopwatch::kUnitsMilliseconds, true);
+			for (const uint32_t Instance : Moved)
+			{
+				XMFLOAT4X3& Transform = ObjectToWorld[Instance];
+				Transform._41 += 2.0f * RandomFloat(RandomState) - 1.0f;
+				Transform._42 += 2.0f * RandomFloat(RandomState) - 1.0f;
+				Transform._43 += 2.0f * RandomFloat(RandomState) - 1.0f;
+				SetInstanceBounds(XMLoadFloat4x3(&Transform), MeshBounds[MeshIndices[Instance]], Instance, Bounds);
+			}
+			UpdateInstanceBVH(Bounds, Moved.data(), (uint32_t)Moved.size(), BVH);
+			UpdateMilliseconds = XMMin(UpdateMilliseconds, UpdateTime.GetElapsedTimeFloat());
+
+			EA::StdC::Stopwatch RefitTime(EA::StdC::Stopwatch::kUnitsMilliseconds, true);
+			RefitInstanceBVH(Bounds, BVH);
+			RefitMilliseconds = XMMin(RefitMilliseconds, RefitTime.GetElapsedTimeFloat());
+		}
+
+		// Queries run on the tree that was updated and refit by the last run.
+		eastl::vector<uint32_t> Visible(NumInstances);
+		eastl::vector<uint32_t> Reference(NumInstances);
+		uint64_t NumVisible = 0;
+		uint32_t NumDiffs = 0;
+		float QueryMicroseconds = FLT_MAX;
+		float BruteQueryMicroseconds = FLT_MAX;
+		for (uint32_t Run = 0; Run < NumRuns; ++Run)
+		{
+			uint32_t ViewState = 0x2545F491u;
+			float QueryTime = 0.0f;
+			float BruteQueryTime = 0.0f;
+			NumVisible = 0;
+			for (uint32_t ViewIdx = 0; ViewIdx < NumViews; ++ViewIdx)
+			{
+				const XMVECTOR Eye = XMVectorScale(XMVectorSet(RandomFloat(ViewState), RandomFloat(ViewState), RandomFloat(ViewState), 0.0f), Size);
+				const XMVECTOR Direction = RandomDirection(ViewState);
+				const XMVECTOR Up = fabsf(XMVectorGetY(Direction)) > 0.99f ? XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f) : XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+				const XMMATRIX WorldToClip = XMMatrixLookToLH(Eye, Direction, Up) * XMMatrixPerspectiveFovLH(XM_PI / 3, 1.777f, 0.1f, 0.5f * Size);
+				XMFLOAT4 FrustumPlanes[6];
+				GetFrustumPlanes(WorldToClip, FrustumPlanes);
+
+				EA::StdC::Stopwatch Time(EA::StdC::Stopwatch::kUnitsMicroseconds, true);
+				const uint32_t Count = QueryInstanceBVH(BVH, Bounds, FrustumPlanes, Visible.data());
+				QueryTime += Time.GetElapsedTimeFloat();
+				Time.Restart();
+				const uint32_t ReferenceCount = CullInstances(Bounds, FrustumPlanes, Reference.data());
+				BruteQueryTime += Time.GetElapsedTimeFloat();
+
+				NumVisible += Count;
+				if (Run == 0)
+				{
+					eastl::sort(Visible.begin(), Visible.begin() + Count);
+					NumDiffs += Count != ReferenceCount || memcmp(Visible.data(), Reference.data(), Count * sizeof(uint32_t)) != 0;
+				}
+			}
+			QueryMicroseconds = XMMin(QueryMicroseconds, QueryTime / NumViews);
+			BruteQueryMicroseconds = XMMin(BruteQueryMicroseconds, BruteQueryTime / NumViews);
+		}
+
+		float RayMicroseconds = FLT_MAX;
+		float BruteRayMicroseconds = FLT_MAX;
+		for (uint32_t Run = 0; Run < NumRuns; ++Run)
+		{
+			uint32_t RayState = 0x68E31DA4u;
+			float RayTime = 0.0f;
+			float BruteRayTime = 0.0f;
+			for (uint32_t RayIdx = 0; RayIdx < NumRays; ++RayIdx)
+			{
+				XMFLOAT3 Origin, Direction;
+				XMStoreFloat3(&Origin, XMVectorScale(XMVectorSet(RandomFloat(RayState), RandomFloat(RayState), RandomFloat(RayState), 0.0f), Size));
+				XMStoreFloat3(&Direction, RandomDirection(RayState));
+
+				uint32_t Instance, ReferenceInstance;
+				float Distance, ReferenceDistance;
+				EA::StdC::Stopwatch Time(EA::StdC::Stopwatch::kUnitsMicroseconds, true);
+				const bool bHit = RayCastInstanceBVH(BVH, Bounds, Origin, Direction, FLT_MAX, Instance, Distance);
+				RayTime += Time.GetElapsedTimeFloat();
+				Time.Restart();
+				const bool bReferenceHit = RayCastInstances(Bounds, Origin, Direction, FLT_MAX, ReferenceInstance, ReferenceDistance);
+				BruteRayTime += Time.GetElapsedTimeFloat();
+
+				if (Run == 0)
+				{
+					NumDiffs += bHit != bReferenceHit || Instance != ReferenceInstance || Distance != ReferenceDistance;
+				}
+			}
+			RayMicroseconds = XMMin(RayMicroseconds, RayTime / NumRays);
+			BruteRayMicroseconds = XMMin(BruteRayMicroseconds, BruteRayTime / NumRays);
+		}
+
+		printf("%10u %11.2f %10.2f %10u %10.2f %10.3f %8.2f%% %11.2f %11.2f %10.2f %10.2f %8u\n", NumInstances, BoundsMilliseconds, BuildMilliseconds,
+			(uint32_t)BVH.Nodes.size(), RefitMilliseconds, UpdateMilliseconds, 100.0 * NumVisible / ((double)NumViews * NumInstances), QueryMicroseconds,
+			BruteQueryMicroseconds, RayMicroseconds, BruteRayMicroseconds, NumDiffs);
+		if (NumDiffs > 0)
+		{
+			Result = 1;
+		}
+	}
+	return Result;
+}
+
+// Command list of the submission benchmarks: every call the demo makes is written to a stream of packets (the command,
+// then its arguments) the way a D3D12 command list writes its allocator, so submitting costs what writing the packets
+// costs. GPU addresses are CPU pointers, ReplayCommands() reads the constants, instance data and indirect arguments
+// through them.
+enum
+{
+	COMMAND_SetRootConstantBufferView, // Root parameter, address.
+	COMMAND_SetRootShaderResourceView, // Root parameter, address.
+	COMMAND_SetRoot32BitConstant, // Root parameter, value.
+	COMMAND_DrawIndexedInstanced, // Index count, instance count, start index, base vertex.
+	COMMAND_ExecuteIndirect, // Address of FStaticDrawBatch arguments, their count.
+	COMMAND_SetState, // Any other state the demo sets (targets, buffers, pipeline...), two words of made-up arguments.
+};
+
+struct FRecordingCommandList
+{
+	eastl::vector<uint32_t> Packets;
+	uint32_t NumCommands;
+};
+
+static uint32_t* AppendCommand(FRecordingCommandList& CmdList, uint32_t Command, uint32_t NumArguments)
+{
+	const size_t Offset = CmdList.Packets.size();
+	CmdList.Packets.resize(Offset + 1 + NumArguments);
+	CmdList.Packets[Offset] = Command;
+	CmdList.NumCommands += 1;
+	return &CmdList.Packets[Offset + 1];
+}
+
+static void AppendAddressCommand(FRecordingCommandList& CmdList, uint32_t Command, uint32_t RootParameter, const void* Address)
+{
+	uint32_t* Arguments = AppendCommand(CmdList, Command, 3);
+	Arguments[0] = RootParameter;
+	memcpy(&Arguments[1], &Address, sizeof(Address));
+}
+
+// The draws of RecordStaticDraws() the way the demo submitted them: the constants of every instance as root CBV 0.
+static void SubmitStaticDraws(const FStaticDrawList& List, const FPerDrawConstantData* Constants, FRecordingCommandList& CmdList)
+{
+	for (uint32_t Idx = 0; Idx < (uint32_t)List.Commands.size(); ++Idx)
+	{
+		const FStaticDrawCommand& Command = List.Commands[Idx];
+		if (Command.IndexCount > 0)
+		{
+			AppendAddressCommand(CmdList, COMMAND_SetRootConstantBufferView, 0, &Constants[Idx]);
+			uint32_t* Arguments = AppendCommand(CmdList, COMMAND_DrawIndexedInstanced, 4);
+			Arguments[0] = Command.IndexCount;
+			Arguments[1] = 1;
+			Arguments[2] = Command.StartIndexLocation;
+			Arguments[3] = Command.BaseVertexLocation;
+		}
+	}
+}
+
+// State of a command list that the demo records static mesh batches to (see SetDrawTargetState() and
+// SetStaticDrawState() in ImageBasedPBR.cpp): viewport, scissor rect, render targets, topology, vertex and index
+// buffers, pipeline, root signature, per-frame constants and descriptor tables, with the instance data as root SRV 2.
+static void SubmitStaticDrawState(const FStaticInstanceData* Instances, FRecordingCommandList& CmdList)
+{
+	for (uint32_t Idx = 0; Idx < 12; ++Idx)
+	{
+		uint32_t* Arguments = AppendCommand(CmdList, COMMAND_SetState, 2);
+		Arguments[0] = Idx;
+		Arguments[1] = 0;
+	}
+	AppendAddressCommand(CmdList, COMMAND_SetRootShaderResourceView, 2, Instances);
+}
+
+// Batches [Begin, End) of RecordStaticDrawBatches() the way the demo draws them (see DrawStaticBatches()): a root constant
+// and a draw each.
+static void SubmitStaticDrawBatches(const FStaticDrawBatch* Batches, uint32_t Begin, uint32_t End, FRecordingCommandList& CmdList)
+{
+	for (uint32_t Idx = Begin; Idx < End; ++Idx)
+	{
+		const FStaticDrawBatch& Batch = Batches[Idx];
+		uint32_t* Arguments = AppendCommand(CmdList, COMMAND_SetRoot32BitConstant, 2);
+		Arguments[0] = 0;
+		Arguments[1] = Batch.FirstInstance;
+		Arguments = AppendCommand(CmdList, COMMAND_DrawIndexedInstanced, 4);
+		Arguments[0] = Batch.IndexCountPerInstance;
+		Arguments[1] = Batch.InstanceCount;
+		Arguments[2] = Batch.StartIndexLocation;
+		Arguments[3] = (uint32_t)Batch.BaseVertexLocation;
+	}
+}
+
+// All batches with one ExecuteIndirect() of their copy in OutArguments.
+static void SubmitStaticDrawsIndirect(const FStaticDrawList& List, eastl::vector<FStaticDrawBatch>& OutArguments, FRecordingCommandList& CmdList)
+{
+	OutArguments.resize(List.Batches.size());
+	memcpy(OutArguments.data(), List.Batches.data(), List.Batches.size() * sizeof(FStaticDrawBatch));
+	const FStaticDrawBatch* Address = OutArguments.data();
+	uint32_t* Arguments = AppendCommand(CmdList, COMMAND_ExecuteIndirect, 3);
+	memcpy(&Arguments[0], &Address, sizeof(Address));
+	Arguments[2] = (uint32_t)List.Batches.size();
+}
+
+struct FReplayStats
+{
+	uint64_t NumDraws; // DrawIndexedInstanced() calls and indirect arguments.
+	uint64_t NumInstances;
+	uint64_t NumIndices;
+	uint64_t Checksum; // Sum of the hashes of all drawn instances, the same for any order and way of submission.
+	uint64_t OrderedChecksum; // Hash of the hashes of all drawn instances in order.
+	uint64_t NumUnboundInstances; // Drawn without constants or instance data.
+};
+
+// What the GPU would see of a drawn instance: its indices and the data that the vertex shader reads.
+static uint64_t HashDrawnInstance(uint32_t IndexCount, uint32_t StartIndexLocation, uint32_t BaseVertexLocation, const XMFLOAT4X3& ObjectToWorld, const XMFLOAT3& Albedo,
+	float Roughness, float Metallic, float AO, const XMFLOAT3& PositionScale, const XMFLOAT3& PositionBias)
+{
+	uint32_t Words[27] = { IndexCount, StartIndexLocation, BaseVertexLocation };
+	memcpy(&Words[3], &ObjectToWorld, sizeof(ObjectToWorld));
+	memcpy(&Words[15], &Albedo, sizeof(Albedo));
+	memcpy(&Words[18], &Roughness, sizeof(float));
+	memcpy(&Words[19], &Metallic, sizeof(float));
+	memcpy(&Words[20], &AO, sizeof(float));
+	memcpy(&Words[21], &PositionScale, sizeof(PositionScale));
+	memcpy(&Words[24], &PositionBias, sizeof(PositionBias));
+	uint64_t Hash = 14695981039346656037ull; // FNV-1a
+	for (uint32_t Word : Words)
+	{
+		Hash = (Hash ^ Word) * 1099511628211ull;
+	}
+	return Hash;
+}
+
+// Executes the recorded commands against the root signatures of the demo's static mesh pipelines: root CBV 0 of
+// FPerDrawConstantData (before instancing) or root constant 0 with the first instance in the instance data of root SRV 2.
+// Like a command list on the GPU, the list starts without root arguments, command lists replayed one after another
+// with the same stats add up to their execution in order.
+static void ReplayCommands(const FRecordingCommandList& CmdList, FReplayStats& InOutStats)
+{
+	uint64_t RootValues[3] = {};
+	bool bPerDrawConstants = false;
+	auto Draw = [&](uint32_t IndexCount, uint32_t InstanceCount, uint32_t StartIndexLocation, uint32_t BaseVertexLocation)
+	{
+		InOutStats.NumDraws += 1;
+		InOutStats.NumInstances += InstanceCount;
+		InOutStats.NumIndices += (uint64_t)IndexCount * InstanceCount;
+		for (uint32_t InstanceIdx = 0; InstanceIdx < InstanceCount; ++InstanceIdx)
+		{
+			uint64_t Hash;
+			if (bPerDrawConstants && RootValues[0] != 0)
+			{
+				const auto* Constants = (const FPerDrawConstantData*)RootValues[0];
+				Hash = HashDrawnInstance(IndexCount, StartIndexLocation, BaseVertexLocation, Constants->ObjectToWorld, Constants->Albedo, Constants->Roughness,
+					Constants->Metallic, Constants->AO, Constants->PositionScale, Constants->PositionBias);
+			}
+			else if (!bPerDrawConstants && RootValues[2] != 0)
+			{
+				const FStaticInstanceData& Instance = ((const FStaticInstanceData*)RootValues[2])[RootValues[0] + InstanceIdx];
+				Hash = HashDrawnInstance(IndexCount, StartIndexLocation, BaseVertexLocation, Instance.ObjectToWorld, Instance.Albedo, Instance.Roughness,
+					Instance.Metallic, Instance.AO, Instance.PositionScale, Instance.PositionBias);
+			}
+			else
+			{
+				InOutStats.NumUnboundInstances += 1;
+				continue;
+			}
+			InOutStats.Checksum += Hash;
+			InOutStats.OrderedChecksum = (InOutStats.OrderedChecksum ^ Hash) * 1099511628211ull;
+		}
+	};
+
+	const uint32_t* Packet = CmdList.Packets.data();
+	for (uint32_t CommandIdx = 0; CommandIdx < CmdList.NumCommands; ++CommandIdx)
+	{
+		const uint32_t* Arguments = Packet + 1;
+		switch (Packet[0])
+		{
+		case COMMAND_SetRootConstantBufferView:
+		case COMMAND_SetRootShaderResourceView:
+			memcpy(&RootValues[Arguments[0]], &Arguments[1], sizeof(uint64_t));
+			bPerDrawConstants = Packet[0] == COMMAND_SetRootConstantBufferView ? Arguments[0] == 0 : bPerDrawConstants;
+			Packet += 4;
+			break;
+		case COMMAND_SetRoot32BitConstant:
+			RootValues[Arguments[0]] = Arguments[1];
+			bPerDrawConstants = bPerDrawConstants && Arguments[0] != 0;
+			Packet += 3;
+			break;
+		case COMMAND_DrawIndexedInstanced:
+			Draw(Arguments[0], Arguments[1], Arguments[2], Arguments[3]);
+			Packet += 5;
+			break;
+		case COMMAND_SetState:
+			Packet += 3;
+			break;
+		case COMMAND_ExecuteIndirect:
+		{
+			const FStaticDrawBatch* Batches;
+			memcpy(&Batches, &Arguments[0], sizeof(Batches));
+			bPerDrawConstants = false;
+			for (uint32_t Idx = 0; Idx < Arguments[2]; ++Idx)
+			{
+				RootValues[0] = Batches[Idx].FirstInstance;
+				Draw(Batches[Idx].IndexCountPerInstance, Batches[Idx].InstanceCount, Batches[Idx].StartIndexLocation, (uint32_t)Batches[Idx].BaseVertexLocation);
+			}
+			Packet += 4;
+			break;
+		}
+		default:
+			return; // Not recorded by any Submit...() above.
+		}
+	}
+}
+
+// Adds the meshes of the files to the scene the way the demo adds the built-in ones, every section is one mesh of the mix.
+static bool LoadBenchmarkScene(const char* const* FileNames, int NumFiles, FStaticScene& OutScene)
+{
+	FStaticScene& Scene = OutScene;
+	FJobSystem Jobs = {};
+	CreateJobSystem(0, Jobs);
+	eastl::vector<FMappedFile> Files(NumFiles);
+	eastl::vector<eastl::vector<uint8_t>> CookedData(NumFiles);
+	eastl::vector<FCookedMesh> Meshes(NumFiles);
+	Scene.IndexSize = 2;
+	bool bHasFailed = false;
+	for (int FileIdx = 0; FileIdx < NumFiles; ++FileIdx)
+	{
+		Files[FileIdx] = FMappedFile{};
+		Meshes[FileIdx] = FCookedMesh{};
+		if (!OpenMeshFile(Jobs, FileNames[FileIdx], Files[FileIdx], CookedData[FileIdx], Meshes[FileIdx]))
+		{
+			fprintf(stderr, "Failed to load %s\n", FileNames[FileIdx]);
+			bHasFailed = true;
+			continue;
+		}
+		Scene.IndexSize = XMMax(Scene.IndexSize, Meshes[FileIdx].IndexSize);
+	}
+	uint32_t NumVertices = 0;
+	for (int FileIdx = 0; FileIdx < NumFiles && !bHasFailed; ++FileIdx)
+	{
+		AddStaticSceneMesh(Meshes[FileIdx], NumVertices, (uint32_t)(Scene.Indices.size() / Scene.IndexSize), false, Scene);
+		AppendStaticSceneIndices(Meshes[FileIdx], Scene);
+		NumVertices += Meshes[FileIdx].NumVertices;
+	}
+	for (FMappedFile& File : Files)
+	{
+		CloseMappedFile(File);
+	}
+	DestroyJobSystem(Jobs);
+	return !bHasFailed;
+}
+
+static int BenchmarkStaticScene(int Argc, char** Argv)
+{
+	int NumFiles = 0;
+	while (NumFiles < Argc && Argv[NumFiles][0] != '-')
+	{
+		++NumFiles;
+	}
+	uint32_t NumInstances = 100000;
+	uint32_t MovingPercent = 10;
+	uint32_t NumFrames = 30;
+	uint32_t MaxThreads = 0;
+	uint32_t bCullClusters = 1;
+	const FOption Options[] =
+	{
+		{ "-instances", &NumInstances, nullptr },
+		{ "-moving", &MovingPercent, nullptr },
+		{ "-frames", &NumFrames, nullptr },
+		{ "-threads", &MaxThreads, nullptr },
+		{ "-clusters", &bCullClusters, nullptr },
+	};
+	if (!ParseOptions(Argc - NumFiles, Argv + NumFiles, Options, (uint32_t)eastl::size(Options)) || NumInstances == 0 || NumFrames == 0)
+	{
+		return -1;
+	}
+	const char* DefaultFileNames[] = { "Data/Meshes/Cube.mesh", "Data/Meshes/Sphere.mesh" };
+	const char* const* FileNames = NumFiles > 0 ? Argv : DefaultFileNames;
+	NumFiles = NumFiles > 0 ? NumFiles : (int)eastl::size(DefaultFileNames);
+	if (MaxThreads == 0)
+	{
+		MaxThreads = (uint32_t)XMMax(EA::Thread::GetProcessorCount(), 1);
+	}
+
+	FStaticScene Scene = {};
+	if (!LoadBenchmarkScene(FileNames, NumFiles, Scene))
+	{
+		return 1;
+	}
+
+	FStaticSceneDesc Desc;
+	Desc.NumInstances = NumInstances;
+	Desc.FirstMesh = 0;
+	Desc.NumMeshes = (uint32_t)Scene.Meshes.size();
+	Desc.MovingFraction = XMMin(MovingPercent, 100u) / 100.0f;
+	Desc.Seed = 1;
+
+	// The demo's camera and view: 60 degree field of view, 1 pixel of LOD error at 1080p, 60 frames per second.
+	const float FovY = XM_PI / 3;
+	const float FrameTime = 1.0f / 60.0f;
+	FStaticDrawView View;
+	View.MaxLODErrorAtUnitDistance = 1.0f * 2.0f * tanf(0.5f * FovY) / 1080.0f;
+	View.bCullClusters = bCullClusters != 0;
+
+	eastl::vector<uint32_t> Visible(NumInstances);
+	eastl::vector<FStaticInstanceData> InstanceData(NumInstances);
+	eastl::vector<FStaticDrawBatch> IndirectArguments;
+	FStaticDrawList DrawList = {};
+	eastl::vector<uint8_t> CulledIndices;
+
+	printf("%u instances of %u meshes, %u%% moving, %u frames, cluster culling %s\n", NumInstances, Desc.NumMeshes, XMMin(MovingPercent, 100u), NumFrames,
+		View.bCullClusters ? "on" : "off");
+	printf("%8s %9s %13s %13s %13s %13s %13s %10s %8s\n", "threads", "visible", "animate [ns]", "cull [ns]", "record [ns]", "submit [ns]", "frame [ms]",
+		"speedup", "diffs");
+
+	int Result = 0;
+	double SingleThreadedTime = 0.0;
+	FReplayStats Reference = {};
+	for (uint32_t NumThreads = 1; NumThreads <= MaxThreads; NumThreads = NumThreads < MaxThreads ? XMMin(2 * NumThreads, MaxThreads) : NumThreads + 1)
+	{
+		FJobSystem Jobs = {};
+		CreateJobSystem(NumThreads > 1 ? NumThreads - 1 : JOB_SYSTEM_NO_WORKERS, Jobs);
+
+		// Every thread count starts from the same scene and sees the same frames.
+		const float HalfSize = GenerateStaticScene(Desc, Scene);
+		BuildStaticSceneBVH(Scene);
+		const float CameraDistance = 1.5f * HalfSize;
+		const XMMATRIX Projection = XMMatrixPerspectiveFovLH(FovY, 1.777f, 0.1f, XMMax(100.0f, 4.0f * CameraDistance));
+
+		double AnimateTime = 0.0;
+		double CullTime = 0.0;
+		double RecordTime = 0.0;
+		double SubmitTime = 0.0;
+		uint64_t NumVisible = 0;
+		FRecordingCommandList CmdList = {};
+		FReplayStats Replay = {};
+		for (uint32_t Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			const float Time = Frame * FrameTime;
+			const float Angle = XMScalarModAngle(0.25f * Time);
+			XMStoreFloat3(&View.CameraPosition, XMVectorSet(CameraDistance * cosf(Angle), 0.5f * CameraDistance, CameraDistance * sinf(Angle), 1.0f));
+			const XMMATRIX WorldToClip = XMMatrixLookAtLH(XMLoadFloat3(&View.CameraPosition), XMVectorZero(), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)) * Projection;
+			XMStoreFloat4x4(&View.WorldToClip, WorldToClip);
+
+			EA::StdC::Stopwatch Stopwatch(EA::StdC::Stopwatch::kUnitsNanoseconds, true);
+			AnimateStaticScene(Jobs, Time, Scene);
+			AnimateTime += Stopwatch.GetElapsedTime();
+
+			Stopwatch.Restart();
+			XMFLOAT4 FrustumPlanes[6];
+			GetFrustumPlanes(WorldToClip, FrustumPlanes);
+			const uint32_t Count = QueryInstanceBVH(Scene.InstanceBVH, Scene.InstanceBounds, FrustumPlanes, Visible.data());
+			CullTime += Stopwatch.GetElapsedTime();
+
+			Stopwatch.Restart();
+			SelectStaticDrawLODs(Jobs, Scene, View, Visible.data(), Count, DrawList);
+			RecordTime += Stopwatch.GetElapsedTime();
+
+			// Grown outside of the timer, the demo grows its culled index buffers only when they are too small.
+			if (View.bCullClusters)
+			{
+				CulledIndices.resize(XMMax(CulledIndices.size(), (size_t)DrawList.MaxCulledIndexCount * Scene.IndexSize));
+			}
+
+			Stopwatch.Restart();
+			RecordStaticDrawBatches(Jobs, Scene, View, Visible.data(), Count, CulledIndices.data(), InstanceData.data(), DrawList);
+			RecordTime += Stopwatch.GetElapsedTime();
+
+			CmdList.Packets.clear();
+			CmdList.NumCommands = 0;
+			Stopwatch.Restart();
+			SubmitStaticDrawState(InstanceData.data(), CmdList);
+			if (DrawList.Batches.size() >= STATIC_DRAW_INDIRECT_MIN_BATCHES)
+			{
+				SubmitStaticDrawsIndirect(DrawList, IndirectArguments, CmdList);
+			}
+			else
+			{
+				SubmitStaticDrawBatches(DrawList.Batches.data(), 0, (uint32_t)DrawList.Batches.size(), CmdList);
+			}
+			SubmitTime += Stopwatch.GetElapsedTime();
+			ReplayCommands(CmdList, Replay);
+
+			NumVisible += Count;
+		}
+
+		if (NumThreads == 1)
+		{
+			SingleThreadedTime = AnimateTime + CullTime + RecordTime + SubmitTime;
+			Reference = Replay;
+		}
+		const uint32_t NumDiffs = Replay.NumIndices != Reference.NumIndices || Replay.Checksum != Reference.Checksum;
+		const double PerInstance = 1.0 / ((double)NumFrames * NumInstances);
+		const double PerVisible = 1.0 / (double)XMMax(NumVisible, (uint64_t)1);
+		const double FrameTimeTotal = AnimateTime + CullTime + RecordTime + SubmitTime;
+		printf("%8u %8.2f%% %13.1f %13.1f %13.1f %13.1f %13.3f %9.2fx %8u\n", GetNumThreads(Jobs), 100.0 * NumVisible * PerInstance, AnimateTime * PerInstance,
+			CullTime * PerInstance, RecordTime * PerVisible, SubmitTime * PerVisible, 1e-6 * FrameTimeTotal / NumFrames, SingleThreadedTime / FrameTimeTotal, NumDiffs);
+		if (NumDiffs > 0)
+		{
+			Result = 1;
+		}
+		DestroyJobSystem(Jobs);
+	}
+	return Result;
+}
+
+// Ways of submitting the static mesh draws of a frame.
+enum
+{
+	SUBMISSION_PerDraw, // RecordStaticDraws(), constants and a draw per instance, the demo before instancing.
+	SUBMISSION_Instanced, // RecordStaticDrawBatches(), a root constant and DrawIndexedInstanced() per batch.
+	SUBMISSION_Indirect, // RecordStaticDrawBatches(), one ExecuteIndirect() of all batches.
+	SUBMISSION_Count,
+};
+
+static int BenchmarkDrawSubmission(int Argc, char** Argv)
+{
+	int NumFiles = 0;
+	while (NumFiles < Argc && Argv[NumFiles][0] != '-')
+	{
+		++NumFiles;
+	}
+	uint32_t NumInstances = 100000;
+	uint32_t NumFrames = 30;
+	uint32_t NumThreads = 1;
+	const FOption Options[] =
+	{
+		{ "-instances", &NumInstances, nullptr },
+		{ "-frames", &NumFrames, nullptr },
+		{ "-threads", &NumThreads, nullptr },
+	};
+	if (!ParseOptions(Argc - NumFiles, Argv + NumFiles, Options, (uint32_t)eastl::size(Options)) || NumInstances == 0 || NumFrames == 0 || NumThreads == 0)
+	{
+		return -1;
+	}
+	const char* DefaultFileNames[] = { "Data/Meshes/Cube.mesh", "Data/Meshes/Sphere.mesh" };
+	const char* const* FileNames = NumFiles > 0 ? Argv : DefaultFileNames;
+	NumFiles = NumFiles > 0 ? NumFiles : (int)eastl::size(DefaultFileNames);
+
+	FStaticScene Scene = {};
+	if (!LoadBenchmarkScene(FileNames, NumFiles, Scene))
+	{
+		return 1;
+	}
+	FStaticSceneDesc Desc;
+	Desc.NumInstances = NumInstances;
+	Desc.FirstMesh = 0;
+	Desc.NumMeshes = (uint32_t)Scene.Meshes.size();
+	Desc.MovingFraction = 0.0f;
+	Desc.Seed = 1;
+	const float HalfSize = GenerateStaticScene(Desc, Scene);
+	BuildStaticSceneBVH(Scene);
+
+	// The camera of scene-benchmark.
+	const float FovY = XM_PI / 3;
+	const float FrameTime = 1.0f / 60.0f;
+	const float CameraDistance = 1.5f * HalfSize;
+	const XMMATRIX Projection = XMMatrixPerspectiveFovLH(FovY, 1.777f, 0.1f, XMMax(100.0f, 4.0f * CameraDistance));
+	FStaticDrawView View;
+	View.MaxLODErrorAtUnitDistance = 1.0f * 2.0f * tanf(0.5f * FovY) / 1080.0f;
+
+	FJobSystem Jobs = {};
+	CreateJobSystem(NumThreads > 1 ? NumThreads - 1 : JOB_SYSTEM_NO_WORKERS, Jobs);
+	eastl::vector<uint32_t> Visible(NumInstances);
+	eastl::vector<FPerDrawConstantData> Constants(NumInstances);
+	eastl::vector<FStaticInstanceData> InstanceData(NumInstances);
+	eastl::vector<FStaticDrawBatch> IndirectArguments;
+	eastl::vector<uint8_t> CulledIndices;
+	FStaticDrawList DrawList = {};
+	FRecordingCommandList CmdList = {};
+
+	printf("%u instances of %u meshes, %u frames, %u threads\n", NumInstances, Desc.NumMeshes, NumFrames, GetNumThreads(Jobs));
+	printf("%10s %9s %9s %18s %18s %18s %12s %12s %12s %8s\n", "submission", "clusters", "visible", "record [ms/100k]", "submit [ms/100k]", "total [ms/100k]",
+		"commands", "packets [KB]", "upload [KB]", "diffs");
+
+	static const char* SubmissionNames[] = { "per-draw", "instanced", "indirect" };
+	static_assert(eastl::size(SubmissionNames) == SUBMISSION_Count, "Missing submission name.");
+	int Result = 0;
+	for (uint32_t bCullClusters = 0; bCullClusters < 2; ++bCullClusters)
+	{
+		View.bCullClusters = bCullClusters != 0;
+		double RecordTimes[SUBMISSION_Count] = {};
+		double SubmitTimes[SUBMISSION_Count] = {};
+		uint64_t NumCommands[SUBMISSION_Count] = {};
+		uint64_t NumPacketBytes[SUBMISSION_Count] = {};
+		uint64_t NumUploadBytes[SUBMISSION_Count] = {};
+		uint32_t NumDiffs[SUBMISSION_Count] = {};
+		uint64_t NumVisible = 0;
+		for (uint32_t Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			const float Angle = XMScalarModAngle(0.25f * Frame * FrameTime);
+			XMStoreFloat3(&View.CameraPosition, XMVectorSet(CameraDistance * cosf(Angle), 0.5f * CameraDistance, CameraDistance * sinf(Angle), 1.0f));
+			const XMMATRIX WorldToClip = XMMatrixLookAtLH(XMLoadFloat3(&View.CameraPosition), XMVectorZero(), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)) * Projection;
+			XMStoreFloat4x4(&View.WorldToClip, WorldToClip);
+			XMFLOAT4 FrustumPlanes[6];
+			GetFrustumPlanes(WorldToClip, FrustumPlanes);
+			const uint32_t Count = QueryInstanceBVH(Scene.InstanceBVH, Scene.InstanceBounds, FrustumPlanes, Visible.data());
+			NumVisible += Count;
+
+			// Every way sees the same LODs and culled clusters, only the recording and submission are timed.
+			FReplayStats Replays[SUBMISSION_Count] = {};
+			for (uint32_t Submission = 0; Submission < SUBMISSION_Count; ++Submission)
+			{
+				SelectStaticDrawLODs(Jobs, Scene, View, Visible.data(), Count, DrawList);
+				if (View.bCullClusters)
+				{
+					CulledIndices.resize(XMMax(CulledIndices.size(), (size_t)DrawList.MaxCulledIndexCount * Scene.IndexSize));
+				}
+				CmdList.Packets.clear();
+				CmdList.NumCommands = 0;
+
+				EA::StdC::Stopwatch Stopwatch(EA::StdC::Stopwatch::kUnitsNanoseconds, true);
+				if (Submission == SUBMISSION_PerDraw)
+				{
+					RecordStaticDraws(Jobs, Scene, View, Visible.data(), Count, CulledIndices.data(), Constants.data(), DrawList);
+				}
+				else
+				{
+					RecordStaticDrawBatches(Jobs, Scene, View, Visible.data(), Count, CulledIndices.data(), InstanceData.data(), DrawList);
+				}
+				RecordTimes[Submission] += Stopwatch.GetElapsedTime();
+
+				Stopwatch.Restart();
+				if (Submission == SUBMISSION_PerDraw)
+				{
+					SubmitStaticDraws(DrawList, Constants.data(), CmdList);
+				}
+				else
+				{
+					SubmitStaticDrawState(InstanceData.data(), CmdList);
+					if (Submission == SUBMISSION_Indirect)
+					{
+						SubmitStaticDrawsIndirect(DrawList, IndirectArguments, CmdList);
+					}
+					else
+					{
+						SubmitStaticDrawBatches(DrawList.Batches.data(), 0, (uint32_t)DrawList.Batches.size(), CmdList);
+					}
+				}
+				SubmitTimes[Submission] += Stopwatch.GetElapsedTime();
+
+				ReplayCommands(CmdList, Replays[Submission]);
+				NumCommands[Submission] += CmdList.NumCommands;
+				NumPacketBytes[Submission] += CmdList.Packets.size() * sizeof(uint32_t);
+				NumUploadBytes[Submission] += Submission == SUBMISSION_PerDraw ? (uint64_t)Count * sizeof(FPerDrawConstantData) :
+					Replays[Submission].NumInstances * sizeof(FStaticInstanceData);
+				NumUploadBytes[Submission] += Submission == SUBMISSION_Indirect ? DrawList.Batches.size() * sizeof(FStaticDrawBatch) : 0;
+				NumDiffs[Submission] += Replays[Submission].NumIndices != Replays[SUBMISSION_PerDraw].NumIndices ||
+					Replays[Submission].Checksum != Replays[SUBMISSION_PerDraw].Checksum;
+			}
+		}
+
+		const double Per100k = 1e-6 * 100000.0 / (double)XMMax(NumVisible, (uint64_t)1);
+		for (uint32_t Submission = 0; Submission < SUBMISSION_Count; ++Submission)
+		{
+			printf("%10s %9s %8.2f%% %18.3f %18.3f %18.3f %12llu %12.1f %12.1f %8u\n", SubmissionNames[Submission], View.bCullClusters ? "culled" : "all",
+				100.0 * NumVisible / ((double)NumFrames * NumInstances), RecordTimes[Submission] * Per100k, SubmitTimes[Submission] * Per100k,
+				(RecordTimes[Submission] + SubmitTimes[Submission]) * Per100k, (unsigned long long)(NumCommands[Submission] / NumFrames),
+				NumPacketBytes[Submission] / (1024.0 * NumFrames), NumUploadBytes[Submission] / (1024.0 * NumFrames), NumDiffs[Submission]);
+			if (NumDiffs[Submission] > 0)
+			{
+				Result = 1;
+			}
+		}
+	}
+	DestroyJobSystem(Jobs);
+	return Result;
+}
+
+#define BENCHMARK_MAX_COMMAND_LISTS 32 // MAX_JOB_COMMAND_LISTS of the demo (see Library.h).
+
+static int BenchmarkCommandLists(int Argc, char** Argv)
+{
+	int NumFiles = 0;
+	while (NumFiles < Argc && Argv[NumFiles][0] != '-')
+	{
+		++NumFiles;
+	}
+	uint32_t NumInstances = 100000;
+	uint32_t NumFrames = 30;
+	uint32_t MaxThreads = BENCHMARK_MAX_COMMAND_LISTS;
+	uint32_t bCullClusters = 1;
+	const FOption Options[] =
+	{
+		{ "-instances", &NumInstances, nullptr },
+		{ "-frames", &NumFrames, nullptr },
+		{ "-threads", &MaxThreads, nullptr },
+		{ "-clusters", &bCullClusters, nullptr },
+	};
+	if (!ParseOptions(Argc - NumFiles, Argv + NumFiles, Options, (uint32_t)eastl::size(Options)) || NumInstances == 0 || NumFrames == 0 || MaxThreads == 0)
+	{
+		return -1;
+	}
+	const char* DefaultFileNames[] = { "Data/Meshes/Cube.mesh", "Data/Meshes/Sphere.mesh" };
+	const char* const* FileNames = NumFiles > 0 ? Argv : DefaultFileNames;
+	NumFiles = NumFiles > 0 ? NumFiles : (int)eastl::size(DefaultFileNames);
+
+	FStaticScene Scene = {};
+	if (!LoadBenchmarkScene(FileNames, NumFiles, Scene))
+	{
+		return 1;
+	}
+	FStaticSceneDesc Desc;
+	Desc.NumInstances = NumInstances;
+	Desc.FirstMesh = 0;
+	Desc.NumMeshes = (uint32_t)Scene.Meshes.size();
+	Desc.MovingFraction = 0.0f;
+	Desc.Seed = 1;
+	const float HalfSize = GenerateStaticScene(Desc, Scene);
+	BuildStaticSceneBVH(Scene);
+
+	// The camera of scene-benchmark.
+	const float FovY = XM_PI / 3;
+	const float FrameTime = 1.0f / 60.0f;
+	const float CameraDistance = 1.5f * HalfSize;
+	const XMMATRIX Projection = XMMatrixPerspectiveFovLH(FovY, 1.777f, 0.1f, XMMax(100.0f, 4.0f * CameraDistance));
+	FStaticDrawView View;
+	View.MaxLODErrorAtUnitDistance = 1.0f * 2.0f * tanf(0.5f * FovY) / 1080.0f;
+	View.bCullClusters = bCullClusters != 0;
+
+	eastl::vector<uint32_t> Visible(NumInstances);
+	eastl::vector<FStaticInstanceData> InstanceData(NumInstances);
+	eastl::vector<uint8_t> CulledIndices;
+	FStaticDrawList DrawList = {};
+	// Kept over the frames like the demo's lists and allocators, the packets keep their capacity.
+	FRecordingCommandList CmdLists[BENCHMARK_MAX_COMMAND_LISTS];
+
+	printf("%u instances of %u meshes, %u frames, cluster culling %s\n", NumInstances, Desc.NumMeshes, NumFrames, View.bCullClusters ? "on" : "off");
+	printf("%8s %8s %9s %16s %18s %10s %12s %8s\n", "threads", "lists", "batches", "record [ms]", "record [ms/100k]", "speedup", "commands", "diffs");
+
+	int Result = 0;
+	double SingleThreadedTime = 0.0;
+	eastl::vector<FReplayStats> References(NumFrames);
+	for (uint32_t NumThreads = 1; NumThreads <= MaxThreads; NumThreads = NumThreads < MaxThreads ? XMMin(2 * NumThreads, MaxThreads) : NumThreads + 1)
+	{
+		FJobSystem Jobs = {};
+		CreateJobSystem(NumThreads > 1 ? NumThreads - 1 : JOB_SYSTEM_NO_WORKERS, Jobs);
+
+		double RecordTime = 0.0;
+		uint64_t NumBatches = 0;
+		uint64_t NumLists = 0;
+		uint64_t NumCommands = 0;
+		uint32_t NumDiffs = 0;
+		for (uint32_t Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			const float Angle = XMScalarModAngle(0.25f * Frame * FrameTime);
+			XMStoreFloat3(&View.CameraPosition, XMVectorSet(CameraDistance * cosf(Angle), 0.5f * CameraDistance, CameraDistance * sinf(Angle), 1.0f));
+			const XMMATRIX WorldToClip = XMMatrixLookAtLH(XMLoadFloat3(&View.CameraPosition), XMVectorZero(), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)) * Projection;
+			XMStoreFloat4x4(&View.WorldToClip, WorldToClip);
+			XMFLOAT4 FrustumPlanes[6];
+			GetFrustumPlanes(WorldToClip, FrustumPlanes);
+			const uint32_t Count = QueryInstanceBVH(Scene.InstanceBVH, Scene.InstanceBounds, FrustumPlanes, Visible.data());
+
+			SelectStaticDrawLODs(Jobs, Scene, View, Visible.data(), Count, DrawList);
+			if (View.bCullClusters)
+			{
+				CulledIndices.resize(XMMax(CulledIndices.size(), (size_t)DrawList.MaxCulledIndexCount * Scene.IndexSize));
+			}
+			RecordStaticDrawBatches(Jobs, Scene, View, Visible.data(), Count, CulledIndices.data(), InstanceData.data(), DrawList);
+
+			// Only the recording of the draws is timed, the way Draw() in ImageBasedPBR.cpp splits it when ExecuteIndirect()
+			// is off: every list gets its state and a range of the batches.
+			const auto FrameBatches = (uint32_t)DrawList.Batches.size();
+			const uint32_t FrameLists = GetNumStaticDrawCommandLists(FrameBatches, XMMin(NumThreads, (uint32_t)BENCHMARK_MAX_COMMAND_LISTS));
+			for (uint32_t ListIdx = 0; ListIdx < FrameLists; ++ListIdx)
+			{
+				CmdLists[ListIdx].Packets.clear();
+				CmdLists[ListIdx].NumCommands = 0;
+			}
+			EA::StdC::Stopwatch Stopwatch(EA::StdC::Stopwatch::kUnitsNanoseconds, true);
+			ParallelFor(Jobs, FrameLists, 1, [&](uint32_t Begin, uint32_t End)
+			{
+				for (uint32_t ListIdx = Begin; ListIdx < End; ++ListIdx)
+				{
+					SubmitStaticDrawState(InstanceData.data(), CmdLists[ListIdx]);
+					SubmitStaticDrawBatches(DrawList.Batches.data(), GetStaticDrawCommandListBegin(FrameBatches, FrameLists, ListIdx),
+						GetStaticDrawCommandListBegin(FrameBatches, FrameLists, ListIdx + 1), CmdLists[ListIdx]);
+				}
+			});
+			RecordTime += Stopwatch.GetElapsedTime();
+
+			// Executed in order, the lists must draw what the one list of a single thread draws, in the same order.
+			FReplayStats Replay = {};
+			for (uint32_t ListIdx = 0; ListIdx < FrameLists; ++ListIdx)
+			{
+				ReplayCommands(CmdLists[ListIdx], Replay);
+				NumCommands += CmdLists[ListIdx].NumCommands;
+			}
+			if (NumThreads == 1)
+			{
+				References[Frame] = Replay;
+			}
+			const FReplayStats& Reference = References[Frame];
+			NumDiffs += Replay.NumIndices != Reference.NumIndices || Replay.Checksum != Reference.Checksum || Replay.OrderedChecksum != Reference.OrderedChecksum ||
+				Replay.NumUnboundInstances > 0;
+			NumBatches += FrameBatches;
+			NumLists += FrameLists;
+		}
+
+		if (NumThreads == 1)
+		{
+			SingleThreadedTime = RecordTime;
+		}
+		printf("%8u %8.1f %9llu %16.3f %18.3f %9.2fx %12llu %8u\n", GetNumThreads(Jobs), (double)NumLists / NumFrames, (unsigned long long)(NumBatches / NumFrames),
+			1e-6 * RecordTime / NumFrames, 1e-6 * 100000.0 * RecordTime / (double)XMMax(NumBatches, (uint64_t)1), SingleThreadedTime / RecordTime,
+			(unsigned long long)(NumCommands / NumFrames), NumDiffs);
+		if (NumDiffs > 0)
+		{
+			Result = 1;
+		}
+		DestroyJobSystem(Jobs);
+	}
+	return Result;
+}
+
+// AnimateStaticScene() the way it moved instances before the structure of arrays: a matrix per instance, multiplied
+// with the spin around the y axis. Writes the transforms and bounds, the index over them is refit the same way.
+static void AnimateStaticSceneReference(FJobSystem& Jobs, float Time, FStaticScene& InOutScene)
+{
+	FStaticScene& Scene = InOutScene;
+	const auto NumMoving = (uint32_t)Scene.MovingInstances.size();
+	ParallelFor(Jobs, NumMoving, STATIC_ANIMATION_JOB_GRANULARITY, [&Scene, Time](uint32_t Begin, uint32_t End)
+	{
+		const FStaticMotions& Motions = Scene.Motions;
+		for (uint32_t Idx = Begin; Idx < End; ++Idx)
+		{
+			const XMVECTOR Rotation = XMVectorSet(Motions.RotationX[Idx], Motions.RotationY[Idx], Motions.RotationZ[Idx], Motions.RotationW[Idx]);
+			XMMATRIX Transform = XMMatrixMultiply(XMMatrixRotationQuaternion(Rotation), XMMatrixRotationY(XMScalarModAngle(Motions.SpinSpeed[Idx] * Time)));
+			Transform.r[0] = XMVectorScale(Transform.r[0], Motions.Scale[Idx]);
+			Transform.r[1] = XMVectorScale(Transform.r[1], Motions.Scale[Idx]);
+			Transform.r[2] = XMVectorScale(Transform.r[2], Motions.Scale[Idx]);
+			const float Bob = Motions.BobHeight[Idx] * XMScalarSin(XMScalarModAngle(Motions.BobSpeed[Idx] * Time + Motions.BobPhase[Idx]));
+			Transform.r[3] = XMVectorSet(Motions.PositionX[Idx], Motions.PositionY[Idx] + Bob, Motions.PositionZ[Idx], 1.0f);
+
+			const uint32_t InstanceIdx = Scene.MovingInstances[Idx];
+			FStaticMeshInstance& Instance = Scene.Instances[InstanceIdx];
+			XMStoreFloat4x3(&Instance.ObjectToWorld, Transform);
+			SetInstanceBounds(Transform, Scene.Meshes[Instance.MeshIndex].Bounds, InstanceIdx, Scene.InstanceBounds);
+		}
+	});
+	if (NumMoving * 8 > (uint32_t)Scene.Instances.size())
+	{
+		RefitInstanceBVH(Scene.InstanceBounds, Scene.InstanceBVH);
+	}
+	else
+	{
+		UpdateInstanceBVH(Scene.InstanceBounds, Scene.MovingInstances.data(), NumMoving, Scene.InstanceBVH);
+	}
+}
+
+// The instance data of RecordStaticDrawBatches() before it was packed with the scene: transposed and written field by
+// field for every visible instance.
+static void WriteStaticInstanceDataReference(FJobSystem& Jobs, const FStaticScene& Scene, const uint32_t* Instances, uint32_t NumInstances,
+	FStaticInstanceData* OutInstances)
+{
+	ParallelFor(Jobs, NumInstances, STATIC_DRAW_JOB_GRANULARITY, [&](uint32_t Begin, uint32_t End)
+	{
+		for (uint32_t Idx = Begin; Idx < End; ++Idx)
+		{
+			const FStaticMeshInstance& MeshInst = Scene.Instances[Instances[Idx]];
+			const FStaticMesh& Mesh = Scene.Meshes[MeshInst.MeshIndex];
+
+			FStaticInstanceData& Data = OutInstances[Idx];
+			const XMMATRIX ObjectToWorldT = XMMatrixTranspose(XMLoadFloat4x3(&MeshInst.ObjectToWorld));
+			XMStoreFloat4((XMFLOAT4*)&Data.ObjectToWorld, ObjectToWorldT.r[0]);
+			XMStoreFloat4((XMFLOAT4*)&Data.ObjectToWorld + 1, ObjectToWorldT.r[1]);
+			XMStoreFloat4((XMFLOAT4*)&Data.ObjectToWorld + 2, ObjectToWorldT.r[2]);
+			Data.PositionScale = Mesh.PositionScale;
+			Data.Roughness = MeshInst.Roughness;
+			Data.PositionBias = Mesh.PositionBias;
+			Data.Metallic = MeshInst.Metallic;
+			Data.Albedo = MeshInst.Albedo;
+			Data.AO = 1.0f;
+		}
+	});
+}
+
+static int BenchmarkInstanceTransforms(int Argc, char** Argv)
+{
+	int NumFiles = 0;
+	while (NumFiles < Argc && Argv[NumFiles][0] != '-')
+	{
+		++NumFiles;
+	}
+	uint32_t NumInstances = 100000;
+	uint32_t MovingPercent = 100;
+	uint32_t NumFrames = 30;
+	uint32_t MaxThreads = 0;
+	const FOption Options[] =
+	{
+		{ "-instances", &NumInstances, nullptr },
+		{ "-moving", &MovingPercent, nullptr },
+		{ "-frames", &NumFrames, nullptr },
+		{ "-threads", &MaxThreads, nullptr },
+	};
+	if (!ParseOptions(Argc - NumFiles, Argv + NumFiles, Options, (uint32_t)eastl::size(Options)) || NumInstances == 0 || NumFrames == 0)
+	{
+		return -1;
+	}
+	const char* DefaultFileNames[] = { "Data/Meshes/Cube.mesh", "Data/Meshes/Sphere.mesh" };
+	const char* const* FileNames = NumFiles > 0 ? Argv : DefaultFileNames;
+	NumFiles = NumFiles > 0 ? NumFiles : (int)eastl::size(DefaultFileNames);
+	if (MaxThreads == 0)
+	{
+		MaxThreads = (uint32_t)XMMax(EA::Thread::GetProcessorCount(), 1);
+	}
+
+	FStaticScene Scene = {};
+	if (!LoadBenchmarkScene(FileNames, NumFiles, Scene))
+	{
+		return 1;
+	}
+	FStaticSceneDesc Desc;
+	Desc.NumInstances = NumInstances;
+	Desc.FirstMesh = 0;
+	Desc.NumMeshes = (uint32_t)Scene.Meshes.size();
+	Desc.MovingFraction = XMMin(MovingPercent, 100u) / 100.0f;
+	Desc.Seed = 1;
+
+	// The camera of scene-benchmark, the instance data of the visible instances is written in the order of the index.
+	const float FovY = XM_PI / 3;
+	const float FrameTime = 1.0f / 60.0f;
+
+	eastl::vector<uint32_t> Visible(NumInstances);
+	eastl::vector<uint32_t> Locations(NumInstances);
+	for (uint32_t Idx = 0; Idx < NumInstances; ++Idx)
+	{
+		Locations[Idx] = Idx;
+	}
+	eastl::vector<FStaticInstanceData> ReferenceData(NumInstances);
+	eastl::vector<FStaticInstanceData> StreamedData(NumInstances);
+	eastl::vector<XMFLOAT4X3> ReferenceTransforms;
+
+	printf("%u instances of %u meshes, %u%% moving, %u frames\n", NumInstances, Desc.NumMeshes, XMMin(MovingPercent, 100u), NumFrames);
+	printf("%8s %9s %15s %15s %15s %15s %10s %12s %8s\n", "threads", "moving", "matrix [M/s]", "animate [M/s]", "fields [M/s]", "stream [M/s]", "speedup",
+		"max error", "diffs");
+
+	int Result = 0;
+	for (uint32_t NumThreads = 1; NumThreads <= MaxThreads; NumThreads = NumThreads < MaxThreads ? XMMin(2 * NumThreads, MaxThreads) : NumThreads + 1)
+	{
+		FJobSystem Jobs = {};
+		CreateJobSystem(NumThreads > 1 ? NumThreads - 1 : JOB_SYSTEM_NO_WORKERS, Jobs);
+
+		const float HalfSize = GenerateStaticScene(Desc, Scene);
+		BuildStaticSceneBVH(Scene);
+		const auto NumMoving = (uint32_t)Scene.MovingInstances.size();
+		ReferenceTransforms.resize(NumMoving);
+		const float CameraDistance = 1.5f * HalfSize;
+		const XMMATRIX Projection = XMMatrixPerspectiveFovLH(FovY, 1.777f, 0.1f, XMMax(100.0f, 4.0f * CameraDistance));
+
+		double ReferenceAnimateTime = 0.0;
+		double AnimateTime = 0.0;
+		double ReferenceWriteTime = 0.0;
+		double StreamTime = 0.0;
+		uint64_t NumWritten = 0;
+		float MaxError = 0.0f;
+		uint32_t NumDiffs = 0;
+		for (uint32_t Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			// Both animations write the same instances, the reference goes first and keeps its transforms.
+			const float Time = (Frame + 1) * FrameTime;
+			EA::StdC::Stopwatch Stopwatch(EA::StdC::Stopwatch::kUnitsNanoseconds, true);
+			AnimateStaticSceneReference(Jobs, Time, Scene);
+			ReferenceAnimateTime += Stopwatch.GetElapsedTime();
+			for (uint32_t Idx = 0; Idx < NumMoving; ++Idx)
+			{
+				ReferenceTransforms[Idx] = Scene.Instances[Scene.MovingInstances[Idx]].ObjectToWorld;
+			}
+
+			Stopwatch.Restart();
+			AnimateStaticScene(Jobs, Time, Scene);
+			AnimateTime += Stopwatch.GetElapsedTime();
+			for (uint32_t Idx = 0; Idx < NumMoving; ++Idx)
+			{
+				const XMFLOAT4X3& Transform = Scene.Instances[Scene.MovingInstances[Idx]].ObjectToWorld;
+				for (uint32_t Element = 0; Element < 12; ++Element)
+				{
+					MaxError = XMMax(MaxError, fabsf(Transform.f[Element] - ReferenceTransforms[Idx].f[Element]));
+				}
+			}
+
+			const float Angle = XMScalarModAngle(0.25f * Time);
+			const XMVECTOR CameraPosition = XMVectorSet(CameraDistance * cosf(Angle), 0.5f * CameraDistance, CameraDistance * sinf(Angle), 1.0f);
+			XMFLOAT4 FrustumPlanes[6];
+			GetFrustumPlanes(XMMatrixLookAtLH(CameraPosition, XMVectorZero(), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f)) * Projection, FrustumPlanes);
+			const uint32_t Count = QueryInstanceBVH(Scene.InstanceBVH, Scene.InstanceBounds, FrustumPlanes, Visible.data());
+			NumWritten += Count;
+
+			Stopwatch.Restart();
+			WriteStaticInstanceDataReference(Jobs, Scene, Visible.data(), Count, ReferenceData.data());
+			ReferenceWriteTime += Stopwatch.GetElapsedTime();
+
+			Stopwatch.Restart();
+			ParallelFor(Jobs, Count, STATIC_DRAW_JOB_GRANULARITY, [&](uint32_t Begin, uint32_t End)
+			{
+				StreamStaticInstanceData(Scene, Visible.data(), Locations.data(), Begin, End, StreamedData.data());
+			});
+			StreamTime += Stopwatch.GetElapsedTime();
+
+			// The packed data of the moving instances must have followed them.
+			NumDiffs += memcmp(ReferenceData.data(), StreamedData.data(), Count * sizeof(FStaticInstanceData)) != 0;
+		}
+
+		// Millions of instances per second and core.
+		const double Moved = (double)NumMoving * NumFrames * 1e3 / NumThreads;
+		const double Written = (double)NumWritten * 1e3 / NumThreads;
+		NumDiffs += MaxError > 1e-4f * XMMax(1.0f, HalfSize);
+		printf("%8u %9u %15.2f %15.2f %15.2f %15.2f %9.2fx %12.2e %8u\n", GetNumThreads(Jobs), NumMoving, Moved / XMMax(ReferenceAnimateTime, 1.0),
+			Moved / XMMax(AnimateTime, 1.0), Written / XMMax(ReferenceWriteTime, 1.0), Written / XMMax(StreamTime, 1.0),
+			(ReferenceAnimateTime + ReferenceWriteTime) / XMMax(AnimateTime + StreamTime, 1.0), MaxError, NumDiffs);
+		if (NumDiffs > 0)
+		{
+			Result = 1;
+		}
+		DestroyJobSystem(Jobs);
+	}
+	return Result;
+}
+
+// Upload ring backend on heap memory at made-up GPU addresses (64 KB aligned like D3D12 buffers), counts what is alive.
+struct FHeapUploadBackend
+{
+	uint64_t NextGPUAddress;
+	uint32_t NumMemories;
+};
+
+static bool CreateHeapUploadMemory(void* Context, uint64_t Size, FUploadMemory& OutMemory)
+{
+	FHeapUploadBackend& Backend = *(FHeapUploadBackend*)Context;
+	OutMemory.CPUStart = (uint8_t*)malloc((size_t)Size);
+	if (!OutMemory.CPUStart)
+	{
+		return false;
+	}
+	OutMemory.Resource = OutMemory.CPUStart;
+	OutMemory.GPUStart = Backend.NextGPUAddress;
+	Backend.NextGPUAddress += (Size + 0xffff) & ~(uint64_t)0xffff;
+	Backend.NumMemories += 1;
+	return true;
+}
+
+static void DestroyHeapUploadMemory(void* Context, const FUploadMemory& Memory)
+{
+	FHeapUploadBackend& Backend = *(FHeapUploadBackend*)Context;
+	free(Memory.CPUStart);
+	Backend.NumMemories -= 1;
+}
+
+// Allocation of the fuzzed frames, filled with its index until the fake GPU is done with its frame.
+struct FFuzzedUpload
+{
+	uint32_t* Words;
+	uint32_t NumWords;
+	uint32_t Index;
+	uint64_t FenceValue;
+};
+
+static int FuzzUploadRing(int Argc, char** Argv)
+{
+	uint32_t NumFrames = 10000;
+	uint32_t MaxLatency = 3;
+	uint32_t PageSizeKB = 1024;
+	uint32_t Seed = 1;
+	const FOption Options[] =
+	{
+		{ "-frames", &NumFrames, nullptr },
+		{ "-latency", &MaxLatency, nullptr },
+		{ "-page", &PageSizeKB, nullptr },
+		{ "-seed", &Seed, nullptr },
+	};
+	if (!ParseOptions(Argc, Argv, Options, (uint32_t)eastl::size(Options)) || NumFrames == 0 || PageSizeKB == 0 || Seed == 0)
+	{
+		return -1;
+	}
+	const uint64_t PageSize = (uint64_t)PageSizeKB * 1024;
+	printf("%u frames, %u KB pages, GPU up to %u frames behind\n", NumFrames, PageSizeKB, MaxLatency);
+
+	FHeapUploadBackend HeapBackend = { 0x100000000ull, 0 };
+	FUploadBackend Backend;
+	Backend.Context = &HeapBackend;
+	Backend.CreateMemory = &CreateHeapUploadMemory;
+	Backend.DestroyMemory = &DestroyHeapUploadMemory;
+
+	// Frames of mostly small allocations, some up to a quarter of a page, a few dedicated ones of up to 4 pages and every
+	// 64th frame on average a burst of 16 times as many. The fake GPU lags 0 to MaxLatency frames behind, checks the
+	// allocations of every frame it completes and the ring reclaims them.
+	FUploadRing Ring;
+	CreateUploadRing(Backend, PageSize, Ring);
+	eastl::vector<FFuzzedUpload> InFlight;
+	uint32_t State = Seed;
+	uint64_t CompletedFenceValue = 0;
+	uint64_t NumAllocations = 0;
+	uint64_t NumDedicated = 0;
+	uint64_t NumBytes = 0;
+	uint32_t NumOverwritten = 0;
+	uint32_t NumMisplaced = 0;
+	uint32_t NumWrongStats = 0;
+	for (uint32_t Frame = 0; Frame < NumFrames; ++Frame)
+	{
+		const uint64_t FenceValue = Frame + 1;
+		uint32_t NumFrameAllocations = (uint32_t)(64.0f * RandomFloat(State));
+		if (RandomFloat(State) < 1.0f / 64.0f)
+		{
+			NumFrameAllocations *= 16;
+		}
+		uint64_t NumFrameBytes = 0;
+		for (uint32_t AllocationIdx = 0; AllocationIdx < NumFrameAllocations; ++AllocationIdx)
+		{
+			const float Kind = RandomFloat(State);
+			uint64_t Size;
+			if (Kind < 0.9f)
+			{
+				Size = 4 + (uint64_t)(4092.0f * RandomFloat(State));
+			}
+			else if (Kind < 0.99f)
+			{
+				Size = 4 + (uint64_t)((PageSize / 4 - 4) * RandomFloat(State));
+			}
+			else
+			{
+				Size = PageSize / 4 + 4 + (uint64_t)(4 * PageSize * RandomFloat(State));
+			}
+			Size &= ~(uint64_t)3;
+
+			FUploadAllocation Allocation;
+			if (!AllocateUpload(Ring, Size, Allocation))
+			{
+				fprintf(stderr, "Out of memory\n");
+				return 1;
+			}
+			if (Allocation.Offset % UPLOAD_RING_ALIGNMENT != 0 || Allocation.GPUAddress % UPLOAD_RING_ALIGNMENT != 0
+				|| Allocation.CPUAddress != (uint8_t*)Allocation.Resource + Allocation.Offset)
+			{
+				++NumMisplaced;
+			}
+			NumDedicated += Size > PageSize / 4;
+			NumFrameBytes += (Size + UPLOAD_RING_ALIGNMENT - 1) & ~(uint64_t)(UPLOAD_RING_ALIGNMENT - 1);
+
+			FFuzzedUpload Upload = { (uint32_t*)Allocation.CPUAddress, (uint32_t)(Size / 4), (uint32_t)NumAllocations++, FenceValue };
+			for (uint32_t WordIdx = 0; WordIdx < Upload.NumWords; ++WordIdx)
+			{
+				Upload.Words[WordIdx] = Upload.Index;
+			}
+			InFlight.push_back(Upload);
+		}
+		CloseUploadFrame(Ring, FenceValue);
+		NumBytes += NumFrameBytes;
+		NumWrongStats += Ring.LastFrame.NumBytes != NumFrameBytes || Ring.LastFrame.NumAllocations != NumFrameAllocations;
+
+		// The GPU is somewhere between MaxLatency frames behind and done with this one, it never goes back.
+		const uint32_t Latency = (uint32_t)((MaxLatency + 1) * RandomFloat(State));
+		const uint64_t GPUFenceValue = FenceValue > Latency ? FenceValue - Latency : 0;
+		CompletedFenceValue = XMMax(CompletedFenceValue, XMMin(GPUFenceValue, FenceValue));
+		if (Frame + 1 == NumFrames)
+		{
+			CompletedFenceValue = FenceValue;
+		}
+		uint32_t NumStillInFlight = 0;
+		for (const FFuzzedUpload& Upload : InFlight)
+		{
+			if (Upload.FenceValue > CompletedFenceValue)
+			{
+				InFlight[NumStillInFlight++] = Upload;
+				continue;
+			}
+			for (uint32_t WordIdx = 0; WordIdx < Upload.NumWords; ++WordIdx)
+			{
+				if (Upload.Words[WordIdx] != Upload.Index)
+				{
+					++NumOverwritten;
+					break;
+				}
+			}
+		}
+		InFlight.resize(NumStillInFlight);
+		ReclaimUploadMemory(Ring, CompletedFenceValue);
+	}
+
+	// Everything was reclaimed, the pages are empty and all memory goes back to the backend.
+	uint32_t NumLeaked = Ring.NumBytesInUse != 0 || !Ring.Dedicated.empty();
+	for (const FUploadPage& Page : Ring.Pages)
+	{
+		NumLeaked += Page.Head != Page.Tail || !Page.Regions.empty();
+	}
+	const FUploadStats MaxFrame = Ring.MaxFrame;
+	const uint32_t NumPages = (uint32_t)Ring.Pages.size();
+	DestroyUploadRing(Ring);
+	NumLeaked += HeapBackend.NumMemories != 0;
+
+	const double MB = 1.0 / (1024.0 * 1024.0);
+	printf("%llu allocations (%llu dedicated), %.2f MB per frame, %.2f MB in the largest frame\n", (unsigned long long)NumAllocations,
+		(unsigned long long)NumDedicated, MB * NumBytes / NumFrames, MB * MaxFrame.NumBytes);
+	printf("high water %.2f MB, capacity %.2f MB at most, %u pages\n", MB * MaxFrame.HighWater, MB * MaxFrame.Capacity, NumPages);
+	printf("%u overwritten, %u misplaced, %u wrong frame stats, %u leaked\n", NumOverwritten, NumMisplaced, NumWrongStats, NumLeaked);
+	int Result = NumOverwritten + NumMisplaced + NumWrongStats + NumLeaked > 0 ? 1 : 0;
+
+	// Steady state throughput of the constants of a frame of the demo: allocations of one FPerDrawConstantData, two frames
+	// in flight.
+	{
+		const uint32_t NumBenchmarkFrames = 100;
+		const uint32_t NumFrameAllocations = 10000;
+		HeapBackend.NextGPUAddress = 0x100000000ull;
+		CreateUploadRing(Backend, PageSize, Ring);
+		EA::StdC::Stopwatch Stopwatch(EA::StdC::Stopwatch::kUnitsNanoseconds, true);
+		uint64_t Checksum = 0;
+		for (uint32_t Frame = 0; Frame < NumBenchmarkFrames; ++Frame)
+		{
+			for (uint32_t AllocationIdx = 0; AllocationIdx < NumFrameAllocations; ++AllocationIdx)
+			{
+				FUploadAllocation Allocation;
+				AllocateUpload(Ring, sizeof(FPerDrawConstantData), Allocation);
+				Checksum += Allocation.GPUAddress;
+			}
+			CloseUploadFrame(Ring, Frame + 1);
+			ReclaimUploadMemory(Ring, Frame);
+		}
+		const double NanosecondsPerAllocation = (double)Stopwatch.GetElapsedTime() / ((double)NumBenchmarkFrames * NumFrameAllocations);
+		printf("%.1f ns per allocation of %u bytes, %u pages (checksum %llx)\n", NanosecondsPerAllocation, (uint32_t)sizeof(FPerDrawConstantData),
+			(uint32_t)Ring.Pages.size(), (unsigned long long)Checksum);
+		DestroyUploadRing(Ring);
+	}
+	return Result;
+}
+
+// Slot of the churned descriptors, as the fake GPU sees it.
+enum EChurnedSlotState
+{
+	CHURNED_SLOT_Free,
+	CHURNED_SLOT_Live,
+	CHURNED_SLOT_Retired, // Released, the GPU may read it until FenceValue.
+};
+
+struct FChurnedSlot
+{
+	uint32_t State;
+	uint64_t FenceValue;
+};
+
+// Released handle that must stay invalid, checked until the frame after MaxFrame.
+struct FStaleDescriptorHandle
+{
+	FDescriptorHandle Handle;
+	uint32_t MaxFrame;
+};
+
+static int ChurnDescriptorSlots(int Argc, char** Argv)
+{
+	uint32_t NumFrames = 10000;
+	uint32_t MaxLatency = 3;
+	uint32_t Capacity = 4096;
+	uint32_t Seed = 1;
+	const FOption Options[] =
+	{
+		{ "-frames", &NumFrames, nullptr },
+		{ "-latency", &MaxLatency, nullptr },
+		{ "-capacity", &Capacity, nullptr },
+		{ "-seed", &Seed, nullptr },
+	};
+	if (!ParseOptions(Argc, Argv, Options, (uint32_t)eastl::size(Options)) || NumFrames == 0 || Capacity == 0
+		|| Capacity > DESCRIPTOR_MAX_SLOTS || Seed == 0)
+	{
+		return -1;
+	}
+	printf("%u frames, %u slots, GPU up to %u frames behind\n", NumFrames, Capacity, MaxLatency);
+
+	// Every frame releases a random part of the live handles and allocates up to as many as the frame wants live, a
+	// random level that is all of the slots every 64th frame on average. The fake GPU lags 0 to MaxLatency frames behind
+	// and the slots are reclaimed the way PresentFrame() does it.
+	FDescriptorSlots Slots;
+	CreateDescriptorSlots(Capacity, Slots);
+	eastl::vector<FChurnedSlot> SlotStates(Capacity, FChurnedSlot{ CHURNED_SLOT_Free, 0 });
+	eastl::vector<FDescriptorHandle> Live;
+	eastl::vector<FStaleDescriptorHandle> Stale;
+	uint32_t State = Seed;
+	uint64_t CompletedFenceValue = 0;
+	uint64_t NumAllocations = 0;
+	uint64_t NumReleases = 0;
+	uint32_t NumFull = 0;
+	uint32_t NumReusedEarly = 0;
+	uint32_t NumStaleAccepted = 0;
+	uint32_t NumWrongFull = 0;
+	for (uint32_t Frame = 0; Frame < NumFrames; ++Frame)
+	{
+		const uint64_t FenceValue = Frame + 1;
+
+		const uint32_t NumReleased = (uint32_t)(Live.size() * 0.5f * RandomFloat(State));
+		for (uint32_t Idx = 0; Idx < NumReleased; ++Idx)
+		{
+			const uint32_t LiveIdx = (uint32_t)(Live.size() * RandomFloat(State)) % (uint32_t)Live.size();
+			const FDescriptorHandle Handle = Live[LiveIdx];
+			Live.erase_unsorted(Live.begin() + LiveIdx);
+
+			ReleaseDescriptorSlot(Slots, Handle, FenceValue);
+			SlotStates[GetDescriptorSlot(Handle)] = FChurnedSlot{ CHURNED_SLOT_Retired, FenceValue };
+			Stale.push_back(FStaleDescriptorHandle{ Handle, Frame + 64 });
+			++NumReleases;
+		}
+
+		const uint32_t NumWanted = RandomFloat(State) < 1.0f / 64.0f ? Capacity : (uint32_t)(Capacity * 0.75f * RandomFloat(State));
+		while ((uint32_t)Live.size() < NumWanted)
+		{
+			FDescriptorHandle Handle;
+			if (!AllocateDescriptorSlot(Slots, Handle))
+			{
+				// Only when every slot is live or waits for the GPU.
+				uint32_t NumFree = 0;
+				for (const FChurnedSlot& Slot : SlotStates)
+				{
+					NumFree += Slot.State == CHURNED_SLOT_Free;
+				}
+				NumWrongFull += NumFree > 0;
+				++NumFull;
+				break;
+			}
+			FChurnedSlot& Slot = SlotStates[GetDescriptorSlot(Handle)];
+			NumReusedEarly += Slot.State != CHURNED_SLOT_Free || Handle == DESCRIPTOR_HANDLE_INVALID;
+			Slot.State = CHURNED_SLOT_Live;
+			Live.push_back(Handle);
+			++NumAllocations;
+		}
+
+		// Released handles are rejected, whatever happened to their slot since.
+		uint32_t NumStillStale = 0;
+		for (const FStaleDescriptorHandle& Handle : Stale)
+		{
+			if (IsDescriptorHandleValid(Slots, Handle.Handle) || ReleaseDescriptorSlot(Slots, Handle.Handle, FenceValue))
+			{
+				++NumStaleAccepted;
+			}
+			if (Handle.MaxFrame > Frame)
+			{
+				Stale[NumStillStale++] = Handle;
+			}
+		}
+		Stale.resize(NumStillStale);
+		for (FDescriptorHandle Handle : Live)
+		{
+			NumStaleAccepted += !IsDescriptorHandleValid(Slots, Handle);
+		}
+
+		// The GPU is somewhere between MaxLatency frames behind and done with this one, it never goes back.
+		const uint32_t Latency = (uint32_t)((MaxLatency + 1) * RandomFloat(State));
+		const uint64_t GPUFenceValue = FenceValue > Latency ? FenceValue - Latency : 0;
+		CompletedFenceValue = XMMax(CompletedFenceValue, XMMin(GPUFenceValue, FenceValue));
+		for (FChurnedSlot& Slot : SlotStates)
+		{
+			if (Slot.State == CHURNED_SLOT_Retired && Slot.FenceValue <= CompletedFenceValue)
+			{
+				Slot.State = CHURNED_SLOT_Free;
+			}
+		}
+		ReclaimDescriptorSlots(Slots, CompletedFenceValue);
+	}
+
+	// Everything released and completed, all slots are free again.
+	for (FDescriptorHandle Handle : Live)
+	{
+		ReleaseDescriptorSlot(Slots, Handle, NumFrames + 1);
+	}
+	ReclaimDescriptorSlots(Slots, NumFrames + 1);
+	const uint32_t NumLeaked = Slots.NumAllocated + (uint32_t)Slots.Retired.size() + Slots.NumUsedSlots - (uint32_t)Slots.FreeSlots.size();
+
+	printf("%llu allocations, %llu releases, slots ran out in %u frames\n", (unsigned long long)NumAllocations,
+		(unsigned long long)NumReleases, NumFull);
+	printf("%u reused early, %u stale handles accepted, %u wrong out of slots, %u leaked\n", NumReusedEarly, NumStaleAccepted,
+		NumWrongFull, NumLeaked);
+	int Result = NumReusedEarly + NumStaleAccepted + NumWrongFull + NumLeaked > 0 ? 1 : 0;
+
+	// Steady churn of streamed textures: half the slots live, every frame releases and allocates 1% of them, two frames
+	// in flight.
+	{
+		const uint32_t NumBenchmarkFrames = 1000;
+		const uint32_t NumFrameReleases = XMMax(Capacity / 200, 1u);
+		CreateDescriptorSlots(Capacity, Slots);
+		Live.clear();
+		for (uint32_t Idx = 0; Idx < Capacity / 2; ++Idx)
+		{
+			FDescriptorHandle Handle;
+			AllocateDescriptorSlot(Slots, Handle);
+			Live.push_back(Handle);
+		}
+		EA::StdC::Stopwatch Stopwatch(EA::StdC::Stopwatch::kUnitsNanoseconds, true);
+		uint64_t Checksum = 0;
+		uint32_t NextLive = 0;
+		for (uint32_t Frame = 0; Frame < NumBenchmarkFrames; ++Frame)
+		{
+			for (uint32_t Idx = 0; Idx < NumFrameReleases; ++Idx)
+			{
+				FDescriptorHandle& Handle = Live[NextLive];
+				NextLive = (NextLive + 7) % (uint32_t)Live.size();
+				ReleaseDescriptorSlot(Slots, Handle, Frame + 1);
+				AllocateDescriptorSlot(Slots, Handle);
+				Checksum += Handle;
+			}
+			ReclaimDescriptorSlots(Slots, Frame);
+		}
+		const double NanosecondsPerChurn = (double)Stopwatch.GetElapsedTime() / ((double)NumBenchmarkFrames * NumFrameReleases);
+		printf("%.1f ns per release and allocation, %u slots used (checksum %llx)\n", NanosecondsPerChurn, Slots.NumUsedSlots,
+			(unsigned long long)Checksum);
+	}
+	return Result;
+}
+
+static void PrintUsage()
+{
+	printf("Usage:\n");
+	printf("  MeshTool ply-convert <input.ply> <output.ply> [-threads N] [-format ascii|binary|binary-be]\n");
+	printf("  MeshTool ply-benchmark <input.ply>... [-threads N] [-runs N]\n");
+	printf("  MeshTool gltf-info <input.gltf|glb>... [-runs N]\n");
+	printf("  MeshTool mesh-cook <input.gltf|glb|ply> <output.mesh>\n");
+	printf("  MeshTool mesh-benchmark <input.gltf|glb>... [-runs N]\n");
+	printf("  MeshTool mesh-optimize <input.gltf|glb|ply>... [-cache N] [-threads N]\n");
+	printf("  MeshTool mesh-simplify <input.gltf|glb|ply>... [-runs N] [-threads N]\n");
+	printf("  MeshTool mesh-cull <input.gltf|glb|ply>... [-views N] [-runs N] [-threads N]\n");
+	printf("  MeshTool mesh-stream <input.mesh|gltf|glb|ply>... [-runs N] [-threads N]\n");
+	printf("  MeshTool instance-bvh [-instances N] [-views N] [-rays N] [-runs N]\n");
+	printf("  MeshTool scene-benchmark [input.mesh|gltf|glb|ply]... [-instances N] [-moving P] [-frames N] [-threads N] [-clusters 0|1]\n");
+	printf("  MeshTool draw-submission [input.mesh|gltf|glb|ply]... [-instances N] [-frames N] [-threads N]\n");
+	printf("  MeshTool command-lists [input.mesh|gltf|glb|ply]... [-instances N] [-frames N] [-threads N] [-clusters 0|1]\n");
+	printf("  MeshTool instance-transforms [input.mesh|gltf|glb|ply]... [-instances N] [-moving P] [-frames N] [-threads N]\n");
+	printf("  MeshTool upload-ring [-frames N] [-latency N] [-page KB] [-seed N]\n");
+	printf("  MeshTool descriptor-churn [-frames N] [-latency N] [-capacity N] [-seed N]\n");
+}
+
+int main(int Argc, char** Argv)
+{
+	if (Argc >= 4 && EA::StdC::Strcmp(Argv[1], "ply-convert") == 0)
+	{
+		const int Result = ConvertPLYFile(Argv[2], Argv[3], Argc - 4, Argv + 4);
+		if (Result >= 0)
+		{
+			return Result;
+		}
+	}
+	if (Argc >= 3 && EA::StdC::Strcmp(Argv[1], "ply-benchmark") == 0)
+	{
+		const int Result = BenchmarkPLYLoader(Argc - 2, Argv + 2);
+		if (Result >= 0)
+		{
+			return Result;
+		}
+	}
+	if (Argc >= 3 && EA::StdC::Strcmp(Argv[1], "gltf-info") == 0)
+	{
+		const int Result = PrintGLTFSceneInfo(Argc - 2, Argv + 2);
+		if (Result >= 0)
+		{
+			return Result;
+		}
+	}
+	if (Argc == 4 && EA::StdC::Strcmp(Argv[1], "mesh-cook") == 0)
+	{
+		return CookMeshFile(Argv[2], Argv[3]);
+	}
+	if (Argc >= 3 && EA::StdC::Strcmp(Argv[1], "mesh-benchmark") == 0)
+	{
+		const int Result = BenchmarkCookedMesh(Argc - 2, Argv + 2);
+		if (Result >= 0)
+		{
+			return Result;
+		}
+	}
+	if (Argc >= 3 && EA::StdC::Strcmp(Argv[1], "mesh-optimize") == 0)
+	{
+		const int Result = BenchmarkMeshOptimizer(Argc - 2, Argv + 2);
+		if (Result >= 0)
+		{
+			return Result;
+		}
+	}
+	if (Argc >= 3 && EA::StdC::Strcmp(Argv[1], "mesh-simplify") == 0)
+	{
+		const int Result = BenchmarkMeshSimplifier(Argc - 2, Argv + 2);
+		if (Result >= 0)
+		{
+			return Result;
+		}
+	}
+	if (Argc >= 3 && EA::StdC::Strcmp(Argv[1], "mesh-cull") == 0)
+	{
+		const int Result = BenchmarkClusterCulling(Argc - 2, Argv + 2);
+		if (Result >= 0)
+		{
+			return Result;
+		}
+	}
+	if (Argc >= 3 && EA::StdC::Strcmp(Argv[1], "mesh-stream") == 0)
+	{
+		const int Result = BenchmarkMeshStreaming(Argc - 2, Argv + 2);
+		if (Result >= 0)
+		{
+			return Result;
+		}
+	}
+	if (Argc >= 2 && EA::StdC::Strcmp(Argv[1], "instance-bvh") == 0)
+	{
+		const int Result = BenchmarkInstanceBVH(Argc - 2, Argv + 2);
+		if (Result >= 0)
+		{
+			return Result;
+		}
+	}
+	if (Argc >= 2 && EA::StdC::Strcmp(Argv[1], "scene-benchmark") == 0)
+	{
+		const int Result = BenchmarkStaticScene(Argc - 2, Argv + 2);
+		if (Result >= 0)
+		{
+			return Result;
+		}
+	}
+	if (Argc >= 2 && EA::StdC::Strcmp(Argv[1], "draw-submission") == 0)
+	{
+		const int Result = BenchmarkDrawSubmission(Argc - 2, Argv + 2);
+		if (Result >= 0)
+		{
+			return Result;
+		}
+	}
+	if (Argc >= 2 && EA::StdC::Strcmp(Argv[1], "command-lists") == 0)
+	{
+		const int Result = BenchmarkCommandLists(Argc - 2, Argv + 2);
+		if (Result >= 0)
+		{
+			return Result;
+		}
+	}
+	if (Argc >= 2 && EA::StdC::Strcmp(Argv[1], "instance-transforms") == 0)
+	{
+		const int Result = BenchmarkInstanceTransforms(Argc - 2, Argv + 2);
+		if (Result >= 0)
+		{
+			return Result;
+		}
+	}
+	if (Argc >= 2 && EA::StdC::Strcmp(Argv[1], "upload-ring") == 0)
+	{
+		const int Result = FuzzUploadRing(Argc - 2, Argv + 2);
+		if (Result >= 0)
+		{
+			return Result;
+		}
+	}
+	if (Argc >= 2 && EA::StdC::Strcmp(Argv[1], "descriptor-churn") == 0)
+	{
+		const int Result = ChurnDescriptorSlots(Argc - 2, Argv + 2);
+		if (Result >= 0)
+		{
+			return Result;
+		}
+	}
+	PrintUsage();
+	return 1;
+}
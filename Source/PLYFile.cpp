@@ -0,0 +1,1148 @@
+#include "PLYFile.h"
+#include "JobSystem.h"
+#include "MappedFile.h"
+#include "EAAssert/eaassert.h"
+#include "EAStdC/EAString.h"
+#include "EAThread/eathread_atomic.h"
+#include <stdio.h>
+#include <string.h>
+
+#define PLY_VERTICES_PER_JOB 16384
+#define PLY_FACES_PER_JOB 16384
+#define PLY_ASCII_CHUNK_SIZE (1024 * 1024)
+
+enum
+{
+	PLY_TYPE_Int8, PLY_TYPE_UInt8, PLY_TYPE_Int16, PLY_TYPE_UInt16, PLY_TYPE_Int32, PLY_TYPE_UInt32, PLY_TYPE_Float32, PLY_TYPE_Float64,
+	PLY_TYPE_Count,
+};
+
+// Both the original and the sized names.
+static const char* const GTypeNames[PLY_TYPE_Count][2] =
+{
+	{ "char", "int8" }, { "uchar", "uint8" }, { "short", "int16" }, { "ushort", "uint16" },
+	{ "int", "int32" }, { "uint", "uint32" }, { "float", "float32" }, { "double", "float64" },
+};
+static const uint32_t GTypeSizes[PLY_TYPE_Count] = { 1, 1, 2, 2, 4, 4, 4, 8 };
+
+// What a property is read into.
+enum
+{
+	PLY_TARGET_X, PLY_TARGET_Y, PLY_TARGET_Z, PLY_TARGET_NX, PLY_TARGET_NY, PLY_TARGET_NZ, PLY_TARGET_U, PLY_TARGET_V,
+	PLY_TARGET_VertexIndices,
+	PLY_TARGET_None,
+};
+
+static const struct
+{
+	const char* Name;
+	uint32_t Target;
+} GVertexPropertyNames[] =
+{
+	{ "x", PLY_TARGET_X }, { "y", PLY_TARGET_Y }, { "z", PLY_TARGET_Z },
+	{ "nx", PLY_TARGET_NX }, { "ny", PLY_TARGET_NY }, { "nz", PLY_TARGET_NZ },
+	{ "s", PLY_TARGET_U }, { "t", PLY_TARGET_V }, { "u", PLY_TARGET_U }, { "v", PLY_TARGET_V },
+	{ "texture_u", PLY_TARGET_U }, { "texture_v", PLY_TARGET_V }, { "texture_s", PLY_TARGET_U }, { "texture_t", PLY_TARGET_V },
+};
+
+struct FPLYProperty
+{
+	uint32_t Type; // Of list items for lists.
+	uint32_t CountType; // Lists only.
+	uint32_t Target;
+	uint32_t Offset; // In fixed-size binary records.
+	bool bIsList;
+};
+
+struct FPLYElement
+{
+	eastl::vector<FPLYProperty> Properties;
+	uint64_t Count;
+	uint32_t Stride; // Binary record size, 0 when lists make it variable.
+};
+
+struct FPLYHeader
+{
+	eastl::vector<FPLYElement> Elements;
+	uint64_t DataOffset;
+	uint32_t Format;
+	uint32_t VertexElement; // UINT32_MAX when missing.
+	uint32_t FaceElement;
+	uint32_t VertexProperties[PLY_TARGET_VertexIndices]; // Indexed by PLY_TARGET_, UINT32_MAX when missing.
+	uint32_t IndexProperty; // Of the face element.
+	bool bHasNormals;
+	bool bHasTexcoords;
+};
+
+// Where DecodePLY() writes, already resized.
+struct FPLYOutput
+{
+	XMFLOAT3* Positions;
+	XMFLOAT3* Normals; // nullptr when the file has none.
+	XMFLOAT2* Texcoords;
+	uint32_t NumVertices;
+};
+
+static inline bool IsSpace(char C)
+{
+	return C == ' ' || C == '\t' || C == '\r';
+}
+
+static inline bool IsDigit(char C)
+{
+	return (uint32_t)(C - '0') < 10;
+}
+
+static inline const char* SkipSpaces(const char* Cursor, const char* End)
+{
+	while (Cursor < End && IsSpace(*Cursor))
+	{
+		++Cursor;
+	}
+	return Cursor;
+}
+
+static bool ReadLine(const uint8_t* Data, uint64_t Size, uint64_t& InOutOffset, char* OutLine, uint32_t MaxLength)
+{
+	uint32_t Length = 0;
+	while (InOutOffset < Size && Data[InOutOffset] != '\n')
+	{
+		if (Length + 1 < MaxLength)
+		{
+			OutLine[Length++] = (char)Data[InOutOffset];
+		}
+		++InOutOffset;
+	}
+	while (Length > 0 && IsSpace(OutLine[Length - 1]))
+	{
+		--Length;
+	}
+	OutLine[Length] = 0;
+	if (InOutOffset == Size)
+	{
+		return false;
+	}
+	++InOutOffset;
+	return true;
+}
+
+static bool NextToken(const char*& InOutLine, char* OutToken, uint32_t MaxLength)
+{
+	const char* Line = InOutLine;
+	while (*Line == ' ' || *Line == '\t')
+	{
+		++Line;
+	}
+	uint32_t Length = 0;
+	while (*Line != 0 && *Line != ' ' && *Line != '\t')
+	{
+		if (Length + 1 < MaxLength)
+		{
+			OutToken[Length++] = *Line;
+		}
+		++Line;
+	}
+	OutToken[Length] = 0;
+	InOutLine = Line;
+	return Length > 0;
+}
+
+static bool ParseType(const char* Name, uint32_t& OutType)
+{
+	for (uint32_t Type = 0; Type < PLY_TYPE_Count; ++Type)
+	{
+		if (EA::StdC::Strcmp(Name, GTypeNames[Type][0]) == 0 || EA::StdC::Strcmp(Name, GTypeNames[Type][1]) == 0)
+		{
+			OutType = Type;
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool IsIntegerType(uint32_t Type)
+{
+	return Type < PLY_TYPE_Float32;
+}
+
+static inline bool HasRecords(uint64_t Offset, uint64_t Size, uint64_t Count, uint32_t Stride)
+{
+	return Offset <= Size && Count <= (Size - Offset) / Stride;
+}
+
+static bool ParsePLYHeader(const uint8_t* Data, uint64_t Size, FPLYHeader& OutHeader)
+{
+	uint64_t Offset = 0;
+	char Line[1024];
+	char Token[64];
+
+	if (!ReadLine(Data, Size, Offset, Line, sizeof(Line)) || EA::StdC::Strcmp(Line, "ply") != 0)
+	{
+		return false;
+	}
+
+	OutHeader.Format = UINT32_MAX;
+	for (;;)
+	{
+		if (!ReadLine(Data, Size, Offset, Line, sizeof(Line)))
+		{
+			return false;
+		}
+		const char* Cursor = Line;
+		if (!NextToken(Cursor, Token, sizeof(Token)) || EA::StdC::Strcmp(Token, "comment") == 0 || EA::StdC::Strcmp(Token, "obj_info") == 0)
+		{
+			continue;
+		}
+		if (EA::StdC::Strcmp(Token, "format") == 0)
+		{
+			NextToken(Cursor, Token, sizeof(Token));
+			if (EA::StdC::Strcmp(Token, "ascii") == 0)
+			{
+				OutHeader.Format = PLY_FORMAT_Ascii;
+			}
+			else if (EA::StdC::Strcmp(Token, "binary_little_endian") == 0)
+			{
+				OutHeader.Format = PLY_FORMAT_BinaryLittleEndian;
+			}
+			else if (EA::StdC::Strcmp(Token, "binary_big_endian") == 0)
+			{
+				OutHeader.Format = PLY_FORMAT_BinaryBigEndian;
+			}
+			else
+			{
+				return false;
+			}
+		}
+		else if (EA::StdC::Strcmp(Token, "element") == 0)
+		{
+			char Name[64];
+			if (!NextToken(Cursor, Name, sizeof(Name)) || !NextToken(Cursor, Token, sizeof(Token)) || !IsDigit(Token[0]))
+			{
+				return false;
+			}
+			FPLYElement Element;
+			Element.Count = EA::StdC::AtoU64(Token);
+			Element.Stride = 0;
+			if (EA::StdC::Strcmp(Name, "vertex") == 0)
+			{
+				OutHeader.VertexElement = (uint32_t)OutHeader.Elements.size();
+			}
+			else if (EA::StdC::Strcmp(Name, "face") == 0)
+			{
+				OutHeader.FaceElement = (uint32_t)OutHeader.Elements.size();
+			}
+			OutHeader.Elements.push_back(Element);
+		}
+		else if (EA::StdC::Strcmp(Token, "property") == 0)
+		{
+			if (OutHeader.Elements.empty() || !NextToken(Cursor, Token, sizeof(Token)))
+			{
+				return false;
+			}
+			FPLYProperty Property = {};
+			Property.bIsList = EA::StdC::Strcmp(Token, "list") == 0;
+			if (Property.bIsList)
+			{
+				if (!NextToken(Cursor, Token, sizeof(Token)) || !ParseType(Token, Property.CountType) || !IsIntegerType(Property.CountType) ||
+					!NextToken(Cursor, Token, sizeof(Token)))
+				{
+					return false;
+				}
+			}
+			char Name[64];
+			if (!ParseType(Token, Property.Type) || !NextToken(Cursor, Name, sizeof(Name)))
+			{
+				return false;
+			}
+
+			const uint32_t ElementIdx = (uint32_t)OutHeader.Elements.size() - 1;
+			const uint32_t PropertyIdx = (uint32_t)OutHeader.Elements.back().Properties.size();
+			Property.Target = PLY_TARGET_None;
+			if (ElementIdx == OutHeader.VertexElement && !Property.bIsList)
+			{
+				for (uint32_t Idx = 0; Idx < eastl::size(GVertexPropertyNames); ++Idx)
+				{
+					const uint32_t Target = GVertexPropertyNames[Idx].Target;
+					if (EA::StdC::Strcmp(Name, GVertexPropertyNames[Idx].Name) == 0 && OutHeader.VertexProperties[Target] == UINT32_MAX)
+					{
+						Property.Target = Target;
+						OutHeader.VertexProperties[Target] = PropertyIdx;
+						break;
+					}
+				}
+			}
+			else if (ElementIdx == OutHeader.FaceElement && Property.bIsList && OutHeader.IndexProperty == UINT32_MAX &&
+				(EA::StdC::Strcmp(Name, "vertex_indices") == 0 || EA::StdC::Strcmp(Name, "vertex_index") == 0))
+			{
+				if (!IsIntegerType(Property.Type))
+				{
+					return false;
+				}
+				Property.Target = PLY_TARGET_VertexIndices;
+				OutHeader.IndexProperty = PropertyIdx;
+			}
+			OutHeader.Elements.back().Properties.push_back(Property);
+		}
+		else if (EA::StdC::Strcmp(Token, "end_header") == 0)
+		{
+			break;
+		}
+		else
+		{
+			return false;
+		}
+	}
+	OutHeader.DataOffset = Offset;
+
+	for (FPLYElement& Element : OutHeader.Elements)
+	{
+		uint32_t Stride = 0;
+		for (FPLYProperty& Property : Element.Properties)
+		{
+			Property.Offset = Stride;
+			Stride += GTypeSizes[Property.Type];
+			if (Property.bIsList)
+			{
+				Stride = 0;
+				break;
+			}
+		}
+		Element.Stride = Stride;
+	}
+
+	// Reject counts the data cannot hold before anything gets allocated for them. An ASCII record is at least one byte
+	// (a line), a binary one at least its fixed-size properties plus the counts of its lists.
+	uint64_t MinOffset = OutHeader.DataOffset;
+	for (const FPLYElement& Element : OutHeader.Elements)
+	{
+		uint32_t MinRecordSize = 1;
+		if (OutHeader.Format != PLY_FORMAT_Ascii)
+		{
+			MinRecordSize = 0;
+			for (const FPLYProperty& Property : Element.Properties)
+			{
+				MinRecordSize += GTypeSizes[Property.bIsList ? Property.CountType : Property.Type];
+			}
+		}
+		if (MinRecordSize > 0)
+		{
+			if (!HasRecords(MinOffset, Size, Element.Count, MinRecordSize))
+			{
+				return false;
+			}
+			MinOffset += Element.Count * MinRecordSize;
+		}
+	}
+
+	const uint32_t* VertexProperties = OutHeader.VertexProperties;
+	OutHeader.bHasNormals = VertexProperties[PLY_TARGET_NX] != UINT32_MAX && VertexProperties[PLY_TARGET_NY] != UINT32_MAX && VertexProperties[PLY_TARGET_NZ] != UINT32_MAX;
+	OutHeader.bHasTexcoords = VertexProperties[PLY_TARGET_U] != UINT32_MAX && VertexProperties[PLY_TARGET_V] != UINT32_MAX;
+
+	return OutHeader.Format != UINT32_MAX && OutHeader.VertexElement != UINT32_MAX && OutHeader.Elements[OutHeader.VertexElement].Count <= UINT32_MAX &&
+		VertexProperties[PLY_TARGET_X] != UINT32_MAX && VertexProperties[PLY_TARGET_Y] != UINT32_MAX && VertexProperties[PLY_TARGET_Z] != UINT32_MAX &&
+		(OutHeader.FaceElement == UINT32_MAX || OutHeader.Elements[OutHeader.FaceElement].Count <= UINT32_MAX);
+}
+
+// Binary files. Hosts are little endian, big endian files are byte swapped on load.
+
+template<bool bSwap>
+static inline uint16_t Load16(const uint8_t* Data)
+{
+	uint16_t Value;
+	memcpy(&Value, Data, 2);
+	return bSwap ? (uint16_t)(Value >> 8 | Value << 8) : Value;
+}
+
+static inline uint32_t ByteSwap32(uint32_t Value)
+{
+	return Value >> 24 | (Value >> 8 & 0xFF00) | (Value << 8 & 0xFF0000) | Value << 24;
+}
+
+template<bool bSwap>
+static inline uint32_t Load32(const uint8_t* Data)
+{
+	uint32_t Value;
+	memcpy(&Value, Data, 4);
+	return bSwap ? ByteSwap32(Value) : Value;
+}
+
+template<bool bSwap>
+static inline uint64_t Load64(const uint8_t* Data)
+{
+	return bSwap ? (uint64_t)Load32<true>(Data) << 32 | Load32<true>(Data + 4) : (uint64_t)Load32<false>(Data + 4) << 32 | Load32<false>(Data);
+}
+
+template<bool bSwap>
+static inline float ReadBinaryFloat(const uint8_t* Data, uint32_t Type)
+{
+	switch (Type)
+	{
+	case PLY_TYPE_Int8: return (float)(int8_t)Data[0];
+	case PLY_TYPE_UInt8: return (float)Data[0];
+	case PLY_TYPE_Int16: return (float)(int16_t)Load16<bSwap>(Data);
+	case PLY_TYPE_UInt16: return (float)Load16<bSwap>(Data);
+	case PLY_TYPE_Int32: return (float)(int32_t)Load32<bSwap>(Data);
+	case PLY_TYPE_UInt32: return (float)Load32<bSwap>(Data);
+	case PLY_TYPE_Float32:
+	{
+		const uint32_t Bits = Load32<bSwap>(Data);
+		float Value;
+		memcpy(&Value, &Bits, 4);
+		return Value;
+	}
+	default:
+	{
+		const uint64_t Bits = Load64<bSwap>(Data);
+		double Value;
+		memcpy(&Value, &Bits, 8);
+		return (float)Value;
+	}
+	}
+}
+
+// Integer types only. Negative values wrap around and fail the range checks.
+template<bool bSwap>
+static inline uint32_t ReadBinaryUInt(const uint8_t* Data, uint32_t Type)
+{
+	switch (Type)
+	{
+	case PLY_TYPE_Int8: return (uint32_t)(int32_t)(int8_t)Data[0];
+	case PLY_TYPE_UInt8: return Data[0];
+	case PLY_TYPE_Int16: return (uint32_t)(int32_t)(int16_t)Load16<bSwap>(Data);
+	case PLY_TYPE_UInt16: return Load16<bSwap>(Data);
+	default: return Load32<bSwap>(Data);
+	}
+}
+
+template<bool bSwap>
+static void DecodeBinaryVertices(const FPLYHeader& Header, const uint8_t* Records, uint32_t Begin, uint32_t End, const FPLYOutput& Output)
+{
+	const FPLYElement& Element = Header.Elements[Header.VertexElement];
+	uint32_t Offsets[PLY_TARGET_VertexIndices] = {};
+	uint32_t Types[PLY_TARGET_VertexIndices] = {};
+	for (uint32_t Target = 0; Target < PLY_TARGET_VertexIndices; ++Target)
+	{
+		if (Header.VertexProperties[Target] != UINT32_MAX)
+		{
+			Offsets[Target] = Element.Properties[Header.VertexProperties[Target]].Offset;
+			Types[Target] = Element.Properties[Header.VertexProperties[Target]].Type;
+		}
+	}
+
+	for (uint32_t Idx = Begin; Idx < End; ++Idx)
+	{
+		const uint8_t* Record = Records + (uint64_t)Idx * Element.Stride;
+		XMFLOAT3& Position = Output.Positions[Idx];
+		Position.x = ReadBinaryFloat<bSwap>(Record + Offsets[PLY_TARGET_X], Types[PLY_TARGET_X]);
+		Position.y = ReadBinaryFloat<bSwap>(Record + Offsets[PLY_TARGET_Y], Types[PLY_TARGET_Y]);
+		Position.z = ReadBinaryFloat<bSwap>(Record + Offsets[PLY_TARGET_Z], Types[PLY_TARGET_Z]);
+		if (Output.Normals)
+		{
+			XMFLOAT3& Normal = Output.Normals[Idx];
+			Normal.x = ReadBinaryFloat<bSwap>(Record + Offsets[PLY_TARGET_NX], Types[PLY_TARGET_NX]);
+			Normal.y = ReadBinaryFloat<bSwap>(Record + Offsets[PLY_TARGET_NY], Types[PLY_TARGET_NY]);
+			Normal.z = ReadBinaryFloat<bSwap>(Record + Offsets[PLY_TARGET_NZ], Types[PLY_TARGET_NZ]);
+		}
+		if (Output.Texcoords)
+		{
+			XMFLOAT2& Texcoord = Output.Texcoords[Idx];
+			Texcoord.x = ReadBinaryFloat<bSwap>(Record + Offsets[PLY_TARGET_U], Types[PLY_TARGET_U]);
+			Texcoord.y = ReadBinaryFloat<bSwap>(Record + Offsets[PLY_TARGET_V], Types[PLY_TARGET_V]);
+		}
+	}
+}
+
+// Faces of the all-triangles fast path: records are just the index list. Returns false when a face is not a
+// triangle (or an index is out of range).
+template<bool bSwap>
+static bool DecodeBinaryTriangles(const FPLYProperty& Indices, const uint8_t* Records, uint32_t Begin, uint32_t End, uint32_t NumVertices, uint32_t* OutTriangles)
+{
+	const uint32_t CountSize = GTypeSizes[Indices.CountType];
+	const uint32_t IndexSize = GTypeSizes[Indices.Type];
+	const uint32_t Stride = CountSize + 3 * IndexSize;
+	for (uint32_t Idx = Begin; Idx < End; ++Idx)
+	{
+		const uint8_t* Record = Records + (uint64_t)Idx * Stride;
+		const uint32_t I0 = ReadBinaryUInt<bSwap>(Record + CountSize, Indices.Type);
+		const uint32_t I1 = ReadBinaryUInt<bSwap>(Record + CountSize + IndexSize, Indices.Type);
+		const uint32_t I2 = ReadBinaryUInt<bSwap>(Record + CountSize + 2 * IndexSize, Indices.Type);
+		if (ReadBinaryUInt<bSwap>(Record, Indices.CountType) != 3 || I0 >= NumVertices || I1 >= NumVertices || I2 >= NumVertices)
+		{
+			return false;
+		}
+		OutTriangles[3 * Idx + 0] = I0;
+		OutTriangles[3 * Idx + 1] = I1;
+		OutTriangles[3 * Idx + 2] = I2;
+	}
+	return true;
+}
+
+// Returns the offset of the next record (0 for truncated data). OutList and OutListCount are the items of property
+// ListProperty.
+template<bool bSwap>
+static uint64_t SkipBinaryRecord(const FPLYElement& Element, const uint8_t* Data, uint64_t Size, uint64_t Offset, uint32_t ListProperty, uint64_t& OutList, uint32_t& OutListCount)
+{
+	for (uint32_t PropertyIdx = 0; PropertyIdx < (uint32_t)Element.Properties.size(); ++PropertyIdx)
+	{
+		const FPLYProperty& Property = Element.Properties[PropertyIdx];
+		if (!Property.bIsList)
+		{
+			Offset += GTypeSizes[Property.Type];
+			continue;
+		}
+		if (Offset + GTypeSizes[Property.CountType] > Size)
+		{
+			return 0;
+		}
+		const uint32_t Count = ReadBinaryUInt<bSwap>(Data + Offset, Property.CountType);
+		Offset += GTypeSizes[Property.CountType];
+		if (PropertyIdx == ListProperty)
+		{
+			OutList = Offset;
+			OutListCount = Count;
+		}
+		Offset += (uint64_t)Count * GTypeSizes[Property.Type];
+	}
+	return Offset <= Size ? Offset : 0;
+}
+
+// Polygons with any number of vertices and faces with other properties. A sequential pass finds where every batch of
+// faces starts and how many triangles it makes, the batches are then triangulated in parallel. Returns the offset
+// after the last face (0 for truncated or corrupt data).
+template<bool bSwap>
+static uint64_t DecodeBinaryPolygons(FJobSystem& Jobs, const FPLYHeader& Header, const uint8_t* Data, uint64_t Size, uint64_t Offset, uint32_t NumVertices,
+	eastl::vector<uint32_t>& InOutTriangles)
+{
+	const FPLYElement& Element = Header.Elements[Header.FaceElement];
+	const uint32_t NumFaces = (uint32_t)Element.Count;
+	const uint32_t NumBatches = (NumFaces + PLY_FACES_PER_JOB - 1) / PLY_FACES_PER_JOB;
+
+	eastl::vector<uint64_t> BatchOffsets(NumBatches + 1);
+	eastl::vector<uint64_t> BatchFirstTriangles(NumBatches + 1);
+	uint64_t NumTriangles = 0;
+	for (uint32_t Idx = 0; Idx < NumFaces; ++Idx)
+	{
+		if (Idx % PLY_FACES_PER_JOB == 0)
+		{
+			BatchOffsets[Idx / PLY_FACES_PER_JOB] = Offset;
+			BatchFirstTriangles[Idx / PLY_FACES_PER_JOB] = NumTriangles;
+		}
+		uint64_t List = 0;
+		uint32_t Count = 0;
+		Offset = SkipBinaryRecord<bSwap>(Element, Data, Size, Offset, Header.IndexProperty, List, Count);
+		if (Offset == 0)
+		{
+			return 0;
+		}
+		NumTriangles += Count > 2 ? Count - 2 : 0;
+	}
+	BatchOffsets[NumBatches] = Offset;
+	BatchFirstTriangles[NumBatches] = NumTriangles;
+
+	const size_t FirstIndex = InOutTriangles.size();
+	InOutTriangles.resize(FirstIndex + 3 * NumTriangles);
+	uint32_t* OutTriangles = InOutTriangles.data() + FirstIndex;
+	const FPLYProperty& Indices = Element.Properties[Header.IndexProperty];
+	const uint32_t IndexSize = GTypeSizes[Indices.Type];
+
+	EA::Thread::AtomicInt32 bIsCorrupt(0);
+	ParallelFor(Jobs, NumBatches, 1, [&](uint32_t Begin, uint32_t End)
+	{
+		for (uint32_t Batch = Begin; Batch < End; ++Batch)
+		{
+			uint64_t RecordOffset = BatchOffsets[Batch];
+			uint32_t* Out = OutTriangles + 3 * BatchFirstTriangles[Batch];
+			const uint32_t NumBatchFaces = XMMin(NumFaces - Batch * PLY_FACES_PER_JOB, (uint32_t)PLY_FACES_PER_JOB);
+			for (uint32_t Idx = 0; Idx < NumBatchFaces; ++Idx)
+			{
+				uint64_t List = 0;
+				uint32_t Count = 0;
+				RecordOffset = SkipBinaryRecord<bSwap>(Element, Data, Size, RecordOffset, Header.IndexProperty, List, Count);
+
+				// Fan triangulation, fine for the convex polygons scanners and modelling tools write.
+				uint32_t First = 0;
+				uint32_t Previous = 0;
+				for (uint32_t Corner = 0; Corner < Count; ++Corner)
+				{
+					const uint32_t Index = ReadBinaryUInt<bSwap>(Data + List + Corner * IndexSize, Indices.Type);
+					if (Index >= NumVertices)
+					{
+						bIsCorrupt.SetValue(1);
+						return;
+					}
+					if (Corner == 0)
+					{
+						First = Index;
+					}
+					else if (Corner >= 2)
+					{
+						Out[0] = First;
+						Out[1] = Previous;
+						Out[2] = Index;
+						Out += 3;
+					}
+					Previous = Index;
+				}
+			}
+		}
+	});
+	return bIsCorrupt.GetValue() == 0 ? Offset : 0;
+}
+
+template<bool bSwap>
+static bool DecodeBinaryPLY(FJobSystem& Jobs, const FPLYHeader& Header, const uint8_t* Data, uint64_t Size, const FPLYOutput& Output, eastl::vector<uint32_t>& InOutTriangles)
+{
+	uint64_t Offset = Header.DataOffset;
+	for (uint32_t ElementIdx = 0; ElementIdx < (uint32_t)Header.Elements.size(); ++ElementIdx)
+	{
+		const FPLYElement& Element = Header.Elements[ElementIdx];
+		if (ElementIdx == Header.VertexElement)
+		{
+			if (Element.Stride == 0 || !HasRecords(Offset, Size, Element.Count, Element.Stride))
+			{
+				return false;
+			}
+			const uint8_t* Records = Data + Offset;
+			ParallelFor(Jobs, Output.NumVertices, PLY_VERTICES_PER_JOB, [&](uint32_t Begin, uint32_t End)
+			{
+				DecodeBinaryVertices<bSwap>(Header, Records, Begin, End, Output);
+			});
+			Offset += Element.Count * Element.Stride;
+		}
+		else if (ElementIdx == Header.FaceElement && Header.IndexProperty != UINT32_MAX)
+		{
+			// Most files only have triangles: when the size adds up, decode them in place and fall back to the
+			// general path if a face turns out to be something else.
+			const FPLYProperty& Indices = Element.Properties[Header.IndexProperty];
+			const uint32_t TriangleStride = GTypeSizes[Indices.CountType] + 3 * GTypeSizes[Indices.Type];
+			const uint32_t NumFaces = (uint32_t)Element.Count;
+			if (Element.Properties.size() == 1 && HasRecords(Offset, Size, Element.Count, TriangleStride))
+			{
+				const size_t FirstIndex = InOutTriangles.size();
+				InOutTriangles.resize(FirstIndex + 3 * (size_t)NumFaces);
+				EA::Thread::AtomicInt32 bAreTriangles(1);
+				ParallelFor(Jobs, NumFaces, PLY_FACES_PER_JOB, [&](uint32_t Begin, uint32_t End)
+				{
+					if (bAreTriangles.GetValue() && !DecodeBinaryTriangles<bSwap>(Indices, Data + Offset, Begin, End, Output.NumVertices, InOutTriangles.data() + FirstIndex))
+					{
+						bAreTriangles.SetValue(0);
+					}
+				});
+				if (bAreTriangles.GetValue())
+				{
+					Offset += Element.Count * TriangleStride;
+					continue;
+				}
+				InOutTriangles.resize(FirstIndex);
+			}
+			Offset = DecodeBinaryPolygons<bSwap>(Jobs, Header, Data, Size, Offset, Output.NumVertices, InOutTriangles);
+			if (Offset == 0)
+			{
+				return false;
+			}
+		}
+		else if (Element.Stride != 0)
+		{
+			if (!HasRecords(Offset, Size, Element.Count, Element.Stride))
+			{
+				return false;
+			}
+			Offset += Element.Count * Element.Stride;
+		}
+		else
+		{
+			for (uint64_t Idx = 0; Idx < Element.Count && Offset != 0; ++Idx)
+			{
+				uint64_t List;
+				uint32_t Count;
+				Offset = SkipBinaryRecord<bSwap>(Element, Data, Size, Offset, UINT32_MAX, List, Count);
+			}
+			if (Offset == 0)
+			{
+				return false;
+			}
+		}
+	}
+	return Offset <= Size;
+}
+
+// ascii files.
+
+static const double GPowersOf10[] =
+{
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+static bool SkipToken(const char*& InOutCursor, const char* End)
+{
+	const char* Cursor = SkipSpaces(InOutCursor, End);
+	const char* const Start = Cursor;
+	while (Cursor < End && !IsSpace(*Cursor))
+	{
+		++Cursor;
+	}
+	InOutCursor = Cursor;
+	return Cursor != Start;
+}
+
+static bool ParseFloatSlow(const char*& InOutCursor, const char* End, float& OutValue)
+{
+	const char* const Start = SkipSpaces(InOutCursor, End);
+	const char* Cursor = Start;
+	if (!SkipToken(Cursor, End) || Cursor - Start >= 64)
+	{
+		return false;
+	}
+	char Token[64];
+	memcpy(Token, Start, Cursor - Start);
+	Token[Cursor - Start] = 0;
+	char* TokenEnd;
+	OutValue = (float)EA::StdC::Strtod(Token, &TokenEnd);
+	InOutCursor = Cursor;
+	return *TokenEnd == 0;
+}
+
+// The usual [-]digits[.digits][e[-]digits] numbers with up to 19 significant digits and small exponents: the mantissa
+// and the power of 10 are exact doubles, so one multiply or divide rounds correctly (the conversion to float then
+// rounds again, at most an ulp away from strtof()). Anything else (inf, nan, long mantissas, large exponents) goes
+// through Strtod().
+static inline bool ParseFloat(const char*& InOutCursor, const char* End, float& OutValue)
+{
+	const char* Cursor = SkipSpaces(InOutCursor, End);
+	bool bIsNegative = false;
+	if (Cursor < End && (*Cursor == '-' || *Cursor == '+'))
+	{
+		bIsNegative = *Cursor == '-';
+		++Cursor;
+	}
+	uint64_t Mantissa = 0;
+	int32_t Exponent = 0;
+	uint32_t NumDigits = 0;
+	bool bHasDigits = false;
+	for (; Cursor < End && IsDigit(*Cursor); ++Cursor)
+	{
+		bHasDigits = true;
+		if (NumDigits < 19)
+		{
+			Mantissa = Mantissa * 10 + (uint32_t)(*Cursor - '0');
+			NumDigits += Mantissa != 0;
+		}
+		else
+		{
+			++Exponent;
+		}
+	}
+	if (Cursor < End && *Cursor == '.')
+	{
+		for (++Cursor; Cursor < End && IsDigit(*Cursor); ++Cursor)
+		{
+			bHasDigits = true;
+			if (NumDigits < 19)
+			{
+				Mantissa = Mantissa * 10 + (uint32_t)(*Cursor - '0');
+				NumDigits += Mantissa != 0;
+				--Exponent;
+			}
+		}
+	}
+	if (bHasDigits && Cursor < End && (*Cursor == 'e' || *Cursor == 'E'))
+	{
+		++Cursor;
+		bool bIsExponentNegative = false;
+		if (Cursor < End && (*Cursor == '-' || *Cursor == '+'))
+		{
+			bIsExponentNegative = *Cursor == '-';
+			++Cursor;
+		}
+		int32_t Value = 0;
+		bHasDigits = Cursor < End && IsDigit(*Cursor);
+		for (; Cursor < End && IsDigit(*Cursor); ++Cursor)
+		{
+			Value = XMMin(Value * 10 + (*Cursor - '0'), 100000);
+		}
+		Exponent += bIsExponentNegative ? -Value : Value;
+	}
+	if (!bHasDigits || (Cursor < End && !IsSpace(*Cursor)) || Mantissa > (1ull << 53) || Exponent < -22 || Exponent > 22)
+	{
+		return ParseFloatSlow(InOutCursor, End, OutValue);
+	}
+	const double Value = Exponent < 0 ? (double)Mantissa / GPowersOf10[-Exponent] : (double)Mantissa * GPowersOf10[Exponent];
+	OutValue = (float)(bIsNegative ? -Value : Value);
+	InOutCursor = Cursor;
+	return true;
+}
+
+static inline bool ParseUInt(const char*& InOutCursor, const char* End, uint32_t& OutValue)
+{
+	const char* Cursor = SkipSpaces(InOutCursor, End);
+	if (Cursor < End && *Cursor == '+')
+	{
+		++Cursor;
+	}
+	const char* const Digits = Cursor;
+	uint64_t Value = 0;
+	for (; Cursor < End && IsDigit(*Cursor); ++Cursor)
+	{
+		Value = Value * 10 + (uint32_t)(*Cursor - '0');
+		if (Value > UINT32_MAX)
+		{
+			return false;
+		}
+	}
+	if (Cursor == Digits || (Cursor < End && !IsSpace(*Cursor)))
+	{
+		return false;
+	}
+	OutValue = (uint32_t)Value;
+	InOutCursor = Cursor;
+	return true;
+}
+
+static bool SkipAsciiList(const char*& InOutCursor, const char* End)
+{
+	uint32_t Count;
+	if (!ParseUInt(InOutCursor, End, Count))
+	{
+		return false;
+	}
+	for (uint32_t Idx = 0; Idx < Count; ++Idx)
+	{
+		if (!SkipToken(InOutCursor, End))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool ParseAsciiVertex(const FPLYElement& Element, const char* Cursor, const char* End, uint32_t Idx, const FPLYOutput& Output)
+{
+	float Values[PLY_TARGET_VertexIndices];
+	for (const FPLYProperty& Property : Element.Properties)
+	{
+		const bool bResult = Property.bIsList ? SkipAsciiList(Cursor, End) :
+			Property.Target != PLY_TARGET_None ? ParseFloat(Cursor, End, Values[Property.Target]) : SkipToken(Cursor, End);
+		if (!bResult)
+		{
+			return false;
+		}
+	}
+	Output.Positions[Idx] = XMFLOAT3(Values[PLY_TARGET_X], Values[PLY_TARGET_Y], Values[PLY_TARGET_Z]);
+	if (Output.Normals)
+	{
+		Output.Normals[Idx] = XMFLOAT3(Values[PLY_TARGET_NX], Values[PLY_TARGET_NY], Values[PLY_TARGET_NZ]);
+	}
+	if (Output.Texcoords)
+	{
+		Output.Texcoords[Idx] = XMFLOAT2(Values[PLY_TARGET_U], Values[PLY_TARGET_V]);
+	}
+	return true;
+}
+
+static bool ParseAsciiFace(const FPLYElement& Element, const char* Cursor, const char* End, uint32_t NumVertices, eastl::vector<uint32_t>& InOutTriangles)
+{
+	for (const FPLYProperty& Property : Element.Properties)
+	{
+		if (Property.Target != PLY_TARGET_VertexIndices)
+		{
+			if (!(Property.bIsList ? SkipAsciiList(Cursor, End) : SkipToken(Cursor, End)))
+			{
+				return false;
+			}
+			continue;
+		}
+		uint32_t Count;
+		if (!ParseUInt(Cursor, End, Count))
+		{
+			return false;
+		}
+		// Fan triangulation, see DecodeBinaryPolygons().
+		uint32_t First = 0;
+		uint32_t Previous = 0;
+		for (uint32_t Corner = 0; Corner < Count; ++Corner)
+		{
+			uint32_t Index;
+			if (!ParseUInt(Cursor, End, Index) || Index >= NumVertices)
+			{
+				return false;
+			}
+			if (Corner == 0)
+			{
+				First = Index;
+			}
+			else if (Corner >= 2)
+			{
+				InOutTriangles.push_back(First);
+				InOutTriangles.push_back(Previous);
+				InOutTriangles.push_back(Index);
+			}
+			Previous = Index;
+		}
+	}
+	return true;
+}
+
+static bool DecodeAsciiPLY(FJobSystem& Jobs, const FPLYHeader& Header, const uint8_t* Data, uint64_t Size, const FPLYOutput& Output, eastl::vector<uint32_t>& InOutTriangles)
+{
+	// Chunks of about PLY_ASCII_CHUNK_SIZE bytes that start at the beginning of a line.
+	eastl::vector<uint64_t> ChunkStarts;
+	for (uint64_t Start = Header.DataOffset; Start < Size;)
+	{
+		ChunkStarts.push_back(Start);
+		const uint64_t Next = Start + PLY_ASCII_CHUNK_SIZE;
+		const void* LineEnd = Next < Size ? memchr(Data + Next, '\n', Size - Next) : nullptr;
+		Start = LineEnd ? (const uint8_t*)LineEnd - Data + 1 : Size;
+	}
+	const uint32_t NumChunks = (uint32_t)ChunkStarts.size();
+	ChunkStarts.push_back(Size);
+
+	// Line numbers of the chunks, a line without '\n' at the end of the file counts too.
+	eastl::vector<uint64_t> FirstLines(NumChunks + 1);
+	ParallelFor(Jobs, NumChunks, 1, [&](uint32_t Begin, uint32_t End)
+	{
+		for (uint32_t Chunk = Begin; Chunk < End; ++Chunk)
+		{
+			const uint8_t* Cursor = Data + ChunkStarts[Chunk];
+			const uint8_t* const ChunkEnd = Data + ChunkStarts[Chunk + 1];
+			uint64_t NumLines = 0;
+			while (const void* LineEnd = memchr(Cursor, '\n', ChunkEnd - Cursor))
+			{
+				Cursor = (const uint8_t*)LineEnd + 1;
+				++NumLines;
+			}
+			FirstLines[Chunk + 1] = NumLines + (Cursor < ChunkEnd ? 1 : 0);
+		}
+	});
+	for (uint32_t Chunk = 0; Chunk < NumChunks; ++Chunk)
+	{
+		FirstLines[Chunk + 1] += FirstLines[Chunk];
+	}
+
+	// Elements are consecutive runs of lines.
+	const uint32_t NumElements = (uint32_t)Header.Elements.size();
+	eastl::vector<uint64_t> ElementFirstLines(NumElements + 1);
+	for (uint32_t ElementIdx = 0; ElementIdx < NumElements; ++ElementIdx)
+	{
+		ElementFirstLines[ElementIdx + 1] = ElementFirstLines[ElementIdx] + Header.Elements[ElementIdx].Count;
+	}
+	if (ElementFirstLines[NumElements] > FirstLines[NumChunks])
+	{
+		return false;
+	}
+
+	// Vertices go straight to the output, triangles to per chunk arrays (polygons make their number unknown).
+	eastl::vector<eastl::vector<uint32_t>> ChunkTriangles(NumChunks);
+	EA::Thread::AtomicInt32 bIsCorrupt(0);
+	ParallelFor(Jobs, NumChunks, 1, [&](uint32_t Begin, uint32_t End)
+	{
+		for (uint32_t Chunk = Begin; Chunk < End; ++Chunk)
+		{
+			const char* Cursor = (const char*)Data + ChunkStarts[Chunk];
+			const char* const ChunkEnd = (const char*)Data + ChunkStarts[Chunk + 1];
+			uint64_t Line = FirstLines[Chunk];
+			uint32_t ElementIdx = 0;
+			for (; Cursor < ChunkEnd && Line < ElementFirstLines[NumElements]; ++Line)
+			{
+				const char* LineEnd = (const char*)memchr(Cursor, '\n', ChunkEnd - Cursor);
+				LineEnd = LineEnd ? LineEnd : ChunkEnd;
+				while (Line >= ElementFirstLines[ElementIdx + 1])
+				{
+					++ElementIdx;
+				}
+
+				const FPLYElement& Element = Header.Elements[ElementIdx];
+				bool bResult = true;
+				if (ElementIdx == Header.VertexElement)
+				{
+					bResult = ParseAsciiVertex(Element, Cursor, LineEnd, (uint32_t)(Line - ElementFirstLines[ElementIdx]), Output);
+				}
+				else if (ElementIdx == Header.FaceElement)
+				{
+					bResult = ParseAsciiFace(Element, Cursor, LineEnd, Output.NumVertices, ChunkTriangles[Chunk]);
+				}
+				if (!bResult)
+				{
+					bIsCorrupt.SetValue(1);
+					return;
+				}
+				Cursor = LineEnd + 1;
+			}
+		}
+	});
+	if (bIsCorrupt.GetValue())
+	{
+		return false;
+	}
+
+	eastl::vector<size_t> ChunkFirstIndices(NumChunks + 1);
+	ChunkFirstIndices[0] = InOutTriangles.size();
+	for (uint32_t Chunk = 0; Chunk < NumChunks; ++Chunk)
+	{
+		ChunkFirstIndices[Chunk + 1] = ChunkFirstIndices[Chunk] + ChunkTriangles[Chunk].size();
+	}
+	InOutTriangles.resize(ChunkFirstIndices[NumChunks]);
+	ParallelFor(Jobs, NumChunks, 1, [&](uint32_t Begin, uint32_t End)
+	{
+		for (uint32_t Chunk = Begin; Chunk < End; ++Chunk)
+		{
+			memcpy(InOutTriangles.data() + ChunkFirstIndices[Chunk], ChunkTriangles[Chunk].data(), ChunkTriangles[Chunk].size() * sizeof(uint32_t));
+			ChunkTriangles[Chunk].set_capacity(0);
+		}
+	});
+	return true;
+}
+
+bool DecodePLY(FJobSystem& Jobs, const void* FileData, uint64_t FileSize, eastl::vector<XMFLOAT3>& InOutPositions, eastl::vector<XMFLOAT3>& InOutNormals,
+	eastl::vector<XMFLOAT2>& InOutTexcoords, eastl::vector<uint32_t>& InOutTriangles)
+{
+	const uint8_t* Data = (const uint8_t*)FileData;
+	FPLYHeader Header;
+	Header.VertexElement = UINT32_MAX;
+	Header.FaceElement = UINT32_MAX;
+	Header.IndexProperty = UINT32_MAX;
+	for (uint32_t& Property : Header.VertexProperties)
+	{
+		Property = UINT32_MAX;
+	}
+	if (!ParsePLYHeader(Data, FileSize, Header))
+	{
+		return false;
+	}
+
+	FPLYOutput Output = {};
+	Output.NumVertices = (uint32_t)Header.Elements[Header.VertexElement].Count;
+	InOutPositions.resize(InOutPositions.size() + Output.NumVertices);
+	Output.Positions = InOutPositions.end() - Output.NumVertices;
+	if (Header.bHasNormals)
+	{
+		InOutNormals.resize(InOutNormals.size() + Output.NumVertices);
+		Output.Normals = InOutNormals.end() - Output.NumVertices;
+	}
+	if (Header.bHasTexcoords)
+	{
+		InOutTexcoords.resize(InOutTexcoords.size() + Output.NumVertices);
+		Output.Texcoords = InOutTexcoords.end() - Output.NumVertices;
+	}
+
+	switch (Header.Format)
+	{
+	case PLY_FORMAT_Ascii: return DecodeAsciiPLY(Jobs, Header, Data, FileSize, Output, InOutTriangles);
+	case PLY_FORMAT_BinaryLittleEndian: return DecodeBinaryPLY<false>(Jobs, Header, Data, FileSize, Output, InOutTriangles);
+	default: return DecodeBinaryPLY<true>(Jobs, Header, Data, FileSize, Output, InOutTriangles);
+	}
+}
+
+bool LoadPLYFile(FJobSystem& Jobs, const char* FileName, eastl::vector<XMFLOAT3>& InOutPositions, eastl::vector<XMFLOAT3>& InOutNormals,
+	eastl::vector<XMFLOAT2>& InOutTexcoords, eastl::vector<uint32_t>& InOutTriangles)
+{
+	FMappedFile File;
+	if (!OpenMappedFile(FileName, File))
+	{
+		return false;
+	}
+	const bool bResult = DecodePLY(Jobs, File.Data, File.Size, InOutPositions, InOutNormals, InOutTexcoords, InOutTriangles);
+	CloseMappedFile(File);
+	return bResult;
+}
+
+template<bool bSwap>
+static void Store32(const void* Value, eastl::vector<uint8_t>& InOutData)
+{
+	uint32_t Bits;
+	memcpy(&Bits, Value, 4);
+	Bits = bSwap ? ByteSwap32(Bits) : Bits;
+	InOutData.insert(InOutData.end(), (const uint8_t*)&Bits, (const uint8_t*)&Bits + 4);
+}
+
+template<bool bSwap>
+static bool WriteBinaryPLYData(FILE* File, const eastl::vector<XMFLOAT3>& Positions, const eastl::vector<XMFLOAT3>& Normals, const eastl::vector<XMFLOAT2>& Texcoords,
+	const eastl::vector<uint32_t>& Triangles)
+{
+	eastl::vector<uint8_t> Data;
+	Data.reserve(Positions.size() * 32);
+	for (size_t Idx = 0; Idx < Positions.size(); ++Idx)
+	{
+		Store32<bSwap>(&Positions[Idx].x, Data);
+		Store32<bSwap>(&Positions[Idx].y, Data);
+		Store32<bSwap>(&Positions[Idx].z, Data);
+		if (!Normals.empty())
+		{
+			Store32<bSwap>(&Normals[Idx].x, Data);
+			Store32<bSwap>(&Normals[Idx].y, Data);
+			Store32<bSwap>(&Normals[Idx].z, Data);
+		}
+		if (!Texcoords.empty())
+		{
+			Store32<bSwap>(&Texcoords[Idx].x, Data);
+			Store32<bSwap>(&Texcoords[Idx].y, Data);
+		}
+	}
+	Data.reserve(Data.size() + Triangles.size() / 3 * 13);
+	for (size_t Idx = 0; Idx < Triangles.size(); ++Idx)
+	{
+		if (Idx % 3 == 0)
+		{
+			Data.push_back(3);
+		}
+		Store32<bSwap>(&Triangles[Idx], Data);
+	}
+	return fwrite(Data.data(), 1, Data.size(), File) == Data.size();
+}
+
+bool SavePLYFile(const char* FileName, uint32_t Format, const eastl::vector<XMFLOAT3>& Positions, const eastl::vector<XMFLOAT3>& Normals,
+	const eastl::vector<XMFLOAT2>& Texcoords, const eastl::vector<uint32_t>& Triangles)
+{
+	EA_ASSERT(Normals.empty() || Normals.size() == Positions.size());
+	EA_ASSERT(Texcoords.empty() || Texcoords.size() == Positions.size());
+	EA_ASSERT(Triangles.size() % 3 == 0);
+
+	FILE* File = fopen(FileName, "wb");
+	if (!File)
+	{
+		return false;
+	}
+	static const char* const FormatNames[] = { "ascii", "binary_little_endian", "binary_big_endian" };
+	fprintf(File, "ply\nformat %s 1.0\nelement vertex %u\nproperty float x\nproperty float y\nproperty float z\n", FormatNames[Format], (uint32_t)Positions.size());
+	if (!Normals.empty())
+	{
+		fprintf(File, "property float nx\nproperty float ny\nproperty float nz\n");
+	}
+	if (!Texcoords.empty())
+	{
+		fprintf(File, "property float s\nproperty float t\n");
+	}
+	fprintf(File, "element face %u\nproperty list uchar int vertex_indices\nend_header\n", (uint32_t)(Triangles.size() / 3));
+
+	bool bResult = true;
+	if (Format == PLY_FORMAT_Ascii)
+	{
+		// 9 significant digits round-trip every float.
+		for (size_t Idx = 0; Idx < Positions.size(); ++Idx)
+		{
+			fprintf(File, "%.9g %.9g %.9g", Positions[Idx].x, Positions[Idx].y, Positions[Idx].z);
+			if (!Normals.empty())
+			{
+				fprintf(File, " %.9g %.9g %.9g", Normals[Idx].x, Normals[Idx].y, Normals[Idx].z);
+			}
+			if (!Texcoords.empty())
+			{
+				fprintf(File, " %.9g %.9g", Texcoords[Idx].x, Texcoords[Idx].y);
+			}
+			fputc('\n', File);
+		}
+		for (size_t Idx = 0; Idx < Triangles.size(); Idx += 3)
+		{
+			fprintf(File, "3 %u %u %u\n", Triangles[Idx], Triangles[Idx + 1], Triangles[Idx + 2]);
+		}
+	}
+	else if (Format == PLY_FORMAT_BinaryLittleEndian)
+	{
+		bResult = WriteBinaryPLYData<false>(File, Positions, Normals, Texcoords, Triangles);
+	}
+	else
+	{
+		bResult = WriteBinaryPLYData<true>(File, Positions, Normals, Texcoords, Triangles);
+	}
+	bResult = !ferror(File) && bResult;
+	return fclose(File) == 0 && bResult;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+#include "EASTL/vector.h"
+#include "DirectXMath/DirectXMath.h"
+
+// Polygon File Format (.ply) reader and writer. Files are decoded straight from the file data (ideally a mapped file)
+// on the job system, without an intermediate copy:
+// - binary_little_endian and binary_big_endian vertices in fixed-size batches,
+// - binary faces in batches found by a quick sequential pass over the list counts (skipped when every face turns out
+//   to be a triangle),
+// - ascii files in line aligned chunks: a parallel newline count gives every chunk its first line, so vertices are
+//   parsed in place and faces are triangulated per chunk and concatenated.
+// Any scalar property type is accepted, polygons are fan triangulated, points and lines are dropped. ascii files must
+// store one element per line (every exporter does).
+
+struct FJobSystem;
+
+enum
+{
+	PLY_FORMAT_Ascii, PLY_FORMAT_BinaryLittleEndian, PLY_FORMAT_BinaryBigEndian,
+};
+
+// Vertex properties: x, y, z, optionally nx, ny, nz and s, t (or u, v, texture_u, texture_v). Faces: vertex_indices
+// (or vertex_index). Normals and texcoords are only appended when the file has them, triangle indices are relative to
+// the first vertex of this file. Returns false for malformed or truncated files and out of range indices, the
+// vectors then hold partial data.
+bool DecodePLY(FJobSystem& Jobs, const void* FileData, uint64_t FileSize, eastl::vector<XMFLOAT3>& InOutPositions, eastl::vector<XMFLOAT3>& InOutNormals,
+	eastl::vector<XMFLOAT2>& InOutTexcoords, eastl::vector<uint32_t>& InOutTriangles);
+bool LoadPLYFile(FJobSystem& Jobs, const char* FileName, eastl::vector<XMFLOAT3>& InOutPositions, eastl::vector<XMFLOAT3>& InOutNormals,
+	eastl::vector<XMFLOAT2>& InOutTexcoords, eastl::vector<uint32_t>& InOutTriangles);
+
+// Normals and Texcoords are optional (empty) or have one entry per position.
+bool SavePLYFile(const char* FileName, uint32_t Format, const eastl::vector<XMFLOAT3>& Positions, const eastl::vector<XMFLOAT3>& Normals,
+	const eastl::vector<XMFLOAT2>& Texcoords, const eastl::vector<uint32_t>& Triangles);
@@ -37,6 +37,33 @@ float3 ImportanceSampleGGX(float2 Xi, float Roughness, float3 N)
 	return TangentX * H.x + TangentY * H.y + N * H.z;
 }
 
+// Direction through texel (U, V) of a cube face in D3D12 face order and orientation (GetCubeMapDirection() in
+// IBLBaker.cpp).
+float3 GetCubeMapDirection(uint Face, float2 UV)
+{
+	float2 ST = 2.0f * UV - 1.0f;
+	float3 Direction;
+	switch (Face)
+	{
+	case 0: Direction = float3(1.0f, -ST.y, -ST.x); break;
+	case 1: Direction = float3(-1.0f, -ST.y, ST.x); break;
+	case 2: Direction = float3(ST.x, 1.0f, ST.y); break;
+	case 3: Direction = float3(ST.x, -1.0f, -ST.y); break;
+	case 4: Direction = float3(ST.x, -ST.y, 1.0f); break;
+	default: Direction = float3(-ST.x, -ST.y, -1.0f); break;
+	}
+	return normalize(Direction);
+}
+
+// Octahedral normal encoding (see EncodeOctahedral() in CookedMesh.cpp).
+float3 DecodeOctahedral(float2 Encoded)
+{
+	float3 N = float3(Encoded, 1.0f - abs(Encoded.x) - abs(Encoded.y));
+	float T = saturate(-N.z);
+	N.xy += N.xy >= 0.0f ? -T : T;
+	return normalize(N);
+}
+
 float GeometrySchlickGGX(float CosTheta, float Roughness)
 {
 	float K = (Roughness * Roughness) * 0.5f;
@@ -1,4 +1,5 @@
 #include "../CPUAndGPUCommon.h"
+#include "Common.hlsli"
 
 #define GRootSignature \
     "RootFlags(ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT), " \
@@ -8,18 +9,19 @@
 		"s0, " \
 		"filter = FILTER_MIN_MAG_LINEAR_MIP_POINT, " \
 		"visibility = SHADER_VISIBILITY_PIXEL, " \
-		"addressU = TEXTURE_ADDRESS_BORDER, " \
-		"addressV = TEXTURE_ADDRESS_BORDER)"
+		"addressU = TEXTURE_ADDRESS_WRAP, " \
+		"addressV = TEXTURE_ADDRESS_CLAMP)"
 
 ConstantBuffer<FPerDrawConstantData> GPerDrawCB : register(b0);
 
 Texture2D GEquirectangularMap : register(t0);
 SamplerState GSampler : register(s0);
 
+// Same mapping as GetEquirectangularUV() in IBLBaker.cpp.
 float2 SampleSphericalMap(float3 V)
 {
-	float2 UV = float2(atan2(V.z, V.x), asin(V.y));
-	UV *= float2(0.1591f, 0.3183f);
+	float2 UV = float2(atan2(V.z, V.x), asin(clamp(V.y, -1.0f, 1.0f)));
+	UV *= float2(0.5f / PI, 1.0f / PI);
 	UV += 0.5f;
 	return UV;
 }
@@ -27,12 +29,12 @@ float2 SampleSphericalMap(float3 V)
 [RootSignature(GRootSignature)]
 void MainVS(
 	in float3 InPosition : _Position,
-	in float3 InNormal : _Normal,
 	out float4 OutPosition : SV_Position,
 	out float3 OutPositionOS : _Position)
 {
-	OutPosition = mul(float4(InPosition, 1.0f), GPerDrawCB.ObjectToClip);
-	OutPositionOS = InPosition;
+	float3 Position = InPosition * GPerDrawCB.PositionScale + GPerDrawCB.PositionBias;
+	OutPosition = mul(float4(Position, 1.0f), GPerDrawCB.ObjectToClip);
+	OutPositionOS = Position;
 }
 
 [RootSignature(GRootSignature)]
@@ -1,48 +1,42 @@
 #include "../CPUAndGPUCommon.h"
 #include "Common.hlsli"
 
+// UAV(u0) to UAV(u7) are the mips of the prefiltered env. map (PREFILTER_ENV_MAP_MAX_MIP_LEVELS, unused mips are null
+// descriptors), each a 6 slice array.
 #define GRootSignature \
-    "RootFlags(ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT), " \
-    "CBV(b0), " \
-    "DescriptorTable(SRV(t0), visibility = SHADER_VISIBILITY_PIXEL), " \
+    "RootConstants(b0, num32BitConstants = 12), " \
+    "DescriptorTable(SRV(t0), UAV(u0, numDescriptors = 8)), " \
     "StaticSampler(" \
 		"s0, " \
-		"filter = FILTER_MIN_MAG_LINEAR_MIP_POINT, " \
-		"visibility = SHADER_VISIBILITY_PIXEL, " \
+		"filter = FILTER_MIN_MAG_MIP_LINEAR, " \
 		"addressU = TEXTURE_ADDRESS_CLAMP, " \
 		"addressV = TEXTURE_ADDRESS_CLAMP, " \
 		"addressW = TEXTURE_ADDRESS_CLAMP)"
 
-ConstantBuffer<FPerDrawConstantData> GPerDrawCB : register(b0);
+ConstantBuffer<FPrefilterEnvMapConstants> GConstants : register(b0);
 TextureCube GEnvMap : register(t0);
+RWTexture2DArray<float4> GPrefilteredEnvMap[PREFILTER_ENV_MAP_MAX_MIP_LEVELS] : register(u0);
 SamplerState GSampler : register(s0);
 
 
-[RootSignature(GRootSignature)]
-void MainVS(
-	in float3 InPosition : _Position,
-	in float3 InNormal : _Normal,
-	out float4 OutPosition : SV_Position,
-	out float3 OutPositionOS : _Position)
-{
-	OutPosition = mul(float4(InPosition, 1.0f), GPerDrawCB.ObjectToClip);
-	OutPositionOS = InPosition;
-}
-
-[RootSignature(GRootSignature)]
-void MainPS(
-	in float4 InPosition : SV_Position,
-	in float3 InPositionOS : _Position,
-	out float4 OutColor : SV_Target0)
+float3 PrefilterEnvMap(float3 N, float Roughness, uint NumSamples)
 {
-	float Roughness = GPerDrawCB.Roughness;
-	float3 N = normalize(InPositionOS);
 	float3 R = N;
 	float3 V = R;
 
+	// Mirror reflection, the GGX lobe is a single direction.
+	if (Roughness == 0.0f)
+	{
+		return GEnvMap.SampleLevel(GSampler, N, 0).rgb;
+	}
+
+	float Width, Height, NumLevels;
+	GEnvMap.GetDimensions(0, Width, Height, NumLevels);
+	float TexelSolidAngle = 4.0f * PI / (6.0f * Width * Width);
+	float Alpha2 = Roughness * Roughness * Roughness * Roughness;
+
 	float3 PrefilteredColor = 0.0f;
 	float TotalWeight = 0.0f;
-	const uint NumSamples = 4 * 1024;
 
 	for (uint SampleIdx = 0; SampleIdx < NumSamples; ++SampleIdx)
 	{
@@ -52,10 +46,49 @@ void MainPS(
 		float NoL = saturate(dot(N, L));
 		if (NoL > 0.0f)
 		{
-			PrefilteredColor += GEnvMap.SampleLevel(GSampler, L, 0).rgb * NoL;
+			// Filtered importance sampling: read the mip whose texels cover the solid angle of the sample,
+			// 1 / (NumSamples * PDF) with PDF = D(NoH) / 4 (V == N). Matches PrefilterEnvMap() in IBLBaker.cpp.
+			float NoH = saturate(dot(N, H));
+			float Denominator = NoH * NoH * (Alpha2 - 1.0f) + 1.0f;
+			float PDF = Alpha2 / (PI * Denominator * Denominator) * 0.25f;
+			float SampleSolidAngle = 1.0f / (NumSamples * PDF);
+			float Mip = clamp(0.5f * log2(SampleSolidAngle / TexelSolidAngle), 0.0f, NumLevels - 1.0f);
+
+			PrefilteredColor += GEnvMap.SampleLevel(GSampler, L, Mip).rgb * NoL;
 			TotalWeight += NoL;
 		}
 	}
 
-	OutColor = float4(PrefilteredColor / TotalWeight, 1.0f);
+	return PrefilteredColor / TotalWeight;
+}
+
+[RootSignature(GRootSignature)]
+[numthreads(PREFILTER_ENV_MAP_TILE_SIZE, PREFILTER_ENV_MAP_TILE_SIZE, 1)]
+void MainCS(uint3 GroupID : SV_GroupID, uint3 GroupThreadID : SV_GroupThreadID)
+{
+	// GroupID.x numbers the tiles of all mips (mip 0 first) relative to FirstTile, GroupID.y is the face. Mip is
+	// uniform in a thread group.
+	uint Tile = GroupID.x + GConstants.FirstTile;
+	uint Mip = 0;
+	uint MipResolution = GConstants.Resolution;
+	uint TilesPerRow = (MipResolution + PREFILTER_ENV_MAP_TILE_SIZE - 1) / PREFILTER_ENV_MAP_TILE_SIZE;
+	while (Tile >= TilesPerRow * TilesPerRow && Mip + 1 < GConstants.NumMipLevels)
+	{
+		Tile -= TilesPerRow * TilesPerRow;
+		Mip += 1;
+		MipResolution = max(MipResolution / 2, 1u);
+		TilesPerRow = (MipResolution + PREFILTER_ENV_MAP_TILE_SIZE - 1) / PREFILTER_ENV_MAP_TILE_SIZE;
+	}
+
+	uint2 Texel = uint2(Tile % TilesPerRow, Tile / TilesPerRow) * PREFILTER_ENV_MAP_TILE_SIZE + GroupThreadID.xy;
+	if (Texel.x >= MipResolution || Texel.y >= MipResolution)
+	{
+		return;
+	}
+
+	float3 N = GetCubeMapDirection(GroupID.y, (Texel + 0.5f) / MipResolution);
+	float Roughness = GConstants.NumMipLevels > 1 ? (float)Mip / (GConstants.NumMipLevels - 1) : 0.0f;
+	uint NumSamples = GConstants.NumSamples[Mip / 4][Mip % 4];
+
+	GPrefilteredEnvMap[Mip][uint3(Texel, GroupID.y)] = float4(PrefilterEnvMap(N, Roughness, NumSamples), 1.0f);
 }
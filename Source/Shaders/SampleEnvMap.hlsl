@@ -3,7 +3,8 @@
 #define GRootSignature \
     "RootFlags(ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT), " \
     "CBV(b0, visibility = SHADER_VISIBILITY_VERTEX), " \
-    "DescriptorTable(SRV(t0), visibility = SHADER_VISIBILITY_PIXEL), " \
+    "RootConstants(b1, num32BitConstants = 1, visibility = SHADER_VISIBILITY_PIXEL), " \
+    "DescriptorTable(SRV(t0, numDescriptors = unbounded, flags = DESCRIPTORS_VOLATILE), visibility = SHADER_VISIBILITY_PIXEL), " \
     "StaticSampler(" \
 		"s0, " \
 		"filter = FILTER_MIN_MAG_MIP_LINEAR, " \
@@ -14,18 +15,24 @@
 
 ConstantBuffer<FPerDrawConstantData> GPerDrawCB : register(b0);
 
-TextureCube GEnvMap : register(t0);
+cbuffer _ : register(b1)
+{
+	uint GEnvMapSlot;
+}
+
+// Starts at the persistent descriptors.
+TextureCube GCubeTextures[] : register(t0);
 SamplerState GSampler : register(s0);
 
 [RootSignature(GRootSignature)]
 void MainVS(
 	in float3 InPosition : _Position,
-	in float3 InNormal : _Normal,
 	out float4 OutPosition : SV_Position,
 	out float3 OutTexcoords : _Texcoords)
 {
-	OutPosition = mul(float4(InPosition, 1.0f), GPerDrawCB.ObjectToClip).xyww;
-	OutTexcoords = InPosition;
+	float3 Position = InPosition * GPerDrawCB.PositionScale + GPerDrawCB.PositionBias;
+	OutPosition = mul(float4(Position, 1.0f), GPerDrawCB.ObjectToClip).xyww;
+	OutTexcoords = Position;
 }
 
 [RootSignature(GRootSignature)]
@@ -34,7 +41,7 @@ void MainPS(
 	in float3 InTexcoords : _Texcoords,
 	out float4 OutColor : SV_Target0)
 {
-	float3 EnvColor = GEnvMap.Sample(GSampler, InTexcoords).rgb;
+	float3 EnvColor = GCubeTextures[GEnvMapSlot].Sample(GSampler, InTexcoords).rgb;
 
 	EnvColor = EnvColor / (EnvColor + 1.0f);
 	EnvColor = pow(EnvColor, 1.0f / 2.2f);
@@ -3,8 +3,11 @@
 
 #define GRootSignature \
     "RootFlags(ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT), " \
-    "CBV(b0), " \
-	"DescriptorTable(CBV(b1), SRV(t0), SRV(t1), SRV(t2), visibility = SHADER_VISIBILITY_PIXEL), " \
+    "RootConstants(b0, num32BitConstants = 1, visibility = SHADER_VISIBILITY_VERTEX), " \
+	"CBV(b1), " \
+	"SRV(t0, visibility = SHADER_VISIBILITY_VERTEX), " \
+	"DescriptorTable(SRV(t0, space = 1, numDescriptors = unbounded, flags = DESCRIPTORS_VOLATILE), visibility = SHADER_VISIBILITY_PIXEL), " \
+	"DescriptorTable(SRV(t0, space = 2, numDescriptors = unbounded, flags = DESCRIPTORS_VOLATILE), visibility = SHADER_VISIBILITY_PIXEL), " \
 	"StaticSampler(" \
 		"s0, " \
 		"filter = FILTER_MIN_MAG_MIP_LINEAR, " \
@@ -13,11 +16,13 @@
 		"addressV = TEXTURE_ADDRESS_BORDER, " \
 		"addressW = TEXTURE_ADDRESS_BORDER)"
 
-ConstantBuffer<FPerDrawConstantData> GPerDrawCB : register(b0);
+// Instances of a draw start at GFirstInstance in GInstances (see FStaticDrawBatch).
+cbuffer _ : register(b0) { uint GFirstInstance; }
 ConstantBuffer<FPerFrameConstantData> GPerFrameCB : register(b1);
-TextureCube GIrradianceMap : register(t0);
-TextureCube GPrefilteredEnvMap : register(t1);
-Texture2D GBRDFIntegrationMap : register(t2);
+StructuredBuffer<FStaticInstanceData> GInstances : register(t0);
+// Both tables start at the persistent descriptors, GPerFrameCB has the slots of the textures.
+TextureCube GCubeTextures[] : register(t0, space1);
+Texture2D GTextures[] : register(t0, space2);
 SamplerState GSampler : register(s0);
 
 // Trowbridge-Reitz GGX normal distribution function.
@@ -41,17 +46,40 @@ float3 FresnelSchlickRoughness(float CosTheta, float3 F0, float Roughness)
 	return F0 + (max(1.0f - Roughness, F0) - F0) * pow(1.0f - CosTheta, 5.0f);
 }
 
+// Irradiance / PI, ringing of the SH reconstruction can go below zero.
+float3 EvaluateIrradianceSH(float3 N)
+{
+	float3 Irradiance = GPerFrameCB.IrradianceSH[0].rgb;
+	Irradiance += GPerFrameCB.IrradianceSH[1].rgb * N.y;
+	Irradiance += GPerFrameCB.IrradianceSH[2].rgb * N.z;
+	Irradiance += GPerFrameCB.IrradianceSH[3].rgb * N.x;
+	Irradiance += GPerFrameCB.IrradianceSH[4].rgb * (N.x * N.y);
+	Irradiance += GPerFrameCB.IrradianceSH[5].rgb * (N.y * N.z);
+	Irradiance += GPerFrameCB.IrradianceSH[6].rgb * (3.0f * N.z * N.z - 1.0f);
+	Irradiance += GPerFrameCB.IrradianceSH[7].rgb * (N.x * N.z);
+	Irradiance += GPerFrameCB.IrradianceSH[8].rgb * (N.x * N.x - N.y * N.y);
+	return max(Irradiance, 0.0f);
+}
+
 [RootSignature(GRootSignature)]
 void MainVS(
 	in float3 InPosition : _Position,
-	in float3 InNormal : _Normal,
+	in float2 InNormal : _Normal,
+	in float4 InColor : _Color,
+	in uint InInstanceID : SV_InstanceID,
 	out float4 OutPosition : SV_Position,
 	out float3 OutPositionWS : _Position,
-	out float3 OutNormalWS : _Normal)
+	out float3 OutNormalWS : _Normal,
+	out float3 OutAlbedo : _Color,
+	nointerpolation out float3 OutMaterial : _Material)
 {
-	OutPosition = mul(float4(InPosition, 1.0f), GPerDrawCB.ObjectToClip);
-	OutPositionWS = mul(float4(InPosition, 1.0f), GPerDrawCB.ObjectToWorld);
-	OutNormalWS = mul(InNormal, (float3x3)GPerDrawCB.ObjectToWorld);
+	FStaticInstanceData Instance = GInstances[GFirstInstance + InInstanceID];
+	float3 Position = InPosition * Instance.PositionScale + Instance.PositionBias;
+	OutPositionWS = mul(float4(Position, 1.0f), Instance.ObjectToWorld);
+	OutPosition = mul(float4(OutPositionWS, 1.0f), GPerFrameCB.WorldToClip);
+	OutNormalWS = mul(DecodeOctahedral(InNormal), (float3x3)Instance.ObjectToWorld);
+	OutAlbedo = Instance.Albedo * InColor.rgb;
+	OutMaterial = float3(Instance.Roughness, Instance.Metallic, Instance.AO);
 }
 
 [RootSignature(GRootSignature)]
@@ -59,16 +87,18 @@ void MainPS(
 	in float4 InPosition : SV_Position,
 	in float3 InPositionWS : _Position,
 	in float3 InNormalWS : _Normal,
+	in float3 InAlbedo : _Color,
+	nointerpolation in float3 InMaterial : _Material,
 	out float4 OutColor : SV_Target0)
 {
 	float3 V = normalize(GPerFrameCB.ViewerPosition.xyz - InPositionWS);
 	float3 N = normalize(InNormalWS);
 	float NoV = saturate(dot(N, V));
 
-	float3 Albedo = GPerDrawCB.Albedo;
-	float Roughness = GPerDrawCB.Roughness;
-	float Metallic = GPerDrawCB.Metallic;
-	float AO = GPerDrawCB.AO;
+	float3 Albedo = InAlbedo;
+	float Roughness = InMaterial.x;
+	float Metallic = InMaterial.y;
+	float AO = InMaterial.z;
 
 	float3 F0 = float3(0.04f, 0.04f, 0.04f);
 	F0 = lerp(F0, Albedo, Metallic);
@@ -107,11 +137,11 @@ void MainPS(
 	float3 KD = 1.0f - F;
 	KD *= 1.0f - Metallic;
 
-	float3 Irradiance = GIrradianceMap.SampleLevel(GSampler, N, 0.0f).rgb;
+	float3 Irradiance = EvaluateIrradianceSH(N);
 	float3 Diffuse = Irradiance * Albedo;
-	float3 PrefilteredColor = GPrefilteredEnvMap.SampleLevel(GSampler, R, Roughness * 5.0f).rgb;
+	float3 PrefilteredColor = GCubeTextures[GPerFrameCB.PrefilteredEnvMapSlot].SampleLevel(GSampler, R, Roughness * 5.0f).rgb;
 
-	float2 EnvBRDF = GBRDFIntegrationMap.SampleLevel(GSampler, float2(min(NoV, 0.999f), Roughness), 0.0f).rg;
+	float2 EnvBRDF = GTextures[GPerFrameCB.BRDFIntegrationMapSlot].SampleLevel(GSampler, float2(min(NoV, 0.999f), Roughness), 0.0f).rg;
 
 	float3 Specular = PrefilteredColor * (F * EnvBRDF.x + EnvBRDF.y);
 
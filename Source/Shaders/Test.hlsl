@@ -3,7 +3,6 @@
 [RootSignature(GRootSignature)]
 void MainVS(
     in float3 InPosition : _Position,
-    in float3 InNormal : _Normal,
     out float4 OutPosition : SV_Position)
 {
     OutPosition = float4(InPosition, 1.0f);
@@ -0,0 +1,178 @@
+#include "SphericalHarmonics.h"
+#include "EAAssert/eaassert.h"
+#include "DirectXMath/DirectXPackedVector.h"
+
+#define PI 3.14159265359f
+
+// Y0 = K0, Y1 = K1 * y, Y2 = K2 * z, Y3 = K3 * x, Y4 = K4 * xy, Y5 = K5 * yz, Y6 = K6 * (3z^2 - 1), Y7 = K7 * xz,
+// Y8 = K8 * (x^2 - y^2).
+static const float GBasisConstants[SH_NUM_COEFFICIENTS] =
+{
+	0.282095f, 0.488603f, 0.488603f, 0.488603f, 1.092548f, 1.092548f, 0.315392f, 1.092548f, 0.546274f,
+};
+
+// Unnormalized GetCubeMapDirection() from IBLBaker.cpp: component C of the direction through (S, T) on a face is
+// S * Axes[C][0] + Axes[C][1] + T * Axes[C][2].
+static const float GFaceAxes[6][3][3] =
+{
+	{ { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, -1.0f }, { -1.0f, 0.0f, 0.0f } }, // +X: (1, -T, -S)
+	{ { 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, -1.0f }, { 1.0f, 0.0f, 0.0f } }, // -X: (-1, -T, S)
+	{ { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } }, // +Y: (S, 1, T)
+	{ { 1.0f, 0.0f, 0.0f }, { 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, -1.0f } }, // -Y: (S, -1, -T)
+	{ { 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f }, { 0.0f, 1.0f, 0.0f } }, // +Z: (S, -T, 1)
+	{ { -1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, -1.0f }, { 0.0f, -1.0f, 0.0f } }, // -Z: (-S, -T, -1)
+};
+
+static void XM_CALLCONV EvaluateBasis(FXMVECTOR X, FXMVECTOR Y, FXMVECTOR Z, XMVECTOR OutBasis[SH_NUM_COEFFICIENTS])
+{
+	OutBasis[0] = XMVectorReplicate(GBasisConstants[0]);
+	OutBasis[1] = XMVectorScale(Y, GBasisConstants[1]);
+	OutBasis[2] = XMVectorScale(Z, GBasisConstants[2]);
+	OutBasis[3] = XMVectorScale(X, GBasisConstants[3]);
+	OutBasis[4] = XMVectorScale(XMVectorMultiply(X, Y), GBasisConstants[4]);
+	OutBasis[5] = XMVectorScale(XMVectorMultiply(Y, Z), GBasisConstants[5]);
+	OutBasis[6] = XMVectorScale(XMVectorMultiplyAdd(XMVectorReplicate(3.0f), XMVectorMultiply(Z, Z), g_XMNegativeOne), GBasisConstants[6]);
+	OutBasis[7] = XMVectorScale(XMVectorMultiply(X, Z), GBasisConstants[7]);
+	OutBasis[8] = XMVectorScale(XMVectorSubtract(XMVectorMultiply(X, X), XMVectorMultiply(Y, Y)), GBasisConstants[8]);
+}
+
+static XMVECTOR XM_CALLCONV LoadTexel(const void* Texels, uint32_t Index, uint32_t TexelFormat)
+{
+	if (TexelFormat == SH_TEXEL_FORMAT_RGBA16F)
+	{
+		return PackedVector::XMLoadHalf4((const PackedVector::XMHALF4*)Texels + Index);
+	}
+	return XMLoadFloat4((const XMFLOAT4*)Texels + Index);
+}
+
+void ProjectCubeMapFaceToSH(uint32_t Face, const void* Texels, uint32_t Resolution, uint32_t TexelFormat, FSH9Color& InOutSH, float& InOutWeight)
+{
+	EA_ASSERT(Face < 6 && Resolution > 0);
+	EA_ASSERT(TexelFormat == SH_TEXEL_FORMAT_RGBA32F || TexelFormat == SH_TEXEL_FORMAT_RGBA16F);
+
+	const float(*Axes)[3] = GFaceAxes[Face];
+	const float InvResolution = 1.0f / Resolution;
+	// The face spans [-1, 1]^2 at distance 1, a texel at (S, T) subtends TexelArea / (1 + S^2 + T^2)^(3/2).
+	const XMVECTOR TexelArea = XMVectorReplicate(4.0f * InvResolution * InvResolution);
+	const XMVECTOR LaneOffsets = XMVectorSet(0.5f, 1.5f, 2.5f, 3.5f);
+	const XMVECTOR LaneIndices = XMVectorSet(0.0f, 1.0f, 2.0f, 3.0f);
+	const XMVECTOR AxisScales[3] = { XMVectorReplicate(Axes[0][0]), XMVectorReplicate(Axes[1][0]), XMVectorReplicate(Axes[2][0]) };
+
+	XMVECTOR Sums[SH_NUM_COEFFICIENTS][3];
+	for (uint32_t Idx = 0; Idx < SH_NUM_COEFFICIENTS; ++Idx)
+	{
+		Sums[Idx][0] = Sums[Idx][1] = Sums[Idx][2] = XMVectorZero();
+	}
+	XMVECTOR WeightSum = XMVectorZero();
+
+	for (uint32_t Y = 0; Y < Resolution; ++Y)
+	{
+		const float T = 2.0f * (Y + 0.5f) * InvResolution - 1.0f;
+		const XMVECTOR OnePlusT2 = XMVectorReplicate(1.0f + T * T);
+		const XMVECTOR AxisOffsets[3] =
+		{
+			XMVectorReplicate(Axes[0][1] + Axes[0][2] * T), XMVectorReplicate(Axes[1][1] + Axes[1][2] * T), XMVectorReplicate(Axes[2][1] + Axes[2][2] * T),
+		};
+
+		for (uint32_t X = 0; X < Resolution; X += 4)
+		{
+			const XMVECTOR S = XMVectorSubtract(XMVectorScale(XMVectorAdd(XMVectorReplicate((float)X), LaneOffsets), 2.0f * InvResolution), g_XMOne);
+			const XMVECTOR InvLength = XMVectorReciprocalSqrt(XMVectorMultiplyAdd(S, S, OnePlusT2));
+
+			XMVECTOR Weight = XMVectorMultiply(TexelArea, XMVectorMultiply(InvLength, XMVectorMultiply(InvLength, InvLength)));
+			uint32_t Indices[4];
+			for (uint32_t Lane = 0; Lane < 4; ++Lane)
+			{
+				Indices[Lane] = Y * Resolution + (X + Lane < Resolution ? X + Lane : Resolution - 1);
+			}
+			if (X + 4 > Resolution)
+			{
+				// Only faces smaller than 4x4 get here, lanes past the end of the row do not contribute.
+				Weight = XMVectorSelect(XMVectorZero(), Weight, XMVectorLess(LaneIndices, XMVectorReplicate((float)(Resolution - X))));
+			}
+
+			// Rows become R, G, B and A of the four texels.
+			XMMATRIX Colors(LoadTexel(Texels, Indices[0], TexelFormat), LoadTexel(Texels, Indices[1], TexelFormat),
+				LoadTexel(Texels, Indices[2], TexelFormat), LoadTexel(Texels, Indices[3], TexelFormat));
+			Colors = XMMatrixTranspose(Colors);
+
+			XMVECTOR Basis[SH_NUM_COEFFICIENTS];
+			EvaluateBasis(
+				XMVectorMultiply(XMVectorMultiplyAdd(S, AxisScales[0], AxisOffsets[0]), InvLength),
+				XMVectorMultiply(XMVectorMultiplyAdd(S, AxisScales[1], AxisOffsets[1]), InvLength),
+				XMVectorMultiply(XMVectorMultiplyAdd(S, AxisScales[2], AxisOffsets[2]), InvLength),
+				Basis);
+
+			const XMVECTOR WeightedR = XMVectorMultiply(Colors.r[0], Weight);
+			const XMVECTOR WeightedG = XMVectorMultiply(Colors.r[1], Weight);
+			const XMVECTOR WeightedB = XMVectorMultiply(Colors.r[2], Weight);
+			for (uint32_t Idx = 0; Idx < SH_NUM_COEFFICIENTS; ++Idx)
+			{
+				Sums[Idx][0] = XMVectorMultiplyAdd(Basis[Idx], WeightedR, Sums[Idx][0]);
+				Sums[Idx][1] = XMVectorMultiplyAdd(Basis[Idx], WeightedG, Sums[Idx][1]);
+				Sums[Idx][2] = XMVectorMultiplyAdd(Basis[Idx], WeightedB, Sums[Idx][2]);
+			}
+			WeightSum = XMVectorAdd(WeightSum, Weight);
+		}
+	}
+
+	for (uint32_t Idx = 0; Idx < SH_NUM_COEFFICIENTS; ++Idx)
+	{
+		XMFLOAT3& Coefficient = InOutSH.Coefficients[Idx];
+		Coefficient.x += XMVectorGetX(XMVectorSum(Sums[Idx][0]));
+		Coefficient.y += XMVectorGetX(XMVectorSum(Sums[Idx][1]));
+		Coefficient.z += XMVectorGetX(XMVectorSum(Sums[Idx][2]));
+	}
+	InOutWeight += XMVectorGetX(XMVectorSum(WeightSum));
+}
+
+void ProjectCubeMapToSH(const void* const Faces[6], uint32_t Resolution, uint32_t TexelFormat, FSH9Color& OutSH)
+{
+	OutSH = {};
+	float Weight = 0.0f;
+	for (uint32_t Face = 0; Face < 6; ++Face)
+	{
+		ProjectCubeMapFaceToSH(Face, Faces[Face], Resolution, TexelFormat, OutSH, Weight);
+	}
+
+	// The per texel solid angle is exact only in the limit, normalizing removes the (small) discretization error.
+	const float Scale = 4.0f * PI / Weight;
+	for (XMFLOAT3& Coefficient : OutSH.Coefficients)
+	{
+		XMStoreFloat3(&Coefficient, XMVectorScale(XMLoadFloat3(&Coefficient), Scale));
+	}
+}
+
+void ConvolveSHWithCosineLobe(const FSH9Color& RadianceSH, FSH9Color& OutIrradianceSH)
+{
+	// Clamped cosine lobe band factors (PI, 2 * PI / 3, PI / 4) divided by PI.
+	const float BandScales[SH_NUM_COEFFICIENTS] = { 1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f };
+
+	for (uint32_t Idx = 0; Idx < SH_NUM_COEFFICIENTS; ++Idx)
+	{
+		XMStoreFloat3(&OutIrradianceSH.Coefficients[Idx], XMVectorScale(XMLoadFloat3(&RadianceSH.Coefficients[Idx]), BandScales[Idx]));
+	}
+}
+
+XMVECTOR XM_CALLCONV EvaluateSH(const FSH9Color& SH, FXMVECTOR Direction)
+{
+	XMVECTOR Basis[SH_NUM_COEFFICIENTS];
+	EvaluateBasis(XMVectorSplatX(Direction), XMVectorSplatY(Direction), XMVectorSplatZ(Direction), Basis);
+
+	XMVECTOR Result = XMVectorZero();
+	for (uint32_t Idx = 0; Idx < SH_NUM_COEFFICIENTS; ++Idx)
+	{
+		Result = XMVectorMultiplyAdd(XMLoadFloat3(&SH.Coefficients[Idx]), Basis[Idx], Result);
+	}
+	return Result;
+}
+
+void GetSHShaderConstants(const FSH9Color& SH, XMFLOAT4 OutConstants[SH_NUM_COEFFICIENTS])
+{
+	for (uint32_t Idx = 0; Idx < SH_NUM_COEFFICIENTS; ++Idx)
+	{
+		const XMFLOAT3& Coefficient = SH.Coefficients[Idx];
+		const float K = GBasisConstants[Idx];
+		OutConstants[Idx] = XMFLOAT4(Coefficient.x * K, Coefficient.y * K, Coefficient.z * K, 0.0f);
+	}
+}
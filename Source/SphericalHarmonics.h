@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+#include "DirectXMath/DirectXMath.h"
+
+// Order 3 (L2, 9 coefficients) real spherical harmonics of RGB signals. Cube maps are projected with solid angle
+// weights, four texels at a time (one per SIMD lane). The irradiance coefficients replace the irradiance cube map:
+// they go into FPerFrameConstantData and are evaluated by EvaluateIrradianceSH() in SimpleForward.hlsl.
+
+#define SH_NUM_COEFFICIENTS 9
+
+enum
+{
+	SH_TEXEL_FORMAT_RGBA32F, SH_TEXEL_FORMAT_RGBA16F,
+};
+
+struct FSH9Color
+{
+	XMFLOAT3 Coefficients[SH_NUM_COEFFICIENTS];
+};
+
+// Adds the projection of one Resolution x Resolution face (D3D cube map conventions, rows tightly packed) to
+// InOutSH and its solid angle to InOutWeight.
+void ProjectCubeMapFaceToSH(uint32_t Face, const void* Texels, uint32_t Resolution, uint32_t TexelFormat, FSH9Color& InOutSH, float& InOutWeight);
+// Projects all six faces (in D3D12 array slice order), the total solid angle is normalized to 4 * PI.
+void ProjectCubeMapToSH(const void* const Faces[6], uint32_t Resolution, uint32_t TexelFormat, FSH9Color& OutSH);
+
+// Convolves radiance with the clamped cosine lobe and divides the result by PI, so evaluating it gives the same
+// values as the old GenerateIrradianceMap.hlsl pass (irradiance / PI).
+void ConvolveSHWithCosineLobe(const FSH9Color& RadianceSH, FSH9Color& OutIrradianceSH);
+
+XMVECTOR XM_CALLCONV EvaluateSH(const FSH9Color& SH, FXMVECTOR Direction);
+
+// Coefficients premultiplied by the basis function constants, the layout of FPerFrameConstantData::IrradianceSH.
+void GetSHShaderConstants(const FSH9Color& SH, XMFLOAT4 OutConstants[SH_NUM_COEFFICIENTS]);
@@ -0,0 +1,577 @@
+#include "StaticScene.h"
+#include "EAAssert/eaassert.h"
+#include "EAStdC/EABitTricks.h"
+#include <math.h>
+#include <string.h>
+
+static float RandomFloat(uint32_t& InOutState)
+{
+	// xorshift32 (Marsaglia 2003).
+	InOutState ^= InOutState << 13;
+	InOutState ^= InOutState >> 17;
+	InOutState ^= InOutState << 5;
+	return (InOutState >> 8) * (1.0f / 16777216.0f);
+}
+
+static XMMATRIX GetMotionTransform(const FStaticMeshMotion& Motion, float Time)
+{
+	XMMATRIX Transform = XMMatrixMultiply(XMMatrixRotationRollPitchYaw(Motion.Rotation.x, Motion.Rotation.y, Motion.Rotation.z),
+		XMMatrixRotationY(XMScalarModAngle(Motion.SpinSpeed * Time)));
+	Transform.r[0] = XMVectorScale(Transform.r[0], Motion.Scale);
+	Transform.r[1] = XMVectorScale(Transform.r[1], Motion.Scale);
+	Transform.r[2] = XMVectorScale(Transform.r[2], Motion.Scale);
+	const float Bob = Motion.BobHeight * XMScalarSin(XMScalarModAngle(Motion.BobSpeed * Time + Motion.BobPhase));
+	Transform.r[3] = XMVectorSet(Motion.Position.x, Motion.Position.y + Bob, Motion.Position.z, 1.0f);
+	return Transform;
+}
+
+void SetStaticMotions(const FStaticMeshMotion* Motions, uint32_t NumMotions, FStaticMotions& OutMotions)
+{
+	// The padding after the last motion doesn't move anything, it only keeps the lanes of the last step defined.
+	const uint32_t Size = (NumMotions + 3) & ~3u;
+	eastl::vector<float>* Components[] =
+	{
+		&OutMotions.PositionX, &OutMotions.PositionY, &OutMotions.PositionZ, &OutMotions.Scale, &OutMotions.RotationX, &OutMotions.RotationY,
+		&OutMotions.RotationZ, &OutMotions.RotationW, &OutMotions.SpinSpeed, &OutMotions.BobHeight, &OutMotions.BobSpeed, &OutMotions.BobPhase,
+	};
+	for (eastl::vector<float>* Component : Components)
+	{
+		Component->assign(Size, 0.0f);
+	}
+	OutMotions.NumMotions = NumMotions;
+	for (uint32_t Idx = 0; Idx < NumMotions; ++Idx)
+	{
+		const FStaticMeshMotion& Motion = Motions[Idx];
+		XMFLOAT4 Rotation;
+		XMStoreFloat4(&Rotation, XMQuaternionRotationRollPitchYaw(Motion.Rotation.x, Motion.Rotation.y, Motion.Rotation.z));
+		OutMotions.PositionX[Idx] = Motion.Position.x;
+		OutMotions.PositionY[Idx] = Motion.Position.y;
+		OutMotions.PositionZ[Idx] = Motion.Position.z;
+		OutMotions.Scale[Idx] = Motion.Scale;
+		OutMotions.RotationX[Idx] = Rotation.x;
+		OutMotions.RotationY[Idx] = Rotation.y;
+		OutMotions.RotationZ[Idx] = Rotation.z;
+		OutMotions.RotationW[Idx] = Rotation.w;
+		OutMotions.SpinSpeed[Idx] = Motion.SpinSpeed;
+		OutMotions.BobHeight[Idx] = Motion.BobHeight;
+		OutMotions.BobSpeed[Idx] = Motion.BobSpeed;
+		OutMotions.BobPhase[Idx] = Motion.BobPhase;
+	}
+}
+
+static void PackStaticInstanceData(const FStaticScene& Scene, uint32_t InstanceIdx, FStaticInstanceData& OutData)
+{
+	const FStaticMeshInstance& MeshInst = Scene.Instances[InstanceIdx];
+	const FStaticMesh& Mesh = Scene.Meshes[MeshInst.MeshIndex];
+	const XMMATRIX ObjectToWorldT = XMMatrixTranspose(XMLoadFloat4x3(&MeshInst.ObjectToWorld));
+	XMStoreFloat4((XMFLOAT4*)&OutData.ObjectToWorld, ObjectToWorldT.r[0]);
+	XMStoreFloat4((XMFLOAT4*)&OutData.ObjectToWorld + 1, ObjectToWorldT.r[1]);
+	XMStoreFloat4((XMFLOAT4*)&OutData.ObjectToWorld + 2, ObjectToWorldT.r[2]);
+	OutData.PositionScale = Mesh.PositionScale;
+	OutData.Roughness = MeshInst.Roughness;
+	OutData.PositionBias = Mesh.PositionBias;
+	OutData.Metallic = MeshInst.Metallic;
+	OutData.Albedo = MeshInst.Albedo;
+	OutData.AO = 1.0f;
+}
+
+void AppendStaticSceneIndices(const FCookedMesh& Mesh, FStaticScene& InOutScene)
+{
+	FStaticScene& Scene = InOutScene;
+	EA_ASSERT(Mesh.IndexSize <= Scene.IndexSize);
+	const size_t Offset = Scene.Indices.size();
+	Scene.Indices.resize(Offset + (size_t)Mesh.NumIndices * Scene.IndexSize);
+	uint8_t* Ptr = Scene.Indices.data() + Offset;
+	if (Mesh.IndexSize == Scene.IndexSize)
+	{
+		memcpy(Ptr, Mesh.Indices, (size_t)Mesh.NumIndices * Scene.IndexSize);
+	}
+	else
+	{
+		for (uint32_t Idx = 0; Idx < Mesh.NumIndices; ++Idx)
+		{
+			((uint32_t*)Ptr)[Idx] = ((const uint16_t*)Mesh.Indices)[Idx];
+		}
+	}
+}
+
+void WidenStaticSceneIndices(FStaticScene& InOutScene)
+{
+	FStaticScene& Scene = InOutScene;
+	EA_ASSERT(Scene.IndexSize == 2);
+	const auto NumIndices = (uint32_t)(Scene.Indices.size() / 2);
+	eastl::vector<uint8_t> Indices((size_t)NumIndices * 4);
+	for (uint32_t Idx = 0; Idx < NumIndices; ++Idx)
+	{
+		((uint32_t*)Indices.data())[Idx] = ((const uint16_t*)Scene.Indices.data())[Idx];
+	}
+	Scene.Indices.swap(Indices);
+	Scene.IndexSize = 4;
+}
+
+uint32_t AddStaticSceneMesh(const FCookedMesh& Mesh, uint32_t BaseVertexLocation, uint32_t StartIndexLocation, bool bAddInstances, FStaticScene& InOutScene)
+{
+	FStaticScene& Scene = InOutScene;
+	for (uint32_t SectionIdx = 0; SectionIdx < Mesh.NumSections; ++SectionIdx)
+	{
+		FStaticMesh StaticMesh;
+		StaticMesh.LODs[0] = FStaticMeshLOD{ Mesh.Sections[SectionIdx].IndexCount, StartIndexLocation + Mesh.Sections[SectionIdx].StartIndexLocation, 0.0f };
+		StaticMesh.NumLODs = 1;
+		StaticMesh.BaseVertexLocation = BaseVertexLocation + Mesh.Sections[SectionIdx].BaseVertexLocation;
+		StaticMesh.PositionScale = Mesh.PositionScale;
+		StaticMesh.PositionBias = Mesh.PositionBias;
+		StaticMesh.Bounds = Mesh.Bounds[SectionIdx];
+		Scene.Meshes.push_back(StaticMesh);
+	}
+	const auto FirstSection = (uint32_t)Scene.Meshes.size() - Mesh.NumSections;
+	for (uint32_t LODIdx = 0; LODIdx < Mesh.NumLODs; ++LODIdx)
+	{
+		const FSceneMeshLOD& LOD = Mesh.LODs[LODIdx];
+		FStaticMesh& StaticMesh = Scene.Meshes[FirstSection + LOD.MeshIndex];
+		if (StaticMesh.NumLODs < MAX_MESH_LODS)
+		{
+			StaticMesh.LODs[StaticMesh.NumLODs++] = FStaticMeshLOD{ LOD.IndexCount, StartIndexLocation + LOD.StartIndexLocation, LOD.Error };
+		}
+	}
+	const auto FirstCluster = (uint32_t)Scene.Clusters.size();
+	for (uint32_t ClusterIdx = 0; ClusterIdx < Mesh.NumClusters; ++ClusterIdx)
+	{
+		FSceneCluster Cluster = Mesh.Clusters[ClusterIdx];
+		Cluster.StartIndexLocation += StartIndexLocation;
+		Scene.Clusters.push_back(Cluster);
+	}
+	for (uint32_t SectionIdx = FirstSection; SectionIdx < (uint32_t)Scene.Meshes.size(); ++SectionIdx)
+	{
+		FStaticMesh& StaticMesh = Scene.Meshes[SectionIdx];
+		for (uint32_t LODIdx = 0; LODIdx < StaticMesh.NumLODs; ++LODIdx)
+		{
+			FStaticMeshLOD& LOD = StaticMesh.LODs[LODIdx];
+			GetClusterRange(Scene.Clusters.data() + FirstCluster, Mesh.NumClusters, LOD.StartIndexLocation, LOD.IndexCount, LOD.FirstCluster,
+				LOD.NumClusters);
+			LOD.FirstCluster += FirstCluster;
+		}
+	}
+	if (bAddInstances)
+	{
+		for (uint32_t InstanceIdx = 0; InstanceIdx < Mesh.NumInstances; ++InstanceIdx)
+		{
+			const FSceneInstance& SceneInstance = Mesh.Instances[InstanceIdx];
+			const FSceneMaterial& Material = Mesh.Materials[Mesh.Sections[SceneInstance.MeshIndex].MaterialIndex];
+
+			FStaticMeshInstance Instance;
+			Instance.ObjectToWorld = SceneInstance.ObjectToWorld;
+			Instance.MeshIndex = FirstSection + SceneInstance.MeshIndex;
+			Instance.Albedo = Material.BaseColor;
+			Instance.Roughness = Material.Roughness;
+			Instance.Metallic = Material.Metallic;
+			Scene.Instances.push_back(Instance);
+		}
+	}
+	return FirstSection;
+}
+
+void BuildStaticSceneBVH(FStaticScene& InOutScene)
+{
+	FStaticScene& Scene = InOutScene;
+	const auto NumInstances = (uint32_t)Scene.Instances.size();
+	ResizeInstanceBounds(NumInstances, Scene.InstanceBounds);
+	Scene.InstanceData.resize(NumInstances);
+	Scene.DirtyInstances.assign((NumInstances + 31) / 32, 0);
+	Scene.NumInstanceTriangles = 0;
+	for (uint32_t Idx = 0; Idx < NumInstances; ++Idx)
+	{
+		const FStaticMeshInstance& Instance = Scene.Instances[Idx];
+		const FStaticMesh& Mesh = Scene.Meshes[Instance.MeshIndex];
+		SetInstanceBounds(XMLoadFloat4x3(&Instance.ObjectToWorld), Mesh.Bounds, Idx, Scene.InstanceBounds);
+		PackStaticInstanceData(Scene, Idx, Scene.InstanceData[Idx]);
+		Scene.NumInstanceTriangles += Mesh.LODs[0].IndexCount / 3;
+	}
+	BuildInstanceBVH(Scene.InstanceBounds, Scene.InstanceBVH);
+}
+
+float GenerateStaticScene(const FStaticSceneDesc& Desc, FStaticScene& InOutScene)
+{
+	FStaticScene& Scene = InOutScene;
+	EA_ASSERT(Desc.NumMeshes > 0 && Desc.FirstMesh + Desc.NumMeshes <= (uint32_t)Scene.Meshes.size());
+
+	// Instances are scaled by [0.5, 1] and jittered by a quarter of the largest radius, so they never leave their cell.
+	float MaxRadius = 0.0f;
+	for (uint32_t MeshIdx = Desc.FirstMesh; MeshIdx < Desc.FirstMesh + Desc.NumMeshes; ++MeshIdx)
+	{
+		const FSceneBounds& Bounds = Scene.Meshes[MeshIdx].Bounds;
+		MaxRadius = XMMax(MaxRadius, XMVectorGetX(XMVector3Length(XMLoadFloat3(&Bounds.Center))) + Bounds.Radius);
+	}
+	const float Spacing = 2.5f * MaxRadius;
+	const auto NumColumns = (uint32_t)ceilf(sqrtf((float)Desc.NumInstances));
+	const float HalfSize = 0.5f * Spacing * NumColumns;
+
+	uint32_t RandomState = Desc.Seed ^ 0x9E3779B9u;
+	RandomState = RandomState != 0 ? RandomState : 1;
+
+	Scene.Instances.resize(Desc.NumInstances);
+	Scene.MovingInstances.clear();
+	eastl::vector<FStaticMeshMotion> Motions;
+	for (uint32_t Idx = 0; Idx < Desc.NumInstances; ++Idx)
+	{
+		FStaticMeshMotion Motion;
+		Motion.Position.x = -HalfSize + Spacing * (Idx % NumColumns + 0.5f) + 0.5f * MaxRadius * (RandomFloat(RandomState) - 0.5f);
+		Motion.Position.y = 0.0f;
+		Motion.Position.z = -HalfSize + Spacing * (Idx / NumColumns + 0.5f) + 0.5f * MaxRadius * (RandomFloat(RandomState) - 0.5f);
+		Motion.Scale = 0.5f + 0.5f * RandomFloat(RandomState);
+		Motion.Rotation = XMFLOAT3(XM_2PI * RandomFloat(RandomState), XM_2PI * RandomFloat(RandomState), XM_2PI * RandomFloat(RandomState));
+		Motion.SpinSpeed = 0.0f;
+		Motion.BobHeight = 0.0f;
+		Motion.BobSpeed = 0.0f;
+		Motion.BobPhase = 0.0f;
+		if (RandomFloat(RandomState) < Desc.MovingFraction)
+		{
+			Motion.SpinSpeed = 4.0f * RandomFloat(RandomState) - 2.0f;
+			Motion.BobHeight = MaxRadius * RandomFloat(RandomState);
+			Motion.BobSpeed = 1.0f + 2.0f * RandomFloat(RandomState);
+			Motion.BobPhase = XM_2PI * RandomFloat(RandomState);
+			Motions.push_back(Motion);
+			Scene.MovingInstances.push_back(Idx);
+		}
+
+		FStaticMeshInstance& Instance = Scene.Instances[Idx];
+		XMStoreFloat4x3(&Instance.ObjectToWorld, GetMotionTransform(Motion, 0.0f));
+		Instance.MeshIndex = Desc.FirstMesh + XMMin((uint32_t)(RandomFloat(RandomState) * Desc.NumMeshes), Desc.NumMeshes - 1);
+		Instance.Albedo = XMFLOAT3(0.05f + 0.9f * RandomFloat(RandomState), 0.05f + 0.9f * RandomFloat(RandomState), 0.05f + 0.9f * RandomFloat(RandomState));
+		Instance.Roughness = 0.05f + 0.95f * RandomFloat(RandomState);
+		Instance.Metallic = RandomFloat(RandomState) < 0.3f ? 1.0f : 0.0f;
+	}
+	SetStaticMotions(Motions.data(), (uint32_t)Motions.size(), Scene.Motions);
+	return HalfSize;
+}
+
+void AnimateStaticScene(FJobSystem& Jobs, float Time, FStaticScene& InOutScene)
+{
+	FStaticScene& Scene = InOutScene;
+	const auto NumMoving = (uint32_t)Scene.MovingInstances.size();
+	EA_ASSERT(Scene.Motions.NumMotions == NumMoving);
+	if (NumMoving == 0)
+	{
+		return;
+	}
+	// Jobs write the bounds of different instances, which never share a FInstanceBounds entry. They start at a multiple
+	// of 4, every step moves the 4 instances of a vector of every motion component.
+	static_assert(STATIC_ANIMATION_JOB_GRANULARITY % 4 == 0, "Jobs must start at a multiple of 4.");
+	ParallelFor(Jobs, NumMoving, STATIC_ANIMATION_JOB_GRANULARITY, [&Scene, Time](uint32_t Begin, uint32_t End)
+	{
+		const FStaticMotions& Motions = Scene.Motions;
+		const XMVECTOR TimeV = XMVectorReplicate(Time);
+		for (uint32_t Idx = Begin; Idx < End; Idx += 4)
+		{
+			// The rotation of the pitch, yaw and roll followed by the spin around the y axis (the half angle of its quaternion).
+			XMVECTOR SinSpin, CosSpin;
+			XMVectorSinCos(&SinSpin, &CosSpin, XMVectorScale(XMVectorModAngles(XMVectorMultiply(XMLoadFloat4((const XMFLOAT4*)&Motions.SpinSpeed[Idx]), TimeV)), 0.5f));
+			const XMVECTOR RotationX = XMLoadFloat4((const XMFLOAT4*)&Motions.RotationX[Idx]);
+			const XMVECTOR RotationY = XMLoadFloat4((const XMFLOAT4*)&Motions.RotationY[Idx]);
+			const XMVECTOR RotationZ = XMLoadFloat4((const XMFLOAT4*)&Motions.RotationZ[Idx]);
+			const XMVECTOR RotationW = XMLoadFloat4((const XMFLOAT4*)&Motions.RotationW[Idx]);
+			const XMVECTOR QX = XMVectorMultiplyAdd(CosSpin, RotationX, XMVectorMultiply(SinSpin, RotationZ));
+			const XMVECTOR QY = XMVectorMultiplyAdd(CosSpin, RotationY, XMVectorMultiply(SinSpin, RotationW));
+			const XMVECTOR QZ = XMVectorNegativeMultiplySubtract(SinSpin, RotationX, XMVectorMultiply(CosSpin, RotationZ));
+			const XMVECTOR QW = XMVectorNegativeMultiplySubtract(SinSpin, RotationY, XMVectorMultiply(CosSpin, RotationW));
+
+			// Scaled rotation matrix of the quaternion (see XMMatrixRotationQuaternion()), a vector per element.
+			const XMVECTOR Scale = XMLoadFloat4((const XMFLOAT4*)&Motions.Scale[Idx]);
+			const XMVECTOR Scale2 = XMVectorAdd(Scale, Scale);
+			const XMVECTOR XX = XMVectorMultiply(QX, QX), YY = XMVectorMultiply(QY, QY), ZZ = XMVectorMultiply(QZ, QZ);
+			const XMVECTOR XY = XMVectorMultiply(QX, QY), XZ = XMVectorMultiply(QX, QZ), YZ = XMVectorMultiply(QY, QZ);
+			const XMVECTOR XW = XMVectorMultiply(QX, QW), YW = XMVectorMultiply(QY, QW), ZW = XMVectorMultiply(QZ, QW);
+			const XMVECTOR M00 = XMVectorNegativeMultiplySubtract(Scale2, XMVectorAdd(YY, ZZ), Scale);
+			const XMVECTOR M01 = XMVectorMultiply(Scale2, XMVectorAdd(XY, ZW));
+			const XMVECTOR M02 = XMVectorMultiply(Scale2, XMVectorSubtract(XZ, YW));
+			const XMVECTOR M10 = XMVectorMultiply(Scale2, XMVectorSubtract(XY, ZW));
+			const XMVECTOR M11 = XMVectorNegativeMultiplySubtract(Scale2, XMVectorAdd(XX, ZZ), Scale);
+			const XMVECTOR M12 = XMVectorMultiply(Scale2, XMVectorAdd(YZ, XW));
+			const XMVECTOR M20 = XMVectorMultiply(Scale2, XMVectorAdd(XZ, YW));
+			const XMVECTOR M21 = XMVectorMultiply(Scale2, XMVectorSubtract(YZ, XW));
+			const XMVECTOR M22 = XMVectorNegativeMultiplySubtract(Scale2, XMVectorAdd(XX, YY), Scale);
+			const XMVECTOR Bob = XMVectorMultiply(XMLoadFloat4((const XMFLOAT4*)&Motions.BobHeight[Idx]),
+				XMVectorSin(XMVectorModAngles(XMVectorMultiplyAdd(XMLoadFloat4((const XMFLOAT4*)&Motions.BobSpeed[Idx]), TimeV,
+				XMLoadFloat4((const XMFLOAT4*)&Motions.BobPhase[Idx])))));
+			const XMVECTOR M30 = XMLoadFloat4((const XMFLOAT4*)&Motions.PositionX[Idx]);
+			const XMVECTOR M31 = XMVectorAdd(XMLoadFloat4((const XMFLOAT4*)&Motions.PositionY[Idx]), Bob);
+			const XMVECTOR M32 = XMLoadFloat4((const XMFLOAT4*)&Motions.PositionZ[Idx]);
+
+			// Back to the 12 floats of a XMFLOAT4X3 per instance, 4 of them in every row of the transposes.
+			const XMMATRIX Rows0 = XMMatrixTranspose(XMMATRIX(M00, M01, M02, M10));
+			const XMMATRIX Rows1 = XMMatrixTranspose(XMMATRIX(M11, M12, M20, M21));
+			const XMMATRIX Rows2 = XMMatrixTranspose(XMMATRIX(M22, M30, M31, M32));
+			const uint32_t NumLanes = XMMin(End - Idx, 4u);
+			for (uint32_t Lane = 0; Lane < NumLanes; ++Lane)
+			{
+				const uint32_t InstanceIdx = Scene.MovingInstances[Idx + Lane];
+				FStaticMeshInstance& Instance = Scene.Instances[InstanceIdx];
+				XMStoreFloat4((XMFLOAT4*)&Instance.ObjectToWorld, Rows0.r[Lane]);
+				XMStoreFloat4((XMFLOAT4*)&Instance.ObjectToWorld + 1, Rows1.r[Lane]);
+				XMStoreFloat4((XMFLOAT4*)&Instance.ObjectToWorld + 2, Rows2.r[Lane]);
+				SetInstanceBounds(XMLoadFloat4x3(&Instance.ObjectToWorld), Scene.Meshes[Instance.MeshIndex].Bounds, InstanceIdx, Scene.InstanceBounds);
+			}
+		}
+	});
+
+	// Packed again in the order of the instances, jobs of whole words of the dirty bits.
+	for (uint32_t InstanceIdx : Scene.MovingInstances)
+	{
+		Scene.DirtyInstances[InstanceIdx / 32] |= 1u << (InstanceIdx % 32);
+	}
+	ParallelFor(Jobs, (uint32_t)Scene.DirtyInstances.size(), STATIC_DRAW_JOB_GRANULARITY / 32, [&Scene](uint32_t Begin, uint32_t End)
+	{
+		for (uint32_t Word = Begin; Word < End; ++Word)
+		{
+			for (uint32_t Bits = Scene.DirtyInstances[Word]; Bits != 0; Bits &= Bits - 1)
+			{
+				const uint32_t InstanceIdx = Word * 32 + EA::StdC::CountTrailing0Bits(Bits);
+				PackStaticInstanceData(Scene, InstanceIdx, Scene.InstanceData[InstanceIdx]);
+			}
+			Scene.DirtyInstances[Word] = 0;
+		}
+	});
+
+	// Walking up from every moving instance costs more than visiting every node once when many of them move.
+	if (NumMoving * 8 > (uint32_t)Scene.Instances.size())
+	{
+		RefitInstanceBVH(Scene.InstanceBounds, Scene.InstanceBVH);
+	}
+	else
+	{
+		UpdateInstanceBVH(Scene.InstanceBounds, Scene.MovingInstances.data(), NumMoving, Scene.InstanceBVH);
+	}
+}
+
+void SelectStaticDrawLODs(FJobSystem& Jobs, const FStaticScene& Scene, const FStaticDrawView& View, const uint32_t* Instances, uint32_t NumInstances,
+	FStaticDrawList& OutList)
+{
+	const uint32_t NumJobs = (NumInstances + STATIC_DRAW_JOB_GRANULARITY - 1) / STATIC_DRAW_JOB_GRANULARITY;
+	OutList.Commands.resize(NumInstances);
+	OutList.FirstCulledIndices.resize(NumJobs + 1);
+	OutList.FirstCulledIndices[0] = 0;
+
+	const XMVECTOR CameraPosition = XMLoadFloat3(&View.CameraPosition);
+	ParallelFor(Jobs, NumInstances, STATIC_DRAW_JOB_GRANULARITY, [&](uint32_t Begin, uint32_t End)
+	{
+		uint32_t NumIndices = 0;
+		for (uint32_t Idx = Begin; Idx < End; ++Idx)
+		{
+			const FStaticMeshInstance& MeshInst = Scene.Instances[Instances[Idx]];
+			const FStaticMesh& Mesh = Scene.Meshes[MeshInst.MeshIndex];
+			const XMMATRIX ObjectToWorld = XMLoadFloat4x3(&MeshInst.ObjectToWorld);
+
+			const XMVECTOR ScaleSq = XMVectorMax(XMVector3LengthSq(ObjectToWorld.r[0]), XMVectorMax(XMVector3LengthSq(ObjectToWorld.r[1]), XMVector3LengthSq(ObjectToWorld.r[2])));
+			const float Distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(ObjectToWorld.r[3], CameraPosition)));
+			const float MaxError = View.MaxLODErrorAtUnitDistance * Distance / XMVectorGetX(XMVectorSqrt(ScaleSq));
+			uint32_t LODIdx = 0;
+			while (LODIdx + 1 < Mesh.NumLODs && Mesh.LODs[LODIdx + 1].Error <= MaxError)
+			{
+				++LODIdx;
+			}
+
+			FStaticDrawCommand& Command = OutList.Commands[Idx];
+			Command.IndexCount = Mesh.LODs[LODIdx].IndexCount;
+			Command.StartIndexLocation = Mesh.LODs[LODIdx].StartIndexLocation;
+			Command.BaseVertexLocation = Mesh.BaseVertexLocation;
+			Command.LODIndex = LODIdx;
+			NumIndices += Command.IndexCount;
+		}
+		OutList.FirstCulledIndices[Begin / STATIC_DRAW_JOB_GRANULARITY + 1] = NumIndices;
+	});
+
+	for (uint32_t Job = 0; Job < NumJobs; ++Job)
+	{
+		EA_ASSERT(OutList.FirstCulledIndices[Job + 1] <= UINT32_MAX - OutList.FirstCulledIndices[Job]);
+		OutList.FirstCulledIndices[Job + 1] += OutList.FirstCulledIndices[Job];
+	}
+	OutList.MaxCulledIndexCount = OutList.FirstCulledIndices[NumJobs];
+}
+
+// Culls the clusters of the LOD of the command to OutCulledIndices at InOutNumCulledIndices, which the command then draws.
+static void CullStaticDrawClusters(const FStaticScene& Scene, const FStaticDrawView& View, FXMMATRIX ObjectToWorld, const FStaticMesh& Mesh,
+	void* OutCulledIndices, uint32_t& InOutNumCulledIndices, FStaticDrawCommand& InOutCommand, FClusterCullStats& InOutStats)
+{
+	const FStaticMeshLOD& LOD = Mesh.LODs[InOutCommand.LODIndex];
+	FClusterCullView ClusterView;
+	InitClusterCullView(ObjectToWorld, XMLoadFloat4x4(&View.WorldToClip), View.CameraPosition, ClusterView);
+	InOutCommand.IndexCount = CullClusters(ClusterView, &Scene.Clusters[LOD.FirstCluster], LOD.NumClusters, Scene.Indices.data(), Scene.IndexSize,
+		(uint8_t*)OutCulledIndices + (size_t)InOutNumCulledIndices * Scene.IndexSize, InOutStats);
+	InOutCommand.StartIndexLocation = InOutNumCulledIndices;
+	InOutNumCulledIndices += InOutCommand.IndexCount;
+}
+
+static void SumStaticDrawStats(FStaticDrawList& InOutList)
+{
+	FStaticDrawList& List = InOutList;
+	List.Stats = FStaticDrawStats{};
+	for (const FStaticDrawStats& Stats : List.JobStats)
+	{
+		List.Stats.NumTriangles += Stats.NumTriangles;
+		List.Stats.ClusterCullStats.NumClusters += Stats.ClusterCullStats.NumClusters;
+		List.Stats.ClusterCullStats.NumVisibleClusters += Stats.ClusterCullStats.NumVisibleClusters;
+		List.Stats.ClusterCullStats.NumTriangles += Stats.ClusterCullStats.NumTriangles;
+		List.Stats.ClusterCullStats.NumFrustumCulledTriangles += Stats.ClusterCullStats.NumFrustumCulledTriangles;
+		List.Stats.ClusterCullStats.NumBackfaceCulledTriangles += Stats.ClusterCullStats.NumBackfaceCulledTriangles;
+	}
+}
+
+void RecordStaticDraws(FJobSystem& Jobs, const FStaticScene& Scene, const FStaticDrawView& View, const uint32_t* Instances, uint32_t NumInstances,
+	void* OutCulledIndices, FPerDrawConstantData* OutConstants, FStaticDrawList& InOutList)
+{
+	FStaticDrawList& List = InOutList;
+	EA_ASSERT(List.Commands.size() == NumInstances);
+	const uint32_t NumJobs = (NumInstances + STATIC_DRAW_JOB_GRANULARITY - 1) / STATIC_DRAW_JOB_GRANULARITY;
+	List.JobStats.resize(NumJobs);
+
+	const XMMATRIX WorldToClip = XMLoadFloat4x4(&View.WorldToClip);
+	ParallelFor(Jobs, NumInstances, STATIC_DRAW_JOB_GRANULARITY, [&](uint32_t Begin, uint32_t End)
+	{
+		FStaticDrawStats& Stats = List.JobStats[Begin / STATIC_DRAW_JOB_GRANULARITY];
+		Stats = FStaticDrawStats{};
+		uint32_t NumCulledIndices = List.FirstCulledIndices[Begin / STATIC_DRAW_JOB_GRANULARITY];
+		for (uint32_t Idx = Begin; Idx < End; ++Idx)
+		{
+			const FStaticMeshInstance& MeshInst = Scene.Instances[Instances[Idx]];
+			const FStaticMesh& Mesh = Scene.Meshes[MeshInst.MeshIndex];
+			const XMMATRIX ObjectToWorld = XMLoadFloat4x3(&MeshInst.ObjectToWorld);
+
+			FStaticDrawCommand& Command = List.Commands[Idx];
+			if (View.bCullClusters)
+			{
+				CullStaticDrawClusters(Scene, View, ObjectToWorld, Mesh, OutCulledIndices, NumCulledIndices, Command, Stats.ClusterCullStats);
+			}
+			Stats.NumTriangles += Command.IndexCount / 3;
+
+			FPerDrawConstantData& Constants = OutConstants[Idx];
+			XMStoreFloat4x4(&Constants.ObjectToClip, XMMatrixTranspose(ObjectToWorld * WorldToClip));
+			{
+				const XMMATRIX ObjectToWorldT = XMMatrixTranspose(ObjectToWorld);
+				XMStoreFloat4((XMFLOAT4*)&Constants.ObjectToWorld, ObjectToWorldT.r[0]);
+				XMStoreFloat4((XMFLOAT4*)&Constants.ObjectToWorld + 1, ObjectToWorldT.r[1]);
+				XMStoreFloat4((XMFLOAT4*)&Constants.ObjectToWorld + 2, ObjectToWorldT.r[2]);
+			}
+			Constants.Albedo = MeshInst.Albedo;
+			Constants.Metallic = MeshInst.Metallic;
+			Constants.Roughness = MeshInst.Roughness;
+			Constants.AO = 1.0f;
+			Constants.PositionScale = Mesh.PositionScale;
+			Constants.PositionBias = Mesh.PositionBias;
+		}
+	});
+
+	SumStaticDrawStats(List);
+}
+
+void RecordStaticDrawBatches(FJobSystem& Jobs, const FStaticScene& Scene, const FStaticDrawView& View, const uint32_t* Instances, uint32_t NumInstances,
+	void* OutCulledIndices, FStaticInstanceData* OutInstances, FStaticDrawList& InOutList)
+{
+	FStaticDrawList& List = InOutList;
+	EA_ASSERT(List.Commands.size() == NumInstances);
+	const uint32_t NumJobs = (NumInstances + STATIC_DRAW_JOB_GRANULARITY - 1) / STATIC_DRAW_JOB_GRANULARITY;
+	List.JobStats.resize(NumJobs);
+	List.InstanceLocations.resize(NumInstances);
+
+	// Cluster culling, and the mesh LOD of every command until the batches are known.
+	ParallelFor(Jobs, NumInstances, STATIC_DRAW_JOB_GRANULARITY, [&](uint32_t Begin, uint32_t End)
+	{
+		FStaticDrawStats& Stats = List.JobStats[Begin / STATIC_DRAW_JOB_GRANULARITY];
+		Stats = FStaticDrawStats{};
+		uint32_t NumCulledIndices = List.FirstCulledIndices[Begin / STATIC_DRAW_JOB_GRANULARITY];
+		for (uint32_t Idx = Begin; Idx < End; ++Idx)
+		{
+			const FStaticMeshInstance& MeshInst = Scene.Instances[Instances[Idx]];
+			FStaticDrawCommand& Command = List.Commands[Idx];
+			if (View.bCullClusters)
+			{
+				const FStaticMesh& Mesh = Scene.Meshes[MeshInst.MeshIndex];
+				CullStaticDrawClusters(Scene, View, XMLoadFloat4x3(&MeshInst.ObjectToWorld), Mesh, OutCulledIndices, NumCulledIndices, Command,
+					Stats.ClusterCullStats);
+			}
+			Stats.NumTriangles += Command.IndexCount / 3;
+			List.InstanceLocations[Idx] = Command.IndexCount > 0 ? MeshInst.MeshIndex * MAX_MESH_LODS + Command.LODIndex : UINT32_MAX;
+		}
+	});
+
+	// Batches, and where the data of every instance goes.
+	List.Batches.clear();
+	uint32_t NumBatchedInstances = 0;
+	if (View.bCullClusters)
+	{
+		// Every instance draws indices of its own.
+		for (uint32_t Idx = 0; Idx < NumInstances; ++Idx)
+		{
+			const FStaticDrawCommand& Command = List.Commands[Idx];
+			if (List.InstanceLocations[Idx] != UINT32_MAX)
+			{
+				List.Batches.push_back(FStaticDrawBatch{ NumBatchedInstances, Command.IndexCount, 1, Command.StartIndexLocation, (int32_t)Command.BaseVertexLocation, 0 });
+				List.InstanceLocations[Idx] = NumBatchedInstances++;
+			}
+		}
+	}
+	else
+	{
+		// Counting sort by mesh LOD.
+		List.BatchStarts.assign(Scene.Meshes.size() * MAX_MESH_LODS, 0);
+		for (uint32_t Location : List.InstanceLocations)
+		{
+			if (Location != UINT32_MAX)
+			{
+				List.BatchStarts[Location] += 1;
+			}
+		}
+		for (uint32_t Key = 0; Key < (uint32_t)List.BatchStarts.size(); ++Key)
+		{
+			const uint32_t Count = List.BatchStarts[Key];
+			List.BatchStarts[Key] = NumBatchedInstances;
+			if (Count > 0)
+			{
+				const FStaticMesh& Mesh = Scene.Meshes[Key / MAX_MESH_LODS];
+				const FStaticMeshLOD& LOD = Mesh.LODs[Key % MAX_MESH_LODS];
+				List.Batches.push_back(FStaticDrawBatch{ NumBatchedInstances, LOD.IndexCount, Count, LOD.StartIndexLocation, (int32_t)Mesh.BaseVertexLocation, 0 });
+				NumBatchedInstances += Count;
+			}
+		}
+		for (uint32_t& Location : List.InstanceLocations)
+		{
+			if (Location != UINT32_MAX)
+			{
+				Location = List.BatchStarts[Location]++;
+			}
+		}
+	}
+
+	ParallelFor(Jobs, NumInstances, STATIC_DRAW_JOB_GRANULARITY, [&](uint32_t Begin, uint32_t End)
+	{
+		StreamStaticInstanceData(Scene, Instances, List.InstanceLocations.data(), Begin, End, OutInstances);
+	});
+
+	SumStaticDrawStats(List);
+}
+
+void StreamStaticInstanceData(const FStaticScene& Scene, const uint32_t* Instances, const uint32_t* Locations, uint32_t Begin, uint32_t End,
+	FStaticInstanceData* OutInstances)
+{
+	static_assert(sizeof(FStaticInstanceData) % 16 == 0, "Instance data must be whole 16 byte chunks.");
+	EA_ASSERT(((uintptr_t)OutInstances & 15) == 0);
+	for (uint32_t Idx = Begin; Idx < End; ++Idx)
+	{
+		if (Locations[Idx] == UINT32_MAX)
+		{
+			continue;
+		}
+		const auto* Src = (const XMFLOAT4*)&Scene.InstanceData[Instances[Idx]];
+		auto* Dst = (XMFLOAT4A*)&OutInstances[Locations[Idx]];
+		for (uint32_t Chunk = 0; Chunk < sizeof(FStaticInstanceData) / 16; ++Chunk)
+		{
+#if defined(_XM_SSE_INTRINSICS_)
+			_mm_stream_ps(&Dst[Chunk].x, XMLoadFloat4(&Src[Chunk]));
+#else
+			XMStoreFloat4A(&Dst[Chunk], XMLoadFloat4(&Src[Chunk]));
+#endif
+		}
+	}
+#if defined(_XM_SSE_INTRINSICS_)
+	// Non-temporal stores are not ordered with the ones that tell other threads (and the GPU) that the data is there.
+	_mm_sfence();
+#endif
+}
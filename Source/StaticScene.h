@@ -0,0 +1,231 @@
+#pragma once
+
+#include <stdint.h>
+#include "EASTL/vector.h"
+#include "CPUAndGPUCommon.h"
+#include "CookedMesh.h"
+#include "InstanceBVH.h"
+#include "JobSystem.h"
+#include "MeshCluster.h"
+#include "MeshSimplify.h"
+
+// CPU side of the static geometry: the meshes (sections of cooked meshes) and clusters that live in one shared vertex
+// and index buffer, the instances that draw them, their world bounds and the index over those (see InstanceBVH.h).
+// Nothing here talks to the GPU, the per-frame work ends in a draw list: a draw and constants per instance
+// (FStaticDrawCommand) or, what the demo submits, a draw per mesh LOD of instances packed in a structured buffer
+// (FStaticDrawBatch). MeshTool scene-benchmark and draw-submission submit them to a command list that only records.
+//
+// Besides the instances of cooked meshes, GenerateStaticScene() fills a scene with any number of instances of a mix
+// of meshes, with random transforms and materials, some of which move (AnimateStaticScene()).
+//
+// The GPU data of every instance (FStaticInstanceData) is packed once and kept with the scene, so the draw recording
+// only copies the visible ones to upload memory. Moving instances are animated 4 at a time from a structure of arrays
+// (FStaticMotions), one per lane of XMVECTOR, and only the instances that moved are packed again (DirtyInstances).
+
+#define STATIC_DRAW_JOB_GRANULARITY 1024 // Instances per SelectStaticDrawLODs() and RecordStaticDraws() job.
+#define STATIC_ANIMATION_JOB_GRANULARITY 4096 // Moving instances per AnimateStaticScene() job.
+#define STATIC_DRAW_INDIRECT_MIN_BATCHES 16 // Batches that the demo submits with one ExecuteIndirect() instead of a draw each.
+#define STATIC_DRAW_BATCHES_PER_COMMAND_LIST 1024 // Fewest batches that get a command list of their own, see GetNumStaticDrawCommandLists().
+
+struct FStaticMeshLOD
+{
+	uint32_t IndexCount;
+	uint32_t StartIndexLocation;
+	float Error; // Object space distance to LODs[0].
+	uint32_t FirstCluster; // In FStaticScene::Clusters.
+	uint32_t NumClusters;
+};
+
+struct FStaticMesh
+{
+	FStaticMeshLOD LODs[MAX_MESH_LODS]; // LODs[0] is the full detail mesh, all of them index the same vertices.
+	uint32_t NumLODs;
+	uint32_t BaseVertexLocation;
+	XMFLOAT3 PositionScale; // Dequantization of the cooked vertex positions (see VERTEX_ATTRIBUTE_Position).
+	XMFLOAT3 PositionBias;
+	FSceneBounds Bounds; // Object space.
+};
+
+struct FStaticMeshInstance
+{
+	XMFLOAT4X3 ObjectToWorld;
+	uint32_t MeshIndex;
+	XMFLOAT3 Albedo;
+	float Roughness;
+	float Metallic;
+};
+
+// ObjectToWorld of a moving instance at Time: scaled, rotated by Rotation (pitch, yaw, roll) and then by SpinSpeed * Time
+// around the y axis, moved to Position and up by BobHeight * sin(BobSpeed * Time + BobPhase).
+struct FStaticMeshMotion
+{
+	XMFLOAT3 Position;
+	float Scale;
+	XMFLOAT3 Rotation;
+	float SpinSpeed; // Radians per second.
+	float BobHeight;
+	float BobSpeed; // Radians per second.
+	float BobPhase;
+};
+
+// FStaticMeshMotion of the moving instances, one array per component, sized to a multiple of 4. The rotation is a
+// unit quaternion (x, y, z, w) of the pitch, yaw and roll.
+struct FStaticMotions
+{
+	uint32_t NumMotions;
+	eastl::vector<float> PositionX;
+	eastl::vector<float> PositionY;
+	eastl::vector<float> PositionZ;
+	eastl::vector<float> Scale;
+	eastl::vector<float> RotationX;
+	eastl::vector<float> RotationY;
+	eastl::vector<float> RotationZ;
+	eastl::vector<float> RotationW;
+	eastl::vector<float> SpinSpeed;
+	eastl::vector<float> BobHeight;
+	eastl::vector<float> BobSpeed;
+	eastl::vector<float> BobPhase;
+};
+
+struct FStaticScene
+{
+	eastl::vector<FStaticMesh> Meshes;
+	eastl::vector<FStaticMeshInstance> Instances;
+	FStaticMotions Motions; // Entry i moves MovingInstances[i].
+	eastl::vector<uint32_t> MovingInstances;
+	eastl::vector<FStaticInstanceData> InstanceData; // Per Instances entry, packed by BuildStaticSceneBVH().
+	eastl::vector<uint32_t> DirtyInstances; // A bit per Instances entry whose InstanceData is out of date.
+	FInstanceBounds InstanceBounds; // World space, per Instances entry.
+	FInstanceBVH InstanceBVH;
+	uint64_t NumInstanceTriangles; // LODs[0] of all instances.
+	uint32_t IndexSize; // Of Indices, 2 until a mesh needs 32-bit indices.
+	eastl::vector<uint8_t> Indices; // CPU copy of the static index buffer that CullClusters() reads.
+	eastl::vector<FSceneCluster> Clusters; // Index ranges of Indices.
+};
+
+struct FStaticSceneDesc
+{
+	uint32_t NumInstances;
+	uint32_t FirstMesh; // Instances pick one of Meshes[FirstMesh, FirstMesh + NumMeshes) at random.
+	uint32_t NumMeshes;
+	float MovingFraction; // Of the instances, [0, 1].
+	uint32_t Seed;
+};
+
+struct FStaticDrawView
+{
+	XMFLOAT4X4 WorldToClip;
+	XMFLOAT3 CameraPosition;
+	float MaxLODErrorAtUnitDistance; // LOD error (in world units) at unit distance that projects to the largest allowed error.
+	bool bCullClusters;
+};
+
+// Draw of one instance, replayed with the instance's FPerDrawConstantData as the root CBV.
+struct FStaticDrawCommand
+{
+	uint32_t IndexCount; // Zero when all of the instance's clusters were culled.
+	uint32_t StartIndexLocation; // In the culled index buffer when clusters are culled, in the static one otherwise.
+	uint32_t BaseVertexLocation;
+	uint32_t LODIndex;
+};
+
+// Draw of the instanced path: InstanceCount instances of one mesh LOD (or one instance with its culled clusters), whose
+// FStaticInstanceData follow each other from FirstInstance on. The layout of an ExecuteIndirect() argument of the demo:
+// a root constant (the shaders add FirstInstance to SV_InstanceID, which doesn't include StartInstanceLocation) and
+// D3D12_DRAW_INDEXED_ARGUMENTS.
+struct FStaticDrawBatch
+{
+	uint32_t FirstInstance;
+	uint32_t IndexCountPerInstance;
+	uint32_t InstanceCount;
+	uint32_t StartIndexLocation;
+	int32_t BaseVertexLocation;
+	uint32_t StartInstanceLocation; // Always zero.
+};
+
+struct FStaticDrawStats
+{
+	uint64_t NumTriangles; // With the selected LODs, after cluster culling.
+	FClusterCullStats ClusterCullStats;
+};
+
+// Draws of the visible instances of one frame, recorded in jobs of STATIC_DRAW_JOB_GRANULARITY instances.
+struct FStaticDrawList
+{
+	eastl::vector<FStaticDrawCommand> Commands; // Per instance.
+	eastl::vector<uint32_t> FirstCulledIndices; // Per job, where its culled indices start, followed by their total.
+	eastl::vector<FStaticDrawStats> JobStats;
+	uint32_t MaxCulledIndexCount; // Room that the culled index buffer needs, the indices of the selected LODs.
+	FStaticDrawStats Stats;
+	eastl::vector<FStaticDrawBatch> Batches; // Instanced path, in mesh and LOD order (in command order with cluster culling).
+	eastl::vector<uint32_t> InstanceLocations; // Instanced path, per command: where its FStaticInstanceData goes, UINT32_MAX for none.
+	eastl::vector<uint32_t> BatchStarts; // Instanced path, per mesh LOD (MeshIndex * MAX_MESH_LODS + LODIndex).
+};
+
+// Command lists that NumBatches draws of a FStaticDrawList are recorded to in parallel, a job each, at most MaxLists.
+// Every list gets STATIC_DRAW_BATCHES_PER_COMMAND_LIST batches or more, so it pays for its state.
+inline uint32_t GetNumStaticDrawCommandLists(uint32_t NumBatches, uint32_t MaxLists)
+{
+	const uint32_t NumLists = NumBatches / STATIC_DRAW_BATCHES_PER_COMMAND_LIST;
+	return NumLists < 1 ? 1 : NumLists < MaxLists ? NumLists : MaxLists;
+}
+
+// First batch of list ListIdx, the list records the batches up to the first one of the next list. The split only depends
+// on the number of batches and lists, so the lists executed in order draw the same as one list with all batches.
+inline uint32_t GetStaticDrawCommandListBegin(uint32_t NumBatches, uint32_t NumLists, uint32_t ListIdx)
+{
+	return (uint32_t)((uint64_t)NumBatches * ListIdx / NumLists);
+}
+
+// Replaces the motions with NumMotions of Motions (nullptr for none).
+void SetStaticMotions(const FStaticMeshMotion* Motions, uint32_t NumMotions, FStaticMotions& OutMotions);
+
+// Appends the indices of Mesh, converted to InOutScene.IndexSize, which must not be smaller than Mesh.IndexSize.
+void AppendStaticSceneIndices(const FCookedMesh& Mesh, FStaticScene& InOutScene);
+
+// Converts the indices added so far to 32 bits.
+void WidenStaticSceneIndices(FStaticScene& InOutScene);
+
+// Adds the sections, LODs and clusters of a mesh whose vertices and indices are at BaseVertexLocation and
+// StartIndexLocation of the static geometry buffers and, when bAddInstances is set, its instances. Returns the index of
+// the mesh of its first section.
+uint32_t AddStaticSceneMesh(const FCookedMesh& Mesh, uint32_t BaseVertexLocation, uint32_t StartIndexLocation, bool bAddInstances, FStaticScene& InOutScene);
+
+// World bounds and GPU data of all instances and the index over them, rebuilt whenever instances are added or removed
+// (moving instances only need AnimateStaticScene()).
+void BuildStaticSceneBVH(FStaticScene& InOutScene);
+
+// Replaces the instances with Desc.NumInstances generated ones on a jittered square grid in the xz plane, centered at
+// the origin and spaced by the largest mesh of the mix. Returns the half size of the grid. The index over them is built
+// by BuildStaticSceneBVH().
+float GenerateStaticScene(const FStaticSceneDesc& Desc, FStaticScene& InOutScene);
+
+// Moves the moving instances to where they are at Time, with their world bounds and GPU data, and refits the index
+// over them.
+void AnimateStaticScene(FJobSystem& Jobs, float Time, FStaticScene& InOutScene);
+
+// First half of the draw recording: selects the coarsest LOD of every instance whose error, scaled by the instance and
+// seen from the distance to its origin, stays below View.MaxLODErrorAtUnitDistance and fills OutList.MaxCulledIndexCount,
+// so that the culled index buffer can be sized before RecordStaticDraws().
+void SelectStaticDrawLODs(FJobSystem& Jobs, const FStaticScene& Scene, const FStaticDrawView& View, const uint32_t* Instances, uint32_t NumInstances,
+	FStaticDrawList& OutList);
+
+// Second half: culls the clusters of the selected LODs into OutCulledIndices (in Scene.IndexSize, the culled indices of a
+// job start where the selected LODs of the jobs before it end, so there may be gaps) when View.bCullClusters is set,
+// writes the constants of every instance to OutConstants (NumInstances long) and finishes the commands and stats.
+// Commands and constants do not depend on the number of threads.
+void RecordStaticDraws(FJobSystem& Jobs, const FStaticScene& Scene, const FStaticDrawView& View, const uint32_t* Instances, uint32_t NumInstances,
+	void* OutCulledIndices, FPerDrawConstantData* OutConstants, FStaticDrawList& InOutList);
+
+// Instanced alternative to RecordStaticDraws(), same culling and stats: instead of constants and a draw per instance, the
+// instances that draw the same mesh LOD are batched into one draw (InOutList.Batches) and their data is streamed to
+// OutInstances (16 byte aligned, up to NumInstances entries, as many as the batches draw, see StreamStaticInstanceData()).
+// Batches and instance data do not depend on the number of threads.
+void RecordStaticDrawBatches(FJobSystem& Jobs, const FStaticScene& Scene, const FStaticDrawView& View, const uint32_t* Instances, uint32_t NumInstances,
+	void* OutCulledIndices, FStaticInstanceData* OutInstances, FStaticDrawList& InOutList);
+
+// Copies the InstanceData of Instances[Begin, End) to OutInstances at their Locations (UINT32_MAX for none) with
+// non-temporal stores, which go around the caches to write-combined upload memory in whole 16 byte chunks.
+// OutInstances is 16 byte aligned.
+void StreamStaticInstanceData(const FStaticScene& Scene, const uint32_t* Instances, const uint32_t* Locations, uint32_t Begin, uint32_t End,
+	FStaticInstanceData* OutInstances);
@@ -0,0 +1,242 @@
+#include "UploadRing.h"
+#include "EASTL/algorithm.h"
+#include "EAAssert/eaassert.h"
+
+void CreateUploadRing(const FUploadBackend& Backend, uint64_t PageSize, FUploadRing& OutRing)
+{
+	EA_ASSERT(PageSize > 0 && PageSize % UPLOAD_RING_ALIGNMENT == 0);
+	OutRing.Backend = Backend;
+	OutRing.PageSize = PageSize;
+	OutRing.Pages.clear();
+	OutRing.CurrentPage = 0;
+	OutRing.Dedicated.clear();
+	OutRing.FreeDedicated.clear();
+	OutRing.NumBytesInUse = 0;
+	OutRing.Frame = FUploadStats{};
+	OutRing.LastFrame = FUploadStats{};
+	OutRing.MaxFrame = FUploadStats{};
+}
+
+void DestroyUploadRing(FUploadRing& Ring)
+{
+	const FUploadBackend& Backend = Ring.Backend;
+	for (const FUploadPage& Page : Ring.Pages)
+	{
+		Backend.DestroyMemory(Backend.Context, Page.Memory);
+	}
+	for (const FUploadDedicated& Dedicated : Ring.Dedicated)
+	{
+		Backend.DestroyMemory(Backend.Context, Dedicated.Memory);
+	}
+	for (const FUploadDedicated& Dedicated : Ring.FreeDedicated)
+	{
+		Backend.DestroyMemory(Backend.Context, Dedicated.Memory);
+	}
+	Ring.Pages.clear();
+	Ring.Dedicated.clear();
+	Ring.FreeDedicated.clear();
+	Ring.NumBytesInUse = 0;
+}
+
+// Size bytes at the head of the page, or at its start when they don't fit before its end. Returns false when that would
+// reach bytes that were not reclaimed.
+static bool AllocateFromPage(FUploadPage& Page, uint64_t Size, uint64_t& OutOffset, uint64_t& OutNumBytes)
+{
+	if (Page.Head == Page.Tail)
+	{
+		// Empty, no frame needs its positions (see FUploadRegion).
+		EA_ASSERT(Page.Regions.empty());
+		Page.Head = 0;
+		Page.Tail = 0;
+	}
+	uint64_t Offset = Page.Head % Page.Size;
+	uint64_t Padding = 0;
+	if (Offset + Size > Page.Size)
+	{
+		Padding = Page.Size - Offset;
+		Offset = 0;
+	}
+	if (Page.Head + Padding + Size - Page.Tail > Page.Size)
+	{
+		return false;
+	}
+	Page.Head += Padding + Size;
+	OutOffset = Offset;
+	OutNumBytes = Padding + Size;
+	return true;
+}
+
+static bool AllocateDedicated(FUploadRing& Ring, uint64_t Size, FUploadAllocation& OutAllocation)
+{
+	// Rounded to pages so that the memory of a similar allocation of an earlier frame can be reused.
+	const uint64_t RoundedSize = (Size + Ring.PageSize - 1) / Ring.PageSize * Ring.PageSize;
+
+	FUploadDedicated Dedicated;
+	uint32_t FreeIdx = 0;
+	for (; FreeIdx < (uint32_t)Ring.FreeDedicated.size(); ++FreeIdx)
+	{
+		const uint64_t FreeSize = Ring.FreeDedicated[FreeIdx].Size;
+		if (FreeSize >= RoundedSize && FreeSize <= 2 * RoundedSize)
+		{
+			break;
+		}
+	}
+	if (FreeIdx < (uint32_t)Ring.FreeDedicated.size())
+	{
+		Dedicated = Ring.FreeDedicated[FreeIdx];
+		Ring.FreeDedicated.erase_unsorted(Ring.FreeDedicated.begin() + FreeIdx);
+	}
+	else
+	{
+		if (!Ring.Backend.CreateMemory(Ring.Backend.Context, RoundedSize, Dedicated.Memory))
+		{
+			return false;
+		}
+		Dedicated.Size = RoundedSize;
+	}
+	Dedicated.FenceValue = UINT64_MAX;
+	Ring.Dedicated.push_back(Dedicated);
+
+	OutAllocation.CPUAddress = Dedicated.Memory.CPUStart;
+	OutAllocation.GPUAddress = Dedicated.Memory.GPUStart;
+	OutAllocation.Resource = Dedicated.Memory.Resource;
+	OutAllocation.Offset = 0;
+	Ring.NumBytesInUse += Dedicated.Size;
+	Ring.Frame.NumDedicatedBytes += Size;
+	return true;
+}
+
+bool AllocateUpload(FUploadRing& Ring, uint64_t Size, FUploadAllocation& OutAllocation)
+{
+	EA_ASSERT(Size > 0);
+	Size = (Size + UPLOAD_RING_ALIGNMENT - 1) & ~(uint64_t)(UPLOAD_RING_ALIGNMENT - 1);
+
+	if (Size > Ring.PageSize / 4)
+	{
+		if (!AllocateDedicated(Ring, Size, OutAllocation))
+		{
+			return false;
+		}
+	}
+	else
+	{
+		// The current page, then the others in turn, then a new one.
+		const auto NumPages = (uint32_t)Ring.Pages.size();
+		uint64_t Offset = 0;
+		uint64_t NumBytes = 0;
+		uint32_t PageIdx = 0;
+		for (; PageIdx < NumPages; ++PageIdx)
+		{
+			if (AllocateFromPage(Ring.Pages[(Ring.CurrentPage + PageIdx) % NumPages], Size, Offset, NumBytes))
+			{
+				break;
+			}
+		}
+		if (PageIdx < NumPages)
+		{
+			Ring.CurrentPage = (Ring.CurrentPage + PageIdx) % NumPages;
+		}
+		else
+		{
+			FUploadPage Page;
+			if (!Ring.Backend.CreateMemory(Ring.Backend.Context, Ring.PageSize, Page.Memory))
+			{
+				return false;
+			}
+			Page.Size = Ring.PageSize;
+			Page.Head = 0;
+			Page.Tail = 0;
+			Ring.Pages.push_back(Page);
+			Ring.CurrentPage = NumPages;
+			Ring.Frame.NumCreatedPages += 1;
+			AllocateFromPage(Ring.Pages.back(), Size, Offset, NumBytes);
+		}
+
+		const FUploadMemory& Memory = Ring.Pages[Ring.CurrentPage].Memory;
+		OutAllocation.CPUAddress = Memory.CPUStart + Offset;
+		OutAllocation.GPUAddress = Memory.GPUStart + Offset;
+		OutAllocation.Resource = Memory.Resource;
+		OutAllocation.Offset = Offset;
+		Ring.NumBytesInUse += NumBytes;
+	}
+
+	Ring.Frame.NumBytes += Size;
+	Ring.Frame.NumAllocations += 1;
+	Ring.Frame.HighWater = eastl::max(Ring.Frame.HighWater, Ring.NumBytesInUse);
+	return true;
+}
+
+void CloseUploadFrame(FUploadRing& Ring, uint64_t FenceValue)
+{
+	for (FUploadPage& Page : Ring.Pages)
+	{
+		const uint64_t FrameStart = Page.Regions.empty() ? Page.Tail : Page.Regions.back().End;
+		if (Page.Head != FrameStart)
+		{
+			EA_ASSERT(Page.Regions.empty() || Page.Regions.back().FenceValue <= FenceValue);
+			Page.Regions.push_back(FUploadRegion{ Page.Head, FenceValue });
+		}
+	}
+	for (FUploadDedicated& Dedicated : Ring.Dedicated)
+	{
+		if (Dedicated.FenceValue == UINT64_MAX)
+		{
+			Dedicated.FenceValue = FenceValue;
+		}
+	}
+	// Nothing reused the memory reclaimed before this frame, the frames after are not likely to need it either.
+	for (const FUploadDedicated& Dedicated : Ring.FreeDedicated)
+	{
+		Ring.Backend.DestroyMemory(Ring.Backend.Context, Dedicated.Memory);
+	}
+	Ring.FreeDedicated.clear();
+
+	FUploadStats& Frame = Ring.Frame;
+	Frame.Capacity = 0;
+	for (const FUploadPage& Page : Ring.Pages)
+	{
+		Frame.Capacity += Page.Size;
+	}
+	for (const FUploadDedicated& Dedicated : Ring.Dedicated)
+	{
+		Frame.Capacity += Dedicated.Size;
+	}
+
+	FUploadStats& Max = Ring.MaxFrame;
+	Max.NumBytes = eastl::max(Max.NumBytes, Frame.NumBytes);
+	Max.NumDedicatedBytes = eastl::max(Max.NumDedicatedBytes, Frame.NumDedicatedBytes);
+	Max.NumAllocations = eastl::max(Max.NumAllocations, Frame.NumAllocations);
+	Max.NumCreatedPages = eastl::max(Max.NumCreatedPages, Frame.NumCreatedPages);
+	Max.HighWater = eastl::max(Max.HighWater, Frame.HighWater);
+	Max.Capacity = eastl::max(Max.Capacity, Frame.Capacity);
+	Ring.LastFrame = Frame;
+	Ring.Frame = FUploadStats{};
+}
+
+void ReclaimUploadMemory(FUploadRing& Ring, uint64_t CompletedFenceValue)
+{
+	for (FUploadPage& Page : Ring.Pages)
+	{
+		uint32_t NumReclaimed = 0;
+		while (NumReclaimed < (uint32_t)Page.Regions.size() && Page.Regions[NumReclaimed].FenceValue <= CompletedFenceValue)
+		{
+			Ring.NumBytesInUse -= Page.Regions[NumReclaimed].End - Page.Tail;
+			Page.Tail = Page.Regions[NumReclaimed].End;
+			++NumReclaimed;
+		}
+		Page.Regions.erase(Page.Regions.begin(), Page.Regions.begin() + NumReclaimed);
+	}
+	for (uint32_t Idx = 0; Idx < (uint32_t)Ring.Dedicated.size();)
+	{
+		if (Ring.Dedicated[Idx].FenceValue <= CompletedFenceValue)
+		{
+			Ring.NumBytesInUse -= Ring.Dedicated[Idx].Size;
+			Ring.FreeDedicated.push_back(Ring.Dedicated[Idx]);
+			Ring.Dedicated.erase_unsorted(Ring.Dedicated.begin() + Idx);
+		}
+		else
+		{
+			++Idx;
+		}
+	}
+}
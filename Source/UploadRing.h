@@ -0,0 +1,105 @@
+#pragma once
+
+#include <stdint.h>
+#include "EASTL/vector.h"
+
+// Upload memory for everything the CPU writes and the GPU reads once: constants, dynamic index data and the source of
+// copies to default heap buffers. Allocations are carved one after another from pages of mapped memory, each of which
+// is used as a ring. CloseUploadFrame() tags the bytes allocated since the last call with the fence value that the GPU
+// signals when it is done with them and ReclaimUploadMemory() frees them once the fence got there, so a frame can use
+// any part of a page that older frames left free. When no page has room the frame gets a new one rather than waiting
+// for the GPU (pages are kept until DestroyUploadRing()), and allocations larger than a quarter of a page get memory of
+// their own, tagged and freed the same way.
+//
+// The ring never touches the memory. It comes from an FUploadBackend, which creates D3D12 upload heap buffers in the demo
+// (see Library.cpp) and heap memory in MeshTool upload-ring, which runs the ring against a fake fence.
+
+#define UPLOAD_RING_ALIGNMENT 256 // Of all allocations, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT.
+
+struct FUploadMemory
+{
+	void* Resource; // ID3D12Resource with the D3D12 backend.
+	uint8_t* CPUStart; // Mapped for as long as the memory lives.
+	uint64_t GPUStart;
+};
+
+struct FUploadBackend
+{
+	void* Context;
+	// Returns false when Size bytes can't be allocated.
+	bool (*CreateMemory)(void* Context, uint64_t Size, FUploadMemory& OutMemory);
+	void (*DestroyMemory)(void* Context, const FUploadMemory& Memory);
+};
+
+struct FUploadAllocation
+{
+	uint8_t* CPUAddress;
+	uint64_t GPUAddress;
+	void* Resource;
+	uint64_t Offset; // In Resource.
+};
+
+// Bytes of a page up to the position End that the GPU uses until FenceValue.
+struct FUploadRegion
+{
+	uint64_t End;
+	uint64_t FenceValue;
+};
+
+// Positions count the bytes allocated from the page, the padding skipped at its end included. The byte at position P
+// is at offset P % Size.
+struct FUploadPage
+{
+	FUploadMemory Memory;
+	uint64_t Size;
+	uint64_t Head; // Next allocation.
+	uint64_t Tail; // Oldest byte that was not reclaimed.
+	eastl::vector<FUploadRegion> Regions; // Closed frames that were not reclaimed, oldest first.
+};
+
+// Memory of an allocation larger than a quarter of a page.
+struct FUploadDedicated
+{
+	FUploadMemory Memory;
+	uint64_t Size; // A multiple of the page size.
+	uint64_t FenceValue; // UINT64_MAX until the frame is closed.
+};
+
+struct FUploadStats
+{
+	uint64_t NumBytes; // Allocated in the frame, aligned.
+	uint64_t NumDedicatedBytes; // Of NumBytes, in dedicated memory.
+	uint32_t NumAllocations;
+	uint32_t NumCreatedPages; // In the frame.
+	uint64_t HighWater; // Most bytes in use (allocated and not reclaimed, of all frames) at any time during the frame.
+	uint64_t Capacity; // All pages and dedicated memory at the end of the frame.
+};
+
+struct FUploadRing
+{
+	FUploadBackend Backend;
+	uint64_t PageSize;
+	eastl::vector<FUploadPage> Pages;
+	uint32_t CurrentPage; // Tried first.
+	eastl::vector<FUploadDedicated> Dedicated; // In use.
+	eastl::vector<FUploadDedicated> FreeDedicated; // Reclaimed, reused by the frame after or destroyed.
+	uint64_t NumBytesInUse;
+	FUploadStats Frame; // Open frame so far.
+	FUploadStats LastFrame;
+	FUploadStats MaxFrame; // Largest value of every field over all closed frames.
+};
+
+// PageSize is a multiple of UPLOAD_RING_ALIGNMENT. No memory is created until the first allocation.
+void CreateUploadRing(const FUploadBackend& Backend, uint64_t PageSize, FUploadRing& OutRing);
+// The GPU must be done with all allocations.
+void DestroyUploadRing(FUploadRing& Ring);
+
+// Returns false when the backend is out of memory. The allocation stays valid until the fence value of its frame
+// (see CloseUploadFrame()) is completed.
+bool AllocateUpload(FUploadRing& Ring, uint64_t Size, FUploadAllocation& OutAllocation);
+
+// Ends the frame, FenceValue is signaled after the GPU work that reads its allocations.
+void CloseUploadFrame(FUploadRing& Ring, uint64_t FenceValue);
+
+// Frees the allocations of the closed frames whose fence value is not larger than CompletedFenceValue.
+void ReclaimUploadMemory(FUploadRing& Ring, uint64_t CompletedFenceValue);
@@ -0,0 +1,82 @@
+#include "VertexLayout.h"
+#include "EAAssert/eaassert.h"
+#include <string.h>
+
+static const uint32_t GAttributeSizes[VERTEX_ATTRIBUTE_Count] = { 8, 4, 4, 4, 4 };
+static const char* GAttributeNames[VERTEX_ATTRIBUTE_Count] = { "_Position", "_Normal", "_Tangent", "_Texcoord", "_Color" };
+// Encoded default values.
+static const uint8_t GDefaultNormal[4] = { 0, 0, 0, 0 };
+static const uint8_t GDefaultTangent[4] = { 127, 0, 0, 127 };
+static const uint8_t GDefaultTexcoord[4] = { 0, 0, 0, 0 };
+static const uint8_t GDefaultColor[4] = { 255, 255, 255, 255 };
+static const uint8_t* GAttributeDefaults[VERTEX_ATTRIBUTE_Count] = { nullptr, GDefaultNormal, GDefaultTangent, GDefaultTexcoord, GDefaultColor };
+
+void InitVertexLayout(uint32_t AttributeMask, FVertexLayout& OutLayout)
+{
+	EA_ASSERT((AttributeMask & VERTEX_ATTRIBUTE_BIT(VERTEX_ATTRIBUTE_Position)) && (AttributeMask & ~VERTEX_ATTRIBUTES_ALL) == 0);
+
+	OutLayout = FVertexLayout{};
+	OutLayout.AttributeMask = AttributeMask;
+	for (uint32_t Attribute = 0; Attribute < VERTEX_ATTRIBUTE_Count; ++Attribute)
+	{
+		if (AttributeMask & VERTEX_ATTRIBUTE_BIT(Attribute))
+		{
+			const uint32_t Stream = Attribute == VERTEX_ATTRIBUTE_Position ? 0 : 1;
+			OutLayout.Elements[Attribute] = FVertexElement{ Stream, OutLayout.Strides[Stream], GAttributeSizes[Attribute] };
+			OutLayout.Strides[Stream] += GAttributeSizes[Attribute];
+		}
+	}
+}
+
+const char* GetVertexAttributeName(uint32_t Attribute)
+{
+	EA_ASSERT(Attribute < VERTEX_ATTRIBUTE_Count);
+	return GAttributeNames[Attribute];
+}
+
+void ConvertVertices(const FVertexLayout& SrcLayout, const void* const SrcStreams[VERTEX_MAX_STREAMS], uint32_t FirstVertex, uint32_t NumVertices,
+	const FVertexLayout& DstLayout, void* const OutStreams[VERTEX_MAX_STREAMS])
+{
+	for (uint32_t Stream = 0; Stream < VERTEX_MAX_STREAMS; ++Stream)
+	{
+		if (OutStreams[Stream] == nullptr || DstLayout.Strides[Stream] == 0)
+		{
+			continue;
+		}
+		const uint32_t DstStride = DstLayout.Strides[Stream];
+
+		// Same attributes, same layout: the whole range is one copy.
+		if (SrcLayout.AttributeMask == DstLayout.AttributeMask)
+		{
+			memcpy(OutStreams[Stream], (const uint8_t*)SrcStreams[Stream] + (size_t)FirstVertex * DstStride, (size_t)NumVertices * DstStride);
+			continue;
+		}
+
+		for (uint32_t Attribute = 0; Attribute < VERTEX_ATTRIBUTE_Count; ++Attribute)
+		{
+			const FVertexElement& DstElement = DstLayout.Elements[Attribute];
+			if ((DstLayout.AttributeMask & VERTEX_ATTRIBUTE_BIT(Attribute)) == 0 || DstElement.Stream != Stream)
+			{
+				continue;
+			}
+			uint8_t* Dst = (uint8_t*)OutStreams[Stream] + DstElement.Offset;
+			if (SrcLayout.AttributeMask & VERTEX_ATTRIBUTE_BIT(Attribute))
+			{
+				const FVertexElement& SrcElement = SrcLayout.Elements[Attribute];
+				const uint32_t SrcStride = SrcLayout.Strides[SrcElement.Stream];
+				const uint8_t* SrcData = (const uint8_t*)SrcStreams[SrcElement.Stream] + (size_t)FirstVertex * SrcStride + SrcElement.Offset;
+				for (uint32_t Idx = 0; Idx < NumVertices; ++Idx)
+				{
+					memcpy(Dst + (size_t)Idx * DstStride, SrcData + (size_t)Idx * SrcStride, DstElement.Size);
+				}
+			}
+			else
+			{
+				for (uint32_t Idx = 0; Idx < NumVertices; ++Idx)
+				{
+					memcpy(Dst + (size_t)Idx * DstStride, GAttributeDefaults[Attribute], DstElement.Size);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>
+
+// Vertex layouts are described by the set of attributes they contain. Every attribute has a fixed GPU format, positions
+// go to their own stream (stream 0) so that passes which only need positions fetch 8 bytes per vertex, all other
+// attributes are interleaved in stream 1 in VERTEX_ATTRIBUTE_ order. Layouts with different attribute sets can be
+// converted into each other with plain copies, attributes that the source layout lacks get their default value.
+// Pipelines build their input layout from the static geometry layout and the attributes their vertex shader reads.
+
+#define VERTEX_MAX_STREAMS 2
+
+enum
+{
+	VERTEX_ATTRIBUTE_Position, // R16G16B16A16_UNORM, quantized relative to the mesh bounds, w is zero.
+	VERTEX_ATTRIBUTE_Normal, // R16G16_SNORM, octahedral, default is +z.
+	VERTEX_ATTRIBUTE_Tangent, // R8G8B8A8_SNORM, xyz is the tangent, w the bitangent sign, default is (+x, 1).
+	VERTEX_ATTRIBUTE_Texcoord, // R16G16_FLOAT, default is zero.
+	VERTEX_ATTRIBUTE_Color, // R8G8B8A8_UNORM, default is white.
+	VERTEX_ATTRIBUTE_Count,
+};
+
+#define VERTEX_ATTRIBUTE_BIT(Attribute) (1u << (Attribute))
+#define VERTEX_ATTRIBUTES_ALL (VERTEX_ATTRIBUTE_BIT(VERTEX_ATTRIBUTE_Count) - 1)
+
+struct FVertexElement
+{
+	uint32_t Stream;
+	uint32_t Offset; // Within a vertex of Stream.
+	uint32_t Size;
+};
+
+struct FVertexLayout
+{
+	uint32_t AttributeMask; // VERTEX_ATTRIBUTE_BIT()s, always contains the position.
+	FVertexElement Elements[VERTEX_ATTRIBUTE_Count]; // Only the ones in AttributeMask are valid.
+	uint32_t Strides[VERTEX_MAX_STREAMS]; // Zero for empty streams.
+};
+
+void InitVertexLayout(uint32_t AttributeMask, FVertexLayout& OutLayout);
+
+// HLSL semantic of an attribute ("_Position", "_Normal", ...).
+const char* GetVertexAttributeName(uint32_t Attribute);
+
+// Converts NumVertices vertices, starting at FirstVertex of the source streams, to the start of OutStreams. Null output
+// streams are skipped.
+void ConvertVertices(const FVertexLayout& SrcLayout, const void* const SrcStreams[VERTEX_MAX_STREAMS], uint32_t FirstVertex, uint32_t NumVertices,
+	const FVertexLayout& DstLayout, void* const OutStreams[VERTEX_MAX_STREAMS]);